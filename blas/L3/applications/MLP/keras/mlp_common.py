@@ -32,6 +32,11 @@ def predict_fpga( fpga_rt, test_data, g_in_scale):
         result[i,:] = softmax(result[i,:])   
     return result
     
+def predict_fpga_fused( fpga_rt, test_data, g_in_scale):
+    #softmax of the last layer is run inside the fcn chain
+    result = fpga_rt.predict_fused(test_data, g_in_scale)
+    return result.astype(np.float32)
+    
 def softmax(x):
     """Compute softmax values for each sets of scores in x."""
     e_x = np.exp(x - np.max(x))
@@ -143,6 +143,7 @@ if  __name__ == '__main__':
     parser.add_argument('--model', required = True, help='model')
     parser.add_argument('--train', default = False, help='set to True if retrain the model')
     parser.add_argument('--run_async', default = False, help='run async for multi-kernel')
+    parser.add_argument('--fused', default = False, help='run all layers as one fcn chain, with softmax included')
     
     
     args = parser.parse_args()
@@ -179,7 +180,10 @@ if  __name__ == '__main__':
         
     inp = train_fd[predictors].values
     
-    if not args.run_async: # for larger batch size, run multi-kernels in parallel will bring up to 4x better performance
+    if args.fused:
+        for i in range(numKernels):
+            fpga_out.append(mlp_common.predict_fpga_fused(fpga_rt[i], inp, g_in_scale))
+    elif not args.run_async: # for larger batch size, run multi-kernels in parallel will bring up to 4x better performance
         for i in range(numKernels):
             fpga_out.append(mlp_common.predict_fpga(fpga_rt[i], inp, g_in_scale))
     else:
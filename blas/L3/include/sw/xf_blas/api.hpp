@@ -19,9 +19,24 @@
 
 extern "C" {
 
+// one layer of xfblasFcnChain, C = act(((A * B + X) * postScale) >> postShift)
+typedef struct {
+    void* A;
+    void* B;
+    void* C;
+    void* X;
+    int m, n, k, lda, ldb, ldc, ldx;
+    int postScale, postShift;
+    short preluScale, preluAlpha;
+    int activation; // 0 linear, 1 relu, 2 prelu, 3 sigmoid, 4 tanh, 5 gelu, 6 softmax along the rows
+    int validN;     // cols of C holding data, softmax rows are taken over them only, 0 for n
+    float actScaleIn, actScaleOut;
+} xfblasFcnLayer_t;
+
 bool xfblasCreate(char* xclbin, char* engineName, unsigned int kernelNumber, unsigned int deviceIndex);
 bool xfblasSend(void* A, unsigned long long numElem, int elemSize, unsigned int kernelIndex, unsigned int deviceIndex);
 bool xfblasGet(void* A, unsigned int kernelIndex, unsigned int deviceIndex);
+bool xfblasAlloc(void* A, unsigned long long numElem, int elemSize, unsigned int kernelIndex, unsigned int deviceIndex);
 void xfblasFreeInstr(unsigned int kernelIndex, unsigned int deviceIndex);
 void xfblasDestroy(unsigned int kernelNumber, unsigned int deviceIndex);
 void xfblasFree(void* A, unsigned int kernelIndex, unsigned int deviceIndex);
@@ -86,6 +101,11 @@ bool xfblasFcnByAddress(unsigned int l_aOff,
                         short p_preluAlpha,
                         unsigned int kernelIndex,
                         unsigned int deviceIndex);
+bool xfblasFcnChain(xfblasFcnLayer_t* layers,
+                    unsigned int numLayers,
+                    char* dataType,
+                    unsigned int kernelIndex,
+                    unsigned int deviceIndex);
 bool xfblasGetByAddress(
     void* A, unsigned long long p_bufSize, unsigned int offset, unsigned int kernelIndex, unsigned int deviceIndex);
 void xfblasExecuteAsync(unsigned int numkernels, unsigned int deviceIndex);
@@ -17,6 +17,12 @@
 #ifndef XF_BLAS_GEMM_HOST_HPP
 #define XF_BLAS_GEMM_HOST_HPP
 
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <thread>
+
 #include "handle.hpp"
 #include "host.hpp"
 
@@ -57,6 +63,73 @@ class GemmArgs : public BLASArgs {
     } m_GemmArgs;
 };
 
+/*
+ * Cuts C = alpha * op(A) * op(B) + beta * C on host matrices into tiles of C and panels of k that fit in the memory of
+ * one kernel. Tiles are taken from m_next by the kernels that share the work.
+ */
+class GEMMTiling {
+   public:
+    bool m_transA, m_transB;
+    unsigned int m_m, m_n, m_k;
+    int m_aScale, m_cScale;
+    void *m_a, *m_b, *m_c;
+    unsigned int m_lda, m_ldb, m_ldc;
+    unsigned int m_minSize;
+    unsigned int m_tileM = 0, m_tileN = 0, m_tileK = 0;
+    unsigned int m_tilesM = 0, m_tilesN = 0, m_panels = 0;
+    atomic<unsigned int> m_next{0};
+
+    // position of a panel in op(A), op(B) and C, and its sizes before and after padding to the minimum size
+    struct Panel {
+        size_t m_i, m_j, m_l;
+        unsigned int m_m, m_n, m_k;
+        unsigned int m_paddedM, m_paddedN, m_paddedK;
+    };
+
+    /*
+     * Picks the largest tiles whose buffers fit in p_memSize bytes. Each kernel holds two C tiles and two panels of
+     * A and B, so 2 * T * T + 4 * T * K elements with square tiles of C and panels of depth K <= T.
+     */
+    bool plan(unsigned long long p_memSize, unsigned int p_elemSize) {
+        const double l_elems = (double)p_memSize / p_elemSize;
+        const unsigned int l_m = getPaddedSize(m_m, m_minSize);
+        const unsigned int l_n = getPaddedSize(m_n, m_minSize);
+        const unsigned int l_k = getPaddedSize(m_k, m_minSize);
+        m_tileK = min(l_k, roundDown(sqrt(l_elems / 6)));
+        unsigned int l_tile = roundDown((sqrt(16.0 * m_tileK * m_tileK + 8 * l_elems) - 4.0 * m_tileK) / 4);
+        if (m_tileK == 0 || l_tile == 0) {
+            return false;
+        }
+        m_tileM = min(l_m, l_tile);
+        m_tileN = min(l_n, l_tile);
+        m_tilesM = (m_m + m_tileM - 1) / m_tileM;
+        m_tilesN = (m_n + m_tileN - 1) / m_tileN;
+        m_panels = (m_k + m_tileK - 1) / m_tileK;
+        m_next = 0;
+        return true;
+    }
+
+    Panel getPanel(unsigned int p_tile, unsigned int p_panel) const {
+        Panel l_panel;
+        l_panel.m_i = (size_t)(p_tile / m_tilesN) * m_tileM;
+        l_panel.m_j = (size_t)(p_tile % m_tilesN) * m_tileN;
+        l_panel.m_l = (size_t)p_panel * m_tileK;
+        l_panel.m_m = min(m_tileM, (unsigned int)(m_m - l_panel.m_i));
+        l_panel.m_n = min(m_tileN, (unsigned int)(m_n - l_panel.m_j));
+        l_panel.m_k = min(m_tileK, (unsigned int)(m_k - l_panel.m_l));
+        l_panel.m_paddedM = getPaddedSize(l_panel.m_m, m_minSize);
+        l_panel.m_paddedN = getPaddedSize(l_panel.m_n, m_minSize);
+        l_panel.m_paddedK = getPaddedSize(l_panel.m_k, m_minSize);
+        return l_panel;
+    }
+
+   protected:
+    unsigned int roundDown(double p_size) {
+        double l_size = floor(p_size / m_minSize) * m_minSize;
+        return l_size < 0x80000000u ? (unsigned int)l_size : 0x80000000u / m_minSize * m_minSize;
+    }
+};
+
 class GEMMHost : public BLASHost {
    public:
     GEMMHost() = delete;
@@ -116,13 +189,480 @@ class GEMMHost : public BLASHost {
 
         GemmArgs l_gargs(l_aOff, l_bOff, l_cOff, l_xOff, p_m, p_k, p_n, p_lda, p_ldb, p_ldc, p_ldx, p_postScale,
                          p_postShift);
-        this->addInstr(&l_gargs);
+        if (!this->addInstr(&l_gargs)) {
+            return XFBLAS_STATUS_INVALID_PROGRAM;
+        }
+        this->enableRun();
+
+        return XFBLAS_STATUS_SUCCESS;
+    }
+
+    virtual xfblasStatus_t addGEMMOpByAddress(unsigned int l_aOff,
+                                              unsigned int l_bOff,
+                                              unsigned int l_cOff,
+                                              unsigned int l_xOff,
+                                              unsigned int p_m,
+                                              unsigned int p_n,
+                                              unsigned int p_k,
+                                              unsigned int p_lda,
+                                              unsigned int p_ldb,
+                                              unsigned int p_ldc,
+                                              unsigned int p_ldx,
+                                              int p_postScale,
+                                              int p_postShift) {
+        GemmArgs l_gargs(l_aOff, l_bOff, l_cOff, l_xOff, p_m, p_k, p_n, p_lda, p_ldb, p_ldc, p_ldx, p_postScale,
+                         p_postShift);
+        if (!this->addInstr(&l_gargs)) {
+            return XFBLAS_STATUS_INVALID_PROGRAM;
+        }
         this->enableRun();
 
         return XFBLAS_STATUS_SUCCESS;
     }
+
+    /*
+     * Runs C[i] = alpha * op(A[i]) * op(B[i]) + beta * C[i] for p_batch problems of the same sizes, from and to host
+     * memory.
+     *
+     * The problems are cut into groups that fill the instruction buffer. The operands of a group are staged into one
+     * device slab as runGEMMStaged does, C of all problems first so that only that part is copied back, with each
+     * operand zero-padded to p_minSize and starting on a page. Each group is one copy to the device, one execution and
+     * one copy back.
+     */
+    template <typename t_dataType>
+    xfblasStatus_t runGEMMBatch(bool p_transA,
+                                bool p_transB,
+                                int p_alpha,
+                                void* const* p_a,
+                                void* const* p_b,
+                                int p_beta,
+                                void* const* p_c,
+                                unsigned int p_batch,
+                                unsigned int p_m,
+                                unsigned int p_n,
+                                unsigned int p_k,
+                                unsigned int p_lda,
+                                unsigned int p_ldb,
+                                unsigned int p_ldc,
+                                unsigned int p_minSize,
+                                bool p_kernelScale) {
+        const unsigned int l_m = getPaddedSize(p_m, p_minSize);
+        const unsigned int l_n = getPaddedSize(p_n, p_minSize);
+        const unsigned int l_k = getPaddedSize(p_k, p_minSize);
+        const unsigned long long l_pageSize = this->PAGE_SIZE;
+        const unsigned long long l_aPages =
+            ((unsigned long long)l_m * l_k * sizeof(t_dataType) + l_pageSize - 1) / l_pageSize;
+        const unsigned long long l_bPages =
+            ((unsigned long long)l_k * l_n * sizeof(t_dataType) + l_pageSize - 1) / l_pageSize;
+        const unsigned long long l_cPages =
+            ((unsigned long long)l_m * l_n * sizeof(t_dataType) + l_pageSize - 1) / l_pageSize;
+        int l_postScale, l_aScale, l_cScale;
+        splitScale(p_kernelScale, p_alpha, p_beta, l_postScale, l_aScale, l_cScale);
+
+        // instructions already added are run first, so that the group owns the instruction buffer
+        xfblasStatus_t l_status = XFBLAS_STATUS_SUCCESS;
+        if (this->m_instrOffset != 0) {
+            l_status = this->execute();
+            if (l_status != XFBLAS_STATUS_SUCCESS) {
+                return l_status;
+            }
+            this->clearInstrBuf();
+        }
+        const unsigned int l_group = min(p_batch, this->getInstrSpace(sizeof(GemmArgs)));
+        if (l_group == 0) {
+            return XFBLAS_STATUS_INVALID_PROGRAM;
+        }
+
+        const unsigned long long l_cBytes = l_group * l_cPages * l_pageSize;
+        const unsigned long long l_slabBytes = l_group * (l_aPages + l_bPages + l_cPages) * l_pageSize;
+        char* l_slab = nullptr;
+        l_status = this->allocMat(&l_slab, l_slabBytes);
+        if (l_status != XFBLAS_STATUS_SUCCESS) {
+            return l_status;
+        }
+        const unsigned long long l_slabPage = this->getMatPage(l_slab);
+
+        for (unsigned int l_first = 0; l_first < p_batch && l_status == XFBLAS_STATUS_SUCCESS; l_first += l_group) {
+            const unsigned int l_num = min(l_group, p_batch - l_first);
+            // padding is never written by the copies, and stays zero in C as A and B are zero there
+            if (l_first != 0) {
+                this->clearInstrBuf();
+                if (l_cScale == 0) {
+                    memset(l_slab, 0, l_cBytes);
+                }
+            }
+            for (unsigned int i = 0; i < l_num && l_status == XFBLAS_STATUS_SUCCESS; i++) {
+                unsigned long long l_cPage = i * l_cPages;
+                unsigned long long l_aPage = l_group * l_cPages + i * l_aPages;
+                unsigned long long l_bPage = l_group * (l_cPages + l_aPages) + i * l_bPages;
+                stageMat((t_dataType*)(l_slab + l_aPage * l_pageSize), l_k, (t_dataType*)p_a[l_first + i], p_lda, p_m,
+                         p_k, p_transA, l_aScale);
+                stageMat((t_dataType*)(l_slab + l_bPage * l_pageSize), l_n, (t_dataType*)p_b[l_first + i], p_ldb, p_k,
+                         p_n, p_transB, 1);
+                if (l_cScale != 0) {
+                    stageMat((t_dataType*)(l_slab + l_cPage * l_pageSize), l_n, (t_dataType*)p_c[l_first + i], p_ldc,
+                             p_m, p_n, false, l_cScale);
+                }
+                l_status = addGEMMOpByAddress(l_slabPage + l_aPage, l_slabPage + l_bPage, l_slabPage + l_cPage,
+                                              l_slabPage + l_cPage, l_m, l_n, l_k, l_k, l_n, l_n, l_n, l_postScale, 0);
+            }
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = this->setMatPartToFPGA(l_slab, l_slabBytes);
+            }
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = this->execute();
+            }
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = this->getMatPart(l_slab, l_cBytes);
+            }
+            for (unsigned int i = 0; i < l_num && l_status == XFBLAS_STATUS_SUCCESS; i++) {
+                stageMat((t_dataType*)p_c[l_first + i], p_ldc, (t_dataType*)(l_slab + i * l_cPages * l_pageSize), l_n,
+                         p_m, p_n, false, 1);
+            }
+        }
+        this->clearInstrBuf();
+        this->freeMat(l_slab);
+        return l_status;
+    }
+
+    /*
+     * Runs C = alpha * op(A) * op(B) + beta * C on matrices already in device memory, for the cases the kernel
+     * instruction cannot express: transposes, sizes not padded to p_minSize, and scalars the post-scale stage cannot
+     * apply alone.
+     *
+     * The instructions added before are run first. A, B and C are then read back, and copied into one padded staging
+     * slab in a single pass that also applies op() and the scalars. When the kernel can scale, alpha goes to its
+     * post-scale stage and the staged C is scaled by beta / alpha, which is exact when alpha divides beta. Otherwise A
+     * is scaled by alpha while it is copied. The slab is run at once, and the result is copied into the device buffer
+     * of C, so a later xfblasGetMatrix sees it.
+     *
+     * p_lda, p_ldb and p_ldc are the leading dimensions in device memory.
+     */
+    template <typename t_dataType>
+    xfblasStatus_t runGEMMStaged(bool p_transA,
+                                 bool p_transB,
+                                 unsigned int p_m,
+                                 unsigned int p_n,
+                                 unsigned int p_k,
+                                 int p_alpha,
+                                 void* p_a,
+                                 unsigned int p_lda,
+                                 void* p_b,
+                                 unsigned int p_ldb,
+                                 int p_beta,
+                                 void* p_c,
+                                 unsigned int p_ldc,
+                                 unsigned int p_minSize,
+                                 bool p_kernelScale) {
+        if (!this->hasMat(p_a) || !this->hasMat(p_b) || !this->hasMat(p_c)) {
+            return XFBLAS_STATUS_ALLOC_FAILED;
+        }
+        const unsigned int l_m = getPaddedSize(p_m, p_minSize);
+        const unsigned int l_n = getPaddedSize(p_n, p_minSize);
+        const unsigned int l_k = getPaddedSize(p_k, p_minSize);
+        const unsigned long long l_pageSize = this->PAGE_SIZE;
+        const unsigned long long l_cBytes =
+            ((unsigned long long)l_m * l_n * sizeof(t_dataType) + l_pageSize - 1) / l_pageSize * l_pageSize;
+        const unsigned long long l_aBytes =
+            ((unsigned long long)l_m * l_k * sizeof(t_dataType) + l_pageSize - 1) / l_pageSize * l_pageSize;
+        const unsigned long long l_bBytes =
+            ((unsigned long long)l_k * l_n * sizeof(t_dataType) + l_pageSize - 1) / l_pageSize * l_pageSize;
+
+        int l_postScale, l_aScale, l_cScale;
+        splitScale(p_kernelScale, p_alpha, p_beta, l_postScale, l_aScale, l_cScale);
+
+        xfblasStatus_t l_status = XFBLAS_STATUS_SUCCESS;
+        if (this->m_instrOffset != 0) {
+            l_status = this->execute();
+            if (l_status != XFBLAS_STATUS_SUCCESS) {
+                return l_status;
+            }
+            this->clearInstrBuf();
+        }
+        l_status = this->getMatPart(p_a, this->getMatSize(p_a));
+        if (l_status == XFBLAS_STATUS_SUCCESS) {
+            l_status = this->getMatPart(p_b, this->getMatSize(p_b));
+        }
+        if (l_status == XFBLAS_STATUS_SUCCESS) {
+            l_status = this->getMatPart(p_c, this->getMatSize(p_c));
+        }
+        if (l_status != XFBLAS_STATUS_SUCCESS) {
+            return l_status;
+        }
+
+        char* l_slab = nullptr;
+        l_status = this->allocMat(&l_slab, l_cBytes + l_aBytes + l_bBytes);
+        if (l_status != XFBLAS_STATUS_SUCCESS) {
+            return l_status;
+        }
+        t_dataType* l_sc = (t_dataType*)l_slab;
+        t_dataType* l_sa = (t_dataType*)(l_slab + l_cBytes);
+        t_dataType* l_sb = (t_dataType*)(l_slab + l_cBytes + l_aBytes);
+        t_dataType* l_hc = (t_dataType*)this->getMatHostPtr(p_c);
+        stageMat(l_sa, l_k, (t_dataType*)this->getMatHostPtr(p_a), p_lda, p_m, p_k, p_transA, l_aScale);
+        stageMat(l_sb, l_n, (t_dataType*)this->getMatHostPtr(p_b), p_ldb, p_k, p_n, p_transB, 1);
+        if (l_cScale != 0) {
+            stageMat(l_sc, l_n, l_hc, p_ldc, p_m, p_n, false, l_cScale);
+        }
+
+        const unsigned long long l_slabPage = this->getMatPage(l_slab);
+        const unsigned long long l_aPage = l_slabPage + l_cBytes / l_pageSize;
+        const unsigned long long l_bPage = l_aPage + l_aBytes / l_pageSize;
+        l_status = addGEMMOpByAddress(l_aPage, l_bPage, l_slabPage, l_slabPage, l_m, l_n, l_k, l_k, l_n, l_n, l_n,
+                                      l_postScale, 0);
+        if (l_status == XFBLAS_STATUS_SUCCESS) {
+            l_status = this->setMatPartToFPGA(l_slab, l_cBytes + l_aBytes + l_bBytes);
+        }
+        if (l_status == XFBLAS_STATUS_SUCCESS) {
+            l_status = this->execute();
+        }
+        if (l_status == XFBLAS_STATUS_SUCCESS) {
+            l_status = this->getMatPart(l_slab, l_cBytes);
+        }
+        if (l_status == XFBLAS_STATUS_SUCCESS) {
+            stageMat(l_hc, p_ldc, l_sc, l_n, p_m, p_n, false, 1);
+            l_status = this->setMatPartToFPGA(p_c, this->getMatSize(p_c));
+        }
+        this->clearInstrBuf();
+        this->freeMat(l_slab);
+        return l_status;
+    }
+
+    /*
+     * Runs the tiles of p_plan taken by this kernel until none is left.
+     *
+     * Each tile of C stays in device memory while the panels of A and B along k are added to it, the C input of the
+     * instruction being the tile itself. Panels and tiles are double buffered: the next panel is staged and copied to
+     * the device by a loader task while the kernel runs the current one, and a finished tile is copied back by a drain
+     * task while the kernel starts the next. The post-scale stage would also scale the partial sums, so alpha is
+     * applied to the staged A.
+     */
+    template <typename t_dataType>
+    xfblasStatus_t runGEMMTiles(GEMMTiling& p_plan) {
+        const unsigned long long l_cBytes = (unsigned long long)p_plan.m_tileM * p_plan.m_tileN * sizeof(t_dataType);
+        const unsigned long long l_aBytes = (unsigned long long)p_plan.m_tileM * p_plan.m_tileK * sizeof(t_dataType);
+        const unsigned long long l_bBytes = (unsigned long long)p_plan.m_tileK * p_plan.m_tileN * sizeof(t_dataType);
+        const unsigned int l_tiles = p_plan.m_tilesM * p_plan.m_tilesN;
+
+        xfblasStatus_t l_status = XFBLAS_STATUS_SUCCESS;
+        if (this->m_instrOffset != 0) {
+            l_status = this->execute();
+            if (l_status != XFBLAS_STATUS_SUCCESS) {
+                return l_status;
+            }
+            this->clearInstrBuf();
+        }
+        char *l_c[2] = {nullptr, nullptr}, *l_a[2] = {nullptr, nullptr}, *l_b[2] = {nullptr, nullptr};
+        for (int i = 0; i < 2 && l_status == XFBLAS_STATUS_SUCCESS; i++) {
+            l_status = this->allocMat(&l_c[i], l_cBytes);
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = this->allocMat(&l_a[i], l_aBytes);
+            }
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = this->allocMat(&l_b[i], l_bBytes);
+            }
+        }
+
+        auto l_load = [&, this](unsigned int p_tile, unsigned int p_panel, char* p_a, char* p_b,
+                                char* p_c) -> xfblasStatus_t {
+            const GEMMTiling::Panel l_p = p_plan.getPanel(p_tile, p_panel);
+            const unsigned int l_m = l_p.m_m, l_n = l_p.m_n, l_k = l_p.m_k;
+            const unsigned int l_pm = l_p.m_paddedM, l_pn = l_p.m_paddedN, l_pk = l_p.m_paddedK;
+            const size_t l_i = l_p.m_i, l_j = l_p.m_j, l_l = l_p.m_l;
+            const t_dataType* l_srcA = (t_dataType*)p_plan.m_a + (p_plan.m_transA ? l_l * p_plan.m_lda + l_i
+                                                                                    : l_i * p_plan.m_lda + l_l);
+            const t_dataType* l_srcB = (t_dataType*)p_plan.m_b + (p_plan.m_transB ? l_j * p_plan.m_ldb + l_l
+                                                                                    : l_l * p_plan.m_ldb + l_j);
+            // the buffers keep the previous panel, the padding of a smaller one is cleared
+            if (l_m != l_pm || l_k != l_pk) {
+                memset(p_a, 0, (size_t)l_pm * l_pk * sizeof(t_dataType));
+            }
+            if (l_k != l_pk || l_n != l_pn) {
+                memset(p_b, 0, (size_t)l_pk * l_pn * sizeof(t_dataType));
+            }
+            stageMat((t_dataType*)p_a, l_pk, l_srcA, p_plan.m_lda, l_m, l_k, p_plan.m_transA, p_plan.m_aScale);
+            stageMat((t_dataType*)p_b, l_pn, l_srcB, p_plan.m_ldb, l_k, l_n, p_plan.m_transB, 1);
+            xfblasStatus_t l_ret = this->setMatPartToFPGA(p_a, (size_t)l_pm * l_pk * sizeof(t_dataType));
+            if (l_ret == XFBLAS_STATUS_SUCCESS) {
+                l_ret = this->setMatPartToFPGA(p_b, (size_t)l_pk * l_pn * sizeof(t_dataType));
+            }
+            if (p_panel == 0 && l_ret == XFBLAS_STATUS_SUCCESS) {
+                if (p_plan.m_cScale == 0 || l_m != l_pm || l_n != l_pn) {
+                    memset(p_c, 0, (size_t)l_pm * l_pn * sizeof(t_dataType));
+                }
+                if (p_plan.m_cScale != 0) {
+                    stageMat((t_dataType*)p_c, l_pn, (t_dataType*)p_plan.m_c + l_i * p_plan.m_ldc + l_j, p_plan.m_ldc,
+                             l_m, l_n, false, p_plan.m_cScale);
+                }
+                l_ret = this->setMatPartToFPGA(p_c, (size_t)l_pm * l_pn * sizeof(t_dataType));
+            }
+            return l_ret;
+        };
+        auto l_drain = [&, this](unsigned int p_tile, char* p_c) -> xfblasStatus_t {
+            const GEMMTiling::Panel l_p = p_plan.getPanel(p_tile, 0);
+            xfblasStatus_t l_ret = this->getMatPart(p_c, (size_t)l_p.m_paddedM * l_p.m_paddedN * sizeof(t_dataType));
+            if (l_ret == XFBLAS_STATUS_SUCCESS) {
+                stageMat((t_dataType*)p_plan.m_c + l_p.m_i * p_plan.m_ldc + l_p.m_j, p_plan.m_ldc, (t_dataType*)p_c,
+                         l_p.m_paddedN, l_p.m_m, l_p.m_n, false, 1);
+            }
+            return l_ret;
+        };
+
+        unsigned int l_tile = l_status == XFBLAS_STATUS_SUCCESS ? p_plan.m_next++ : l_tiles;
+        unsigned int l_panel = 0, l_buf = 0, l_cBuf = 0;
+        future<xfblasStatus_t> l_loading, l_draining;
+        if (l_tile < l_tiles) {
+            l_loading = async(launch::async, l_load, l_tile, 0, l_a[0], l_b[0], l_c[0]);
+        }
+        while (l_tile < l_tiles) {
+            l_status = l_loading.get();
+            if (l_status != XFBLAS_STATUS_SUCCESS) {
+                break;
+            }
+            unsigned int l_nextTile = l_tile, l_nextPanel = l_panel + 1;
+            if (l_nextPanel == p_plan.m_panels) {
+                l_nextTile = p_plan.m_next++;
+                l_nextPanel = 0;
+            }
+            unsigned int l_nextCBuf = l_nextPanel == 0 ? 1 - l_cBuf : l_cBuf;
+            if (l_nextTile < l_tiles) {
+                // the C buffer of the next tile is free once the tile before this one is drained
+                if (l_nextPanel == 0 && l_draining.valid()) {
+                    l_status = l_draining.get();
+                    if (l_status != XFBLAS_STATUS_SUCCESS) {
+                        break;
+                    }
+                }
+                l_loading = async(launch::async, l_load, l_nextTile, l_nextPanel, l_a[1 - l_buf], l_b[1 - l_buf],
+                                  l_c[l_nextCBuf]);
+            }
+
+            const GEMMTiling::Panel l_p = p_plan.getPanel(l_tile, l_panel);
+            const unsigned long long l_cPage = this->getMatPage(l_c[l_cBuf]);
+            l_status = addGEMMOpByAddress(this->getMatPage(l_a[l_buf]), this->getMatPage(l_b[l_buf]), l_cPage, l_cPage,
+                                          l_p.m_paddedM, l_p.m_paddedN, l_p.m_paddedK, l_p.m_paddedK, l_p.m_paddedN,
+                                          l_p.m_paddedN, l_p.m_paddedN, 1, 0);
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = this->execute();
+            }
+            this->clearInstrBuf();
+            if (l_status != XFBLAS_STATUS_SUCCESS) {
+                break;
+            }
+            if (l_nextPanel == 0) {
+                // the drain of the tile before may still run when no next tile was loaded
+                if (l_draining.valid()) {
+                    l_status = l_draining.get();
+                    if (l_status != XFBLAS_STATUS_SUCCESS) {
+                        break;
+                    }
+                }
+                l_draining = async(launch::async, l_drain, l_tile, l_c[l_cBuf]);
+            }
+            l_tile = l_nextTile;
+            l_panel = l_nextPanel;
+            l_buf = 1 - l_buf;
+            l_cBuf = l_nextCBuf;
+        }
+        if (l_loading.valid()) {
+            l_loading.wait();
+        }
+        if (l_draining.valid()) {
+            xfblasStatus_t l_drainStatus = l_draining.get();
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = l_drainStatus;
+            }
+        }
+        for (int i = 0; i < 2; i++) {
+            for (char* l_mat : {l_c[i], l_a[i], l_b[i]}) {
+                if (l_mat != nullptr) {
+                    this->freeMat(l_mat);
+                }
+            }
+        }
+        return l_status;
+    }
+
+   protected:
+    // p_scale * p_val, integer results saturate to the range of t_dataType instead of wrapping around
+    template <typename t_dataType>
+    static t_dataType scaleVal(int p_scale, t_dataType p_val) {
+        if (!numeric_limits<t_dataType>::is_integer) {
+            return (t_dataType)(p_scale * p_val);
+        }
+        long long l_val = (long long)p_scale * (long long)p_val;
+        l_val = min(l_val, (long long)numeric_limits<t_dataType>::max());
+        l_val = max(l_val, (long long)numeric_limits<t_dataType>::min());
+        return (t_dataType)l_val;
+    }
+
+    // p_dst = p_scale * op(p_src) for a p_rows x p_cols op(p_src), in tiles so that the transposed side stays in cache
+    template <typename t_dataType>
+    static void stageMat(t_dataType* p_dst,
+                         unsigned int p_ldDst,
+                         const t_dataType* p_src,
+                         unsigned int p_ldSrc,
+                         unsigned int p_rows,
+                         unsigned int p_cols,
+                         bool p_trans,
+                         int p_scale) {
+        const unsigned int l_tile = 32;
+        for (unsigned int ib = 0; ib < p_rows; ib += l_tile) {
+            for (unsigned int jb = 0; jb < p_cols; jb += l_tile) {
+                const unsigned int l_ie = min(ib + l_tile, p_rows);
+                const unsigned int l_je = min(jb + l_tile, p_cols);
+                for (unsigned int i = ib; i < l_ie; i++) {
+                    for (unsigned int j = jb; j < l_je; j++) {
+                        t_dataType l_val = p_trans ? p_src[(size_t)j * p_ldSrc + i] : p_src[(size_t)i * p_ldSrc + j];
+                        p_dst[(size_t)i * p_ldDst + j] = p_scale == 1 ? l_val : scaleVal(p_scale, l_val);
+                    }
+                }
+            }
+        }
+    }
+
+    // alpha goes to the post-scale stage of the kernel when it is exact, otherwise to the staged A
+    static void splitScale(
+        bool p_kernelScale, int p_alpha, int p_beta, int& p_postScale, int& p_aScale, int& p_cScale) {
+        if (p_kernelScale && p_alpha != 0 && p_beta % p_alpha == 0) {
+            p_postScale = p_alpha;
+            p_aScale = 1;
+            p_cScale = p_beta / p_alpha;
+        } else {
+            p_postScale = 1;
+            p_aScale = p_alpha;
+            p_cScale = p_beta;
+        }
+    }
 };
 
+/*
+ * Runs p_plan on all the kernels of all the devices, one thread per kernel.
+ */
+template <typename t_dataType>
+xfblasStatus_t runGEMMTiled(GEMMTiling& p_plan) {
+    vector<GEMMHost*> l_hosts;
+    for (auto& l_device : BLASHostHandle::instance().m_handlePtr) {
+        for (auto& l_host : l_device.second) {
+            l_hosts.push_back(static_cast<GEMMHost*>(l_host.get()));
+        }
+    }
+    vector<xfblasStatus_t> l_status(l_hosts.size(), XFBLAS_STATUS_SUCCESS);
+    vector<thread> l_workers;
+    for (unsigned int i = 0; i < l_hosts.size(); i++) {
+        l_workers.push_back(thread([&, i] { l_status[i] = l_hosts[i]->runGEMMTiles<t_dataType>(p_plan); }));
+    }
+    for (auto& l_worker : l_workers) {
+        l_worker.join();
+    }
+    for (auto l_ret : l_status) {
+        if (l_ret != XFBLAS_STATUS_SUCCESS) {
+            return l_ret;
+        }
+    }
+    return XFBLAS_STATUS_SUCCESS;
+}
+
 } // namespace blas
 
 } // namespace xf
@@ -95,7 +95,9 @@ class GEMVHost : public BLASHost {
         l_cOff /= this->PAGE_SIZE;
 
         GemvArgs l_gargs(l_aOff, l_bOff, l_cOff, p_m, p_n, p_lda);
-        this->addInstr(&l_gargs);
+        if (!this->addInstr(&l_gargs)) {
+            return XFBLAS_STATUS_INVALID_PROGRAM;
+        }
         this->enableRun();
 
         return XFBLAS_STATUS_SUCCESS;
@@ -17,6 +17,9 @@
 #ifndef XF_BLAS_FCN_HOST_HPP
 #define XF_BLAS_FCN_HOST_HPP
 
+#include <cmath>
+#include <limits>
+
 #include "handle.hpp"
 #include "host.hpp"
 
@@ -62,6 +65,32 @@ class FcnArgs : public BLASArgs {
     } m_fcn_args;
 };
 
+// epilogue of an FCN layer, linear, ReLU and PReLU are applied by the kernel, the others on the host
+typedef enum {
+    FcnActLinear,
+    FcnActRelu,
+    FcnActPRelu,
+    FcnActSigmoid,
+    FcnActTanh,
+    FcnActGelu,
+    FcnActSoftmax
+} FcnActType;
+
+/*
+ * One layer of a chain, C = act(((A * B + X) * postScale) >> postShift). The host epilogues read C as values of
+ * m_actScaleIn steps per unit, and write it back with m_actScaleOut steps per unit, both 1 for float.
+ */
+class FcnLayer {
+   public:
+    void *m_a, *m_b, *m_c, *m_x;
+    unsigned int m_m, m_n, m_k, m_lda, m_ldb, m_ldc, m_ldx;
+    int m_postScale, m_postShift;
+    short m_preluScale, m_preluAlpha;
+    FcnActType m_act;
+    unsigned int m_validN; // cols of C holding data, softmax rows are taken over them only, 0 for m_n
+    float m_actScaleIn, m_actScaleOut;
+};
+
 class FCNHost : public BLASHost {
    public:
     FCNHost() = delete;
@@ -124,7 +153,9 @@ class FCNHost : public BLASHost {
 
         FcnArgs args(l_aOff, l_bOff, l_cOff, l_xOff, p_m, p_k, p_n, p_lda, p_ldb, p_ldc, p_ldx, p_postScale,
                      p_postShift, p_preluScale, p_preluAlpha);
-        this->addInstr(&args);
+        if (!this->addInstr(&args)) {
+            return XFBLAS_STATUS_INVALID_PROGRAM;
+        }
         this->enableRun();
 
         return XFBLAS_STATUS_SUCCESS;
@@ -147,11 +178,126 @@ class FCNHost : public BLASHost {
                                              short p_preluAlpha) {
         FcnArgs args(l_aOff, l_bOff, l_cOff, l_xOff, p_m, p_k, p_n, p_lda, p_ldb, p_ldc, p_ldx, p_postScale,
                      p_postShift, p_preluScale, p_preluAlpha);
-        this->addInstr(&args);
+        if (!this->addInstr(&args)) {
+            return XFBLAS_STATUS_INVALID_PROGRAM;
+        }
         this->enableRun();
 
         return XFBLAS_STATUS_SUCCESS;
     }
+
+    /*
+     * Runs p_layers in order, each layer usually reading the C of the one before as its A, and leaves the output of the
+     * last layer in its host memory. All the buffers must have device memory, intermediate ones need not be sent.
+     *
+     * Layers with a kernel epilogue are added to the same instructions, so their outputs never leave the device. The
+     * kernel has no sigmoid, tanh, GELU or softmax: the instructions up to such a layer are run, its output is read
+     * back, activated and written back, and the chain goes on from there. The output of the last layer is read back
+     * anyway, so a classifier with a softmax or sigmoid output runs as one submission.
+     */
+    template <typename t_dataType>
+    xfblasStatus_t runFCNChain(const vector<FcnLayer>& p_layers) {
+        xfblasStatus_t l_status = XFBLAS_STATUS_SUCCESS;
+        if (this->m_instrOffset != 0) {
+            l_status = this->execute();
+            this->clearInstrBuf();
+        }
+        for (size_t i = 0; i < p_layers.size() && l_status == XFBLAS_STATUS_SUCCESS; i++) {
+            const FcnLayer& l_layer = p_layers[i];
+            const bool l_last = i + 1 == p_layers.size();
+            const bool l_hostAct = l_layer.m_act > FcnActPRelu;
+            // a zero PReLU scale clears the negative values, a scale of one keeps them
+            short l_preluScale = l_layer.m_act == FcnActRelu ? 0 : 1;
+            short l_preluAlpha = 0;
+            if (l_layer.m_act == FcnActPRelu) {
+                l_preluScale = l_layer.m_preluScale;
+                l_preluAlpha = l_layer.m_preluAlpha;
+            }
+            if (this->getInstrSpace(sizeof(FcnArgs)) == 0) {
+                l_status = this->execute();
+                this->clearInstrBuf();
+            }
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = addFCNOp(l_layer.m_a, l_layer.m_b, l_layer.m_c, l_layer.m_x, l_layer.m_m, l_layer.m_n,
+                                    l_layer.m_k, l_layer.m_lda, l_layer.m_ldb, l_layer.m_ldc, l_layer.m_ldx,
+                                    l_layer.m_postScale, l_layer.m_postShift, l_preluScale, l_preluAlpha);
+            }
+            if (l_status != XFBLAS_STATUS_SUCCESS || (!l_hostAct && !l_last)) {
+                continue;
+            }
+            l_status = this->execute();
+            this->clearInstrBuf();
+            t_dataType* l_c = (t_dataType*)(l_last ? l_layer.m_c : this->getMatHostPtr(l_layer.m_c));
+            if (l_status == XFBLAS_STATUS_SUCCESS) {
+                l_status = l_last ? this->getMatRestricted(l_layer.m_c, l_layer.m_c)
+                                  : this->getMatPart(l_layer.m_c, this->getMatSize(l_layer.m_c));
+            }
+            if (l_status == XFBLAS_STATUS_SUCCESS && l_hostAct) {
+                applyActivation(l_c, l_layer.m_m, l_layer.m_validN == 0 ? l_layer.m_n : l_layer.m_validN,
+                                l_layer.m_ldc, l_layer.m_act, l_layer.m_actScaleIn, l_layer.m_actScaleOut);
+                if (!l_last) {
+                    l_status = this->setMatPartToFPGA(l_layer.m_c, this->getMatSize(l_layer.m_c));
+                }
+            }
+        }
+        return l_status;
+    }
+
+   protected:
+    // p_c = act(p_c) on p_rows x p_cols values, the softmax being taken along each row
+    template <typename t_dataType>
+    static void applyActivation(t_dataType* p_c,
+                                unsigned int p_rows,
+                                unsigned int p_cols,
+                                unsigned int p_ldc,
+                                FcnActType p_act,
+                                float p_scaleIn,
+                                float p_scaleOut) {
+        vector<double> l_row(p_cols);
+        for (unsigned int i = 0; i < p_rows; i++) {
+            t_dataType* l_c = p_c + (size_t)i * p_ldc;
+            double l_max = -numeric_limits<double>::infinity(), l_sum = 0;
+            for (unsigned int j = 0; j < p_cols; j++) {
+                l_row[j] = l_c[j] / (double)p_scaleIn;
+                l_max = max(l_max, l_row[j]);
+            }
+            for (unsigned int j = 0; j < p_cols; j++) {
+                double l_x = l_row[j];
+                switch (p_act) {
+                    case FcnActSigmoid:
+                        l_row[j] = 1 / (1 + exp(-l_x));
+                        break;
+                    case FcnActTanh:
+                        l_row[j] = tanh(l_x);
+                        break;
+                    case FcnActGelu:
+                        l_row[j] = 0.5 * l_x * (1 + tanh(0.7978845608028654 * (l_x + 0.044715 * l_x * l_x * l_x)));
+                        break;
+                    case FcnActSoftmax:
+                        l_row[j] = exp(l_x - l_max);
+                        l_sum += l_row[j];
+                        break;
+                    default:
+                        break;
+                }
+            }
+            for (unsigned int j = 0; j < p_cols; j++) {
+                double l_y = (p_act == FcnActSoftmax ? l_row[j] / l_sum : l_row[j]) * p_scaleOut;
+                l_c[j] = toDataType<t_dataType>(l_y);
+            }
+        }
+    }
+
+    // integer outputs are rounded and saturated
+    template <typename t_dataType>
+    static t_dataType toDataType(double p_val) {
+        if (!numeric_limits<t_dataType>::is_integer) {
+            return (t_dataType)p_val;
+        }
+        p_val = round(p_val);
+        p_val = min(max(p_val, (double)numeric_limits<t_dataType>::min()), (double)numeric_limits<t_dataType>::max());
+        return (t_dataType)p_val;
+    }
 };
 
 } // namespace blas
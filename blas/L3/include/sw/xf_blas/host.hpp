@@ -22,7 +22,9 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <set>
 #include <iostream>
+#include <mutex>
 
 #include "ert.h"
 #include "xclhal2.h"
@@ -46,6 +48,8 @@ class XFpga {
     uuid_t m_xclbinId;
     vector<int> m_mem;
     vector<unsigned long long> m_baseAddress;
+    vector<unsigned long long> m_memSize;
+    vector<unsigned int> m_memKernels;
 
     bool m_init = false;
 
@@ -79,9 +83,24 @@ class XFpga {
         auto l_topo = xclbin::get_axlf_section(l_top, MEM_TOPOLOGY);
         struct mem_topology* l_topology = (mem_topology*)(l_header + l_topo->m_sectionOffset);
 
+        // kernels connected to each memory bank, a bank is shared by all of them
+        vector<set<int> > l_kernels(l_topology->m_count);
+        auto l_conn = xclbin::get_axlf_section(l_top, CONNECTIVITY);
+        if (l_conn != nullptr) {
+            struct connectivity* l_connectivity = (connectivity*)(l_header + l_conn->m_sectionOffset);
+            for (int i = 0; i < l_connectivity->m_count; ++i) {
+                const connection& l_connection = l_connectivity->m_connection[i];
+                if (l_connection.mem_data_index >= 0 && l_connection.mem_data_index < l_topology->m_count) {
+                    l_kernels[l_connection.mem_data_index].insert(l_connection.m_ip_layout_index);
+                }
+            }
+        }
+
         for (int i = 0; i < l_topology->m_count; ++i) {
             if (l_topology->m_mem_data[i].m_used) {
                 m_baseAddress.push_back(l_topology->m_mem_data[i].m_base_address);
+                m_memSize.push_back(l_topology->m_mem_data[i].m_size * 1024);
+                m_memKernels.push_back(l_kernels[i].empty() ? 1 : l_kernels[i].size());
                 int l_mem = i;
                 m_mem.push_back(l_mem);
             }
@@ -139,11 +158,14 @@ class XFpga {
         if (xclExecBuf(m_handle, m_execHandle)) {
             return 0;
         }
-        // while (ecmd->state == 1){
-        while (xclExecWait(m_handle, 1) == 0)
-            ;
-
-        //}
+        // other kernels may complete first when they are run from other streams, wait for this command
+        while (ecmd->state != ERT_CMD_STATE_COMPLETED && ecmd->state != ERT_CMD_STATE_ERROR &&
+               ecmd->state != ERT_CMD_STATE_ABORT) {
+            xclExecWait(m_handle, 1);
+        }
+        if (ecmd->state != ERT_CMD_STATE_COMPLETED) {
+            return 0;
+        }
         return m_execHandle;
     }
 };
@@ -176,6 +198,7 @@ class XHost {
     unsigned int m_instrOffset;
     unsigned int m_instrBufHandle;
     unsigned int m_cuIndex;
+    mutex m_instrMutex; // instructions are added and executed from the worker threads of the streams
 
    public:
     XHost() = delete;
@@ -187,13 +210,13 @@ class XHost {
             return;
         }
         void* l_alignedMem = nullptr;
-        int l_memAllocStatus = posix_memalign(&l_alignedMem, PAGE_SIZE, INSTR_BUF_SIZE);
+        int l_memAllocStatus = posix_memalign(&l_alignedMem, PAGE_SIZE, INSTR_BUF_SIZE + KERN_DBG_BUF_SIZE);
         if (l_memAllocStatus) {
             *p_status = XFBLAS_STATUS_ALLOC_FAILED;
         }
         m_instrBuf = (char*)l_alignedMem;
         m_progBuf = (char*)l_alignedMem;
-        memset(m_instrBuf, 0, INSTR_BUF_SIZE);
+        memset(m_instrBuf, 0, INSTR_BUF_SIZE + KERN_DBG_BUF_SIZE);
         m_instrOffset = 0;
         m_instrBufHandle = m_fpga->createBuf(m_instrBuf, INSTR_BUF_SIZE + KERN_DBG_BUF_SIZE, m_cuIndex);
     }
@@ -302,11 +325,62 @@ class XHost {
         return XFBLAS_STATUS_SUCCESS;
     }
 
-    void addInstr(BLASArgs* p_args) {
+    bool addInstr(BLASArgs* p_args) {
+        lock_guard<mutex> l_lock(m_instrMutex);
+        // the kernel stops at the first zero instruction, one is always kept at the end
+        if (m_instrOffset + 2 * p_args->sizeInBytes() > INSTR_BUF_SIZE) {
+            return false;
+        }
         char* l_instr = p_args->asByteArray();
         char* l_currPos = &m_progBuf[m_instrOffset];
         memcpy(l_currPos, l_instr, p_args->sizeInBytes());
         m_instrOffset += p_args->sizeInBytes();
+        return true;
+    }
+
+    // number of instructions of p_instrSize bytes that can still be added
+    unsigned int getInstrSpace(size_t p_instrSize) {
+        lock_guard<mutex> l_lock(m_instrMutex);
+        return (INSTR_BUF_SIZE - m_instrOffset) / p_instrSize - 1;
+    }
+
+    // offset in pages of a matrix from the base of the kernel memory, as the instructions address it
+    unsigned long long getMatPage(void* p_hostHandle) {
+        xclBOProperties l_prop;
+        uint64_t l_address =
+            !xclGetBOProperties(m_fpga->m_handle, m_bufHandle[p_hostHandle], &l_prop) ? l_prop.paddr : -1;
+        return (l_address - m_fpga->m_baseAddress[m_cuIndex]) / PAGE_SIZE;
+    }
+
+    // host memory the device buffer of a matrix is copied from and to
+    void* getMatHostPtr(void* p_hostHandle) {
+        auto l_host = m_hostMat.find(p_hostHandle);
+        return l_host == m_hostMat.end() ? p_hostHandle : l_host->second;
+    }
+
+    bool hasMat(void* p_hostHandle) { return m_bufHandle.find(p_hostHandle) != m_bufHandle.end(); }
+
+    unsigned long long getMatSize(void* p_hostHandle) { return m_hostMatSz[p_hostHandle]; }
+
+    // bytes of the memory bank of the kernel
+    unsigned long long getMemSize() { return m_fpga->m_memSize[m_cuIndex]; }
+
+    // bytes of the memory bank of the kernel divided among the kernels connected to the bank
+    unsigned long long getMemShare() { return m_fpga->m_memSize[m_cuIndex] / m_fpga->m_memKernels[m_cuIndex]; }
+
+    // copies the first p_bufSize bytes of a matrix allocated by allocMat
+    xfblasStatus_t setMatPartToFPGA(void* p_hostHandle, unsigned long long p_bufSize) {
+        if (!m_fpga->copyToFpga(m_bufHandle[p_hostHandle], p_bufSize)) {
+            return XFBLAS_STATUS_ALLOC_FAILED;
+        }
+        return XFBLAS_STATUS_SUCCESS;
+    }
+
+    xfblasStatus_t getMatPart(void* p_hostHandle, unsigned long long p_bufSize) {
+        if (!m_fpga->copyFromFpga(m_bufHandle[p_hostHandle], p_bufSize)) {
+            return XFBLAS_STATUS_ALLOC_FAILED;
+        }
+        return XFBLAS_STATUS_SUCCESS;
     }
 
     template <typename t_dataType>
@@ -373,6 +447,7 @@ class XHost {
     }
 
     void clearInstrBuf() {
+        lock_guard<mutex> l_lock(m_instrMutex);
         memset(this->m_progBuf, 0, PAGE_SIZE);
         this->m_instrOffset = 0;
     }
@@ -417,6 +492,7 @@ class BLASHost : public XHost {
         : XHost(p_xclbin, p_status, p_kernelIndex, p_deviceIndex) {}
 
     xfblasStatus_t execute() {
+        lock_guard<mutex> l_lock(this->m_instrMutex);
         xfblasStatus_t l_status = XFBLAS_STATUS_SUCCESS;
         if (m_execControl) {
             if (!this->m_fpga->copyToFpga(this->m_instrBufHandle, this->INSTR_BUF_SIZE + this->KERN_DBG_BUF_SIZE)) {
@@ -433,7 +509,10 @@ class BLASHost : public XHost {
         return l_status;
     }
 
-    void enableRun() { m_execControl = true; }
+    void enableRun() {
+        lock_guard<mutex> l_lock(this->m_instrMutex);
+        m_execControl = true;
+    }
 };
 
 } // namespace blas
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef XF_BLAS_STREAM_HPP
+#define XF_BLAS_STREAM_HPP
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include <unordered_map>
+
+#include "../utility/utility.hpp"
+
+#ifndef XFBLAS_STREAM_WORKERS
+#define XFBLAS_STREAM_WORKERS 8
+#endif
+
+using namespace std;
+
+namespace xf {
+
+namespace blas {
+
+class BLASStream;
+
+/*
+ * An event marks a point in a stream. m_recorded counts the records issued, m_completed is the latest record the
+ * stream has reached, so a wait only depends on the records issued before it.
+ */
+class BLASEvent {
+   public:
+    unsigned long long m_recorded = 0;
+    unsigned long long m_completed = 0;
+    vector<shared_ptr<BLASStream> > m_waiting;
+};
+
+/*
+ * One entry of a stream, either an operation run by a worker or an event record/wait handled by the scheduler.
+ */
+class BLASStreamOp {
+   public:
+    enum { OP_RUN, OP_RECORD, OP_WAIT };
+    int m_type;
+    function<xfblasStatus_t()> m_fn;
+    shared_ptr<BLASEvent> m_event;
+    unsigned long long m_target;
+
+    BLASStreamOp(function<xfblasStatus_t()> p_fn) : m_type(OP_RUN), m_fn(p_fn), m_target(0) {}
+    BLASStreamOp(int p_type, shared_ptr<BLASEvent> p_event, unsigned long long p_target)
+        : m_type(p_type), m_event(p_event), m_target(p_target) {}
+};
+
+/*
+ * Operations of one stream run in order, one at a time, on the kernel the stream is bound to. Different streams run
+ * concurrently, so transfers of one stream overlap the kernel execution of another.
+ */
+class BLASStream {
+   public:
+    unsigned int m_kernelIndex;
+    unsigned int m_deviceIndex;
+    deque<BLASStreamOp> m_ops;
+    unsigned int m_pending = 0;
+    bool m_active = false; // queued to a worker, running, or parked on an event
+    xfblasStatus_t m_status = XFBLAS_STATUS_SUCCESS;
+
+    BLASStream(unsigned int p_kernelIndex, unsigned int p_deviceIndex)
+        : m_kernelIndex(p_kernelIndex), m_deviceIndex(p_deviceIndex) {}
+};
+
+typedef shared_ptr<BLASStream> xfblasStream_t;
+typedef shared_ptr<BLASEvent> xfblasEvent_t;
+
+/*
+ * Fixed pool of worker threads shared by all streams. Workers are started on first use, so the per-operation cost is
+ * a queue push instead of a thread creation.
+ */
+class BLASStreamPool {
+   public:
+    static BLASStreamPool& instance() {
+        static BLASStreamPool theInstance;
+        return theInstance;
+    }
+
+    ~BLASStreamPool() {
+        {
+            lock_guard<mutex> l_lock(m_mutex);
+            m_stop = true;
+        }
+        m_ready.notify_all();
+        for (auto& l_worker : m_workers) {
+            l_worker.join();
+        }
+    }
+
+    void enqueue(const xfblasStream_t& p_stream, const BLASStreamOp& p_op) {
+        lock_guard<mutex> l_lock(m_mutex);
+        if (m_workers.empty()) {
+            for (unsigned int i = 0; i < XFBLAS_STREAM_WORKERS; i++) {
+                m_workers.push_back(thread(&BLASStreamPool::work, this));
+            }
+        }
+        p_stream->m_ops.push_back(p_op);
+        p_stream->m_pending++;
+        m_pending++;
+        if (!p_stream->m_active) {
+            p_stream->m_active = true;
+            advance(p_stream);
+        }
+    }
+
+    void record(const xfblasEvent_t& p_event, const xfblasStream_t& p_stream) {
+        unsigned long long l_target;
+        {
+            lock_guard<mutex> l_lock(m_mutex);
+            l_target = ++p_event->m_recorded;
+        }
+        enqueue(p_stream, BLASStreamOp(BLASStreamOp::OP_RECORD, p_event, l_target));
+    }
+
+    void wait(const xfblasStream_t& p_stream, const xfblasEvent_t& p_event) {
+        unsigned long long l_target;
+        {
+            lock_guard<mutex> l_lock(m_mutex);
+            l_target = p_event->m_recorded;
+        }
+        enqueue(p_stream, BLASStreamOp(BLASStreamOp::OP_WAIT, p_event, l_target));
+    }
+
+    xfblasStatus_t synchronize(const xfblasStream_t& p_stream) {
+        unique_lock<mutex> l_lock(m_mutex);
+        m_idle.wait(l_lock, [&] { return p_stream->m_pending == 0; });
+        xfblasStatus_t l_status = p_stream->m_status;
+        p_stream->m_status = XFBLAS_STATUS_SUCCESS;
+        return l_status;
+    }
+
+    void synchronize(const xfblasEvent_t& p_event) {
+        unique_lock<mutex> l_lock(m_mutex);
+        unsigned long long l_target = p_event->m_recorded;
+        m_idle.wait(l_lock, [&] { return p_event->m_completed >= l_target; });
+    }
+
+    void synchronizeAll() {
+        unique_lock<mutex> l_lock(m_mutex);
+        m_idle.wait(l_lock, [&] { return m_pending == 0; });
+    }
+
+    // the stream used by the async calls that only name a kernel
+    xfblasStream_t defaultStream(unsigned int p_kernelIndex, unsigned int p_deviceIndex) {
+        lock_guard<mutex> l_lock(m_mutex);
+        xfblasStream_t& l_stream = m_defaultStreams[p_deviceIndex][p_kernelIndex];
+        if (!l_stream) {
+            l_stream = xfblasStream_t(new BLASStream(p_kernelIndex, p_deviceIndex));
+        }
+        return l_stream;
+    }
+
+   protected:
+    BLASStreamPool() {}
+
+    mutex m_mutex;
+    condition_variable m_ready;
+    condition_variable m_idle;
+    deque<xfblasStream_t> m_readyList;
+    vector<thread> m_workers;
+    unordered_map<unsigned int, unordered_map<unsigned int, xfblasStream_t> > m_defaultStreams;
+    unsigned long long m_pending = 0;
+    bool m_stop = false;
+
+    void retire(const xfblasStream_t& p_stream) {
+        p_stream->m_ops.pop_front();
+        p_stream->m_pending--;
+        m_pending--;
+    }
+
+    // called with m_mutex held on an active stream that is neither queued nor running
+    void advance(const xfblasStream_t& p_stream) {
+        while (!p_stream->m_ops.empty() && p_stream->m_ops.front().m_type != BLASStreamOp::OP_RUN) {
+            BLASStreamOp& l_op = p_stream->m_ops.front();
+            xfblasEvent_t l_event = l_op.m_event;
+            if (l_op.m_type == BLASStreamOp::OP_WAIT) {
+                if (l_event->m_completed < l_op.m_target) {
+                    l_event->m_waiting.push_back(p_stream);
+                    return;
+                }
+                retire(p_stream);
+            } else {
+                l_event->m_completed = max(l_event->m_completed, l_op.m_target);
+                retire(p_stream);
+                vector<xfblasStream_t> l_waiting;
+                l_waiting.swap(l_event->m_waiting);
+                for (auto& l_stream : l_waiting) {
+                    advance(l_stream);
+                }
+                m_idle.notify_all();
+            }
+        }
+        if (p_stream->m_ops.empty()) {
+            p_stream->m_active = false;
+            m_idle.notify_all();
+        } else {
+            m_readyList.push_back(p_stream);
+            m_ready.notify_one();
+        }
+    }
+
+    void work() {
+        unique_lock<mutex> l_lock(m_mutex);
+        while (true) {
+            m_ready.wait(l_lock, [&] { return m_stop || !m_readyList.empty(); });
+            if (m_readyList.empty()) {
+                return;
+            }
+            xfblasStream_t l_stream = m_readyList.front();
+            m_readyList.pop_front();
+            function<xfblasStatus_t()> l_fn = l_stream->m_ops.front().m_fn;
+            l_lock.unlock();
+            xfblasStatus_t l_status = l_fn();
+            l_lock.lock();
+            if (l_stream->m_status == XFBLAS_STATUS_SUCCESS) {
+                l_stream->m_status = l_status;
+            }
+            retire(l_stream);
+            advance(l_stream);
+        }
+    }
+};
+
+} // namespace blas
+
+} // namespace xf
+
+#endif
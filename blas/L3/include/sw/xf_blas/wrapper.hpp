@@ -820,7 +820,10 @@ xfblasStatus_t xfblasDestroy(unsigned int kernelNumber = 1, unsigned int deviceI
 }
 
 /**
- * @brief This function performs the matrix-matrix multiplication C = alpha*op(A)op(B) + beta*C
+ * @brief This function performs the matrix-matrix multiplication C = alpha*op(A)op(B) + beta*C. Untransposed padded
+ * problems with alpha equal to beta are added to the instructions of the kernel, run by the next copy from FPGA device
+ * memory. Other problems are run at once through a padded staging copy that applies op() and the scalars, and their
+ * result is written to the FPGA device memory of C.
  * @param transa operation op(A) that is non- or (conj.) transpose
  * @param transb operation op(B) that is non- or (conj.) transpose
  * @param m number of rows in matrix A, matrix C
@@ -838,6 +841,7 @@ xfblasStatus_t xfblasDestroy(unsigned int kernelNumber = 1, unsigned int deviceI
  * @param deviceIndex index of device that is being used, default is 0
  * @retval xfblasStatus_t 0 if the operation completed successfully
  * @retval xfblasStatus_t 1 if the library was not initialized
+ * @retval xfblasStatus_t 2 if parameters m, n, k <= 0 or a leading dimension is smaller than the cols of its matrix
  * @retval xfblasStatus_t 3 if not all the matrices have FPGA devie memory allocated
  * @retval xfblasStatus_t 4 if the engine is not supported for now
  */
@@ -859,28 +863,266 @@ xfblasStatus_t xfblasGemm(xfblasOperation_t transa,
     if (ConfigDict::instance().m_dict.empty()) {
         return XFBLAS_STATUS_NOT_INITIALIZED;
     }
-    if (ConfigDict::instance().m_dict["GEMX_runGemm"] == "1") {
-        if (transa == XFBLAS_OP_N && transb == XFBLAS_OP_N && alpha == 1 && beta == 1) {
-            GEMMHost* l_gemmPtr =
-                static_cast<GEMMHost*>(BLASHostHandle::instance().m_handlePtr[deviceIndex][kernelIndex].get());
-            xfblasStatus_t l_status;
-            int l_minSize = stoi(ConfigDict::instance().m_dict["minSize"]);
-            if (m % l_minSize != 0 || n % l_minSize != 0 || k % l_minSize != 0) {
-                int padded_m = getPaddedSize(m, l_minSize);
-                int padded_n = getPaddedSize(n, l_minSize);
-                int padded_k = getPaddedSize(k, l_minSize);
-                int paddedLda = getPaddedSize(lda, l_minSize);
-                int paddedLdb = getPaddedSize(ldb, l_minSize);
-                int paddedLdc = getPaddedSize(ldc, l_minSize);
-                l_status = l_gemmPtr->addGEMMOp(A, B, C, C, padded_m, padded_n, padded_k, paddedLda, paddedLdb,
-                                                paddedLdc, paddedLdc, 1, 0);
-            } else {
-                l_status = l_gemmPtr->addGEMMOp(A, B, C, C, m, n, k, lda, ldb, ldc, ldc, 1, 0);
+    if (ConfigDict::instance().m_dict["GEMX_runGemm"] != "1") {
+        return XFBLAS_STATUS_NOT_SUPPORTED;
+    }
+    bool l_transA = transa != XFBLAS_OP_N;
+    bool l_transB = transb != XFBLAS_OP_N;
+    if (m <= 0 || n <= 0 || k <= 0 || lda < (l_transA ? m : k) || ldb < (l_transB ? k : n) || ldc < n) {
+        return XFBLAS_STATUS_INVALID_VALUE;
+    }
+    GEMMHost* l_gemmPtr =
+        static_cast<GEMMHost*>(BLASHostHandle::instance().m_handlePtr[deviceIndex][kernelIndex].get());
+    string l_dataType = ConfigDict::instance().m_dict["GEMX_dataType"];
+    int l_minSize = stoi(ConfigDict::instance().m_dict["minSize"]);
+    int l_paddedLda = getPaddedSize(lda, l_minSize);
+    int l_paddedLdb = getPaddedSize(ldb, l_minSize);
+    int l_paddedLdc = getPaddedSize(ldc, l_minSize);
+    // the post-scale stage only scales the integer results
+    bool l_kernelScale = l_dataType == "short";
+    bool l_padded = m % l_minSize == 0 && n % l_minSize == 0 && k % l_minSize == 0;
+
+    if (!l_transA && !l_transB && l_padded && alpha == beta && (alpha == 1 || l_kernelScale)) {
+        return l_gemmPtr->addGEMMOp(A, B, C, C, m, n, k, l_paddedLda, l_paddedLdb, l_paddedLdc, l_paddedLdc, alpha, 0);
+    }
+    if (l_dataType == "short") {
+        return l_gemmPtr->runGEMMStaged<short>(l_transA, l_transB, m, n, k, alpha, A, l_paddedLda, B, l_paddedLdb, beta,
+                                               C, l_paddedLdc, l_minSize, l_kernelScale);
+    } else if (l_dataType == "float") {
+        return l_gemmPtr->runGEMMStaged<float>(l_transA, l_transB, m, n, k, alpha, A, l_paddedLda, B, l_paddedLdb, beta,
+                                               C, l_paddedLdc, l_minSize, l_kernelScale);
+    } else if (l_dataType == "int") {
+        return l_gemmPtr->runGEMMStaged<int>(l_transA, l_transB, m, n, k, alpha, A, l_paddedLda, B, l_paddedLdb, beta,
+                                             C, l_paddedLdc, l_minSize, l_kernelScale);
+    } else {
+        return XFBLAS_STATUS_NOT_SUPPORTED;
+    }
+}
+
+/**
+ * @brief This function performs the matrix-matrix multiplications C[i] = alpha*op(A[i])op(B[i]) + beta*C[i] for
+ * batchCount problems of the same sizes. The matrices are in host memory and need no xfblasMalloc, the problems are
+ * packed into one device buffer and one instruction stream, and executed at once. Batches larger than the instruction
+ * buffer are run in groups that fill it. The results are in C when the function returns.
+ * @param transa operation op(A) that is non- or (conj.) transpose
+ * @param transb operation op(B) that is non- or (conj.) transpose
+ * @param m number of rows in matrix A, matrix C
+ * @param n number of cols in matrix B, matrix C
+ * @param k number of cols in matrix A, number of rows in matrix B
+ * @param alpha scalar used for multiplication
+ * @param Aarray array of pointers to the matrices A in the host memory
+ * @param lda leading dimension of matirx A
+ * @param Barray array of pointers to the matrices B in the host memory
+ * @param ldb leading dimension of matrix B
+ * @param beta scalar used for multiplication
+ * @param Carray array of pointers to the matrices C in the host memory
+ * @param ldc leading dimension of matrix C
+ * @param batchCount number of problems
+ * @param kernelIndex index of kernel that is being used, default is 0
+ * @param deviceIndex index of device that is being used, default is 0
+ * @retval xfblasStatus_t 0 if the operation completed successfully
+ * @retval xfblasStatus_t 1 if the library was not initialized
+ * @retval xfblasStatus_t 2 if parameters m, n, k, batchCount <= 0 or a leading dimension is too small
+ * @retval xfblasStatus_t 3 if the device memory for the batch could not be allocated or copied
+ * @retval xfblasStatus_t 4 if the engine is not supported for now
+ */
+xfblasStatus_t xfblasGemmBatched(xfblasOperation_t transa,
+                                 xfblasOperation_t transb,
+                                 int m,
+                                 int n,
+                                 int k,
+                                 int alpha,
+                                 void* const Aarray[],
+                                 int lda,
+                                 void* const Barray[],
+                                 int ldb,
+                                 int beta,
+                                 void* const Carray[],
+                                 int ldc,
+                                 int batchCount,
+                                 unsigned int kernelIndex = 0,
+                                 unsigned int deviceIndex = 0) {
+    if (ConfigDict::instance().m_dict.empty()) {
+        return XFBLAS_STATUS_NOT_INITIALIZED;
+    }
+    if (ConfigDict::instance().m_dict["GEMX_runGemm"] != "1") {
+        return XFBLAS_STATUS_NOT_SUPPORTED;
+    }
+    bool l_transA = transa != XFBLAS_OP_N;
+    bool l_transB = transb != XFBLAS_OP_N;
+    if (m <= 0 || n <= 0 || k <= 0 || batchCount <= 0 || lda < (l_transA ? m : k) || ldb < (l_transB ? k : n) ||
+        ldc < n) {
+        return XFBLAS_STATUS_INVALID_VALUE;
+    }
+    GEMMHost* l_gemmPtr =
+        static_cast<GEMMHost*>(BLASHostHandle::instance().m_handlePtr[deviceIndex][kernelIndex].get());
+    string l_dataType = ConfigDict::instance().m_dict["GEMX_dataType"];
+    int l_minSize = stoi(ConfigDict::instance().m_dict["minSize"]);
+    bool l_kernelScale = l_dataType == "short";
+    if (l_dataType == "short") {
+        return l_gemmPtr->runGEMMBatch<short>(l_transA, l_transB, alpha, Aarray, Barray, beta, Carray, batchCount, m, n,
+                                              k, lda, ldb, ldc, l_minSize, l_kernelScale);
+    } else if (l_dataType == "float") {
+        return l_gemmPtr->runGEMMBatch<float>(l_transA, l_transB, alpha, Aarray, Barray, beta, Carray, batchCount, m, n,
+                                              k, lda, ldb, ldc, l_minSize, l_kernelScale);
+    } else if (l_dataType == "int") {
+        return l_gemmPtr->runGEMMBatch<int>(l_transA, l_transB, alpha, Aarray, Barray, beta, Carray, batchCount, m, n,
+                                            k, lda, ldb, ldc, l_minSize, l_kernelScale);
+    } else {
+        return XFBLAS_STATUS_NOT_SUPPORTED;
+    }
+}
+
+/**
+ * @brief This function performs the same batched matrix-matrix multiplications as xfblasGemmBatched, with the
+ * problems at a fixed distance from each other in three host arrays
+ * @param transa operation op(A) that is non- or (conj.) transpose
+ * @param transb operation op(B) that is non- or (conj.) transpose
+ * @param m number of rows in matrix A, matrix C
+ * @param n number of cols in matrix B, matrix C
+ * @param k number of cols in matrix A, number of rows in matrix B
+ * @param alpha scalar used for multiplication
+ * @param A pointer to the first matrix A in the host memory
+ * @param lda leading dimension of matirx A
+ * @param strideA number of elements from one matrix A to the next
+ * @param B pointer to the first matrix B in the host memory
+ * @param ldb leading dimension of matrix B
+ * @param strideB number of elements from one matrix B to the next
+ * @param beta scalar used for multiplication
+ * @param C pointer to the first matrix C in the host memory
+ * @param ldc leading dimension of matrix C
+ * @param strideC number of elements from one matrix C to the next
+ * @param batchCount number of problems
+ * @param kernelIndex index of kernel that is being used, default is 0
+ * @param deviceIndex index of device that is being used, default is 0
+ * @retval xfblasStatus_t 0 if the operation completed successfully
+ * @retval xfblasStatus_t 1 if the library was not initialized
+ * @retval xfblasStatus_t 2 if parameters m, n, k, batchCount <= 0 or a leading dimension is too small
+ * @retval xfblasStatus_t 3 if the device memory for the batch could not be allocated or copied
+ * @retval xfblasStatus_t 4 if the engine is not supported for now
+ */
+xfblasStatus_t xfblasGemmStridedBatched(xfblasOperation_t transa,
+                                        xfblasOperation_t transb,
+                                        int m,
+                                        int n,
+                                        int k,
+                                        int alpha,
+                                        void* A,
+                                        int lda,
+                                        long long strideA,
+                                        void* B,
+                                        int ldb,
+                                        long long strideB,
+                                        int beta,
+                                        void* C,
+                                        int ldc,
+                                        long long strideC,
+                                        int batchCount,
+                                        unsigned int kernelIndex = 0,
+                                        unsigned int deviceIndex = 0) {
+    if (ConfigDict::instance().m_dict.empty()) {
+        return XFBLAS_STATUS_NOT_INITIALIZED;
+    }
+    if (batchCount <= 0) {
+        return XFBLAS_STATUS_INVALID_VALUE;
+    }
+    int l_elemSize = getTypeSize(ConfigDict::instance().m_dict["GEMX_dataType"]);
+    vector<void*> l_a(batchCount), l_b(batchCount), l_c(batchCount);
+    for (int i = 0; i < batchCount; i++) {
+        l_a[i] = (char*)A + i * strideA * l_elemSize;
+        l_b[i] = (char*)B + i * strideB * l_elemSize;
+        l_c[i] = (char*)C + i * strideC * l_elemSize;
+    }
+    return xfblasGemmBatched(transa, transb, m, n, k, alpha, l_a.data(), lda, l_b.data(), ldb, beta, l_c.data(), ldc,
+                             batchCount, kernelIndex, deviceIndex);
+}
+
+/**
+ * @brief This function performs the matrix-matrix multiplication C = alpha*op(A)op(B) + beta*C on matrices in host
+ * memory that may be larger than the FPGA device memory. C is cut into tiles and k into panels sized to the memory of
+ * each kernel. The tiles are shared among all the kernels of all the devices. Each kernel keeps its tile of C in device
+ * memory while the panels of A and B are streamed through two buffers, the next one being copied while the current one
+ * is computed. The results are in C when the function returns.
+ * @param transa operation op(A) that is non- or (conj.) transpose
+ * @param transb operation op(B) that is non- or (conj.) transpose
+ * @param m number of rows in matrix A, matrix C
+ * @param n number of cols in matrix B, matrix C
+ * @param k number of cols in matrix A, number of rows in matrix B
+ * @param alpha scalar used for multiplication
+ * @param A pointer to matrix A in the host memory
+ * @param lda leading dimension of matirx A
+ * @param B pointer to matrix B in the host memory
+ * @param ldb leading dimension of matrix B
+ * @param beta scalar used for multiplication
+ * @param C pointer to matrix C in the host memory
+ * @param ldc leading dimension of matrix C
+ * @param memSize bytes of device memory used by each kernel, default 0 uses half of its share of its memory bank, the
+ * bank being divided among the kernels connected to it
+ * @retval xfblasStatus_t 0 if the operation completed successfully
+ * @retval xfblasStatus_t 1 if the library was not initialized
+ * @retval xfblasStatus_t 2 if parameters m, n, k <= 0, a leading dimension is too small or memSize is too small for
+ * one tile
+ * @retval xfblasStatus_t 3 if the device memory for the tiles could not be allocated or copied
+ * @retval xfblasStatus_t 4 if the engine is not supported for now
+ */
+xfblasStatus_t xfblasGemmTiled(xfblasOperation_t transa,
+                               xfblasOperation_t transb,
+                               int m,
+                               int n,
+                               int k,
+                               int alpha,
+                               void* A,
+                               int lda,
+                               void* B,
+                               int ldb,
+                               int beta,
+                               void* C,
+                               int ldc,
+                               unsigned long long memSize = 0) {
+    if (ConfigDict::instance().m_dict.empty()) {
+        return XFBLAS_STATUS_NOT_INITIALIZED;
+    }
+    if (ConfigDict::instance().m_dict["GEMX_runGemm"] != "1") {
+        return XFBLAS_STATUS_NOT_SUPPORTED;
+    }
+    bool l_transA = transa != XFBLAS_OP_N;
+    bool l_transB = transb != XFBLAS_OP_N;
+    if (m <= 0 || n <= 0 || k <= 0 || lda < (l_transA ? m : k) || ldb < (l_transB ? k : n) || ldc < n) {
+        return XFBLAS_STATUS_INVALID_VALUE;
+    }
+    string l_dataType = ConfigDict::instance().m_dict["GEMX_dataType"];
+    if (memSize == 0) {
+        for (auto& l_device : BLASHostHandle::instance().m_handlePtr) {
+            for (auto& l_host : l_device.second) {
+                unsigned long long l_memSize = l_host->getMemShare() / 2;
+                memSize = memSize == 0 ? l_memSize : min(memSize, l_memSize);
             }
-            return l_status;
-        } else {
-            return XFBLAS_STATUS_NOT_SUPPORTED;
         }
+    }
+    GEMMTiling l_plan;
+    l_plan.m_transA = l_transA;
+    l_plan.m_transB = l_transB;
+    l_plan.m_m = m;
+    l_plan.m_n = n;
+    l_plan.m_k = k;
+    l_plan.m_aScale = alpha;
+    l_plan.m_cScale = beta;
+    l_plan.m_a = A;
+    l_plan.m_b = B;
+    l_plan.m_c = C;
+    l_plan.m_lda = lda;
+    l_plan.m_ldb = ldb;
+    l_plan.m_ldc = ldc;
+    l_plan.m_minSize = stoi(ConfigDict::instance().m_dict["minSize"]);
+    if (!l_plan.plan(memSize, getTypeSize(l_dataType))) {
+        return XFBLAS_STATUS_INVALID_VALUE;
+    }
+    if (l_dataType == "short") {
+        return runGEMMTiled<short>(l_plan);
+    } else if (l_dataType == "float") {
+        return runGEMMTiled<float>(l_plan);
+    } else if (l_dataType == "int") {
+        return runGEMMTiled<int>(l_plan);
     } else {
         return XFBLAS_STATUS_NOT_SUPPORTED;
     }
@@ -20,16 +20,271 @@
 #include "handle.hpp"
 #include "gemm_host.hpp"
 #include "gemv_host.hpp"
-#include <future>
+#include "stream.hpp"
+#include "wrapper.hpp"
 
 namespace xf {
 
 namespace blas {
 
-vector<future<xfblasStatus_t> > fuStatus;
+/**
+ * @brief This function creates a stream bound to one kernel. Operations enqueued on a stream run in order, operations
+ * of different streams run concurrently on a fixed pool of worker threads.
+ * @param stream pointer to the created stream
+ * @param kernelIndex index of kernel that is being used, default is 0
+ * @param deviceIndex index of device that is being used, default is 0
+ * @retval xfblasStatus_t 0 if the stream was created
+ * @retval xfblasStatus_t 1 if the library was not initialized
+ */
+xfblasStatus_t xfblasStreamCreate(xfblasStream_t* stream, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
+    if (ConfigDict::instance().m_dict.empty()) {
+        return XFBLAS_STATUS_NOT_INITIALIZED;
+    }
+    *stream = xfblasStream_t(new BLASStream(kernelIndex, deviceIndex));
+    return XFBLAS_STATUS_SUCCESS;
+}
+
+/**
+ * @brief This function blocks until all the operations enqueued on the stream have completed
+ * @param stream the stream
+ * @retval xfblasStatus_t status of the first failed operation since the last synchronization, 0 if all succeeded
+ */
+xfblasStatus_t xfblasStreamSynchronize(xfblasStream_t stream) {
+    return BLASStreamPool::instance().synchronize(stream);
+}
+
+/**
+ * @brief This function waits for the operations of the stream and releases it
+ * @param stream the stream
+ * @retval xfblasStatus_t status of the first failed operation since the last synchronization, 0 if all succeeded
+ */
+xfblasStatus_t xfblasStreamDestroy(xfblasStream_t& stream) {
+    xfblasStatus_t l_status = BLASStreamPool::instance().synchronize(stream);
+    stream.reset();
+    return l_status;
+}
+
+/**
+ * @brief This function creates an event used to order operations across streams
+ * @param event pointer to the created event
+ * @retval xfblasStatus_t 0 if the event was created
+ */
+xfblasStatus_t xfblasEventCreate(xfblasEvent_t* event) {
+    *event = xfblasEvent_t(new BLASEvent());
+    return XFBLAS_STATUS_SUCCESS;
+}
+
+/**
+ * @brief This function records the event at the current end of the stream, the event completes when all the
+ * operations enqueued on the stream before it have completed
+ * @param event the event
+ * @param stream the stream
+ * @retval xfblasStatus_t 0 if the record was enqueued
+ */
+xfblasStatus_t xfblasEventRecord(xfblasEvent_t event, xfblasStream_t stream) {
+    BLASStreamPool::instance().record(event, stream);
+    return XFBLAS_STATUS_SUCCESS;
+}
+
+/**
+ * @brief This function makes the operations enqueued on the stream afterwards wait for the last record of the event.
+ * The host is not blocked, and an event never recorded is not waited for.
+ * @param stream the stream
+ * @param event the event
+ * @retval xfblasStatus_t 0 if the wait was enqueued
+ */
+xfblasStatus_t xfblasStreamWaitEvent(xfblasStream_t stream, xfblasEvent_t event) {
+    BLASStreamPool::instance().wait(stream, event);
+    return XFBLAS_STATUS_SUCCESS;
+}
+
+/**
+ * @brief This function blocks until the last record of the event has completed
+ * @param event the event
+ * @retval xfblasStatus_t 0 if the event completed
+ */
+xfblasStatus_t xfblasEventSynchronize(xfblasEvent_t event) {
+    BLASStreamPool::instance().synchronize(event);
+    return XFBLAS_STATUS_SUCCESS;
+}
+
+/**
+ * @brief This asynchronous function copies a matrix in host memory to FPGA device memory. Arguments are copied when
+ * the operation is enqueued, the host matrix must stay valid until the stream is synchronized.
+ * @param rows number of rows in the matrix
+ * @param cols number of cols in the matrix that is being used
+ * @param elemSize number of bytes required to store each element in the matrix
+ * @param A pointer to the matrix array in the host memory
+ * @param lda leading dimension of the matrix that indicates the total number of cols in the matrix
+ * @param d_A pointer to mapped memory
+ * @param stream the stream the copy is enqueued on
+ */
+void xfblasSetMatrixAsync(int rows, int cols, int elemSize, short* A, int lda, short* d_A, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(stream, BLASStreamOp([=] {
+        return xfblasSetMatrix(rows, cols, elemSize, A, lda, d_A, kernelIndex, deviceIndex);
+    }));
+}
+
+void xfblasSetMatrixAsync(int rows, int cols, int elemSize, float* A, int lda, float* d_A, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(stream, BLASStreamOp([=] {
+        return xfblasSetMatrix(rows, cols, elemSize, A, lda, d_A, kernelIndex, deviceIndex);
+    }));
+}
+
+/**
+ * @brief This asynchronous function copies a vector in host memory to FPGA device memory
+ * @param n number of elements in vector
+ * @param elemSize number of bytes required to store each element in the vector
+ * @param x pointer to the vector in the host memory
+ * @param incx the storage spacing between consecutive elements of vector x
+ * @param d_x pointer to mapped memory
+ * @param stream the stream the copy is enqueued on
+ */
+void xfblasSetVectorAsync(int n, int elemSize, short* x, int incx, short* d_x, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(
+        stream, BLASStreamOp([=] { return xfblasSetVector(n, elemSize, x, incx, d_x, kernelIndex, deviceIndex); }));
+}
+
+void xfblasSetVectorAsync(int n, int elemSize, float* x, int incx, float* d_x, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(
+        stream, BLASStreamOp([=] { return xfblasSetVector(n, elemSize, x, incx, d_x, kernelIndex, deviceIndex); }));
+}
+
+/**
+ * @brief This asynchronous function copies a matrix in FPGA device memory to host memory, the instructions added to
+ * the kernel before are executed first
+ * @param rows number of rows in the matrix
+ * @param cols number of cols in the matrix that is being used
+ * @param elemSize number of bytes required to store each element in the matrix
+ * @param d_A pointer to mapped memory
+ * @param A pointer to the matrix array in the host memory
+ * @param lda leading dimension of the matrix that indicates the total number of cols in the matrix
+ * @param stream the stream the copy is enqueued on
+ */
+void xfblasGetMatrixAsync(int rows, int cols, int elemSize, short* d_A, short* A, int lda, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(stream, BLASStreamOp([=] {
+        return xfblasGetMatrix(rows, cols, elemSize, d_A, A, lda, kernelIndex, deviceIndex);
+    }));
+}
+
+void xfblasGetMatrixAsync(int rows, int cols, int elemSize, float* d_A, float* A, int lda, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(stream, BLASStreamOp([=] {
+        return xfblasGetMatrix(rows, cols, elemSize, d_A, A, lda, kernelIndex, deviceIndex);
+    }));
+}
+
+/**
+ * @brief This asynchronous function copies a vector in FPGA device memory to host memory
+ * @param n number of elements in vector
+ * @param elemSize number of bytes required to store each element in the vector
+ * @param d_x pointer to mapped memory
+ * @param x pointer to the vector in the host memory
+ * @param incx the storage spacing between consecutive elements of vector x
+ * @param stream the stream the copy is enqueued on
+ */
+void xfblasGetVectorAsync(int n, int elemSize, short* d_x, short* x, int incx, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(
+        stream, BLASStreamOp([=] { return xfblasGetVector(n, elemSize, d_x, x, incx, kernelIndex, deviceIndex); }));
+}
+
+void xfblasGetVectorAsync(int n, int elemSize, float* d_x, float* x, int incx, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(
+        stream, BLASStreamOp([=] { return xfblasGetVector(n, elemSize, d_x, x, incx, kernelIndex, deviceIndex); }));
+}
+
+/**
+ * @brief This asynchronous function copies a matrix in host memory to FPGA device memory
+ * @param A pointer to matrix A in the host memory
+ * @param stream the stream the copy is enqueued on
+ */
+void xfblasSetMatrixRestrictedAsync(void* A, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(
+        stream, BLASStreamOp([=] { return xfblasSetMatrixRestricted(A, kernelIndex, deviceIndex); }));
+}
+
+/**
+ * @brief This asynchronous function copies a vector in host memory to FPGA device memory
+ * @param x pointer to vector x in the host memory
+ * @param stream the stream the copy is enqueued on
+ */
+void xfblasSetVectorRestrictedAsync(void* x, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(
+        stream, BLASStreamOp([=] { return xfblasSetVectorRestricted(x, kernelIndex, deviceIndex); }));
+}
 
 /**
  * @brief This asynchronous function copies a matrix in FPGA device memory to host memory
+ * @param A pointer to matrix A in the host memory
+ * @param stream the stream the copy is enqueued on
+ */
+void xfblasGetMatrixRestrictedAsync(void* A, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(
+        stream, BLASStreamOp([=] { return xfblasGetMatrixRestricted(A, kernelIndex, deviceIndex); }));
+}
+
+/**
+ * @brief This asynchronous function copies a vector in FPGA device memory to host memory
+ * @param x pointer to vector x in the host memory
+ * @param stream the stream the copy is enqueued on
+ */
+void xfblasGetVectorRestrictedAsync(void* x, xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(
+        stream, BLASStreamOp([=] { return xfblasGetVectorRestricted(x, kernelIndex, deviceIndex); }));
+}
+
+/**
+ * @brief This asynchronous function adds the matrix-matrix multiplication C = alpha*op(A)op(B) + beta*C to the
+ * kernel of the stream, it is executed by the next copy from FPGA device memory on the stream
+ * @param transa operation op(A) that is non- or (conj.) transpose
+ * @param transb operation op(B) that is non- or (conj.) transpose
+ * @param m number of rows in matrix A, matrix C
+ * @param n number of cols in matrix B, matrix C
+ * @param k number of cols in matrix A, number of rows in matrix B
+ * @param alpha scalar used for multiplication
+ * @param A pointer to matrix A in the host memory
+ * @param lda leading dimension of matirx A
+ * @param B pointer to matrix B in the host memory
+ * @param ldb leading dimension of matrix B
+ * @param beta scalar used for multiplication
+ * @param C pointer to matrix C in the host memory
+ * @param ldc leading dimension of matrix C
+ * @param stream the stream the operation is enqueued on
+ */
+void xfblasGemmAsync(xfblasOperation_t transa,
+                     xfblasOperation_t transb,
+                     int m,
+                     int n,
+                     int k,
+                     int alpha,
+                     void* A,
+                     int lda,
+                     void* B,
+                     int ldb,
+                     int beta,
+                     void* C,
+                     int ldc,
+                     xfblasStream_t stream) {
+    unsigned int kernelIndex = stream->m_kernelIndex, deviceIndex = stream->m_deviceIndex;
+    BLASStreamPool::instance().enqueue(stream, BLASStreamOp([=] {
+        return xfblasGemm(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, kernelIndex, deviceIndex);
+    }));
+}
+
+/**
+ * @brief This asynchronous function copies a matrix in FPGA device memory to host memory, on the default stream of
+ * the kernel
  * @param rows number of rows in the matrix
  * @param cols number of cols in the matrix that is being used
  * @param elemSize number of bytes required to store each element in the matrix
@@ -47,8 +302,8 @@ void xfblasGetMatrixAsync(int rows,
                           int lda,
                           unsigned int kernelIndex = 0,
                           unsigned int deviceIndex = 0) {
-    fuStatus.push_back(async(
-        launch::async, [&] { return xfblasGetMatrix(rows, cols, elemSize, d_A, A, lda, kernelIndex, deviceIndex); }));
+    xfblasGetMatrixAsync(rows, cols, elemSize, d_A, A, lda,
+                         BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
 }
 
 void xfblasGetMatrixAsync(int rows,
@@ -59,12 +314,49 @@ void xfblasGetMatrixAsync(int rows,
                           int lda,
                           unsigned int kernelIndex = 0,
                           unsigned int deviceIndex = 0) {
-    fuStatus.push_back(async(
-        launch::async, [&] { return xfblasGetMatrix(rows, cols, elemSize, d_A, A, lda, kernelIndex, deviceIndex); }));
+    xfblasGetMatrixAsync(rows, cols, elemSize, d_A, A, lda,
+                         BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
 }
 
 /**
- * @brief This asynchronous function copies a vector in FPGA device memory to host memory
+ * @brief This asynchronous function copies a matrix in host memory to FPGA device memory, on the default stream of
+ * the kernel
+ * @param rows number of rows in the matrix
+ * @param cols number of cols in the matrix that is being used
+ * @param elemSize number of bytes required to store each element in the matrix
+ * @param A pointer to the matrix array in the host memory
+ * @param lda leading dimension of the matrix that indicates the total number of cols in the matrix
+ * @param d_A pointer to mapped memory
+ * @param kernelIndex index of kernel that is being used, default is 0
+ * @param deviceIndex index of device that is being used, default is 0
+ */
+void xfblasSetMatrixAsync(int rows,
+                          int cols,
+                          int elemSize,
+                          short* A,
+                          int lda,
+                          short* d_A,
+                          unsigned int kernelIndex = 0,
+                          unsigned int deviceIndex = 0) {
+    xfblasSetMatrixAsync(rows, cols, elemSize, A, lda, d_A,
+                         BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
+}
+
+void xfblasSetMatrixAsync(int rows,
+                          int cols,
+                          int elemSize,
+                          float* A,
+                          int lda,
+                          float* d_A,
+                          unsigned int kernelIndex = 0,
+                          unsigned int deviceIndex = 0) {
+    xfblasSetMatrixAsync(rows, cols, elemSize, A, lda, d_A,
+                         BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
+}
+
+/**
+ * @brief This asynchronous function copies a vector in FPGA device memory to host memory, on the default stream of
+ * the kernel
  * @param n number of elements in vector
  * @param elemSize number of bytes required to store each element in the vector
  * @param d_x pointer to mapped memory
@@ -75,41 +367,84 @@ void xfblasGetMatrixAsync(int rows,
  */
 void xfblasGetVectorAsync(
     int n, int elemSize, short* d_x, short* x, int incx, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
-    fuStatus.push_back(
-        async(launch::async, [&] { return xfblasGetVector(n, elemSize, d_x, x, incx, kernelIndex, deviceIndex); }));
+    xfblasGetVectorAsync(n, elemSize, d_x, x, incx, BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
 }
 
 void xfblasGetVectorAsync(
     int n, int elemSize, float* d_x, float* x, int incx, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
-    fuStatus.push_back(
-        async(launch::async, [&] { return xfblasGetVector(n, elemSize, d_x, x, incx, kernelIndex, deviceIndex); }));
+    xfblasGetVectorAsync(n, elemSize, d_x, x, incx, BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
 }
 
 /**
- * @brief This asynchronous function copies a matrix in FPGA device memory to host memory
+ * @brief This asynchronous function copies a vector in host memory to FPGA device memory, on the default stream of
+ * the kernel
+ * @param n number of elements in vector
+ * @param elemSize number of bytes required to store each element in the vector
+ * @param x pointer to the vector in the host memory
+ * @param incx the storage spacing between consecutive elements of vector x
+ * @param d_x pointer to mapped memory
+ * @param kernelIndex index of kernel that is being used, default is 0
+ * @param deviceIndex index of device that is being used, default is 0
+ */
+void xfblasSetVectorAsync(
+    int n, int elemSize, short* x, int incx, short* d_x, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
+    xfblasSetVectorAsync(n, elemSize, x, incx, d_x, BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
+}
+
+void xfblasSetVectorAsync(
+    int n, int elemSize, float* x, int incx, float* d_x, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
+    xfblasSetVectorAsync(n, elemSize, x, incx, d_x, BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
+}
+
+/**
+ * @brief This asynchronous function copies a matrix in FPGA device memory to host memory, on the default stream of
+ * the kernel
  * @param A pointer to matrix A in the host memory
  * @param kernelIndex index of kernel that is being used, default is 0
  * @param deviceIndex index of device that is being used, default is 0
  */
 void xfblasGetMatrixRestrictedAsync(void* A, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
-    fuStatus.push_back(async(launch::async, xfblasGetMatrixRestricted, A, kernelIndex, deviceIndex));
+    xfblasGetMatrixRestrictedAsync(A, BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
 }
 
 /**
- * @brief This asynchronous function copies a matrix in FPGA device memory to host memory
+ * @brief This asynchronous function copies a matrix in FPGA device memory to host memory, on the default stream of
+ * the kernel
  * @param x pointer to vetcor x in the host memory
  * @param kernelIndex index of kernel that is being used, default is 0
  * @param deviceIndex index of device that is being used, default is 0
  */
 void xfblasGetVectorRestrictedAsync(void* x, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
-    fuStatus.push_back(async(launch::async, xfblasGetVectorRestricted, x, kernelIndex, deviceIndex));
+    xfblasGetVectorRestrictedAsync(x, BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
+}
+
+/**
+ * @brief This asynchronous function copies a matrix in host memory to FPGA device memory, on the default stream of
+ * the kernel
+ * @param A pointer to matrix A in the host memory
+ * @param kernelIndex index of kernel that is being used, default is 0
+ * @param deviceIndex index of device that is being used, default is 0
+ */
+void xfblasSetMatrixRestrictedAsync(void* A, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
+    xfblasSetMatrixRestrictedAsync(A, BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
+}
+
+/**
+ * @brief This asynchronous function copies a vector in host memory to FPGA device memory, on the default stream of
+ * the kernel
+ * @param x pointer to vector x in the host memory
+ * @param kernelIndex index of kernel that is being used, default is 0
+ * @param deviceIndex index of device that is being used, default is 0
+ */
+void xfblasSetVectorRestrictedAsync(void* x, unsigned int kernelIndex = 0, unsigned int deviceIndex = 0) {
+    xfblasSetVectorRestrictedAsync(x, BLASStreamPool::instance().defaultStream(kernelIndex, deviceIndex));
 }
 
+/**
+ * @brief This function blocks until the operations enqueued on all the streams have completed
+ */
 void xfblasKernelSynchronize() {
-    for (auto& fu : fuStatus) {
-        fu.wait();
-    }
-    fuStatus.clear();
+    BLASStreamPool::instance().synchronizeAll();
 }
 
 } // namespace blas
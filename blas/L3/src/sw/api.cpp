@@ -82,6 +82,17 @@ bool xfblasGet(void* A, unsigned int kernelIndex, unsigned int deviceIndex) {
     return true;
 }
 
+bool xfblasAlloc(
+    void* A, unsigned long long numElem, int elemSize, unsigned int kernelIndex, unsigned int deviceIndex) {
+    unsigned long long l_bufSize = numElem * elemSize;
+    xfblasStatus_t l_status =
+        BLASHostHandle::instance().m_handlePtr[deviceIndex][kernelIndex]->allocMatRestricted(A, A, l_bufSize);
+    if (l_status != XFBLAS_STATUS_SUCCESS) {
+        return false;
+    }
+    return true;
+}
+
 bool xfblasGetByAddress(
     void* A, unsigned long long p_bufSize, unsigned int offset, unsigned int kernelIndex, unsigned int deviceIndex) {
     xfblasStatus_t l_status =
@@ -235,5 +246,56 @@ bool xfblasFcnByAddress(unsigned int l_aOff,
     xfblasStatus_t l_status =
         l_fcnPtr->addFCNOpByAddress(l_aOff, l_bOff, l_cOff, l_xOff, p_m, p_n, p_k, p_lda, p_ldb, p_ldc, p_ldx,
                                     p_postScale, p_postShift, p_preluScale, p_preluAlpha);
+    if (l_status != XFBLAS_STATUS_SUCCESS) {
+        return false;
+    }
+    return true;
+}
+
+bool xfblasFcnChain(xfblasFcnLayer_t* layers,
+                    unsigned int numLayers,
+                    char* dataType,
+                    unsigned int kernelIndex,
+                    unsigned int deviceIndex) {
+    vector<FcnLayer> l_layers(numLayers);
+    for (unsigned int i = 0; i < numLayers; i++) {
+        const xfblasFcnLayer_t& l_in = layers[i];
+        if (l_in.activation < FcnActLinear || l_in.activation > FcnActSoftmax) {
+            return false;
+        }
+        l_layers[i] = {l_in.A,
+                       l_in.B,
+                       l_in.C,
+                       l_in.X,
+                       (unsigned int)l_in.m,
+                       (unsigned int)l_in.n,
+                       (unsigned int)l_in.k,
+                       (unsigned int)l_in.lda,
+                       (unsigned int)l_in.ldb,
+                       (unsigned int)l_in.ldc,
+                       (unsigned int)l_in.ldx,
+                       l_in.postScale,
+                       l_in.postShift,
+                       l_in.preluScale,
+                       l_in.preluAlpha,
+                       (FcnActType)l_in.activation,
+                       (unsigned int)l_in.validN,
+                       l_in.actScaleIn,
+                       l_in.actScaleOut};
+    }
+    FCNHost* l_fcnPtr = static_cast<FCNHost*>(BLASHostHandle::instance().m_handlePtr[deviceIndex][kernelIndex].get());
+    xfblasStatus_t l_status;
+    if (strcmp(dataType, "float") == 0) {
+        l_status = l_fcnPtr->runFCNChain<float>(l_layers);
+    } else if (strcmp(dataType, "short") == 0) {
+        l_status = l_fcnPtr->runFCNChain<short>(l_layers);
+    } else if (strcmp(dataType, "int") == 0) {
+        l_status = l_fcnPtr->runFCNChain<int>(l_layers);
+    } else {
+        return false;
+    }
+    if (l_status != XFBLAS_STATUS_SUCCESS) {
+        return false;
+    }
     return true;
 }
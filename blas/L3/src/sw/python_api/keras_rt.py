@@ -44,6 +44,7 @@ class KerasRT(XfblasRT):
       keras_b = keras_model.get_weights()[1::2]
       XfblasRT.__init__(self, xclbin_opts, keras_w, keras_b, wgt_scale, bias_scale, post_scale,relu_scale,idxKernel,idxDevice)
       self.kmodel = keras_model
+      self.wgt_scale = wgt_scale
        
     def loadInstr(self):
       xfblas.freeInstr(self.idxKernel,self.idxDevice)
@@ -77,4 +78,57 @@ class KerasRT(XfblasRT):
             if act == 'relu':
               xfblas.fcnOpByAddress(self.offset_list[2*numLayers+i],self.offset_list[i],self.offset_list[2*numLayers+i+1],self.offset_list[numLayers+i],self.fpga_buf[i], self._qw[i], self.fpga_buf[i+1], self._qb[i], self.post_scale[i][0], self.post_scale[i][1], 0, 0, self.idxKernel,self.idxDevice)
             else:
-              xfblas.fcnOpByAddress(self.offset_list[2*numLayers+i],self.offset_list[i],self.offset_list[2*numLayers+i+1],self.offset_list[numLayers+i],self.fpga_buf[i], self._qw[i], self.fpga_buf[i+1], self._qb[i], self.post_scale[i][0], self.post_scale[i][1], 1, 0, self.idxKernel,self.idxDevice)
\ No newline at end of file
+              xfblas.fcnOpByAddress(self.offset_list[2*numLayers+i],self.offset_list[i],self.offset_list[2*numLayers+i+1],self.offset_list[numLayers+i],self.fpga_buf[i], self._qw[i], self.fpga_buf[i+1], self._qb[i], self.post_scale[i][0], self.post_scale[i][1], 1, 0, self.idxKernel,self.idxDevice)
+
+    def predict_fused(self, inp, in_scale, out_scale=32767.0):
+      '''
+      Return output prediction for the input sample, running all layers as one fcn chain. Intermediate results stay on
+      FPGA, only layers with sigmoid, tanh, gelu or softmax activation are read back, activated on host and sent again
+      
+      Parameters
+      
+      inp
+            input sample
+      in_scale
+            scale of input sample
+      out_scale
+            scale of the output of a host activation on the last layer, ignored with float xclbin
+      '''
+      self.init_fpgabuf(inp.shape)
+      isFloat = self.xclbin_opts["GEMX_dataType"] == "float"
+      if isFloat:
+        padded_arr = self.format_for_fpga(inp, self.min_k, self.min_n)
+        np.copyto(self.fpga_buf[0],  padded_arr, casting='same_kind', where=True)
+      else:
+        padded_arr = self.format_for_fpga(inp * in_scale, self.min_k, self.min_n)
+        np.copyto(self.fpga_buf[0],  np.int16(np.around(padded_arr)), casting='same_kind', where=True)
+      xfblas.sendMat(self.fpga_buf[0],self.idxKernel,self.idxDevice)
+      for i in self.fpga_buf[1:]:
+        xfblas.allocMat(i,self.idxKernel,self.idxDevice)
+      numLayers = len(self.kmodel.layers)
+      layers = []
+      scale = 1.0 if isFloat else in_scale # quantization scale of the values in fpga_buf[i]
+      for i,l in enumerate(self.kmodel.layers):
+          act = l.get_config()['activation']
+          if isFloat:
+            postScale, postShift = 1, 0
+          else:
+            postScale, postShift = self.post_scale[i][0], self.post_scale[i][1]
+            scale = scale * self.wgt_scale[i] * postScale / (1 << postShift)
+          last = i == numLayers - 1
+          actScaleOut = out_scale if last and not isFloat else scale
+          validN = self.out_dim[1] if last else 0
+          layers.append(xfblas.fcnLayer(self.fpga_buf[i], self._qw[i], self.fpga_buf[i+1], self._qb[i], postScale,
+                                        postShift, act, validN=validN, actScaleIn=scale, actScaleOut=actScaleOut))
+      dataType = "float" if isFloat else "short"
+      if not xfblas.fcnChain(layers, dataType, self.idxKernel, self.idxDevice):
+        raise Exception('Failed to run the fcn chain.')
+      for i in self.fpga_buf:
+        xfblas.freeMat(i,self.idxKernel,self.idxDevice)
+      for i in self._qb:
+        xfblas.freeMat(i,self.idxKernel,self.idxDevice)
+      self.offset_list=self.offset_list[:len(self._qw)+1] # only keep the offset for weights
+      result = self.fpga_buf[-1][:self.out_dim[0],:self.out_dim[1]]
+      if not isFloat and act in ('sigmoid', 'tanh', 'gelu', 'softmax'):
+        result = result / np.float32(out_scale)
+      return result
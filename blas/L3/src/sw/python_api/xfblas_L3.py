@@ -18,6 +18,16 @@ import sys
 import argparse
 import os
 
+class XFBLASFcnLayer(Structure):
+  _fields_ = [('A',c_void_p),('B',c_void_p),('C',c_void_p),('X',c_void_p),
+              ('m',c_int),('n',c_int),('k',c_int),('lda',c_int),('ldb',c_int),('ldc',c_int),('ldx',c_int),
+              ('postScale',c_int),('postShift',c_int),
+              ('preluScale',c_short),('preluAlpha',c_short),
+              ('activation',c_int),('validN',c_int),
+              ('actScaleIn',c_float),('actScaleOut',c_float)]
+
+_fcnActivations = {'linear':0,'relu':1,'prelu':2,'sigmoid':3,'tanh':4,'gelu':5,'softmax':6}
+
 class XFBLASManager:
   def __init__(self,libFile):
     self._lib = cdll.LoadLibrary(libFile)
@@ -27,6 +37,8 @@ class XFBLASManager:
     self._lib.xfblasSend.restype = c_bool
     self._lib.xfblasGet.argtypes = [np.ctypeslib.ndpointer(flags="C_CONTIGUOUS"),c_uint,c_uint]
     self._lib.xfblasGet.restype = c_bool
+    self._lib.xfblasAlloc.argtypes = [np.ctypeslib.ndpointer(flags="C_CONTIGUOUS"),c_ulonglong,c_uint,c_uint,c_uint]
+    self._lib.xfblasAlloc.restype = c_bool
     self._lib.xfblasFreeInstr.argtypes = [c_uint,c_uint]
     self._lib.xfblasDestroy.argtypes = [c_uint,c_uint]
     self._lib.xfblasFree.argtypes = [np.ctypeslib.ndpointer(flags="C_CONTIGUOUS"),c_uint,c_uint]
@@ -62,6 +74,8 @@ class XFBLASManager:
     self._lib.xfblasGemm.restype = c_bool
     self._lib.xfblasGetByAddress.argtypes = [np.ctypeslib.ndpointer(flags="C_CONTIGUOUS"),c_ulonglong,c_uint,c_uint,c_uint]
     self._lib.xfblasGetByAddress.restype = c_bool
+    self._lib.xfblasFcnChain.argtypes = [POINTER(XFBLASFcnLayer),c_uint,c_char_p,c_uint,c_uint]
+    self._lib.xfblasFcnChain.restype = c_bool
     self._lib.xfblasExecuteAsync.argtypes = [c_uint,c_uint]
     self._lib.xfblasExecute.argtypes = [c_uint,c_uint]
     
@@ -147,6 +161,21 @@ class XFBLASManager:
     '''
     return self._lib.xfblasGet(A,idxKernel,idxDevice)
   
+  def allocMat(self,A,idxKernel,idxDevice):
+    '''
+    allocate device memory for mat A without sending it, for results that are only written by the device
+    
+    Parameters
+    
+    A:          ndarray
+                matrix in host memory
+    idxKernel:  int
+                index of kernel to be used
+    idxDeivce:  int
+                index of local device to be used
+    '''
+    return self._lib.xfblasAlloc(A,c_ulonglong(A.size),c_uint(A.itemsize),idxKernel,idxDevice)
+  
   def freeInstr(self,idxKernel,idxDevice):
     '''
     free memory for instructions
@@ -308,6 +337,27 @@ class XFBLASManager:
     '''
     return self._lib.xfblasGetByAddress(A,c_ulonglong(A.size*A.itemsize),offset,idxKernel,idxDevice)
   
+  def fcnChain(self,layers,dataType,idxKernel,idxDevice):
+    '''
+    run a chain of fcn layers, each one reading the C of the previous one as its A on device.
+    linear, relu and prelu run in the kernel; sigmoid, tanh, gelu and softmax run on host and are the only layers whose
+    C is read back before the last one. All matrices have to be on device, see sendMat and allocMat, and the C of the
+    last layer is in host memory after the call
+    
+    Parameters
+    
+    layers:         list
+                    layers built with fcnLayer
+    dataType:       str
+                    float, short or int, the element type of all matrices
+    idxKernel:      int
+                    index of kernel to be used
+    idxDeivce:      int
+                    index of local device to be used
+    '''
+    l_layers = (XFBLASFcnLayer * len(layers))(*layers)
+    return self._lib.xfblasFcnChain(l_layers,len(layers),dataType.encode('utf-8'),idxKernel,idxDevice)
+  
   def executeAsync(self,numKernel,idxDevice):
     '''
     run number of kernels async
@@ -381,6 +431,34 @@ def fcnOp(A,B,C,X,postScale=1,postShift=0,preluScale=1,preluAlpha=0,idxKernel=0,
 def fcnOpByAddress(a,b,c,x,A,B,C,X,postScale=1,postShift=0,preluScale=1,preluAlpha=0,idxKernel=0,idxDevice=0):
     return _xfblasManager.fcnOpByAddress(a,b,c,x,A,B,C,X,postScale,postShift,preluScale,preluAlpha,idxKernel,idxDevice)
   
+def allocMat(A,idxKernel=0,idxDevice=0):
+    return _xfblasManager.allocMat(A,idxKernel,idxDevice)
+  
+def fcnLayer(A,B,C,X,postScale=1,postShift=0,activation='linear',preluScale=1,preluAlpha=0,validN=0,actScaleIn=1.0,actScaleOut=1.0):
+    '''
+    describe one layer of fcnChain, C = activation(((A * B + X) * postScale) >> postShift)
+    
+    Parameters
+    
+    activation:     str
+                    linear, relu, prelu, sigmoid, tanh, gelu or softmax, softmax is taken along the rows
+    validN:         int
+                    number of cols of C holding data, softmax is taken over them only, 0 for all cols
+    actScaleIn:     float
+                    C is divided by it before a host activation, the quantization scale of integer types
+    actScaleOut:    float
+                    the host activation result is multiplied by it before stored to C
+    '''
+    if activation not in _fcnActivations:
+      raise Exception('Unsupported activation %s.' % activation)
+    return XFBLASFcnLayer(A.ctypes.data,B.ctypes.data,C.ctypes.data,X.ctypes.data,
+                          A.shape[0],B.shape[1],A.shape[1],A.shape[1],B.shape[1],C.shape[1],X.shape[1],
+                          postScale,postShift,preluScale,preluAlpha,
+                          _fcnActivations[activation],validN,actScaleIn,actScaleOut)
+  
+def fcnChain(layers,dataType,idxKernel=0,idxDevice=0):
+    return _xfblasManager.fcnChain(layers,dataType,idxKernel,idxDevice)
+  
 def getMatByAddress(A,offset,idxKernel=0,idxDevice=0):
     return _xfblasManager.getMatByAddress(A,offset,idxKernel,idxDevice)
   
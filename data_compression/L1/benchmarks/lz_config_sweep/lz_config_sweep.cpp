@@ -0,0 +1,324 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * C-simulation sweep of lzCompress MATCH_LEVEL and LZ_DICT_SIZE over a file
+ * corpus. Each configuration runs the zlib compress chain
+ * lzCompress -> lzBestMatchFilter -> lzBooster -> lz77Divide -> treegen ->
+ * huffmanEncoder block by block, checks the LZ77 tokens of every block
+ * rebuild the input and reports ratio, modeled bytes/cycle and wall time.
+ */
+
+#include "hls_stream.h"
+#include <ap_int.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cmdlineparser.h"
+
+#include "zlib_specs.hpp"
+#include "lz_optional.hpp"
+#include "lz_compress.hpp"
+#include "huffman_treegen.hpp"
+#include "huffman_encoder.hpp"
+
+#define LTREE_SIZE 286
+#define DTREE_SIZE 30
+
+#define LZ_MAX_OFFSET_LIMIT 32768
+#define OFFSET_WINDOW (32 * 1024)
+#define MAX_MATCH_LEN 255
+#define MATCH_LEN 6
+#define MIN_MATCH 3
+#define MIN_OFFSET 1
+#define MIN_BLOCK_SIZE 128
+#define BLOCK_SIZE_IN_KB 1024
+
+// zlib header and sync flush marker accounted per block
+const uint32_t c_blockFraming = 8;
+
+struct sweepResult {
+    uint64_t input_size;
+    uint64_t output_size;
+    uint64_t cycles;
+    double wall_ms;
+    bool pass;
+};
+
+template <int MATCH_LEVEL, int LZ_DICT_SIZE>
+void lz77Compress(hls::stream<ap_uint<8> >& inStream, hls::stream<ap_uint<32> >& boosterStream, uint32_t input_size) {
+    hls::stream<ap_uint<32> > compressdStream("compressdStream");
+    hls::stream<ap_uint<32> > bestMatchStream("bestMatchStream");
+
+#pragma HLS STREAM variable = compressdStream depth = 16
+#pragma HLS STREAM variable = bestMatchStream depth = 16
+
+#pragma HLS dataflow
+    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT, MATCH_LEVEL, MIN_OFFSET, LZ_DICT_SIZE>(
+        inStream, compressdStream, input_size);
+    xf::compression::lzBestMatchFilter<MATCH_LEN, OFFSET_WINDOW>(compressdStream, bestMatchStream, input_size);
+    xf::compression::lzBooster<MAX_MATCH_LEN>(bestMatchStream, boosterStream, input_size);
+}
+
+// Top function, default configuration
+void lz77CompressTop(hls::stream<ap_uint<8> >& inStream, hls::stream<ap_uint<32> >& boosterStream, uint32_t input_size) {
+    lz77Compress<6, 1 << 12>(inStream, boosterStream, input_size);
+}
+
+void zlibHuffmanEncoder(hls::stream<ap_uint<32> >& inStream,
+                        hls::stream<ap_uint<16> >& huffOut,
+                        hls::stream<uint16_t>& huffOutSize,
+                        const uint32_t input_size,
+                        hls::stream<uint16_t>& StreamCode,
+                        hls::stream<uint8_t>& StreamSize) {
+    hls::stream<uint16_t> bitVals("bitVals");
+    hls::stream<uint8_t> bitLen("bitLen");
+#pragma HLS STREAM variable = bitVals depth = 32
+#pragma HLS STREAM variable = bitLen depth = 32
+
+#pragma HLS dataflow
+    xf::compression::huffmanEncoder(inStream, bitVals, bitLen, input_size, StreamCode, StreamSize);
+    xf::compression::details::bitPackingSize(bitVals, bitLen, huffOut, huffOutSize);
+}
+
+/**
+ * Rebuild block from LZ77 tokens (byte, match length, offset - 1) and
+ * compare with input
+ */
+bool verifyTokens(const uint8_t* in, uint32_t input_size, const std::vector<ap_uint<32> >& tokens) {
+    std::vector<uint8_t> out(input_size);
+    uint32_t pos = 0;
+    for (auto& token : tokens) {
+        if (pos >= input_size) break;
+        uint8_t tCh = token.range(7, 0);
+        uint8_t tLen = token.range(15, 8);
+        uint32_t tOffset = (uint32_t)token.range(31, 16) + 1;
+        if (tLen == 0) {
+            out[pos++] = tCh;
+            continue;
+        }
+        if (tOffset > pos || pos + tLen > input_size) return false;
+        for (uint8_t k = 0; k < tLen; k++, pos++) out[pos] = out[pos - tOffset];
+    }
+    return (pos == input_size) && std::equal(out.begin(), out.end(), in);
+}
+
+/**
+ * Compress one block, returns compressed bytes. lzTokens is the number of
+ * LZ77 symbols handed to the Huffman encoder.
+ */
+template <int MATCH_LEVEL, int LZ_DICT_SIZE>
+uint32_t compressBlock(const uint8_t* in, uint32_t input_size, uint32_t& lzTokens, bool& pass) {
+    hls::stream<ap_uint<8> > inStream("inStream");
+    hls::stream<ap_uint<32> > boosterStream("boosterStream");
+    hls::stream<ap_uint<32> > divideInStream("divideInStream");
+    hls::stream<ap_uint<32> > lz77OutStream("lz77OutStream");
+    hls::stream<bool> lz77OutStreamEos("lz77OutStreamEos");
+    hls::stream<uint32_t> lz77OutStreamTree("lz77OutStreamTree");
+    hls::stream<uint32_t> lz77CompressedSize("lz77CompressedSize");
+    hls::stream<uint16_t> StreamCode("maxCodeStream");
+    hls::stream<uint8_t> StreamSize("maxCodeSize");
+    hls::stream<ap_uint<32> > encodedStream("encodedStream");
+    hls::stream<ap_uint<16> > huffOut("huffOut");
+    hls::stream<uint16_t> huffOutSize("huffOutSize");
+
+    for (uint32_t i = 0; i < input_size; i++) inStream << in[i];
+    lz77Compress<MATCH_LEVEL, LZ_DICT_SIZE>(inStream, boosterStream, input_size);
+
+    // Keep a copy of the tokens for verification
+    std::vector<ap_uint<32> > tokens;
+    while (!boosterStream.empty()) {
+        ap_uint<32> token = boosterStream.read();
+        tokens.push_back(token);
+        divideInStream << token;
+    }
+    pass = verifyTokens(in, input_size, tokens);
+
+    xf::compression::lz77Divide(divideInStream, lz77OutStream, lz77OutStreamEos, lz77OutStreamTree,
+                                lz77CompressedSize, input_size);
+
+    uint32_t ltree_freq[LTREE_SIZE];
+    uint32_t dtree_freq[DTREE_SIZE];
+    for (uint32_t i = 0; i < LTREE_SIZE; ++i) ltree_freq[i] = lz77OutStreamTree.read();
+    for (uint32_t i = 0; i < DTREE_SIZE; ++i) dtree_freq[i] = lz77OutStreamTree.read();
+    xf::compression::zlibTreegenInMMOutStream(ltree_freq, dtree_freq, StreamCode, StreamSize);
+
+    lzTokens = 0;
+    for (bool eos = lz77OutStreamEos.read(); eos != true; eos = lz77OutStreamEos.read()) {
+        encodedStream << lz77OutStream.read();
+        lzTokens++;
+    }
+    lz77OutStream.read();
+    uint32_t lz77CmpSize = lz77CompressedSize.read();
+
+    zlibHuffmanEncoder(encodedStream, huffOut, huffOutSize, lz77CmpSize, StreamCode, StreamSize);
+    uint32_t outsize = 0;
+    for (auto size = huffOutSize.read(); size != 0; size = huffOutSize.read()) outsize += size;
+    return outsize;
+}
+
+/**
+ * Modeled kernel cycles for one block. lzCompress, lzBestMatchFilter,
+ * lzBooster and lz77Divide form a II=1 dataflow over input bytes after the
+ * dictionary reset (2 entries per cycle). Huffman encoding takes one LZ77
+ * symbol per cycle and overlaps LZ77 of the next block.
+ */
+template <int LZ_DICT_SIZE>
+uint64_t modelCycles(uint32_t input_size, uint32_t lzTokens) {
+    uint64_t lzCycles = LZ_DICT_SIZE / 2 + input_size;
+    uint64_t huffCycles = lzTokens;
+    return (lzCycles > huffCycles) ? lzCycles : huffCycles;
+}
+
+template <int MATCH_LEVEL, int LZ_DICT_SIZE>
+sweepResult runFile(const std::vector<uint8_t>& data, uint32_t block_size) {
+    sweepResult res = {data.size(), 0, 0, 0, true};
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t offset = 0; offset < data.size(); offset += block_size) {
+        uint32_t size = std::min<uint64_t>(block_size, data.size() - offset);
+        const uint8_t* in = data.data() + offset;
+        if (size < MIN_BLOCK_SIZE) {
+            // Stored block, as done by the kernels
+            res.output_size += size + 5;
+            res.cycles += size;
+            continue;
+        }
+        uint32_t lzTokens = 0;
+        bool blockPass = true;
+        uint32_t cmpSize = compressBlock<MATCH_LEVEL, LZ_DICT_SIZE>(in, size, lzTokens, blockPass);
+        res.output_size += cmpSize + c_blockFraming;
+        res.cycles += modelCycles<LZ_DICT_SIZE>(size, lzTokens);
+        res.pass = res.pass && blockPass;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    res.wall_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    return res;
+}
+
+typedef sweepResult (*sweepFunc)(const std::vector<uint8_t>&, uint32_t);
+
+struct sweepConfig {
+    int match_level;
+    int dict_size;
+    sweepFunc run;
+};
+
+#define SWEEP_CONFIG(ML, DS) \
+    { ML, DS, runFile<ML, DS> }
+
+// Configurations swept, add entries here to try other builds
+static const sweepConfig c_configs[] = {
+    SWEEP_CONFIG(1, 1 << 10), SWEEP_CONFIG(1, 1 << 12), SWEEP_CONFIG(1, 1 << 14), SWEEP_CONFIG(2, 1 << 10),
+    SWEEP_CONFIG(2, 1 << 12), SWEEP_CONFIG(2, 1 << 14), SWEEP_CONFIG(4, 1 << 10), SWEEP_CONFIG(4, 1 << 12),
+    SWEEP_CONFIG(4, 1 << 14), SWEEP_CONFIG(6, 1 << 10), SWEEP_CONFIG(6, 1 << 12), SWEEP_CONFIG(6, 1 << 14),
+};
+
+void printRow(std::ostream& os,
+              const std::string& file,
+              const sweepConfig& cfg,
+              const sweepResult& res,
+              char sep,
+              int width = 0) {
+    double ratio = res.output_size ? (double)res.input_size / res.output_size : 0;
+    double bpc = res.cycles ? (double)res.input_size / res.cycles : 0;
+    os << std::setw(width) << file << sep << std::setw(width) << cfg.match_level << sep << std::setw(width)
+       << cfg.dict_size << sep << std::setw(width) << res.input_size << sep << std::setw(width) << res.output_size
+       << sep << std::setw(width) << std::fixed << std::setprecision(3) << ratio << sep << std::setw(width) << bpc
+       << sep << std::setw(width) << res.wall_ms << sep << std::setw(width) << (res.pass ? "PASS" : "FAIL")
+       << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    sda::utils::CmdLineParser parser;
+    parser.addSwitch("--file_list", "-l", "List of files", "");
+    parser.addSwitch("--original_file", "-o", "Original file path", "");
+    parser.addSwitch("--current_path", "-p", "Current data path", "");
+    parser.addSwitch("--results", "-r", "Results CSV file", "lz_config_sweep.csv");
+    parser.addSwitch("--block_size", "-B", "Block size in KB", std::to_string(BLOCK_SIZE_IN_KB));
+    parser.parse(argc, argv);
+
+    std::string listFileName = parser.value("file_list");
+    std::string singleInputFileName = parser.value("original_file");
+    std::string currentPath = parser.value("current_path");
+    std::string resultsFileName = parser.value("results");
+    uint32_t block_size = std::stoi(parser.value("block_size")) * 1024;
+
+    std::vector<std::string> files;
+    if (!listFileName.empty()) {
+        std::ifstream infilelist(listFileName.c_str());
+        std::string curFileName;
+        while (std::getline(infilelist, curFileName)) {
+            if (curFileName.empty() || curFileName[0] == '#') continue;
+            files.push_back(currentPath.empty() ? curFileName : currentPath + "/" + curFileName);
+        }
+    } else {
+        files.push_back(singleInputFileName);
+    }
+
+    if (files.empty() || files[0].empty()) {
+        std::cout << "No input files, use -l <file list> or -o <file>" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t> > corpus;
+    for (auto& name : files) {
+        std::ifstream inFile(name.c_str(), std::ifstream::binary);
+        if (!inFile.is_open()) {
+            std::cout << "Cannot open the input file!! " << name << std::endl;
+            return 1;
+        }
+        corpus.emplace_back((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+    }
+
+    std::ofstream results(resultsFileName.c_str());
+    results << "file,match_level,dict_size,input_bytes,output_bytes,ratio,bytes_per_cycle,wall_ms,status" << std::endl;
+
+    const int c_width = 12;
+    const char* header[] = {"file",   "match_level", "dict_size", "input",  "output",
+                            "ratio", "bytes/cycle", "wall_ms",   "status"};
+    for (auto h : header) std::cout << std::setw(c_width) << h << ' ';
+    std::cout << std::endl;
+
+    bool pass = true;
+    for (auto& cfg : c_configs) {
+        sweepResult total = {0, 0, 0, 0, true};
+        for (size_t f = 0; f < files.size(); f++) {
+            sweepResult res = cfg.run(corpus[f], block_size);
+            std::string base = files[f].substr(files[f].find_last_of('/') + 1);
+            printRow(std::cout, base, cfg, res, ' ', c_width);
+            printRow(results, base, cfg, res, ',');
+            total.input_size += res.input_size;
+            total.output_size += res.output_size;
+            total.cycles += res.cycles;
+            total.wall_ms += res.wall_ms;
+            total.pass = total.pass && res.pass;
+        }
+        printRow(std::cout, "TOTAL", cfg, total, ' ', c_width);
+        printRow(results, "TOTAL", cfg, total, ',');
+        pass = pass && total.pass;
+    }
+    std::cout << "Results written to " << resultsFileName << std::endl;
+    std::cout << (pass ? "\nTEST PASSED\n" : "TEST FAILED\n") << std::endl;
+    return pass ? 0 : 1;
+}
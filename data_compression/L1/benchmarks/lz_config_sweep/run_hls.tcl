@@ -0,0 +1,63 @@
+#
+# Copyright 2019 Xilinx, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+source settings.tcl
+set DIR_NAME "lz_config_sweep"
+set DESIGN_PATH "${XF_PROJ_ROOT}/L1/benchmarks/${DIR_NAME}"
+set PROJ "lz_config_sweep.prj"
+set SOLN "sol1"
+
+if {![info exists CLKP]} {
+  set CLKP 3.3
+}
+
+# Corpus list and data directory, e.g. silesia.list and the Silesia directory
+if {![info exists CORPUS_LIST]} {
+  set CORPUS_LIST "${DESIGN_PATH}/corpus.list"
+}
+if {![info exists CORPUS_PATH]} {
+  set CORPUS_PATH "${XF_PROJ_ROOT}/common/data"
+}
+
+open_project -reset $PROJ
+add_files $XF_PROJ_ROOT/common/libs/logger/logger.cpp -cflags "-I${XF_PROJ_ROOT}/common/libs/logger"
+add_files $XF_PROJ_ROOT/common/libs/cmdparser/cmdlineparser.cpp -cflags "-I${XF_PROJ_ROOT}/common/libs/cmdparser -I${XF_PROJ_ROOT}/common/libs/logger"
+add_files lz_config_sweep.cpp -cflags "-I${XF_PROJ_ROOT}/L1/include/hw -I${XF_PROJ_ROOT}/common/libs/cmdparser -I${XF_PROJ_ROOT}/common/libs/logger"
+
+add_files -tb $XF_PROJ_ROOT/common/libs/logger/logger.cpp -cflags "-I${XF_PROJ_ROOT}/common/libs/logger"
+add_files -tb $XF_PROJ_ROOT/common/libs/cmdparser/cmdlineparser.cpp -cflags "-I${XF_PROJ_ROOT}/common/libs/cmdparser -I${XF_PROJ_ROOT}/common/libs/logger"
+add_files -tb lz_config_sweep.cpp -cflags "-I${XF_PROJ_ROOT}/L1/include/hw -I${XF_PROJ_ROOT}/common/libs/cmdparser -I${XF_PROJ_ROOT}/common/libs/logger"
+
+set_top lz77CompressTop
+
+open_solution -reset $SOLN
+
+
+
+set_part $XPART
+create_clock -period $CLKP
+
+config_compile -pragma_strict_mode
+
+if {$CSIM == 1} {
+  csim_design -argv "-l ${CORPUS_LIST} -p ${CORPUS_PATH} -r ${DESIGN_PATH}/lz_config_sweep.csv"
+}
+
+if {$CSYNTH == 1} {
+  csynth_design
+}
+
+exit
@@ -0,0 +1,372 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_FSE_ENCODER_HPP_
+#define _XFCOMPRESSION_FSE_ENCODER_HPP_
+
+/**
+ * @file fse_encoder.hpp
+ * @brief Header for Finite State Entropy (tANS) encoder modules.
+ *
+ * Tables and bitstream follow the FSE layout of the Zstandard format: a
+ * stream is written forward with the symbols in reverse order and a final
+ * end mark bit, so the decoder reads it backwards from the last byte.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include <ap_int.h>
+#include <stdint.h>
+
+#include "zstd_specs.hpp"
+
+namespace xf {
+namespace compression {
+
+/**
+ * Little endian bit writer, bits are appended from LSB side
+ */
+struct fseBitWriter {
+    uint64_t acc;
+    uint8_t bits;
+    uint32_t idx;
+};
+
+/**
+ * Symbol transform of a FSE compression table
+ */
+struct fseSymbolTransform {
+    int32_t deltaFindState;
+    uint32_t deltaNbBits;
+};
+
+/**
+ * @brief FSE compression table
+ *
+ * @tparam MAX_SYMBOLS alphabet size
+ * @tparam MAX_TABLE_LOG maximum accuracy log
+ */
+template <int MAX_SYMBOLS, int MAX_TABLE_LOG>
+struct fseCTable {
+    uint16_t stateTable[1 << MAX_TABLE_LOG];
+    fseSymbolTransform symbolTT[MAX_SYMBOLS];
+    uint8_t tableLog;
+};
+
+inline uint8_t fseHighBit(uint32_t val) {
+    uint8_t bit = 0;
+fse_high_bit:
+    for (uint8_t i = 1; i < 32; i++) {
+#pragma HLS UNROLL
+        if ((val >> i) & 1) bit = i;
+    }
+    return bit;
+}
+
+inline void fseBitWriterInit(fseBitWriter& bw, uint32_t idx) {
+    bw.acc = 0;
+    bw.bits = 0;
+    bw.idx = idx;
+}
+
+/**
+ * @brief Append nbBits lower bits of value, at most 32 bits at a time
+ */
+inline void fseAddBits(fseBitWriter& bw, uint8_t* out, uint32_t value, uint8_t nbBits) {
+    uint64_t mask = (((uint64_t)1) << nbBits) - 1;
+    bw.acc |= (value & mask) << bw.bits;
+    bw.bits += nbBits;
+fse_flush_bytes:
+    while (bw.bits >= 8) {
+#pragma HLS LOOP_TRIPCOUNT min = 0 max = 4
+        out[bw.idx++] = bw.acc;
+        bw.acc >>= 8;
+        bw.bits -= 8;
+    }
+}
+
+/**
+ * @brief Flush pending bits padded with zeros
+ *
+ * @return index past the last written byte
+ */
+inline uint32_t fseFlushBits(fseBitWriter& bw, uint8_t* out) {
+    if (bw.bits) out[bw.idx++] = bw.acc;
+    bw.acc = 0;
+    bw.bits = 0;
+    return bw.idx;
+}
+
+/**
+ * @brief Terminate a backward read stream with the end mark bit
+ *
+ * @return index past the last written byte
+ */
+inline uint32_t fseCloseStream(fseBitWriter& bw, uint8_t* out) {
+    fseAddBits(bw, out, 1, 1);
+    return fseFlushBits(bw, out);
+}
+
+/**
+ * @brief Pick accuracy log for a distribution
+ *
+ * @param maxTableLog maximum accuracy log allowed for the alphabet
+ * @param total number of symbols to be encoded
+ * @param maxSymbol largest symbol value present
+ * @param minus reduction of accuracy against total, 2 for sequences
+ */
+inline uint8_t fseOptimalTableLog(uint8_t maxTableLog, uint32_t total, uint8_t maxSymbol, uint8_t minus = 2) {
+    int tableLog = maxTableLog;
+    int maxBitsSrc = (int)fseHighBit(total - 1) - minus;
+    int minBitsSrc = fseHighBit(total) + 1;
+    int minBitsSymbols = fseHighBit(maxSymbol) + 2;
+    int minBits = (minBitsSrc < minBitsSymbols) ? minBitsSrc : minBitsSymbols;
+
+    if (maxBitsSrc < tableLog) tableLog = maxBitsSrc;
+    if (minBits > tableLog) tableLog = minBits;
+    if (tableLog < c_fseMinTableLog) tableLog = c_fseMinTableLog;
+    if (tableLog > maxTableLog) tableLog = maxTableLog;
+    return tableLog;
+}
+
+/**
+ * @brief Scale symbol frequencies to a table of 1 << tableLog states,
+ * every present symbol keeps at least one state
+ *
+ * @tparam MAX_SYMBOLS alphabet size
+ *
+ * @param freq symbol frequencies
+ * @param total sum of frequencies
+ * @param maxSymbol largest symbol value present
+ * @param tableLog accuracy log
+ * @param norm normalized frequencies
+ */
+template <int MAX_SYMBOLS>
+void fseNormalizeCounts(const uint32_t freq[MAX_SYMBOLS],
+                        uint32_t total,
+                        uint8_t maxSymbol,
+                        uint8_t tableLog,
+                        int16_t norm[MAX_SYMBOLS]) {
+    const int32_t tableSize = 1 << tableLog;
+    int32_t remaining = tableSize;
+    uint8_t largest = 0;
+
+fse_normalize:
+    for (uint16_t s = 0; s < MAX_SYMBOLS; s++) {
+#pragma HLS PIPELINE II = 1
+        int32_t count = 0;
+        if (s <= maxSymbol && freq[s]) {
+            count = ((uint64_t)freq[s] * tableSize + (total >> 1)) / total;
+            if (count == 0) count = 1;
+            if (freq[s] > freq[largest]) largest = s;
+        }
+        norm[s] = count;
+        remaining -= count;
+    }
+
+    // Rounding error is absorbed by the most probable symbol when possible
+    if (norm[largest] + remaining >= (norm[largest] + 1) / 2) {
+        norm[largest] += remaining;
+        remaining = 0;
+    }
+
+// Otherwise take states away from the largest counts one by one
+fse_normalize_fix:
+    while (remaining < 0) {
+#pragma HLS LOOP_TRIPCOUNT min = 0 max = MAX_SYMBOLS
+        uint8_t maxIdx = 0;
+        for (uint16_t s = 1; s <= maxSymbol; s++) {
+            if (norm[s] > norm[maxIdx]) maxIdx = s;
+        }
+        norm[maxIdx]--;
+        remaining++;
+    }
+    if (remaining > 0) norm[largest] += remaining;
+}
+
+/**
+ * @brief Write normalized distribution in FSE table description format
+ *
+ * @tparam MAX_SYMBOLS alphabet size
+ *
+ * @param norm normalized frequencies
+ * @param maxSymbol largest symbol value present
+ * @param tableLog accuracy log
+ * @param out output buffer
+ * @param idx write position in output buffer
+ *
+ * @return index past the last written byte
+ */
+template <int MAX_SYMBOLS>
+uint32_t fseWriteNCount(const int16_t norm[MAX_SYMBOLS], uint8_t maxSymbol, uint8_t tableLog, uint8_t* out, uint32_t idx) {
+    fseBitWriter bw;
+    fseBitWriterInit(bw, idx);
+
+    int32_t tableSize = 1 << tableLog;
+    int32_t remaining = tableSize + 1;
+    int32_t threshold = tableSize;
+    uint8_t nbBits = tableLog + 1;
+    bool previousIs0 = false;
+
+    fseAddBits(bw, out, tableLog - c_fseMinTableLog, 4);
+
+fse_ncount:
+    for (uint16_t symbol = 0; (symbol <= maxSymbol) && (remaining > 1);) {
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = MAX_SYMBOLS
+        if (previousIs0) {
+            // Run of zero probability symbols as 2 bit repeat flags
+            uint16_t start = symbol;
+            while ((symbol <= maxSymbol) && !norm[symbol]) symbol++;
+            while (symbol >= start + 3) {
+                start += 3;
+                fseAddBits(bw, out, 3, 2);
+            }
+            fseAddBits(bw, out, symbol - start, 2);
+        }
+
+        int32_t count = norm[symbol++];
+        int32_t max = (2 * threshold - 1) - remaining;
+        remaining -= (count < 0) ? -count : count;
+        count++;
+        if (count >= threshold) count += max;
+        fseAddBits(bw, out, count, nbBits - (count < max));
+        previousIs0 = (count == 1);
+        while (remaining < threshold) {
+            nbBits--;
+            threshold >>= 1;
+        }
+    }
+    return fseFlushBits(bw, out);
+}
+
+/**
+ * @brief Build FSE compression table from normalized frequencies
+ *
+ * @tparam MAX_SYMBOLS alphabet size
+ * @tparam MAX_TABLE_LOG maximum accuracy log
+ *
+ * @param norm normalized frequencies
+ * @param maxSymbol largest symbol value present
+ * @param tableLog accuracy log
+ * @param ctable compression table
+ */
+template <int MAX_SYMBOLS, int MAX_TABLE_LOG>
+void fseBuildCTable(const int16_t norm[MAX_SYMBOLS],
+                    uint8_t maxSymbol,
+                    uint8_t tableLog,
+                    fseCTable<MAX_SYMBOLS, MAX_TABLE_LOG>& ctable) {
+    const uint32_t tableSize = 1 << tableLog;
+    const uint32_t tableMask = tableSize - 1;
+    const uint32_t step = (tableSize >> 1) + (tableSize >> 3) + 3;
+    uint32_t highThreshold = tableSize - 1;
+
+    uint8_t tableSymbol[1 << MAX_TABLE_LOG];
+    uint32_t cumul[MAX_SYMBOLS + 1];
+
+    ctable.tableLog = tableLog;
+
+    // Symbol start positions, low probability symbols go to the top
+    cumul[0] = 0;
+fse_cumul:
+    for (uint16_t u = 1; u <= maxSymbol + 1; u++) {
+#pragma HLS PIPELINE II = 1
+        if (norm[u - 1] == -1) {
+            cumul[u] = cumul[u - 1] + 1;
+            tableSymbol[highThreshold--] = u - 1;
+        } else {
+            cumul[u] = cumul[u - 1] + norm[u - 1];
+        }
+    }
+
+    // Spread symbols over the table
+    uint32_t position = 0;
+fse_spread:
+    for (uint16_t symbol = 0; symbol <= maxSymbol; symbol++) {
+        for (int16_t n = 0; n < norm[symbol]; n++) {
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = 512
+            tableSymbol[position] = symbol;
+            position = (position + step) & tableMask;
+            while (position > highThreshold) position = (position + step) & tableMask;
+        }
+    }
+
+    // Next state of every (symbol, occurrence)
+fse_state_table:
+    for (uint32_t u = 0; u < tableSize; u++) {
+#pragma HLS PIPELINE II = 1
+        uint8_t s = tableSymbol[u];
+        ctable.stateTable[cumul[s]++] = tableSize + u;
+    }
+
+    int32_t total = 0;
+fse_symbol_tt:
+    for (uint16_t s = 0; s <= maxSymbol; s++) {
+#pragma HLS PIPELINE II = 1
+        int16_t count = norm[s];
+        if (count == 0) {
+            ctable.symbolTT[s].deltaNbBits = ((tableLog + 1) << 16) - tableSize;
+            ctable.symbolTT[s].deltaFindState = 0;
+        } else if (count == -1 || count == 1) {
+            ctable.symbolTT[s].deltaNbBits = (tableLog << 16) - tableSize;
+            ctable.symbolTT[s].deltaFindState = total - 1;
+            total++;
+        } else {
+            uint32_t maxBitsOut = tableLog - fseHighBit(count - 1);
+            uint32_t minStatePlus = (uint32_t)count << maxBitsOut;
+            ctable.symbolTT[s].deltaNbBits = (maxBitsOut << 16) - minStatePlus;
+            ctable.symbolTT[s].deltaFindState = total - count;
+            total += count;
+        }
+    }
+}
+
+/**
+ * @brief Initialize encoder state with the last symbol of the stream,
+ * no bits are written for it
+ */
+template <int MAX_SYMBOLS, int MAX_TABLE_LOG>
+inline void fseInitState(uint32_t& state, const fseCTable<MAX_SYMBOLS, MAX_TABLE_LOG>& ctable, uint8_t symbol) {
+    fseSymbolTransform tt = ctable.symbolTT[symbol];
+    uint32_t nbBitsOut = (tt.deltaNbBits + (1 << 15)) >> 16;
+    uint32_t value = (nbBitsOut << 16) - tt.deltaNbBits;
+    state = ctable.stateTable[(value >> nbBitsOut) + tt.deltaFindState];
+}
+
+/**
+ * @brief Encode one symbol, low bits of the state are written out
+ */
+template <int MAX_SYMBOLS, int MAX_TABLE_LOG>
+inline void fseEncodeSymbol(fseBitWriter& bw,
+                            uint8_t* out,
+                            uint32_t& state,
+                            const fseCTable<MAX_SYMBOLS, MAX_TABLE_LOG>& ctable,
+                            uint8_t symbol) {
+    fseSymbolTransform tt = ctable.symbolTT[symbol];
+    uint32_t nbBitsOut = (state + tt.deltaNbBits) >> 16;
+    fseAddBits(bw, out, state, nbBitsOut);
+    state = ctable.stateTable[(state >> nbBitsOut) + tt.deltaFindState];
+}
+
+/**
+ * @brief Write final state, read first by the decoder
+ */
+inline void fseFlushState(fseBitWriter& bw, uint8_t* out, uint32_t state, uint8_t tableLog) {
+    fseAddBits(bw, out, state, tableLog);
+}
+
+} // namespace compression
+} // namespace xf
+#endif // _XFCOMPRESSION_FSE_ENCODER_HPP_
@@ -35,6 +35,21 @@ namespace compression {
 
 typedef ap_uint<32> compressd_dt;
 
+namespace details {
+
+// log2 of a power of 2, the number of hash bits addressing a dictionary of N entries
+template <int N>
+struct lzDictBits {
+    enum { value = 1 + lzDictBits<(N >> 1)>::value };
+};
+
+template <>
+struct lzDictBits<1> {
+    enum { value = 0 };
+};
+
+} // namespace details
+
 /**
  * @brief This module reads input literals from stream and updates
  * match length and offset of each literal.
@@ -44,11 +59,14 @@ typedef ap_uint<32> compressd_dt;
  * @tparam LZ_MAX_OFFSET_LIMIT maximum offset limit
  * @tparam MATCH_LEVEL match level
  * @tparam MIN_OFFSET minimum offset
- * @tparam LZ_DICT_SIZE dictionary size
+ * @tparam LZ_DICT_SIZE dictionary size, power of 2 (hash width follows it)
  *
- * @param inStream input stream
- * @param outStream output stream
+ * @param inStream input stream, preset dictionary bytes followed by input
+ * @param outStream output stream, dictionary positions are written as
+ * literals so the following stages can fill their history from them
  * @param input_size input size
+ * @param dict_size preset dictionary size, matches of the input can reach
+ * back into the dictionary
  */
 template <int MATCH_LEN,
           int MIN_MATCH,
@@ -57,12 +75,16 @@ template <int MATCH_LEN,
           int MIN_OFFSET = 1,
           int LZ_DICT_SIZE = 1 << 12,
           int LEFT_BYTES = 64>
-void lzCompress(hls::stream<ap_uint<8> >& inStream, hls::stream<compressd_dt>& outStream, uint32_t input_size) {
+void lzCompress(hls::stream<ap_uint<8> >& inStream,
+                hls::stream<compressd_dt>& outStream,
+                uint32_t input_size,
+                uint32_t dict_size = 0) {
     const int c_dictEleWidth = (MATCH_LEN * 8 + 24);
     typedef ap_uint<MATCH_LEVEL * c_dictEleWidth> uintDictV_t;
     typedef ap_uint<c_dictEleWidth> uintDict_t;
 
     if (input_size == 0) return;
+    uint32_t total_size = dict_size + input_size;
     // Dictionary
     uintDictV_t dict[LZ_DICT_SIZE];
 #pragma HLS RESOURCE variable = dict core = RAM_T2P_URAM
@@ -86,7 +108,7 @@ dict_flush:
         present_window[i] = inStream.read();
     }
 lz_compress:
-    for (uint32_t i = MATCH_LEN - 1; i < input_size - LEFT_BYTES; i++) {
+    for (uint32_t i = MATCH_LEN - 1; i < total_size - LEFT_BYTES; i++) {
 #pragma HLS PIPELINE II = 1
 #pragma HLS dependence variable = dict inter false
         uint32_t currIdx = i - MATCH_LEN + 1;
@@ -98,8 +120,16 @@ lz_compress:
         present_window[MATCH_LEN - 1] = inStream.read();
 
         // Calculate Hash Value
-        uint32_t hash =
-            (present_window[0] << 4) ^ (present_window[1] << 3) ^ (present_window[2] << 3) ^ (present_window[3]);
+        // 4K dictionary uses the shift/xor hash, other (power of 2) sizes
+        // take the high bits of a multiplicative hash of the first 4 bytes
+        uint32_t hash;
+        if (LZ_DICT_SIZE == (1 << 12)) {
+            hash = (present_window[0] << 4) ^ (present_window[1] << 3) ^ (present_window[2] << 3) ^ (present_window[3]);
+        } else {
+            uint32_t word = present_window[0] | (present_window[1] << 8) | (present_window[2] << 16) |
+                            ((uint32_t)present_window[3] << 24);
+            hash = (word * 2654435761U) >> (32 - details::lzDictBits<LZ_DICT_SIZE>::value);
+        }
 
         // Dictionary Lookup
         uintDictV_t dictReadValue = dict[hash];
@@ -115,6 +145,7 @@ lz_compress:
         // Match search and Filtering
         // Comp dict pick
         uint8_t match_length = 0;
+        bool dictPos = (currIdx < dict_size);
         uint32_t match_offset = 0;
         for (int l = 0; l < MATCH_LEVEL; l++) {
             uint8_t len = 0;
@@ -128,8 +159,8 @@ lz_compress:
                     done = 1;
                 }
             }
-            if ((len >= MIN_MATCH) && (currIdx > compareIdx) && ((currIdx - compareIdx) < LZ_MAX_OFFSET_LIMIT) &&
-                ((currIdx - compareIdx - 1) >= MIN_OFFSET)) {
+            if ((len >= MIN_MATCH) && !dictPos && (currIdx > compareIdx) &&
+                ((currIdx - compareIdx) < LZ_MAX_OFFSET_LIMIT) && ((currIdx - compareIdx - 1) >= MIN_OFFSET)) {
                 len = len;
             } else {
                 len = 0;
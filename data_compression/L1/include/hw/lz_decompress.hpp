@@ -44,12 +44,18 @@ typedef ap_uint<32> compressd_dt;
  * @tparam LOW_OFFSET low offset
  * @tparam HISTORY_SIZE history size
  *
- * @param inStream input stream
+ * @param inStream input stream, dict_size literals of the preset dictionary
+ * followed by the input
  * @param outStream output stream
  * @param original_size original size
+ * @param dict_size preset dictionary size, dictionary literals only fill the
+ * history and are not written to output
  */
 template <int HISTORY_SIZE, int LOW_OFFSET = 8>
-void lzDecompress(hls::stream<compressd_dt>& inStream, hls::stream<ap_uint<8> >& outStream, uint32_t original_size) {
+void lzDecompress(hls::stream<compressd_dt>& inStream,
+                  hls::stream<ap_uint<8> >& outStream,
+                  uint32_t original_size,
+                  uint32_t dict_size = 0) {
     enum lzDecompressStates { READ_STATE, MATCH_STATE, LOW_OFFSET_STATE };
 
     uint8_t local_buf[HISTORY_SIZE];
@@ -66,7 +72,7 @@ void lzDecompress(hls::stream<compressd_dt>& inStream, hls::stream<ap_uint<8> >&
     ap_uint<8> prevValue[LOW_OFFSET];
 #pragma HLS ARRAY_PARTITION variable = prevValue dim = 0 complete
 lz_decompress:
-    for (uint32_t i = 0; i < original_size; i++) {
+    for (uint32_t i = 0; i < original_size + dict_size; i++) {
 #pragma HLS PIPELINE II = 1
         if (next_states == READ_STATE) {
             nextValue = inStream.read();
@@ -99,7 +105,7 @@ lz_decompress:
             if (out_len == match_len) next_states = READ_STATE;
         }
         local_buf[i % HISTORY_SIZE] = outValue;
-        outStream << outValue;
+        if (i >= dict_size) outStream << outValue;
         for (uint32_t pIdx = LOW_OFFSET - 1; pIdx > 0; pIdx--) {
 #pragma HLS UNROLL
             prevValue[pIdx] = prevValue[pIdx - 1];
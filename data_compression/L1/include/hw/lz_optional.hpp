@@ -188,10 +188,15 @@ lz_bestMatchFilter_left_over:
  * @param outStream output stream 32bit per write
  * @param input_size input size
  * @param left_bytes last 64 left over bytes
+ * @param dict_size preset dictionary size, the first dict_size literals
+ * only fill the history window and are not written
  *
 */
 template <int MAX_MATCH_LEN, int BOOSTER_OFFSET_WINDOW = 16 * 1024, int LEFT_BYTES = 64>
-void lzBooster(hls::stream<compressd_dt>& inStream, hls::stream<compressd_dt>& outStream, uint32_t input_size) {
+void lzBooster(hls::stream<compressd_dt>& inStream,
+               hls::stream<compressd_dt>& outStream,
+               uint32_t input_size,
+               uint32_t dict_size = 0) {
     if (input_size == 0) return;
     uint8_t local_mem[BOOSTER_OFFSET_WINDOW];
     uint32_t match_loc = 0;
@@ -202,8 +207,10 @@ void lzBooster(hls::stream<compressd_dt>& inStream, hls::stream<compressd_dt>& o
     bool outFlag = false;
     bool boostFlag = false;
     uint16_t skip_len = 0;
+    uint32_t outIdx = 0;
+    uint32_t outStreamIdx = 0;
 lz_booster:
-    for (uint32_t i = 0; i < (input_size - LEFT_BYTES); i++) {
+    for (uint32_t i = 0; i < (dict_size + input_size - LEFT_BYTES); i++) {
 #pragma HLS PIPELINE II = 1
 #pragma HLS dependence variable = local_mem inter false
         compressd_dt inValue = inStream.read();
@@ -230,7 +237,9 @@ lz_booster:
             match_loc = i - tOffset;
             if (i) outFlag = true;
             outStreamValue = outValue;
+            outStreamIdx = outIdx;
             outValue = inValue;
+            outIdx = i;
             if (tLen) {
                 if (boostFlag) {
                     matchFlag = true;
@@ -243,12 +252,13 @@ lz_booster:
                 matchFlag = false;
             }
         }
-        if (outFlag) outStream << outStreamValue;
+        if (outFlag && (outStreamIdx >= dict_size)) outStream << outStreamValue;
     }
-    outStream << outValue;
+    if (outIdx >= dict_size) outStream << outValue;
 lz_booster_left_bytes:
     for (uint32_t i = 0; i < LEFT_BYTES; i++) {
-        outStream << inStream.read();
+        compressd_dt inValue = inStream.read();
+        if (input_size + i >= LEFT_BYTES) outStream << inValue;
     }
 }
 
@@ -287,6 +297,209 @@ lz_filter_left_bytes:
     }
 }
 
+namespace details {
+
+// Approximate Deflate cost in bits: literal, and match as ~7 bit length code
+// plus extra bits with ~5 bit distance code plus extra bits
+const uint32_t c_lzParseLitCost = 8;
+
+inline uint32_t lzParseHighBit(uint32_t val) {
+    uint32_t bit = 0;
+    while (val >>= 1) bit++;
+    return bit;
+}
+
+inline uint32_t lzParseMatchCost(uint32_t len, uint32_t offset) {
+    uint32_t lenExtra = (len > 10) ? lzParseHighBit(len - 3) - 2 : 0;
+    uint32_t offExtra = (offset > 4) ? lzParseHighBit(offset - 1) - 1 : 0;
+    return 12 + lenExtra + offExtra;
+}
+
+/**
+ * @brief Common body of lzLazyFilter and lzOptimalParse. Candidates of
+ * PARSE_WINDOW positions plus MAX_MATCH_LEN look ahead are extended against
+ * the history and the window is parsed either lazily or by the cheapest
+ * path under the bit cost model.
+ */
+template <int MAX_MATCH_LEN, int MIN_MATCH, int PARSE_WINDOW, int HISTORY_SIZE, int MAX_LAZY, bool OPTIMAL>
+void lzParse(hls::stream<compressd_dt>& inStream,
+             hls::stream<compressd_dt>& outStream,
+             uint32_t input_size,
+             uint32_t dict_size) {
+    // History ring holds the offset window plus look ahead, token ring a
+    // parse window plus look ahead (HISTORY_SIZE >= PARSE_WINDOW +
+    // MAX_MATCH_LEN, PARSE_WINDOW >= MAX_MATCH_LEN, both powers of 2)
+    const uint32_t c_histRing = 2 * HISTORY_SIZE;
+    const uint32_t c_tokRing = 2 * PARSE_WINDOW;
+    const uint32_t c_span = PARSE_WINDOW + MAX_MATCH_LEN;
+    if (input_size == 0) return;
+
+    uint8_t history[c_histRing];
+#pragma HLS RESOURCE variable = history core = RAM_2P_BRAM
+    uint8_t candLen[c_tokRing];
+    uint16_t candOffset[c_tokRing];
+    uint16_t extLen[c_span + 1];
+    uint32_t pathCost[c_span + 1];
+    uint16_t pathLen[c_span + 1];
+
+    uint32_t total_size = dict_size + input_size;
+    uint32_t filled = 0;
+lz_parse_dict:
+    for (; filled < dict_size; filled++) {
+#pragma HLS PIPELINE II = 1
+        compressd_dt inValue = inStream.read();
+        history[filled & (c_histRing - 1)] = inValue.range(7, 0);
+    }
+
+    uint32_t base = dict_size;
+lz_parse:
+    while (base < total_size) {
+        uint32_t span = (total_size - base > c_span) ? c_span : total_size - base;
+        uint32_t window = (total_size - base > PARSE_WINDOW) ? PARSE_WINDOW : total_size - base;
+
+    lz_parse_fill:
+        for (; filled < base + span; filled++) {
+#pragma HLS PIPELINE II = 1
+            compressd_dt inValue = inStream.read();
+            history[filled & (c_histRing - 1)] = inValue.range(7, 0);
+            candLen[filled & (c_tokRing - 1)] = inValue.range(15, 8);
+            candOffset[filled & (c_tokRing - 1)] = inValue.range(31, 16);
+        }
+
+    // Extend each candidate up to MAX_MATCH_LEN or the end of look ahead
+    lz_parse_extend:
+        for (uint32_t r = 0; r < span; r++) {
+            uint32_t p = base + r;
+            uint32_t len = candLen[p & (c_tokRing - 1)];
+            uint32_t offset = candOffset[p & (c_tokRing - 1)] + 1;
+            uint32_t maxLen = (span - r > MAX_MATCH_LEN) ? MAX_MATCH_LEN : span - r;
+            if (len > maxLen) len = maxLen;
+            if (len >= MIN_MATCH && offset <= HISTORY_SIZE) {
+            lz_parse_extend_match:
+                while (len < maxLen &&
+                       history[(p + len) & (c_histRing - 1)] == history[(p + len - offset) & (c_histRing - 1)]) {
+#pragma HLS PIPELINE II = 1
+                    len++;
+                }
+            }
+            extLen[r] = (len >= MIN_MATCH) ? len : 0;
+        }
+
+        if (OPTIMAL) {
+            // Cheapest path from every position to the end of look ahead
+            pathCost[span] = 0;
+        lz_parse_cost:
+            for (uint32_t r = span; r-- > 0;) {
+                uint32_t bestCost = c_lzParseLitCost + pathCost[r + 1];
+                uint32_t bestLen = 0;
+                uint32_t offset = candOffset[(base + r) & (c_tokRing - 1)] + 1;
+            lz_parse_cost_len:
+                for (uint32_t l = MIN_MATCH; l <= extLen[r]; l++) {
+#pragma HLS PIPELINE II = 1
+                    uint32_t cost = lzParseMatchCost(l, offset) + pathCost[r + l];
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestLen = l;
+                    }
+                }
+                pathCost[r] = bestCost;
+                pathLen[r] = bestLen;
+            }
+        } else {
+        // Match is deferred to a literal when the next position has a longer one
+        lz_parse_lazy:
+            for (uint32_t r = 0; r < span; r++) {
+#pragma HLS PIPELINE II = 1
+                uint32_t len = extLen[r];
+                if (len < MAX_LAZY && r + 1 < span && extLen[r + 1] > len) len = 0;
+                pathLen[r] = len;
+            }
+        }
+
+    // Emit the parse of the window, last match may end inside look ahead
+    lz_parse_emit:
+        uint32_t r = 0;
+        while (r < window) {
+#pragma HLS PIPELINE II = 1
+            uint32_t p = base + r;
+            compressd_dt outValue = 0;
+            outValue.range(7, 0) = history[p & (c_histRing - 1)];
+            if (pathLen[r]) {
+                outValue.range(15, 8) = pathLen[r];
+                outValue.range(31, 16) = candOffset[p & (c_tokRing - 1)];
+                r += pathLen[r];
+            } else {
+                r++;
+            }
+            outStream << outValue;
+        }
+        base += r;
+    }
+}
+
+} // namespace details
+
+/**
+ * @brief This module picks matches with lazy evaluation as zlib levels
+ * 4 to 9 do: the match at a position is emitted only if the next position
+ * does not have a longer one, else a literal is emitted and the next
+ * position is evaluated the same way. Candidate lengths coming from
+ * lzCompress/lzBestMatchFilter are first extended up to MAX_MATCH_LEN
+ * against the history window, so it replaces lzBooster in the pipeline.
+ *
+ * @tparam MAX_MATCH_LEN maximum length allowed for character match
+ * @tparam MIN_MATCH minimum match length, 4 keeps lz77Divide from seeing
+ * length 3 matches
+ * @tparam MAX_LAZY matches of this length or longer are taken directly
+ * @tparam PARSE_WINDOW positions parsed per window, power of 2
+ * @tparam HISTORY_SIZE offset window used to extend matches, power of 2
+ *
+ * @param inStream input stream, one token per input byte
+ * @param outStream output stream of literal and match tokens
+ * @param input_size input size
+ * @param dict_size preset dictionary size, the first dict_size literals
+ * only fill the history window and are not written
+ */
+template <int MAX_MATCH_LEN,
+          int MIN_MATCH = 4,
+          int MAX_LAZY = 42,
+          int PARSE_WINDOW = 512,
+          int HISTORY_SIZE = 16 * 1024>
+void lzLazyFilter(hls::stream<compressd_dt>& inStream,
+                  hls::stream<compressd_dt>& outStream,
+                  uint32_t input_size,
+                  uint32_t dict_size = 0) {
+    details::lzParse<MAX_MATCH_LEN, MIN_MATCH, PARSE_WINDOW, HISTORY_SIZE, MAX_LAZY, false>(inStream, outStream,
+                                                                                           input_size, dict_size);
+}
+
+/**
+ * @brief This module selects matches with a bounded window optimal parse.
+ * Candidate lengths are extended like in lzLazyFilter and, for every window
+ * of PARSE_WINDOW positions, the cheapest literal/match path is found using
+ * an approximate Deflate bit cost, where every length from MIN_MATCH up to
+ * the extended one is considered. It trades throughput for ratio and plugs
+ * in the same place as lzBooster/lzLazyFilter.
+ *
+ * @tparam MAX_MATCH_LEN maximum length allowed for character match
+ * @tparam MIN_MATCH minimum match length
+ * @tparam PARSE_WINDOW positions parsed per window, power of 2
+ * @tparam HISTORY_SIZE offset window used to extend matches, power of 2
+ *
+ * @param inStream input stream, one token per input byte
+ * @param outStream output stream of literal and match tokens
+ * @param input_size input size
+ * @param dict_size preset dictionary size, as in lzLazyFilter
+ */
+template <int MAX_MATCH_LEN, int MIN_MATCH = 4, int PARSE_WINDOW = 512, int HISTORY_SIZE = 16 * 1024>
+void lzOptimalParse(hls::stream<compressd_dt>& inStream,
+                    hls::stream<compressd_dt>& outStream,
+                    uint32_t input_size,
+                    uint32_t dict_size = 0) {
+    details::lzParse<MAX_MATCH_LEN, MIN_MATCH, PARSE_WINDOW, HISTORY_SIZE, MAX_MATCH_LEN, true>(
+        inStream, outStream, input_size, dict_size);
+}
+
 } // namespace compression
 } // namespace xf
 #endif // _XFCOMPRESSION_LZ_OPTIONAL_HPP_
@@ -0,0 +1,696 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_ZSTD_COMPRESS_HPP_
+#define _XFCOMPRESSION_ZSTD_COMPRESS_HPP_
+
+/**
+ * @file zstd_compress.hpp
+ * @brief Header for modules used in Zstandard compression kernel.
+ *
+ * LZ77 tokens from lzCompress, lzBestMatchFilter and lzBooster are packed
+ * into Zstandard compressed blocks: Huffman coded literals and FSE coded
+ * sequences. Blocks which do not shrink are stored raw or as RLE.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include "hls_stream.h"
+
+#include <ap_int.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "fse_encoder.hpp"
+#include "lz_compress.hpp"
+#include "lz_optional.hpp"
+#include "zstd_specs.hpp"
+
+namespace xf {
+namespace compression {
+namespace details {
+
+// Below this many sequences the predefined tables are used
+const uint32_t c_zstdPredefinedSeqLimit = 64;
+// Below this many literals Huffman header does not pay off
+const uint32_t c_zstdMinHufLiterals = 64;
+
+inline uint32_t zstdWriteLE(uint8_t* out, uint32_t idx, uint64_t value, uint8_t nbytes) {
+    for (uint8_t i = 0; i < nbytes; i++) {
+#pragma HLS UNROLL
+        out[idx++] = value >> (8 * i);
+    }
+    return idx;
+}
+
+/**
+ * @brief Literals section header of raw and RLE literals
+ */
+inline uint32_t zstdLitHeader(uint8_t* out, uint32_t idx, uint8_t litType, uint32_t litSize) {
+    if (litSize < 32) return zstdWriteLE(out, idx, litType | (litSize << 3), 1);
+    if (litSize < 4096) return zstdWriteLE(out, idx, litType | (1 << 2) | (litSize << 4), 2);
+    return zstdWriteLE(out, idx, litType | (3 << 2) | (litSize << 4), 3);
+}
+
+/**
+ * @brief Code of a length from baseline table, largest code whose baseline
+ * does not exceed the value
+ */
+template <int NUM_CODES>
+inline uint8_t zstdLengthCode(uint32_t value, const uint32_t base[NUM_CODES]) {
+    uint8_t code = 0;
+zstd_length_code:
+    for (uint8_t c = 1; c < NUM_CODES; c++) {
+#pragma HLS UNROLL
+        if (base[c] <= value) code = c;
+    }
+    return code;
+}
+
+/**
+ * @brief Huffman code lengths limited to c_zstdHufMaxBits, the code is
+ * kept complete as the format derives the last weight from the others
+ *
+ * @param freq literal frequencies
+ * @param maxSymbol largest literal present
+ * @param codeLen code length per literal
+ *
+ * @return longest code length
+ */
+static uint8_t zstdHuffmanLengths(const uint32_t freq[256], uint8_t maxSymbol, uint8_t codeLen[256]) {
+    const uint8_t c_maxBits = c_zstdHufMaxBits;
+    uint16_t sym[256];
+    uint32_t nodeFreq[512];
+    uint16_t parent[512];
+    uint8_t depth[512];
+    uint16_t n = 0;
+
+    // Present symbols sorted by increasing frequency
+huf_sort:
+    for (uint16_t s = 0; s <= maxSymbol; s++) {
+        codeLen[s] = 0;
+        if (freq[s] == 0) continue;
+        int16_t j = n++;
+        for (; j > 0 && freq[sym[j - 1]] > freq[s]; j--) sym[j] = sym[j - 1];
+        sym[j] = s;
+    }
+    for (uint16_t i = 0; i < n; i++) nodeFreq[i] = freq[sym[i]];
+
+    // Two queue tree construction, internal nodes are created in order
+    uint16_t leaf = 0, node = n;
+huf_tree:
+    for (uint16_t next = n; next < 2 * n - 1; next++) {
+        uint16_t child[2];
+        for (uint8_t k = 0; k < 2; k++) {
+            if (leaf < n && (node >= next || nodeFreq[leaf] <= nodeFreq[node]))
+                child[k] = leaf++;
+            else
+                child[k] = node++;
+        }
+        nodeFreq[next] = nodeFreq[child[0]] + nodeFreq[child[1]];
+        parent[child[0]] = next;
+        parent[child[1]] = next;
+    }
+    depth[2 * n - 2] = 0;
+huf_depth:
+    for (int16_t i = 2 * n - 3; i >= 0; i--) depth[i] = depth[parent[i]] + 1;
+
+    // Clip to maximum length, kraft sum counted in units of 2^-c_maxBits
+    int32_t kraft = 0;
+    const int32_t c_full = 1 << c_maxBits;
+    uint8_t len[256];
+    for (uint16_t i = 0; i < n; i++) {
+        len[i] = (depth[i] > c_maxBits) ? c_maxBits : depth[i];
+        kraft += 1 << (c_maxBits - len[i]);
+    }
+huf_limit:
+    while (kraft > c_full) {
+        // Lengthen the least frequent code which can still grow
+        for (uint16_t i = 0; i < n; i++) {
+            if (len[i] < c_maxBits) {
+                len[i]++;
+                kraft -= 1 << (c_maxBits - len[i]);
+                break;
+            }
+        }
+    }
+huf_fill:
+    while (kraft < c_full) {
+        // Shorten the most frequent code which fits in the slack
+        for (int16_t i = n - 1; i >= 0; i--) {
+            if (len[i] > 1 && (1 << (c_maxBits - len[i])) <= (c_full - kraft)) {
+                kraft += 1 << (c_maxBits - len[i]);
+                len[i]--;
+                break;
+            }
+        }
+    }
+
+    uint8_t maxLen = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        codeLen[sym[i]] = len[i];
+        if (len[i] > maxLen) maxLen = len[i];
+    }
+    return maxLen;
+}
+
+/**
+ * @brief FSE compressed Huffman weights, two interleaved states
+ *
+ * @return number of bytes written, 0 when not compressible
+ */
+static uint32_t zstdCompressWeights(const uint8_t* weights, uint16_t numWeights, uint8_t* out) {
+    const uint8_t c_maxWeight = c_zstdHufMaxBits;
+    uint32_t freq[c_maxWeight + 1];
+    int16_t norm[c_maxWeight + 1];
+    fseCTable<c_maxWeight + 1, c_zstdHufWeightFseLog> ctable;
+
+    for (uint8_t w = 0; w <= c_maxWeight; w++) freq[w] = 0;
+    uint8_t maxW = 0;
+    uint32_t maxCount = 0;
+    for (uint16_t i = 0; i < numWeights; i++) {
+        uint8_t w = weights[i];
+        freq[w]++;
+        if (w > maxW) maxW = w;
+        if (freq[w] > maxCount) maxCount = freq[w];
+    }
+    if (numWeights <= 2 || maxCount == numWeights || maxCount == 1) return 0;
+
+    uint8_t tableLog = fseOptimalTableLog(c_zstdHufWeightFseLog, numWeights, maxW);
+    fseNormalizeCounts<c_maxWeight + 1>(freq, numWeights, maxW, tableLog, norm);
+    uint32_t idx = fseWriteNCount<c_maxWeight + 1>(norm, maxW, tableLog, out, 0);
+    fseBuildCTable<c_maxWeight + 1, c_zstdHufWeightFseLog>(norm, maxW, tableLog, ctable);
+
+    // Even positions belong to first state, odd positions to second state
+    fseBitWriter bw;
+    fseBitWriterInit(bw, idx);
+    uint32_t state[2];
+    int32_t i = numWeights - 1;
+    fseInitState(state[i & 1], ctable, weights[i]);
+    i--;
+    fseInitState(state[i & 1], ctable, weights[i]);
+    for (i--; i >= 0; i--) fseEncodeSymbol(bw, out, state[i & 1], ctable, weights[i]);
+    fseFlushState(bw, out, state[1], tableLog);
+    fseFlushState(bw, out, state[0], tableLog);
+    return fseCloseStream(bw, out);
+}
+
+/**
+ * @brief Encode literals section, Huffman coded when it is smaller than raw
+ *
+ * @param lit literals
+ * @param litSize number of literals
+ * @param out output buffer
+ * @param idx write position in output buffer
+ *
+ * @return index past the last written byte
+ */
+static uint32_t zstdLiteralsSection(const uint8_t* lit, uint32_t litSize, uint8_t* out, uint32_t idx) {
+    uint32_t freq[256];
+    uint8_t codeLen[256];
+    uint16_t code[256];
+    uint8_t weights[256];
+    uint8_t wtBuf[256];
+
+    for (uint16_t s = 0; s < 256; s++) freq[s] = 0;
+lit_freq:
+    for (uint32_t i = 0; i < litSize; i++) {
+#pragma HLS PIPELINE II = 1
+        freq[lit[i]]++;
+    }
+    uint8_t maxSymbol = 0;
+    uint16_t distinct = 0;
+    for (uint16_t s = 0; s < 256; s++) {
+        if (freq[s]) {
+            maxSymbol = s;
+            distinct++;
+        }
+    }
+
+    uint32_t rawHeader = (litSize < 32) ? 1 : (litSize < 4096) ? 2 : 3;
+    if (litSize && distinct == 1) {
+        idx = zstdLitHeader(out, idx, ZSTD_RLE_LIT, litSize);
+        out[idx++] = lit[0];
+        return idx;
+    }
+    bool rawLit = (litSize < c_zstdMinHufLiterals);
+
+    uint8_t maxLen = 0;
+    if (!rawLit) maxLen = zstdHuffmanLengths(freq, maxSymbol, codeLen);
+
+    // Canonical codes, longest codes take the smallest values
+    uint16_t nbPerRank[c_zstdHufMaxBits + 1];
+    uint16_t valPerRank[c_zstdHufMaxBits + 2];
+    for (uint8_t r = 0; r <= c_zstdHufMaxBits; r++) nbPerRank[r] = 0;
+    for (uint16_t s = 0; s <= maxSymbol && !rawLit; s++) nbPerRank[codeLen[s]]++;
+    uint16_t minVal = 0;
+    for (int8_t r = maxLen; r > 0 && !rawLit; r--) {
+        valPerRank[r] = minVal;
+        minVal += nbPerRank[r];
+        minVal >>= 1;
+    }
+    for (uint16_t s = 0; s <= maxSymbol && !rawLit; s++) {
+        weights[s] = codeLen[s] ? maxLen + 1 - codeLen[s] : 0;
+        if (codeLen[s]) code[s] = valPerRank[codeLen[s]]++;
+    }
+
+    // Tree description: FSE compressed or direct 4 bit weights
+    uint32_t fseWtSize = rawLit ? 0 : zstdCompressWeights(weights, maxSymbol, wtBuf);
+    uint32_t directWtSize = (maxSymbol <= c_zstdHufMaxDirectWeights) ? (maxSymbol + 1) / 2 : 0xFFFF;
+    bool fseWeights = fseWtSize && (fseWtSize < 128) && (fseWtSize < directWtSize);
+    uint32_t treeSize = 1 + (fseWeights ? fseWtSize : directWtSize);
+    if (!fseWeights && directWtSize == 0xFFFF) rawLit = true;
+
+    // Stream sizes known upfront from code lengths
+    bool singleStream = (litSize < 1024);
+    uint8_t numStreams = singleStream ? 1 : 4;
+    uint32_t segSize = singleStream ? litSize : (litSize + 3) / 4;
+    uint32_t streamSize[4] = {0, 0, 0, 0};
+    uint32_t compSize = treeSize + (singleStream ? 0 : 6);
+    for (uint8_t k = 0; k < numStreams && !rawLit; k++) {
+        uint32_t start = k * segSize;
+        uint32_t end = (k == numStreams - 1) ? litSize : start + segSize;
+        uint32_t bits = 0;
+        for (uint32_t i = start; i < end; i++) bits += codeLen[lit[i]];
+        streamSize[k] = (bits + 8) / 8;
+        compSize += streamSize[k];
+    }
+    uint8_t sizeFormat = singleStream ? 0 : (compSize < 16384 && litSize < 16384) ? 2 : 3;
+    uint32_t hufHeader = (sizeFormat == 3) ? 5 : (sizeFormat == 2) ? 4 : 3;
+    if (rawLit || (hufHeader + compSize >= rawHeader + litSize)) {
+        idx = zstdLitHeader(out, idx, ZSTD_RAW_LIT, litSize);
+        for (uint32_t i = 0; i < litSize; i++) out[idx++] = lit[i];
+        return idx;
+    }
+
+    uint64_t header = ZSTD_HUF_LIT | ((uint64_t)litSize << 4);
+    if (sizeFormat == 3)
+        header |= (3 << 2) | ((uint64_t)compSize << 22);
+    else if (sizeFormat == 2)
+        header |= (2 << 2) | ((uint64_t)compSize << 18);
+    else
+        header |= ((uint64_t)compSize << 14);
+    idx = zstdWriteLE(out, idx, header, hufHeader);
+
+    if (fseWeights) {
+        out[idx++] = fseWtSize;
+        for (uint32_t i = 0; i < fseWtSize; i++) out[idx++] = wtBuf[i];
+    } else {
+        out[idx++] = 127 + maxSymbol;
+        for (uint16_t i = 0; i < maxSymbol; i += 2) {
+            uint8_t hi = weights[i];
+            uint8_t lo = (i + 1 < maxSymbol) ? weights[i + 1] : 0;
+            out[idx++] = (hi << 4) | lo;
+        }
+    }
+
+    if (!singleStream) {
+        for (uint8_t k = 0; k < 3; k++) idx = zstdWriteLE(out, idx, streamSize[k], 2);
+    }
+
+    // Literals are written last to first, decoder reads the stream backwards
+huf_streams:
+    for (uint8_t k = 0; k < numStreams; k++) {
+        uint32_t start = k * segSize;
+        uint32_t end = (k == numStreams - 1) ? litSize : start + segSize;
+        fseBitWriter bw;
+        fseBitWriterInit(bw, idx);
+        for (uint32_t i = end; i > start; i--) {
+#pragma HLS PIPELINE II = 1
+            uint8_t s = lit[i - 1];
+            fseAddBits(bw, out, code[s], codeLen[s]);
+        }
+        idx = fseCloseStream(bw, out);
+    }
+    return idx;
+}
+
+/**
+ * @brief Pick compression mode of one sequence symbol type and build its
+ * table, the table description is written to output
+ *
+ * @return ZSTD_PREDEFINED_MODE, ZSTD_RLE_MODE or ZSTD_FSE_MODE
+ */
+template <int MAX_SYMBOLS, int MAX_TABLE_LOG>
+uint8_t zstdSeqTable(const uint8_t* codes,
+                     uint32_t nbSeq,
+                     const int16_t* defNorm,
+                     uint8_t defMax,
+                     uint8_t defLog,
+                     fseCTable<MAX_SYMBOLS, MAX_TABLE_LOG>& ctable,
+                     uint8_t* out,
+                     uint32_t& idx) {
+    uint32_t freq[MAX_SYMBOLS];
+    int16_t norm[MAX_SYMBOLS];
+    for (uint8_t s = 0; s < MAX_SYMBOLS; s++) freq[s] = 0;
+seq_freq:
+    for (uint32_t i = 0; i < nbSeq; i++) {
+#pragma HLS PIPELINE II = 1
+        freq[codes[i]]++;
+    }
+    uint8_t maxSymbol = 0;
+    uint8_t distinct = 0;
+    for (uint8_t s = 0; s < MAX_SYMBOLS; s++) {
+        if (freq[s]) {
+            maxSymbol = s;
+            distinct++;
+        }
+    }
+
+    if (distinct == 1) {
+        out[idx++] = maxSymbol;
+        return ZSTD_RLE_MODE;
+    }
+    if (nbSeq < c_zstdPredefinedSeqLimit) {
+        for (uint8_t s = 0; s < MAX_SYMBOLS; s++) norm[s] = (s <= defMax) ? defNorm[s] : 0;
+        fseBuildCTable<MAX_SYMBOLS, MAX_TABLE_LOG>(norm, defMax, defLog, ctable);
+        return ZSTD_PREDEFINED_MODE;
+    }
+    uint8_t tableLog = fseOptimalTableLog(MAX_TABLE_LOG, nbSeq, maxSymbol);
+    fseNormalizeCounts<MAX_SYMBOLS>(freq, nbSeq, maxSymbol, tableLog, norm);
+    idx = fseWriteNCount<MAX_SYMBOLS>(norm, maxSymbol, tableLog, out, idx);
+    fseBuildCTable<MAX_SYMBOLS, MAX_TABLE_LOG>(norm, maxSymbol, tableLog, ctable);
+    return ZSTD_FSE_MODE;
+}
+
+/**
+ * @brief Encode sequences section
+ *
+ * @param litLen literal length per sequence
+ * @param matchLen match length per sequence
+ * @param offset match offset per sequence
+ * @param nbSeq number of sequences
+ * @param out output buffer
+ * @param idx write position in output buffer
+ * @param limit give up once output goes past this index
+ *
+ * @return false when output exceeded limit
+ */
+template <int MAX_SEQ>
+bool zstdSequencesSection(const uint32_t* litLen,
+                          const uint16_t* matchLen,
+                          const uint32_t* offset,
+                          uint32_t nbSeq,
+                          uint8_t* out,
+                          uint32_t& idx,
+                          uint32_t limit) {
+    uint8_t llCode[MAX_SEQ];
+    uint8_t mlCode[MAX_SEQ];
+    uint8_t ofCode[MAX_SEQ];
+    fseCTable<c_zstdMaxLL + 1, c_zstdLLFseLog> llTable;
+    fseCTable<c_zstdMaxML + 1, c_zstdMLFseLog> mlTable;
+    fseCTable<c_zstdMaxOF + 1, c_zstdOFFseLog> ofTable;
+
+    if (nbSeq < 128) {
+        out[idx++] = nbSeq;
+    } else if (nbSeq < 0x7F00) {
+        out[idx++] = (nbSeq >> 8) + 0x80;
+        out[idx++] = nbSeq;
+    } else {
+        out[idx++] = 0xFF;
+        idx = zstdWriteLE(out, idx, nbSeq - 0x7F00, 2);
+    }
+    if (nbSeq == 0) return true;
+
+seq_codes:
+    for (uint32_t i = 0; i < nbSeq; i++) {
+#pragma HLS PIPELINE II = 1
+        llCode[i] = zstdLengthCode<c_zstdMaxLL + 1>(litLen[i], c_zstdLLBase);
+        mlCode[i] = zstdLengthCode<c_zstdMaxML + 1>(matchLen[i], c_zstdMLBase);
+        ofCode[i] = fseHighBit(offset[i] + 3);
+    }
+
+    uint32_t modeIdx = idx++;
+    uint8_t llMode = zstdSeqTable<c_zstdMaxLL + 1, c_zstdLLFseLog>(llCode, nbSeq, c_zstdLLDefaultNorm, c_zstdMaxLL,
+                                                                   c_zstdLLDefaultLog, llTable, out, idx);
+    uint8_t ofMode = zstdSeqTable<c_zstdMaxOF + 1, c_zstdOFFseLog>(ofCode, nbSeq, c_zstdOFDefaultNorm, c_zstdOFDefaultMax,
+                                                                   c_zstdOFDefaultLog, ofTable, out, idx);
+    uint8_t mlMode = zstdSeqTable<c_zstdMaxML + 1, c_zstdMLFseLog>(mlCode, nbSeq, c_zstdMLDefaultNorm, c_zstdMaxML,
+                                                                   c_zstdMLDefaultLog, mlTable, out, idx);
+    out[modeIdx] = (llMode << 6) | (ofMode << 4) | (mlMode << 2);
+
+    bool llFse = (llMode != ZSTD_RLE_MODE);
+    bool ofFse = (ofMode != ZSTD_RLE_MODE);
+    bool mlFse = (mlMode != ZSTD_RLE_MODE);
+
+    // Last sequence sets up the states and is decoded first
+    fseBitWriter bw;
+    fseBitWriterInit(bw, idx);
+    uint32_t llState = 0, ofState = 0, mlState = 0;
+    uint32_t n = nbSeq - 1;
+    if (mlFse) fseInitState(mlState, mlTable, mlCode[n]);
+    if (ofFse) fseInitState(ofState, ofTable, ofCode[n]);
+    if (llFse) fseInitState(llState, llTable, llCode[n]);
+    fseAddBits(bw, out, litLen[n], c_zstdLLBits[llCode[n]]);
+    fseAddBits(bw, out, matchLen[n] - c_zstdMinMatch, c_zstdMLBits[mlCode[n]]);
+    fseAddBits(bw, out, offset[n] + 3, ofCode[n]);
+
+seq_encode:
+    for (n = nbSeq - 1; n > 0; n--) {
+#pragma HLS PIPELINE II = 1
+        uint32_t i = n - 1;
+        if (ofFse) fseEncodeSymbol(bw, out, ofState, ofTable, ofCode[i]);
+        if (mlFse) fseEncodeSymbol(bw, out, mlState, mlTable, mlCode[i]);
+        if (llFse) fseEncodeSymbol(bw, out, llState, llTable, llCode[i]);
+        fseAddBits(bw, out, litLen[i], c_zstdLLBits[llCode[i]]);
+        fseAddBits(bw, out, matchLen[i] - c_zstdMinMatch, c_zstdMLBits[mlCode[i]]);
+        fseAddBits(bw, out, offset[i] + 3, ofCode[i]);
+        if (bw.idx > limit) return false;
+    }
+    if (mlFse) fseFlushState(bw, out, mlState, mlTable.tableLog);
+    if (ofFse) fseFlushState(bw, out, ofState, ofTable.tableLog);
+    if (llFse) fseFlushState(bw, out, llState, llTable.tableLog);
+    idx = fseCloseStream(bw, out);
+    return (idx <= limit);
+}
+
+/**
+ * @brief Pack LZ77 tokens of one block as Zstandard block, block header
+ * included. Raw or RLE block is written when compressed block is not
+ * smaller than input.
+ *
+ * @tparam BLOCK_SIZE maximum block size
+ *
+ * @param inStream lz tokens (byte, match length, offset - 1)
+ * @param outStream output byte stream
+ * @param outEos end of stream flag per output byte, always false
+ * @param blockSizeStream block size including header
+ * @param input_size block input size
+ * @param last last block of frame
+ */
+template <int BLOCK_SIZE>
+void zstdBlockPacker(hls::stream<compressd_dt>& inStream,
+                     hls::stream<ap_uint<8> >& outStream,
+                     hls::stream<bool>& outEos,
+                     hls::stream<uint32_t>& blockSizeStream,
+                     uint32_t input_size,
+                     bool last) {
+    const int c_maxSeq = BLOCK_SIZE / c_zstdMinMatch + 1;
+    uint8_t rawBuf[BLOCK_SIZE];
+    uint8_t litBuf[BLOCK_SIZE];
+    uint8_t compBuf[BLOCK_SIZE + 64];
+    uint32_t litLen[c_maxSeq];
+    uint16_t matchLen[c_maxSeq];
+    uint32_t offset[c_maxSeq];
+
+    uint32_t litSize = 0;
+    uint32_t nbSeq = 0;
+    uint32_t litRun = 0;
+    bool isRle = true;
+
+// Matches shorter than format minimum are sent as literals
+zstd_parse_tokens:
+    for (uint32_t pos = 0; pos < input_size;) {
+#pragma HLS PIPELINE II = 1
+        compressd_dt inValue = inStream.read();
+        uint8_t tCh = inValue.range(7, 0);
+        uint8_t tLen = inValue.range(15, 8);
+        uint32_t tOffset = (uint32_t)inValue.range(31, 16) + 1;
+
+        if (tLen == 0) {
+            rawBuf[pos++] = tCh;
+            litBuf[litSize++] = tCh;
+            litRun++;
+            continue;
+        }
+        for (uint8_t k = 0; k < tLen; k++) {
+            rawBuf[pos + k] = rawBuf[pos + k - tOffset];
+            if (tLen < c_zstdMinMatch) litBuf[litSize++] = rawBuf[pos + k];
+        }
+        pos += tLen;
+        if (tLen < c_zstdMinMatch) {
+            litRun += tLen;
+        } else {
+            litLen[nbSeq] = litRun;
+            matchLen[nbSeq] = tLen;
+            offset[nbSeq] = tOffset;
+            nbSeq++;
+            litRun = 0;
+        }
+    }
+    for (uint32_t i = 1; i < input_size; i++) {
+        if (rawBuf[i] != rawBuf[0]) isRle = false;
+    }
+
+    uint32_t idx = zstdLiteralsSection(litBuf, litSize, compBuf, 3);
+    bool compressed = (idx < input_size);
+    if (compressed) compressed = zstdSequencesSection<c_maxSeq>(litLen, matchLen, offset, nbSeq, compBuf, idx, input_size);
+    compressed = compressed && (idx - 3 < input_size);
+
+    uint8_t blockType = ZSTD_COMPRESSED_BLOCK;
+    uint32_t contentSize = idx - 3;
+    if (isRle && input_size > 1) {
+        blockType = ZSTD_RLE_BLOCK;
+        contentSize = 1;
+        compBuf[3] = rawBuf[0];
+    } else if (!compressed) {
+        blockType = ZSTD_RAW_BLOCK;
+        contentSize = input_size;
+    }
+    uint32_t blockSize = (blockType == ZSTD_RLE_BLOCK) ? input_size : contentSize;
+    zstdWriteLE(compBuf, 0, (uint32_t)last | (blockType << 1) | (blockSize << 3), 3);
+
+zstd_write_block:
+    for (uint32_t i = 0; i < contentSize + 3; i++) {
+#pragma HLS PIPELINE II = 1
+        uint8_t outValue = compBuf[i];
+        if (blockType == ZSTD_RAW_BLOCK && i >= 3) outValue = rawBuf[i - 3];
+        outStream << outValue;
+        outEos << 0;
+    }
+    blockSizeStream << contentSize + 3;
+}
+
+/**
+ * @brief Store block as raw block, used for blocks too small for LZ77
+ */
+static void zstdRawBlock(hls::stream<ap_uint<8> >& inStream,
+                         hls::stream<ap_uint<8> >& outStream,
+                         hls::stream<bool>& outEos,
+                         uint32_t input_size,
+                         bool last) {
+    uint32_t header = (uint32_t)last | (ZSTD_RAW_BLOCK << 1) | (input_size << 3);
+    for (uint8_t i = 0; i < 3; i++) {
+        outStream << (uint8_t)(header >> (8 * i));
+        outEos << 0;
+    }
+zstd_raw_block:
+    for (uint32_t i = 0; i < input_size; i++) {
+#pragma HLS PIPELINE II = 1
+        outStream << inStream.read();
+        outEos << 0;
+    }
+}
+
+template <int BLOCK_SIZE, int MATCH_LEN, int MIN_MATCH, int LZ_MAX_OFFSET_LIMIT, int MAX_MATCH_LEN>
+void zstdCompressBlock(hls::stream<ap_uint<8> >& inStream,
+                       hls::stream<ap_uint<8> >& outStream,
+                       hls::stream<bool>& outEos,
+                       hls::stream<uint32_t>& blockSizeStream,
+                       uint32_t input_size,
+                       bool last) {
+    hls::stream<compressd_dt> compressdStream("compressdStream");
+    hls::stream<compressd_dt> bestMatchStream("bestMatchStream");
+    hls::stream<compressd_dt> boosterStream("boosterStream");
+#pragma HLS STREAM variable = compressdStream depth = 8
+#pragma HLS STREAM variable = bestMatchStream depth = 8
+#pragma HLS STREAM variable = boosterStream depth = 8
+
+#pragma HLS dataflow
+    lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, compressdStream, input_size);
+    lzBestMatchFilter<MATCH_LEN, LZ_MAX_OFFSET_LIMIT>(compressdStream, bestMatchStream, input_size);
+    lzBooster<MAX_MATCH_LEN>(bestMatchStream, boosterStream, input_size);
+    zstdBlockPacker<BLOCK_SIZE>(boosterStream, outStream, outEos, blockSizeStream, input_size, last);
+}
+
+} // namespace details
+} // namespace compression
+} // namespace xf
+
+namespace xf {
+namespace compression {
+
+/**
+ * @brief Zstandard compression of one frame. Input is split into
+ * BLOCK_SIZE blocks, each block goes through LZ77 match search and is packed
+ * with Huffman coded literals and FSE coded sequences. Frame carries content
+ * size and no checksum, offsets are always explicit (no repeat offsets).
+ *
+ * @tparam BLOCK_SIZE block size, at most 64KB as LZ77 offsets are 16 bit
+ * @tparam MIN_BLOCK_SIZE blocks below this size are stored raw
+ * @tparam MATCH_LEN match window of lzCompress
+ * @tparam MIN_MATCH minimum match of lzCompress
+ * @tparam LZ_MAX_OFFSET_LIMIT maximum match offset
+ * @tparam MAX_MATCH_LEN maximum match length of lzBooster
+ *
+ * @param inStream input data stream
+ * @param outStream compressed frame
+ * @param outEos end of stream flag per output byte
+ * @param outSize compressed frame size
+ * @param input_size input size
+ */
+template <int BLOCK_SIZE = 64 * 1024,
+          int MIN_BLOCK_SIZE = 128,
+          int MATCH_LEN = 6,
+          int MIN_MATCH = 4,
+          int LZ_MAX_OFFSET_LIMIT = 65536,
+          int MAX_MATCH_LEN = 255>
+void zstdCompress(hls::stream<ap_uint<8> >& inStream,
+                  hls::stream<ap_uint<8> >& outStream,
+                  hls::stream<bool>& outEos,
+                  hls::stream<uint32_t>& outSize,
+                  uint32_t input_size) {
+    hls::stream<uint32_t> blockSizeStream("blockSizeStream");
+#pragma HLS STREAM variable = blockSizeStream depth = 2
+
+    // Frame header: single segment, frame content size of 1, 2 or 4 bytes
+    uint8_t fcsFlag = (input_size < 256) ? 0 : (input_size < 65536 + 256) ? 1 : 2;
+    uint8_t fcsBytes = (fcsFlag == 0) ? 1 : (fcsFlag == 1) ? 2 : 4;
+    uint32_t fcs = (fcsFlag == 1) ? input_size - 256 : input_size;
+    uint8_t header[10];
+    uint8_t hIdx = details::zstdWriteLE(header, 0, c_zstdMagicNumber, 4);
+    header[hIdx++] = (fcsFlag << 6) | (1 << 5);
+    hIdx = details::zstdWriteLE(header, hIdx, fcs, fcsBytes);
+    for (uint8_t i = 0; i < hIdx; i++) {
+        outStream << header[i];
+        outEos << 0;
+    }
+    uint32_t compressedSize = hIdx;
+
+    uint32_t remaining = input_size;
+zstd_blocks:
+    do {
+        uint32_t blockSize = (remaining < BLOCK_SIZE) ? remaining : BLOCK_SIZE;
+        bool last = (blockSize == remaining);
+        if (blockSize < MIN_BLOCK_SIZE) {
+            details::zstdRawBlock(inStream, outStream, outEos, blockSize, last);
+            compressedSize += blockSize + 3;
+        } else {
+            details::zstdCompressBlock<BLOCK_SIZE, MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT, MAX_MATCH_LEN>(
+                inStream, outStream, outEos, blockSizeStream, blockSize, last);
+            compressedSize += blockSizeStream.read();
+        }
+        remaining -= blockSize;
+    } while (remaining);
+
+    outStream << 0;
+    outEos << 1;
+    outSize << compressedSize;
+}
+
+} // namespace compression
+} // namespace xf
+#endif // _XFCOMPRESSION_ZSTD_COMPRESS_HPP_
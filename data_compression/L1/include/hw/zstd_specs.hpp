@@ -0,0 +1,94 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_ZSTD_SPECS_HPP_
+#define _XFCOMPRESSION_ZSTD_SPECS_HPP_
+
+/**
+ * @file zstd_specs.hpp
+ * @brief Header containing Zstandard format constants (RFC 8878).
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include <stdint.h>
+
+namespace xf {
+namespace compression {
+
+const uint32_t c_zstdMagicNumber = 0xFD2FB528;
+const uint32_t c_zstdMaxBlockSize = 128 * 1024;
+const uint8_t c_zstdMinMatch = 3;
+
+// Block types
+enum zstdBlockType { ZSTD_RAW_BLOCK = 0, ZSTD_RLE_BLOCK = 1, ZSTD_COMPRESSED_BLOCK = 2 };
+
+// Literals block types
+enum zstdLitType { ZSTD_RAW_LIT = 0, ZSTD_RLE_LIT = 1, ZSTD_HUF_LIT = 2 };
+
+// Sequence symbol compression modes
+enum zstdSeqMode { ZSTD_PREDEFINED_MODE = 0, ZSTD_RLE_MODE = 1, ZSTD_FSE_MODE = 2 };
+
+// Literal length, match length and offset code alphabet
+const uint8_t c_zstdMaxLL = 35;
+const uint8_t c_zstdMaxML = 52;
+const uint8_t c_zstdMaxOF = 31;
+
+// Maximum accuracy log of FSE tables
+const uint8_t c_zstdLLFseLog = 9;
+const uint8_t c_zstdMLFseLog = 9;
+const uint8_t c_zstdOFFseLog = 8;
+const uint8_t c_fseMinTableLog = 5;
+
+// Huffman literals
+const uint8_t c_zstdHufMaxBits = 11;
+const uint8_t c_zstdHufWeightFseLog = 6;
+const uint8_t c_zstdHufMaxDirectWeights = 128;
+
+// Literal length codes: baseline and number of extra bits
+const uint32_t c_zstdLLBase[c_zstdMaxLL + 1] = {0,  1,  2,   3,   4,   5,    6,    7,    8,    9,     10,    11,
+                                                12, 13, 14,  15,  16,  18,   20,   22,   24,   28,    32,    40,
+                                                48, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536};
+const uint8_t c_zstdLLBits[c_zstdMaxLL + 1] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0,  0,  1,  1,
+                                               1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+// Match length codes: baseline (Match_Length, minimum 3) and number of extra bits
+const uint32_t c_zstdMLBase[c_zstdMaxML + 1] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14,  15,  16,  17,  18,   19,   20,   21,   22,   23,    24,    25,
+    26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051, 4099,
+    8195, 16387, 32771, 65539};
+const uint8_t c_zstdMLBits[c_zstdMaxML + 1] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                               0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+                                               2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+// Predefined distributions, -1 stands for "less than 1" probability
+const uint8_t c_zstdLLDefaultLog = 6;
+const int16_t c_zstdLLDefaultNorm[c_zstdMaxLL + 1] = {4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1,  1,  2,  2,
+                                                      2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1};
+
+const uint8_t c_zstdMLDefaultLog = 6;
+const int16_t c_zstdMLDefaultNorm[c_zstdMaxML + 1] = {1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1,  1,  1,  1,
+                                                      1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  1,  1,  1,
+                                                      1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1};
+
+const uint8_t c_zstdOFDefaultLog = 5;
+const uint8_t c_zstdOFDefaultMax = 28;
+const int16_t c_zstdOFDefaultNorm[c_zstdOFDefaultMax + 1] = {1, 1, 1, 1, 1, 1, 2, 2, 2, 1,  1,  1,  1,  1, 1,
+                                                             1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1};
+
+} // namespace compression
+} // namespace xf
+#endif // _XFCOMPRESSION_ZSTD_SPECS_HPP_
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hls_stream.h"
+#include <ap_int.h>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lz_compress.hpp"
+#include "lz_optional.hpp"
+#include "lz_decompress.hpp"
+
+#define LZ_MAX_OFFSET_LIMIT 65536
+#define OFFSET_WINDOW (64 * 1024)
+#define HISTORY_SIZE (64 * 1024)
+#define MAX_MATCH_LEN 255
+#define MATCH_LEN 6
+#define MIN_MATCH 4
+
+typedef ap_uint<32> compressd_dt;
+typedef ap_uint<8> uintV_t;
+
+void lzDictEngineRun(hls::stream<uintV_t>& inStream,
+                     hls::stream<compressd_dt>& outStream,
+                     uint32_t input_size,
+                     uint32_t dict_size) {
+    hls::stream<compressd_dt> compressdStream("compressdStream");
+    hls::stream<compressd_dt> bestMatchStream("bestMatchStream");
+
+#pragma HLS STREAM variable = compressdStream depth = 8
+#pragma HLS STREAM variable = bestMatchStream depth = 8
+
+#pragma HLS RESOURCE variable = compressdStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = bestMatchStream core = FIFO_SRL
+
+#pragma HLS dataflow
+    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, compressdStream, input_size,
+                                                                          dict_size);
+    xf::compression::lzBestMatchFilter<MATCH_LEN, OFFSET_WINDOW>(compressdStream, bestMatchStream,
+                                                                 input_size + dict_size);
+    xf::compression::lzBooster<MAX_MATCH_LEN, OFFSET_WINDOW>(bestMatchStream, outStream, input_size, dict_size);
+}
+
+// Same pipeline with the optimal parse in place of the booster
+void lzDictOptimalRun(hls::stream<uintV_t>& inStream,
+                      hls::stream<compressd_dt>& outStream,
+                      uint32_t input_size,
+                      uint32_t dict_size) {
+    hls::stream<compressd_dt> compressdStream("compressdStream");
+    hls::stream<compressd_dt> bestMatchStream("bestMatchStream");
+
+    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, compressdStream, input_size,
+                                                                          dict_size);
+    xf::compression::lzBestMatchFilter<MATCH_LEN, OFFSET_WINDOW>(compressdStream, bestMatchStream,
+                                                                 input_size + dict_size);
+    xf::compression::lzOptimalParse<MAX_MATCH_LEN, MIN_MATCH, 512, OFFSET_WINDOW>(bestMatchStream, outStream,
+                                                                                  input_size, dict_size);
+}
+
+bool readFile(const char* name, std::vector<uint8_t>& data) {
+    std::ifstream inputFile(name, std::ifstream::binary);
+    if (!inputFile.is_open()) return false;
+    inputFile.seekg(0, std::ios::end);
+    data.resize(inputFile.tellg());
+    inputFile.seekg(0, std::ios::beg);
+    inputFile.read((char*)data.data(), data.size());
+    return true;
+}
+
+// Compress with the given dictionary, decode the tokens with the same
+// dictionary preloaded and return the token count, 0 on mismatch
+uint32_t lzDictRoundTrip(std::vector<uint8_t>& dict, std::vector<uint8_t>& in, bool optimal) {
+    uint32_t input_size = in.size();
+    uint32_t dict_size = dict.size();
+    hls::stream<uintV_t> inStream("inStream");
+    hls::stream<compressd_dt> tokenStream("tokenStream");
+    hls::stream<compressd_dt> decStream("decStream");
+    hls::stream<ap_uint<8> > outStream("outStream");
+
+    for (uint32_t i = 0; i < dict_size; i++) inStream << dict[i];
+    for (uint32_t i = 0; i < input_size; i++) inStream << in[i];
+
+    // COMPRESSION CALL
+    if (optimal)
+        lzDictOptimalRun(inStream, tokenStream, input_size, dict_size);
+    else
+        lzDictEngineRun(inStream, tokenStream, input_size, dict_size);
+
+    // Decoder takes offset - 1 and length - 1, dictionary as literals
+    for (uint32_t i = 0; i < dict_size; i++) decStream << (compressd_dt)dict[i];
+    uint32_t tokens = 0;
+    while (!tokenStream.empty()) {
+        compressd_dt inValue = tokenStream.read();
+        uint8_t tLen = inValue.range(15, 8);
+        compressd_dt outValue = 0;
+        if (tLen) {
+            outValue.range(15, 0) = inValue.range(31, 16);
+            outValue.range(31, 16) = tLen - 1;
+        } else {
+            outValue.range(7, 0) = inValue.range(7, 0);
+        }
+        decStream << outValue;
+        tokens++;
+    }
+
+    // DECOMPRESSION CALL
+    xf::compression::lzDecompress<HISTORY_SIZE>(decStream, outStream, input_size, dict_size);
+
+    if (outStream.size() != input_size) return 0;
+    for (uint32_t i = 0; i < input_size; i++) {
+        if (outStream.read() != in[i]) return 0;
+    }
+    return tokens;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<uint8_t> in, dict, empty;
+    if (argc < 3 || !readFile(argv[1], in) || !readFile(argv[2], dict)) {
+        std::cout << "Usage: " << argv[0] << " <input file> <dictionary file>" << std::endl;
+        exit(1);
+    }
+
+    bool pass = true;
+    for (int optimal = 0; optimal < 2; optimal++) {
+        uint32_t plainTokens = lzDictRoundTrip(empty, in, optimal);
+        uint32_t dictTokens = lzDictRoundTrip(dict, in, optimal);
+        std::cout << "------- " << (optimal ? "Optimal parse" : "Booster") << " tokens without dictionary: "
+                  << plainTokens << ", with dictionary: " << dictTokens << " -------" << std::endl;
+        if (plainTokens == 0 || dictTokens == 0) pass = false;
+    }
+    std::cout << "TEST " << (pass ? "PASSED" : "FAILED") << std::endl;
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hls_stream.h"
+#include <ap_int.h>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lz_compress.hpp"
+#include "lz_optional.hpp"
+
+#define LZ_MAX_OFFSET_LIMIT 32768
+#define OFFSET_WINDOW (32 * 1024)
+#define MAX_MATCH_LEN 255
+#define MATCH_LEN 6
+#define MIN_MATCH 3
+#define PARSE_MIN_MATCH 4
+
+typedef ap_uint<32> compressd_dt;
+typedef ap_uint<8> uintV_t;
+
+enum parserType { GREEDY = 0, LAZY = 1, OPTIMAL = 2 };
+
+void lzParseEngineRun(hls::stream<uintV_t>& inStream, hls::stream<compressd_dt>& outStream, uint32_t input_size) {
+    hls::stream<compressd_dt> compressdStream("compressdStream");
+    hls::stream<compressd_dt> bestMatchStream("bestMatchStream");
+
+#pragma HLS STREAM variable = compressdStream depth = 8
+#pragma HLS STREAM variable = bestMatchStream depth = 8
+
+#pragma HLS RESOURCE variable = compressdStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = bestMatchStream core = FIFO_SRL
+
+#pragma HLS dataflow
+    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, compressdStream, input_size);
+    xf::compression::lzBestMatchFilter<MATCH_LEN, OFFSET_WINDOW>(compressdStream, bestMatchStream, input_size);
+    xf::compression::lzOptimalParse<MAX_MATCH_LEN, PARSE_MIN_MATCH>(bestMatchStream, outStream, input_size);
+}
+
+// Reference greedy (lzBooster) and lazy pipelines
+void lzParseReference(std::vector<uint8_t>& in, std::vector<compressd_dt>& tokens, parserType parser) {
+    uint32_t input_size = in.size();
+    hls::stream<uintV_t> inStream("inStream");
+    hls::stream<compressd_dt> compressdStream("compressdStream");
+    hls::stream<compressd_dt> bestMatchStream("bestMatchStream");
+    hls::stream<compressd_dt> outStream("outStream");
+    for (uint32_t i = 0; i < input_size; i++) inStream << in[i];
+
+    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, compressdStream, input_size);
+    xf::compression::lzBestMatchFilter<MATCH_LEN, OFFSET_WINDOW>(compressdStream, bestMatchStream, input_size);
+    if (parser == GREEDY)
+        xf::compression::lzBooster<MAX_MATCH_LEN>(bestMatchStream, outStream, input_size);
+    else
+        xf::compression::lzLazyFilter<MAX_MATCH_LEN, PARSE_MIN_MATCH>(bestMatchStream, outStream, input_size);
+    while (!outStream.empty()) tokens.push_back(outStream.read());
+}
+
+// Replays the tokens, returns approximate Deflate size in bits or 0 on mismatch
+uint64_t lzParseVerify(std::vector<uint8_t>& in, std::vector<compressd_dt>& tokens) {
+    std::vector<uint8_t> out;
+    uint64_t bits = 0;
+    for (size_t t = 0; t < tokens.size(); t++) {
+        uint8_t tCh = tokens[t].range(7, 0);
+        uint8_t tLen = tokens[t].range(15, 8);
+        uint32_t tOffset = (uint32_t)tokens[t].range(31, 16) + 1;
+        if (tLen == 0) {
+            out.push_back(tCh);
+            bits += xf::compression::details::c_lzParseLitCost;
+            continue;
+        }
+        if (tOffset > out.size()) return 0;
+        for (uint32_t k = 0; k < tLen; k++) out.push_back(out[out.size() - tOffset]);
+        bits += xf::compression::details::lzParseMatchCost(tLen, tOffset);
+    }
+    if (out != in) return 0;
+    return bits;
+}
+
+int main(int argc, char* argv[]) {
+    hls::stream<uintV_t> bytestr_in("parseIn");
+    hls::stream<compressd_dt> bytestr_out("parseOut");
+
+    std::ifstream inputFile;
+
+    // Input file open for input_size
+    inputFile.open(argv[1], std::ofstream::binary | std::ofstream::in);
+    if (!inputFile.is_open()) {
+        std::cout << "Cannot open the input file!!" << std::endl;
+        exit(1);
+    }
+    inputFile.seekg(0, std::ios::end);
+    uint32_t input_size = inputFile.tellg();
+    inputFile.seekg(0, std::ios::beg);
+    std::vector<uint8_t> in(input_size);
+    inputFile.read((char*)in.data(), input_size);
+    inputFile.close();
+
+    for (uint32_t i = 0; i < input_size; i++) bytestr_in << in[i];
+
+    // PARSE CALL
+    lzParseEngineRun(bytestr_in, bytestr_out, input_size);
+
+    std::vector<compressd_dt> tokens[3];
+    while (!bytestr_out.empty()) tokens[OPTIMAL].push_back(bytestr_out.read());
+    lzParseReference(in, tokens[GREEDY], GREEDY);
+    lzParseReference(in, tokens[LAZY], LAZY);
+
+    const char* names[3] = {"greedy", "lazy", "optimal"};
+    int errors = 0;
+    for (int p = GREEDY; p <= OPTIMAL; p++) {
+        uint64_t bits = lzParseVerify(in, tokens[p]);
+        if (bits == 0 && input_size != 0) {
+            std::cout << names[p] << " parse: token replay mismatch" << std::endl;
+            errors++;
+            continue;
+        }
+        std::cout << "------- " << names[p] << " parse: " << tokens[p].size() << " tokens, ~" << (bits + 7) / 8
+                  << " bytes -------" << std::endl;
+    }
+    std::cout << "TEST " << (errors ? "FAILED" : "PASSED") << std::endl;
+    return errors;
+}
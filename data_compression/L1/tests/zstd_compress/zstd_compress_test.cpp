@@ -0,0 +1,112 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hls_stream.h"
+#include <ap_int.h>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "zstd_compress.hpp"
+
+#define BLOCK_SIZE (64 * 1024)
+#define MIN_BLOCK_SIZE 128
+#define LZ_MAX_OFFSET_LIMIT 65536
+#define MAX_MATCH_LEN 255
+#define MATCH_LEN 6
+
+typedef ap_uint<8> uintV_t;
+
+int const c_minMatch = 4;
+
+void zstdCompressEngineRun(hls::stream<uintV_t>& inStream,
+                           hls::stream<uintV_t>& zstdOut,
+                           hls::stream<bool>& zstdOut_eos,
+                           hls::stream<uint32_t>& zstdOutSize,
+                           uint32_t input_size) {
+    xf::compression::zstdCompress<BLOCK_SIZE, MIN_BLOCK_SIZE, MATCH_LEN, c_minMatch, LZ_MAX_OFFSET_LIMIT, MAX_MATCH_LEN>(
+        inStream, zstdOut, zstdOut_eos, zstdOutSize, input_size);
+}
+
+int main(int argc, char* argv[]) {
+    hls::stream<uintV_t> bytestr_in("compressIn");
+    hls::stream<uintV_t> bytestr_out("compressOut");
+    hls::stream<bool> zstdOut_eos;
+    hls::stream<uint32_t> zstdOutSize;
+
+    std::ifstream inputFile;
+    std::fstream outputFile;
+
+    inputFile.open(argv[1], std::ofstream::binary | std::ofstream::in);
+    if (!inputFile.is_open()) {
+        std::cout << "Cannot open the input file!!" << std::endl;
+        exit(0);
+    }
+    inputFile.seekg(0, std::ios::end);
+    uint32_t input_size = inputFile.tellg();
+    inputFile.seekg(0, std::ios::beg);
+    std::vector<uint8_t> original(input_size);
+    inputFile.read((char*)original.data(), input_size);
+    inputFile.close();
+
+    for (uint32_t i = 0; i < input_size; i++) bytestr_in << original[i];
+
+    // COMPRESSION CALL
+    zstdCompressEngineRun(bytestr_in, bytestr_out, zstdOut_eos, zstdOutSize, input_size);
+
+    uint32_t outsize = zstdOutSize.read();
+    std::cout << "------- Compression Ratio: " << (float)input_size / outsize << " -------" << std::endl;
+
+    outputFile.open(argv[2], std::fstream::binary | std::fstream::out);
+    if (!outputFile.is_open()) {
+        std::cout << "Cannot open the output file!!" << std::endl;
+        exit(0);
+    }
+    uint32_t written = 0;
+    for (bool eos_flag = zstdOut_eos.read(); !eos_flag; eos_flag = zstdOut_eos.read()) {
+        uint8_t w = bytestr_out.read();
+        outputFile.write((char*)&w, 1);
+        written++;
+    }
+    // trailing token after the end of stream
+    bytestr_out.read();
+    outputFile.close();
+    if (written != outsize) {
+        std::cout << "Compressed size mismatch " << written << " != " << outsize << std::endl;
+        return 1;
+    }
+
+    // Round trip through reference zstd decoder
+    std::string decFile = std::string(argv[2]) + ".dec";
+    std::string cmd = "zstd -d -q -f " + std::string(argv[2]) + " -o " + decFile;
+    if (system(cmd.c_str()) != 0) {
+        std::cout << "Reference zstd decoder rejected " << argv[2] << std::endl;
+        return 1;
+    }
+    std::ifstream decodedFile(decFile.c_str(), std::ifstream::binary);
+    std::vector<uint8_t> decoded((std::istreambuf_iterator<char>(decodedFile)), std::istreambuf_iterator<char>());
+    if (decoded != original) {
+        std::cout << "TEST FAILED: decompressed data does not match input" << std::endl;
+        return 1;
+    }
+    std::cout << "TEST PASSED" << std::endl;
+    return 0;
+}
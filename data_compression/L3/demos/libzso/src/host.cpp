@@ -7,6 +7,8 @@
 #include <iostream>
 #include <iomanip>
 #include <assert.h>
+#include <fstream>
+#include "chunk_chain.hpp"
 #define CHUNK 16384
 
 void zlib_compress(char* inFile) {
@@ -51,7 +53,7 @@ void zlib_compress(char* inFile) {
 void zlib_uncompress(char* inFile) {
     std::string outFile = inFile;
     outFile = outFile + ".orig";
-    uint64_t uncompress_len;
+    uint64_t uncompress_len = 0;
 
     FILE* fptr;
     fptr = fopen(inFile, "rb");
@@ -60,7 +62,8 @@ void zlib_uncompress(char* inFile) {
     fclose(fptr);
     uint32_t insize_print = (input_size / 1000000);
     uint8_t* input = (uint8_t*)calloc(input_size, 1);
-    uint8_t* uncompress_out = (uint8_t*)calloc(input_size * 20, 1);
+    // Decompressed size is unknown, output is collected in a chunk chain
+    xf::compression::xfChunkChain uncompress_out;
 
     fptr = fopen(inFile, "rb");
     fread(input, 1, input_size, fptr);
@@ -69,7 +72,19 @@ void zlib_uncompress(char* inFile) {
     std::chrono::duration<double, std::milli> compress_API_time_ms_1(0);
     auto compress_API_start = std::chrono::high_resolution_clock::now();
 
-    int err = uncompress(uncompress_out, &uncompress_len, input, input_size);
+    z_stream strm = {};
+    int err = inflateInit(&strm);
+    strm.next_in = input;
+    strm.avail_in = input_size;
+    while (err == Z_OK) {
+        uint64_t avail;
+        strm.next_out = uncompress_out.tail(avail);
+        strm.avail_out = avail;
+        err = inflate(&strm, Z_NO_FLUSH);
+        uncompress_out.commit(avail - strm.avail_out);
+    }
+    inflateEnd(&strm);
+    uncompress_len = uncompress_out.size();
 
     auto compress_API_end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration<double, std::milli>(compress_API_end - compress_API_start);
@@ -80,11 +95,12 @@ void zlib_uncompress(char* inFile) {
     std::cout << "Input File: " << inFile << " (" << insize_print << " MB)" << std::endl;
     std::cout << "Output File: " << outFile.c_str() << " (" << (uncompress_len / 1000000) << " MB)" << std::endl;
 
-    // printf("uncompress_len %d err %d \n", uncompress_len, err);
+    if (err != Z_STREAM_END) std::cout << "Decompression Failed, error " << err << std::endl;
 
-    fptr = fopen(outFile.c_str(), "wb");
-    fwrite(uncompress_out, 1, uncompress_len, fptr);
-    fclose(fptr);
+    std::ofstream outf(outFile.c_str(), std::ofstream::binary);
+    uncompress_out.write(outf);
+    outf.close();
+    free(input);
 }
 
 int main(int argc, char* argv[]) {
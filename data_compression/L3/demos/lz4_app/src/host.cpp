@@ -34,7 +34,8 @@ static uint64_t getFileSize(std::ifstream& file) {
     return file_size;
 }
 
-void xilCompressTop(std::string& compress_mod, uint32_t block_size, std::string& compress_bin) {
+void xilCompressTop(
+    std::string& compress_mod, uint32_t block_size, std::string& compress_bin, bool index, uint8_t backend) {
     // Xilinx LZ4 object
     xfLz4 xlz;
 
@@ -43,7 +44,7 @@ void xilCompressTop(std::string& compress_mod, uint32_t block_size, std::string&
     binaryFileName = compress_bin;
 
     // Create xfLz4 object
-    xlz.init(binaryFileName, 1, block_size);
+    xlz.init(binaryFileName, 1, block_size, backend);
 
     std::ifstream inFile(compress_mod.c_str(), std::ifstream::binary);
     if (!inFile) {
@@ -67,6 +68,9 @@ void xilCompressTop(std::string& compress_mod, uint32_t block_size, std::string&
     bool file_list_flag = false;
     uint64_t enbytes = xlz.compressFile(lz_compress_in, lz_compress_out, input_size, file_list_flag, 0);
 
+    // Seek index sidecar for decompress range
+    if (index) xlz.blockIndex().save(lz_compress_out + ".idx");
+
 #ifdef EVENT_PROFILE
     auto total_start = std::chrono::high_resolution_clock::now();
 #endif
@@ -123,7 +127,8 @@ void xilCompressDecompressList(std::string& file_list,
                                bool d_flow,
                                uint32_t block_size,
                                std::string& compress_bin,
-                               std::string& decompress_bin) {
+                               std::string& decompress_bin,
+                               uint8_t backend) {
     // Compression
     // LZ4 Compression Binary Name
     std::string binaryFileName;
@@ -134,7 +139,7 @@ void xilCompressDecompressList(std::string& file_list,
 
     if (c_flow == 0) {
         std::cout << "\n";
-        xlz.init(binaryFileName, 1, block_size);
+        xlz.init(binaryFileName, 1, block_size, backend);
     }
     std::cout << "\n";
 
@@ -201,9 +206,9 @@ void xilCompressDecompressList(std::string& file_list,
     if (d_flow == 0) {
         // Create xfLz4 object
         std::cout << "\n";
-        xlz.init(binaryFileName_decompress, 0, block_size);
+        xlz.init(binaryFileName_decompress, 0, block_size, backend);
         if (c_flow == 1) {
-            xlz.init(binaryFileName, 1, block_size);
+            xlz.init(binaryFileName, 1, block_size, backend);
         }
     }
 
@@ -264,8 +269,12 @@ void xilCompressDecompressList(std::string& file_list,
         xlz.release();
     }
 }
-void xilBatchVerify(
-    std::string& file_list, int f, uint32_t block_size, std::string& compress_bin, std::string& decompress_bin) {
+void xilBatchVerify(std::string& file_list,
+                    int f,
+                    uint32_t block_size,
+                    std::string& compress_bin,
+                    std::string& decompress_bin,
+                    uint8_t backend) {
     if (f == 0) { // All flows are tested (Xilinx, Standard)
 
         // Xilinx LZ4 flow
@@ -275,7 +284,7 @@ void xilBatchVerify(
             // Xilinx LZ4 compression
             std::string ext1 = ".xe2xd.lz4";
             std::string ext2 = ".xe2xd.lz4";
-            xilCompressDecompressList(file_list, ext1, ext2, 0, 0, block_size, compress_bin, decompress_bin);
+            xilCompressDecompressList(file_list, ext1, ext2, 0, 0, block_size, compress_bin, decompress_bin, backend);
 
             // Validate
             std::cout << "\n";
@@ -296,7 +305,7 @@ void xilBatchVerify(
             // Xilinx LZ4 compression
             std::string ext2 = ".xe2sd.lz4";
             std::string ext1 = ".xe2sd.lz4";
-            xilCompressDecompressList(file_list, ext1, ext2, 0, 1, block_size, compress_bin, decompress_bin);
+            xilCompressDecompressList(file_list, ext1, ext2, 0, 1, block_size, compress_bin, decompress_bin, backend);
 
             std::cout << "\n";
             std::cout << "---------------------------------------------------------------------------------------"
@@ -315,7 +324,7 @@ void xilBatchVerify(
             // Standard LZ4 compression
             std::string ext1 = ".se2xd";
             std::string ext2 = ".std.lz4";
-            xilCompressDecompressList(file_list, ext1, ext2, 1, 0, block_size, compress_bin, decompress_bin);
+            xilCompressDecompressList(file_list, ext1, ext2, 1, 0, block_size, compress_bin, decompress_bin, backend);
 
             // Validate
             std::cout << "\n";
@@ -338,7 +347,7 @@ void xilBatchVerify(
             // Xilinx LZ4 compression
             std::string ext1 = ".xe2xd.lz4";
             std::string ext2 = ".xe2xd.lz4";
-            xilCompressDecompressList(file_list, ext1, ext2, 0, 0, block_size, compress_bin, decompress_bin);
+            xilCompressDecompressList(file_list, ext1, ext2, 0, 0, block_size, compress_bin, decompress_bin, backend);
 
             // Validate
             std::cout << "\n";
@@ -359,7 +368,7 @@ void xilBatchVerify(
             // Xilinx LZ4 compression
             std::string ext1 = ".xe2sd.lz4";
             std::string ext2 = ".xe2sd.lz4";
-            xilCompressDecompressList(file_list, ext1, ext2, 0, 1, block_size, compress_bin, decompress_bin);
+            xilCompressDecompressList(file_list, ext1, ext2, 0, 1, block_size, compress_bin, decompress_bin, backend);
 
             // Validate
             std::cout << "\n";
@@ -381,7 +390,7 @@ void xilBatchVerify(
             // Standard LZ4 compression
             std::string ext1 = ".se2xd";
             std::string ext2 = ".std.lz4";
-            xilCompressDecompressList(file_list, ext1, ext2, 1, 0, block_size, compress_bin, decompress_bin);
+            xilCompressDecompressList(file_list, ext1, ext2, 1, 0, block_size, compress_bin, decompress_bin, backend);
 
             // Validate
             std::cout << "\n";
@@ -405,14 +414,57 @@ void xilBatchVerify(
     }
 }
 
-void xilDecompressTop(std::string& decompress_mod, uint32_t block_size, std::string& decompress_bin) {
+void xilDecompressRange(std::string& decompress_mod,
+                        std::string& range,
+                        uint32_t block_size,
+                        std::string& decompress_bin,
+                        uint8_t backend) {
+    // Create xfLz4 object
+    xfLz4 xlz;
+    xlz.init(decompress_bin, 0, block_size, backend);
+
+    // Range is given as offset,length
+    uint64_t offset = strtoull(range.c_str(), nullptr, 10);
+    size_t sep = range.find(',');
+    uint64_t length = (sep == std::string::npos) ? 0 : strtoull(range.c_str() + sep + 1, nullptr, 10);
+
+    xfBlockIndex index;
+    std::string index_file = decompress_mod + ".idx";
+    if (index.load(index_file)) exit(EXIT_FAILURE);
+
+    std::vector<uint8_t> out(length);
+    auto range_start = std::chrono::high_resolution_clock::now();
+    uint64_t debytes = xlz.decompressRangeFile(decompress_mod, index, offset, length, out.data());
+    auto range_end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration<double, std::nano>(range_end - range_start);
+    if (debytes == 0) {
+        std::cout << "Invalid range " << range << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    string lz_range_out = decompress_mod + ".range";
+    std::ofstream outFile(lz_range_out.c_str(), std::ofstream::binary);
+    outFile.write((char*)out.data(), debytes);
+
+    std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:" << (float)debytes * 1000 / duration.count()
+              << std::endl
+              << "Range Size(B)\t\t:" << debytes << std::endl;
+    std::cout << "Output Location: " << lz_range_out.c_str() << std::endl;
+
+    xlz.release();
+}
+
+void xilDecompressTop(std::string& decompress_mod,
+                      uint32_t block_size,
+                      std::string& decompress_bin,
+                      uint8_t backend) {
     // Create xfLz4 object
     xfLz4 xlz;
 
     // LZ4 Decompression Binary Name
     std::string binaryFileName;
     binaryFileName = decompress_bin;
-    xlz.init(binaryFileName, 0, block_size);
+    xlz.init(binaryFileName, 0, block_size, backend);
 
     std::ifstream inFile(decompress_mod.c_str(), std::ifstream::binary);
     if (!inFile) {
@@ -453,7 +505,8 @@ void xilDecompressTop(std::string& decompress_mod, uint32_t block_size, std::str
 void xilCompressDecompressTop(std::string& compress_decompress_mod,
                               uint32_t block_size,
                               std::string& compress_bin,
-                              std::string& decompress_bin) {
+                              std::string& decompress_bin,
+                              uint8_t backend) {
     // Compression
     // LZ4 Compression Binary Name
     std::string binaryFileName = compress_bin;
@@ -461,7 +514,7 @@ void xilCompressDecompressTop(std::string& compress_decompress_mod,
     // Create xfLz4 object
     xfLz4 xlz;
 
-    xlz.init(binaryFileName, 1, block_size);
+    xlz.init(binaryFileName, 1, block_size, backend);
 
     std::cout << "\n";
 
@@ -508,7 +561,7 @@ void xilCompressDecompressTop(std::string& compress_decompress_mod,
     // Create xfLz4 object
     xfLz4 d_xlz;
 
-    d_xlz.init(binaryFileName, 0, block_size);
+    d_xlz.init(binaryFileName, 0, block_size, backend);
 
     std::cout << "\n";
     std::cout << "--------------------------------------------------------------" << std::endl;
@@ -563,6 +616,9 @@ int main(int argc, char* argv[]) {
     parser.addSwitch("--compress_decompress", "-v", "Compress Decompress", "");
     parser.addSwitch("--block_size", "-B", "Compress Block Size [0-64: 1-256: 2-1024: 3-4096]", "0");
     parser.addSwitch("--flow", "-x", "Validation [0-All: 1-XcXd: 2-XcSd: 3-ScXd]", "1");
+    parser.addSwitch("--backend", "-b", "Backend fpga/cpu/auto", "fpga");
+    parser.addSwitch("--index", "-i", "Write block index sidecar", "0");
+    parser.addSwitch("--range", "-r", "Decompress range offset,length", "");
     parser.parse(argc, argv);
 
     std::string compress_bin = parser.value("compress_xclbin");
@@ -573,6 +629,15 @@ int main(int argc, char* argv[]) {
     std::string compress_decompress_mod = parser.value("compress_decompress");
     std::string flow = parser.value("flow");
     std::string block_size = parser.value("block_size");
+    std::string backend_name = parser.value("backend");
+    bool index = (atoi(parser.value("index").c_str()) != 0);
+    std::string range = parser.value("range");
+
+    uint8_t backend = FPGA_BACKEND;
+    if (backend_name == "cpu")
+        backend = CPU_BACKEND;
+    else if (backend_name == "auto")
+        backend = AUTO_BACKEND;
 
     uint32_t bSize = 0;
     // Block Size
@@ -609,14 +674,17 @@ int main(int argc, char* argv[]) {
         fopt = 1;
 
     // "-c" - Compress Mode
-    if (!compress_mod.empty()) xilCompressTop(compress_mod, bSize, compress_bin);
+    if (!compress_mod.empty()) xilCompressTop(compress_mod, bSize, compress_bin, index, backend);
 
-    // "-d" Decompress Mode
-    if (!decompress_mod.empty()) xilDecompressTop(decompress_mod, bSize, decompress_bin);
+    // "-d" Decompress Mode, "-r" decodes a byte range using the sidecar index
+    if (!decompress_mod.empty() && !range.empty())
+        xilDecompressRange(decompress_mod, range, bSize, decompress_bin, backend);
+    else if (!decompress_mod.empty())
+        xilDecompressTop(decompress_mod, bSize, decompress_bin, backend);
 
     // "-v" Compress Decompress Mode
     if (!compress_decompress_mod.empty())
-        xilCompressDecompressTop(compress_decompress_mod, bSize, compress_bin, decompress_bin);
+        xilCompressDecompressTop(compress_decompress_mod, bSize, compress_bin, decompress_bin, backend);
 
     // "-l" List of Files
     if (!filelist.empty()) {
@@ -628,6 +696,6 @@ int main(int argc, char* argv[]) {
             std::cout << "from following source ";
             std::cout << "https://github.com/lz4/lz4.git" << std::endl;
         }
-        xilBatchVerify(filelist, fopt, bSize, compress_bin, decompress_bin);
+        xilBatchVerify(filelist, fopt, bSize, compress_bin, decompress_bin, backend);
     }
 }
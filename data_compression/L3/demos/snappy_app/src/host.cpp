@@ -0,0 +1,336 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "snappy.hpp"
+#include <fstream>
+#include <vector>
+#include "cmdlineparser.h"
+
+using namespace xf::compression;
+
+int validate(std::string& inFile_name, std::string& outFile_name) {
+    std::string command = "cmp " + inFile_name + " " + outFile_name;
+    int ret = system(command.c_str());
+    return ret;
+}
+
+static uint64_t getFileSize(std::ifstream& file) {
+    file.seekg(0, file.end);
+    uint64_t file_size = file.tellg();
+    file.seekg(0, file.beg);
+    return file_size;
+}
+
+void xilCompressTop(std::string& compress_mod, uint32_t block_size, std::string& compress_bin, uint8_t backend) {
+    // Xilinx Snappy object
+    xfSnappy xsnappy;
+
+    // Create xfSnappy object
+    xsnappy.init(compress_bin, 1, block_size, backend);
+
+    std::ifstream inFile(compress_mod.c_str(), std::ifstream::binary);
+    if (!inFile) {
+        std::cout << "Unable to open file";
+        exit(1);
+    }
+    uint64_t input_size = getFileSize(inFile);
+    inFile.close();
+
+    double len = input_size;
+    int order = 0;
+    while (len >= 1000) {
+        order++;
+        len = len / 1000;
+    }
+
+    std::string snappy_compress_in = compress_mod;
+    std::string snappy_compress_out = compress_mod + ".sz";
+
+    bool file_list_flag = false;
+
+    // Call Snappy compression
+    uint64_t enbytes = xsnappy.compressFile(snappy_compress_in, snappy_compress_out, input_size, file_list_flag, 0);
+
+    const char* sizes[] = {"B", "kB", "MB", "GB", "TB"};
+    std::cout << std::setprecision(2) << "SNAPPY_CR\t\t:" << (double)input_size / enbytes << std::endl
+              << std::fixed << std::setprecision(3) << "File Size(" << sizes[order] << ")\t\t:" << len << std::endl
+              << "File Name\t\t:" << snappy_compress_in << std::endl;
+    std::cout << "\n";
+    std::cout << "Output Location: " << snappy_compress_out.c_str() << std::endl;
+    std::cout << "Compressed file size: " << enbytes << std::endl;
+
+    xsnappy.release();
+}
+
+void xilDecompressTop(std::string& decompress_mod, uint32_t block_size, std::string& decompress_bin, uint8_t backend) {
+    // Xilinx Snappy object
+    xfSnappy xsnappy;
+
+    // Create xfSnappy object
+    xsnappy.init(decompress_bin, 0, block_size, backend);
+
+    std::ifstream inFile(decompress_mod.c_str(), std::ifstream::binary);
+    if (!inFile) {
+        std::cout << "Unable to open file";
+        exit(1);
+    }
+    uint64_t input_size = getFileSize(inFile);
+    inFile.close();
+
+    std::string snappy_decompress_in = decompress_mod;
+    std::string snappy_decompress_out = decompress_mod + ".orig";
+
+    bool file_list_flag = false;
+
+    // Call Snappy decompression
+    uint64_t debytes =
+        xsnappy.decompressFile(snappy_decompress_in, snappy_decompress_out, input_size, file_list_flag, 0);
+
+    std::cout << "File Name\t\t:" << snappy_decompress_in << std::endl;
+    std::cout << "\n";
+    std::cout << "Output Location: " << snappy_decompress_out.c_str() << std::endl;
+    std::cout << "Decompressed file size: " << debytes << std::endl;
+
+    xsnappy.release();
+}
+
+void xilValidate(std::string& file_list, std::string& ext) {
+    std::cout << "\n";
+    std::cout << "Status\t\tFile Name" << std::endl;
+    std::cout << "\n";
+
+    std::ifstream infilelist_val(file_list.c_str());
+    std::string line_val;
+
+    while (std::getline(infilelist_val, line_val)) {
+        std::string line_in = line_val;
+        std::string line_out = line_in + ext;
+
+        // Validate input and output files
+        int ret = validate(line_in, line_out);
+        if (ret == 0) {
+            std::cout << "PASSED\t\t" << line_in << std::endl;
+        } else {
+            std::cout << "Validation Failed" << line_out.c_str() << std::endl;
+        }
+    }
+}
+
+// Compresses every file of the list to <file><ext> and decompresses it back
+// to <file><ext>.orig, c_flow/d_flow select Xilinx (0) or standard (1) flow
+void xilCompressDecompressList(std::string& file_list,
+                               std::string& ext,
+                               bool c_flow,
+                               bool d_flow,
+                               uint32_t block_size,
+                               std::string& compress_bin,
+                               std::string& decompress_bin,
+                               uint8_t backend) {
+    bool file_list_flag = true;
+
+    // Compression
+    xfSnappy xsnappy;
+    if (c_flow == 0) xsnappy.init(compress_bin, 1, block_size, backend);
+
+    std::cout << "\n";
+    std::cout << "--------------------------------------------------------------" << std::endl;
+    if (c_flow == 0)
+        std::cout << "                     Xilinx Compress                          " << std::endl;
+    else
+        std::cout << "                     Standard Compress                        " << std::endl;
+    std::cout << "--------------------------------------------------------------" << std::endl;
+
+    std::cout << "\n";
+    if (c_flow == 0)
+        std::cout << "E2E(MBps)\tKT(MBps)\tSNAPPY_CR\tFile Size(MB)\t\tFile Name" << std::endl;
+    else
+        std::cout << "File Size(MB)\t\tFile Name" << std::endl;
+    std::cout << "\n";
+
+    std::ifstream infilelist(file_list.c_str());
+    std::string line;
+
+    // Compress list of files
+    while (std::getline(infilelist, line)) {
+        std::ifstream inFile(line.c_str(), std::ifstream::binary);
+        if (!inFile) {
+            std::cout << "Unable to open file";
+            exit(1);
+        }
+        uint64_t input_size = getFileSize(inFile);
+        inFile.close();
+
+        std::string snappy_compress_out = line + ext;
+
+        // Call Snappy compression
+        uint64_t enbytes = xsnappy.compressFile(line, snappy_compress_out, input_size, file_list_flag, c_flow);
+        if (c_flow == 0) {
+            std::cout << "\t\t" << (double)input_size / enbytes << "\t\t" << std::fixed << std::setprecision(3)
+                      << (double)input_size / 1000000 << "\t\t\t" << line << std::endl;
+        } else {
+            std::cout << std::fixed << std::setprecision(3);
+            std::cout << (double)input_size / 1000000 << "\t\t\t" << line << std::endl;
+        }
+    }
+    if (c_flow == 0) xsnappy.release();
+
+    // De-Compression
+    xfSnappy d_xsnappy;
+    if (d_flow == 0) d_xsnappy.init(decompress_bin, 0, block_size, backend);
+
+    std::cout << "\n";
+    std::cout << "--------------------------------------------------------------" << std::endl;
+    if (d_flow == 0)
+        std::cout << "                     Xilinx De-Compress                       " << std::endl;
+    else
+        std::cout << "                     Standard De-Compress                     " << std::endl;
+    std::cout << "--------------------------------------------------------------" << std::endl;
+
+    std::cout << "\n";
+    if (d_flow == 0)
+        std::cout << "E2E(MBps)\tKT(MBps)\tFile Size(MB)\t\tFile Name" << std::endl;
+    else
+        std::cout << "File Size(MB)\tFile Name" << std::endl;
+    std::cout << "\n";
+
+    std::ifstream infilelist_dec(file_list.c_str());
+    std::string line_dec;
+
+    // Decompress list of files
+    while (std::getline(infilelist_dec, line_dec)) {
+        std::string snappy_decompress_in = line_dec + ext;
+        std::string snappy_decompress_out = snappy_decompress_in + ".orig";
+
+        std::ifstream inFile_dec(snappy_decompress_in.c_str(), std::ifstream::binary);
+        if (!inFile_dec) {
+            std::cout << "Unable to open file";
+            exit(1);
+        }
+        uint64_t input_size = getFileSize(inFile_dec);
+        inFile_dec.close();
+
+        // Call Snappy decompression
+        d_xsnappy.decompressFile(snappy_decompress_in, snappy_decompress_out, input_size, file_list_flag, d_flow);
+
+        if (d_flow == 0) {
+            std::cout << std::fixed << std::setprecision(3) << "\t\t" << (double)input_size / 1000000 << "\t\t"
+                      << snappy_decompress_in << std::endl;
+        } else {
+            std::cout << std::fixed << std::setprecision(3);
+            std::cout << (double)input_size / 1000000 << "\t\t" << snappy_decompress_in << std::endl;
+        }
+    }
+    if (d_flow == 0) d_xsnappy.release();
+
+    // Validate
+    std::cout << "\n";
+    std::cout << "----------------------------------------------------------------------------------------"
+              << std::endl;
+    std::cout << "                       Validate: " << (c_flow ? "Standard" : "Xilinx") << " Compress vs "
+              << (d_flow ? "Standard" : "Xilinx") << " Decompress" << std::endl;
+    std::cout << "----------------------------------------------------------------------------------------"
+              << std::endl;
+    std::string ext_orig = ext + ".orig";
+    xilValidate(file_list, ext_orig);
+}
+
+void xilBatchVerify(std::string& file_list,
+                    int f,
+                    uint32_t block_size,
+                    std::string& compress_bin,
+                    std::string& decompress_bin,
+                    uint8_t backend) {
+    if (f < 0 || f > 3) {
+        std::cout << "-x option is wrong" << f << std::endl;
+        std::cout << "-x - 0 all features" << std::endl;
+        std::cout << "-x - 1 Xilinx (C/D)" << std::endl;
+        std::cout << "-x - 2 Xilinx Compress vs Standard Decompress" << std::endl;
+        std::cout << "-x - 3 Standard Compress vs Xilinx Decompress" << std::endl;
+        return;
+    }
+
+    // Flow : Xilinx Snappy Compress vs Xilinx Snappy Decompress
+    if (f == 0 || f == 1) {
+        std::string ext = ".xe2xd.sz";
+        xilCompressDecompressList(file_list, ext, 0, 0, block_size, compress_bin, decompress_bin, backend);
+    }
+
+    // Flow : Xilinx Snappy Compress vs Standard Snappy Decompress
+    if (f == 0 || f == 2) {
+        std::string ext = ".xe2sd.sz";
+        xilCompressDecompressList(file_list, ext, 0, 1, block_size, compress_bin, decompress_bin, backend);
+    }
+
+    // Flow : Standard Snappy Compress vs Xilinx Snappy Decompress
+    if (f == 0 || f == 3) {
+        std::string ext = ".se2xd.sz";
+        xilCompressDecompressList(file_list, ext, 1, 0, block_size, compress_bin, decompress_bin, backend);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    sda::utils::CmdLineParser parser;
+    parser.addSwitch("--compress_xclbin", "-cx", "Compress XCLBIN", "compress");
+    parser.addSwitch("--decompress_xclbin", "-dx", "DeCompress XCLBIN", "decompress");
+    parser.addSwitch("--compress", "-c", "Compress", "");
+    parser.addSwitch("--file_list", "-l", "List of Input Files", "");
+    parser.addSwitch("--decompress", "-d", "Decompress", "");
+    parser.addSwitch("--block_size", "-B", "Compress Block Size in KB, at most 64", "64");
+    parser.addSwitch("--flow", "-x", "Validation [0-All: 1-XcXd: 2-XcSd: 3-ScXd]", "1");
+    parser.addSwitch("--backend", "-b", "Backend fpga/cpu/auto", "fpga");
+    parser.parse(argc, argv);
+
+    std::string compress_bin = parser.value("compress_xclbin");
+    std::string decompress_bin = parser.value("decompress_xclbin");
+    std::string compress_mod = parser.value("compress");
+    std::string filelist = parser.value("file_list");
+    std::string decompress_mod = parser.value("decompress");
+    std::string flow = parser.value("flow");
+    std::string block_size = parser.value("block_size");
+    std::string backend_name = parser.value("backend");
+
+    uint8_t backend = FPGA_BACKEND;
+    if (backend_name == "cpu")
+        backend = CPU_BACKEND;
+    else if (backend_name == "auto")
+        backend = AUTO_BACKEND;
+
+    // Block Size, Snappy framing format limits chunks to 64KB
+    uint32_t bSize = block_size.empty() ? BLOCK_SIZE_IN_KB : atoi(block_size.c_str());
+    if (bSize == 0 || bSize > 64) {
+        std::cout << "Invalid Block Size provided" << std::endl;
+        parser.printHelp();
+        exit(1);
+    }
+
+    int fopt = flow.empty() ? 1 : atoi(flow.c_str());
+
+    // "-c" - Compress Mode
+    if (!compress_mod.empty()) xilCompressTop(compress_mod, bSize, compress_bin, backend);
+
+    // "-d" Decompress Mode
+    if (!decompress_mod.empty()) xilDecompressTop(decompress_mod, bSize, decompress_bin, backend);
+
+    // "-l" List of Files
+    if (!filelist.empty()) {
+        if (fopt == 0 || fopt == 2 || fopt == 3) {
+            std::cout << "\n" << std::endl;
+            std::cout << "Validation flows with Standard Snappy ";
+            std::cout << "require the python-snappy module (python3 -m snappy)" << std::endl;
+        }
+        xilBatchVerify(filelist, fopt, bSize, compress_bin, decompress_bin, backend);
+    }
+}
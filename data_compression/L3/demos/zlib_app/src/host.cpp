@@ -29,9 +29,10 @@ void xil_compress_decompress_list(std::string& file_list,
                                   int cu,
                                   std::string& single_bin,
                                   uint8_t max_cr,
+                                  uint8_t backend,
                                   enum list_mode mode = COMP_DECOMP) {
     // Create xfZlib object
-    xfZlib xlz(single_bin, max_cr, BOTH);
+    xfZlib xlz(single_bin, max_cr, BOTH, 0, 0, DYNAMIC, backend);
     ERROR_STATUS(xlz.error_code());
 
     if (mode != ONLY_DECOMPRESS) {
@@ -111,7 +112,8 @@ void xil_compress_decompress_list(std::string& file_list,
     }
 }
 
-void xil_batch_verify(std::string& file_list, int cu, enum list_mode mode, std::string& single_bin, uint8_t max_cr) {
+void xil_batch_verify(
+    std::string& file_list, int cu, enum list_mode mode, std::string& single_bin, uint8_t max_cr, uint8_t backend) {
     std::string ext1;
     std::string ext2;
 
@@ -119,7 +121,7 @@ void xil_batch_verify(std::string& file_list, int cu, enum list_mode mode, std::
     ext1 = ".xe2xd.zlib";
     ext2 = ".xe2xd.zlib";
 
-    xil_compress_decompress_list(file_list, ext1, ext2, cu, single_bin, max_cr, mode);
+    xil_compress_decompress_list(file_list, ext1, ext2, cu, single_bin, max_cr, backend, mode);
 
     // Validate
     std::cout << "\n";
@@ -133,9 +135,10 @@ void xil_batch_verify(std::string& file_list, int cu, enum list_mode mode, std::
     xil_validate(file_list, ext3);
 }
 
-void xil_decompress_top(std::string& decompress_mod, int cu, std::string& single_bin, uint8_t max_cr) {
+void xil_decompress_top(
+    std::string& decompress_mod, int cu, std::string& single_bin, uint8_t max_cr, bool stream, uint8_t backend) {
     // Xilinx ZLIB object
-    xfZlib xlz(single_bin, max_cr, DECOMP_ONLY);
+    xfZlib xlz(single_bin, max_cr, DECOMP_ONLY, 0, 0, DYNAMIC, backend);
     ERROR_STATUS(xlz.error_code());
 
     std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:";
@@ -159,17 +162,62 @@ void xil_decompress_top(std::string& decompress_mod, int cu, std::string& single
         len = len / 1000;
     }
 
-    // Call ZLIB compression
+    // Call ZLIB decompression
     // uint32_t enbytes =
-    xlz.decompress_file(lz_decompress_in, lz_decompress_out, input_size, cu);
+    if (stream)
+        xlz.decompress_file_stream(lz_decompress_in, lz_decompress_out, input_size, cu);
+    else
+        xlz.decompress_file(lz_decompress_in, lz_decompress_out, input_size, cu);
     std::cout << std::fixed << std::setprecision(3) << std::endl
               << "File Size(" << sizes[order] << ")\t\t:" << len << std::endl
               << "File Name\t\t:" << lz_decompress_in << std::endl;
 }
 
-void xil_compress_top(std::string& compress_mod, std::string& single_bin, uint8_t max_cr) {
+void xil_decompress_range(
+    std::string& decompress_mod, std::string& range, std::string& single_bin, uint8_t max_cr, uint8_t backend) {
+    // Xilinx ZLIB object
+    xfZlib xlz(single_bin, max_cr, DECOMP_ONLY, 0, 0, DYNAMIC, backend);
+    ERROR_STATUS(xlz.error_code());
+
+    // Range is given as offset,length
+    uint64_t offset = strtoull(range.c_str(), nullptr, 10);
+    size_t sep = range.find(',');
+    uint64_t length = (sep == std::string::npos) ? 0 : strtoull(range.c_str() + sep + 1, nullptr, 10);
+
+    xfBlockIndex index;
+    std::string index_file = decompress_mod + ".idx";
+    if (index.load(index_file)) exit(EXIT_FAILURE);
+
+    std::vector<uint8_t> out(length);
+    auto range_start = std::chrono::high_resolution_clock::now();
+    uint64_t debytes = xlz.decompress_range_file(decompress_mod, index, offset, length, out.data());
+    auto range_end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration<double, std::nano>(range_end - range_start);
+    if (debytes == 0) {
+        std::cout << "Invalid range " << range << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::string range_out = decompress_mod + ".range";
+    std::ofstream outFile(range_out.c_str(), std::ofstream::binary);
+    outFile.write((char*)out.data(), debytes);
+
+    std::cout << std::fixed << std::setprecision(3) << "E2E(MBps)\t\t:" << (float)debytes * 1000 / duration.count()
+              << std::endl
+              << "Range Size(B)\t\t:" << debytes << std::endl
+              << "File Name\t\t:" << decompress_mod << std::endl;
+    std::cout << "\n";
+    std::cout << "Output Location: " << range_out.c_str() << std::endl;
+}
+
+void xil_compress_top(std::string& compress_mod,
+                      std::string& single_bin,
+                      uint8_t max_cr,
+                      bool stream,
+                      bool index,
+                      uint8_t backend) {
     // Xilinx ZLIB object
-    xfZlib xlz(single_bin, max_cr, COMP_ONLY);
+    xfZlib xlz(single_bin, max_cr, COMP_ONLY, 0, 0, DYNAMIC, backend);
     ERROR_STATUS(xlz.error_code());
 
     std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:";
@@ -194,7 +242,14 @@ void xil_compress_top(std::string& compress_mod, std::string& single_bin, uint8_
     }
 
     // Call ZLIB compression
-    uint32_t enbytes = xlz.compress_file(lz_compress_in, lz_compress_out, input_size);
+    uint32_t enbytes = 0;
+    if (stream)
+        enbytes = xlz.compress_file_stream(lz_compress_in, lz_compress_out, input_size);
+    else
+        enbytes = xlz.compress_file(lz_compress_in, lz_compress_out, input_size);
+
+    // Seek index sidecar for decompress range
+    if (index) xlz.block_index().save(lz_compress_out + ".idx");
 
     std::cout.precision(3);
     std::cout << std::fixed << std::setprecision(2) << std::endl
@@ -229,9 +284,12 @@ void xil_validate(std::string& file_list, std::string& ext) {
     }
 }
 
-void xilCompressDecompressTop(std::string& compress_decompress_mod, std::string& single_bin, uint8_t max_cr_val) {
+void xilCompressDecompressTop(std::string& compress_decompress_mod,
+                              std::string& single_bin,
+                              uint8_t max_cr_val,
+                              uint8_t backend) {
     // Create xfZlib object
-    xfZlib xlz(single_bin, max_cr_val, BOTH);
+    xfZlib xlz(single_bin, max_cr_val, BOTH, 0, 0, DYNAMIC, backend);
     ERROR_STATUS(xlz.error_code());
 
     std::cout << "--------------------------------------------------------------" << std::endl;
@@ -333,6 +391,10 @@ int main(int argc, char* argv[]) {
     parser.addSwitch("--file_list", "-l", "List of Input Files", "");
     parser.addSwitch("--cu", "-k", "CU", "0");
     parser.addSwitch("--max_cr", "-mcr", "Maximum CR", "10");
+    parser.addSwitch("--stream", "-s", "Incremental file read/write", "0");
+    parser.addSwitch("--backend", "-b", "Backend fpga/cpu/auto", "fpga");
+    parser.addSwitch("--index", "-i", "Write block index sidecar", "0");
+    parser.addSwitch("--range", "-r", "Decompress range offset,length", "");
     parser.parse(argc, argv);
 
     std::string compress_mod = parser.value("compress");
@@ -342,6 +404,16 @@ int main(int argc, char* argv[]) {
     std::string compress_decompress_mod = parser.value("compress_decompress");
     std::string cu = parser.value("cu");
     std::string mcr = parser.value("max_cr");
+    bool stream = (atoi(parser.value("stream").c_str()) != 0);
+    std::string backend_name = parser.value("backend");
+    bool index = (atoi(parser.value("index").c_str()) != 0);
+    std::string range = parser.value("range");
+
+    uint8_t backend = FPGA_BACKEND;
+    if (backend_name == "cpu")
+        backend = CPU_BACKEND;
+    else if (backend_name == "auto")
+        backend = AUTO_BACKEND;
 
     uint8_t max_cr_val = 0;
     if (!(mcr.empty())) {
@@ -358,7 +430,8 @@ int main(int argc, char* argv[]) {
         cu_run = atoi(cu.c_str());
     }
 
-    if (!compress_decompress_mod.empty()) xilCompressDecompressTop(compress_decompress_mod, single_bin, max_cr_val);
+    if (!compress_decompress_mod.empty())
+        xilCompressDecompressTop(compress_decompress_mod, single_bin, max_cr_val, backend);
 
     if (!filelist.empty()) {
         list_mode lMode;
@@ -370,11 +443,14 @@ int main(int argc, char* argv[]) {
         } else {
             lMode = COMP_DECOMP;
         }
-        xil_batch_verify(filelist, cu_run, lMode, single_bin, max_cr_val);
+        xil_batch_verify(filelist, cu_run, lMode, single_bin, max_cr_val, backend);
     } else if (!compress_mod.empty()) {
         // "-c" - Compress Mode
-        xil_compress_top(compress_mod, single_bin, max_cr_val);
+        xil_compress_top(compress_mod, single_bin, max_cr_val, stream, index, backend);
+    } else if (!decompress_mod.empty() && !range.empty()) {
+        // "-d" with "-r" - Decompress a byte range using the sidecar index
+        xil_decompress_range(decompress_mod, range, single_bin, max_cr_val, backend);
     } else if (!decompress_mod.empty())
         // "-d" - DeCompress Mode
-        xil_decompress_top(decompress_mod, cu_run, single_bin, max_cr_val);
+        xil_decompress_top(decompress_mod, cu_run, single_bin, max_cr_val, stream, backend);
 }
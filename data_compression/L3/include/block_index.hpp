@@ -0,0 +1,270 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/**
+ * @file block_index.hpp
+ * @brief Header for seekable block index of compressed streams
+ *
+ * This file is part of Vitis Data Compression Library host code. Every
+ * block produced by the L3 compress APIs is coded independently, the index
+ * records where each block lives in both compressed and raw stream so a
+ * byte range can be served by decoding only the blocks it overlaps.
+ */
+#ifndef _XFCOMPRESSION_BLOCK_INDEX_HPP_
+#define _XFCOMPRESSION_BLOCK_INDEX_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "host_backend.hpp"
+
+namespace xf {
+namespace compression {
+
+/**
+ * Sidecar index file layout (little endian)
+ * magic "XFIX", version, format, base, block count, block entries
+ */
+const uint32_t c_index_magic = 0x58494658;
+const uint32_t c_index_version = 1;
+
+/**
+ * Stream format described by the index
+ */
+enum index_format { INDEX_DEFLATE = 0, INDEX_LZ4 = 1 };
+
+/**
+ * One independently decodable block
+ */
+struct block_entry {
+    uint64_t comp_offset; // block data offset from start of block stream
+    uint64_t raw_offset;  // uncompressed offset
+    uint32_t comp_size;   // compressed bytes
+    uint32_t raw_size;    // uncompressed bytes
+};
+
+/**
+ *  xfBlockIndex class. Block map of a compressed stream with sidecar
+ * file I/O and parallel range decoding.
+ */
+class xfBlockIndex {
+   public:
+    /**
+     * @brief Reset the index
+     *
+     * @param format INDEX_DEFLATE or INDEX_LZ4
+     */
+    void clear(uint8_t format = INDEX_DEFLATE) {
+        m_format = format;
+        m_base = 0;
+        m_blocks.clear();
+    }
+
+    /**
+     * @brief Append next block, blocks are added in stream order
+     *
+     * @param comp_size compressed size
+     * @param raw_size uncompressed size
+     * @param skip framing bytes between previous block and this one
+     */
+    void add(uint32_t comp_size, uint32_t raw_size, uint32_t skip = 0) {
+        uint64_t comp_offset = skip;
+        if (!m_blocks.empty()) comp_offset += m_blocks.back().comp_offset + m_blocks.back().comp_size;
+        m_blocks.push_back({comp_offset, raw_size_total(), comp_size, raw_size});
+    }
+
+    /**
+     * @brief Bytes preceding the block stream in a file (container header)
+     */
+    void set_base(uint64_t base) { m_base = base; }
+    uint64_t base() const { return m_base; }
+    uint8_t format() const { return m_format; }
+
+    uint32_t size() const { return m_blocks.size(); }
+    const block_entry& operator[](uint32_t idx) const { return m_blocks[idx]; }
+
+    /**
+     * @brief Total uncompressed size covered by the index
+     */
+    uint64_t raw_size_total() const {
+        if (m_blocks.empty()) return 0;
+        return m_blocks.back().raw_offset + m_blocks.back().raw_size;
+    }
+
+    /**
+     * @brief Find blocks overlapping [offset, offset + length)
+     *
+     * @param first first block index
+     * @param last last block index
+     *
+     * @return false when range is empty or past the end
+     */
+    bool find(uint64_t offset, uint64_t length, uint32_t& first, uint32_t& last) const {
+        uint64_t end = std::min(offset + length, raw_size_total());
+        if ((length == 0) || (offset >= end)) return false;
+
+        auto cmp = [](uint64_t val, const block_entry& blk) { return val < blk.raw_offset; };
+        first = std::upper_bound(m_blocks.begin(), m_blocks.end(), offset, cmp) - m_blocks.begin() - 1;
+        last = std::upper_bound(m_blocks.begin(), m_blocks.end(), end - 1, cmp) - m_blocks.begin() - 1;
+        return true;
+    }
+
+    /**
+     * @brief Write index as sidecar file
+     *
+     * @return 0 on success
+     */
+    int save(const std::string& file_name) const {
+        std::ofstream outFile(file_name.c_str(), std::ofstream::binary);
+        if (!outFile) {
+            std::cerr << "Unable to create index file " << file_name << std::endl;
+            return 1;
+        }
+        uint32_t nblocks = m_blocks.size();
+        outFile.write((char*)&c_index_magic, sizeof(c_index_magic));
+        outFile.write((char*)&c_index_version, sizeof(c_index_version));
+        outFile.write((char*)&m_format, sizeof(m_format));
+        outFile.write((char*)&m_base, sizeof(m_base));
+        outFile.write((char*)&nblocks, sizeof(nblocks));
+        for (auto& blk : m_blocks) {
+            outFile.write((char*)&blk.comp_offset, sizeof(blk.comp_offset));
+            outFile.write((char*)&blk.raw_offset, sizeof(blk.raw_offset));
+            outFile.write((char*)&blk.comp_size, sizeof(blk.comp_size));
+            outFile.write((char*)&blk.raw_size, sizeof(blk.raw_size));
+        }
+        return outFile.good() ? 0 : 1;
+    }
+
+    /**
+     * @brief Read index from sidecar file
+     *
+     * @return 0 on success
+     */
+    int load(const std::string& file_name) {
+        std::ifstream inFile(file_name.c_str(), std::ifstream::binary);
+        uint32_t magic = 0, version = 0, nblocks = 0;
+        inFile.read((char*)&magic, sizeof(magic));
+        inFile.read((char*)&version, sizeof(version));
+        if (!inFile || (magic != c_index_magic) || (version != c_index_version)) {
+            std::cerr << "Invalid index file " << file_name << std::endl;
+            return 1;
+        }
+        inFile.read((char*)&m_format, sizeof(m_format));
+        inFile.read((char*)&m_base, sizeof(m_base));
+        inFile.read((char*)&nblocks, sizeof(nblocks));
+        m_blocks.resize(nblocks);
+        for (auto& blk : m_blocks) {
+            inFile.read((char*)&blk.comp_offset, sizeof(blk.comp_offset));
+            inFile.read((char*)&blk.raw_offset, sizeof(blk.raw_offset));
+            inFile.read((char*)&blk.comp_size, sizeof(blk.comp_size));
+            inFile.read((char*)&blk.raw_size, sizeof(blk.raw_size));
+        }
+        return inFile.good() ? 0 : 1;
+    }
+
+    /**
+     * @brief Decode blocks overlapping [offset, offset + length) on a thread
+     * pool. Blocks fully inside the range are decoded in place.
+     *
+     * @param pool host thread pool
+     * @param in compressed bytes following the container header, in[0] is
+     * block stream offset comp_base
+     * @param comp_base block stream offset of in[0]
+     * @param offset uncompressed offset
+     * @param length uncompressed length
+     * @param out output buffer of at least length bytes
+     * @param decode_block bool(src, comp_size, dst, raw_size) block decoder
+     *
+     * @return number of bytes written, 0 on error
+     */
+    template <typename F>
+    uint64_t decode_range(xfThreadPool& pool,
+                          const uint8_t* in,
+                          uint64_t comp_base,
+                          uint64_t offset,
+                          uint64_t length,
+                          uint8_t* out,
+                          F decode_block) const {
+        uint32_t first, last;
+        if (!find(offset, length, first, last)) return 0;
+        uint64_t end = std::min(offset + length, raw_size_total());
+
+        std::atomic<bool> failed{false};
+        pool.parallel_for(last - first + 1, [&](uint32_t i) {
+            const block_entry& blk = m_blocks[first + i];
+            uint64_t lo = std::max(offset, blk.raw_offset);
+            uint64_t hi = std::min(end, blk.raw_offset + blk.raw_size);
+            const uint8_t* src = in + (blk.comp_offset - comp_base);
+
+            if ((lo == blk.raw_offset) && (hi == blk.raw_offset + blk.raw_size)) {
+                if (!decode_block(src, blk.comp_size, out + (lo - offset), blk.raw_size)) failed = true;
+            } else {
+                // Range starts or ends inside this block
+                std::vector<uint8_t> tmp(blk.raw_size);
+                if (!decode_block(src, blk.comp_size, tmp.data(), blk.raw_size))
+                    failed = true;
+                else
+                    std::memcpy(out + (lo - offset), tmp.data() + (lo - blk.raw_offset), hi - lo);
+            }
+        });
+        if (failed) {
+            std::cerr << "Block decode failed" << std::endl;
+            return 0;
+        }
+        return end - offset;
+    }
+
+    /**
+     * @brief Same as decode_range but only the compressed span of the
+     * overlapping blocks is read from file
+     */
+    template <typename F>
+    uint64_t decode_range_file(xfThreadPool& pool,
+                               const std::string& inFile_name,
+                               uint64_t offset,
+                               uint64_t length,
+                               uint8_t* out,
+                               F decode_block) const {
+        uint32_t first, last;
+        if (!find(offset, length, first, last)) return 0;
+
+        uint64_t comp_base = m_blocks[first].comp_offset;
+        uint64_t span = m_blocks[last].comp_offset + m_blocks[last].comp_size - comp_base;
+        std::vector<uint8_t> in(span);
+
+        std::ifstream inFile(inFile_name.c_str(), std::ifstream::binary);
+        inFile.seekg(m_base + comp_base, inFile.beg);
+        inFile.read((char*)in.data(), span);
+        if (!inFile) {
+            std::cerr << "Unable to read " << inFile_name << std::endl;
+            return 0;
+        }
+        return decode_range(pool, in.data(), comp_base, offset, length, out, decode_block);
+    }
+
+   private:
+    uint8_t m_format = INDEX_DEFLATE;
+    uint64_t m_base = 0;
+    std::vector<block_entry> m_blocks;
+};
+
+} // end namespace compression
+} // end namespace xf
+#endif // _XFCOMPRESSION_BLOCK_INDEX_HPP_
@@ -0,0 +1,184 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/**
+ * @file chunk_chain.hpp
+ * @brief Header for growable output buffer made of page aligned chunks
+ *
+ * This file is part of Vitis Data Compression Library host code. When the
+ * decompressed size is not known upfront, output is streamed into a chain of
+ * chunks allocated on demand instead of a buffer sized by guessing the
+ * compression ratio. Chunks grow geometrically so large outputs need few
+ * allocations, pages of the last chunk are only touched once written.
+ */
+#ifndef _XFCOMPRESSION_CHUNK_CHAIN_HPP_
+#define _XFCOMPRESSION_CHUNK_CHAIN_HPP_
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+namespace xf {
+namespace compression {
+
+/**
+ * Default size of first chunk and maximum chunk size
+ */
+const uint64_t c_chain_min_chunk = 64 * 1024;
+const uint64_t c_chain_max_chunk = 16 * 1024 * 1024;
+
+/**
+ *  xfChunkChain class. Append only byte buffer made of page aligned
+ * chunks, data is written in place through tail()/commit().
+ */
+class xfChunkChain {
+   public:
+    /**
+     * @brief Constructor, no memory is allocated until first write
+     *
+     * @param first_chunk size of first chunk
+     * @param max_chunk chunk size stops doubling at this size
+     */
+    xfChunkChain(uint64_t first_chunk = c_chain_min_chunk, uint64_t max_chunk = c_chain_max_chunk)
+        : m_next_chunk(first_chunk), m_max_chunk(std::max(first_chunk, max_chunk)) {}
+
+    ~xfChunkChain() { clear(); }
+
+    xfChunkChain(const xfChunkChain&) = delete;
+    xfChunkChain& operator=(const xfChunkChain&) = delete;
+
+    /**
+     * @brief Writable space at end of chain, a new chunk is allocated when
+     * the last one is full
+     *
+     * @param avail number of writable bytes at returned pointer
+     */
+    uint8_t* tail(uint64_t& avail) {
+        if (m_chunks.empty() || (m_chunks.back().size == m_chunks.back().capacity)) _grow();
+        chunk_t& last = m_chunks.back();
+        avail = last.capacity - last.size;
+        return last.data + last.size;
+    }
+
+    /**
+     * @brief Account bytes written at tail()
+     */
+    void commit(uint64_t size) {
+        m_chunks.back().size += size;
+        m_size += size;
+    }
+
+    /**
+     * @brief Copy bytes to end of chain
+     */
+    void append(const uint8_t* data, uint64_t size) {
+        while (size > 0) {
+            uint64_t avail;
+            uint8_t* dst = tail(avail);
+            uint64_t len = std::min(avail, size);
+            std::memcpy(dst, data, len);
+            commit(len);
+            data += len;
+            size -= len;
+        }
+    }
+
+    /**
+     * @brief Total bytes held by the chain
+     */
+    uint64_t size() const { return m_size; }
+
+    /**
+     * @brief Number of chunks and their content
+     */
+    uint32_t count() const { return m_chunks.size(); }
+    const uint8_t* chunk(uint32_t idx) const { return m_chunks[idx].data; }
+    uint64_t chunk_size(uint32_t idx) const { return m_chunks[idx].size; }
+
+    /**
+     * @brief Copy chain content to a contiguous buffer
+     *
+     * @param offset chain offset to start from
+     * @param out output buffer
+     * @param size number of bytes to copy
+     *
+     * @return number of bytes copied
+     */
+    uint64_t copy(uint64_t offset, uint8_t* out, uint64_t size) const {
+        uint64_t done = 0;
+        for (auto& c : m_chunks) {
+            if (done == size) break;
+            if (offset >= c.size) {
+                offset -= c.size;
+                continue;
+            }
+            uint64_t len = std::min(c.size - offset, size - done);
+            std::memcpy(out + done, c.data + offset, len);
+            done += len;
+            offset = 0;
+        }
+        return done;
+    }
+
+    /**
+     * @brief Write chain content to a stream
+     *
+     * @return 0 on success
+     */
+    int write(std::ostream& os) const {
+        for (auto& c : m_chunks) os.write((const char*)c.data, c.size);
+        return os.good() ? 0 : 1;
+    }
+
+    /**
+     * @brief Release all chunks
+     */
+    void clear() {
+        for (auto& c : m_chunks) free(c.data);
+        m_chunks.clear();
+        m_size = 0;
+    }
+
+   private:
+    struct chunk_t {
+        uint8_t* data;
+        uint64_t capacity;
+        uint64_t size;
+    };
+
+    void _grow() {
+        uint64_t page = sysconf(_SC_PAGESIZE);
+        uint64_t capacity = (m_next_chunk + page - 1) / page * page;
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, page, capacity)) throw std::bad_alloc();
+        m_chunks.push_back({(uint8_t*)ptr, capacity, 0});
+        m_next_chunk = std::min(m_next_chunk * 2, m_max_chunk);
+    }
+
+    std::vector<chunk_t> m_chunks;
+    uint64_t m_size = 0;
+    uint64_t m_next_chunk;
+    uint64_t m_max_chunk;
+};
+
+} // end namespace compression
+} // end namespace xf
+#endif // _XFCOMPRESSION_CHUNK_CHAIN_HPP_
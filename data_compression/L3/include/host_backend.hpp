@@ -0,0 +1,217 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/**
+ * @file host_backend.hpp
+ * @brief Header for backend selection and host thread pool
+ *
+ * This file is part of Vitis Data Compression Library host code, it is used
+ * by the L3 classes to run block compression on CPU cores when no device is
+ * available.
+ */
+#ifndef _XFCOMPRESSION_HOST_BACKEND_HPP_
+#define _XFCOMPRESSION_HOST_BACKEND_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "xcl2.hpp"
+
+/**
+ * Backend used by the L3 classes
+ * FPGA_BACKEND: xclbin and device are mandatory
+ * CPU_BACKEND: blocks are processed on a host thread pool
+ * AUTO_BACKEND: FPGA when a Xilinx device and the xclbin are found, CPU otherwise
+ */
+enum host_backend { FPGA_BACKEND = 0, CPU_BACKEND = 1, AUTO_BACKEND = 2 };
+
+namespace xf {
+namespace compression {
+
+/**
+ * @brief Resolve AUTO_BACKEND without terminating on missing
+ * OpenCL platform, device or xclbin.
+ *
+ * @param binaryFile xclbin file name
+ * @param backend requested backend
+ *
+ * @return FPGA_BACKEND or CPU_BACKEND
+ */
+inline uint8_t select_backend(const std::string& binaryFile, uint8_t backend) {
+    if (backend != AUTO_BACKEND) return backend;
+    if (access(binaryFile.c_str(), R_OK) != 0) return CPU_BACKEND;
+
+    std::vector<cl::Platform> platforms;
+    if (cl::Platform::get(&platforms) != CL_SUCCESS) return CPU_BACKEND;
+
+    for (size_t i = 0; i < platforms.size(); i++) {
+        cl_int err;
+        std::string platformName = platforms[i].getInfo<CL_PLATFORM_NAME>(&err);
+        if ((err != CL_SUCCESS) || (platformName != "Xilinx")) continue;
+
+        std::vector<cl::Device> devices;
+        err = platforms[i].getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices);
+        if ((err == CL_SUCCESS) && !devices.empty()) return FPGA_BACKEND;
+    }
+    return CPU_BACKEND;
+}
+
+/**
+ *  xfThreadPool class. Work stealing thread pool used by the CPU backend.
+ * Every worker owns a task queue, it pops from the back of its own queue
+ * and steals from the front of the others once it runs dry.
+ */
+class xfThreadPool {
+   public:
+    /**
+     * @brief Start worker threads
+     *
+     * @param num_threads worker count, 0 means all hardware threads
+     */
+    explicit xfThreadPool(uint32_t num_threads = 0) {
+        if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = 1;
+
+        for (uint32_t i = 0; i < num_threads; i++) m_queues.emplace_back(new task_queue);
+        for (uint32_t i = 0; i < num_threads; i++) m_workers.emplace_back(&xfThreadPool::_run, this, i);
+    }
+
+    /**
+     * @brief Drain the queues and join the workers
+     */
+    ~xfThreadPool() {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stop = true;
+        }
+        m_task_cv.notify_all();
+        for (auto& worker : m_workers) worker.join();
+    }
+
+    /**
+     * @brief Queue a task, tasks are spread round robin over the workers
+     *
+     * @param task callable to be executed
+     */
+    void submit(std::function<void()> task) {
+        uint32_t qidx = m_next++ % m_queues.size();
+        m_pending++;
+        {
+            std::lock_guard<std::mutex> lock(m_queues[qidx]->lock);
+            m_queues[qidx]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_queued++;
+        }
+        m_task_cv.notify_one();
+    }
+
+    /**
+     * @brief Wait for all submitted tasks, must not be called from a task
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_done_cv.wait(lock, [this] { return m_pending == 0; });
+    }
+
+    /**
+     * @brief Run func(0) .. func(count - 1) on the pool and wait for them
+     *
+     * @param count number of invocations
+     * @param func callable taking the invocation index
+     */
+    template <typename F>
+    void parallel_for(uint32_t count, F func) {
+        for (uint32_t i = 0; i < count; i++) submit([func, i] { func(i); });
+        wait();
+    }
+
+    /**
+     * @brief Number of worker threads
+     */
+    uint32_t size() const { return m_workers.size(); }
+
+   private:
+    struct task_queue {
+        std::mutex lock;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    bool _pop(uint32_t id, std::function<void()>& task) {
+        uint32_t nqueues = m_queues.size();
+        for (uint32_t i = 0; i < nqueues; i++) {
+            uint32_t qidx = (id + i) % nqueues;
+            std::lock_guard<std::mutex> lock(m_queues[qidx]->lock);
+            auto& tasks = m_queues[qidx]->tasks;
+            if (tasks.empty()) continue;
+
+            // Own queue is LIFO to keep caches warm, steals are FIFO
+            if (i == 0) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+            } else {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void _run(uint32_t id) {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_task_cv.wait(lock, [this] { return m_stop || m_queued > 0; });
+                if (m_queued == 0) return;
+                m_queued--;
+            }
+            // A queued task is reserved above so pop can only fail on a race
+            // with another worker stealing it, retry until found
+            while (!_pop(id, task)) std::this_thread::yield();
+            task();
+
+            if (--m_pending == 0) {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_done_cv.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<task_queue> > m_queues;
+    std::vector<std::thread> m_workers;
+    std::mutex m_lock;
+    std::condition_variable m_task_cv;
+    std::condition_variable m_done_cv;
+    std::atomic<uint64_t> m_pending{0};
+    std::atomic<uint32_t> m_next{0};
+    uint64_t m_queued = 0;
+    bool m_stop = false;
+};
+
+} // end namespace compression
+} // end namespace xf
+#endif // _XFCOMPRESSION_HOST_BACKEND_HPP_
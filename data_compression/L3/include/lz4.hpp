@@ -26,6 +26,8 @@
 
 #include <iomanip>
 #include "xcl2.hpp"
+#include "host_backend.hpp"
+#include "block_index.hpp"
 
 /**
  * Maximum compute units supported
@@ -66,8 +68,12 @@ class xfLz4 {
      * @brief Initialize the class object.
      *
      * @param binaryFile file to be read
+     * @param flow compress (1) or decompress (0) kernels
+     * @param block_size_kb block size in KB
+     * @param backend FPGA_BACKEND, CPU_BACKEND or AUTO_BACKEND, CPU backend
+     * codes the blocks on a host thread pool with the same block framing
      */
-    int init(const std::string& binaryFile, uint8_t flow, uint32_t block_size_kb);
+    int init(const std::string& binaryFile, uint8_t flow, uint32_t block_size_kb, uint8_t backend = FPGA_BACKEND);
 
     /**
      * @brief release
@@ -130,6 +136,85 @@ class xfLz4 {
     uint64_t compressFile(
         std::string& inFile_name, std::string& outFile_name, uint64_t actual_size, bool file_list_flag, bool m_flow);
 
+    /**
+     * @brief Block index of the last compress run, compressFile sets its
+     * base to the frame header size so it can be saved as sidecar
+     */
+    xfBlockIndex& blockIndex();
+
+    /**
+     * @brief Decode only the blocks overlapping an uncompressed byte range,
+     * blocks are decoded in parallel on host threads
+     *
+     * @param in compressed frame including header
+     * @param index block index of the frame
+     * @param offset uncompressed offset
+     * @param length uncompressed length
+     * @param out output buffer of at least length bytes
+     *
+     * @return number of bytes written, 0 on error or empty range
+     */
+    uint64_t decompressRange(
+        const uint8_t* in, const xfBlockIndex& index, uint64_t offset, uint64_t length, uint8_t* out);
+
+    /**
+     * @brief Same as decompressRange, only compressed bytes of the needed
+     * blocks are read from the file
+     *
+     * @param inFile_name compressed file name
+     * @param index block index of the file, usually loaded from sidecar
+     * @param offset uncompressed offset
+     * @param length uncompressed length
+     * @param out output buffer of at least length bytes
+     */
+    uint64_t decompressRangeFile(
+        const std::string& inFile_name, const xfBlockIndex& index, uint64_t offset, uint64_t length, uint8_t* out);
+
+    /**
+     * @brief Load a preset dictionary used by compressBatch and
+     * decompressBatch, only its last 64KB can be referenced and their
+     * positions are hashed once here
+     *
+     * @param dict dictionary bytes, nullptr clears the dictionary
+     * @param dict_size dictionary size
+     */
+    void setDictionary(const uint8_t* dict, uint32_t dict_size);
+
+    /**
+     * @brief Compress many small messages in one call, every message is
+     * coded as an independent LZ4 block which may reference the preset
+     * dictionary. Without dictionary the FPGA backend packs one message
+     * per block slot of the host buffer so a kernel invocation codes up to
+     * HOST_BUFFER_SIZE / block size messages, otherwise messages are coded
+     * on the host thread pool.
+     *
+     * @param in message pointers
+     * @param in_size message sizes
+     * @param count number of messages
+     * @param out output, messages are packed back to back, needs
+     * in_size[i] + in_size[i] / 255 + 16 bytes per message
+     * @param out_size compressed size of each message
+     *
+     * @return total output size, 0 on error
+     */
+    uint64_t compressBatch(
+        const uint8_t* const* in, const uint32_t* in_size, uint32_t count, uint8_t* out, uint32_t* out_size);
+
+    /**
+     * @brief Decompress messages produced by compressBatch on the host
+     * thread pool, the same preset dictionary has to be loaded
+     *
+     * @param in compressed messages packed back to back
+     * @param in_size compressed size of each message
+     * @param count number of messages
+     * @param out output pointer of each message
+     * @param out_size original size of each message
+     *
+     * @return total decompressed size, 0 on error
+     */
+    uint64_t decompressBatch(
+        const uint8_t* in, const uint32_t* in_size, uint32_t count, uint8_t* const* out, const uint32_t* out_size);
+
     /**
      * @brief Class constructor
      *
@@ -142,6 +227,32 @@ class xfLz4 {
     ~xfLz4();
 
    private:
+    uint64_t _compress_cpu(uint8_t* in, uint8_t* out, uint64_t input_size, uint32_t host_buffer_size);
+    uint64_t _decompress_cpu(uint8_t* in, uint8_t* out, uint64_t input_size, uint64_t original_size);
+    uint64_t _compress_batch_fpga(
+        const uint8_t* const* in, const uint32_t* in_size, uint32_t count, uint8_t* out, uint32_t* out_size);
+
+    /**
+     * Backend in use, FPGA_BACKEND or CPU_BACKEND
+     */
+    uint8_t m_backend = FPGA_BACKEND;
+
+    /**
+     * Host thread pool for CPU backend
+     */
+    std::unique_ptr<xfThreadPool> m_pool;
+
+    /**
+     * Blocks of last compressed frame
+     */
+    xfBlockIndex m_index;
+
+    /**
+     * Preset dictionary and hash table of its positions
+     */
+    std::vector<uint8_t> m_dict;
+    std::vector<uint32_t> m_dictTable;
+
     /**
      * Block Size
      */
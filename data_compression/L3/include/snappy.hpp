@@ -0,0 +1,243 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/**
+ * @file snappy.hpp
+ * @brief Header for Snappy host functionality
+ *
+ * This file is part of Vitis Data Compression Library host code for snappy compression.
+ */
+
+#ifndef _XFCOMPRESSION_SNAPPY_HPP_
+#define _XFCOMPRESSION_SNAPPY_HPP_
+
+#include <iomanip>
+#include "xcl2.hpp"
+#include "host_backend.hpp"
+
+/**
+ * Maximum compute units supported
+ */
+#if (C_COMPUTE_UNIT > D_COMPUTE_UNIT)
+#define MAX_COMPUTE_UNITS C_COMPUTE_UNIT
+#else
+#define MAX_COMPUTE_UNITS D_COMPUTE_UNIT
+#endif
+
+/**
+ * Maximum host buffer used to operate per kernel invocation
+ */
+#define HOST_BUFFER_SIZE (2 * 1024 * 1024)
+
+/**
+ * Default block size
+ */
+#ifndef BLOCK_SIZE_IN_KB
+#define BLOCK_SIZE_IN_KB 64
+#endif
+/**
+ * Value below is used to associate with
+ * Overlapped buffers, ideally overlapped
+ * execution requires 2 resources per invocation
+ */
+#define OVERLAP_BUF_COUNT 2
+
+namespace xf {
+namespace compression {
+/**
+ *  xfSnappy class. Class containing methods for Snappy compression and
+ * decompression to be executed on host side. Output follows the Snappy
+ * framing format, every block is one chunk carrying the masked CRC-32C of
+ * its uncompressed data.
+ */
+class xfSnappy {
+   public:
+    /**
+     * @brief Initialize the class object.
+     *
+     * @param binaryFile file to be read
+     * @param flow compress (1) or decompress (0) kernels
+     * @param block_size_kb block size in KB, framing format limits chunks to 64KB
+     * @param backend FPGA_BACKEND, CPU_BACKEND or AUTO_BACKEND, CPU backend
+     * codes the blocks on a host thread pool with the same framing
+     */
+    int init(const std::string& binaryFile, uint8_t flow, uint32_t block_size_kb, uint8_t backend = FPGA_BACKEND);
+
+    /**
+     * @brief release
+     *
+     */
+    int release();
+
+    /**
+     * @brief Compress a buffer to a framed stream, host buffer size chunks
+     * are distributed over the compute units and host to device transfers
+     * overlap kernel execution.
+     *
+     * @param in input byte sequence
+     * @param out output byte sequence, needs compressBound(actual_size) bytes
+     * @param actual_size input size
+     * @param host_buffer_size host buffer size
+     * @param file_list_flag print throughput in file list format
+     *
+     * @return framed stream size
+     */
+    uint64_t compress(uint8_t* in, uint8_t* out, uint64_t actual_size, uint32_t host_buffer_size, bool file_list_flag);
+
+    /**
+     * @brief Decompress a framed stream, chunk CRCs are verified.
+     *
+     * @param in input byte sequence
+     * @param out output byte sequence
+     * @param actual_size input size
+     * @param original_size original size, see originalSize
+     * @param host_buffer_size host buffer size
+     * @param file_list_flag print throughput in file list format
+     *
+     * @return original size, 0 on malformed stream or CRC mismatch
+     */
+    uint64_t decompress(uint8_t* in,
+                        uint8_t* out,
+                        uint64_t actual_size,
+                        uint64_t original_size,
+                        uint32_t host_buffer_size,
+                        bool file_list_flag);
+
+    /**
+     * @brief This module is provided to support compress API and
+     * it's not recommended to use for high throughput.
+     *
+     * @param inFile_name input file name
+     * @param outFile_name output file name
+     * @param actual_size input size
+     * @param file_list_flag print throughput in file list format
+     * @param m_flow Xilinx (0) or standard (1) flow
+     */
+    uint64_t compressFile(
+        std::string& inFile_name, std::string& outFile_name, uint64_t actual_size, bool file_list_flag, bool m_flow);
+
+    /**
+     * @brief This module is provided to support decompress API and
+     * it's not recommended to use for high throughput.
+     *
+     * @param inFile_name input file name
+     * @param outFile_name output file name
+     * @param actual_size input size
+     * @param file_list_flag print throughput in file list format
+     * @param m_flow Xilinx (0) or standard (1) flow
+     */
+    uint64_t decompressFile(
+        std::string& inFile_name, std::string& outFile_name, uint64_t actual_size, bool file_list_flag, bool m_flow);
+
+    /**
+     * @brief Worst case framed stream size
+     *
+     * @param input_size input size
+     */
+    uint64_t compressBound(uint64_t input_size);
+
+    /**
+     * @brief Original size of a framed stream, only chunk headers and the
+     * preamble of compressed chunks are read
+     *
+     * @param in framed stream
+     * @param input_size framed stream size
+     *
+     * @return original size, 0 on malformed stream
+     */
+    uint64_t originalSize(const uint8_t* in, uint64_t input_size);
+
+    /**
+     * @brief Class constructor
+     *
+     */
+    xfSnappy();
+
+    /**
+     * @brief Class destructor.
+     */
+    ~xfSnappy();
+
+   private:
+    /**
+     * Data chunk of a framed stream
+     */
+    struct chunk_t {
+        uint64_t in_idx;
+        uint64_t out_idx;
+        uint32_t compressed_size;
+        uint32_t block_size;
+        uint32_t crc;
+        bool compressed;
+    };
+
+    bool _parse_chunks(const uint8_t* in, uint64_t input_size, std::vector<chunk_t>& chunks);
+    uint64_t _compress_cpu(uint8_t* in, uint8_t* out, uint64_t input_size);
+    uint64_t _decompress_cpu(uint8_t* in, uint8_t* out, const std::vector<chunk_t>& chunks);
+    uint64_t _decompress_fpga(
+        uint8_t* in, uint8_t* out, const std::vector<chunk_t>& chunks, uint32_t host_buffer_size, uint64_t& kernel_time);
+
+    /**
+     * Backend in use, FPGA_BACKEND or CPU_BACKEND
+     */
+    uint8_t m_backend = FPGA_BACKEND;
+
+    /**
+     * Host thread pool for CPU backend
+     */
+    std::unique_ptr<xfThreadPool> m_pool;
+
+    /**
+     * Block Size
+     */
+    uint32_t m_BlockSizeInKb;
+
+    /**
+     * Binary flow compress/decompress
+     */
+    bool m_BinFlow;
+
+    /**
+     * Switch between FPGA/Standard flows
+     */
+    bool m_SwitchFlow;
+
+    cl::Program* m_program;
+    cl::Context* m_context;
+    cl::CommandQueue* m_q;
+    cl::Kernel* compress_kernel_snappy[C_COMPUTE_UNIT];
+    cl::Kernel* decompress_kernel_snappy[D_COMPUTE_UNIT];
+
+    // Compression related
+    std::vector<uint8_t, aligned_allocator<uint8_t> > h_buf_in[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    std::vector<uint8_t, aligned_allocator<uint8_t> > h_buf_out[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    std::vector<uint32_t, aligned_allocator<uint8_t> > h_blksize[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    std::vector<uint32_t, aligned_allocator<uint8_t> > h_compressSize[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+
+    // Device buffers
+    cl::Buffer* buffer_input[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    cl::Buffer* buffer_output[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    cl::Buffer* buffer_compressed_size[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    cl::Buffer* buffer_block_size[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+
+    // Kernel names
+    std::vector<std::string> compress_kernel_names = {"xilSnappyCompress"};
+    std::vector<std::string> decompress_kernel_names = {"xilSnappyDecompress"};
+};
+
+} // end namespace compression
+} // end namespace xf
+#endif // _XFCOMPRESSION_SNAPPY_HPP_
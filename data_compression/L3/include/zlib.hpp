@@ -30,6 +30,9 @@
 #include <fstream>
 #include <thread>
 #include "xcl2.hpp"
+#include "host_backend.hpp"
+#include "block_index.hpp"
+#include "chunk_chain.hpp"
 #include <sys/stat.h>
 #include <random>
 #include <new>
@@ -190,6 +193,8 @@ struct zlib_aligned_allocator {
     void deallocate(T* p, std::size_t num) { free(p); }
 };
 
+struct z_stream_s;
+
 namespace xf {
 namespace compression {
 
@@ -223,6 +228,37 @@ class xfZlib {
 
     uint32_t decompress(uint8_t* in, uint8_t* out, uint32_t actual_size, int cu_run);
 
+    /**
+     * @brief Decompress when the original size is known, e.g. from the
+     * block index recorded at compression time. Output buffer is sized
+     * exactly instead of input size times maximum compression ratio.
+     *
+     * @param in input byte sequence
+     * @param out output byte sequence of original_size bytes
+     * @param input_size input size
+     * @param original_size original size
+     * @param cu_run compute unit number
+     *
+     * @return decompressed size, 0 on error or when output exceeds
+     * original_size
+     */
+    uint64_t decompress_exact(uint8_t* in, uint8_t* out, uint64_t input_size, uint64_t original_size, int cu_run);
+
+    /**
+     * @brief Decompress when the original size is unknown. Output is
+     * streamed through the incremental decompression APIs into a chain of
+     * page aligned chunks grown on demand, so no output capacity is guessed
+     * and no compression ratio limit applies.
+     *
+     * @param in input byte sequence
+     * @param input_size input size
+     * @param out chunk chain, decompressed data is appended
+     * @param cu_run compute unit number
+     *
+     * @return decompressed size, 0 on error
+     */
+    uint64_t decompress_chain(uint8_t* in, uint64_t input_size, xfChunkChain& out, int cu_run);
+
     /**
      * @brief In shared library flow this call can be used for compress buffer
      * in overlapped manner. This is used in libz.so created.
@@ -260,7 +296,9 @@ class xfZlib {
 
     /**
      * @brief This method  does file operations and invokes decompress API which
-     * internally does zlib decompression on FPGA in overlapped manner
+     * internally does zlib decompression on FPGA in overlapped manner. Output
+     * is sized from the <inFile_name>.idx sidecar when present (see
+     * block_index), otherwise it is collected with decompress_chain.
      *
      * @param inFile_name input file name
      * @param outFile_name output file name
@@ -270,10 +308,125 @@ class xfZlib {
 
     uint32_t decompress_file(std::string& inFile_name, std::string& outFile_name, uint64_t input_size, int cu_run);
 
+    /**
+     * @brief This method does file operations and invokes incremental
+     * compression APIs, input file is read in HOST_BUFFER_SIZE pieces so
+     * host memory usage doesn't depend on the file size
+     *
+     * @param inFile_name input file name
+     * @param outFile_name output file name
+     * @param input_size input size
+     */
+
+    uint64_t compress_file_stream(std::string& inFile_name, std::string& outFile_name, uint64_t input_size);
+
+    /**
+     * @brief This method does file operations and invokes incremental
+     * decompression APIs, input file is read in INPUT_BUFFER_SIZE pieces and
+     * output is written as soon as the data reader kernel returns it
+     *
+     * @param inFile_name input file name
+     * @param outFile_name output file name
+     * @param input_size input size
+     * @param cu_run compute unit number
+     */
+
+    uint64_t decompress_file_stream(std::string& inFile_name,
+                                    std::string& outFile_name,
+                                    uint64_t input_size,
+                                    int cu_run);
+
+    /**
+     * @brief Reset incremental compression state. Input pushed afterwards
+     * is staged directly in the compress host buffers which are cycled
+     * across C_COMPUTE_UNIT * OVERLAP_BUF_COUNT kernel invocations
+     *
+     */
+    void compress_stream_init();
+
+    /**
+     * @brief Push input bytes into incremental compression. Kernels are
+     * launched as soon as a host buffer worth of data is gathered.
+     *
+     * @param in input byte sequence
+     * @param input_size input size
+     *
+     * @return number of bytes consumed, less than input_size when all the
+     * host buffers are in flight and compress_stream_pull has to be called
+     */
+    uint64_t compress_stream_push(const uint8_t* in, uint64_t input_size);
+
+    /**
+     * @brief Pull compressed bytes in input order. Waits on the oldest
+     * kernel invocation in flight, partial reads are resumed on next call.
+     *
+     * @param out output byte sequence
+     * @param out_size output buffer capacity
+     *
+     * @return number of bytes written, 0 once all pushed data has been
+     * pulled (and the end of stream block when finish was called)
+     */
+    uint64_t compress_stream_pull(uint8_t* out, uint64_t out_size);
+
+    /**
+     * @brief Mark end of input. Launches the last partially filled host
+     * buffer, the following pulls drain the pipeline and end with the
+     * Z_SYNC_FLUSH block written by compress().
+     *
+     */
+    void compress_stream_finish();
+
+    /**
+     * @brief Prepare incremental decompression on a compute unit. The data
+     * writer, decompress and data reader kernels are started, total
+     * compressed size is needed as the decompress kernel takes it upfront.
+     *
+     * @param input_size total compressed size including header
+     * @param cu_run compute unit number
+     *
+     * @return 0 on success
+     */
+    int decompress_stream_init(uint64_t input_size, int cu_run);
+
+    /**
+     * @brief Push compressed bytes. First push must carry the complete
+     * zlib/gzip header which is validated as in decompress().
+     *
+     * @param in input byte sequence
+     * @param input_size input size
+     *
+     * @return number of bytes consumed, less than input_size when both
+     * DIN_BUFFERCOUNT buffers are still being consumed by the device
+     */
+    uint64_t decompress_stream_push(const uint8_t* in, uint64_t input_size);
+
+    /**
+     * @brief Pull decompressed bytes. Doesn't block while input is still
+     * expected, once all input is pushed it waits for the next data reader
+     * buffer.
+     *
+     * @param out output byte sequence
+     * @param out_size output buffer capacity
+     *
+     * @return number of bytes written, 0 after all input is pushed means
+     * end of stream
+     */
+    uint64_t decompress_stream_pull(uint8_t* out, uint64_t out_size);
+
+    /**
+     * @brief Wait for decompress kernel and release per stream resources
+     *
+     * @return total number of decompressed bytes
+     */
+    uint64_t decompress_stream_finish();
+
     uint64_t get_event_duration_ns(const cl::Event& event);
 
     /**
      * @brief Constructor responsible for creating various host/device buffers.
+     * With CPU_BACKEND (or AUTO_BACKEND and no usable device) no OpenCL
+     * object is created, BLOCK_SIZE_IN_KB blocks are deflated on a host
+     * thread pool with the same framing the kernels produce.
      *
      */
     xfZlib(const std::string& binaryFile,
@@ -281,7 +434,8 @@ class xfZlib {
            uint8_t cd_flow = BOTH,
            uint8_t device_id = 0,
            uint8_t profile = 0,
-           uint8_t d_type = DYNAMIC);
+           uint8_t d_type = DYNAMIC,
+           uint8_t backend = FPGA_BACKEND);
 
     /**
      * @brief OpenCL setup initialization
@@ -306,15 +460,124 @@ class xfZlib {
      */
     int error_code(void);
 
+    /**
+     * @brief Backend in use, FPGA_BACKEND or CPU_BACKEND
+     */
+    uint8_t backend(void);
+
+    /**
+     * @brief Block index of the last compress or compress_stream run.
+     * compress_file and compress_file_stream set its base to the header
+     * size so it can be saved as sidecar of the output file.
+     */
+    xfBlockIndex& block_index(void);
+
+    /**
+     * @brief Decompress only the blocks overlapping an uncompressed byte
+     * range, blocks are inflated in parallel on host threads
+     *
+     * @param in compressed stream including zlib/gzip header
+     * @param index block index of the stream
+     * @param offset uncompressed offset
+     * @param length uncompressed length
+     * @param out output buffer of at least length bytes
+     *
+     * @return number of bytes written, 0 on error or empty range
+     */
+    uint64_t decompress_range(
+        const uint8_t* in, const xfBlockIndex& index, uint64_t offset, uint64_t length, uint8_t* out);
+
+    /**
+     * @brief Same as decompress_range, only compressed bytes of the needed
+     * blocks are read from the file
+     *
+     * @param inFile_name compressed file name
+     * @param index block index of the file, usually loaded from sidecar
+     * @param offset uncompressed offset
+     * @param length uncompressed length
+     * @param out output buffer of at least length bytes
+     */
+    uint64_t decompress_range_file(
+        const std::string& inFile_name, const xfBlockIndex& index, uint64_t offset, uint64_t length, uint8_t* out);
+
+    /**
+     * @brief Load a preset dictionary used by compress_batch and
+     * decompress_batch, only its last 32KB can be referenced by deflate
+     *
+     * @param dict dictionary bytes, nullptr clears the dictionary
+     * @param dict_size dictionary size
+     */
+    void set_dictionary(const uint8_t* dict, uint32_t dict_size);
+
+    /**
+     * @brief Compress many small messages in one call. Every message
+     * becomes an independent zlib stream, with the FDICT flag and the
+     * dictionary adler32 in its header when a dictionary is loaded.
+     * Without dictionary the FPGA backend packs one message per block
+     * slot of the host buffer so a kernel invocation codes up to
+     * HOST_BUFFER_SIZE / block size messages. Kernels have no dictionary
+     * port, so with a dictionary, or on the CPU backend, messages are
+     * spread over the host thread pool and every worker reuses one
+     * deflate state.
+     *
+     * @param in message pointers
+     * @param in_size message sizes
+     * @param count number of messages
+     * @param out output, messages are packed back to back, needs
+     * compressBound(in_size[i]) + 4 bytes per message
+     * @param out_size compressed size of each message
+     *
+     * @return total output size, 0 on error
+     */
+    uint64_t compress_batch(
+        const uint8_t* const* in, const uint32_t* in_size, uint32_t count, uint8_t* out, uint32_t* out_size);
+
+    /**
+     * @brief Decompress messages produced by compress_batch, the preset
+     * dictionary is applied when a stream asks for it
+     *
+     * @param in compressed messages packed back to back
+     * @param in_size compressed size of each message
+     * @param count number of messages
+     * @param out output pointer of each message
+     * @param out_size original size of each message
+     *
+     * @return total decompressed size, 0 on error
+     */
+    uint64_t decompress_batch(
+        const uint8_t* in, const uint32_t* in_size, uint32_t count, uint8_t* const* out, const uint32_t* out_size);
+
    private:
     void _enqueue_writes(uint32_t bufSize, uint8_t* in, uint32_t inputSize, int cu);
-    void _enqueue_reads(uint32_t bufSize, uint8_t* out, uint32_t* decompSize, int cu, uint32_t max_outbuf);
+    void _enqueue_reads(uint32_t bufSize, uint8_t* out, uint32_t* decompSize, int cu, uint64_t max_outbuf);
+    int _check_header(const uint8_t* in);
+    void _compress_stream_launch(uint32_t slot);
+    void _decompress_stream_write(uint8_t cbf_idx, uint32_t size);
+    void _decompress_stream_read(uint8_t cbf_idx);
+    uint64_t _compress_cpu(const uint8_t* in, uint8_t* out, uint64_t input_size);
+    uint64_t _compress_batch_fpga(
+        const uint8_t* const* in, const uint32_t* in_size, uint32_t count, uint8_t* out, uint32_t* out_size);
+    uint32_t _decompress_cpu(const uint8_t* in, uint8_t* out, uint64_t input_size, uint64_t max_outbuf_size);
+    uint32_t _decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int cu, uint64_t max_outbuf_size);
 
     uint8_t m_cdflow;
     bool m_isProfile;
     uint8_t m_deviceid = 0;
     uint8_t m_max_cr = MAX_CR;
     int m_err_code = 0;
+    uint8_t m_backend = FPGA_BACKEND;
+
+    // CPU backend
+    std::unique_ptr<xfThreadPool> m_pool;
+    std::vector<uint8_t> m_cpu_in;
+    std::vector<uint8_t> m_cpu_out;
+    z_stream_s* m_dstrm_zs = nullptr;
+
+    // Blocks of last compressed stream
+    xfBlockIndex m_index;
+
+    // Preset dictionary of compress_batch/decompress_batch
+    std::vector<uint8_t> m_dict;
 
     cl::Device m_device;
     cl::Context* m_context = nullptr;
@@ -364,6 +627,39 @@ class xfZlib {
     cl::Buffer* buffer_dec_zlib_output[DOUT_BUFFERCOUNT] = {nullptr};
     cl::Buffer* buffer_dec_compress_size[MAX_DDCOMP_UNITS];
 
+    // Incremental compression state, a slot is one (cu, flag) host buffer
+    uint32_t m_cstrm_fill = 0;
+    uint32_t m_cstrm_head = 0;
+    uint32_t m_cstrm_tail = 0;
+    uint32_t m_cstrm_inflight = 0;
+    uint32_t m_cstrm_blk = 0;
+    uint32_t m_cstrm_off = 0;
+    uint8_t m_cstrm_trailer = 0;
+    bool m_cstrm_finish = false;
+    uint32_t m_cstrm_size[C_COMPUTE_UNIT * OVERLAP_BUF_COUNT];
+    cl::Event m_cstrm_event[C_COMPUTE_UNIT * OVERLAP_BUF_COUNT];
+
+    // Incremental decompression state
+    int m_dstrm_cu = 0;
+    uint64_t m_dstrm_in_size = 0;
+    uint64_t m_dstrm_in_done = 0;
+    uint64_t m_dstrm_out_done = 0;
+    uint32_t m_dstrm_inbuf_size = 0;
+    uint32_t m_dstrm_outbuf_size = 0;
+    uint32_t m_dstrm_wfill = 0;
+    uint32_t m_dstrm_widx = 0;
+    uint32_t m_dstrm_ridx = 0;
+    uint32_t m_dstrm_roff = 0;
+    uint32_t m_dstrm_rsize = 0;
+    bool m_dstrm_started = false;
+    bool m_dstrm_rvalid = false;
+    bool m_dstrm_last = false;
+    bool m_dstrm_done = false;
+    cl::Event m_dstrm_wevent[DIN_BUFFERCOUNT];
+    cl::Event m_dstrm_revent[DOUT_BUFFERCOUNT];
+    cl::Buffer* m_dstrm_size_buf[DOUT_BUFFERCOUNT] = {nullptr};
+    cl::Buffer* m_dstrm_status_buf = nullptr;
+
     // Kernel names
     std::vector<std::string> compress_kernel_names = {"xilLz77Compress"};
     std::vector<std::string> huffman_kernel_names = {"xilHuffmanKernel"};
@@ -0,0 +1,125 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/**
+ * @file zlib_dispatch.hpp
+ * @brief Header for accelerator dispatch of the libz.so entry points
+ *
+ * This file is part of Vitis Data Compression Library host code. deflate()
+ * and inflate() of the bundled zlib hand large one shot streams to this
+ * dispatcher, everything else stays on the software path.
+ */
+#ifndef _XFCOMPRESSION_ZLIB_DISPATCH_HPP_
+#define _XFCOMPRESSION_ZLIB_DISPATCH_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "zlib.hpp"
+
+namespace xf {
+namespace compression {
+
+/**
+ * Default xclbin used when XILINX_LIBZ_XCLBIN is not set
+ */
+const std::string c_libz_xclbin = "/opt/Xilinx/zlib/u50_gen3x16_xdma_201920_3.xclbin";
+
+/**
+ *  xfZlibDispatch class. Process wide owner of the device used by libz.so.
+ * One xfZlib object per direction is opened on first use and kept for the
+ * life of the process. Device calls made by concurrent application threads
+ * are queued, whichever thread finds the device idle runs every queued call
+ * back to back as one batch while the others wait for their result.
+ *
+ * Configuration is read once from the environment:
+ * XILINX_LIBZ_XCLBIN xclbin path, MIN_INPUT_SIZE smallest stream sent to the
+ * device (default 1MB), XILINX_CU_ID decompress compute unit.
+ */
+class xfZlibDispatch {
+   public:
+    /**
+     * @brief Process wide dispatcher
+     */
+    static xfZlibDispatch& instance();
+
+    /**
+     * @brief Smallest input handed to the device, UINT64_MAX when no
+     * xclbin is available
+     */
+    uint64_t threshold() const { return m_threshold; }
+
+    /**
+     * @brief Compress on the device
+     *
+     * @param in input byte sequence
+     * @param input_size input size
+     * @param out raw deflate blocks ending with a final block are appended
+     *
+     * @return compressed size, 0 when the software path has to be used
+     */
+    uint64_t deflate(const uint8_t* in, uint64_t input_size, xfChunkChain& out);
+
+    /**
+     * @brief Decompress a zlib stream on the device
+     *
+     * @param in zlib stream
+     * @param input_size stream size
+     * @param out decompressed data is appended
+     *
+     * @return decompressed size, 0 when the software path has to be used
+     */
+    uint64_t inflate(const uint8_t* in, uint64_t input_size, xfChunkChain& out);
+
+   private:
+    /**
+     * Device call queued by an application thread
+     */
+    struct job_t {
+        bool compress;
+        const uint8_t* in;
+        uint64_t input_size;
+        xfChunkChain* out;
+        uint64_t result;
+        bool done;
+    };
+
+    xfZlibDispatch();
+    uint64_t _submit(job_t& job);
+    void _run(job_t& job);
+    xfZlib* _open(bool compress);
+
+    std::string m_xclbin;
+    uint64_t m_threshold = UINT64_MAX;
+    int m_cu = 0;
+
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::deque<job_t*> m_queue;
+    bool m_busy = false;
+
+    // Devices are only touched by the thread running a batch
+    std::unique_ptr<xfZlib> m_comp;
+    std::unique_ptr<xfZlib> m_decomp;
+    bool m_comp_failed = false;
+    bool m_decomp_failed = false;
+    std::vector<uint8_t, zlib_aligned_allocator<uint8_t> > m_cbuf;
+};
+
+} // end namespace compression
+} // end namespace xf
+#endif // _XFCOMPRESSION_ZLIB_DISPATCH_HPP_
@@ -34,6 +34,176 @@ using namespace xf::compression;
 #define MAX_NUMBER_BLOCKS (HOST_BUFFER_SIZE / (BLOCK_SIZE_IN_KB * 1024))
 namespace lz4_specs = xf::compression;
 
+// LZ4 block format limits
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MFLIMIT 12
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_LOG 12
+
+static inline uint32_t lz4Read32(const uint8_t* ptr) {
+    uint32_t val;
+    std::memcpy(&val, ptr, 4);
+    return val;
+}
+
+static inline uint32_t lz4Hash(uint32_t val) {
+    return (val * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static inline uint32_t lz4PutLength(uint8_t* out, uint32_t len) {
+    uint32_t outIdx = 0;
+    for (; len >= 255; len -= 255) out[outIdx++] = 255;
+    out[outIdx++] = len;
+    return outIdx;
+}
+
+// Greedy hash chain-less LZ4 block encoder used by the CPU backend,
+// returns 0 when the encoded block doesn't fit in out_size. Positions are
+// counted from the start of the optional preset dictionary, dict_table
+// holds the hashed dictionary positions.
+static uint32_t lz4BlockCompress(const uint8_t* in,
+                                 uint32_t in_size,
+                                 uint8_t* out,
+                                 uint32_t out_size,
+                                 const uint8_t* dict = nullptr,
+                                 uint32_t dict_size = 0,
+                                 const uint32_t* dict_table = nullptr) {
+    uint32_t table[1 << LZ4_HASH_LOG];
+    if (dict_table)
+        std::memcpy(table, dict_table, sizeof(table));
+    else
+        std::memset(table, 0xFF, sizeof(table));
+
+    auto byteAt = [&](uint32_t pos) { return (pos < dict_size) ? dict[pos] : in[pos - dict_size]; };
+    auto read32At = [&](uint32_t pos) {
+        if (pos >= dict_size) return lz4Read32(&in[pos - dict_size]);
+        if (pos + 4 <= dict_size) return lz4Read32(&dict[pos]);
+        uint8_t seq[4];
+        for (uint32_t k = 0; k < 4; k++) seq[k] = byteAt(pos + k);
+        return lz4Read32(seq);
+    };
+
+    uint32_t end = dict_size + in_size;
+    uint32_t ip = dict_size, anchor = dict_size, op = 0;
+    if (in_size > LZ4_MFLIMIT) {
+        uint32_t limit = end - LZ4_MFLIMIT;
+        uint32_t match_limit = end - LZ4_LAST_LITERALS;
+        while (ip < limit) {
+            uint32_t seq = lz4Read32(&in[ip - dict_size]);
+            uint32_t hash = lz4Hash(seq);
+            uint32_t ref = table[hash];
+            table[hash] = ip;
+            if ((ref == 0xFFFFFFFF) || (ip - ref > LZ4_MAX_OFFSET) || (read32At(ref) != seq)) {
+                // Skip faster over incompressible data
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            // Extend match backwards and forwards
+            while ((ip > anchor) && (ref > 0) && (in[ip - 1 - dict_size] == byteAt(ref - 1))) {
+                ip--;
+                ref--;
+            }
+            uint32_t mlen = LZ4_MIN_MATCH;
+            while ((ip + mlen < match_limit) && (in[ip + mlen - dict_size] == byteAt(ref + mlen))) mlen++;
+
+            uint32_t lit = ip - anchor;
+            if (op + 1 + lit / 255 + 1 + lit + 2 + (mlen - LZ4_MIN_MATCH) / 255 + 1 > out_size) return 0;
+
+            uint8_t* token = &out[op++];
+            *token = ((lit < 15) ? lit : 15) << 4;
+            if (lit >= 15) op += lz4PutLength(&out[op], lit - 15);
+            std::memcpy(&out[op], &in[anchor - dict_size], lit);
+            op += lit;
+
+            uint32_t offset = ip - ref;
+            out[op++] = offset;
+            out[op++] = offset >> 8;
+
+            uint32_t mcode = mlen - LZ4_MIN_MATCH;
+            *token |= (mcode < 15) ? mcode : 15;
+            if (mcode >= 15) op += lz4PutLength(&out[op], mcode - 15);
+
+            ip += mlen;
+            anchor = ip;
+            if (ip < limit) table[lz4Hash(lz4Read32(&in[ip - 2 - dict_size]))] = ip - 2;
+        }
+    }
+
+    // Last literals
+    uint32_t lit = end - anchor;
+    if (op + 1 + lit / 255 + 1 + lit > out_size) return 0;
+    out[op++] = ((lit < 15) ? lit : 15) << 4;
+    if (lit >= 15) op += lz4PutLength(&out[op], lit - 15);
+    std::memcpy(&out[op], &in[anchor - dict_size], lit);
+    op += lit;
+    return op;
+}
+
+// LZ4 block decoder used by the CPU backend, returns decoded size
+// or -1 on a malformed block
+static int64_t lz4BlockDecompress(const uint8_t* in,
+                                  uint32_t in_size,
+                                  uint8_t* out,
+                                  uint32_t out_size,
+                                  const uint8_t* dict = nullptr,
+                                  uint32_t dict_size = 0) {
+    uint32_t ip = 0, op = 0;
+    while (ip < in_size) {
+        uint8_t token = in[ip++];
+
+        uint32_t lit = token >> 4;
+        if (lit == 15) {
+            uint8_t val;
+            do {
+                if (ip >= in_size) return -1;
+                val = in[ip++];
+                lit += val;
+            } while (val == 255);
+        }
+        if ((ip + lit > in_size) || (op + lit > out_size)) return -1;
+        std::memcpy(&out[op], &in[ip], lit);
+        ip += lit;
+        op += lit;
+
+        // Last sequence has literals only
+        if (ip == in_size) break;
+
+        if (ip + 2 > in_size) return -1;
+        uint32_t offset = in[ip] | (in[ip + 1] << 8);
+        ip += 2;
+        if ((offset == 0) || (offset > op + dict_size)) return -1;
+
+        uint32_t mlen = token & 15;
+        if (mlen == 15) {
+            uint8_t val;
+            do {
+                if (ip >= in_size) return -1;
+                val = in[ip++];
+                mlen += val;
+            } while (val == 255);
+        }
+        mlen += LZ4_MIN_MATCH;
+        if (op + mlen > out_size) return -1;
+
+        // Overlapping copy replicates the last offset bytes
+        if (offset > op) {
+            // Match starts in the preset dictionary and may run into output
+            for (uint32_t i = 0; i < mlen; i++) {
+                uint32_t back = offset - i;
+                out[op + i] = (back > op) ? dict[dict_size - (back - op)] : out[op + i - offset];
+            }
+        } else if (offset >= mlen) {
+            std::memcpy(&out[op], &out[op - offset], mlen);
+        } else {
+            for (uint32_t i = 0; i < mlen; i++) out[op + i] = out[op + i - offset];
+        }
+        op += mlen;
+    }
+    return op;
+}
+
 // Get the duration of input event
 uint64_t getEventDurationNs(const cl::Event& event) {
     uint64_t start_time = 0, end_time = 0;
@@ -116,6 +286,8 @@ uint64_t xfLz4::compressFile(
         outFile.put((uint8_t)(xxh >> 8));
         // LZ4 overlap & multiple compute unit compress
         enbytes = compress(in.data(), out.data(), input_size, host_buffer_size, file_list_flag);
+        // Block stream follows the 15 byte frame header
+        m_index.set_base(15);
         // Writing compressed data
         outFile.write((char*)out.data(), enbytes);
 
@@ -160,7 +332,16 @@ xfLz4::xfLz4() {
 // Destructor
 xfLz4::~xfLz4() {}
 
-int xfLz4::init(const std::string& binaryFile, uint8_t flow, uint32_t block_size_kb) {
+int xfLz4::init(const std::string& binaryFile, uint8_t flow, uint32_t block_size_kb, uint8_t backend) {
+    m_backend = select_backend(binaryFile, backend);
+    if (m_backend == CPU_BACKEND) {
+        m_BlockSizeInKb = block_size_kb;
+        m_BinFlow = flow;
+        m_pool.reset(new xfThreadPool());
+        std::cout << "Using CPU backend, threads=" << m_pool->size() << std::endl;
+        return 0;
+    }
+
     // unsigned fileBufSize;
     // The get_xil_devices will return vector of Xilinx Devices
     std::vector<cl::Device> devices = xcl::get_xil_devices();
@@ -208,6 +389,11 @@ int xfLz4::init(const std::string& binaryFile, uint8_t flow, uint32_t block_size
 }
 
 int xfLz4::release() {
+    if (m_backend == CPU_BACKEND) {
+        m_pool.reset();
+        return 0;
+    }
+
     if (m_BinFlow) {
         for (uint32_t i = 0; i < C_COMPUTE_UNIT; i++) {
             if (compress_kernel_lz4[i]) {
@@ -321,6 +507,19 @@ uint64_t xfLz4::decompress(uint8_t* in,
                            uint64_t original_size,
                            uint32_t host_buffer_size,
                            bool file_list_flag) {
+    if (m_backend == CPU_BACKEND) {
+        auto total_start = std::chrono::high_resolution_clock::now();
+        uint64_t debytes = _decompress_cpu(in, out, input_size, original_size);
+        auto total_end = std::chrono::high_resolution_clock::now();
+        auto total_time_ns = std::chrono::duration<double, std::nano>(total_end - total_start);
+        float throughput_in_mbps_1 = (float)original_size * 1000 / total_time_ns.count();
+        if (file_list_flag == 0)
+            std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:" << throughput_in_mbps_1 << std::endl;
+        else
+            std::cout << std::fixed << std::setprecision(2) << throughput_in_mbps_1 << "\t\t-";
+        return debytes;
+    }
+
     uint32_t max_num_blks = (host_buffer_size) / (m_BlockSizeInKb * 1024);
 
     for (uint32_t i = 0; i < MAX_COMPUTE_UNITS; i++) {
@@ -745,6 +944,20 @@ uint64_t xfLz4::decompress(uint8_t* in,
 // overlapped with Kernel execution between multiple compute units
 uint64_t xfLz4::compress(
     uint8_t* in, uint8_t* out, uint64_t input_size, uint32_t host_buffer_size, bool file_list_flag) {
+    m_index.clear(INDEX_LZ4);
+    if (m_backend == CPU_BACKEND) {
+        auto total_start = std::chrono::high_resolution_clock::now();
+        uint64_t enbytes = _compress_cpu(in, out, input_size, host_buffer_size);
+        auto total_end = std::chrono::high_resolution_clock::now();
+        auto total_time_ns = std::chrono::duration<double, std::nano>(total_end - total_start);
+        float throughput_in_mbps_1 = (float)input_size * 1000 / total_time_ns.count();
+        if (file_list_flag == 0)
+            std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:" << throughput_in_mbps_1 << std::endl;
+        else
+            std::cout << std::fixed << std::setprecision(2) << throughput_in_mbps_1 << "\t\t-";
+        return enbytes;
+    }
+
     // printf("host_buffer_size %d \n", host_buffer_size);
     uint32_t max_num_blks = (host_buffer_size) / (m_BlockSizeInKb * 1024);
 
@@ -889,6 +1102,7 @@ uint64_t xfLz4::compress(
                         std::memcpy(&out[outIdx], (h_buf_out[cu][flag]).data() + bIdx * block_size_in_bytes,
                                     compressed_size);
                         outIdx += compressed_size;
+                        m_index.add(compressed_size, block_size, 4);
                     } else {
                         if (block_size == block_size_in_bytes) {
                             out[outIdx++] = 0;
@@ -911,6 +1125,7 @@ uint64_t xfLz4::compress(
                         }
                         std::memcpy(&out[outIdx], &in[brick_flag_idx * host_buffer_size + index], block_size);
                         outIdx += block_size;
+                        m_index.add(block_size, block_size, 4);
                     } // End of else - uncompressed stream update
                 }
             }
@@ -1012,6 +1227,7 @@ uint64_t xfLz4::compress(
                     outIdx += 4;
                     std::memcpy(&out[outIdx], &h_buf_out[cu][flag].data()[bIdx * block_size_in_bytes], compressed_size);
                     outIdx += compressed_size;
+                    m_index.add(compressed_size, block_size, 4);
                 } else {
                     if (block_size == block_size_in_bytes) {
                         out[outIdx++] = 0;
@@ -1039,6 +1255,7 @@ uint64_t xfLz4::compress(
                     }
                     std::memcpy(&out[outIdx], &in[brick_flag_idx * host_buffer_size + index], block_size);
                     outIdx += block_size;
+                    m_index.add(block_size, block_size, 4);
                 } // End of else - uncompressed stream update
 
             } // For loop ends
@@ -1085,3 +1302,350 @@ uint64_t xfLz4::compress(
 
     return outIdx;
 } // Overlap end
+
+// CPU backend compression, blocks are encoded on the host thread pool and
+// framed exactly as the overlapped compress flow above
+uint64_t xfLz4::_compress_cpu(uint8_t* in, uint8_t* out, uint64_t input_size, uint32_t host_buffer_size) {
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
+    uint64_t nblocks = (input_size + block_size_in_bytes - 1) / block_size_in_bytes;
+
+    // Blocks are handled in waves to bound the temporary memory
+    uint32_t wave = m_pool->size() * 8;
+    std::vector<uint8_t> blk_out((uint64_t)wave * block_size_in_bytes);
+    std::vector<uint32_t> blk_csize(wave);
+    uint64_t outIdx = 0;
+
+    for (uint64_t blk = 0; blk < nblocks; blk += wave) {
+        uint32_t count = wave;
+        if (blk + count > nblocks) count = nblocks - blk;
+
+        m_pool->parallel_for(count, [&](uint32_t i) {
+            uint64_t index = (blk + i) * block_size_in_bytes;
+            uint32_t block_size = block_size_in_bytes;
+            if (index + block_size > input_size) block_size = input_size - index;
+
+            // Only encodings smaller than the block are worth keeping
+            blk_csize[i] = lz4BlockCompress(&in[index], block_size, &blk_out[(uint64_t)i * block_size_in_bytes],
+                                            block_size - 1);
+        });
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t index = (blk + i) * block_size_in_bytes;
+            uint32_t block_size = block_size_in_bytes;
+            if (index + block_size > input_size) block_size = input_size - index;
+            uint32_t compressed_size = blk_csize[i];
+
+            // Chunk smaller than a block is stored, same as device flow
+            uint64_t chunk_start = (index / host_buffer_size) * host_buffer_size;
+            uint64_t orig_chunk_size = host_buffer_size;
+            if (chunk_start + orig_chunk_size > input_size) orig_chunk_size = input_size - chunk_start;
+
+            if (compressed_size != 0 && compressed_size < block_size && orig_chunk_size >= block_size) {
+                std::memcpy(&out[outIdx], &compressed_size, 4);
+                outIdx += 4;
+                std::memcpy(&out[outIdx], &blk_out[(uint64_t)i * block_size_in_bytes], compressed_size);
+                outIdx += compressed_size;
+                m_index.add(compressed_size, block_size, 4);
+            } else {
+                if (block_size == block_size_in_bytes) {
+                    out[outIdx++] = 0;
+                    out[outIdx++] = 0;
+
+                    if (block_size == lz4_specs::MAX_BSIZE_64KB)
+                        out[outIdx++] = lz4_specs::BSIZE_NCOMP_64;
+                    else if (block_size == lz4_specs::MAX_BSIZE_256KB)
+                        out[outIdx++] = lz4_specs::BSIZE_NCOMP_256;
+                    else if (block_size == lz4_specs::MAX_BSIZE_1024KB)
+                        out[outIdx++] = lz4_specs::BSIZE_NCOMP_1024;
+                    else if (block_size == lz4_specs::MAX_BSIZE_4096KB)
+                        out[outIdx++] = lz4_specs::BSIZE_NCOMP_4096;
+
+                    out[outIdx++] = lz4_specs::NO_COMPRESS_BIT;
+                } else {
+                    std::memcpy(&out[outIdx], &block_size, 3);
+                    outIdx += 3;
+                    out[outIdx++] = lz4_specs::NO_COMPRESS_BIT;
+                }
+                std::memcpy(&out[outIdx], &in[index], block_size);
+                outIdx += block_size;
+                m_index.add(block_size, block_size, 4);
+            }
+        }
+    }
+    return outIdx;
+}
+
+xfBlockIndex& xfLz4::blockIndex() {
+    return m_index;
+}
+
+// Stored blocks are recognised by compressed size equal to block size
+static bool lz4DecodeBlock(const uint8_t* src, uint32_t comp_size, uint8_t* dst, uint32_t raw_size) {
+    if (comp_size == raw_size) {
+        std::memcpy(dst, src, raw_size);
+        return true;
+    }
+    return lz4BlockDecompress(src, comp_size, dst, raw_size) == raw_size;
+}
+
+// Blocks are decoded on host threads as the decompress kernels
+// consume a whole frame
+uint64_t xfLz4::decompressRange(
+    const uint8_t* in, const xfBlockIndex& index, uint64_t offset, uint64_t length, uint8_t* out) {
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+    return index.decode_range(*m_pool, in + index.base(), 0, offset, length, out, lz4DecodeBlock);
+}
+
+uint64_t xfLz4::decompressRangeFile(
+    const std::string& inFile_name, const xfBlockIndex& index, uint64_t offset, uint64_t length, uint8_t* out) {
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+    return index.decode_range_file(*m_pool, inFile_name, offset, length, out, lz4DecodeBlock);
+}
+
+// CPU backend decompression, block headers are parsed serially and
+// the blocks are decoded in parallel straight to their output offset
+uint64_t xfLz4::_decompress_cpu(uint8_t* in, uint8_t* out, uint64_t input_size, uint64_t original_size) {
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
+    uint64_t nblocks = (original_size + block_size_in_bytes - 1) / block_size_in_bytes;
+    std::vector<uint64_t> blk_in(nblocks);
+    std::vector<uint32_t> blk_csize(nblocks);
+
+    uint64_t inIdx = 0;
+    for (uint64_t blk = 0; blk < nblocks; blk++) {
+        uint32_t compressed_size = 0;
+        if (inIdx + 4 > input_size) {
+            std::cerr << "Truncated block header" << std::endl;
+            return 0;
+        }
+        std::memcpy(&compressed_size, &in[inIdx], 4);
+        inIdx += 4;
+
+        uint32_t tmp = compressed_size;
+        tmp >>= 24;
+
+        if (tmp == lz4_specs::NO_COMPRESS_BIT) {
+            uint8_t b3 = compressed_size >> 16;
+            if (b3 == lz4_specs::BSIZE_NCOMP_64 || b3 == lz4_specs::BSIZE_NCOMP_4096 ||
+                b3 == lz4_specs::BSIZE_NCOMP_256 || b3 == lz4_specs::BSIZE_NCOMP_1024) {
+                compressed_size = block_size_in_bytes;
+            } else {
+                compressed_size &= 0xFFFFFF;
+            }
+        }
+
+        if (inIdx + compressed_size > input_size) {
+            std::cerr << "Truncated block data" << std::endl;
+            return 0;
+        }
+        blk_in[blk] = inIdx;
+        blk_csize[blk] = compressed_size;
+        inIdx += compressed_size;
+    }
+
+    std::atomic<bool> failed{false};
+    uint32_t ntasks = m_pool->size() * 4;
+    if (ntasks > nblocks) ntasks = nblocks;
+    m_pool->parallel_for(ntasks, [&](uint32_t task) {
+        for (uint64_t blk = task; blk < nblocks; blk += ntasks) {
+            uint64_t index = blk * block_size_in_bytes;
+            uint32_t block_size = block_size_in_bytes;
+            if (index + block_size > original_size) block_size = original_size - index;
+            uint32_t compressed_size = blk_csize[blk];
+
+            if (compressed_size < block_size) {
+                int64_t size = lz4BlockDecompress(&in[blk_in[blk]], compressed_size, &out[index], block_size);
+                if (size != block_size) failed = true;
+            } else if (compressed_size == block_size) {
+                // No compression block
+                std::memcpy(&out[index], &in[blk_in[blk]], block_size);
+            } else {
+                failed = true;
+            }
+        }
+    });
+
+    if (failed) {
+        std::cerr << "Corrupted LZ4 block" << std::endl;
+        return 0;
+    }
+    return original_size;
+}
+
+void xfLz4::setDictionary(const uint8_t* dict, uint32_t dict_size) {
+    // Older bytes are out of LZ4 offset range
+    if (dict == nullptr) dict_size = 0;
+    if (dict_size > LZ4_MAX_OFFSET) {
+        dict += dict_size - LZ4_MAX_OFFSET;
+        dict_size = LZ4_MAX_OFFSET;
+    }
+    m_dict.assign(dict, dict + dict_size);
+    m_dictTable.clear();
+    if (dict_size == 0) return;
+
+    m_dictTable.resize(1 << LZ4_HASH_LOG, 0xFFFFFFFF);
+    for (uint32_t pos = 0; pos + 4 <= dict_size; pos++) m_dictTable[lz4Hash(lz4Read32(&m_dict[pos]))] = pos;
+}
+
+// Every task owns a contiguous range of messages, messages are written at
+// worst case offsets and compacted afterwards
+uint64_t xfLz4::compressBatch(
+    const uint8_t* const* in, const uint32_t* in_size, uint32_t count, uint8_t* out, uint32_t* out_size) {
+    if (count == 0) return 0;
+    if (m_backend == FPGA_BACKEND && m_BinFlow && m_dict.empty())
+        return _compress_batch_fpga(in, in_size, count, out, out_size);
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+
+    std::vector<uint64_t> out_idx(count);
+    uint64_t bound = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        out_idx[i] = bound;
+        bound += in_size[i] + in_size[i] / 255 + 16;
+    }
+
+    const uint8_t* dict = m_dict.empty() ? nullptr : m_dict.data();
+    const uint32_t* dict_table = m_dict.empty() ? nullptr : m_dictTable.data();
+    std::atomic<bool> failed{false};
+    uint32_t ntasks = m_pool->size() * 4;
+    if (ntasks > count) ntasks = count;
+    m_pool->parallel_for(ntasks, [&](uint32_t task) {
+        uint32_t first = (uint64_t)task * count / ntasks;
+        uint32_t last = (uint64_t)(task + 1) * count / ntasks;
+        for (uint32_t i = first; i < last; i++) {
+            out_size[i] = lz4BlockCompress(in[i], in_size[i], &out[out_idx[i]], in_size[i] + in_size[i] / 255 + 16,
+                                           dict, m_dict.size(), dict_table);
+            if (out_size[i] == 0) failed = true;
+        }
+    });
+    if (failed) {
+        std::cerr << "Batch LZ4 compression failed" << std::endl;
+        return 0;
+    }
+
+    uint64_t outIdx = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        std::memmove(&out[outIdx], &out[out_idx[i]], out_size[i]);
+        outIdx += out_size[i];
+    }
+    return outIdx;
+}
+
+// Messages are placed one per block slot of the host buffer and the block
+// size array carries the message sizes. Messages larger than a block, or
+// left stored by the kernel, are coded on host.
+uint64_t xfLz4::_compress_batch_fpga(
+    const uint8_t* const* in, const uint32_t* in_size, uint32_t count, uint8_t* out, uint32_t* out_size) {
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
+    uint32_t max_slots = HOST_BUFFER_SIZE / block_size_in_bytes;
+    uint32_t host_buffer_size = max_slots * block_size_in_bytes;
+
+    MEM_ALLOC_CHECK(h_buf_in[0][0].resize(host_buffer_size), host_buffer_size, "Input Host Buffer");
+    MEM_ALLOC_CHECK(h_buf_out[0][0].resize(host_buffer_size), host_buffer_size, "Output Host Buffer");
+    MEM_ALLOC_CHECK(h_blksize[0][0].resize(max_slots), max_slots, "BlockSize Host Buffer");
+    MEM_ALLOC_CHECK(h_compressSize[0][0].resize(max_slots), max_slots, "CompressSize Host Buffer");
+
+    buffer_input[0][0] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, host_buffer_size,
+                                        h_buf_in[0][0].data());
+    buffer_output[0][0] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, host_buffer_size,
+                                         h_buf_out[0][0].data());
+    buffer_compressed_size[0][0] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY,
+                                                  max_slots * sizeof(uint32_t), h_compressSize[0][0].data());
+    buffer_block_size[0][0] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY,
+                                             max_slots * sizeof(uint32_t), h_blksize[0][0].data());
+
+    std::vector<uint32_t> slot_msg(max_slots);
+    uint64_t outIdx = 0;
+    bool failed = false;
+    for (uint32_t i = 0; i < count && !failed;) {
+        uint32_t first = i;
+        uint32_t nslots = 0;
+        for (; i < count && nslots < max_slots; i++) {
+            if (in_size[i] > block_size_in_bytes) continue;
+            std::memcpy(h_buf_in[0][0].data() + (uint64_t)nslots * block_size_in_bytes, in[i], in_size[i]);
+            h_blksize[0][0][nslots] = in_size[i];
+            slot_msg[nslots++] = i;
+        }
+
+        if (nslots) {
+            uint32_t input_size = nslots * block_size_in_bytes;
+            uint32_t narg = 0;
+            compress_kernel_lz4[0]->setArg(narg++, *(buffer_input[0][0]));
+            compress_kernel_lz4[0]->setArg(narg++, *(buffer_output[0][0]));
+            compress_kernel_lz4[0]->setArg(narg++, *(buffer_compressed_size[0][0]));
+            compress_kernel_lz4[0]->setArg(narg++, *(buffer_block_size[0][0]));
+            compress_kernel_lz4[0]->setArg(narg++, m_BlockSizeInKb);
+            compress_kernel_lz4[0]->setArg(narg++, input_size);
+
+            m_q->enqueueMigrateMemObjects({*(buffer_input[0][0]), *(buffer_block_size[0][0])}, 0);
+            m_q->enqueueTask(*compress_kernel_lz4[0]);
+            m_q->enqueueMigrateMemObjects({*(buffer_output[0][0]), *(buffer_compressed_size[0][0])},
+                                          CL_MIGRATE_MEM_OBJECT_HOST);
+            m_q->finish();
+        }
+
+        // Output keeps the message order
+        uint32_t slot = 0;
+        for (uint32_t m = first; m < i; m++) {
+            uint32_t compressed_size = 0;
+            if (slot < nslots && slot_msg[slot] == m) {
+                uint32_t kernel_size = h_compressSize[0][0][slot];
+                if (kernel_size < in_size[m]) {
+                    std::memcpy(&out[outIdx], h_buf_out[0][0].data() + (uint64_t)slot * block_size_in_bytes,
+                                kernel_size);
+                    compressed_size = kernel_size;
+                }
+                slot++;
+            }
+            if (compressed_size == 0)
+                compressed_size = lz4BlockCompress(in[m], in_size[m], &out[outIdx], in_size[m] + in_size[m] / 255 + 16);
+            if (compressed_size == 0) failed = true;
+            out_size[m] = compressed_size;
+            outIdx += compressed_size;
+        }
+    }
+
+    delete buffer_input[0][0];
+    buffer_input[0][0] = nullptr;
+    delete buffer_output[0][0];
+    buffer_output[0][0] = nullptr;
+    delete buffer_compressed_size[0][0];
+    buffer_compressed_size[0][0] = nullptr;
+    delete buffer_block_size[0][0];
+    buffer_block_size[0][0] = nullptr;
+    if (failed) {
+        std::cerr << "Batch LZ4 compression failed" << std::endl;
+        return 0;
+    }
+    return outIdx;
+}
+
+uint64_t xfLz4::decompressBatch(
+    const uint8_t* in, const uint32_t* in_size, uint32_t count, uint8_t* const* out, const uint32_t* out_size) {
+    if (count == 0) return 0;
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+
+    std::vector<uint64_t> in_idx(count);
+    uint64_t inIdx = 0, total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        in_idx[i] = inIdx;
+        inIdx += in_size[i];
+        total += out_size[i];
+    }
+
+    const uint8_t* dict = m_dict.empty() ? nullptr : m_dict.data();
+    std::atomic<bool> failed{false};
+    uint32_t ntasks = m_pool->size() * 4;
+    if (ntasks > count) ntasks = count;
+    m_pool->parallel_for(ntasks, [&](uint32_t task) {
+        uint32_t first = (uint64_t)task * count / ntasks;
+        uint32_t last = (uint64_t)(task + 1) * count / ntasks;
+        for (uint32_t i = first; i < last; i++) {
+            int64_t size = lz4BlockDecompress(&in[in_idx[i]], in_size[i], out[i], out_size[i], dict, m_dict.size());
+            if (size != out_size[i]) failed = true;
+        }
+    });
+    if (failed) {
+        std::cerr << "Corrupted LZ4 block" << std::endl;
+        return 0;
+    }
+    return total;
+}
@@ -0,0 +1,1041 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include "snappy.hpp"
+
+using namespace xf::compression;
+
+// Snappy framing format
+#define SNAPPY_CHUNK_COMPRESSED 0x00
+#define SNAPPY_CHUNK_UNCOMPRESSED 0x01
+#define SNAPPY_CHUNK_SKIPPABLE 0x80
+#define SNAPPY_CHUNK_STREAM_ID 0xff
+#define SNAPPY_CHUNK_HEADER_SIZE 4
+#define SNAPPY_CHUNK_CRC_SIZE 4
+#define SNAPPY_STREAM_ID_SIZE 10
+#define SNAPPY_MAX_CHUNK_SIZE (64 * 1024)
+#define SNAPPY_CRC_MASK_DELTA 0xa282ead8
+
+// Snappy block format limits
+#define SNAPPY_MIN_MATCH 4
+#define SNAPPY_INPUT_MARGIN 15
+#define SNAPPY_HASH_LOG 14
+
+static const uint8_t c_snappyStreamId[SNAPPY_STREAM_ID_SIZE] = {0xff, 0x06, 0x00, 0x00, 0x73,
+                                                                0x4e, 0x61, 0x50, 0x70, 0x59};
+
+// Slicing-by-8 tables of CRC-32C (Castagnoli, reflected)
+struct snappyCrcTable {
+    uint32_t t[8][256];
+    snappyCrcTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+            t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int k = 1; k < 8; k++) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+        }
+    }
+};
+
+// Masked CRC-32C of uncompressed chunk data as stored in the framing format
+static uint32_t snappyMaskedCrc(const uint8_t* data, uint64_t size) {
+    static const snappyCrcTable table;
+    const uint32_t(*t)[256] = table.t;
+    uint32_t crc = 0xFFFFFFFF;
+    for (; size >= 8; size -= 8, data += 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, data, 4);
+        std::memcpy(&hi, data + 4, 4);
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; size > 0; size--) crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    crc ^= 0xFFFFFFFF;
+    return ((crc >> 15) | (crc << 17)) + SNAPPY_CRC_MASK_DELTA;
+}
+
+static inline uint32_t snappyRead32(const uint8_t* ptr) {
+    uint32_t val;
+    std::memcpy(&val, ptr, 4);
+    return val;
+}
+
+static inline uint32_t snappyHash(uint32_t val) {
+    return (val * 0x1e35a7bd) >> (32 - SNAPPY_HASH_LOG);
+}
+
+static uint32_t snappyPutLiteral(uint8_t* out, const uint8_t* lit, uint32_t len) {
+    uint32_t op = 0;
+    uint32_t n = len - 1;
+    if (n < 60) {
+        out[op++] = n << 2;
+    } else if (n < 256) {
+        out[op++] = 60 << 2;
+        out[op++] = n;
+    } else {
+        out[op++] = 61 << 2;
+        out[op++] = n;
+        out[op++] = n >> 8;
+    }
+    std::memcpy(&out[op], lit, len);
+    return op + len;
+}
+
+static uint32_t snappyPutCopy(uint8_t* out, uint32_t offset, uint32_t len) {
+    uint32_t op = 0;
+    // Copies are limited to 64 bytes, last one keeps at least 4 bytes
+    for (; len >= 68; len -= 64) {
+        out[op++] = 2 | (63 << 2);
+        out[op++] = offset;
+        out[op++] = offset >> 8;
+    }
+    if (len > 64) {
+        out[op++] = 2 | (59 << 2);
+        out[op++] = offset;
+        out[op++] = offset >> 8;
+        len -= 60;
+    }
+    if ((len < 12) && (offset < 2048)) {
+        out[op++] = 1 | ((len - 4) << 2) | ((offset >> 8) << 5);
+        out[op++] = offset;
+    } else {
+        out[op++] = 2 | ((len - 1) << 2);
+        out[op++] = offset;
+        out[op++] = offset >> 8;
+    }
+    return op;
+}
+
+// Greedy Snappy block encoder used by the CPU backend, input is at most one
+// 64KB chunk. Returns 0 when the encoded block doesn't fit in out_size.
+static uint32_t snappyBlockCompress(const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t out_size) {
+    uint16_t table[1 << SNAPPY_HASH_LOG];
+    std::memset(table, 0, sizeof(table));
+
+    // Preamble, uncompressed length as varint
+    uint32_t op = 0;
+    if (out_size < 5) return 0;
+    uint32_t len = in_size;
+    for (; len >= 0x80; len >>= 7) out[op++] = len | 0x80;
+    out[op++] = len;
+
+    uint32_t ip = 1, anchor = 0;
+    if (in_size > SNAPPY_INPUT_MARGIN) {
+        uint32_t limit = in_size - SNAPPY_INPUT_MARGIN;
+        table[snappyHash(snappyRead32(in))] = 0;
+        while (ip < limit) {
+            uint32_t seq = snappyRead32(&in[ip]);
+            uint32_t hash = snappyHash(seq);
+            uint32_t ref = table[hash];
+            table[hash] = ip;
+            if (snappyRead32(&in[ref]) != seq || ref >= ip) {
+                // Skip faster over incompressible data
+                ip += 1 + ((ip - anchor) >> 5);
+                continue;
+            }
+
+            uint32_t mlen = SNAPPY_MIN_MATCH;
+            while ((ip + mlen < in_size) && (in[ip + mlen] == in[ref + mlen])) mlen++;
+
+            uint32_t lit = ip - anchor;
+            if (op + lit + 3 + 3 * (mlen / 60 + 2) > out_size) return 0;
+            if (lit) op += snappyPutLiteral(&out[op], &in[anchor], lit);
+            op += snappyPutCopy(&out[op], ip - ref, mlen);
+
+            ip += mlen;
+            anchor = ip;
+            if (ip < limit) table[snappyHash(snappyRead32(&in[ip - 1]))] = ip - 1;
+        }
+    }
+
+    // Last literals
+    uint32_t lit = in_size - anchor;
+    if (lit) {
+        if (op + lit + 3 > out_size) return 0;
+        op += snappyPutLiteral(&out[op], &in[anchor], lit);
+    }
+    return op;
+}
+
+// Reads the varint preamble, returns its size or 0 when malformed
+static uint32_t snappyPreamble(const uint8_t* in, uint32_t in_size, uint32_t& length) {
+    length = 0;
+    for (uint32_t i = 0; (i < in_size) && (i < 5); i++) {
+        length |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+        if ((in[i] & 0x80) == 0) return i + 1;
+    }
+    return 0;
+}
+
+// Snappy block decoder used by the CPU backend, returns decoded size
+// or -1 on a malformed block
+static int64_t snappyBlockDecompress(const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t out_size) {
+    uint32_t length;
+    uint32_t ip = snappyPreamble(in, in_size, length);
+    if ((ip == 0) || (length != out_size)) return -1;
+
+    uint32_t op = 0;
+    while (ip < in_size) {
+        uint8_t tag = in[ip++];
+        uint32_t len, offset;
+        switch (tag & 3) {
+            case 0: {
+                len = tag >> 2;
+                if (len >= 60) {
+                    uint32_t nbytes = len - 59;
+                    if (ip + nbytes > in_size) return -1;
+                    len = 0;
+                    for (uint32_t i = 0; i < nbytes; i++) len |= (uint32_t)in[ip + i] << (8 * i);
+                    ip += nbytes;
+                }
+                len++;
+                if ((ip + len > in_size) || (op + len > out_size)) return -1;
+                std::memcpy(&out[op], &in[ip], len);
+                ip += len;
+                op += len;
+                continue;
+            }
+            case 1:
+                if (ip + 1 > in_size) return -1;
+                len = ((tag >> 2) & 7) + 4;
+                offset = ((uint32_t)(tag >> 5) << 8) | in[ip];
+                ip += 1;
+                break;
+            case 2:
+                if (ip + 2 > in_size) return -1;
+                len = (tag >> 2) + 1;
+                offset = in[ip] | (in[ip + 1] << 8);
+                ip += 2;
+                break;
+            default:
+                if (ip + 4 > in_size) return -1;
+                len = (tag >> 2) + 1;
+                offset = snappyRead32(&in[ip]);
+                ip += 4;
+                break;
+        }
+        if ((offset == 0) || (offset > op) || (op + len > out_size)) return -1;
+
+        // Overlapping copy replicates the last offset bytes
+        if (offset >= len) {
+            std::memcpy(&out[op], &out[op - offset], len);
+        } else {
+            for (uint32_t i = 0; i < len; i++) out[op + i] = out[op + i - offset];
+        }
+        op += len;
+    }
+    return op;
+}
+
+// Frames one block, stored when the encoded block is not smaller
+static uint32_t snappyPutChunk(
+    uint8_t* out, const uint8_t* raw, uint32_t block_size, const uint8_t* cdata, uint32_t compressed_size, uint32_t crc) {
+    bool keep = (compressed_size != 0) && (compressed_size < block_size);
+    uint32_t len = (keep ? compressed_size : block_size) + SNAPPY_CHUNK_CRC_SIZE;
+    out[0] = keep ? SNAPPY_CHUNK_COMPRESSED : SNAPPY_CHUNK_UNCOMPRESSED;
+    out[1] = len;
+    out[2] = len >> 8;
+    out[3] = len >> 16;
+    std::memcpy(&out[4], &crc, 4);
+    std::memcpy(&out[8], keep ? cdata : raw, len - SNAPPY_CHUNK_CRC_SIZE);
+    return SNAPPY_CHUNK_HEADER_SIZE + len;
+}
+
+// Get the duration of input event
+static uint64_t getEventDurationNs(const cl::Event& event) {
+    uint64_t start_time = 0, end_time = 0;
+
+    event.getProfilingInfo<uint64_t>(CL_PROFILING_COMMAND_START, &start_time);
+    event.getProfilingInfo<uint64_t>(CL_PROFILING_COMMAND_END, &end_time);
+    uint64_t duration = end_time - start_time;
+    return duration;
+}
+
+// Constructor
+xfSnappy::xfSnappy() {
+    for (uint32_t i = 0; i < C_COMPUTE_UNIT; i++) compress_kernel_snappy[i] = nullptr;
+    for (uint32_t i = 0; i < D_COMPUTE_UNIT; i++) decompress_kernel_snappy[i] = nullptr;
+    for (uint32_t i = 0; i < MAX_COMPUTE_UNITS; i++) {
+        for (uint32_t j = 0; j < OVERLAP_BUF_COUNT; j++) {
+            buffer_input[i][j] = nullptr;
+            buffer_output[i][j] = nullptr;
+            buffer_compressed_size[i][j] = nullptr;
+            buffer_block_size[i][j] = nullptr;
+        }
+    }
+}
+
+// Destructor
+xfSnappy::~xfSnappy() {}
+
+int xfSnappy::init(const std::string& binaryFile, uint8_t flow, uint32_t block_size_kb, uint8_t backend) {
+    // Framing format limits uncompressed chunk data to 64KB
+    if (block_size_kb * 1024 > SNAPPY_MAX_CHUNK_SIZE) {
+        std::cout << "Snappy block size limited to " << SNAPPY_MAX_CHUNK_SIZE / 1024 << "KB" << std::endl;
+        block_size_kb = SNAPPY_MAX_CHUNK_SIZE / 1024;
+    }
+    m_BlockSizeInKb = block_size_kb;
+    m_BinFlow = flow;
+
+    m_backend = select_backend(binaryFile, backend);
+    if (m_backend == CPU_BACKEND) {
+        m_pool.reset(new xfThreadPool());
+        std::cout << "Using CPU backend, threads=" << m_pool->size() << std::endl;
+        return 0;
+    }
+
+    // The get_xil_devices will return vector of Xilinx Devices
+    std::vector<cl::Device> devices = xcl::get_xil_devices();
+    cl::Device device = devices[0];
+
+    // Creating Context and Command Queue for selected Device
+    m_context = new cl::Context(device);
+    m_q = new cl::CommandQueue(*m_context, device, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE);
+    std::string device_name = device.getInfo<CL_DEVICE_NAME>();
+    std::cout << "Found Device=" << device_name.c_str() << std::endl;
+
+    // import_binary() command will find the OpenCL binary file created using the
+    // v++ compiler load into OpenCL Binary and return as Binaries
+    // OpenCL and it can contain many functions which can be executed on the
+    // device.
+    auto fileBuf = xcl::read_binary_file(binaryFile);
+    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    devices.resize(1);
+
+    m_program = new cl::Program(*m_context, devices, bins);
+    std::string cu_id;
+    std::string comp_krnl_name = compress_kernel_names[0].c_str();
+    std::string decomp_krnl_name = decompress_kernel_names[0].c_str();
+
+    if (m_BinFlow) {
+        // Create Compress kernels
+        for (uint32_t i = 0; i < C_COMPUTE_UNIT; i++) {
+            cu_id = std::to_string(i + 1);
+            std::string krnl_name_full = comp_krnl_name + ":{" + comp_krnl_name + "_" + cu_id + "}";
+            compress_kernel_snappy[i] = new cl::Kernel(*m_program, krnl_name_full.c_str());
+        }
+    } else {
+        // Create Decompress kernels
+        for (uint32_t i = 0; i < D_COMPUTE_UNIT; i++) {
+            cu_id = std::to_string(i + 1);
+            std::string krnl_name_full = decomp_krnl_name + ":{" + decomp_krnl_name + "_" + cu_id + "}";
+            decompress_kernel_snappy[i] = new cl::Kernel(*m_program, krnl_name_full.c_str());
+        }
+    }
+
+    return 0;
+}
+
+int xfSnappy::release() {
+    if (m_backend == CPU_BACKEND) {
+        m_pool.reset();
+        return 0;
+    }
+
+    if (m_BinFlow) {
+        for (uint32_t i = 0; i < C_COMPUTE_UNIT; i++) {
+            if (compress_kernel_snappy[i]) {
+                delete compress_kernel_snappy[i];
+                compress_kernel_snappy[i] = nullptr;
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < D_COMPUTE_UNIT; i++) {
+            if (decompress_kernel_snappy[i]) {
+                delete decompress_kernel_snappy[i];
+                decompress_kernel_snappy[i] = nullptr;
+            }
+        }
+    }
+    delete (m_program);
+    delete (m_q);
+    delete (m_context);
+
+    return 0;
+}
+
+uint64_t xfSnappy::compressBound(uint64_t input_size) {
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
+    uint64_t nblocks = (input_size + block_size_in_bytes - 1) / block_size_in_bytes;
+    return SNAPPY_STREAM_ID_SIZE + input_size + nblocks * (SNAPPY_CHUNK_HEADER_SIZE + SNAPPY_CHUNK_CRC_SIZE);
+}
+
+uint64_t xfSnappy::compressFile(
+    std::string& inFile_name, std::string& outFile_name, uint64_t input_size, bool file_list_flag, bool m_flow) {
+    m_SwitchFlow = m_flow;
+    if (m_SwitchFlow == 0) { // Xilinx FPGA compression flow
+        std::ifstream inFile(inFile_name.c_str(), std::ifstream::binary);
+        std::ofstream outFile(outFile_name.c_str(), std::ofstream::binary);
+
+        if (!inFile) {
+            std::cout << "Unable to open file";
+            exit(1);
+        }
+
+        std::vector<uint8_t, aligned_allocator<uint8_t> > in;
+        std::vector<uint8_t, aligned_allocator<uint8_t> > out;
+
+        uint64_t output_size = compressBound(input_size);
+        MEM_ALLOC_CHECK(in.resize(input_size), input_size, "Input Buffer");
+        MEM_ALLOC_CHECK(out.resize(output_size), output_size, "Output Buffer");
+
+        inFile.read((char*)in.data(), input_size);
+
+        uint32_t host_buffer_size = (m_BlockSizeInKb * 1024) * 32;
+
+        // Snappy overlap & multiple compute unit compress
+        uint64_t enbytes = compress(in.data(), out.data(), input_size, host_buffer_size, file_list_flag);
+
+        // Writing compressed data
+        outFile.write((char*)out.data(), enbytes);
+
+        // Close file
+        inFile.close();
+        outFile.close();
+        return enbytes;
+    } else { // Standard Snappy flow, python-snappy writes the framing format
+        std::string command = "python3 -m snappy -c " + inFile_name + " " + outFile_name;
+        system(command.c_str());
+        return 0;
+    }
+}
+
+uint64_t xfSnappy::decompressFile(
+    std::string& inFile_name, std::string& outFile_name, uint64_t input_size, bool file_list_flag, bool m_flow) {
+    m_SwitchFlow = m_flow;
+    if (m_SwitchFlow == 0) {
+        std::ifstream inFile(inFile_name.c_str(), std::ifstream::binary);
+        std::ofstream outFile(outFile_name.c_str(), std::ofstream::binary);
+
+        if (!inFile) {
+            std::cout << "Unable to open file";
+            exit(1);
+        }
+
+        std::vector<uint8_t, aligned_allocator<uint8_t> > in;
+        MEM_ALLOC_CHECK(in.resize(input_size), input_size, "Input Buffer");
+        inFile.read((char*)in.data(), input_size);
+
+        // Framing format doesn't store the original size, chunk headers
+        // are walked to find it
+        uint64_t original_size = originalSize(in.data(), input_size);
+        std::vector<uint8_t, aligned_allocator<uint8_t> > out;
+        MEM_ALLOC_CHECK(out.resize(original_size), original_size, "Output Buffer");
+
+        uint32_t host_buffer_size = SNAPPY_MAX_CHUNK_SIZE * 32;
+
+        // Decompression Overlapped multiple cu solution
+        uint64_t debytes =
+            decompress(in.data(), out.data(), input_size, original_size, host_buffer_size, file_list_flag);
+        outFile.write((char*)out.data(), debytes);
+
+        // Close file
+        inFile.close();
+        outFile.close();
+        return debytes;
+    } else {
+        std::string command = "python3 -m snappy -d " + inFile_name + " " + outFile_name;
+        system(command.c_str());
+        return 0;
+    }
+}
+
+bool xfSnappy::_parse_chunks(const uint8_t* in, uint64_t input_size, std::vector<chunk_t>& chunks) {
+    chunks.clear();
+    if ((input_size < SNAPPY_STREAM_ID_SIZE) || std::memcmp(in, c_snappyStreamId, SNAPPY_STREAM_ID_SIZE)) {
+        std::cerr << "Missing Snappy stream identifier" << std::endl;
+        return false;
+    }
+
+    uint64_t outIdx = 0;
+    for (uint64_t inIdx = 0; inIdx < input_size;) {
+        if (inIdx + SNAPPY_CHUNK_HEADER_SIZE > input_size) {
+            std::cerr << "Truncated chunk header" << std::endl;
+            return false;
+        }
+        uint8_t type = in[inIdx];
+        uint32_t len = in[inIdx + 1] | (in[inIdx + 2] << 8) | (in[inIdx + 3] << 16);
+        inIdx += SNAPPY_CHUNK_HEADER_SIZE;
+        if (inIdx + len > input_size) {
+            std::cerr << "Truncated chunk data" << std::endl;
+            return false;
+        }
+
+        if (type == SNAPPY_CHUNK_STREAM_ID) {
+            // Concatenated streams repeat the identifier
+            if (std::memcmp(&in[inIdx - SNAPPY_CHUNK_HEADER_SIZE], c_snappyStreamId, SNAPPY_STREAM_ID_SIZE)) {
+                std::cerr << "Invalid Snappy stream identifier" << std::endl;
+                return false;
+            }
+        } else if ((type == SNAPPY_CHUNK_COMPRESSED) || (type == SNAPPY_CHUNK_UNCOMPRESSED)) {
+            if (len < SNAPPY_CHUNK_CRC_SIZE) {
+                std::cerr << "Invalid chunk length" << std::endl;
+                return false;
+            }
+            chunk_t chunk;
+            chunk.crc = snappyRead32(&in[inIdx]);
+            chunk.in_idx = inIdx + SNAPPY_CHUNK_CRC_SIZE;
+            chunk.compressed_size = len - SNAPPY_CHUNK_CRC_SIZE;
+            chunk.compressed = (type == SNAPPY_CHUNK_COMPRESSED);
+            chunk.block_size = chunk.compressed_size;
+            if (chunk.compressed &&
+                snappyPreamble(&in[chunk.in_idx], chunk.compressed_size, chunk.block_size) == 0) {
+                std::cerr << "Invalid Snappy preamble" << std::endl;
+                return false;
+            }
+            if (chunk.block_size > SNAPPY_MAX_CHUNK_SIZE) {
+                std::cerr << "Chunk exceeds " << SNAPPY_MAX_CHUNK_SIZE << " bytes" << std::endl;
+                return false;
+            }
+            chunk.out_idx = outIdx;
+            outIdx += chunk.block_size;
+            chunks.push_back(chunk);
+        } else if (type < SNAPPY_CHUNK_SKIPPABLE) {
+            std::cerr << "Reserved unskippable chunk " << (uint32_t)type << std::endl;
+            return false;
+        }
+        // Padding and other skippable chunks are ignored
+        inIdx += len;
+    }
+    return true;
+}
+
+uint64_t xfSnappy::originalSize(const uint8_t* in, uint64_t input_size) {
+    std::vector<chunk_t> chunks;
+    if (!_parse_chunks(in, input_size, chunks) || chunks.empty()) return 0;
+    return chunks.back().out_idx + chunks.back().block_size;
+}
+
+uint64_t xfSnappy::decompress(uint8_t* in,
+                              uint8_t* out,
+                              uint64_t input_size,
+                              uint64_t original_size,
+                              uint32_t host_buffer_size,
+                              bool file_list_flag) {
+    std::vector<chunk_t> chunks;
+    if (!_parse_chunks(in, input_size, chunks)) return 0;
+    uint64_t stream_size = chunks.empty() ? 0 : chunks.back().out_idx + chunks.back().block_size;
+    if (stream_size != original_size) {
+        std::cerr << "Original size mismatch " << stream_size << " " << original_size << std::endl;
+        return 0;
+    }
+    if (original_size == 0) return 0;
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+
+    uint64_t total_kernel_time = 0;
+    auto total_start = std::chrono::high_resolution_clock::now();
+    uint64_t debytes = (m_backend == CPU_BACKEND)
+                           ? _decompress_cpu(in, out, chunks)
+                           : _decompress_fpga(in, out, chunks, host_buffer_size, total_kernel_time);
+
+    // Chunk CRCs of the device flow are checked on the host pool
+    if (debytes && (m_backend != CPU_BACKEND)) {
+        std::atomic<bool> failed{false};
+        uint32_t ntasks = m_pool->size() * 4;
+        if (ntasks > chunks.size()) ntasks = chunks.size();
+        m_pool->parallel_for(ntasks, [&](uint32_t task) {
+            for (uint64_t i = task; i < chunks.size(); i += ntasks) {
+                if (snappyMaskedCrc(&out[chunks[i].out_idx], chunks[i].block_size) != chunks[i].crc) failed = true;
+            }
+        });
+        if (failed) {
+            std::cerr << "Snappy chunk CRC mismatch" << std::endl;
+            debytes = 0;
+        }
+    }
+    auto total_end = std::chrono::high_resolution_clock::now();
+    auto total_time_ns = std::chrono::duration<double, std::nano>(total_end - total_start);
+    float throughput_in_mbps_1 = (float)original_size * 1000 / total_time_ns.count();
+    if (m_backend == CPU_BACKEND) {
+        if (file_list_flag == 0)
+            std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:" << throughput_in_mbps_1 << std::endl;
+        else
+            std::cout << std::fixed << std::setprecision(2) << throughput_in_mbps_1 << "\t\t-";
+    } else {
+        float kernel_throughput_in_mbps_1 = (float)original_size * 1000 / total_kernel_time;
+        if (file_list_flag == 0) {
+            std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:" << throughput_in_mbps_1 << std::endl
+                      << "KT(MBps)\t\t:" << kernel_throughput_in_mbps_1 << std::endl;
+        } else {
+            std::cout << std::fixed << std::setprecision(2) << throughput_in_mbps_1 << "\t\t";
+            std::cout << std::fixed << std::setprecision(2) << kernel_throughput_in_mbps_1;
+        }
+    }
+    return debytes;
+}
+
+// Chunks are grouped in bricks of host buffer size, compressed chunks of a
+// brick are placed at 64KB stride for the kernel and stored chunks are
+// copied to their output offset while the brick is staged
+uint64_t xfSnappy::_decompress_fpga(
+    uint8_t* in, uint8_t* out, const std::vector<chunk_t>& chunks, uint32_t host_buffer_size, uint64_t& kernel_time) {
+    uint32_t block_size_in_bytes = SNAPPY_MAX_CHUNK_SIZE;
+    uint32_t max_num_blks = host_buffer_size / block_size_in_bytes;
+    if (max_num_blks == 0) max_num_blks = 1;
+    host_buffer_size = max_num_blks * block_size_in_bytes;
+
+    for (uint32_t i = 0; i < MAX_COMPUTE_UNITS; i++) {
+        for (uint32_t j = 0; j < OVERLAP_BUF_COUNT; j++) {
+            MEM_ALLOC_CHECK(h_buf_in[i][j].resize(host_buffer_size), host_buffer_size, "Input Host Buffer");
+            MEM_ALLOC_CHECK(h_buf_out[i][j].resize(host_buffer_size), host_buffer_size, "Output Host Buffer");
+            MEM_ALLOC_CHECK(h_blksize[i][j].resize(max_num_blks), max_num_blks, "MaxBlockSize Host Buffer");
+            MEM_ALLOC_CHECK(h_compressSize[i][j].resize(max_num_blks), max_num_blks, "MaxNumBlocks Host Buffer");
+        }
+    }
+
+    uint32_t overlap_buf_count = OVERLAP_BUF_COUNT;
+    uint32_t total_chunks = (chunks.size() - 1) / max_num_blks + 1;
+    if (total_chunks < 2) overlap_buf_count = 1;
+
+    // Read, Write and Kernel events
+    cl::Event kernel_events[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    cl::Event read_events[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    cl::Event write_events[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+
+    // Device buffer allocation
+    for (uint32_t cu = 0; cu < D_COMPUTE_UNIT; cu++) {
+        for (uint32_t flag = 0; flag < overlap_buf_count; flag++) {
+            buffer_input[cu][flag] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY,
+                                                    host_buffer_size, h_buf_in[cu][flag].data());
+            buffer_output[cu][flag] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY,
+                                                     host_buffer_size, h_buf_out[cu][flag].data());
+            buffer_compressed_size[cu][flag] =
+                new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, max_num_blks * sizeof(uint32_t),
+                               h_compressSize[cu][flag].data());
+            buffer_block_size[cu][flag] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY,
+                                                         max_num_blks * sizeof(uint32_t), h_blksize[cu][flag].data());
+        }
+    }
+
+    // Stage a brick, returns the number of chunks sent to the kernel
+    auto stageBrick = [&](uint32_t brick, uint32_t cu, uint32_t flag) {
+        uint32_t nblocks = 0;
+        uint64_t first = (uint64_t)brick * max_num_blks;
+        uint64_t last = std::min<uint64_t>(first + max_num_blks, chunks.size());
+        for (uint64_t c = first; c < last; c++) {
+            const chunk_t& chunk = chunks[c];
+            if (chunk.compressed) {
+                h_compressSize[cu][flag].data()[nblocks] = chunk.compressed_size;
+                h_blksize[cu][flag].data()[nblocks] = chunk.block_size;
+                std::memcpy(&h_buf_in[cu][flag].data()[nblocks * block_size_in_bytes], &in[chunk.in_idx],
+                            chunk.compressed_size);
+                nblocks++;
+            } else {
+                // No compression block
+                std::memcpy(&out[chunk.out_idx], &in[chunk.in_idx], chunk.block_size);
+            }
+        }
+        return nblocks;
+    };
+
+    // Copy decoded chunks of a brick to their output offset
+    auto finishBrick = [&](uint32_t brick, uint32_t cu, uint32_t flag) {
+        uint32_t bufIdx = 0;
+        uint64_t first = (uint64_t)brick * max_num_blks;
+        uint64_t last = std::min<uint64_t>(first + max_num_blks, chunks.size());
+        for (uint64_t c = first; c < last; c++) {
+            if (!chunks[c].compressed) continue;
+            std::memcpy(&out[chunks[c].out_idx], &h_buf_out[cu][flag].data()[bufIdx], chunks[c].block_size);
+            bufIdx += block_size_in_bytes;
+        }
+        kernel_time += getEventDurationNs(kernel_events[cu][flag]);
+    };
+
+    // Track the flags of remaining chunks
+    std::vector<uint32_t> chunk_flags(total_chunks);
+    std::vector<uint32_t> cu_order(total_chunks);
+
+    // Finished bricks
+    uint32_t completed_bricks = 0;
+
+    int flag = 0;
+    uint32_t lcl_cu = 0;
+
+    // Main loop of overlap execution
+    // Loop below runs over total bricks i.e., host buffer size chunks
+    for (uint32_t brick = 0, itr = 0; brick < total_chunks; brick += D_COMPUTE_UNIT, itr++, flag = !flag) {
+        lcl_cu = D_COMPUTE_UNIT;
+        if (brick + lcl_cu > total_chunks) lcl_cu = total_chunks - brick;
+
+        // Loop below runs over number of compute units
+        for (uint32_t cu = 0; cu < lcl_cu; cu++) {
+            chunk_flags[brick + cu] = flag;
+            cu_order[brick + cu] = cu;
+            if (itr >= 2) {
+                // Wait on current flag previous operation to finish
+                read_events[cu][flag].wait();
+                finishBrick(brick - (D_COMPUTE_UNIT * overlap_buf_count - cu), cu, flag);
+                completed_bricks++;
+            }
+
+            uint32_t nblocks = stageBrick(brick + cu, cu, flag);
+
+            // Set kernel arguments
+            uint32_t narg = 0;
+            decompress_kernel_snappy[cu]->setArg(narg++, *(buffer_input[cu][flag]));
+            decompress_kernel_snappy[cu]->setArg(narg++, *(buffer_output[cu][flag]));
+            decompress_kernel_snappy[cu]->setArg(narg++, *(buffer_block_size[cu][flag]));
+            decompress_kernel_snappy[cu]->setArg(narg++, *(buffer_compressed_size[cu][flag]));
+            decompress_kernel_snappy[cu]->setArg(narg++, block_size_in_bytes / 1024);
+            decompress_kernel_snappy[cu]->setArg(narg++, nblocks);
+
+            // Kernel wait events for writing & compute
+            std::vector<cl::Event> kernelWriteWait;
+            std::vector<cl::Event> kernelComputeWait;
+
+            // Migrate memory - Map host to device buffers
+            m_q->enqueueMigrateMemObjects(
+                {*(buffer_input[cu][flag]), *(buffer_compressed_size[cu][flag]), *(buffer_block_size[cu][flag])}, 0,
+                NULL, &(write_events[cu][flag]));
+            kernelWriteWait.push_back(write_events[cu][flag]);
+
+            // Launch kernel
+            m_q->enqueueTask(*decompress_kernel_snappy[cu], &kernelWriteWait, &(kernel_events[cu][flag]));
+            kernelComputeWait.push_back(kernel_events[cu][flag]);
+
+            // Migrate memory - Map device to host buffers
+            m_q->enqueueMigrateMemObjects({*(buffer_output[cu][flag])}, CL_MIGRATE_MEM_OBJECT_HOST, &kernelComputeWait,
+                                          &(read_events[cu][flag]));
+        } // Compute unit loop
+    }     // End of main loop
+    m_q->flush();
+    m_q->finish();
+
+    // Handle leftover bricks, they complete in submission order
+    for (uint32_t brick = completed_bricks; brick < total_chunks; brick++)
+        finishBrick(brick, cu_order[brick], chunk_flags[brick]);
+
+    for (uint32_t cu = 0; cu < D_COMPUTE_UNIT; cu++) {
+        for (uint32_t flag = 0; flag < overlap_buf_count; flag++) {
+            if (buffer_input[cu][flag]) {
+                delete buffer_input[cu][flag];
+                buffer_input[cu][flag] = nullptr;
+            }
+            if (buffer_output[cu][flag]) {
+                delete buffer_output[cu][flag];
+                buffer_output[cu][flag] = nullptr;
+            }
+            if (buffer_compressed_size[cu][flag]) {
+                delete buffer_compressed_size[cu][flag];
+                buffer_compressed_size[cu][flag] = nullptr;
+            }
+            if (buffer_block_size[cu][flag]) {
+                delete buffer_block_size[cu][flag];
+                buffer_block_size[cu][flag] = nullptr;
+            }
+        }
+    }
+    return chunks.back().out_idx + chunks.back().block_size;
+}
+
+// CPU backend decompression, chunks are decoded in parallel straight to
+// their output offset and their CRC is checked by the same task
+uint64_t xfSnappy::_decompress_cpu(uint8_t* in, uint8_t* out, const std::vector<chunk_t>& chunks) {
+    std::atomic<bool> failed{false};
+    uint32_t ntasks = m_pool->size() * 4;
+    if (ntasks > chunks.size()) ntasks = chunks.size();
+    m_pool->parallel_for(ntasks, [&](uint32_t task) {
+        for (uint64_t i = task; i < chunks.size(); i += ntasks) {
+            const chunk_t& chunk = chunks[i];
+            if (chunk.compressed) {
+                int64_t size =
+                    snappyBlockDecompress(&in[chunk.in_idx], chunk.compressed_size, &out[chunk.out_idx], chunk.block_size);
+                if (size != chunk.block_size) {
+                    failed = true;
+                    continue;
+                }
+            } else {
+                // No compression block
+                std::memcpy(&out[chunk.out_idx], &in[chunk.in_idx], chunk.block_size);
+            }
+            if (snappyMaskedCrc(&out[chunk.out_idx], chunk.block_size) != chunk.crc) failed = true;
+        }
+    });
+
+    if (failed) {
+        std::cerr << "Corrupted Snappy chunk" << std::endl;
+        return 0;
+    }
+    return chunks.back().out_idx + chunks.back().block_size;
+}
+
+// This version of compression does overlapped execution between
+// Kernel and Host. I/O operations between Host and Device are
+// overlapped with Kernel execution between multiple compute units
+uint64_t xfSnappy::compress(
+    uint8_t* in, uint8_t* out, uint64_t input_size, uint32_t host_buffer_size, bool file_list_flag) {
+    // Snappy Stream Identifier
+    std::memcpy(out, c_snappyStreamId, SNAPPY_STREAM_ID_SIZE);
+    uint64_t outIdx = SNAPPY_STREAM_ID_SIZE;
+    if (input_size == 0) return outIdx;
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+
+    if (m_backend == CPU_BACKEND) {
+        auto total_start = std::chrono::high_resolution_clock::now();
+        outIdx += _compress_cpu(in, &out[outIdx], input_size);
+        auto total_end = std::chrono::high_resolution_clock::now();
+        auto total_time_ns = std::chrono::duration<double, std::nano>(total_end - total_start);
+        float throughput_in_mbps_1 = (float)input_size * 1000 / total_time_ns.count();
+        if (file_list_flag == 0)
+            std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:" << throughput_in_mbps_1 << std::endl;
+        else
+            std::cout << std::fixed << std::setprecision(2) << throughput_in_mbps_1 << "\t\t-";
+        return outIdx;
+    }
+
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
+    host_buffer_size = (host_buffer_size / block_size_in_bytes) * block_size_in_bytes;
+    if (host_buffer_size == 0) host_buffer_size = block_size_in_bytes;
+    uint32_t max_num_blks = host_buffer_size / block_size_in_bytes;
+
+    for (uint32_t i = 0; i < MAX_COMPUTE_UNITS; i++) {
+        for (uint32_t j = 0; j < OVERLAP_BUF_COUNT; j++) {
+            MEM_ALLOC_CHECK(h_buf_in[i][j].resize(host_buffer_size), host_buffer_size, "Input Host Buffer");
+            MEM_ALLOC_CHECK(h_buf_out[i][j].resize(host_buffer_size), host_buffer_size, "Output Host Buffer");
+            MEM_ALLOC_CHECK(h_blksize[i][j].resize(max_num_blks), max_num_blks, "MaxNumBlocks Host Buffer");
+            MEM_ALLOC_CHECK(h_compressSize[i][j].resize(max_num_blks), max_num_blks, "CompressSize Host Buffer");
+        }
+    }
+
+    uint32_t overlap_buf_count = OVERLAP_BUF_COUNT;
+    uint64_t total_kernel_time = 0;
+    // Read, Write and Kernel events
+    cl::Event kernel_events[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    cl::Event read_events[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+    cl::Event write_events[MAX_COMPUTE_UNITS][OVERLAP_BUF_COUNT];
+
+    // Total chunks in input file
+    // For example: Input file size is 12MB and Host buffer size is 2MB
+    // Then we have 12/2 = 6 chunks exists
+    uint32_t total_chunks = (input_size - 1) / host_buffer_size + 1;
+    if (total_chunks < 2) overlap_buf_count = 1;
+
+    // Masked CRC of every block, computed on the host pool while
+    // the kernels of the previous bricks run
+    uint64_t total_blocks = (input_size - 1) / block_size_in_bytes + 1;
+    std::vector<uint32_t> blk_crc(total_blocks);
+
+    // Device buffer allocation
+    for (uint32_t cu = 0; cu < C_COMPUTE_UNIT; cu++) {
+        for (uint32_t flag = 0; flag < overlap_buf_count; flag++) {
+            // Input:- This buffer contains input chunk data
+            buffer_input[cu][flag] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY,
+                                                    host_buffer_size, h_buf_in[cu][flag].data());
+
+            // Output:- This buffer contains compressed data written by device
+            buffer_output[cu][flag] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY,
+                                                     host_buffer_size, h_buf_out[cu][flag].data());
+
+            // Ouput:- This buffer contains compressed block sizes
+            buffer_compressed_size[cu][flag] =
+                new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, max_num_blks * sizeof(uint32_t),
+                               h_compressSize[cu][flag].data());
+
+            // Input:- This buffer contains origianl input block sizes
+            buffer_block_size[cu][flag] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY,
+                                                         max_num_blks * sizeof(uint32_t), h_blksize[cu][flag].data());
+        }
+    }
+
+    // Size of a brick, all bricks hold host buffer size except the last
+    auto chunkSize = [&](uint32_t brick) {
+        uint64_t start = (uint64_t)brick * host_buffer_size;
+        return (uint32_t)std::min<uint64_t>(host_buffer_size, input_size - start);
+    };
+
+    // Frame the blocks of a finished brick
+    auto finishBrick = [&](uint32_t brick, uint32_t cu, uint32_t flag) {
+        uint64_t start = (uint64_t)brick * host_buffer_size;
+        uint32_t chunk_size = chunkSize(brick);
+        for (uint32_t bIdx = 0, index = 0; index < chunk_size; bIdx++, index += block_size_in_bytes) {
+            uint32_t block_size = std::min(block_size_in_bytes, chunk_size - index);
+            uint32_t compressed_size = h_compressSize[cu][flag].data()[bIdx];
+            outIdx += snappyPutChunk(&out[outIdx], &in[start + index], block_size,
+                                     &h_buf_out[cu][flag].data()[bIdx * block_size_in_bytes], compressed_size,
+                                     blk_crc[start / block_size_in_bytes + bIdx]);
+        }
+        total_kernel_time += getEventDurationNs(kernel_events[cu][flag]);
+    };
+
+    // Track the flags of respective chunks for left over handling
+    std::vector<uint32_t> chunk_flags(total_chunks);
+    std::vector<uint32_t> cu_order(total_chunks);
+
+    // Finished bricks
+    uint32_t completed_bricks = 0;
+
+    int flag = 0;
+    uint32_t lcl_cu = 0;
+
+    // Main loop of overlap execution
+    // Loop below runs over total bricks i.e., host buffer size chunks
+    auto total_start = std::chrono::high_resolution_clock::now();
+    for (uint32_t brick = 0, itr = 0; brick < total_chunks; brick += C_COMPUTE_UNIT, itr++, flag = !flag) {
+        lcl_cu = C_COMPUTE_UNIT;
+        if (brick + lcl_cu > total_chunks) lcl_cu = total_chunks - brick;
+        // Loop below runs over number of compute units
+        for (uint32_t cu = 0; cu < lcl_cu; cu++) {
+            chunk_flags[brick + cu] = flag;
+            cu_order[brick + cu] = cu;
+            // Wait on read events
+            if (itr >= 2) {
+                // Wait on current flag previous operation to finish
+                read_events[cu][flag].wait();
+                finishBrick(brick - (C_COMPUTE_UNIT * overlap_buf_count - cu), cu, flag);
+                completed_bricks++;
+            }
+
+            // Figure out block sizes per brick
+            uint32_t chunk_size = chunkSize(brick + cu);
+            uint32_t bIdx = 0;
+            for (uint32_t i = 0; i < chunk_size; i += block_size_in_bytes) {
+                (h_blksize[cu][flag]).data()[bIdx++] = std::min(block_size_in_bytes, chunk_size - i);
+            }
+
+            // Copy data from input buffer to host
+            uint64_t start = (uint64_t)(brick + cu) * host_buffer_size;
+            std::memcpy(h_buf_in[cu][flag].data(), &in[start], chunk_size);
+
+            // Set kernel arguments
+            uint32_t narg = 0;
+            compress_kernel_snappy[cu]->setArg(narg++, *(buffer_input[cu][flag]));
+            compress_kernel_snappy[cu]->setArg(narg++, *(buffer_output[cu][flag]));
+            compress_kernel_snappy[cu]->setArg(narg++, *(buffer_compressed_size[cu][flag]));
+            compress_kernel_snappy[cu]->setArg(narg++, *(buffer_block_size[cu][flag]));
+            compress_kernel_snappy[cu]->setArg(narg++, m_BlockSizeInKb);
+            compress_kernel_snappy[cu]->setArg(narg++, chunk_size);
+
+            // Transfer data from host to device
+            m_q->enqueueMigrateMemObjects({*(buffer_input[cu][flag]), *(buffer_block_size[cu][flag])}, 0, NULL,
+                                          &(write_events[cu][flag]));
+
+            // Kernel wait events for writing & compute
+            std::vector<cl::Event> kernelWriteWait;
+            std::vector<cl::Event> kernelComputeWait;
+
+            // Kernel Write events update
+            kernelWriteWait.push_back(write_events[cu][flag]);
+
+            // Fire the kernel
+            m_q->enqueueTask(*compress_kernel_snappy[cu], &kernelWriteWait, &(kernel_events[cu][flag]));
+            // Update kernel events flag on computation
+            kernelComputeWait.push_back(kernel_events[cu][flag]);
+
+            // Transfer data from device to host
+            m_q->enqueueMigrateMemObjects({*(buffer_output[cu][flag]), *(buffer_compressed_size[cu][flag])},
+                                          CL_MIGRATE_MEM_OBJECT_HOST, &kernelComputeWait, &(read_events[cu][flag]));
+
+            // Block CRCs of this brick overlap the kernel execution
+            uint64_t first_blk = start / block_size_in_bytes;
+            m_pool->parallel_for(bIdx, [&, first_blk](uint32_t b) {
+                uint64_t index = (first_blk + b) * block_size_in_bytes;
+                uint32_t block_size = std::min<uint64_t>(block_size_in_bytes, input_size - index);
+                blk_crc[first_blk + b] = snappyMaskedCrc(&in[index], block_size);
+            });
+        } // Compute unit loop ends here
+
+    } // Main loop ends here
+    m_q->flush();
+    m_q->finish();
+
+    // Handle leftover bricks, they complete in submission order
+    for (uint32_t brick = completed_bricks; brick < total_chunks; brick++)
+        finishBrick(brick, cu_order[brick], chunk_flags[brick]);
+
+    auto total_end = std::chrono::high_resolution_clock::now();
+    auto total_time_ns = std::chrono::duration<double, std::nano>(total_end - total_start);
+    float throughput_in_mbps_1 = (float)input_size * 1000 / total_time_ns.count();
+    float kernel_throughput_in_mbps_1 = (float)input_size * 1000 / total_kernel_time;
+    if (file_list_flag == 0) {
+        std::cout << std::fixed << std::setprecision(2) << "E2E(MBps)\t\t:" << throughput_in_mbps_1 << std::endl
+                  << "KT(MBps)\t\t:" << kernel_throughput_in_mbps_1 << std::endl;
+    } else {
+        std::cout << std::fixed << std::setprecision(2) << throughput_in_mbps_1 << "\t\t";
+        std::cout << std::fixed << std::setprecision(2) << kernel_throughput_in_mbps_1;
+    }
+
+    for (uint32_t cu = 0; cu < C_COMPUTE_UNIT; cu++) {
+        for (uint32_t flag = 0; flag < overlap_buf_count; flag++) {
+            if (buffer_input[cu][flag]) {
+                delete buffer_input[cu][flag];
+                buffer_input[cu][flag] = nullptr;
+            }
+            if (buffer_output[cu][flag]) {
+                delete buffer_output[cu][flag];
+                buffer_output[cu][flag] = nullptr;
+            }
+            if (buffer_compressed_size[cu][flag]) {
+                delete buffer_compressed_size[cu][flag];
+                buffer_compressed_size[cu][flag] = nullptr;
+            }
+            if (buffer_block_size[cu][flag]) {
+                delete buffer_block_size[cu][flag];
+                buffer_block_size[cu][flag] = nullptr;
+            }
+        }
+    }
+
+    return outIdx;
+} // Overlap end
+
+// CPU backend compression, blocks are encoded on the host thread pool and
+// framed exactly as the overlapped compress flow above
+uint64_t xfSnappy::_compress_cpu(uint8_t* in, uint8_t* out, uint64_t input_size) {
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
+    uint64_t nblocks = (input_size + block_size_in_bytes - 1) / block_size_in_bytes;
+
+    // Blocks are handled in waves to bound the temporary memory
+    uint32_t wave = m_pool->size() * 8;
+    std::vector<uint8_t> blk_out((uint64_t)wave * block_size_in_bytes);
+    std::vector<uint32_t> blk_csize(wave);
+    std::vector<uint32_t> blk_crc(wave);
+    uint64_t outIdx = 0;
+
+    for (uint64_t blk = 0; blk < nblocks; blk += wave) {
+        uint32_t count = wave;
+        if (blk + count > nblocks) count = nblocks - blk;
+
+        m_pool->parallel_for(count, [&](uint32_t i) {
+            uint64_t index = (blk + i) * block_size_in_bytes;
+            uint32_t block_size = block_size_in_bytes;
+            if (index + block_size > input_size) block_size = input_size - index;
+
+            // Only encodings smaller than the block are worth keeping
+            blk_csize[i] = snappyBlockCompress(&in[index], block_size, &blk_out[(uint64_t)i * block_size_in_bytes],
+                                               block_size - 1);
+            blk_crc[i] = snappyMaskedCrc(&in[index], block_size);
+        });
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t index = (blk + i) * block_size_in_bytes;
+            uint32_t block_size = block_size_in_bytes;
+            if (index + block_size > input_size) block_size = input_size - index;
+            outIdx += snappyPutChunk(&out[outIdx], &in[index], block_size, &blk_out[(uint64_t)i * block_size_in_bytes],
+                                     blk_csize[i], blk_crc[i]);
+        }
+    }
+    return outIdx;
+}
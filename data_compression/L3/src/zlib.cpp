@@ -15,6 +15,7 @@
  *
  */
 #include "zlib.hpp"
+#include <zlib.h>
 
 using namespace xf::compression;
 
@@ -37,7 +38,7 @@ void zip(std::string& inFile_name, std::ofstream& outFile, uint8_t* zip_out, uin
     outFile.put(0);
 }
 
-void gzip_headers(std::string& inFile_name, std::ofstream& outFile, uint8_t* zip_out, uint32_t enbytes) {
+void gzip_header(std::string& inFile_name, std::ofstream& outFile) {
     const uint16_t c_format_0 = 31;
     const uint16_t c_format_1 = 139;
     const uint16_t c_variant = 8;
@@ -85,8 +86,11 @@ void gzip_headers(std::string& inFile_name, std::ofstream& outFile, uint8_t* zip
     }
 
     outFile.put(0);
-    outFile.write((char*)zip_out, enbytes);
+}
 
+void gzip_trailer(std::string& inFile_name, std::ofstream& outFile) {
+    struct stat istat;
+    stat(inFile_name.c_str(), &istat);
     unsigned long ifile_size = istat.st_size;
     uint8_t crc_byte = 0;
     long crc_val = 0;
@@ -116,6 +120,12 @@ void gzip_headers(std::string& inFile_name, std::ofstream& outFile, uint8_t* zip
     outFile.put(0);
 }
 
+void gzip_headers(std::string& inFile_name, std::ofstream& outFile, uint8_t* zip_out, uint32_t enbytes) {
+    gzip_header(inFile_name, outFile);
+    outFile.write((char*)zip_out, enbytes);
+    gzip_trailer(inFile_name, outFile);
+}
+
 void zlib_headers(std::string& inFile_name, std::ofstream& outFile, uint8_t* zip_out, uint32_t enbytes) {
     outFile.put(120);
     outFile.put(1);
@@ -127,6 +137,16 @@ void zlib_headers(std::string& inFile_name, std::ofstream& outFile, uint8_t* zip
     outFile.put(0);
 }
 
+// Size of header written by gzip_header or zlib_headers
+static uint64_t file_header_size(std::string& inFile_name) {
+#ifdef GZIP_MODE
+    // 10 bytes fixed header and null terminated file name
+    return 10 + inFile_name.size() + 1;
+#else
+    return 2;
+#endif
+}
+
 uint64_t xfZlib::compress_file(std::string& inFile_name, std::string& outFile_name, uint64_t input_size) {
     std::chrono::duration<double, std::nano> compress_API_time_ns_1(0);
     std::ifstream inFile(inFile_name.c_str(), std::ifstream::binary);
@@ -160,6 +180,7 @@ uint64_t xfZlib::compress_file(std::string& inFile_name, std::string& outFile_na
     float throughput_in_mbps_1 = (float)input_size * 1000 / compress_API_time_ns_1.count();
     std::cout << std::fixed << std::setprecision(3) << throughput_in_mbps_1;
 
+    m_index.set_base(file_header_size(inFile_name));
     if (enbytes > 0) {
 #ifdef GZIP_MODE
         // Pack gzip encoded stream .gz file
@@ -193,9 +214,9 @@ int xfZlib::init(const std::string& binaryFileName, uint8_t kidx) {
 
     // Look for platform
     std::vector<cl::Platform> platforms;
-    OCL_CHECK(err, err = cl::Platform::get(&platforms));
+    err = cl::Platform::get(&platforms);
     auto num_platforms = platforms.size();
-    if (num_platforms == 0) {
+    if ((err != CL_SUCCESS) || (num_platforms == 0)) {
         std::cerr << "No Platforms were found this could be cased because of the OpenCL \
                       ICD not installed at /etc/OpenCL/vendors directory"
                   << std::endl;
@@ -225,7 +246,12 @@ int xfZlib::init(const std::string& binaryFileName, uint8_t kidx) {
     }
     // Getting ACCELERATOR Devices and selecting 1st such device
     std::vector<cl::Device> devices;
-    OCL_CHECK(err, err = platform.getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices));
+    err = platform.getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices);
+    if ((err != CL_SUCCESS) || (devices.size() <= m_deviceid)) {
+        std::cerr << "Error: Failed to find Xilinx device " << (int)m_deviceid << std::endl;
+        m_err_code = 1;
+        return 1;
+    }
     m_device = devices[m_deviceid];
 
     // OpenCL Setup Start
@@ -343,7 +369,8 @@ xfZlib::xfZlib(const std::string& binaryFileName,
                uint8_t cd_flow,
                uint8_t device_id,
                uint8_t profile,
-               uint8_t d_type) {
+               uint8_t d_type,
+               uint8_t backend) {
     for (int i = 0; i < MAX_CCOMP_UNITS; i++) {
         for (int j = 0; j < OVERLAP_BUF_COUNT; j++) {
             buffer_input[i][j] = nullptr;
@@ -368,13 +395,26 @@ xfZlib::xfZlib(const std::string& binaryFileName,
     uint8_t kidx = d_type;
 
     // OpenCL setup
-    int err = init(binaryFileName, kidx);
-    if (err) {
+    m_backend = select_backend(binaryFileName, backend);
+    int err = 0;
+    if (m_backend == FPGA_BACKEND) err = init(binaryFileName, kidx);
+    if (err && (backend == AUTO_BACKEND)) {
+        std::cerr << "\nOpenCL Setup Failed, switching to CPU backend" << std::endl;
+        release();
+        m_err_code = 0;
+        m_backend = CPU_BACKEND;
+    } else if (err) {
         std::cerr << "\nOpenCL Setup Failed" << std::endl;
         release();
         return;
     }
 
+    // Host thread pool replaces the compute units
+    if (m_backend == CPU_BACKEND) {
+        m_pool.reset(new xfThreadPool());
+        return;
+    }
+
 #ifdef VERBOSE
     auto device_API_end = std::chrono::high_resolution_clock::now();
     auto duration_devscan = std::chrono::duration<double, std::milli>(device_API_end - device_API_start);
@@ -501,6 +541,14 @@ int xfZlib::error_code(void) {
     return m_err_code;
 }
 
+uint8_t xfZlib::backend(void) {
+    return m_backend;
+}
+
+xfBlockIndex& xfZlib::block_index(void) {
+    return m_index;
+}
+
 void xfZlib::release() {
     DELETE_OBJ(m_program);
     DELETE_OBJ(m_context);
@@ -553,8 +601,13 @@ void xfZlib::release() {
 
         for (int i = 0; i < DOUT_BUFFERCOUNT; i++) {
             DELETE_OBJ(buffer_dec_zlib_output[i]);
+            DELETE_OBJ(m_dstrm_size_buf[i]);
         }
+        DELETE_OBJ(m_dstrm_status_buf);
     }
+
+    if (m_dstrm_zs) inflateEnd(m_dstrm_zs);
+    DELETE_OBJ(m_dstrm_zs);
 }
 
 // Destructor
@@ -587,6 +640,7 @@ uint64_t xfZlib::compress_buffer(uint8_t* in, uint8_t* out, uint64_t input_size)
     // Call to compress
     // Zlib Compress
     uint64_t enbytes = compress(in, out + 2, input_size, host_buffer_size);
+    m_index.set_base(2);
     if (enbytes != 0) {
         out[enbytes + 1] = 0;
         out[enbytes + 2] = 0;
@@ -610,24 +664,34 @@ uint32_t xfZlib::decompress_file(std::string& inFile_name, std::string& outFile_
         exit(1);
     }
 
-    uint32_t output_buf_size = input_size * m_max_cr;
-
     std::vector<uint8_t, zlib_aligned_allocator<uint8_t> > in;
-    // Allocat output size
-    // 8 - Max CR per file expected, if this size is big
-    // Decompression crashes
-    std::vector<uint8_t, zlib_aligned_allocator<uint8_t> > out(output_buf_size);
-
     MEM_ALLOC_CHECK(in.resize(input_size), input_size, "Input Buffer");
-    MEM_ALLOC_CHECK(in.resize(output_buf_size), output_buf_size, "Output Buffer");
-
-    uint32_t debytes = 0;
     inFile.read((char*)in.data(), input_size);
 
-    // printme("Call to zlib_decompress \n");
-    // Call decompress
+    // Original size recorded by the block index at compression time
+    uint64_t original_size = 0;
+    std::string index_file = inFile_name + ".idx";
+    if (std::ifstream(index_file.c_str()).good()) {
+        xfBlockIndex index;
+        if (index.load(index_file) == 0) original_size = index.raw_size_total();
+    }
+
+    // Output sized exactly when the original size is known, otherwise it
+    // grows in chunks as the data reader kernel returns it
+    std::vector<uint8_t, zlib_aligned_allocator<uint8_t> > out;
+    xfChunkChain out_chain;
+    uint64_t debytes = 0;
+
     auto decompress_API_start = std::chrono::high_resolution_clock::now();
-    debytes = decompress(in.data(), out.data(), input_size, cu);
+    if (original_size) {
+        MEM_ALLOC_CHECK(out.resize(original_size), original_size, "Output Buffer");
+        debytes = decompress_exact(in.data(), out.data(), input_size, original_size, cu);
+    }
+    // Stale or missing index
+    if (debytes == 0) {
+        out.clear();
+        debytes = decompress_chain(in.data(), input_size, out_chain, cu);
+    }
     auto decompress_API_end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration<double, std::nano>(decompress_API_end - decompress_API_start);
     decompress_API_time_ns_1 = duration;
@@ -640,7 +704,10 @@ uint32_t xfZlib::decompress_file(std::string& inFile_name, std::string& outFile_
     float throughput_in_mbps_1 = (float)debytes * 1000 / decompress_API_time_ns_1.count();
     std::cout << std::fixed << std::setprecision(3) << throughput_in_mbps_1;
 
-    outFile.write((char*)out.data(), debytes);
+    if (out_chain.size())
+        out_chain.write(outFile);
+    else
+        outFile.write((char*)out.data(), debytes);
 
     // Close file
     inFile.close();
@@ -650,7 +717,7 @@ uint32_t xfZlib::decompress_file(std::string& inFile_name, std::string& outFile_
 }
 
 // method to enqueue reads in parallel with writes to decompression kernel
-void xfZlib::_enqueue_reads(uint32_t bufSize, uint8_t* out, uint32_t* decompSize, int cu, uint32_t max_outbuf_size) {
+void xfZlib::_enqueue_reads(uint32_t bufSize, uint8_t* out, uint32_t* decompSize, int cu, uint64_t max_outbuf_size) {
     const int BUFCNT = DOUT_BUFFERCOUNT;
     cl::Event hostReadEvent[BUFCNT];
     cl::Event kernelReadEvent[BUFCNT];
@@ -660,6 +727,7 @@ void xfZlib::_enqueue_reads(uint32_t bufSize, uint8_t* out, uint32_t* decompSize
     uint8_t* outP = nullptr;
     uint32_t* outSize = nullptr;
     uint32_t dcmpSize = 0;
+    bool overflow = false;
     cl::Buffer* buffer_size[BUFCNT];
     cl::Buffer* buffer_status; // single common buffer to capture the decompression status by kernel
     cl_int err;
@@ -694,22 +762,13 @@ void xfZlib::_enqueue_reads(uint32_t bufSize, uint8_t* out, uint32_t* decompSize
                 if (raw_size > bufSize) {
                     --raw_size;
                 }
-                if (raw_size != 0) {
+                // Output beyond max_outbuf_size is drained but not copied
+                if ((max_outbuf_size != 0) && ((uint64_t)dcmpSize + raw_size > max_outbuf_size)) overflow = true;
+                if ((raw_size != 0) && !overflow) {
                     std::memcpy(out + dcmpSize, outP, raw_size);
                     dcmpSize += raw_size;
                 }
                 if (raw_size != bufSize) done = true;
-
-                if ((dcmpSize > max_outbuf_size) && (max_outbuf_size != 0)) {
-                    std::cout << "\n" << std::endl;
-                    std::cout << "\x1B[35mZIP BOMB: Exceeded output buffer size during decompression \033[0m \n"
-                              << std::endl;
-                    std::cout
-                        << "\x1B[35mUse -mcr option to increase the maximum compression ratio (Default: 10) \033[0m \n"
-                        << std::endl;
-                    std::cout << "\x1B[35mAborting .... \033[0m\n" << std::endl;
-                    exit(1);
-                }
                 if ((kernelReadWait[cbf_idx]).size() > 0)
                     kernelReadWait[cbf_idx].pop_back(); // must always have single element
             }
@@ -733,6 +792,13 @@ void xfZlib::_enqueue_reads(uint32_t bufSize, uint8_t* out, uint32_t* decompSize
     } while (!(done && keq_idx == cpy_cnt));
     // wait for data transfer queue to finish
     OCL_CHECK(err, err = m_q_rdd[cu]->finish());
+    if (overflow) {
+        std::cout << "\n" << std::endl;
+        std::cout << "\x1B[35mZIP BOMB: Exceeded output buffer size during decompression \033[0m \n" << std::endl;
+        std::cout << "\x1B[35mUse -mcr option to increase the maximum compression ratio (Default: 10) \033[0m \n"
+                  << std::endl;
+        dcmpSize = 0;
+    }
     *decompSize = dcmpSize;
 
     // free the buffers
@@ -785,8 +851,8 @@ void xfZlib::_enqueue_writes(uint32_t bufSize, uint8_t* in, uint32_t inputSize,
     OCL_CHECK(err, err = m_q_wr[cu]->finish());
 }
 
-uint32_t xfZlib::decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int cu) {
-    cl_int err;
+// Validates zlib/gzip stream header, returns non-zero on mismatch
+int xfZlib::_check_header(const uint8_t* in) {
 #ifdef GZIP_MODE
 
     uint8_t hidx = 0;
@@ -797,7 +863,7 @@ uint32_t xfZlib::decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int
         std::cerr << "Magic Header Fails" << std::endl;
         // We must set error_flag true and return it helps
         // for CISCO use case
-        return 0;
+        return 1;
     }
 
     // Check if method is deflate or not
@@ -806,7 +872,7 @@ uint32_t xfZlib::decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int
         std::cerr << "Deflate Header Check Fails" << std::endl;
         // We must set error_flag true and return it helps
         // for CISCO use case
-        return 0;
+        return 1;
     }
 
     // Check if the FLAG has correct value
@@ -818,7 +884,7 @@ uint32_t xfZlib::decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int
         std::cerr << "Deflate -n option check failed" << std::endl;
         // We must set error_flag true and return it helps
         // for CISCO use case
-        return 0;
+        return 1;
     }
 
     hidx++;
@@ -838,7 +904,7 @@ uint32_t xfZlib::decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int
     if (ochck) {
         std::cerr << "\n";
         std::cerr << "GZip header mismatch: OS code is unknown" << std::endl;
-        return 0;
+        return 1;
     }
 
 #else
@@ -860,21 +926,76 @@ uint32_t xfZlib::decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int
             std::cerr << "\n";
             std::cerr << "Header check fails" << std::endl;
             // Set error_flag to true here for cisco usecase
-            return 0;
+            return 1;
         }
     } else {
         // Set the error flag to true for Cisco Usecase
         // and return
         std::cerr << "\n";
         std::cerr << "Zlib Header mismatch" << std::endl;
-        return 0;
+        return 1;
     }
 
 #endif
+    return 0;
+}
+
+uint32_t xfZlib::decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int cu) {
+    return _decompress(in, out, input_size, cu, (uint64_t)input_size * m_max_cr);
+}
+
+uint64_t xfZlib::decompress_exact(
+    uint8_t* in, uint8_t* out, uint64_t input_size, uint64_t original_size, int cu) {
+    if ((input_size > UINT32_MAX) || (original_size > UINT32_MAX)) {
+        std::cerr << "decompress_exact supports streams up to 4GB, use decompress_chain" << std::endl;
+        return 0;
+    }
+    // Empty original has nothing to decompress into
+    if (original_size == 0) return 0;
+    return _decompress(in, out, input_size, cu, original_size);
+}
+
+uint64_t xfZlib::decompress_chain(uint8_t* in, uint64_t input_size, xfChunkChain& out, int cu) {
+    if (decompress_stream_init(input_size, cu)) return 0;
+
+    // Data reader buffers are copied straight into the chain tail
+    for (uint64_t inIdx = 0; inIdx < input_size;) {
+        uint64_t inbytes = decompress_stream_push(&in[inIdx], input_size - inIdx);
+        if (error_code()) break;
+        inIdx += inbytes;
+
+        uint64_t avail;
+        uint8_t* dst = out.tail(avail);
+        uint64_t outbytes = decompress_stream_pull(dst, avail);
+        out.commit(outbytes);
+        if (inbytes == 0 && outbytes == 0) std::this_thread::yield();
+    }
+
+    while (!error_code()) {
+        uint64_t avail;
+        uint8_t* dst = out.tail(avail);
+        uint64_t outbytes = decompress_stream_pull(dst, avail);
+        if (outbytes == 0) break;
+        out.commit(outbytes);
+    }
+
+    // CPU inflate stalls without error on a truncated stream
+    bool truncated = (m_backend == CPU_BACKEND) && !m_dstrm_done;
+    uint64_t debytes = decompress_stream_finish();
+    if (error_code() || truncated) return 0;
+    return debytes;
+}
+
+uint32_t xfZlib::_decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int cu, uint64_t max_outbuf_size) {
+    cl_int err;
+    // zlib/gzip header checks
+    if (_check_header(in)) return 0;
+
+    if (m_backend == CPU_BACKEND) return _decompress_cpu(in, out, input_size, max_outbuf_size);
+
     // Streaming based solution
     uint32_t inBufferSize = INPUT_BUFFER_SIZE;
     uint32_t outBufferSize = OUTPUT_BUFFER_SIZE;
-    uint32_t max_outbuf_size = input_size * m_max_cr;
     const int c_bufcnt = DIN_BUFFERCOUNT;
     const int c_outBufCnt = DOUT_BUFFERCOUNT;
 
@@ -914,6 +1035,15 @@ uint32_t xfZlib::decompress(uint8_t* in, uint8_t* out, uint32_t input_size, int
 // Kernel and Host. I/O operations between Host and Device are
 // overlapped with Kernel execution between multiple compute units
 uint64_t xfZlib::compress(uint8_t* in, uint8_t* out, uint64_t input_size, uint32_t host_buffer_size) {
+    m_index.clear(INDEX_DEFLATE);
+    if (m_backend == CPU_BACKEND) {
+        uint64_t outIdx = _compress_cpu(in, out, input_size);
+        // zlib special block based on Z_SYNC_FLUSH
+        const uint8_t c_sync_flush[] = {0x01, 0x00, 0x00, 0xff, 0xff};
+        std::memcpy(&out[outIdx], c_sync_flush, sizeof(c_sync_flush));
+        return outIdx + sizeof(c_sync_flush);
+    }
+
     cl_int err;
     uint32_t block_size_in_kb = BLOCK_SIZE_IN_KB;
     uint32_t block_size_in_bytes = block_size_in_kb * 1024;
@@ -1009,6 +1139,7 @@ overlap:
                                        *(buffer_zlib_output[cu][flag]), CL_TRUE, index,
                                        compressed_size * sizeof(uint8_t), &out[outIdx]));
                     outIdx += compressed_size;
+                    m_index.add(compressed_size, block_size);
                 }
             } // If condition which reads huffman output for 0 or 1 location
 
@@ -1147,6 +1278,7 @@ overlap:
                 m_q[queue_idx + cu]->enqueueReadBuffer(*(buffer_zlib_output[cu][flag]), CL_TRUE, index,
                                                        compressed_size * sizeof(uint8_t), &out[outIdx]);
                 outIdx += compressed_size;
+                m_index.add(compressed_size, block_size);
             }
         }
     }
@@ -1161,3 +1293,981 @@ overlap:
     outIdx += xarg;
     return outIdx;
 } // Overlap end
+
+// Size of zlib/gzip header already validated by _check_header
+static uint32_t zlib_header_size(const uint8_t* in) {
+#ifdef GZIP_MODE
+    uint32_t hidx = 10;
+    // File name is null terminated
+    if (in[3] == 0x08) {
+        while (in[hidx] != 0) hidx++;
+        hidx++;
+    }
+    return hidx;
+#else
+    return 2;
+#endif
+}
+
+// CPU backend compression, every BLOCK_SIZE_IN_KB block is raw deflated
+// independently and byte aligned by Z_SYNC_FLUSH same as the kernel output
+uint64_t xfZlib::_compress_cpu(const uint8_t* in, uint8_t* out, uint64_t input_size) {
+    uint32_t block_size_in_bytes = BLOCK_SIZE_IN_KB * 1024;
+    uint64_t nblocks = (input_size + block_size_in_bytes - 1) / block_size_in_bytes;
+
+    // Blocks are handled in waves to bound the temporary memory
+    uint32_t wave = m_pool->size() * OVERLAP_BUF_COUNT;
+    std::vector<std::vector<uint8_t> > blk_out(wave);
+    std::vector<uint64_t> blk_size(wave);
+    std::atomic<bool> failed{false};
+    uint64_t outIdx = 0;
+
+    for (uint64_t blk = 0; blk < nblocks; blk += wave) {
+        uint32_t count = wave;
+        if (blk + count > nblocks) count = nblocks - blk;
+
+        m_pool->parallel_for(count, [&](uint32_t i) {
+            uint64_t index = (blk + i) * block_size_in_bytes;
+            uint32_t block_size = block_size_in_bytes;
+            if (index + block_size > input_size) block_size = input_size - index;
+
+            z_stream strm = {};
+            // Level 1 matches the fast mode advertised by the zlib header
+            if (deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                failed = true;
+                return;
+            }
+            blk_out[i].resize(deflateBound(&strm, block_size) + 16);
+            strm.next_in = const_cast<uint8_t*>(&in[index]);
+            strm.avail_in = block_size;
+            strm.next_out = blk_out[i].data();
+            strm.avail_out = blk_out[i].size();
+            if (deflate(&strm, Z_SYNC_FLUSH) != Z_OK || strm.avail_in != 0) failed = true;
+            blk_size[i] = strm.total_out;
+            deflateEnd(&strm);
+        });
+        if (failed) {
+            std::cerr << "CPU deflate failed" << std::endl;
+            m_err_code = 1;
+            return 0;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t index = (blk + i) * block_size_in_bytes;
+            uint32_t block_size = block_size_in_bytes;
+            if (index + block_size > input_size) block_size = input_size - index;
+
+            std::memcpy(&out[outIdx], blk_out[i].data(), blk_size[i]);
+            outIdx += blk_size[i];
+            m_index.add(blk_size[i], block_size);
+        }
+    }
+    return outIdx;
+}
+
+// CPU backend decompression, without a block index the stream can only
+// be inflated serially, see decompress_range
+uint32_t xfZlib::_decompress_cpu(const uint8_t* in, uint8_t* out, uint64_t input_size, uint64_t max_outbuf_size) {
+    uint32_t hsize = zlib_header_size(in);
+    if (input_size <= hsize) return 0;
+
+    z_stream strm = {};
+    if (inflateInit2(&strm, -15) != Z_OK) return 0;
+    strm.next_in = const_cast<uint8_t*>(&in[hsize]);
+    strm.avail_in = input_size - hsize;
+    strm.next_out = out;
+    strm.avail_out = max_outbuf_size;
+
+    // Trailer (adler32/crc32) following the final block is not consumed
+    int ret = inflate(&strm, Z_FINISH);
+    uint32_t debytes = strm.total_out;
+    inflateEnd(&strm);
+
+    if (ret != Z_STREAM_END) {
+        std::cerr << "CPU inflate failed " << ret << std::endl;
+        return 0;
+    }
+    return debytes;
+}
+
+// Inflate one independent block, block ends on a sync flush marker
+// instead of a final block so Z_STREAM_END is not expected
+static bool inflate_block(const uint8_t* src, uint32_t comp_size, uint8_t* dst, uint32_t raw_size) {
+    z_stream strm = {};
+    if (inflateInit2(&strm, -15) != Z_OK) return false;
+    strm.next_in = const_cast<uint8_t*>(src);
+    strm.avail_in = comp_size;
+    strm.next_out = dst;
+    strm.avail_out = raw_size;
+
+    int ret = inflate(&strm, Z_SYNC_FLUSH);
+    bool done = (ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR) && (strm.total_out == raw_size);
+    inflateEnd(&strm);
+    return done;
+}
+
+// Blocks are inflated on host threads as the decompress kernels
+// consume a whole stream from its header
+uint64_t xfZlib::decompress_range(
+    const uint8_t* in, const xfBlockIndex& index, uint64_t offset, uint64_t length, uint8_t* out) {
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+    return index.decode_range(*m_pool, in + index.base(), 0, offset, length, out, inflate_block);
+}
+
+uint64_t xfZlib::decompress_range_file(
+    const std::string& inFile_name, const xfBlockIndex& index, uint64_t offset, uint64_t length, uint8_t* out) {
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+    return index.decode_range_file(*m_pool, inFile_name, offset, length, out, inflate_block);
+}
+
+void xfZlib::set_dictionary(const uint8_t* dict, uint32_t dict_size) {
+    // Older bytes are out of the 32KB deflate window
+    const uint32_t c_window = 32 * 1024;
+    if (dict == nullptr) dict_size = 0;
+    if (dict_size > c_window) {
+        dict += dict_size - c_window;
+        dict_size = c_window;
+    }
+    m_dict.assign(dict, dict + dict_size);
+}
+
+// Every task owns a contiguous range of messages so a deflate state is
+// initialized once per range and only reset per message. Messages are
+// written at worst case offsets and compacted afterwards.
+uint64_t xfZlib::compress_batch(
+    const uint8_t* const* in, const uint32_t* in_size, uint32_t count, uint8_t* out, uint32_t* out_size) {
+    if (count == 0) return 0;
+    if (m_backend == FPGA_BACKEND && (m_cdflow == BOTH || m_cdflow == COMP_ONLY) && m_dict.empty())
+        return _compress_batch_fpga(in, in_size, count, out, out_size);
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+
+    std::vector<uint64_t> out_idx(count);
+    uint64_t bound = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        out_idx[i] = bound;
+        // Dictionary id adds 4 bytes to the zlib header
+        bound += compressBound(in_size[i]) + 4;
+    }
+
+    std::atomic<bool> failed{false};
+    uint32_t ntasks = m_pool->size() * 4;
+    if (ntasks > count) ntasks = count;
+    m_pool->parallel_for(ntasks, [&](uint32_t task) {
+        z_stream strm = {};
+        // Level 1 matches the fast mode of the kernels
+        if (deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            failed = true;
+            return;
+        }
+        uint32_t first = (uint64_t)task * count / ntasks;
+        uint32_t last = (uint64_t)(task + 1) * count / ntasks;
+        for (uint32_t i = first; i < last; i++) {
+            deflateReset(&strm);
+            if (!m_dict.empty() && deflateSetDictionary(&strm, m_dict.data(), m_dict.size()) != Z_OK) {
+                failed = true;
+                break;
+            }
+            strm.next_in = const_cast<uint8_t*>(in[i]);
+            strm.avail_in = in_size[i];
+            strm.next_out = &out[out_idx[i]];
+            strm.avail_out = compressBound(in_size[i]) + 4;
+            if (deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+                failed = true;
+                break;
+            }
+            out_size[i] = strm.total_out;
+        }
+        deflateEnd(&strm);
+    });
+    if (failed) {
+        std::cerr << "Batch deflate failed" << std::endl;
+        return 0;
+    }
+
+    uint64_t outIdx = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        std::memmove(&out[outIdx], &out[out_idx[i]], out_size[i]);
+        outIdx += out_size[i];
+    }
+    return outIdx;
+}
+
+// Messages are placed one per block slot of the host buffer and the block
+// size array carries the message sizes. The kernel blocks are byte aligned
+// and not final, so a message is the zlib header, its block, an empty final
+// stored block and the adler32. Empty messages, messages larger than a
+// block, or blocks over the output bound of a message are deflated on host.
+uint64_t xfZlib::_compress_batch_fpga(
+    const uint8_t* const* in, const uint32_t* in_size, uint32_t count, uint8_t* out, uint32_t* out_size) {
+    cl_int err;
+    uint32_t block_size_in_kb = BLOCK_SIZE_IN_KB;
+    uint32_t block_size_in_bytes = block_size_in_kb * 1024;
+    uint32_t max_slots = HOST_BUFFER_SIZE / block_size_in_bytes;
+    const uint8_t c_final_block[] = {0x01, 0x00, 0x00, 0xff, 0xff};
+    // zlib header, final block and adler32 around the kernel block
+    const uint32_t c_frame_size = 2 + sizeof(c_final_block) + 4;
+
+    z_stream strm = {};
+    if (deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        std::cerr << "Batch deflate failed" << std::endl;
+        return 0;
+    }
+
+    std::vector<uint32_t> slot_msg(max_slots);
+    uint64_t outIdx = 0;
+    bool failed = false;
+    for (uint32_t i = 0; i < count && !failed;) {
+        uint32_t first = i;
+        uint32_t nslots = 0;
+        for (; i < count && nslots < max_slots; i++) {
+            if (in_size[i] == 0 || in_size[i] > block_size_in_bytes) continue;
+            std::memcpy(h_buf_in[0][0].data() + (uint64_t)nslots * block_size_in_bytes, in[i], in_size[i]);
+            h_blksize[0][0][nslots] = in_size[i];
+            slot_msg[nslots++] = i;
+        }
+
+        if (nslots) {
+            uint32_t input_size = nslots * block_size_in_bytes;
+            int narg = 0;
+            OCL_CHECK(err, err = compress_kernel[0]->setArg(narg++, *(buffer_input[0][0])));
+            OCL_CHECK(err, err = compress_kernel[0]->setArg(narg++, *(buffer_lz77_output[0][0])));
+            OCL_CHECK(err, err = compress_kernel[0]->setArg(narg++, *(buffer_compress_size[0][0])));
+            OCL_CHECK(err, err = compress_kernel[0]->setArg(narg++, *(buffer_inblk_size[0][0])));
+            OCL_CHECK(err, err = compress_kernel[0]->setArg(narg++, *(buffer_dyn_ltree_freq[0][0])));
+            OCL_CHECK(err, err = compress_kernel[0]->setArg(narg++, *(buffer_dyn_dtree_freq[0][0])));
+            OCL_CHECK(err, err = compress_kernel[0]->setArg(narg++, block_size_in_kb));
+            OCL_CHECK(err, err = compress_kernel[0]->setArg(narg++, input_size));
+
+            narg = 0;
+            OCL_CHECK(err, err = huffman_kernel[0]->setArg(narg++, *(buffer_lz77_output[0][0])));
+            OCL_CHECK(err, err = huffman_kernel[0]->setArg(narg++, *(buffer_dyn_ltree_freq[0][0])));
+            OCL_CHECK(err, err = huffman_kernel[0]->setArg(narg++, *(buffer_dyn_dtree_freq[0][0])));
+            OCL_CHECK(err, err = huffman_kernel[0]->setArg(narg++, *(buffer_zlib_output[0][0])));
+            OCL_CHECK(err, err = huffman_kernel[0]->setArg(narg++, *(buffer_compress_size[0][0])));
+            OCL_CHECK(err, err = huffman_kernel[0]->setArg(narg++, *(buffer_inblk_size[0][0])));
+            OCL_CHECK(err, err = huffman_kernel[0]->setArg(narg++, block_size_in_kb));
+            OCL_CHECK(err, err = huffman_kernel[0]->setArg(narg++, input_size));
+
+            OCL_CHECK(err, err = m_q[0]->enqueueMigrateMemObjects({*(buffer_input[0][0]), *(buffer_inblk_size[0][0])},
+                                                                  0 /* 0 means from host*/));
+            OCL_CHECK(err, err = m_q[0]->enqueueTask(*compress_kernel[0]));
+            OCL_CHECK(err, err = m_q[0]->enqueueTask(*huffman_kernel[0]));
+            OCL_CHECK(err, err = m_q[0]->enqueueMigrateMemObjects(
+                               {*(buffer_zlib_output[0][0]), *(buffer_compress_size[0][0])}, CL_MIGRATE_MEM_OBJECT_HOST));
+            OCL_CHECK(err, err = m_q[0]->finish());
+        }
+
+        // Output keeps the message order
+        uint32_t slot = 0;
+        for (uint32_t m = first; m < i && !failed; m++) {
+            uint32_t compressed_size = 0;
+            if (slot < nslots && slot_msg[slot] == m) {
+                uint32_t kernel_size = h_compressSize[0][0][slot];
+                if (kernel_size > 0 && kernel_size <= block_size_in_bytes &&
+                    kernel_size + c_frame_size <= compressBound(in_size[m]) + 4) {
+                    uint8_t* msg = &out[outIdx];
+                    msg[0] = 0x78;
+                    msg[1] = 0x01;
+                    std::memcpy(&msg[2], h_buf_zlibout[0][0].data() + (uint64_t)slot * block_size_in_bytes,
+                                kernel_size);
+                    std::memcpy(&msg[2 + kernel_size], c_final_block, sizeof(c_final_block));
+                    uint32_t adler = adler32(adler32(0L, Z_NULL, 0), in[m], in_size[m]);
+                    uint8_t* trailer = &msg[2 + kernel_size + sizeof(c_final_block)];
+                    for (int b = 0; b < 4; b++) trailer[b] = adler >> (24 - 8 * b);
+                    compressed_size = kernel_size + c_frame_size;
+                }
+                slot++;
+            }
+            if (compressed_size == 0) {
+                deflateReset(&strm);
+                strm.next_in = const_cast<uint8_t*>(in[m]);
+                strm.avail_in = in_size[m];
+                strm.next_out = &out[outIdx];
+                strm.avail_out = compressBound(in_size[m]) + 4;
+                if (deflate(&strm, Z_FINISH) != Z_STREAM_END) failed = true;
+                compressed_size = strm.total_out;
+            }
+            out_size[m] = compressed_size;
+            outIdx += compressed_size;
+        }
+    }
+    deflateEnd(&strm);
+
+    if (failed) {
+        std::cerr << "Batch deflate failed" << std::endl;
+        return 0;
+    }
+    return outIdx;
+}
+
+uint64_t xfZlib::decompress_batch(
+    const uint8_t* in, const uint32_t* in_size, uint32_t count, uint8_t* const* out, const uint32_t* out_size) {
+    if (count == 0) return 0;
+    if (!m_pool) m_pool.reset(new xfThreadPool());
+
+    std::vector<uint64_t> in_idx(count);
+    uint64_t inIdx = 0, total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        in_idx[i] = inIdx;
+        inIdx += in_size[i];
+        total += out_size[i];
+    }
+
+    std::atomic<bool> failed{false};
+    uint32_t ntasks = m_pool->size() * 4;
+    if (ntasks > count) ntasks = count;
+    m_pool->parallel_for(ntasks, [&](uint32_t task) {
+        z_stream strm = {};
+        if (inflateInit(&strm) != Z_OK) {
+            failed = true;
+            return;
+        }
+        uint32_t first = (uint64_t)task * count / ntasks;
+        uint32_t last = (uint64_t)(task + 1) * count / ntasks;
+        for (uint32_t i = first; i < last; i++) {
+            inflateReset(&strm);
+            strm.next_in = const_cast<uint8_t*>(&in[in_idx[i]]);
+            strm.avail_in = in_size[i];
+            // inflate rejects a null output even for empty messages
+            uint8_t empty;
+            strm.next_out = out_size[i] ? out[i] : &empty;
+            strm.avail_out = out_size[i];
+            int ret = inflate(&strm, Z_FINISH);
+            // Dictionary adler32 is checked by inflateSetDictionary
+            if (ret == Z_NEED_DICT && !m_dict.empty() &&
+                inflateSetDictionary(&strm, m_dict.data(), m_dict.size()) == Z_OK)
+                ret = inflate(&strm, Z_FINISH);
+            if (ret != Z_STREAM_END || strm.total_out != out_size[i]) {
+                failed = true;
+                break;
+            }
+        }
+        inflateEnd(&strm);
+    });
+    if (failed) {
+        std::cerr << "Batch inflate failed" << std::endl;
+        return 0;
+    }
+    return total;
+}
+
+uint64_t xfZlib::compress_file_stream(std::string& inFile_name, std::string& outFile_name, uint64_t input_size) {
+    std::chrono::duration<double, std::nano> compress_API_time_ns_1(0);
+    std::ifstream inFile(inFile_name.c_str(), std::ifstream::binary);
+    std::ofstream outFile(outFile_name.c_str(), std::ofstream::binary);
+
+    if (!inFile) {
+        std::cout << "Unable to open file";
+        exit(1);
+    }
+
+    // Only one host buffer worth of input and output is staged
+    // at a time irrespective of file size
+    uint32_t host_buffer_size = HOST_BUFFER_SIZE;
+    std::vector<uint8_t, zlib_aligned_allocator<uint8_t> > zlib_in;
+    std::vector<uint8_t, zlib_aligned_allocator<uint8_t> > zlib_out;
+
+    MEM_ALLOC_CHECK(zlib_in.resize(host_buffer_size), host_buffer_size, "Input Buffer");
+    MEM_ALLOC_CHECK(zlib_out.resize(host_buffer_size * 2), host_buffer_size * 2, "Output Buffer");
+
+#ifdef GZIP_MODE
+    gzip_header(inFile_name, outFile);
+#else
+    outFile.put(120);
+    outFile.put(1);
+#endif
+
+    auto compress_API_start = std::chrono::high_resolution_clock::now();
+    uint64_t enbytes = 0;
+
+    compress_stream_init();
+    for (uint64_t inIdx = 0; inIdx < input_size;) {
+        uint32_t chunk_size = host_buffer_size;
+        if (inIdx + chunk_size > input_size) chunk_size = input_size - inIdx;
+        inFile.read((char*)zlib_in.data(), chunk_size);
+        inIdx += chunk_size;
+
+        for (uint64_t pushed = 0; pushed < chunk_size;) {
+            pushed += compress_stream_push(zlib_in.data() + pushed, chunk_size - pushed);
+            // All host buffers are in flight, drain the oldest one
+            if (pushed < chunk_size) {
+                uint64_t outbytes = compress_stream_pull(zlib_out.data(), zlib_out.size());
+                outFile.write((char*)zlib_out.data(), outbytes);
+                enbytes += outbytes;
+            }
+        }
+    }
+    compress_stream_finish();
+
+    for (uint64_t outbytes = 0; (outbytes = compress_stream_pull(zlib_out.data(), zlib_out.size())) > 0;) {
+        outFile.write((char*)zlib_out.data(), outbytes);
+        enbytes += outbytes;
+    }
+
+    auto compress_API_end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration<double, std::nano>(compress_API_end - compress_API_start);
+    compress_API_time_ns_1 += duration;
+
+    float throughput_in_mbps_1 = (float)input_size * 1000 / compress_API_time_ns_1.count();
+    std::cout << std::fixed << std::setprecision(3) << throughput_in_mbps_1;
+
+    m_index.set_base(file_header_size(inFile_name));
+#ifdef GZIP_MODE
+    gzip_trailer(inFile_name, outFile);
+#else
+    outFile.put(0);
+    outFile.put(0);
+    outFile.put(0);
+    outFile.put(0);
+    outFile.put(0);
+#endif
+
+    // Close file
+    inFile.close();
+    outFile.close();
+    return enbytes;
+}
+
+uint64_t xfZlib::decompress_file_stream(std::string& inFile_name,
+                                        std::string& outFile_name,
+                                        uint64_t input_size,
+                                        int cu) {
+    std::chrono::duration<double, std::nano> decompress_API_time_ns_1(0);
+    std::ifstream inFile(inFile_name.c_str(), std::ifstream::binary);
+    std::ofstream outFile(outFile_name.c_str(), std::ofstream::binary);
+
+    if (!inFile) {
+        std::cout << "Unable to open file";
+        exit(1);
+    }
+
+    uint32_t inBufferSize = INPUT_BUFFER_SIZE;
+    uint32_t outBufferSize = OUTPUT_BUFFER_SIZE;
+    std::vector<uint8_t, zlib_aligned_allocator<uint8_t> > in;
+    std::vector<uint8_t, zlib_aligned_allocator<uint8_t> > out;
+
+    MEM_ALLOC_CHECK(in.resize(inBufferSize), inBufferSize, "Input Buffer");
+    MEM_ALLOC_CHECK(out.resize(outBufferSize), outBufferSize, "Output Buffer");
+
+    auto decompress_API_start = std::chrono::high_resolution_clock::now();
+    if (decompress_stream_init(input_size, cu)) return 0;
+
+    for (uint64_t inIdx = 0; inIdx < input_size;) {
+        uint32_t chunk_size = inBufferSize;
+        if (inIdx + chunk_size > input_size) chunk_size = input_size - inIdx;
+        inFile.read((char*)in.data(), chunk_size);
+        inIdx += chunk_size;
+
+        for (uint64_t pushed = 0; pushed < chunk_size;) {
+            uint64_t inbytes = decompress_stream_push(in.data() + pushed, chunk_size - pushed);
+            if (error_code()) {
+                decompress_stream_finish();
+                std::cerr << "Decompression Failed" << std::endl;
+                return 0;
+            }
+            pushed += inbytes;
+
+            uint64_t outbytes = decompress_stream_pull(out.data(), outBufferSize);
+            outFile.write((char*)out.data(), outbytes);
+            if (inbytes == 0 && outbytes == 0) std::this_thread::yield();
+        }
+    }
+
+    for (uint64_t outbytes = 0; (outbytes = decompress_stream_pull(out.data(), outBufferSize)) > 0;) {
+        outFile.write((char*)out.data(), outbytes);
+    }
+    uint64_t debytes = decompress_stream_finish();
+
+    auto decompress_API_end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration<double, std::nano>(decompress_API_end - decompress_API_start);
+    decompress_API_time_ns_1 = duration;
+
+    if (debytes == 0) {
+        std::cerr << "Decompression Failed" << std::endl;
+        return 0;
+    }
+
+    float throughput_in_mbps_1 = (float)debytes * 1000 / decompress_API_time_ns_1.count();
+    std::cout << std::fixed << std::setprecision(3) << throughput_in_mbps_1;
+
+    // Close file
+    inFile.close();
+    outFile.close();
+
+    return debytes;
+}
+
+void xfZlib::compress_stream_init() {
+    cl_int err;
+    const uint32_t c_slots = C_COMPUTE_UNIT * OVERLAP_BUF_COUNT;
+
+    if (m_backend == CPU_BACKEND) {
+        // One chunk wide enough for the whole pool is staged at a time
+        uint32_t chunk_size = m_pool->size() * BLOCK_SIZE_IN_KB * 1024;
+        if (chunk_size < HOST_BUFFER_SIZE) chunk_size = HOST_BUFFER_SIZE;
+        m_cpu_in.resize(chunk_size);
+        m_cpu_out.resize(chunk_size * 2);
+    } else {
+        // Drop whatever is left from previous stream
+        for (uint32_t i = 0; i < m_cstrm_inflight; i++) {
+            OCL_CHECK(err, err = m_cstrm_event[(m_cstrm_tail + i) % c_slots].wait());
+        }
+    }
+
+    m_cstrm_fill = 0;
+    m_cstrm_head = 0;
+    m_cstrm_tail = 0;
+    m_cstrm_inflight = 0;
+    m_cstrm_blk = 0;
+    m_cstrm_off = 0;
+    m_cstrm_trailer = 0;
+    m_cstrm_finish = false;
+    m_index.clear(INDEX_DEFLATE);
+}
+
+// Launch lz77 and huffman kernels on the data staged in a slot
+void xfZlib::_compress_stream_launch(uint32_t slot) {
+    cl_int err;
+    uint32_t block_size_in_kb = BLOCK_SIZE_IN_KB;
+    uint32_t block_size_in_bytes = block_size_in_kb * 1024;
+    uint32_t cu = slot % C_COMPUTE_UNIT;
+    uint32_t flag = slot / C_COMPUTE_UNIT;
+    uint32_t chunk_size = m_cstrm_size[slot];
+
+    // Figure out block sizes of this chunk
+    uint32_t idxblk = 0;
+    for (uint32_t i = 0; i < chunk_size; i += block_size_in_bytes) {
+        uint32_t block_size = block_size_in_bytes;
+        if (i + block_size > chunk_size) {
+            block_size = chunk_size - i;
+        }
+        (h_blksize[cu][flag]).data()[idxblk++] = block_size;
+    }
+
+    // Set kernel arguments
+    int narg = 0;
+    OCL_CHECK(err, err = compress_kernel[cu]->setArg(narg++, *(buffer_input[cu][flag])));
+    OCL_CHECK(err, err = compress_kernel[cu]->setArg(narg++, *(buffer_lz77_output[cu][flag])));
+    OCL_CHECK(err, err = compress_kernel[cu]->setArg(narg++, *(buffer_compress_size[cu][flag])));
+    OCL_CHECK(err, err = compress_kernel[cu]->setArg(narg++, *(buffer_inblk_size[cu][flag])));
+    OCL_CHECK(err, err = compress_kernel[cu]->setArg(narg++, *(buffer_dyn_ltree_freq[cu][flag])));
+    OCL_CHECK(err, err = compress_kernel[cu]->setArg(narg++, *(buffer_dyn_dtree_freq[cu][flag])));
+    OCL_CHECK(err, err = compress_kernel[cu]->setArg(narg++, block_size_in_kb));
+    OCL_CHECK(err, err = compress_kernel[cu]->setArg(narg++, chunk_size));
+
+    narg = 0;
+    OCL_CHECK(err, err = huffman_kernel[cu]->setArg(narg++, *(buffer_lz77_output[cu][flag])));
+    OCL_CHECK(err, err = huffman_kernel[cu]->setArg(narg++, *(buffer_dyn_ltree_freq[cu][flag])));
+    OCL_CHECK(err, err = huffman_kernel[cu]->setArg(narg++, *(buffer_dyn_dtree_freq[cu][flag])));
+    OCL_CHECK(err, err = huffman_kernel[cu]->setArg(narg++, *(buffer_zlib_output[cu][flag])));
+    OCL_CHECK(err, err = huffman_kernel[cu]->setArg(narg++, *(buffer_compress_size[cu][flag])));
+    OCL_CHECK(err, err = huffman_kernel[cu]->setArg(narg++, *(buffer_inblk_size[cu][flag])));
+    OCL_CHECK(err, err = huffman_kernel[cu]->setArg(narg++, block_size_in_kb));
+    OCL_CHECK(err, err = huffman_kernel[cu]->setArg(narg++, chunk_size));
+
+    // Migrate memory - Map host to device buffers
+    OCL_CHECK(err, err = m_q[slot]->enqueueMigrateMemObjects(
+                       {*(buffer_input[cu][flag]), *(buffer_inblk_size[cu][flag])}, 0 /* 0 means from host*/));
+
+    // LZ77 Compress Fire Kernel invocation
+    OCL_CHECK(err, err = m_q[slot]->enqueueTask(*compress_kernel[cu]));
+
+    // Huffman Fire Kernel invocation
+    OCL_CHECK(err, err = m_q[slot]->enqueueTask(*huffman_kernel[cu]));
+
+    OCL_CHECK(err, err = m_q[slot]->enqueueMigrateMemObjects({*(buffer_compress_size[cu][flag])},
+                                                             CL_MIGRATE_MEM_OBJECT_HOST, NULL, &(m_cstrm_event[slot])));
+    OCL_CHECK(err, err = m_q[slot]->flush());
+}
+
+uint64_t xfZlib::compress_stream_push(const uint8_t* in, uint64_t input_size) {
+    const uint32_t c_slots = C_COMPUTE_UNIT * OVERLAP_BUF_COUNT;
+    uint32_t host_buffer_size = HOST_BUFFER_SIZE;
+    uint64_t inIdx = 0;
+
+    // CPU backend keeps a single slot, compressed once staging is full
+    if (m_backend == CPU_BACKEND) {
+        while ((inIdx < input_size) && (m_cstrm_inflight == 0)) {
+            uint64_t size = m_cpu_in.size() - m_cstrm_fill;
+            if (size > input_size - inIdx) size = input_size - inIdx;
+
+            std::memcpy(m_cpu_in.data() + m_cstrm_fill, &in[inIdx], size);
+            m_cstrm_fill += size;
+            inIdx += size;
+
+            if (m_cstrm_fill == m_cpu_in.size()) {
+                m_cstrm_size[0] = _compress_cpu(m_cpu_in.data(), m_cpu_out.data(), m_cstrm_fill);
+                m_cstrm_fill = 0;
+                m_cstrm_off = 0;
+                m_cstrm_inflight = 1;
+            }
+        }
+        return inIdx;
+    }
+
+    // Head slot is free as long as not every slot is in flight
+    while ((inIdx < input_size) && (m_cstrm_inflight < c_slots)) {
+        uint32_t slot = m_cstrm_head;
+        uint32_t cu = slot % C_COMPUTE_UNIT;
+        uint32_t flag = slot / C_COMPUTE_UNIT;
+
+        uint64_t size = host_buffer_size - m_cstrm_fill;
+        if (size > input_size - inIdx) size = input_size - inIdx;
+
+        std::memcpy(h_buf_in[cu][flag].data() + m_cstrm_fill, &in[inIdx], size);
+        m_cstrm_fill += size;
+        inIdx += size;
+
+        if (m_cstrm_fill == host_buffer_size) {
+            m_cstrm_size[slot] = m_cstrm_fill;
+            _compress_stream_launch(slot);
+            m_cstrm_fill = 0;
+            m_cstrm_head = (m_cstrm_head + 1) % c_slots;
+            m_cstrm_inflight++;
+        }
+    }
+    return inIdx;
+}
+
+void xfZlib::compress_stream_finish() {
+    const uint32_t c_slots = C_COMPUTE_UNIT * OVERLAP_BUF_COUNT;
+    if (m_cstrm_finish) return;
+
+    // Partially filled head slot is never in flight
+    if ((m_cstrm_fill > 0) && (m_backend == CPU_BACKEND)) {
+        m_cstrm_size[0] = _compress_cpu(m_cpu_in.data(), m_cpu_out.data(), m_cstrm_fill);
+        m_cstrm_fill = 0;
+        m_cstrm_off = 0;
+        m_cstrm_inflight = 1;
+    } else if (m_cstrm_fill > 0) {
+        m_cstrm_size[m_cstrm_head] = m_cstrm_fill;
+        _compress_stream_launch(m_cstrm_head);
+        m_cstrm_fill = 0;
+        m_cstrm_head = (m_cstrm_head + 1) % c_slots;
+        m_cstrm_inflight++;
+    }
+    m_cstrm_finish = true;
+}
+
+uint64_t xfZlib::compress_stream_pull(uint8_t* out, uint64_t out_size) {
+    cl_int err;
+    const uint32_t c_slots = C_COMPUTE_UNIT * OVERLAP_BUF_COUNT;
+    uint32_t block_size_in_bytes = BLOCK_SIZE_IN_KB * 1024;
+    uint64_t outIdx = 0;
+
+    if ((m_backend == CPU_BACKEND) && (m_cstrm_inflight > 0)) {
+        uint64_t size = m_cstrm_size[0] - m_cstrm_off;
+        if (size > out_size) size = out_size;
+
+        std::memcpy(out, m_cpu_out.data() + m_cstrm_off, size);
+        outIdx += size;
+        m_cstrm_off += size;
+        if (m_cstrm_off == m_cstrm_size[0]) m_cstrm_inflight = 0;
+    }
+
+    while ((m_backend == FPGA_BACKEND) && (m_cstrm_inflight > 0) && (outIdx < out_size)) {
+        uint32_t slot = m_cstrm_tail;
+        uint32_t cu = slot % C_COMPUTE_UNIT;
+        uint32_t flag = slot / C_COMPUTE_UNIT;
+        uint32_t nblocks = (m_cstrm_size[slot] - 1) / block_size_in_bytes + 1;
+
+        // Wait on oldest chunk to finish
+        OCL_CHECK(err, err = m_cstrm_event[slot].wait());
+
+        // Copy the data from various blocks in concatinated manner
+        while ((m_cstrm_blk < nblocks) && (outIdx < out_size)) {
+            uint32_t compressed_size = (h_compressSize[cu][flag].data())[m_cstrm_blk];
+            uint64_t size = compressed_size - m_cstrm_off;
+            if (size > out_size - outIdx) size = out_size - outIdx;
+
+            if (size > 0) {
+                OCL_CHECK(err, err = m_q[slot]->enqueueReadBuffer(*(buffer_zlib_output[cu][flag]), CL_TRUE,
+                                                                  m_cstrm_blk * block_size_in_bytes + m_cstrm_off,
+                                                                  size * sizeof(uint8_t), &out[outIdx]));
+            }
+            outIdx += size;
+            m_cstrm_off += size;
+
+            if (m_cstrm_off == compressed_size) {
+                uint32_t block_size = block_size_in_bytes;
+                if ((m_cstrm_blk + 1) * block_size_in_bytes > m_cstrm_size[slot])
+                    block_size = m_cstrm_size[slot] - m_cstrm_blk * block_size_in_bytes;
+                m_index.add(compressed_size, block_size);
+                m_cstrm_blk++;
+                m_cstrm_off = 0;
+            }
+        }
+
+        // Slot is free to take input again
+        if (m_cstrm_blk == nblocks) {
+            m_cstrm_blk = 0;
+            m_cstrm_tail = (m_cstrm_tail + 1) % c_slots;
+            m_cstrm_inflight--;
+        }
+    }
+
+    // zlib special block based on Z_SYNC_FLUSH
+    if (m_cstrm_finish && (m_cstrm_inflight == 0)) {
+        const uint8_t c_sync_flush[] = {0x01, 0x00, 0x00, 0xff, 0xff};
+        while ((m_cstrm_trailer < sizeof(c_sync_flush)) && (outIdx < out_size)) {
+            out[outIdx++] = c_sync_flush[m_cstrm_trailer++];
+        }
+    }
+    return outIdx;
+}
+
+int xfZlib::decompress_stream_init(uint64_t input_size, int cu) {
+    m_dstrm_cu = cu;
+    m_dstrm_in_size = input_size;
+    m_dstrm_in_done = 0;
+    m_dstrm_out_done = 0;
+    m_dstrm_wfill = 0;
+    m_dstrm_widx = 0;
+    m_dstrm_ridx = 0;
+    m_dstrm_roff = 0;
+    m_dstrm_rsize = 0;
+    m_dstrm_started = false;
+    m_dstrm_rvalid = false;
+    m_dstrm_last = false;
+    m_dstrm_done = false;
+
+    m_dstrm_inbuf_size = INPUT_BUFFER_SIZE;
+    m_dstrm_outbuf_size = OUTPUT_BUFFER_SIZE;
+    if (input_size < m_dstrm_inbuf_size) m_dstrm_inbuf_size = input_size;
+
+    if (input_size == 0) {
+        std::cerr << "\nEmpty input stream" << std::endl;
+        return 1;
+    }
+
+    if (m_backend == CPU_BACKEND) {
+        if (m_dstrm_zs) inflateEnd(m_dstrm_zs);
+        DELETE_OBJ(m_dstrm_zs);
+        m_dstrm_zs = new z_stream();
+        if (inflateInit2(m_dstrm_zs, -15) != Z_OK) {
+            DELETE_OBJ(m_dstrm_zs);
+            return 1;
+        }
+        m_cpu_in.resize(m_dstrm_inbuf_size);
+    }
+    return 0;
+}
+
+// Enqueue data writer kernel on a filled input buffer
+void xfZlib::_decompress_stream_write(uint8_t cbf_idx, uint32_t size) {
+    cl_int err;
+    int cu = m_dstrm_cu;
+
+    OCL_CHECK(err, err = data_writer_kernel[cu]->setArg(0, *(buffer_dec_input[cbf_idx])));
+    OCL_CHECK(err, err = data_writer_kernel[cu]->setArg(1, size));
+
+    OCL_CHECK(err, err = m_q_wr[cu]->enqueueMigrateMemObjects({*(buffer_dec_input[cbf_idx])}, 0, NULL, NULL));
+    OCL_CHECK(err, err = m_q_wr[cu]->enqueueTask(*data_writer_kernel[cu], NULL, &(m_dstrm_wevent[cbf_idx])));
+    OCL_CHECK(err, err = m_q_wr[cu]->flush());
+}
+
+// Enqueue data reader kernel and migration back to host on an output buffer
+void xfZlib::_decompress_stream_read(uint8_t cbf_idx) {
+    cl_int err;
+    int cu = m_dstrm_cu;
+    cl::Event kernelReadEvent;
+    std::vector<cl::Event> kernelReadWait;
+
+    OCL_CHECK(err, err = data_reader_kernel[cu]->setArg(0, *(buffer_dec_zlib_output[cbf_idx])));
+    OCL_CHECK(err, err = data_reader_kernel[cu]->setArg(1, *(m_dstrm_size_buf[cbf_idx])));
+
+    OCL_CHECK(err, err = m_q_rd[cu]->enqueueTask(*data_reader_kernel[cu], NULL, &kernelReadEvent));
+    kernelReadWait.push_back(kernelReadEvent);
+
+    OCL_CHECK(err, err = m_q_rdd[cu]->enqueueMigrateMemObjects(
+                       {*(m_dstrm_size_buf[cbf_idx]), *(buffer_dec_zlib_output[cbf_idx])}, CL_MIGRATE_MEM_OBJECT_HOST,
+                       &kernelReadWait, &(m_dstrm_revent[cbf_idx])));
+    OCL_CHECK(err, err = m_q_rd[cu]->flush());
+}
+
+uint64_t xfZlib::decompress_stream_push(const uint8_t* in, uint64_t input_size) {
+    cl_int err;
+    int cu = m_dstrm_cu;
+    uint64_t inIdx = 0;
+
+    if ((input_size == 0) || (m_dstrm_in_done == m_dstrm_in_size)) return 0;
+
+    // CPU backend stages input for inflate in decompress_stream_pull
+    if (m_backend == CPU_BACKEND) {
+        z_stream* zs = m_dstrm_zs;
+        if (!m_dstrm_started) {
+            if (_check_header(in)) {
+                m_err_code = 1;
+                return 0;
+            }
+            inIdx = zlib_header_size(in);
+            m_dstrm_in_done += inIdx;
+            m_dstrm_started = true;
+        }
+
+        // Move unconsumed input to the start of staging buffer
+        if ((zs->avail_in > 0) && (zs->next_in != m_cpu_in.data()))
+            std::memmove(m_cpu_in.data(), zs->next_in, zs->avail_in);
+        zs->next_in = m_cpu_in.data();
+
+        uint64_t size = m_cpu_in.size() - zs->avail_in;
+        if (size > input_size - inIdx) size = input_size - inIdx;
+        std::memcpy(m_cpu_in.data() + zs->avail_in, &in[inIdx], size);
+        zs->avail_in += size;
+        m_dstrm_in_done += size;
+        return inIdx + size;
+    }
+
+    // Kernels are started only once the header is known to be good
+    if (!m_dstrm_started) {
+        if (_check_header(in)) {
+            m_err_code = 1;
+            return 0;
+        }
+
+        for (int i = 0; i < DOUT_BUFFERCOUNT; i++) {
+            OCL_CHECK(err, m_dstrm_size_buf[i] =
+                               new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY,
+                                              2 * sizeof(uint32_t), h_dcompressSize_stream[i].data(), &err));
+        }
+        h_dcompressStatus.data()[0] = 0;
+        OCL_CHECK(err, m_dstrm_status_buf = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY,
+                                                           sizeof(uint32_t), h_dcompressStatus.data(), &err));
+
+        // set consistent buffer size to be read
+        OCL_CHECK(err, err = data_reader_kernel[cu]->setArg(2, *m_dstrm_status_buf));
+        OCL_CHECK(err, err = data_reader_kernel[cu]->setArg(3, m_dstrm_outbuf_size));
+
+        OCL_CHECK(err, err = decompress_kernel[cu]->setArg(0, (uint32_t)m_dstrm_in_size));
+        OCL_CHECK(err, err = m_q_dec[cu]->enqueueTask(*decompress_kernel[cu]));
+        OCL_CHECK(err, err = m_q_dec[cu]->flush());
+
+        // Keep all output buffers queued ahead of decompress kernel
+        for (uint8_t i = 0; i < DOUT_BUFFERCOUNT; i++) _decompress_stream_read(i);
+        m_dstrm_started = true;
+    }
+
+    while ((inIdx < input_size) && (m_dstrm_in_done < m_dstrm_in_size)) {
+        uint8_t cbf_idx = m_dstrm_widx % DIN_BUFFERCOUNT;
+
+        // Buffer can be refilled once (current - DIN_BUFFERCOUNT) writer kernel is done
+        if ((m_dstrm_wfill == 0) && (m_dstrm_widx >= DIN_BUFFERCOUNT)) {
+            cl_int status;
+            OCL_CHECK(err, status = m_dstrm_wevent[cbf_idx].getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>(&err));
+            if (status != CL_COMPLETE) break;
+        }
+
+        // set for last and other buffers
+        uint64_t bufOffset = (uint64_t)m_dstrm_widx * m_dstrm_inbuf_size;
+        uint32_t cBufSize = m_dstrm_inbuf_size;
+        if (bufOffset + cBufSize > m_dstrm_in_size) cBufSize = m_dstrm_in_size - bufOffset;
+
+        uint64_t size = cBufSize - m_dstrm_wfill;
+        if (size > input_size - inIdx) size = input_size - inIdx;
+
+        std::memcpy(h_dbufstream_in[cbf_idx].data() + m_dstrm_wfill, &in[inIdx], size);
+        m_dstrm_wfill += size;
+        m_dstrm_in_done += size;
+        inIdx += size;
+
+        if (m_dstrm_wfill == cBufSize) {
+            _decompress_stream_write(cbf_idx, cBufSize);
+            m_dstrm_wfill = 0;
+            m_dstrm_widx++;
+        }
+    }
+    return inIdx;
+}
+
+uint64_t xfZlib::decompress_stream_pull(uint8_t* out, uint64_t out_size) {
+    cl_int err;
+    uint64_t outIdx = 0;
+    if (!m_dstrm_started) return 0;
+
+    if (m_backend == CPU_BACKEND) {
+        if (m_dstrm_done) return 0;
+        z_stream* zs = m_dstrm_zs;
+        zs->next_out = out;
+        zs->avail_out = out_size;
+
+        // Z_BUF_ERROR only means no progress is possible until next push
+        int ret = inflate(zs, Z_NO_FLUSH);
+        outIdx = out_size - zs->avail_out;
+        m_dstrm_out_done += outIdx;
+        if (ret == Z_STREAM_END) {
+            m_dstrm_done = true;
+        } else if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+            std::cerr << "CPU inflate failed " << ret << std::endl;
+            m_err_code = 1;
+            m_dstrm_done = true;
+        }
+        return outIdx;
+    }
+
+    // Waiting is safe only when every input buffer has been handed to the device
+    bool blocking = (m_dstrm_in_done == m_dstrm_in_size);
+
+    while ((!m_dstrm_done) && (outIdx < out_size)) {
+        uint8_t cbf_idx = m_dstrm_ridx % DOUT_BUFFERCOUNT;
+
+        if (!m_dstrm_rvalid) {
+            if (!blocking) {
+                cl_int status;
+                OCL_CHECK(err, status = m_dstrm_revent[cbf_idx].getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>(&err));
+                if (status != CL_COMPLETE) break;
+            }
+            OCL_CHECK(err, err = m_dstrm_revent[cbf_idx].wait());
+
+            uint32_t raw_size = h_dcompressSize_stream[cbf_idx].data()[0];
+            // if output data size is multiple of buffer size, then (buffer_size + 1) is sent by reader kernel
+            if (raw_size > m_dstrm_outbuf_size) {
+                --raw_size;
+            }
+            if (raw_size != m_dstrm_outbuf_size) m_dstrm_last = true;
+            m_dstrm_rsize = raw_size;
+            m_dstrm_roff = 0;
+            m_dstrm_rvalid = true;
+        }
+
+        uint64_t size = m_dstrm_rsize - m_dstrm_roff;
+        if (size > out_size - outIdx) size = out_size - outIdx;
+        if (size > 0) std::memcpy(&out[outIdx], h_dbufstream_zlibout[cbf_idx].data() + m_dstrm_roff, size);
+        outIdx += size;
+        m_dstrm_roff += size;
+        m_dstrm_out_done += size;
+
+        // Buffer drained, hand it back to data reader kernel
+        if (m_dstrm_roff == m_dstrm_rsize) {
+            m_dstrm_rvalid = false;
+            m_dstrm_ridx++;
+            if (m_dstrm_last)
+                m_dstrm_done = true;
+            else
+                _decompress_stream_read(cbf_idx);
+        }
+    }
+    return outIdx;
+}
+
+uint64_t xfZlib::decompress_stream_finish() {
+    cl_int err;
+    int cu = m_dstrm_cu;
+
+    if (m_dstrm_zs) inflateEnd(m_dstrm_zs);
+    DELETE_OBJ(m_dstrm_zs);
+
+    if (m_dstrm_started && (m_backend == FPGA_BACKEND)) {
+        OCL_CHECK(err, err = m_q_wr[cu]->finish());
+        OCL_CHECK(err, err = m_q_dec[cu]->finish());
+        OCL_CHECK(err, err = m_q_rd[cu]->finish());
+        OCL_CHECK(err, err = m_q_rdd[cu]->finish());
+    }
+
+    for (int i = 0; i < DOUT_BUFFERCOUNT; i++) {
+        DELETE_OBJ(m_dstrm_size_buf[i]);
+    }
+    DELETE_OBJ(m_dstrm_status_buf);
+    m_dstrm_started = false;
+
+    return m_dstrm_out_done;
+}
@@ -0,0 +1,128 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "zlib_dispatch.hpp"
+
+using namespace xf::compression;
+
+xfZlibDispatch& xfZlibDispatch::instance() {
+    // Never destroyed, the runtime may already be gone when static
+    // destructors of a preloaded library run
+    static xfZlibDispatch* dispatch = new xfZlibDispatch();
+    return *dispatch;
+}
+
+xfZlibDispatch::xfZlibDispatch() {
+    const char* xclbin = getenv("XILINX_LIBZ_XCLBIN");
+    m_xclbin = xclbin ? xclbin : c_libz_xclbin;
+    if (!std::ifstream(m_xclbin.c_str(), std::ifstream::binary).good()) {
+#ifdef VERBOSE
+        std::cout << "Unable to open binary file, using SW solution" << std::endl;
+#endif
+        return;
+    }
+
+    const char* min_size = getenv("MIN_INPUT_SIZE");
+    m_threshold = min_size ? strtoull(min_size, nullptr, 0) : MEGA_BYTE;
+    const char* cu_id = getenv("XILINX_CU_ID");
+    if (cu_id) m_cu = atoi(cu_id);
+}
+
+uint64_t xfZlibDispatch::deflate(const uint8_t* in, uint64_t input_size, xfChunkChain& out) {
+    job_t job = {true, in, input_size, &out, 0, false};
+    return _submit(job);
+}
+
+uint64_t xfZlibDispatch::inflate(const uint8_t* in, uint64_t input_size, xfChunkChain& out) {
+    job_t job = {false, in, input_size, &out, 0, false};
+    return _submit(job);
+}
+
+// Calls queued while the device is busy are run by the next thread that
+// finds it idle, the running thread hands over after one batch so no
+// caller keeps serving others indefinitely
+uint64_t xfZlibDispatch::_submit(job_t& job) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_queue.push_back(&job);
+    while (!job.done) {
+        if (m_busy) {
+            m_cv.wait(lock);
+            continue;
+        }
+        m_busy = true;
+        std::deque<job_t*> batch;
+        batch.swap(m_queue);
+        lock.unlock();
+
+        for (auto j : batch) _run(*j);
+
+        lock.lock();
+        for (auto j : batch) j->done = true;
+        m_busy = false;
+        m_cv.notify_all();
+    }
+    return job.result;
+}
+
+void xfZlibDispatch::_run(job_t& job) {
+    xfZlib* xlz = _open(job.compress);
+    if (xlz == nullptr) return;
+
+    uint8_t* in = const_cast<uint8_t*>(job.in);
+    if (job.compress) {
+        // Worst case expansion same as compress_file
+        uint64_t bound = job.input_size * 2 + 1024;
+        if (m_cbuf.size() < bound) m_cbuf.resize(bound);
+        job.result = xlz->compress(in, m_cbuf.data(), job.input_size, HOST_BUFFER_SIZE);
+        if (job.result) job.out->append(m_cbuf.data(), job.result);
+    } else {
+        job.result = xlz->decompress_chain(in, job.input_size, *job.out, m_cu);
+    }
+
+    // Device left in an unknown state, reopened by the next call
+    if (xlz->error_code()) {
+        job.result = 0;
+        if (job.compress)
+            m_comp.reset();
+        else
+            m_decomp.reset();
+    }
+}
+
+xfZlib* xfZlibDispatch::_open(bool compress) {
+    std::unique_ptr<xfZlib>& xlz = compress ? m_comp : m_decomp;
+    bool& failed = compress ? m_comp_failed : m_decomp_failed;
+    if (xlz || failed) return xlz.get();
+
+    const uint8_t c_max_cr = 0;
+    if (compress)
+        xlz.reset(new xfZlib(m_xclbin, c_max_cr, COMP_ONLY, 0, 0, DYNAMIC, FPGA_BACKEND));
+    else
+        xlz.reset(new xfZlib(m_xclbin, c_max_cr, DECOMP_ONLY, 0, 0, FULL, FPGA_BACKEND));
+
+    int err_code = xlz->error_code();
+    if (err_code) {
+        // Device held by another process, tried again on the next call
+        if (err_code != c_clOutOfResource) {
+#ifdef VERBOSE
+            std::cout << "Failed to use FPGA, switching to SW solution" << std::endl;
+#endif
+            failed = true;
+        }
+        xlz.reset();
+    }
+    return xlz.get();
+}
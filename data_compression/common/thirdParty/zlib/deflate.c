@@ -51,10 +51,9 @@
 
 #include "zlib.hpp"
 #include "deflate.h"
+#include "zlib_dispatch.hpp"
 #include <stdlib.h>
 
-// Minimum size set as 1MB
-#define MIN_INPUT_SIZE MEGA_BYTE
 using namespace xf::compression;
 const char deflate_copyright[] = " deflate 1.2.11 Copyright 1995-2017 Jean-loup Gailly and Mark Adler ";
 /*
@@ -91,6 +90,9 @@ local void lm_init OF((deflate_state * s));
 local void putShortMSB OF((deflate_state * s, uInt b));
 local void flush_pending OF((z_streamp strm));
 local unsigned read_buf OF((z_streamp strm, Bytef* buf, unsigned size));
+local void devfree OF((deflate_state * s));
+local int devcopy OF((z_streamp strm));
+local int deflatedevice OF((z_streamp strm, int flush));
 #ifdef ASMV
 #pragma message("Assembler code may have bugs -- use at your own risk")
 void match_init OF((void)); /* asm code initialization */
@@ -322,6 +324,7 @@ int ZEXPORT deflateInit2_(z_streamp strm,
     strm->state = (struct internal_state FAR*)s;
     s->strm = strm;
     s->status = INIT_STATE; /* to pass state test in deflateReset() */
+    s->dev_out = Z_NULL;
 
     s->wrap = wrap;
     s->gzhead = Z_NULL;
@@ -499,6 +502,7 @@ int ZEXPORT deflateResetKeep(z_streamp strm)
     s = (deflate_state*)strm->state;
     s->pending = 0;
     s->pending_out = s->pending_buf;
+    devfree(s);
 
     if (s->wrap < 0) {
         s->wrap = -s->wrap; /* was made negative by deflate(..., Z_FINISH); */
@@ -562,6 +566,8 @@ int ZEXPORT deflatePending(z_streamp strm, unsigned* pending, int* bits)
 {
     if (deflateStateCheck(strm)) return Z_STREAM_ERROR;
     if (pending != Z_NULL) *pending = strm->state->pending;
+    if (pending != Z_NULL && strm->state->dev_out != Z_NULL)
+        *pending += ((xfChunkChain*)strm->state->dev_out)->size() - strm->state->dev_off;
     if (bits != Z_NULL) *bits = strm->state->bi_valid;
     return Z_OK;
 }
@@ -797,6 +803,101 @@ local void flush_pending(z_streamp strm)
             strm->adler = crc32(strm->adler, s->pending_buf + (beg), s->pending - (beg)); \
     } while (0)
 
+/* ===========================================================================
+ * Release accelerator output not returned yet.
+ */
+local void devfree(deflate_state* s) {
+    delete (xfChunkChain*)s->dev_out;
+    s->dev_out = Z_NULL;
+    s->dev_off = 0;
+}
+
+/* ===========================================================================
+ * Return accelerator output kept in the chunk chain within avail_out, the
+ * stream ends once the whole chain has been copied out.
+ */
+local int devcopy(z_streamp strm) {
+    deflate_state* s = strm->state;
+    xfChunkChain* chain = (xfChunkChain*)s->dev_out;
+
+    uint64_t size = chain->copy(s->dev_off, strm->next_out, strm->avail_out);
+    strm->next_out += size;
+    strm->avail_out -= size;
+    strm->total_out += size;
+    s->dev_off += size;
+
+    if (s->dev_off == chain->size()) {
+        devfree(s);
+        return Z_STREAM_END;
+    }
+    return size ? Z_OK : Z_BUF_ERROR;
+}
+
+/* ===========================================================================
+ * A whole stream given in one Z_FINISH call and larger than the dispatch
+ * threshold is compressed on the accelerator, the zlib or gzip wrapper is
+ * added here.  Streams needing what the kernels do not provide (stored or
+ * Huffman only/RLE/fixed strategies, smaller windows, preset dictionary,
+ * custom gzip header) stay on the software path, as does output exceeding
+ * both deflateBound() and avail_out so one call with a deflateBound() buffer
+ * still completes.  Returns true when the output is pending.
+ */
+local int deflatedevice(z_streamp strm, int flush) {
+    deflate_state* s = strm->state;
+    xfZlibDispatch& dispatch = xfZlibDispatch::instance();
+    const Bytef* in = strm->next_in;
+    uInt size = strm->avail_in;
+
+    if (flush != Z_FINISH || size < dispatch.threshold() || strm->total_in != 0) return 0;
+    if (s->level == 0 || s->strategy >= Z_HUFFMAN_ONLY || s->w_bits != MAX_WBITS || s->strstart != 0 ||
+        s->lookahead != 0 || s->pending != 0 || s->bi_valid != 0 || s->gzhead != Z_NULL)
+        return 0;
+    if (s->status != (s->wrap == 2 ? GZIP_STATE : s->wrap ? INIT_STATE : BUSY_STATE)) return 0;
+
+    xfChunkChain* chain = new xfChunkChain();
+    uLong check;
+    if (s->wrap == 2) {
+        const Bytef c_gzip_header[] = {31, 139, 8, 0, 0, 0, 0, 0, 4, OS_CODE};
+        chain->append(c_gzip_header, sizeof(c_gzip_header));
+        check = crc32_z(crc32(0L, Z_NULL, 0), in, size);
+    } else {
+        /* fastest level flags, same as the xfZlib file header */
+        const Bytef c_zlib_header[] = {0x78, 0x01};
+        if (s->wrap) chain->append(c_zlib_header, sizeof(c_zlib_header));
+        check = adler32_z(adler32(0L, Z_NULL, 0), in, size);
+    }
+
+    if (dispatch.deflate(in, size, *chain) == 0) {
+        delete chain;
+        return 0;
+    }
+
+    Bytef trailer[8];
+    if (s->wrap == 2) {
+        for (int i = 0; i < 4; i++) trailer[i] = (Bytef)(check >> (8 * i));
+        for (int i = 0; i < 4; i++) trailer[4 + i] = (Bytef)(size >> (8 * i));
+        chain->append(trailer, 8);
+    } else if (s->wrap) {
+        for (int i = 0; i < 4; i++) trailer[i] = (Bytef)(check >> (24 - 8 * i));
+        chain->append(trailer, 4);
+    }
+    if (chain->size() > deflateBound(strm, size) && chain->size() > strm->avail_out) {
+        delete chain;
+        return 0;
+    }
+
+    strm->next_in += size;
+    strm->avail_in = 0;
+    strm->total_in += size;
+    strm->adler = check;
+    s->status = FINISH_STATE;
+    s->last_flush = Z_FINISH;
+    if (s->wrap > 0) s->wrap = -s->wrap; /* the trailer is written */
+    s->dev_out = chain;
+    s->dev_off = 0;
+    return 1;
+}
+
 extern "C" {
 /* ========================================================================= */
 #if 0
@@ -807,102 +908,30 @@ int ZEXPORT deflate (strm, flush)
 int ZEXPORT deflate(z_streamp strm, int flush)
 #endif
 {
-    const uint8_t c_max_cr = 0;
-    bool use_cpu_sol = false;
-    bool use_fpga_sol = false;
-    char *xclbin = getenv("XILINX_LIBZ_XCLBIN");
-    std::string u50_xclbin = xclbin;
-
-    if (u50_xclbin.c_str() == NULL) {
-        u50_xclbin = "/opt/Xilinx/zlib/u50_gen3x16_xdma_201920_3.xclbin";
-        std::ifstream bin_file(u50_xclbin.c_str(), std::ifstream::binary);
-        if (bin_file.fail()) {
-#ifdef VERBOSE
-            std::cout << "Unable to open binary file " << std::endl;
-#endif
-            use_cpu_sol = true;
-        } else {
-            use_fpga_sol = true;
-        }
-    } else {
-        use_fpga_sol = true;
-    }
-    
-    char *min_size = getenv("MIN_INPUT_SIZE");
-    uint32_t small_size = MIN_INPUT_SIZE;
-    if (min_size != NULL) {
-        small_size = atoi(min_size);
-    }
+    int old_flush; /* value of flush param for previous deflate call */
+    deflate_state* s;
 
-    // Check input size if its less than
-    // MIN_INPUT_SIZE use SW flow
-    uint64_t input_size = strm->avail_in;
-    if (input_size < small_size) {
-#ifdef VERBOSE
-        std::cout << "Input Size is less than MIN_INPUT_SIZE";
-        std::cout << " Falling back to SW Solution " << std::endl;
-#endif
-        use_cpu_sol = true;
-        use_fpga_sol = false;
+    if (deflateStateCheck(strm) || flush > Z_BLOCK || flush < 0) {
+        return Z_STREAM_ERROR;
     }
+    s = strm->state;
 
-    if (use_fpga_sol) {
-        // Arg 1: xclbin
-        // Xilinx ZLIB object
-        xfZlib *xlz = nullptr;
-        bool flag = false;
-        do {
-            xlz = new xfZlib(u50_xclbin.c_str(), c_max_cr, COMP_ONLY);
-            int err_code = xlz->error_code();
-            if (err_code && (err_code != c_clOutOfResource)) {
-#ifdef VERBOSE
-                std::cout << "Failed to use FPGA for compression, "; 
-                std::cout << " switching to SW solution \n" << std::endl;
-#endif
-                use_cpu_sol = true;
-            } else {
-                uint8_t* input = strm->next_in;
-                uint8_t* output = strm->next_out;
-                // Zlib compression
-                uint64_t enbytes = xlz->compress_buffer((uint8_t*)input, (uint8_t*)output, input_size);
-                delete xlz;
-                if (enbytes == 0) {
-#ifdef VERBOSE
-                    std::cout << "Failed to create device buffer, Retrying . . ." << std::endl;
-#endif
-                    flag = true;
-                } else {
-                    strm->total_out = enbytes;
-                    strm->next_out = output;
-                    return 1;
-                }
-            }
-       } while(flag);
-    } 
-    if (use_cpu_sol) {
-#ifdef VERBOSE
-        printf("CPU Solution \n");
-#endif
-        // printf("Not in CPU deflate \n");
-        int old_flush; /* value of flush param for previous deflate call */
-        deflate_state* s;
+    /* accelerator output of an earlier call is returned first */
+    if (s->dev_out != Z_NULL && strm->next_out != Z_NULL) return devcopy(strm);
 
-        if (deflateStateCheck(strm) || flush > Z_BLOCK || flush < 0) {
-            return Z_STREAM_ERROR;
-        }
-        s = strm->state;
+    if (strm->next_out == Z_NULL || (strm->avail_in != 0 && strm->next_in == Z_NULL) ||
+        (s->status == FINISH_STATE && flush != Z_FINISH)) {
+        ERR_RETURN(strm, Z_STREAM_ERROR);
+    }
+    if (strm->avail_out == 0) ERR_RETURN(strm, Z_BUF_ERROR);
 
-        if (strm->next_out == Z_NULL || (strm->avail_in != 0 && strm->next_in == Z_NULL) ||
-            (s->status == FINISH_STATE && flush != Z_FINISH)) {
-            ERR_RETURN(strm, Z_STREAM_ERROR);
-        }
-        if (strm->avail_out == 0) ERR_RETURN(strm, Z_BUF_ERROR);
+    if (deflatedevice(strm, flush)) return devcopy(strm);
 
-        old_flush = s->last_flush;
-        s->last_flush = flush;
+    old_flush = s->last_flush;
+    s->last_flush = flush;
 
-        /* Flush as much pending output as possible */
-        if (s->pending != 0) {
+    /* Flush as much pending output as possible */
+    if (s->pending != 0) {
         flush_pending(strm);
         if (strm->avail_out == 0) {
             /* Since avail_out is 0, deflate will be called again with
@@ -919,45 +948,65 @@ int ZEXPORT deflate(z_streamp strm, int flush)
          * flushes. For repeated and useless calls with Z_FINISH, we keep
          * returning Z_STREAM_END instead of Z_BUF_ERROR.
          */
-        } else if (strm->avail_in == 0 && RANK(flush) <= RANK(old_flush) && flush != Z_FINISH) {
-            ERR_RETURN(strm, Z_BUF_ERROR);
-        }
+    } else if (strm->avail_in == 0 && RANK(flush) <= RANK(old_flush) && flush != Z_FINISH) {
+        ERR_RETURN(strm, Z_BUF_ERROR);
+    }
 
-        /* User must not provide more input after the first FINISH: */
-        if (s->status == FINISH_STATE && strm->avail_in != 0) {
-            ERR_RETURN(strm, Z_BUF_ERROR);
+    /* User must not provide more input after the first FINISH: */
+    if (s->status == FINISH_STATE && strm->avail_in != 0) {
+        ERR_RETURN(strm, Z_BUF_ERROR);
+    }
+
+    /* Write the header */
+    if (s->status == INIT_STATE) {
+        /* zlib header */
+        uInt header = (Z_DEFLATED + ((s->w_bits - 8) << 4)) << 8;
+        uInt level_flags;
+
+        if (s->strategy >= Z_HUFFMAN_ONLY || s->level < 2)
+            level_flags = 0;
+        else if (s->level < 6)
+            level_flags = 1;
+        else if (s->level == 6)
+            level_flags = 2;
+        else
+            level_flags = 3;
+        header |= (level_flags << 6);
+        if (s->strstart != 0) header |= PRESET_DICT;
+        header += 31 - (header % 31);
+
+        putShortMSB(s, header);
+
+        /* Save the adler32 of the preset dictionary: */
+        if (s->strstart != 0) {
+            putShortMSB(s, (uInt)(strm->adler >> 16));
+            putShortMSB(s, (uInt)(strm->adler & 0xffff));
         }
+        strm->adler = adler32(0L, Z_NULL, 0);
+        s->status = BUSY_STATE;
 
-        /* Write the header */
-        if (s->status == INIT_STATE) {
-            ////printf("INIT_STATE \n");
-            // printf("s->w_bits %d s->level %d s->strategy %d\n",s->w_bits, s->level,s->strategy);
-            s->level = 1;
-            /* zlib header */
-            uInt header = (Z_DEFLATED + ((s->w_bits - 8) << 4)) << 8;
-            uInt level_flags;
-
-            if (s->strategy >= Z_HUFFMAN_ONLY || s->level < 2)
-                level_flags = 0;
-            else if (s->level < 6)
-                level_flags = 1;
-            else if (s->level == 6)
-                level_flags = 2;
-            else
-                level_flags = 3;
-            header |= (level_flags << 6);
-            if (s->strstart != 0) header |= PRESET_DICT;
-            header += 31 - (header % 31);
-            // printf("header %d \n", header);
-
-            putShortMSB(s, header);
-
-            /* Save the adler32 of the preset dictionary: */
-            if (s->strstart != 0) {
-                putShortMSB(s, (uInt)(strm->adler >> 16));
-                putShortMSB(s, (uInt)(strm->adler & 0xffff));
-            }
-            strm->adler = adler32(0L, Z_NULL, 0);
+        /* Compression must start with an empty pending buffer */
+        flush_pending(strm);
+        if (s->pending != 0) {
+            s->last_flush = -1;
+            return Z_OK;
+        }
+    }
+#ifdef GZIP
+    if (s->status == GZIP_STATE) {
+        /* gzip header */
+        strm->adler = crc32(0L, Z_NULL, 0);
+        put_byte(s, 31);
+        put_byte(s, 139);
+        put_byte(s, 8);
+        if (s->gzhead == Z_NULL) {
+            put_byte(s, 0);
+            put_byte(s, 0);
+            put_byte(s, 0);
+            put_byte(s, 0);
+            put_byte(s, 0);
+            put_byte(s, s->level == 9 ? 2 : (s->strategy >= Z_HUFFMAN_ONLY || s->level < 2 ? 4 : 0));
+            put_byte(s, OS_CODE);
             s->status = BUSY_STATE;
 
             /* Compression must start with an empty pending buffer */
@@ -966,40 +1015,148 @@ int ZEXPORT deflate(z_streamp strm, int flush)
                 s->last_flush = -1;
                 return Z_OK;
             }
+        } else {
+            put_byte(s, (s->gzhead->text ? 1 : 0) + (s->gzhead->hcrc ? 2 : 0) + (s->gzhead->extra == Z_NULL ? 0 : 4) +
+                            (s->gzhead->name == Z_NULL ? 0 : 8) + (s->gzhead->comment == Z_NULL ? 0 : 16));
+            put_byte(s, (Byte)(s->gzhead->time & 0xff));
+            put_byte(s, (Byte)((s->gzhead->time >> 8) & 0xff));
+            put_byte(s, (Byte)((s->gzhead->time >> 16) & 0xff));
+            put_byte(s, (Byte)((s->gzhead->time >> 24) & 0xff));
+            put_byte(s, s->level == 9 ? 2 : (s->strategy >= Z_HUFFMAN_ONLY || s->level < 2 ? 4 : 0));
+            put_byte(s, s->gzhead->os & 0xff);
+            if (s->gzhead->extra != Z_NULL) {
+                put_byte(s, s->gzhead->extra_len & 0xff);
+                put_byte(s, (s->gzhead->extra_len >> 8) & 0xff);
+            }
+            if (s->gzhead->hcrc) strm->adler = crc32(strm->adler, s->pending_buf, s->pending);
+            s->gzindex = 0;
+            s->status = EXTRA_STATE;
+        }
+    }
+    if (s->status == EXTRA_STATE) {
+        if (s->gzhead->extra != Z_NULL) {
+            ulg beg = s->pending; /* start of bytes to update crc */
+            uInt left = (s->gzhead->extra_len & 0xffff) - s->gzindex;
+            while (s->pending + left > s->pending_buf_size) {
+                uInt copy = s->pending_buf_size - s->pending;
+                zmemcpy(s->pending_buf + s->pending, s->gzhead->extra + s->gzindex, copy);
+                s->pending = s->pending_buf_size;
+                HCRC_UPDATE(beg);
+                s->gzindex += copy;
+                flush_pending(strm);
+                if (s->pending != 0) {
+                    s->last_flush = -1;
+                    return Z_OK;
+                }
+                beg = 0;
+                left -= copy;
+            }
+            zmemcpy(s->pending_buf + s->pending, s->gzhead->extra + s->gzindex, left);
+            s->pending += left;
+            HCRC_UPDATE(beg);
+            s->gzindex = 0;
+        }
+        s->status = NAME_STATE;
+    }
+    if (s->status == NAME_STATE) {
+        if (s->gzhead->name != Z_NULL) {
+            ulg beg = s->pending; /* start of bytes to update crc */
+            int val;
+            do {
+                if (s->pending == s->pending_buf_size) {
+                    HCRC_UPDATE(beg);
+                    flush_pending(strm);
+                    if (s->pending != 0) {
+                        s->last_flush = -1;
+                        return Z_OK;
+                    }
+                    beg = 0;
+                }
+                val = s->gzhead->name[s->gzindex++];
+                put_byte(s, val);
+            } while (val != 0);
+            HCRC_UPDATE(beg);
+            s->gzindex = 0;
+        }
+        s->status = COMMENT_STATE;
+    }
+    if (s->status == COMMENT_STATE) {
+        if (s->gzhead->comment != Z_NULL) {
+            ulg beg = s->pending; /* start of bytes to update crc */
+            int val;
+            do {
+                if (s->pending == s->pending_buf_size) {
+                    HCRC_UPDATE(beg);
+                    flush_pending(strm);
+                    if (s->pending != 0) {
+                        s->last_flush = -1;
+                        return Z_OK;
+                    }
+                    beg = 0;
+                }
+                val = s->gzhead->comment[s->gzindex++];
+                put_byte(s, val);
+            } while (val != 0);
+            HCRC_UPDATE(beg);
+        }
+        s->status = HCRC_STATE;
+    }
+    if (s->status == HCRC_STATE) {
+        if (s->gzhead->hcrc) {
+            if (s->pending + 2 > s->pending_buf_size) {
+                flush_pending(strm);
+                if (s->pending != 0) {
+                    s->last_flush = -1;
+                    return Z_OK;
+                }
+            }
+            put_byte(s, (Byte)(strm->adler & 0xff));
+            put_byte(s, (Byte)((strm->adler >> 8) & 0xff));
+            strm->adler = crc32(0L, Z_NULL, 0);
         }
+        s->status = BUSY_STATE;
 
-        /* Start a new block or continue the current one.
-         */
-        if (strm->avail_in != 0 || s->lookahead != 0 || (flush != Z_NO_FLUSH && s->status != FINISH_STATE)) {
-            block_state bstate;
+        /* Compression must start with an empty pending buffer */
+        flush_pending(strm);
+        if (s->pending != 0) {
+            s->last_flush = -1;
+            return Z_OK;
+        }
+    }
+#endif
 
-            bstate = s->level == 0 ? deflate_stored(s, flush)
-                                   : s->strategy == Z_HUFFMAN_ONLY
-                                         ? deflate_huff(s, flush)
-                                         : s->strategy == Z_RLE ? deflate_rle(s, flush)
-                                                                : (*(configuration_table[s->level].func))(s, flush);
+    /* Start a new block or continue the current one.
+     */
+    if (strm->avail_in != 0 || s->lookahead != 0 || (flush != Z_NO_FLUSH && s->status != FINISH_STATE)) {
+        block_state bstate;
 
-            if (bstate == finish_started || bstate == finish_done) {
-                s->status = FINISH_STATE;
-            }
-            if (bstate == need_more || bstate == finish_started) {
-                if (strm->avail_out == 0) {
-                    s->last_flush = -1; /* avoid BUF_ERROR next call, see above */
-                }
-                return Z_OK;
-                /* If flush != Z_NO_FLUSH && avail_out == 0, the next call
-                 * of deflate should use the same flush parameter to make sure
-                 * that the flush is complete. So we don't have to output an
-                 * empty block here, this will be done at next call. This also
-                 * ensures that for a very small output buffer, we emit at most
-                 * one empty block.
-                 */
+        bstate = s->level == 0 ? deflate_stored(s, flush)
+                               : s->strategy == Z_HUFFMAN_ONLY
+                                     ? deflate_huff(s, flush)
+                                     : s->strategy == Z_RLE ? deflate_rle(s, flush)
+                                                            : (*(configuration_table[s->level].func))(s, flush);
+
+        if (bstate == finish_started || bstate == finish_done) {
+            s->status = FINISH_STATE;
+        }
+        if (bstate == need_more || bstate == finish_started) {
+            if (strm->avail_out == 0) {
+                s->last_flush = -1; /* avoid BUF_ERROR next call, see above */
             }
-            if (bstate == block_done) {
-                if (flush == Z_PARTIAL_FLUSH) {
-                    _tr_align(s);
-                } else if (flush != Z_BLOCK) { /* FULL_FLUSH or SYNC_FLUSH */
-                    _tr_stored_block(s, (char*)0, 0L, 0);
+            return Z_OK;
+            /* If flush != Z_NO_FLUSH && avail_out == 0, the next call
+             * of deflate should use the same flush parameter to make sure
+             * that the flush is complete. So we don't have to output an
+             * empty block here, this will be done at next call. This also
+             * ensures that for a very small output buffer, we emit at most
+             * one empty block.
+             */
+        }
+        if (bstate == block_done) {
+            if (flush == Z_PARTIAL_FLUSH) {
+                _tr_align(s);
+            } else if (flush != Z_BLOCK) { /* FULL_FLUSH or SYNC_FLUSH */
+                _tr_stored_block(s, (char*)0, 0L, 0);
                 /* For a full flush, this empty block will be recognized
                  * as a special marker by inflate_sync().
                  */
@@ -1012,28 +1169,40 @@ int ZEXPORT deflate(z_streamp strm, int flush)
                     }
                 }
             }
-                flush_pending(strm);
-                if (strm->avail_out == 0) {
-                    s->last_flush = -1; /* avoid BUF_ERROR at next call, see above */
-                    return Z_OK;
-                }
+            flush_pending(strm);
+            if (strm->avail_out == 0) {
+                s->last_flush = -1; /* avoid BUF_ERROR at next call, see above */
+                return Z_OK;
             }
         }
+    }
 
-        if (flush != Z_FINISH) return Z_OK;
-        if (s->wrap <= 0) return Z_STREAM_END;
-
-        // Crc check
-        putShortMSB(s, 0);
-        putShortMSB(s, 0);
+    if (flush != Z_FINISH) return Z_OK;
+    if (s->wrap <= 0) return Z_STREAM_END;
 
-        flush_pending(strm);
-        /* If avail_out is zero, the application will call deflate again
-         * to flush the rest.
-         */
-        if (s->wrap > 0) s->wrap = -s->wrap; /* write the trailer only once! */
-        return s->pending != 0 ? Z_OK : Z_STREAM_END;
+    /* Write the trailer */
+#ifdef GZIP
+    if (s->wrap == 2) {
+        put_byte(s, (Byte)(strm->adler & 0xff));
+        put_byte(s, (Byte)((strm->adler >> 8) & 0xff));
+        put_byte(s, (Byte)((strm->adler >> 16) & 0xff));
+        put_byte(s, (Byte)((strm->adler >> 24) & 0xff));
+        put_byte(s, (Byte)(strm->total_in & 0xff));
+        put_byte(s, (Byte)((strm->total_in >> 8) & 0xff));
+        put_byte(s, (Byte)((strm->total_in >> 16) & 0xff));
+        put_byte(s, (Byte)((strm->total_in >> 24) & 0xff));
+    } else
+#endif
+    {
+        putShortMSB(s, (uInt)(strm->adler >> 16));
+        putShortMSB(s, (uInt)(strm->adler & 0xffff));
     }
+    flush_pending(strm);
+    /* If avail_out is zero, the application will call deflate again
+     * to flush the rest.
+     */
+    if (s->wrap > 0) s->wrap = -s->wrap; /* write the trailer only once! */
+    return s->pending != 0 ? Z_OK : Z_STREAM_END;
 }
 }
 /* ========================================================================= */
@@ -1055,6 +1224,7 @@ int ZEXPORT deflateEnd(z_streamp strm)
     TRY_FREE(strm, strm->state->head);
     TRY_FREE(strm, strm->state->prev);
     TRY_FREE(strm, strm->state->window);
+    devfree(strm->state);
 
     ZFREE(strm, strm->state);
     strm->state = Z_NULL;
@@ -1095,6 +1265,12 @@ int ZEXPORT deflateCopy(z_streamp dest, z_streamp source)
     dest->state = (struct internal_state FAR*)ds;
     zmemcpy((voidpf)ds, (voidpf)ss, sizeof(deflate_state));
     ds->strm = dest;
+    if (ss->dev_out != Z_NULL) {
+        xfChunkChain* src = (xfChunkChain*)ss->dev_out;
+        xfChunkChain* chain = new xfChunkChain();
+        for (uint32_t i = 0; i < src->count(); i++) chain->append(src->chunk(i), src->chunk_size(i));
+        ds->dev_out = chain;
+    }
 
     ds->window = (Bytef*)ZALLOC(dest, ds->w_size, 2 * sizeof(Byte));
     ds->prev = (Posf*)ZALLOC(dest, ds->w_size, sizeof(Pos));
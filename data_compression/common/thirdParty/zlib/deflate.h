@@ -272,6 +272,12 @@ typedef struct internal_state {
      * updated to the new high water mark.
      */
 
+    voidpf dev_out;
+    /* Accelerator output not returned yet, see deflate() */
+
+    ulg dev_off;
+    /* Bytes of dev_out already returned */
+
 } FAR deflate_state;
 
 /* Output a byte on the stream.
@@ -84,8 +84,7 @@
 #include "inftrees.h"
 #include "inflate.h"
 #include "inffast.h"
-// Minimum size set as 1MB
-#define MIN_INPUT_SIZE MEGA_BYTE
+#include "zlib_dispatch.hpp"
 using namespace xf::compression;
 #ifdef MAKEFIXED
 #ifndef BUILDFIXED
@@ -101,6 +100,9 @@ local int updatewindow OF((z_streamp strm, const unsigned char FAR* end, unsigne
 void makefixed OF((void));
 #endif
 local unsigned syncsearch OF((unsigned FAR* have, const unsigned char FAR* buf, unsigned len));
+local void devfree OF((struct inflate_state FAR * state));
+local int devcopy OF((z_streamp strm, int flush));
+local int inflatedevice OF((z_streamp strm));
 #if 0
 local int inflateStateCheck(strm)
 z_streamp strm;
@@ -139,6 +141,7 @@ int ZEXPORT inflateResetKeep(z_streamp strm)
     state->lencode = state->distcode = state->next = state->codes;
     state->sane = 1;
     state->back = -1;
+    devfree(state);
     Tracev((stderr, "inflate: reset\n"));
     return Z_OK;
 }
@@ -181,6 +184,9 @@ int ZEXPORT inflateReset2(z_streamp strm, int windowBits)
         windowBits = -windowBits;
     } else {
         wrap = (windowBits >> 4) + 5;
+#ifdef GUNZIP
+        if (windowBits < 48) windowBits &= 15;
+#endif
     }
 
     /* set number of window bits, free window if different */
@@ -232,6 +238,7 @@ int ZEXPORT inflateInit2_(z_streamp strm, int windowBits, const char* version, i
     strm->state = (struct internal_state FAR*)state;
     state->strm = strm;
     state->window = Z_NULL;
+    state->dev_out = Z_NULL;
     state->mode = HEAD; /* to pass state test in inflateReset2() */
     ret = inflateReset2(strm, windowBits);
     if (ret != Z_OK) {
@@ -629,6 +636,77 @@ local int updatewindow(z_streamp strm, const Bytef* end, unsigned copy)
  */
 #include <stdio.h>
 
+/* Release accelerator output not returned yet */
+local void devfree(struct inflate_state FAR* state) {
+    delete (xfChunkChain*)state->dev_out;
+    state->dev_out = Z_NULL;
+    state->dev_off = 0;
+}
+
+/* Return accelerator output kept in the chunk chain within avail_out, the
+   stream ends once the whole chain has been copied out */
+local int devcopy(z_streamp strm, int flush) {
+    struct inflate_state FAR* state = (struct inflate_state FAR*)strm->state;
+    xfChunkChain* chain = (xfChunkChain*)state->dev_out;
+
+    uint64_t size = chain->copy(state->dev_off, strm->next_out, strm->avail_out);
+    strm->next_out += size;
+    strm->avail_out -= size;
+    strm->total_out += size;
+    state->dev_off += size;
+
+    if (state->dev_off == chain->size()) {
+        devfree(state);
+        return Z_STREAM_END;
+    }
+    return (size && flush != Z_FINISH) ? Z_OK : Z_BUF_ERROR;
+}
+
+/*
+   A zlib stream available in one call and larger than the dispatch threshold
+   is decompressed on the accelerator.  The stream is only taken when the
+   adler32 trailer at the end of the input matches the output, otherwise
+   (trailing data, partial stream, device error) nothing is consumed and the
+   software path below decodes it.  Returns true when the output is pending.
+ */
+local int inflatedevice(z_streamp strm) {
+    struct inflate_state FAR* state = (struct inflate_state FAR*)strm->state;
+    xfZlibDispatch& dispatch = xfZlibDispatch::instance();
+    const unsigned char FAR* in = strm->next_in;
+    unsigned size = strm->avail_in;
+
+    if (size < dispatch.threshold() || strm->total_in != 0 || state->bits != 0 || !(state->wrap & 1)) return 0;
+    /* kernels take a 32K window zlib header without preset dictionary */
+    if ((state->wbits != 0 && state->wbits != 15) || in[0] != 0x78 || (0x7800 + in[1]) % 31 || (in[1] & 0x20))
+        return 0;
+
+    xfChunkChain* chain = new xfChunkChain();
+    if (dispatch.inflate(in, size, *chain) == 0) {
+        delete chain;
+        return 0;
+    }
+
+    unsigned long check = adler32(0L, Z_NULL, 0);
+    for (uint32_t i = 0; i < chain->count(); i++) check = adler32_z(check, chain->chunk(i), chain->chunk_size(i));
+    unsigned long trailer = ((unsigned long)in[size - 4] << 24) + ((unsigned long)in[size - 3] << 16) +
+                            ((unsigned long)in[size - 2] << 8) + in[size - 1];
+    if (check != trailer) {
+        delete chain;
+        return 0;
+    }
+
+    strm->next_in += size;
+    strm->avail_in = 0;
+    strm->total_in += size;
+    strm->adler = state->check = check;
+    state->total = chain->size();
+    state->flags = 0;
+    state->mode = DONE;
+    state->dev_out = chain;
+    state->dev_off = 0;
+    return 1;
+}
+
 extern "C" {
 
 #if 0
@@ -639,413 +717,615 @@ int flush;
 int ZEXPORT inflate(z_streamp strm, int flush)
 #endif
 {
-    const uint8_t c_max_cr = 0;
-    bool use_cpu_sol = false;
-    bool use_fpga_sol = false;
-    char *xclbin = getenv("XILINX_LIBZ_XCLBIN");
-    char *cu_id = getenv("XILINX_CU_ID");   
-    std::string u50_xclbin = xclbin;
- 
-    if (u50_xclbin.c_str() == NULL) {
-        u50_xclbin = "/opt/Xilinx/zlib/u50_gen3x16_xdma_201920_3.xclbin";
-        std::ifstream bin_file(u50_xclbin.c_str(), std::ifstream::binary);
-        if (bin_file.fail()) {
-#ifdef VERBOSE
-            std::cout << "Unable to open binary file " << std::endl;
-#endif
-            use_cpu_sol = true;
-        }else {
-            use_fpga_sol = true;
-        }
-    } else {
-        use_fpga_sol = true;
-    }
-    
-    char *min_size = getenv("MIN_INPUT_SIZE");
-    uint32_t small_size = MIN_INPUT_SIZE;
-    if (min_size != NULL) {
-        small_size = atoi(min_size);
-    }
-    
-    // Check input size if its less than
-    // MIN_INPUT_SIZE use SW flow
-    uint64_t input_size = strm->avail_in;
-    if (input_size < small_size) {
-#ifdef VERBOSE
-        std::cout << "Input Size is less than MIN_INPUT_SIZE";
-        std::cout << " Falling back to SW Solution " << std::endl;
-#endif
-        use_cpu_sol = true;
-        use_fpga_sol = false;
-    }
-    
-    if (use_fpga_sol) {
-        // Arg 1: xclbin
-        // Xilinx ZLIB object
-        xfZlib *xlz = nullptr;
-        bool flag = false;
-        do {
-            xlz = new xfZlib(u50_xclbin.c_str(), c_max_cr, DECOMP_ONLY, 0, 0, FULL);
-            int err_code = xlz->error_code();
-            if (err_code && (err_code != c_clOutOfResource)) {
-#ifdef VERBOSE
-                std::cout << "Failed to use FPGA for Decompression, "; 
-                std::cout << " switching to SW solution \n" << std::endl;
-#endif
-                use_cpu_sol = true;
-            } else {
-                uint8_t* input = strm->next_in;
-                uint8_t* output = strm->next_out;
-                // Zlib decompression
-                int debytes = xlz->decompress_buffer((uint8_t*)input, (uint8_t*)output, input_size, atoi(cu_id));
-                delete xlz;
-                if (debytes == 0) {
-#ifdef VERBOSE
-                    std::cout << "Failed to create device buffer, Retrying . . ." << std::endl;
-#endif
-                    flag = true;
-                } else {
-                    strm->total_out = debytes;
-                    strm->next_out = output;
-                    return 1;
-                }
-            }
-        }while(flag);
-    }
-
-    if (use_cpu_sol) {
-#ifdef VERBOSE
-        printf("CPU Solution \n");
+    struct inflate_state FAR* state;
+    z_const unsigned char FAR* next; /* next input */
+    unsigned char FAR* put;          /* next output */
+    unsigned have, left;             /* available input and output */
+    unsigned long hold;              /* bit buffer */
+    unsigned bits;                   /* bits in bit buffer */
+    unsigned in, out;                /* save starting available input and output */
+    unsigned copy;                   /* number of stored or match bytes to copy */
+    unsigned char FAR* from;         /* where to copy match bytes from */
+    code here;                       /* current decoding table entry */
+    code last;                       /* parent table entry */
+    unsigned len;                    /* length to copy for repeats, bits to drop */
+    int ret;                         /* return code */
+#ifdef GUNZIP
+    unsigned char hbuf[4]; /* buffer for gzip header crc calculation */
 #endif
-        // printf("In inflate integrated \n");
-        struct inflate_state FAR* state;
-        z_const unsigned char FAR* next;        /* next input */
-        unsigned char FAR* put;                 /* next output */
-        unsigned int have, left;                /* available input and output */
-        unsigned long hold;                     /* bit buffer */
-        unsigned bits;                          /* bits in bit buffer */
-        unsigned in, out;                       /* save starting available input and output */
-        unsigned copy;                          /* number of stored or match bytes to copy */
-        unsigned char FAR* from;                /* where to copy match bytes from */
-        code here;                              /* current decoding table entry */
-        code last;                              /* parent table entry */
-        unsigned len;                           /* length to copy for repeats, bits to drop */
-        int ret;                                /* return code */
-        static const unsigned short order[19] = /* permutation of code lengths */
-            {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
-        static int flag_kal;
-
-        state = (struct inflate_state FAR*)strm->state;
-
-        LOAD();
-
-        in = have;
-        out = left;
-        ret = Z_OK;
-
-        for (;;) {
-            switch (state->mode) {
-                case HEAD:
-                    if (state->wrap == 0) {
-                        state->mode = TYPEDO;
-                        break;
-                    }
+    static const unsigned short order[19] = /* permutation of code lengths */
+        {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
 
-                    NEEDBITS(16);
-
-                    if (((BITS(8) << 8) + (hold >> 8)) % 31) {
-                        strm->msg = (char*)"incorrect header check";
-                        state->mode = BAD;
-                        break;
-                    }
-
-                    if (BITS(4) != Z_DEFLATED) {
-                        strm->msg = (char*)"unknown compression method";
-                        state->mode = BAD;
-                        // printf("Un known method \n");
-                        break;
-                    }
-
-                    DROPBITS(4);
-                    len = BITS(4) + 8;
-
-                    if (state->wbits == 0) state->wbits = len;
-
-                    if (len > 15 || len > state->wbits) {
-                        strm->msg = (char*)"invalid window size";
-                        state->mode = BAD;
-                        // printf("Invalid window size \n");
-                        break;
-                    }
-
-                    state->dmax = 1U << len;
-
-                    Tracev((stderr, "inflate:   zlib header ok\n"));
+    if (inflateStateCheck(strm) || strm->next_out == Z_NULL || (strm->next_in == Z_NULL && strm->avail_in != 0))
+        return Z_STREAM_ERROR;
 
-                    strm->adler = state->check = adler32(0L, Z_NULL, 0);
-                    state->mode = hold & 0x200 ? DICTID : TYPE;
+    state = (struct inflate_state FAR*)strm->state;
 
+    /* accelerator output of an earlier call is returned first */
+    if (state->dev_out != Z_NULL) return devcopy(strm, flush);
+    if (state->mode == HEAD && inflatedevice(strm)) return devcopy(strm, flush);
+
+    if (state->mode == TYPE) state->mode = TYPEDO; /* skip check */
+    LOAD();
+    in = have;
+    out = left;
+    ret = Z_OK;
+    for (;;) switch (state->mode) {
+            case HEAD:
+                if (state->wrap == 0) {
+                    state->mode = TYPEDO;
+                    break;
+                }
+                NEEDBITS(16);
+#ifdef GUNZIP
+                if ((state->wrap & 2) && hold == 0x8b1f) { /* gzip header */
+                    if (state->wbits == 0) state->wbits = 15;
+                    state->check = crc32(0L, Z_NULL, 0);
+                    CRC2(state->check, hold);
                     INITBITS();
+                    state->mode = FLAGS;
                     break;
-                case TYPE:
-                    if (flush == Z_BLOCK || flush == Z_TREES) {
-                        goto inf_leave;
-                    }
-                case TYPEDO:
-                    if (state->last) {
-                        // printf("TYPEDO \n");
-                        BYTEBITS();
-                        state->mode = CHECK;
-                        break;
-                    }
-
-                    NEEDBITS(3);
-                    state->last = BITS(1);
-                    DROPBITS(1);
-
-                    switch (BITS(2)) {
-                        case 0: /* stored block */
-                            Tracev((stderr, "inflate:     stored block%s\n", state->last ? " (last)" : ""));
-                            state->mode = STORED;
-                            break;
-                        case 1: /* fixed block */
-                            fixedtables(state);
-                            Tracev((stderr, "inflate:     fixed codes block%s\n", state->last ? " (last)" : ""));
-                            state->mode = LEN_; /* decode codes */
-                            if (flush == Z_TREES) {
-                                DROPBITS(2);
-                                goto inf_leave;
-                            }
-                            break;
-                        case 2: /* dynamic block */
-                            Tracev((stderr, "inflate:     dynamic codes block%s\n", state->last ? " (last)" : ""));
-                            state->mode = TABLE;
-                            break;
-                        case 3:
-                            // printf("Invalid block \n");
-                            strm->msg = (char*)"invalid block type";
-                            state->mode = BAD;
-                    }
-
-                    DROPBITS(2);
+                }
+                state->flags = 0; /* expect zlib header */
+                if (state->head != Z_NULL) state->head->done = -1;
+                if (!(state->wrap & 1) || /* check if zlib header allowed */
+#else
+                if (
+#endif
+                    ((BITS(8) << 8) + (hold >> 8)) % 31) {
+                    strm->msg = (char*)"incorrect header check";
+                    state->mode = BAD;
                     break;
-
-                case STORED:
-                    BYTEBITS(); /* go to byte boundary */
-                    NEEDBITS(32);
-                    if ((hold & 0xffff) != ((hold >> 16) ^ 0xffff)) {
-                        strm->msg = (char*)"invalid stored block lengths";
-                        state->mode = BAD;
-                        // printf("Invalid storedblock \n");
-                        break;
-                    }
-                    state->length = (unsigned)hold & 0xffff;
-                    Tracev((stderr, "inflate:       stored length %u\n", state->length));
+                }
+                if (BITS(4) != Z_DEFLATED) {
+                    strm->msg = (char*)"unknown compression method";
+                    state->mode = BAD;
+                    break;
+                }
+                DROPBITS(4);
+                len = BITS(4) + 8;
+                if (state->wbits == 0) state->wbits = len;
+                if (len > 15 || len > state->wbits) {
+                    strm->msg = (char*)"invalid window size";
+                    state->mode = BAD;
+                    break;
+                }
+                state->dmax = 1U << len;
+                Tracev((stderr, "inflate:   zlib header ok\n"));
+                strm->adler = state->check = adler32(0L, Z_NULL, 0);
+                state->mode = hold & 0x200 ? DICTID : TYPE;
+                INITBITS();
+                break;
+#ifdef GUNZIP
+            case FLAGS:
+                NEEDBITS(16);
+                state->flags = (int)(hold);
+                if ((state->flags & 0xff) != Z_DEFLATED) {
+                    strm->msg = (char*)"unknown compression method";
+                    state->mode = BAD;
+                    break;
+                }
+                if (state->flags & 0xe000) {
+                    strm->msg = (char*)"unknown header flags set";
+                    state->mode = BAD;
+                    break;
+                }
+                if (state->head != Z_NULL) state->head->text = (int)((hold >> 8) & 1);
+                if ((state->flags & 0x0200) && (state->wrap & 4)) CRC2(state->check, hold);
+                INITBITS();
+                state->mode = TIME;
+            case TIME:
+                NEEDBITS(32);
+                if (state->head != Z_NULL) state->head->time = hold;
+                if ((state->flags & 0x0200) && (state->wrap & 4)) CRC4(state->check, hold);
+                INITBITS();
+                state->mode = OS;
+            case OS:
+                NEEDBITS(16);
+                if (state->head != Z_NULL) {
+                    state->head->xflags = (int)(hold & 0xff);
+                    state->head->os = (int)(hold >> 8);
+                }
+                if ((state->flags & 0x0200) && (state->wrap & 4)) CRC2(state->check, hold);
+                INITBITS();
+                state->mode = EXLEN;
+            case EXLEN:
+                if (state->flags & 0x0400) {
+                    NEEDBITS(16);
+                    state->length = (unsigned)(hold);
+                    if (state->head != Z_NULL) state->head->extra_len = (unsigned)hold;
+                    if ((state->flags & 0x0200) && (state->wrap & 4)) CRC2(state->check, hold);
                     INITBITS();
-                    state->mode = COPY_;
-                    if (flush == Z_TREES) goto inf_leave;
-
-                case COPY_:
-                    state->mode = COPY;
-                case COPY:
+                } else if (state->head != Z_NULL)
+                    state->head->extra = Z_NULL;
+                state->mode = EXTRA;
+            case EXTRA:
+                if (state->flags & 0x0400) {
                     copy = state->length;
-                    // printf("left %d \n", left);
+                    if (copy > have) copy = have;
                     if (copy) {
-                        if (copy > have) copy = have;
-                        if (copy > left) copy = left;
-                        if (copy == 0) goto inf_leave;
-                        zmemcpy(put, next, copy);
+                        if (state->head != Z_NULL && state->head->extra != Z_NULL) {
+                            len = state->head->extra_len - state->length;
+                            zmemcpy(state->head->extra + len, next,
+                                    len + copy > state->head->extra_max ? state->head->extra_max - len : copy);
+                        }
+                        if ((state->flags & 0x0200) && (state->wrap & 4)) state->check = crc32(state->check, next, copy);
                         have -= copy;
                         next += copy;
-                        left -= copy;
-                        put += copy;
                         state->length -= copy;
-                        break;
-                    }
-                    Tracev((stderr, "inflate:       stored end\n"));
-                    state->mode = TYPE;
-                    break;
-                case TABLE:
-                    NEEDBITS(14);
-                    state->nlen = BITS(5) + 257;
-                    DROPBITS(5);
-                    state->ndist = BITS(5) + 1;
-                    DROPBITS(5);
-                    state->ncode = BITS(4) + 4;
-                    DROPBITS(4);
-                    Tracev((stderr, "inflate:       table sizes ok\n"));
-                    state->have = 0;
-                    state->mode = LENLENS;
-                case LENLENS:
-                    while (state->have < state->ncode) {
-                        // printf("In LENLENS \n");
-                        NEEDBITS(3);
-                        state->lens[order[state->have++]] = (unsigned short)BITS(3);
-                        DROPBITS(3);
                     }
-                    while (state->have < 19) state->lens[order[state->have++]] = 0;
-                    state->next = state->codes;
-                    state->lencode = (const code FAR*)(state->next);
-                    state->lenbits = 7;
-                    ret = inflate_table(CODES, state->lens, 19, &(state->next), &(state->lenbits), state->work);
-                    // printf("ret inflate_table %d\n", ret);
-                    if (ret) {
-                        strm->msg = (char*)"invalid code lengths set";
+                    if (state->length) goto inf_leave;
+                }
+                state->length = 0;
+                state->mode = NAME;
+            case NAME:
+                if (state->flags & 0x0800) {
+                    if (have == 0) goto inf_leave;
+                    copy = 0;
+                    do {
+                        len = (unsigned)(next[copy++]);
+                        if (state->head != Z_NULL && state->head->name != Z_NULL &&
+                            state->length < state->head->name_max)
+                            state->head->name[state->length++] = (Bytef)len;
+                    } while (len && copy < have);
+                    if ((state->flags & 0x0200) && (state->wrap & 4)) state->check = crc32(state->check, next, copy);
+                    have -= copy;
+                    next += copy;
+                    if (len) goto inf_leave;
+                } else if (state->head != Z_NULL)
+                    state->head->name = Z_NULL;
+                state->length = 0;
+                state->mode = COMMENT;
+            case COMMENT:
+                if (state->flags & 0x1000) {
+                    if (have == 0) goto inf_leave;
+                    copy = 0;
+                    do {
+                        len = (unsigned)(next[copy++]);
+                        if (state->head != Z_NULL && state->head->comment != Z_NULL &&
+                            state->length < state->head->comm_max)
+                            state->head->comment[state->length++] = (Bytef)len;
+                    } while (len && copy < have);
+                    if ((state->flags & 0x0200) && (state->wrap & 4)) state->check = crc32(state->check, next, copy);
+                    have -= copy;
+                    next += copy;
+                    if (len) goto inf_leave;
+                } else if (state->head != Z_NULL)
+                    state->head->comment = Z_NULL;
+                state->mode = HCRC;
+            case HCRC:
+                if (state->flags & 0x0200) {
+                    NEEDBITS(16);
+                    if ((state->wrap & 4) && hold != (state->check & 0xffff)) {
+                        strm->msg = (char*)"header crc mismatch";
                         state->mode = BAD;
-                        // printf("Invalid code length set \n");
                         break;
                     }
-                    Tracev((stderr, "inflate:       code lengths ok\n"));
-                    state->have = 0;
-                    state->mode = CODELENS;
-                case CODELENS:
-                    while (state->have < state->nlen + state->ndist) {
-                        for (;;) {
-                            here = state->lencode[BITS(state->lenbits)];
-                            if ((unsigned)(here.bits) <= bits) break;
-                            PULLBYTE();
+                    INITBITS();
+                }
+                if (state->head != Z_NULL) {
+                    state->head->hcrc = (int)((state->flags >> 9) & 1);
+                    state->head->done = 1;
+                }
+                strm->adler = state->check = crc32(0L, Z_NULL, 0);
+                state->mode = TYPE;
+                break;
+#endif
+            case DICTID:
+                NEEDBITS(32);
+                strm->adler = state->check = ZSWAP32(hold);
+                INITBITS();
+                state->mode = DICT;
+            case DICT:
+                if (state->havedict == 0) {
+                    RESTORE();
+                    return Z_NEED_DICT;
+                }
+                strm->adler = state->check = adler32(0L, Z_NULL, 0);
+                state->mode = TYPE;
+            case TYPE:
+                if (flush == Z_BLOCK || flush == Z_TREES) goto inf_leave;
+            case TYPEDO:
+                if (state->last) {
+                    BYTEBITS();
+                    state->mode = CHECK;
+                    break;
+                }
+                NEEDBITS(3);
+                state->last = BITS(1);
+                DROPBITS(1);
+                switch (BITS(2)) {
+                    case 0: /* stored block */
+                        Tracev((stderr, "inflate:     stored block%s\n", state->last ? " (last)" : ""));
+                        state->mode = STORED;
+                        break;
+                    case 1: /* fixed block */
+                        fixedtables(state);
+                        Tracev((stderr, "inflate:     fixed codes block%s\n", state->last ? " (last)" : ""));
+                        state->mode = LEN_; /* decode codes */
+                        if (flush == Z_TREES) {
+                            DROPBITS(2);
+                            goto inf_leave;
                         }
-
-                        if (here.val < 16) {
+                        break;
+                    case 2: /* dynamic block */
+                        Tracev((stderr, "inflate:     dynamic codes block%s\n", state->last ? " (last)" : ""));
+                        state->mode = TABLE;
+                        break;
+                    case 3:
+                        strm->msg = (char*)"invalid block type";
+                        state->mode = BAD;
+                }
+                DROPBITS(2);
+                break;
+            case STORED:
+                BYTEBITS(); /* go to byte boundary */
+                NEEDBITS(32);
+                if ((hold & 0xffff) != ((hold >> 16) ^ 0xffff)) {
+                    strm->msg = (char*)"invalid stored block lengths";
+                    state->mode = BAD;
+                    break;
+                }
+                state->length = (unsigned)hold & 0xffff;
+                Tracev((stderr, "inflate:       stored length %u\n", state->length));
+                INITBITS();
+                state->mode = COPY_;
+                if (flush == Z_TREES) goto inf_leave;
+            case COPY_:
+                state->mode = COPY;
+            case COPY:
+                copy = state->length;
+                if (copy) {
+                    if (copy > have) copy = have;
+                    if (copy > left) copy = left;
+                    if (copy == 0) goto inf_leave;
+                    zmemcpy(put, next, copy);
+                    have -= copy;
+                    next += copy;
+                    left -= copy;
+                    put += copy;
+                    state->length -= copy;
+                    break;
+                }
+                Tracev((stderr, "inflate:       stored end\n"));
+                state->mode = TYPE;
+                break;
+            case TABLE:
+                NEEDBITS(14);
+                state->nlen = BITS(5) + 257;
+                DROPBITS(5);
+                state->ndist = BITS(5) + 1;
+                DROPBITS(5);
+                state->ncode = BITS(4) + 4;
+                DROPBITS(4);
+#ifndef PKZIP_BUG_WORKAROUND
+                if (state->nlen > 286 || state->ndist > 30) {
+                    strm->msg = (char*)"too many length or distance symbols";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                Tracev((stderr, "inflate:       table sizes ok\n"));
+                state->have = 0;
+                state->mode = LENLENS;
+            case LENLENS:
+                while (state->have < state->ncode) {
+                    NEEDBITS(3);
+                    state->lens[order[state->have++]] = (unsigned short)BITS(3);
+                    DROPBITS(3);
+                }
+                while (state->have < 19) state->lens[order[state->have++]] = 0;
+                state->next = state->codes;
+                state->lencode = (const code FAR*)(state->next);
+                state->lenbits = 7;
+                ret = inflate_table(CODES, state->lens, 19, &(state->next), &(state->lenbits), state->work);
+                if (ret) {
+                    strm->msg = (char*)"invalid code lengths set";
+                    state->mode = BAD;
+                    break;
+                }
+                Tracev((stderr, "inflate:       code lengths ok\n"));
+                state->have = 0;
+                state->mode = CODELENS;
+            case CODELENS:
+                while (state->have < state->nlen + state->ndist) {
+                    for (;;) {
+                        here = state->lencode[BITS(state->lenbits)];
+                        if ((unsigned)(here.bits) <= bits) break;
+                        PULLBYTE();
+                    }
+                    if (here.val < 16) {
+                        DROPBITS(here.bits);
+                        state->lens[state->have++] = here.val;
+                    } else {
+                        if (here.val == 16) {
+                            NEEDBITS(here.bits + 2);
                             DROPBITS(here.bits);
-                            state->lens[state->have++] = here.val;
-                        } else {
-                            if (here.val == 16) {
-                                NEEDBITS(here.bits + 2);
-                                DROPBITS(here.bits);
-                                if (state->have == 0) {
-                                    strm->msg = (char*)"invalid bit length repeat";
-                                    state->mode = BAD;
-                                    // printf("Invalid bit length repeat\n");
-                                    break;
-                                }
-                                len = state->lens[state->have - 1];
-                                copy = 3 + BITS(2);
-                                DROPBITS(2);
-                            } else if (here.val == 17) {
-                                NEEDBITS(here.bits + 3);
-                                DROPBITS(here.bits);
-                                len = 0;
-                                copy = 3 + BITS(3);
-                                DROPBITS(3);
-                            } else {
-                                NEEDBITS(here.bits + 7);
-                                DROPBITS(here.bits);
-                                len = 0;
-                                copy = 11 + BITS(7);
-                                DROPBITS(7);
-                            }
-
-                            if (state->have + copy > state->nlen + state->ndist) {
+                            if (state->have == 0) {
                                 strm->msg = (char*)"invalid bit length repeat";
                                 state->mode = BAD;
-                                // printf("Invalid bit length repeat \n");
                                 break;
                             }
-                            while (copy--) state->lens[state->have++] = (unsigned short)len;
+                            len = state->lens[state->have - 1];
+                            copy = 3 + BITS(2);
+                            DROPBITS(2);
+                        } else if (here.val == 17) {
+                            NEEDBITS(here.bits + 3);
+                            DROPBITS(here.bits);
+                            len = 0;
+                            copy = 3 + BITS(3);
+                            DROPBITS(3);
+                        } else {
+                            NEEDBITS(here.bits + 7);
+                            DROPBITS(here.bits);
+                            len = 0;
+                            copy = 11 + BITS(7);
+                            DROPBITS(7);
                         }
-                    } // End of while
+                        if (state->have + copy > state->nlen + state->ndist) {
+                            strm->msg = (char*)"invalid bit length repeat";
+                            state->mode = BAD;
+                            break;
+                        }
+                        while (copy--) state->lens[state->have++] = (unsigned short)len;
+                    }
+                }
 
-                    /* handle error breaks in while */
-                    if (state->mode == BAD) break;
+                /* handle error breaks in while */
+                if (state->mode == BAD) break;
 
-                    // printf("state->lens[256] %d \n", state->lens[256]);
-                    /* check for end-of-block code (better have one) */
-                    if (state->lens[256] == 0) {
-                        strm->msg = (char*)"invalid code -- missing end-of-block";
-                        // printf("missing end of block \n");
-                        state->mode = BAD;
-                        break;
-                    }
+                /* check for end-of-block code (better have one) */
+                if (state->lens[256] == 0) {
+                    strm->msg = (char*)"invalid code -- missing end-of-block";
+                    state->mode = BAD;
+                    break;
+                }
 
-                    /* build code tables -- note: do not change the lenbits or distbits
-                       values here (9 and 6) without reading the comments in inftrees.h
-                       concerning the ENOUGH constants, which depend on those values */
-                    state->next = state->codes;
-                    state->lencode = (const code FAR*)(state->next);
-                    state->lenbits = 9;
-                    ret = inflate_table(LENS, state->lens, state->nlen, &(state->next), &(state->lenbits), state->work);
-                    // printf("ret %d build code tables\n", ret);
-                    if (ret) {
-                        strm->msg = (char*)"invalid literal/lengths set";
-                        state->mode = BAD;
-                        // printf("invalid literal/length set \n");
+                /* build code tables -- note: do not change the lenbits or distbits
+                   values here (9 and 6) without reading the comments in inftrees.h
+                   concerning the ENOUGH constants, which depend on those values */
+                state->next = state->codes;
+                state->lencode = (const code FAR*)(state->next);
+                state->lenbits = 9;
+                ret = inflate_table(LENS, state->lens, state->nlen, &(state->next), &(state->lenbits), state->work);
+                if (ret) {
+                    strm->msg = (char*)"invalid literal/lengths set";
+                    state->mode = BAD;
+                    break;
+                }
+                state->distcode = (const code FAR*)(state->next);
+                state->distbits = 6;
+                ret = inflate_table(DISTS, state->lens + state->nlen, state->ndist, &(state->next), &(state->distbits),
+                                    state->work);
+                if (ret) {
+                    strm->msg = (char*)"invalid distances set";
+                    state->mode = BAD;
+                    break;
+                }
+                Tracev((stderr, "inflate:       codes ok\n"));
+                state->mode = LEN_;
+                if (flush == Z_TREES) goto inf_leave;
+            case LEN_:
+                state->mode = LEN;
+            case LEN:
+                if (have >= 6 && left >= 258) {
+                    RESTORE();
+                    inflate_fast(strm, out);
+                    LOAD();
+                    if (state->mode == TYPE) state->back = -1;
+                    break;
+                }
+                state->back = 0;
+                for (;;) {
+                    here = state->lencode[BITS(state->lenbits)];
+                    if ((unsigned)(here.bits) <= bits) break;
+                    PULLBYTE();
+                }
+                if (here.op && (here.op & 0xf0) == 0) {
+                    last = here;
+                    for (;;) {
+                        here = state->lencode[last.val + (BITS(last.bits + last.op) >> last.bits)];
+                        if ((unsigned)(last.bits + here.bits) <= bits) break;
+                        PULLBYTE();
+                    }
+                    DROPBITS(last.bits);
+                    state->back += last.bits;
+                }
+                DROPBITS(here.bits);
+                state->back += here.bits;
+                state->length = (unsigned)here.val;
+                if ((int)(here.op) == 0) {
+                    Tracevv((stderr, here.val >= 0x20 && here.val < 0x7f ? "inflate:         literal '%c'\n"
+                                                                         : "inflate:         literal 0x%02x\n",
+                             here.val));
+                    state->mode = LIT;
+                    break;
+                }
+                if (here.op & 32) {
+                    Tracevv((stderr, "inflate:         end of block\n"));
+                    state->back = -1;
+                    state->mode = TYPE;
+                    break;
+                }
+                if (here.op & 64) {
+                    strm->msg = (char*)"invalid literal/length code";
+                    state->mode = BAD;
+                    break;
+                }
+                state->extra = (unsigned)(here.op) & 15;
+                state->mode = LENEXT;
+            case LENEXT:
+                if (state->extra) {
+                    NEEDBITS(state->extra);
+                    state->length += BITS(state->extra);
+                    DROPBITS(state->extra);
+                    state->back += state->extra;
+                }
+                Tracevv((stderr, "inflate:         length %u\n", state->length));
+                state->was = state->length;
+                state->mode = DIST;
+            case DIST:
+                for (;;) {
+                    here = state->distcode[BITS(state->distbits)];
+                    if ((unsigned)(here.bits) <= bits) break;
+                    PULLBYTE();
+                }
+                if ((here.op & 0xf0) == 0) {
+                    last = here;
+                    for (;;) {
+                        here = state->distcode[last.val + (BITS(last.bits + last.op) >> last.bits)];
+                        if ((unsigned)(last.bits + here.bits) <= bits) break;
+                        PULLBYTE();
+                    }
+                    DROPBITS(last.bits);
+                    state->back += last.bits;
+                }
+                DROPBITS(here.bits);
+                state->back += here.bits;
+                if (here.op & 64) {
+                    strm->msg = (char*)"invalid distance code";
+                    state->mode = BAD;
+                    break;
+                }
+                state->offset = (unsigned)here.val;
+                state->extra = (unsigned)(here.op) & 15;
+                state->mode = DISTEXT;
+            case DISTEXT:
+                if (state->extra) {
+                    NEEDBITS(state->extra);
+                    state->offset += BITS(state->extra);
+                    DROPBITS(state->extra);
+                    state->back += state->extra;
+                }
+#ifdef INFLATE_STRICT
+                if (state->offset > state->dmax) {
+                    strm->msg = (char*)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                Tracevv((stderr, "inflate:         distance %u\n", state->offset));
+                state->mode = MATCH;
+            case MATCH:
+                if (left == 0) goto inf_leave;
+                copy = out - left;
+                if (state->offset > copy) { /* copy from window */
+                    copy = state->offset - copy;
+                    if (copy > state->whave) {
+                        if (state->sane) {
+                            strm->msg = (char*)"invalid distance too far back";
+                            state->mode = BAD;
+                            break;
+                        }
+#ifdef INFLATE_ALLOW_INVALID_DISTANCE_TOOFAR_ARRR
+                        Trace((stderr, "inflate.c too far\n"));
+                        copy -= state->whave;
+                        if (copy > state->length) copy = state->length;
+                        if (copy > left) copy = left;
+                        left -= copy;
+                        state->length -= copy;
+                        do {
+                            *put++ = 0;
+                        } while (--copy);
+                        if (state->length == 0) state->mode = LEN;
                         break;
+#endif
                     }
-                    state->distcode = (const code FAR*)(state->next);
-                    state->distbits = 6;
-                    ret = inflate_table(DISTS, state->lens + state->nlen, state->ndist, &(state->next), &(state->distbits),
-                                        state->work);
-                    // printf("ret %d build distance tables\n", ret);
-                    if (ret) {
-                        strm->msg = (char*)"invalid distances set";
+                    if (copy > state->wnext) {
+                        copy -= state->wnext;
+                        from = state->window + (state->wsize - copy);
+                    } else
+                        from = state->window + (state->wnext - copy);
+                    if (copy > state->length) copy = state->length;
+                } else { /* copy from output */
+                    from = put - state->offset;
+                    copy = state->length;
+                }
+                if (copy > left) copy = left;
+                left -= copy;
+                state->length -= copy;
+                do {
+                    *put++ = *from++;
+                } while (--copy);
+                if (state->length == 0) state->mode = LEN;
+                break;
+            case LIT:
+                if (left == 0) goto inf_leave;
+                *put++ = (unsigned char)(state->length);
+                left--;
+                state->mode = LEN;
+                break;
+            case CHECK:
+                if (state->wrap) {
+                    NEEDBITS(32);
+                    out -= left;
+                    strm->total_out += out;
+                    state->total += out;
+                    if ((state->wrap & 4) && out) strm->adler = state->check = UPDATE(state->check, put - out, out);
+                    out = left;
+                    if ((state->wrap & 4) && (
+#ifdef GUNZIP
+                                                 state->flags ? hold :
+#endif
+                                                              ZSWAP32(hold)) != state->check) {
+                        strm->msg = (char*)"incorrect data check";
                         state->mode = BAD;
-                        // printf("invalid distance set \n");
                         break;
                     }
-                    Tracev((stderr, "inflate:       codes ok\n"));
-                    state->mode = LEN_;
-                    if (flush == Z_TREES) goto inf_leave;
-                case LEN_:
-                    state->mode = LEN;
-                case LEN:
-                    // printf("In LEN - have %d left %d\n", have, left);
-                    // printf("LEN before if state->mode %d \n", state->mode);
-                    if (have >= 6 && left >= 258) {
-                        RESTORE();
-                        inflate_fast(strm, out);
-                        LOAD();
-                        if (state->mode == TYPE) state->back = -1;
+                    INITBITS();
+                    Tracev((stderr, "inflate:   check matches trailer\n"));
+                }
+#ifdef GUNZIP
+                state->mode = LENGTH;
+            case LENGTH:
+                if (state->wrap && state->flags) {
+                    NEEDBITS(32);
+                    if (hold != (state->total & 0xffffffffUL)) {
+                        strm->msg = (char*)"incorrect length check";
+                        state->mode = BAD;
                         break;
                     }
-                case CHECK:
-                    // printf("CHECK stage \n");
-                    state->mode = DONE;
-                case DONE:
-                    // printf("Its done \n");
-                    ret = Z_STREAM_END;
-                    goto inf_leave;
-                case BAD:
-                    ret = Z_DATA_ERROR;
-                    goto inf_leave;
-                case MEM:
-                    return Z_MEM_ERROR;
-                case SYNC:
-                default:
-                    return Z_STREAM_ERROR;
-            }
-        }
-    /*
-       Return from inflate(), updating the total counts and the check value.
-       If there was no progress during the inflate() call, return a buffer
-       error.  Call updatewindow() to create and/or update the window state.
-       Note: a memory error from inflate() is non-recoverable.
-     */
-    inf_leave:
-        RESTORE();
-        if (state->wsize || (out != strm->avail_out && state->mode < BAD && (state->mode < CHECK || flush != Z_FINISH)))
-            if (updatewindow(strm, strm->next_out, out - strm->avail_out)) {
-                state->mode = MEM;
+                    INITBITS();
+                    Tracev((stderr, "inflate:   length matches trailer\n"));
+                }
+#endif
+                state->mode = DONE;
+            case DONE:
+                ret = Z_STREAM_END;
+                goto inf_leave;
+            case BAD:
+                ret = Z_DATA_ERROR;
+                goto inf_leave;
+            case MEM:
                 return Z_MEM_ERROR;
-            }
-        // printf("in %d strm->avail_in %d \n", in, strm->avail_in);
-
-        in -= strm->avail_in;
-        out -= strm->avail_out;
-        strm->total_in += in;
-        strm->total_out += out;
-        state->total += out;
-        if ((state->wrap & 4) && out) strm->adler = state->check = UPDATE(state->check, strm->next_out - out, out);
-        strm->data_type = (int)state->bits + (state->last ? 64 : 0) + (state->mode == TYPE ? 128 : 0) +
-                          (state->mode == LEN_ || state->mode == COPY_ ? 256 : 0);
-        // printf("in %d out %d flush %d ret %d \n", in, out, flush, ret);
-        if (((in == 0 && out == 0) || flush == Z_FINISH) && ret == Z_OK) {
-            // ret = Z_BUF_ERROR;
-            ret = 1;
-            // printf("ret %d \n", ret);
+            case SYNC:
+            default:
+                return Z_STREAM_ERROR;
         }
-        return ret;
-    }
+
+/*
+   Return from inflate(), updating the total counts and the check value.
+   If there was no progress during the inflate() call, return a buffer
+   error.  Call updatewindow() to create and/or update the window state.
+   Note: a memory error from inflate() is non-recoverable.
+ */
+inf_leave:
+    RESTORE();
+    if (state->wsize || (out != strm->avail_out && state->mode < BAD && (state->mode < CHECK || flush != Z_FINISH)))
+        if (updatewindow(strm, strm->next_out, out - strm->avail_out)) {
+            state->mode = MEM;
+            return Z_MEM_ERROR;
+        }
+    in -= strm->avail_in;
+    out -= strm->avail_out;
+    strm->total_in += in;
+    strm->total_out += out;
+    state->total += out;
+    if ((state->wrap & 4) && out) strm->adler = state->check = UPDATE(state->check, strm->next_out - out, out);
+    strm->data_type = (int)state->bits + (state->last ? 64 : 0) + (state->mode == TYPE ? 128 : 0) +
+                      (state->mode == LEN_ || state->mode == COPY_ ? 256 : 0);
+    if (((in == 0 && out == 0) || flush == Z_FINISH) && ret == Z_OK) ret = Z_BUF_ERROR;
+    return ret;
 }
 }
 #if 0
@@ -1059,6 +1339,7 @@ int ZEXPORT inflateEnd(z_streamp strm)
     if (inflateStateCheck(strm)) return Z_STREAM_ERROR;
     state = (struct inflate_state FAR*)strm->state;
     if (state->window != Z_NULL) ZFREE(strm, state->window);
+    devfree(state);
     ZFREE(strm, strm->state);
     strm->state = Z_NULL;
     Tracev((stderr, "inflate: end\n"));
@@ -1286,6 +1567,12 @@ int ZEXPORT inflateCopy(z_streamp dest, z_streamp source)
     zmemcpy((voidpf)dest, (voidpf)source, sizeof(z_stream));
     zmemcpy((voidpf)copy, (voidpf)state, sizeof(struct inflate_state));
     copy->strm = dest;
+    if (state->dev_out != Z_NULL) {
+        xfChunkChain* src = (xfChunkChain*)state->dev_out;
+        xfChunkChain* chain = new xfChunkChain();
+        for (uint32_t i = 0; i < src->count(); i++) chain->append(src->chunk(i), src->chunk_size(i));
+        copy->dev_out = chain;
+    }
     if (state->lencode >= state->codes && state->lencode <= state->codes + ENOUGH - 1) {
         copy->lencode = copy->codes + (state->lencode - state->codes);
         copy->distcode = copy->codes + (state->distcode - state->codes);
@@ -15,7 +15,6 @@
 #ifndef NO_GZIP
 #define GUNZIP
 #endif
-#undef GUNZIP
 /* Possible inflate modes between inflate() calls */
 typedef enum {
     HEAD = 16180, /* i: waiting for magic header */
@@ -122,4 +121,6 @@ struct inflate_state {
     int sane;                 /* if false, allow invalid distance too far */
     int back;                 /* bits back of last unprocessed length/lit */
     unsigned was;             /* initial length of match */
+    void FAR* dev_out;        /* accelerator output not returned yet */
+    unsigned long dev_off;    /* bytes of dev_out already returned */
 };
@@ -33,6 +33,7 @@
 #include <hls_stream.h>
 
 #include "xf_database/enums.hpp"
+#include "xf_database/hll_sketch.hpp"
 #include "xf_database/utils.hpp"
 
 namespace xf {
@@ -754,6 +755,86 @@ INIT_arg_outLOOP:
 
 } // end direct_aggr_normL2
 
+// hll
+template <int DATINW, int DATOUTW, int KINW, int DIRECTW>
+void direct_aggr_hll(hls::stream<ap_uint<DATINW> >& vin_strm,
+                     hls::stream<bool>& in_e_strm,
+                     hls::stream<ap_uint<DATOUTW> >& vout_strm,
+                     hls::stream<bool>& out_e_strm,
+                     hls::stream<ap_uint<KINW> >& kin_strm,
+                     hls::stream<ap_uint<DIRECTW> >& kout_strm) {
+    bool o_isFinal = 0;
+
+    ap_uint<DATOUTW> arg_out[(1 << DIRECTW)];
+    ap_uint<1> flag[(1 << DIRECTW)];
+
+    ap_uint<DATOUTW> state_c, state_r0, state_r1, state_r2;
+    ap_uint<DIRECTW> addr_c, addr_r0, addr_r1, addr_r2;
+    addr_r0 = addr_r1 = addr_r2 = -1; // The 0x7ff should never be accessed
+
+    bool i_isFinal = in_e_strm.read();
+    o_isFinal = i_isFinal;
+// initialize all registers to zero
+INIT_arg_outLOOP:
+    for (int i = 0; i < ((1 << DIRECTW)); i++) {
+#pragma HLS PIPELINE II = 1
+        arg_out[i] = 0;
+        flag[i] = 0;
+    }
+
+    while (!o_isFinal) {
+#pragma HLS dependence array inter false
+#pragma HLS PIPELINE II = 1
+
+        // 1)Get data's address(addr == cur_key.o_data == keys' dictionary)
+        ap_uint<KINW> cur_key = kin_strm.read();
+        addr_c = cur_key; // 32bit to DIRECTW width convert in direct_aggr
+
+        // 2)Get data to insert into the sketch
+        ap_uint<DATINW> cur_val = vin_strm.read();
+
+        // 2.2) Get the isFinal
+        i_isFinal = in_e_strm.read();
+        o_isFinal = i_isFinal;
+
+        // 3)Read RAM and select the state_c based on the addr, addr0 and addr1
+        if (addr_c == addr_r0)
+            state_c = state_r0;
+        else if (addr_c == addr_r1)
+            state_c = state_r1;
+        else if (addr_c == addr_r2)
+            state_c = state_r2;
+        else {
+            state_c = arg_out[addr_c];
+            flag[addr_c] = 1;
+        }
+        // 4)Write back to RAM
+        state_c = hll_update<DATOUTW, DATINW>(state_c, cur_val);
+
+        arg_out[addr_c] = state_c;
+        // 5)shift the whole data line 1 cycle for RAM content( state) and ADDRESS
+        // (addr)
+        state_r2 = state_r1;
+        state_r1 = state_r0;
+        state_r0 = state_c;
+        addr_r2 = addr_r1;
+        addr_r1 = addr_r0;
+        addr_r0 = addr_c;
+
+    } // end while
+
+    for (int i = 0; i < (1 << DIRECTW); i++) {
+#pragma HLS PIPELINE
+        if (flag[i]) {
+            vout_strm.write(arg_out[i]);
+            kout_strm.write(i);
+            out_e_strm.write(0);
+        } else {
+        }
+    }
+    out_e_strm.write(1);
+} // end direct_aggr_hll
+
 // initialize ram
 template <int DATINW, int DATOUTW, int DIRECTW>
 void initialize_ram(ap_uint<32> op, ap_int<DATOUTW> sum[(1 << DIRECTW)], ap_int<DATOUTW + 1> cnt[(1 << DIRECTW)]) {
@@ -1017,6 +1098,92 @@ void direct_aggr_sum_cnt_mean_norm(ap_uint<32> op,
 
 } // end direct_aggr_normL2
 
+// insert into the hll sketch of each group
+template <int DATINW, int DATOUTW, int DIRECTW>
+void direct_aggr_hll(ap_int<DATOUTW + 1> aggr[(1 << DIRECTW)],
+                     hls::stream<ap_uint<DATINW> >& vin_strm,
+                     hls::stream<bool>& in_e_strm,
+                     hls::stream<ap_uint<DATOUTW> >& vout_strm,
+                     hls::stream<bool>& out_e_strm,
+                     hls::stream<ap_uint<DIRECTW> >& kin_strm,
+                     hls::stream<ap_uint<DIRECTW> >& kout_strm) {
+#pragma HLS inline off
+
+    ap_uint<DATOUTW> state_n, state_c, state_r0, state_r1, state_r2, state_r3, state_r4, state_r5;
+    ap_uint<DIRECTW> addr_c, addr_r0, addr_r1, addr_r2, addr_r3, addr_r4, addr_r5;
+    addr_r0 = addr_r1 = addr_r2 = addr_r3 = addr_r4 = addr_r5 = 1 << DIRECTW;
+    addr_c = 0;
+    state_c = 0;
+    state_r0 = state_r1 = state_r2 = state_r3 = state_r4 = state_r5 = 0;
+
+    bool isFinal = in_e_strm.read();
+    while (!isFinal) {
+#pragma HLS dependence variable = aggr pointer inter false
+#pragma HLS PIPELINE II = 1
+
+        // 1)Get data's address(addr == cur_key.o_data == keys' dictionary)
+        ap_uint<DIRECTW> cur_key = kin_strm.read();
+        addr_c = cur_key;
+
+        // 2)Get data to insert into the sketch
+        ap_uint<DATINW> cur_val = vin_strm.read();
+        isFinal = in_e_strm.read();
+
+        // 3)Read RAM and select the state_c based on the addr, addr0 and addr1
+        if (addr_c == addr_r0)
+            state_c = state_r0;
+        else if (addr_c == addr_r1)
+            state_c = state_r1;
+        else if (addr_c == addr_r2)
+            state_c = state_r2;
+        else if (addr_c == addr_r3)
+            state_c = state_r3;
+        else if (addr_c == addr_r4)
+            state_c = state_r4;
+        else if (addr_c == addr_r5)
+            state_c = state_r5;
+        else
+            state_c = aggr[addr_c](DATOUTW - 1, 0);
+
+        // 4)calculate new sketch
+        state_n = hll_update<DATOUTW, DATINW>(state_c, cur_val);
+
+        // 5)write back to ram
+        aggr[addr_c] = (ap_uint<1>(1), state_n);
+
+        // 5)shift the whole data line 1 cycle for RAM content( state) and ADDRESS
+        // (addr)
+        state_r5 = state_r4;
+        state_r4 = state_r3;
+        state_r3 = state_r2;
+        state_r2 = state_r1;
+        state_r1 = state_r0;
+        state_r0 = state_n;
+
+        addr_r5 = addr_r4;
+        addr_r4 = addr_r3;
+        addr_r3 = addr_r2;
+        addr_r2 = addr_r1;
+        addr_r1 = addr_r0;
+        addr_r0 = addr_c;
+    } // end while
+
+    // output
+    for (int i = 0; i < (1 << DIRECTW); i++) {
+#pragma HLS PIPELINE
+
+        ap_int<DATOUTW + 1> temp = aggr[i];
+        if (temp[DATOUTW] == 1) {
+            vout_strm.write(temp(DATOUTW - 1, 0));
+            kout_strm.write(i);
+            out_e_strm.write(0);
+        } else {
+            // no operation
+        }
+    }
+    out_e_strm.write(1);
+} // end direct_aggr_hll
+
 } // namespace details
 } // namespace database
 } // namespace xf
@@ -1040,8 +1207,10 @@ namespace database {
  *  - AOP_VARIANCE
  *  - AOP_NORML1
  *  - AOP_NORML2
+ *  - AOP_HLL
  *
- * The return value is typed the same as the input payload value.
+ * The return value is typed the same as the input payload value. For AOP_HLL it is the HyperLogLog sketch of the
+ * group, see ``hll_sketch.hpp`` for the register layout.
  * \rst
  * .. CAUTION::
  *     Attention should be paid for overflow in sum or count.
@@ -1081,6 +1250,8 @@ void directGroupAggregate(hls::stream<ap_uint<DATINW> >& vin_strm,
         details::direct_aggr_normL1(vin_strm, in_e_strm, vout_strm, out_e_strm, kin_strm, kout_strm);
     } else if (op == AOP_NORML2) {
         details::direct_aggr_normL2(vin_strm, in_e_strm, vout_strm, out_e_strm, kin_strm, kout_strm);
+    } else if (op == AOP_HLL) {
+        details::direct_aggr_hll(vin_strm, in_e_strm, vout_strm, out_e_strm, kin_strm, kout_strm);
     }
 
 } // direct_aggregate
@@ -1099,8 +1270,10 @@ void directGroupAggregate(hls::stream<ap_uint<DATINW> >& vin_strm,
  *  - AOP_COUNT
  *  - AOP_MEAN
  *  - AOP_NORM1
+ *  - AOP_HLL
  *
- * The return value is typed the same as the input payload value.
+ * The return value is typed the same as the input payload value. For AOP_HLL it is the HyperLogLog sketch of the
+ * group, see ``hll_sketch.hpp`` for the register layout.
  * \rst
  * .. CAUTION::
  *     Attention should be paid for overflow in sum or count.
@@ -1142,6 +1315,9 @@ void directGroupAggregate(ap_uint<32> op,
     } else if (op == AOP_SUM || op == AOP_COUNT || op == AOP_COUNTNONZEROS || op == AOP_MEAN || op == AOP_NORML1) {
         details::direct_aggr_sum_cnt_mean_norm<DATINW, DATOUTW, DIRECTW>(op, sum, cnt, vin_strm, in_e_strm, vout_strm,
                                                                          out_e_strm, kin_strm, kout_strm);
+    } else if (op == AOP_HLL) {
+        details::direct_aggr_hll<DATINW, DATOUTW, DIRECTW>(cnt, vin_strm, in_e_strm, vout_strm, out_e_strm, kin_strm,
+                                                           kout_strm);
     }
 } // direct_aggregate
 
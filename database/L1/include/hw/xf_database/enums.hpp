@@ -35,7 +35,8 @@ namespace enums {
 
 /** @brief Aggregate operators, used by all aggregate functions.
  *
- * hash-aggregate only supports first four operators.
+ * hash-aggregate only supports first four operators and AOP_HLL.
+ * AOP_HLL builds a HyperLogLog sketch of the payload for approximate count distinct.
  */
 enum AggregateOp {
     AOP_MIN = 0,
@@ -46,9 +47,13 @@ enum AggregateOp {
     AOP_MEAN,
     AOP_VARIANCE,
     AOP_NORML1,
-    AOP_NORML2
+    AOP_NORML2,
+    AOP_HLL
 };
 
+/// @brief width of one HyperLogLog register in bits, registers are packed from the LSB.
+enum { HLLRegWidth = 5 };
+
 /**
  * @brief Comparison operator of filter.
  */
@@ -79,6 +84,16 @@ enum { FilterOpWidth = 4 };
 /// @brief Sort Order enum.
 enum SortOrder { SORT_ASCENDING = 1, SORT_DESCENDING = 0 };
 
+/**
+ * @brief Encoding of a compressed column page, read by scanCompressedCol.
+ */
+enum ColEncoding {
+    CENC_RAW = 0, ///< 32-bit values, 16 per word.
+    CENC_BITPACK, ///< base plus an unsigned offset of the page bit width.
+    CENC_RLE,     ///< (value, run length) pairs of 32 bits each, 8 per word.
+    CENC_DELTA    ///< previous value plus base plus an unsigned offset of the page bit width.
+};
+
 } // namespace enums
 
 using namespace enums;
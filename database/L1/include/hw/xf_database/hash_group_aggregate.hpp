@@ -34,6 +34,7 @@
 #include "xf_database/combine_split_col.hpp"
 #include "xf_database/hash_lookup3.hpp"
 #include "xf_database/hash_join_v2.hpp"
+#include "xf_database/hll_sketch.hpp"
 #include "xf_database/types.hpp"
 #include "xf_database/enums.hpp"
 
@@ -797,7 +798,7 @@ void initial_uram(
     } else if (op == enums::AOP_MAX) {
         initial_value = ap_uint<_WPay * _PayNM>(0);
     } else if (op == enums::AOP_SUM || op == enums::AOP_COUNT || op == enums::AOP_COUNTNONZEROS ||
-               op == enums::AOP_MEAN) {
+               op == enums::AOP_MEAN || op == enums::AOP_HLL) {
         initial_value = 0;
     } else {
         // not supported yet
@@ -1204,9 +1205,9 @@ void update_pld_elem(
         col_agg[i][1] = i_pld_uram[1]((i + 1) * _WPay - 1, i * _WPay);
         col_agg[i][2] = i_pld_uram[2]((i + 1) * _WPay - 1, i * _WPay);
 
-        // col0: min-max cnt-cnt_nz default:max
-        // col1: sum_l avg_l default:sum
-        // col2: sum_h avg_h default:sum
+        // col0: min-max cnt-cnt_nz hll_l default:max
+        // col1: sum_l avg_l hll_m default:sum
+        // col2: sum_h avg_h hll_h default:sum
 
         if (op[i] == enums::AOP_COUNT || op[i] == enums::AOP_COUNTNONZEROS || op[i] == enums::AOP_SUM ||
             op[i] == enums::AOP_MEAN) {
@@ -1224,6 +1225,17 @@ void update_pld_elem(
         new_col_agg[i][1] = accum_new(_WPay - 1, 0);
         new_col_agg[i][2] = accum_new(2 * _WPay - 1, _WPay);
 
+        // hll: col2, col1 and col0 together hold the sketch
+        if (op[i] == enums::AOP_HLL) {
+            ap_uint<3 * _WPay> sketch = (col_agg[i][2], col_agg[i][1], col_agg[i][0]);
+            if (enable) {
+                sketch = hll_update<3 * _WPay, _WPay>(sketch, pld[i]);
+            }
+            new_col_agg[i][0] = sketch(_WPay - 1, 0);
+            new_col_agg[i][1] = sketch(2 * _WPay - 1, _WPay);
+            new_col_agg[i][2] = sketch(3 * _WPay - 1, 2 * _WPay);
+        }
+
 #ifndef __SYNTHESIS__
 #ifdef DEBUG_UPDATE_PLD
         if (i == 0) {
@@ -2600,7 +2612,8 @@ namespace database {
  * @param aggr_key_out output of key columns.
  * @param aggr_pld_out output of pld columns. [0][*] is the result of min/max/cnt for
  * pld columns, [1][*] is the low-bit value of sum/average, [2][*] is the hight-bit
- * value of sum/average.
+ * value of sum/average. For hll columns ([2][*], [1][*], [0][*]) is the HyperLogLog
+ * sketch of ``3 * _WPay`` bits, see ``hll_sketch.hpp`` for the register layout.
  * @param strm_e_out is the end signal of output.
  */
 template <int _WKey,
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file hll_sketch.hpp
+ * @brief HyperLogLog sketch registers used by the group aggregate primitives.
+ *
+ * A sketch of W bits holds ``2 ^ hll_index_bits<W>::value`` registers of ``HLLRegWidth`` bits, register i at bits
+ * ``[HLLRegWidth * (i + 1) - 1, HLLRegWidth * i]``. Sketches of the same width are merged by taking the max of each
+ * register, so partial results of different partitions can be combined on host.
+ *
+ * This file is part of Vitis Database Library.
+ */
+
+#ifndef XF_DATABASE_HLL_SKETCH_H
+#define XF_DATABASE_HLL_SKETCH_H
+
+#ifndef __cplusplus
+#error "Vitis Database Library only works with C++."
+#endif
+
+#include <ap_int.h>
+
+#include "xf_database/enums.hpp"
+#include "xf_database/hash_lookup3.hpp"
+
+namespace xf {
+namespace database {
+namespace details {
+
+/// @brief number of index bits of a sketch packed in W bits, at most 4096 registers.
+template <int W, int P = 12>
+struct hll_index_bits {
+    enum { value = W >= (HLLRegWidth << P) ? P : hll_index_bits<W, P - 1>::value };
+};
+
+template <int W>
+struct hll_index_bits<W, 0> {
+    enum { value = 0 };
+};
+
+/// @brief position of the first set bit counted from the MSB, starting from 1 and saturated to the register range.
+template <int W>
+ap_uint<HLLRegWidth> hll_rank(ap_uint<W> w) {
+#pragma HLS inline
+    ap_uint<HLLRegWidth> rank = 1;
+    bool hit = false;
+    for (int i = W - 1; i >= 0; i--) {
+#pragma HLS unroll
+        hit = hit || w[i];
+        if (!hit && rank != ap_uint<HLLRegWidth>(-1)) rank++;
+    }
+    return rank;
+}
+
+/// @brief insert one value into a sketch.
+/// @tparam W width of the sketch, at least HLLRegWidth.
+/// @tparam DATINW width of the value.
+/// @param regs sketch before the insert.
+/// @param val value to count.
+/// @return sketch after the insert.
+template <int W, int DATINW>
+ap_uint<W> hll_update(ap_uint<W> regs, ap_uint<DATINW> val) {
+#pragma HLS inline
+    const int P = hll_index_bits<W>::value;
+
+    // low P bits of the hash select the register, the rest gives the rank
+    ap_uint<64> hash;
+    hashlookup3_core<DATINW>(val, hash);
+    ap_uint<64> mask = (ap_uint<64>(1) << P) - 1;
+    ap_uint<13> idx = hash & mask;
+    ap_uint<HLLRegWidth> rank = hll_rank<64>(hash | mask);
+
+    for (int i = 0; i < (1 << P); i++) {
+#pragma HLS unroll
+        ap_uint<HLLRegWidth> r = regs(HLLRegWidth * i + HLLRegWidth - 1, HLLRegWidth * i);
+        if (idx == i && rank > r) {
+            regs(HLLRegWidth * i + HLLRegWidth - 1, HLLRegWidth * i) = rank;
+        }
+    }
+    return regs;
+}
+
+/// @brief merge two sketches of the same width, register by register.
+template <int W>
+ap_uint<W> hll_merge(ap_uint<W> a, ap_uint<W> b) {
+#pragma HLS inline
+    const int P = hll_index_bits<W>::value;
+    for (int i = 0; i < (1 << P); i++) {
+#pragma HLS unroll
+        ap_uint<HLLRegWidth> ra = a(HLLRegWidth * i + HLLRegWidth - 1, HLLRegWidth * i);
+        ap_uint<HLLRegWidth> rb = b(HLLRegWidth * i + HLLRegWidth - 1, HLLRegWidth * i);
+        if (rb > ra) {
+            a(HLLRegWidth * i + HLLRegWidth - 1, HLLRegWidth * i) = rb;
+        }
+    }
+    return a;
+}
+
+} // namespace details
+} // namespace database
+} // namespace xf
+
+#endif // XF_DATABASE_HLL_SKETCH_H
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file scan_compressed_col.hpp
+ * @brief SCAN of lightweight compressed columns, decoded into one value per cycle.
+ *
+ * A column page is a 512-bit header word followed by the payload words. The header holds
+ *
+ * - ``[7:0]`` encoding, one of ``ColEncoding``
+ * - ``[15:8]`` bit width of the packed offsets, 1 to 32
+ * - ``[63:32]`` number of rows
+ * - ``[95:64]`` base, added to each offset
+ * - ``[127:96]`` value before the first row, for ``CENC_DELTA``
+ * - ``[159:128]`` number of payload words
+ *
+ * Packed offsets are stored from the LSB of each payload word and never cross a word, so one word holds
+ * ``512 / width`` of them.
+ *
+ * This file is part of Vitis Database Library.
+ */
+
+#ifndef XF_DATABASE_SCAN_COMPRESSED_COL_H
+#define XF_DATABASE_SCAN_COMPRESSED_COL_H
+
+#ifndef __cplusplus
+#error "Vitis Database Library only works with C++."
+#endif
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+#include "xf_database/enums.hpp"
+
+namespace xf {
+namespace database {
+namespace details {
+
+template <int burst_len>
+void read_page(ap_uint<512>* page_ptr, hls::stream<ap_uint<512> >& hdr_strm, hls::stream<ap_uint<512> >& w_strm) {
+    ap_uint<512> hdr = page_ptr[0];
+    hdr_strm.write(hdr);
+    const int nword = hdr(159, 128).to_int();
+
+READ_PAGE:
+    for (int i = 0; i < nword; i += burst_len) {
+        const int len = ((i + burst_len) > nword) ? (nword - i) : burst_len;
+    READ_BURST:
+        for (int j = 0; j < len; ++j) {
+#pragma HLS pipeline II = 1
+            w_strm.write(page_ptr[1 + i + j]);
+        }
+    }
+}
+
+// one row per iteration, a payload word is pulled in only when the previous one is used up
+inline void decode_page(hls::stream<ap_uint<512> >& hdr_strm,
+                        hls::stream<ap_uint<512> >& w_strm,
+                        hls::stream<ap_uint<32> >& c_strm,
+                        hls::stream<bool>& e_strm) {
+    ap_uint<512> hdr = hdr_strm.read();
+    const int enc = hdr(7, 0).to_int();
+    const int bw = hdr(15, 8).to_int();
+    const int nrow = hdr(63, 32).to_int();
+    const ap_uint<32> base = hdr(95, 64);
+    ap_uint<32> acc = hdr(127, 96);
+
+    const bool rle = enc == CENC_RLE;
+    const bool delta = enc == CENC_DELTA;
+    const int step = rle ? 64 : bw;
+    const int per_word = 512 / step;
+    const ap_uint<32> mask = bw >= 32 ? 0xffffffffu : (1u << bw) - 1;
+
+    ap_uint<512> w = 0;
+    int left = 0;
+    ap_uint<32> val = 0;
+    ap_uint<32> run = 0;
+DECODE_LOOP:
+    for (int i = 0; i < nrow; ++i) {
+#pragma HLS pipeline II = 1
+        bool fetch = !rle || run == 0;
+        if (fetch && left == 0) {
+            w = w_strm.read();
+            left = per_word;
+        }
+        if (fetch) {
+            ap_uint<64> f = w(63, 0);
+            w >>= step;
+            left--;
+            if (rle) {
+                val = f(31, 0);
+                run = f(63, 32);
+            } else {
+                ap_uint<32> p = f(31, 0) & mask;
+                acc += base + p;
+                val = delta ? acc : ap_uint<32>(base + p);
+            }
+        }
+        if (rle) run--;
+        c_strm.write(val);
+        e_strm.write(false);
+    }
+    e_strm.write(true);
+}
+
+// rows of both columns go out together, columns of one table have the same number of rows
+inline void zip_col(hls::stream<ap_uint<32> >& c0_in_strm,
+                    hls::stream<bool>& e0_strm,
+                    hls::stream<ap_uint<32> >& c1_in_strm,
+                    hls::stream<bool>& e1_strm,
+                    hls::stream<ap_uint<32> >& c0_strm,
+                    hls::stream<ap_uint<32> >& c1_strm,
+                    hls::stream<bool>& e_strm) {
+    bool e0 = e0_strm.read();
+    e1_strm.read();
+ZIP_LOOP:
+    while (!e0) {
+#pragma HLS pipeline II = 1
+        c0_strm.write(c0_in_strm.read());
+        c1_strm.write(c1_in_strm.read());
+        e_strm.write(false);
+        e0 = e0_strm.read();
+        e1_strm.read();
+    }
+    e_strm.write(true);
+}
+
+} // namespace details
+} // namespace database
+} // namespace xf
+
+namespace xf {
+namespace database {
+
+/**
+ * @brief Scan 1 compressed column from DDR/HBM buffers.
+ *
+ * The page is read in bursts and decoded at one row per cycle, raw, bit-packed, run-length and delta pages alike.
+ * A column of 3-bit flags is read with about a tenth of the bandwidth of its raw 32-bit form.
+ *
+ * @tparam burst_len burst read length, must be supported by MC.
+ *
+ * @param page_ptr buffer pointer to the column page, header word first.
+ * @param c0_strm column 0 stream.
+ * @param e_row_strm output end flag stream.
+ */
+template <int burst_len>
+void scanCompressedCol(ap_uint<512>* page_ptr, hls::stream<ap_uint<32> >& c0_strm, hls::stream<bool>& e_row_strm) {
+#pragma HLS dataflow
+    const int fifo_depth = burst_len * 2;
+
+    hls::stream<ap_uint<512> > hdr_strm("hdr_strm");
+#pragma HLS stream variable = hdr_strm depth = 2
+    hls::stream<ap_uint<512> > w_strm("w_strm");
+#pragma HLS stream variable = w_strm depth = fifo_depth
+
+    details::read_page<burst_len>(page_ptr, hdr_strm, w_strm);
+    details::decode_page(hdr_strm, w_strm, c0_strm, e_row_strm);
+}
+
+/**
+ * @brief Scan 2 compressed columns from DDR/HBM buffers.
+ *
+ * Each column may use its own encoding, both pages must hold the same number of rows.
+ *
+ * @tparam burst_len burst read length, must be supported by MC.
+ *
+ * @param c0_page_ptr buffer pointer to the page of column 0.
+ * @param c1_page_ptr buffer pointer to the page of column 1.
+ * @param c0_strm column 0 stream.
+ * @param c1_strm column 1 stream.
+ * @param e_row_strm output end flag stream.
+ */
+template <int burst_len>
+void scanCompressedCol(ap_uint<512>* c0_page_ptr,
+                       ap_uint<512>* c1_page_ptr,
+                       hls::stream<ap_uint<32> >& c0_strm,
+                       hls::stream<ap_uint<32> >& c1_strm,
+                       hls::stream<bool>& e_row_strm) {
+#pragma HLS dataflow
+    const int fifo_depth = burst_len * 2;
+
+    hls::stream<ap_uint<512> > hdr0_strm("hdr0_strm");
+#pragma HLS stream variable = hdr0_strm depth = 2
+    hls::stream<ap_uint<512> > w0_strm("w0_strm");
+#pragma HLS stream variable = w0_strm depth = fifo_depth
+    hls::stream<ap_uint<512> > hdr1_strm("hdr1_strm");
+#pragma HLS stream variable = hdr1_strm depth = 2
+    hls::stream<ap_uint<512> > w1_strm("w1_strm");
+#pragma HLS stream variable = w1_strm depth = fifo_depth
+    hls::stream<ap_uint<32> > d0_strm("d0_strm");
+#pragma HLS stream variable = d0_strm depth = 8
+    hls::stream<ap_uint<32> > d1_strm("d1_strm");
+#pragma HLS stream variable = d1_strm depth = 8
+    hls::stream<bool> e0_strm("e0_strm");
+#pragma HLS stream variable = e0_strm depth = 8
+    hls::stream<bool> e1_strm("e1_strm");
+#pragma HLS stream variable = e1_strm depth = 8
+
+    details::read_page<burst_len>(c0_page_ptr, hdr0_strm, w0_strm);
+    details::read_page<burst_len>(c1_page_ptr, hdr1_strm, w1_strm);
+    details::decode_page(hdr0_strm, w0_strm, d0_strm, e0_strm);
+    details::decode_page(hdr1_strm, w1_strm, d1_strm, e1_strm);
+    details::zip_col(d0_strm, e0_strm, d1_strm, e1_strm, c0_strm, c1_strm, e_row_strm);
+}
+
+} // namespace database
+} // namespace xf
+
+#endif // XF_DATABASE_SCAN_COMPRESSED_COL_H
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file top_k.hpp
+ * @brief Top-K template function implementation, for ORDER BY ... LIMIT k.
+ *
+ * This file is part of Vitis Database Library.
+ */
+
+#ifndef XF_DATABASE_TOP_K_HPP
+#define XF_DATABASE_TOP_K_HPP
+
+#ifndef __cplusplus
+#error "Vitis Database Library only works with C++."
+#endif
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+#include "xf_database/utils.hpp"
+
+namespace xf {
+namespace database {
+namespace details {
+
+// a goes before b, ties keep the row which came first
+template <typename KEY_TYPE>
+inline bool top_k_before(KEY_TYPE a, KEY_TYPE b, bool order) {
+#pragma HLS inline
+    return order ? (a < b) : (b < a);
+}
+
+/// @brief keep the best K rows of one lane in a sorted register array, emit them when the input ends.
+template <typename KEY_TYPE, typename DATA_TYPE, int K>
+void top_k_lane(hls::stream<DATA_TYPE>& din_strm,
+                hls::stream<KEY_TYPE>& kin_strm,
+                hls::stream<bool>& in_e_strm,
+                hls::stream<DATA_TYPE>& dout_strm,
+                hls::stream<KEY_TYPE>& kout_strm,
+                hls::stream<bool>& out_e_strm,
+                ap_uint<32> limit,
+                bool order) {
+    KEY_TYPE key[K];
+#pragma HLS array_partition variable = key complete
+    DATA_TYPE data[K];
+#pragma HLS array_partition variable = data complete
+    bool valid[K];
+#pragma HLS array_partition variable = valid complete
+    bool ins[K];
+#pragma HLS array_partition variable = ins complete
+
+    for (int i = 0; i < K; i++) {
+#pragma HLS unroll
+        valid[i] = false;
+    }
+
+    bool e = in_e_strm.read();
+insert_loop:
+    while (!e) {
+#pragma HLS pipeline II = 1
+        KEY_TYPE k = kin_strm.read();
+        DATA_TYPE d = din_strm.read();
+        e = in_e_strm.read();
+
+        // valid entries form a sorted prefix, so ins[] is false...false true...true
+        for (int i = 0; i < K; i++) {
+#pragma HLS unroll
+            ins[i] = !valid[i] || top_k_before(k, key[i], order);
+        }
+        // shift the tail down by one and drop the new row into the first slot it beats
+        for (int i = K - 1; i >= 0; i--) {
+#pragma HLS unroll
+            if (ins[i]) {
+                if (i == 0 || !ins[i - 1]) {
+                    key[i] = k;
+                    data[i] = d;
+                    valid[i] = true;
+                } else {
+                    key[i] = key[i - 1];
+                    data[i] = data[i - 1];
+                    valid[i] = valid[i - 1];
+                }
+            }
+        }
+    }
+
+emit_loop:
+    for (ap_uint<32> i = 0; i < K; i++) {
+#pragma HLS pipeline II = 1
+        if (valid[i] && i < limit) {
+            kout_strm.write(key[i]);
+            dout_strm.write(data[i]);
+            out_e_strm.write(false);
+        }
+    }
+    out_e_strm.write(true);
+}
+
+/// @brief merge the sorted output of CH_NM lanes, keeping the first limit rows.
+template <typename KEY_TYPE, typename DATA_TYPE, int CH_NM>
+void top_k_merge(hls::stream<DATA_TYPE> din_strm[CH_NM],
+                 hls::stream<KEY_TYPE> kin_strm[CH_NM],
+                 hls::stream<bool> in_e_strm[CH_NM],
+                 hls::stream<DATA_TYPE>& dout_strm,
+                 hls::stream<KEY_TYPE>& kout_strm,
+                 hls::stream<bool>& out_e_strm,
+                 ap_uint<32> limit,
+                 bool order) {
+    KEY_TYPE head_k[CH_NM];
+#pragma HLS array_partition variable = head_k complete
+    DATA_TYPE head_d[CH_NM];
+#pragma HLS array_partition variable = head_d complete
+    bool has[CH_NM];
+#pragma HLS array_partition variable = has complete
+    bool done[CH_NM];
+#pragma HLS array_partition variable = done complete
+
+    for (int c = 0; c < CH_NM; c++) {
+#pragma HLS unroll
+        has[c] = false;
+        done[c] = false;
+    }
+
+    ap_uint<32> cnt = 0;
+    bool all_done = false;
+merge_loop:
+    while (!all_done) {
+#pragma HLS pipeline II = 1
+        // every lane either has a head or has ended before a row is picked
+        for (int c = 0; c < CH_NM; c++) {
+#pragma HLS unroll
+            if (!has[c] && !done[c]) {
+                if (in_e_strm[c].read()) {
+                    done[c] = true;
+                } else {
+                    head_k[c] = kin_strm[c].read();
+                    head_d[c] = din_strm[c].read();
+                    has[c] = true;
+                }
+            }
+        }
+
+        bool found = false;
+        ap_uint<8> sel = 0;
+        KEY_TYPE best = head_k[0];
+        for (int c = 0; c < CH_NM; c++) {
+#pragma HLS unroll
+            if (has[c] && (!found || top_k_before(head_k[c], best, order))) {
+                found = true;
+                sel = c;
+                best = head_k[c];
+            }
+        }
+
+        // the lanes are drained even after limit rows have been written
+        if (found) {
+            if (cnt < limit) {
+                kout_strm.write(best);
+                dout_strm.write(head_d[sel]);
+                out_e_strm.write(false);
+                cnt++;
+            }
+            has[sel] = false;
+        }
+
+        all_done = true;
+        for (int c = 0; c < CH_NM; c++) {
+#pragma HLS unroll
+            all_done = all_done && done[c] && !has[c];
+        }
+    }
+    out_e_strm.write(true);
+}
+
+} // namespace details
+} // namespace database
+} // namespace xf
+
+namespace xf {
+namespace database {
+
+/**
+ * @brief Top-K of one stream, keeps only the first limit rows in key order.
+ *
+ * The best rows seen so far are held in a sorted on-chip register array of ``K`` entries, each input row is inserted
+ * with ``K`` parallel comparisons at II=1. The kept rows are emitted in order once the input ends. Rows with equal keys
+ * keep their input order.
+ *
+ * @tparam KEY_TYPE the input and output key type
+ * @tparam DATA_TYPE the input and output data type
+ * @tparam K the max number of rows kept
+ *
+ * @param dinStrm input data stream
+ * @param kinStrm input key stream
+ * @param endInStrm end flag stream for input
+ * @param doutStrm output data stream
+ * @param koutStrm output key stream
+ * @param endOutStrm end flag stream for output
+ * @param limit number of rows to output, no more than K
+ * @param order 1:smallest keys first 0:largest keys first
+ */
+template <typename KEY_TYPE, typename DATA_TYPE, int K>
+void topK(hls::stream<DATA_TYPE>& dinStrm,
+          hls::stream<KEY_TYPE>& kinStrm,
+          hls::stream<bool>& endInStrm,
+          hls::stream<DATA_TYPE>& doutStrm,
+          hls::stream<KEY_TYPE>& koutStrm,
+          hls::stream<bool>& endOutStrm,
+          ap_uint<32> limit,
+          bool order) {
+    details::top_k_lane<KEY_TYPE, DATA_TYPE, K>(dinStrm, kinStrm, endInStrm, doutStrm, koutStrm, endOutStrm, limit,
+                                                order);
+}
+
+/**
+ * @brief Top-K of multiple streams, keeps only the first limit rows in key order over all channels.
+ *
+ * Each channel keeps its own sorted register array of ``K`` entries, so ``CH_NM`` rows are consumed per cycle.
+ * When all channels end, their kept rows are merged into one sorted output stream. Rows with equal keys are output
+ * in channel order.
+ *
+ * @tparam KEY_TYPE the input and output key type
+ * @tparam DATA_TYPE the input and output data type
+ * @tparam K the max number of rows kept
+ * @tparam CH_NM number of input channels
+ *
+ * @param dinStrm input data streams
+ * @param kinStrm input key streams
+ * @param endInStrm end flag streams for input
+ * @param doutStrm output data stream
+ * @param koutStrm output key stream
+ * @param endOutStrm end flag stream for output
+ * @param limit number of rows to output, no more than K
+ * @param order 1:smallest keys first 0:largest keys first
+ */
+template <typename KEY_TYPE, typename DATA_TYPE, int K, int CH_NM>
+void topK(hls::stream<DATA_TYPE> dinStrm[CH_NM],
+          hls::stream<KEY_TYPE> kinStrm[CH_NM],
+          hls::stream<bool> endInStrm[CH_NM],
+          hls::stream<DATA_TYPE>& doutStrm,
+          hls::stream<KEY_TYPE>& koutStrm,
+          hls::stream<bool>& endOutStrm,
+          ap_uint<32> limit,
+          bool order) {
+#pragma HLS dataflow
+
+    hls::stream<DATA_TYPE> d_strm[CH_NM];
+#pragma HLS stream variable = d_strm depth = 32
+#pragma HLS array_partition variable = d_strm complete
+    hls::stream<KEY_TYPE> k_strm[CH_NM];
+#pragma HLS stream variable = k_strm depth = 32
+#pragma HLS array_partition variable = k_strm complete
+    hls::stream<bool> e_strm[CH_NM];
+#pragma HLS stream variable = e_strm depth = 32
+#pragma HLS array_partition variable = e_strm complete
+
+    for (int c = 0; c < CH_NM; c++) {
+#pragma HLS unroll
+        details::top_k_lane<KEY_TYPE, DATA_TYPE, K>(dinStrm[c], kinStrm[c], endInStrm[c], d_strm[c], k_strm[c],
+                                                    e_strm[c], limit, order);
+    }
+    details::top_k_merge<KEY_TYPE, DATA_TYPE, CH_NM>(d_strm, k_strm, e_strm, doutStrm, koutStrm, endOutStrm, limit,
+                                                     order);
+}
+
+} // namespace database
+} // namespace xf
+
+#endif // XF_DATABASE_TOP_K_HPP
@@ -44,6 +44,7 @@
  *   AOP_VARIANCE when TESTCASE == 9
  *   AOP_NORML1   when TESTCASE == 10
  *   AOP_NORML2   when TESTCASE == 11
+ *   AOP_HLL      when TESTCASE == 12
  */
 #define TESTCASE (4)
 #if (TESTCASE == 1)
@@ -70,6 +71,9 @@
 #elif (TESTCASE == 11)
 #define DAOP xf::database::AOP_NORML2
 #define FUN norml2
+#elif (TESTCASE == 12)
+#define DAOP xf::database::AOP_HLL
+#define FUN hll
 #endif
 
 // For debug
@@ -607,6 +611,56 @@ void norml2(hls::stream<ap_uint<DATINW> >& din_strm,
     }
 }
 
+
+// hll
+template <int DATINW, int DATOUTW, int DIRECTW>
+void hll(hls::stream<ap_uint<DATINW> >& din_strm,
+         hls::stream<ap_uint<DATOUTW> >& out_strm,
+         hls::stream<ap_uint<DIRECTW> >& kin_strm,
+         hls::stream<ap_uint<DIRECTW> >& kout_strm) {
+    const int P = xf::database::details::hll_index_bits<DATOUTW>::value;
+    const int RW = xf::database::HLLRegWidth;
+    // dat
+    ap_uint<DATINW> ret;
+    int reg[CNT_AGG_TEST][1 << P];
+    // key
+    ap_uint<DIRECTW> rkey;
+    // flag
+    int flag[CNT_AGG_TEST];
+
+    // initial flag
+    for (int i = 0; i < CNT_AGG_TEST; i++) {
+        flag[i] = 0;
+        for (int j = 0; j < (1 << P); j++) reg[i][j] = 0;
+    }
+    // aggregate
+    for (int j = 0; j < loopn; j++) {
+        ret = din_strm.read();
+        rkey = kin_strm.read();
+
+        ap_uint<64> hash;
+        xf::database::details::hashlookup3_core<DATINW>(ret, hash);
+        uint64_t h = hash;
+        int idx = h & ((1 << P) - 1);
+        int rank = 1;
+        for (int b = 63; b >= P && !((h >> b) & 1); b--) rank++;
+        if (rank > (1 << RW) - 1) rank = (1 << RW) - 1;
+        if (rank > reg[rkey][idx]) reg[rkey][idx] = rank;
+        flag[rkey] = 1;
+    }
+    // output stream
+    for (int i = 0; i < CNT_AGG_TEST; i++) {
+        if (flag[i]) {
+            distinct_key++;
+            ap_uint<DATOUTW> sketch = 0;
+            for (int j = 0; j < (1 << P); j++) sketch(RW * j + RW - 1, RW * j) = reg[i][j];
+            out_strm.write(sketch);
+            kout_strm.write(i);
+            std::cout << "rkey and hll is " << i << ", " << std::hex << sketch << std::dec << std::endl;
+        }
+    }
+}
+
 } // namespace ref_direct_norml2
 
 int main() {
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+#include "gqe_blocks/gqe_types.hpp"
+#include "gqe_blocks/scan_for_hp.hpp"
+
+using namespace xf::database::gqe;
+
+#define COL_NM 3
+#define TestNumber 1000
+// words of one input column, and of the whole input table with its header
+#define COL_DEPTH ((TestNumber + VEC_LEN - 1) / VEC_LEN)
+#define TABLE_DEPTH (1 + 2 * COL_DEPTH)
+
+static void merge_ch(hls::stream<ap_uint<32> > ch_strms[1][COL_NM],
+                     hls::stream<bool> e_ch_strms[1],
+                     hls::stream<ap_uint<32> > col_strms[COL_NM],
+                     hls::stream<bool>& e_strm) {
+    bool e = e_ch_strms[0].read();
+    while (!e) {
+#pragma HLS pipeline II = 1
+        for (int c = 0; c < COL_NM; c++) {
+#pragma HLS unroll
+            col_strms[c].write(ch_strms[0][c].read());
+        }
+        e_strm.write(false);
+        e = e_ch_strms[0].read();
+    }
+    e_strm.write(true);
+}
+
+// scan of gqePart
+void hls_db_gqe_part_scan_zone_skip(ap_uint<512>* buf_in,
+                                    hls::stream<int8_t>& col_id_strm,
+                                    hls::stream<ap_uint<32> > col_strms[COL_NM],
+                                    hls::stream<bool>& e_strm,
+                                    hls::stream<int>& bit_num_strm,
+                                    hls::stream<int>& bit_num_strm_copy) {
+#pragma HLS INTERFACE m_axi port = buf_in bundle = gmem0_0 depth = TABLE_DEPTH
+#pragma HLS dataflow
+    hls::stream<ap_uint<32> > ch_strms[1][COL_NM];
+#pragma HLS stream variable = ch_strms depth = 32
+    hls::stream<bool> e_ch_strms[1];
+#pragma HLS stream variable = e_ch_strms depth = 32
+    scan_to_channel<COL_NM, 1>(3, buf_in, col_id_strm, ch_strms, e_ch_strms, bit_num_strm, bit_num_strm_copy);
+    merge_ch(ch_strms, e_ch_strms, col_strms, e_strm);
+}
+
+struct SkipCase {
+    const char* name;
+    int zone_naxi;
+    std::vector<int> skip;
+};
+
+int main() {
+    int nerror = 0;
+
+    // two columns, scanned as col 1, row id and col 0
+    std::vector<ap_uint<512> > table(TABLE_DEPTH, 0);
+    for (int r = 0; r < TestNumber; r++) {
+        table[1 + r / VEC_LEN](32 * (r % VEC_LEN) + 31, 32 * (r % VEC_LEN)) = r * 3 + 7;
+        table[1 + COL_DEPTH + r / VEC_LEN](32 * (r % VEC_LEN) + 31, 32 * (r % VEC_LEN)) = r ^ 0x5a5a;
+    }
+    const int8_t col_id[COL_NM] = {1, -2, 0};
+
+    // 5 words of 16 rows make 13 blocks, the last one partial; 40 words are longer than a burst
+    SkipCase cases[] = {{"full scan", 0, {}},
+                        {"no block skipped", 5, {}},
+                        {"first, middle and last blocks skipped", 5, {0, 3, 4, 12}},
+                        {"all blocks skipped", 5, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}},
+                        {"first long block skipped", 40, {0}},
+                        {"last long block skipped", 40, {1}}};
+    for (size_t t = 0; t < sizeof(cases) / sizeof(cases[0]); t++) {
+        const SkipCase& c = cases[t];
+        ap_uint<512> hdr = 0;
+        hdr(31, 0) = TestNumber;
+        hdr(63, 32) = COL_DEPTH;
+        hdr(127, 96) = c.zone_naxi;
+        std::vector<bool> skipped(TestNumber, false);
+        for (size_t k = 0; k < c.skip.size(); k++) {
+            hdr[128 + c.skip[k]] = 1;
+            for (int r = c.skip[k] * c.zone_naxi * VEC_LEN; r < (c.skip[k] + 1) * c.zone_naxi * VEC_LEN; r++) {
+                if (r < TestNumber) skipped[r] = true;
+            }
+        }
+        table[0] = hdr;
+
+        hls::stream<int8_t> col_id_strm("col_id_strm");
+        for (int i = 0; i < COL_NM; i++) col_id_strm.write(col_id[i]);
+        hls::stream<ap_uint<32> > col_strms[COL_NM];
+        hls::stream<bool> e_strm("e_strm");
+        hls::stream<int> bit_num_strm("bit_num_strm");
+        hls::stream<int> bit_num_strm_copy("bit_num_strm_copy");
+        hls_db_gqe_part_scan_zone_skip(table.data(), col_id_strm, col_strms, e_strm, bit_num_strm, bit_num_strm_copy);
+        bit_num_strm.read();
+        bit_num_strm_copy.read();
+
+        // the unskipped scan with the rows of skipped blocks taken out
+        int nerr = 0;
+        int n = 0;
+        int r = 0;
+        while (!e_strm.read()) {
+            while (r < TestNumber && skipped[r]) r++;
+            int32_t golden[COL_NM] = {r ^ 0x5a5a, r, r * 3 + 7};
+            for (int k = 0; k < COL_NM; k++) {
+                int32_t v = col_strms[k].read();
+                nerr += v != golden[k];
+            }
+            n++;
+            r++;
+        }
+        int expected = 0;
+        for (int i = 0; i < TestNumber; i++) expected += !skipped[i];
+        nerr += n != expected;
+        std::cout << c.name << ": " << n << " rows, expected " << expected << ", " << nerr << " errors" << std::endl;
+        nerror += nerr != 0;
+    }
+
+    if (nerror) {
+        std::cout << "\nFAIL: " << nerror << " cases failed.\n";
+    } else {
+        std::cout << "\nPASS: no error found.\n";
+    }
+    return nerror;
+}
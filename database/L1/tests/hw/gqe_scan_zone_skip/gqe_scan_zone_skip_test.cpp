@@ -0,0 +1,126 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+#include "gqe_blocks/gqe_types.hpp"
+#include "gqe_blocks/scan_to_channel.hpp"
+#include "gqe_blocks/write_out.hpp"
+
+using namespace xf::database::gqe;
+
+#define COL_NM 3
+#define TestNumber 1000
+// words of one input column, and of the whole input and output tables with their header
+#define COL_DEPTH ((TestNumber + VEC_LEN - 1) / VEC_LEN)
+#define TABLE_DEPTH (1 + 2 * COL_DEPTH)
+#define OUT_DEPTH (1 + COL_NM * COL_DEPTH)
+
+// scan of gqeJoin and gqeAggr, its rows written out as a result table
+void hls_db_gqe_scan_zone_skip(ap_uint<512>* buf_in,
+                               hls::stream<int8_t>& col_id_strm,
+                               hls::stream<ap_uint<32> >& write_out_cfg_strm,
+                               ap_uint<512>* buf_out) {
+#pragma HLS INTERFACE m_axi port = buf_in bundle = gmem0_0 depth = TABLE_DEPTH
+#pragma HLS INTERFACE m_axi port = buf_out bundle = gmem0_1 depth = OUT_DEPTH
+#pragma HLS dataflow
+    hls::stream<ap_uint<32> > col_strms[1][COL_NM];
+#pragma HLS stream variable = col_strms depth = 32
+    hls::stream<bool> e_strms[1];
+#pragma HLS stream variable = e_strms depth = 32
+    scan_to_channel<COL_NM, 1>(buf_in, col_id_strm, col_strms, e_strms);
+    writeTable<BURST_LEN, 32, VEC_LEN, COL_NM>(col_strms[0], e_strms[0], buf_out, write_out_cfg_strm);
+}
+
+struct SkipCase {
+    const char* name;
+    int zone_naxi;
+    std::vector<int> skip;
+};
+
+int main() {
+    int nerror = 0;
+
+    // two columns, scanned as col 1, row id and col 0
+    std::vector<ap_uint<512> > table(TABLE_DEPTH, 0);
+    for (int r = 0; r < TestNumber; r++) {
+        table[1 + r / VEC_LEN](32 * (r % VEC_LEN) + 31, 32 * (r % VEC_LEN)) = r * 3 + 7;
+        table[1 + COL_DEPTH + r / VEC_LEN](32 * (r % VEC_LEN) + 31, 32 * (r % VEC_LEN)) = r ^ 0x5a5a;
+    }
+    const int8_t col_id[COL_NM] = {1, -2, 0};
+
+    // 5 words of 16 rows make 13 blocks, the last one partial; 40 words are longer than a burst
+    SkipCase cases[] = {{"full scan", 0, {}},
+                        {"no block skipped", 5, {}},
+                        {"first, middle and last blocks skipped", 5, {0, 3, 4, 12}},
+                        {"all blocks skipped", 5, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}},
+                        {"first long block skipped", 40, {0}},
+                        {"last long block skipped", 40, {1}}};
+    for (size_t t = 0; t < sizeof(cases) / sizeof(cases[0]); t++) {
+        const SkipCase& c = cases[t];
+        ap_uint<512> hdr = 0;
+        hdr(31, 0) = TestNumber;
+        hdr(63, 32) = COL_DEPTH;
+        hdr(127, 96) = c.zone_naxi;
+        std::vector<bool> skipped(TestNumber, false);
+        for (size_t k = 0; k < c.skip.size(); k++) {
+            hdr[128 + c.skip[k]] = 1;
+            for (int r = c.skip[k] * c.zone_naxi * VEC_LEN; r < (c.skip[k] + 1) * c.zone_naxi * VEC_LEN; r++) {
+                if (r < TestNumber) skipped[r] = true;
+            }
+        }
+        table[0] = hdr;
+
+        // the output header keeps a stale zone map, the kernel must clear its block size so that the skip bits are
+        // ignored when the result is scanned again
+        std::vector<ap_uint<512> > out(OUT_DEPTH, 0);
+        out[0](63, 32) = COL_DEPTH;
+        out[0](127, 96) = 5;
+        out[0](511, 128) = ~ap_uint<384>(0);
+
+        hls::stream<int8_t> col_id_strm("col_id_strm");
+        for (int i = 0; i < COL_NM; i++) col_id_strm.write(col_id[i]);
+        hls::stream<ap_uint<32> > write_out_cfg_strm("write_out_cfg_strm");
+        write_out_cfg_strm.write((1 << COL_NM) - 1);
+        hls_db_gqe_scan_zone_skip(table.data(), col_id_strm, write_out_cfg_strm, out.data());
+
+        // the unskipped scan with the rows of skipped blocks taken out
+        int nerr = 0;
+        int n = 0;
+        for (int r = 0; r < TestNumber; r++) {
+            if (skipped[r]) continue;
+            int32_t golden[COL_NM] = {r ^ 0x5a5a, r, r * 3 + 7};
+            for (int k = 0; k < COL_NM; k++) {
+                int32_t v = out[1 + k * COL_DEPTH + n / VEC_LEN](32 * (n % VEC_LEN) + 31, 32 * (n % VEC_LEN)).to_int();
+                nerr += v != golden[k];
+            }
+            n++;
+        }
+        int nrow = out[0](31, 0).to_int();
+        nerr += nrow != n;
+        nerr += out[0](127, 96) != 0;
+        std::cout << c.name << ": " << nrow << " rows, expected " << n << ", " << nerr << " errors" << std::endl;
+        nerror += nerr != 0;
+    }
+
+    if (nerror) {
+        std::cout << "\nFAIL: " << nerror << " cases failed.\n";
+    } else {
+        std::cout << "\nPASS: no error found.\n";
+    }
+    return nerror;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "xf_database/scan_compressed_col.hpp"
+#include "xf_database/col_compress.hpp"
+
+using namespace xf::database;
+
+#define BURST_LEN 32
+#define TestNumber 5000
+// header word plus raw payload of TestNumber rows
+#define PAGE_DEPTH (1 + (TestNumber + 15) / 16)
+
+void hls_db_scan_compressed_col(ap_uint<512>* buf0,
+                                ap_uint<512>* buf1,
+                                hls::stream<ap_uint<32> >& c0_strm,
+                                hls::stream<ap_uint<32> >& c1_strm,
+                                hls::stream<bool>& e_strm) {
+#pragma HLS INTERFACE m_axi port = buf0 bundle = gmem0_0 depth = PAGE_DEPTH
+#pragma HLS INTERFACE m_axi port = buf1 bundle = gmem0_1 depth = PAGE_DEPTH
+    xf::database::scanCompressedCol<BURST_LEN>(buf0, buf1, c0_strm, c1_strm, e_strm);
+}
+
+int main() {
+    int nerror = 0;
+    const int ncase = 6;
+    const char* name[ncase] = {"3-bit flags", "sorted dates", "long runs", "random", "negative", "forced rle"};
+    const int golden[ncase] = {CENC_BITPACK, CENC_DELTA, CENC_RLE, CENC_RAW, CENC_BITPACK, CENC_RLE};
+
+    std::vector<int32_t> cols[ncase];
+    srand(1);
+    int32_t date = 19920101;
+    for (int i = 0; i < TestNumber; i++) {
+        cols[0].push_back(rand() % 7);
+        date += rand() % 3;
+        cols[1].push_back(date);
+        cols[2].push_back(i / 700 * 13);
+        cols[3].push_back((rand() << 16) ^ rand());
+        cols[4].push_back(-1000 - rand() % 200);
+        cols[5].push_back(rand() % 2);
+    }
+
+    // the pairs of columns scanned together
+    for (int t = 0; t < ncase; t += 2) {
+        std::vector<ap_uint<512> > page[2];
+        for (int k = 0; k < 2; k++) {
+            int c = t + k;
+            ColEncoding e = compressColumn(cols[c].data(), TestNumber, page[k], c == 5 ? CENC_RLE : -1);
+            std::cout << name[c] << ": encoding " << e << ", width " << page[k][0](15, 8).to_int() << ", "
+                      << page[k].size() << " words" << std::endl;
+            if (e != golden[c]) {
+                std::cout << name[c] << ": expected encoding " << golden[c] << std::endl;
+                nerror++;
+            }
+            page[k].resize(PAGE_DEPTH);
+        }
+
+        hls::stream<ap_uint<32> > c0_strm("c0_strm");
+        hls::stream<ap_uint<32> > c1_strm("c1_strm");
+        hls::stream<bool> e_strm("e_strm");
+        hls_db_scan_compressed_col(page[0].data(), page[1].data(), c0_strm, c1_strm, e_strm);
+
+        int nmiss = 0;
+        for (int i = 0; i < TestNumber; i++) {
+            if (e_strm.read()) {
+                std::cout << "the output flag is incorrect at row " << i << std::endl;
+                nerror++;
+                break;
+            }
+            int32_t v0 = (uint32_t)c0_strm.read();
+            int32_t v1 = (uint32_t)c1_strm.read();
+            nmiss += v0 != cols[t][i];
+            nmiss += v1 != cols[t + 1][i];
+        }
+        if (!e_strm.read()) {
+            std::cout << "the last output flag is incorrect" << std::endl;
+            nerror++;
+        }
+        if (nmiss) std::cout << name[t] << ", " << name[t + 1] << ": " << nmiss << " rows decoded wrong" << std::endl;
+        nerror += nmiss;
+    }
+
+    if (nerror) {
+        std::cout << "\nFAIL: nerror= " << nerror << " errors found.\n";
+    } else {
+        std::cout << "\nPASS: no error found.\n";
+    }
+    return nerror;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector> // std::vector
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+
+#include "xf_database/top_k.hpp"
+
+typedef int32_t KEY_TYPE;
+typedef uint32_t DATA_TYPE;
+
+#define MaxTopK 128
+#define ChannelNumber 4
+#define TestNumber 10000
+#define Limit 100
+// 1: smallest first 0: largest first
+#define OP 0
+
+struct row_t {
+    KEY_TYPE key;
+    DATA_TYPE data;
+    int ch;
+};
+
+// rows of equal key come out in channel order, then in input order
+bool row_before(const row_t& a, const row_t& b) {
+    if (a.key != b.key) return OP ? a.key < b.key : a.key > b.key;
+    if (a.ch != b.ch) return a.ch < b.ch;
+    return a.data < b.data;
+}
+
+void hls_db_top_k(hls::stream<DATA_TYPE> din_strm[ChannelNumber],
+                  hls::stream<KEY_TYPE> kin_strm[ChannelNumber],
+                  hls::stream<bool> strm_in_end[ChannelNumber],
+                  hls::stream<DATA_TYPE>& dout_strm,
+                  hls::stream<KEY_TYPE>& kout_strm,
+                  hls::stream<bool>& strm_out_end,
+                  ap_uint<32> limit,
+                  bool order) {
+    xf::database::topK<KEY_TYPE, DATA_TYPE, MaxTopK, ChannelNumber>(din_strm, kin_strm, strm_in_end, dout_strm,
+                                                                      kout_strm, strm_out_end, limit, order);
+}
+
+int main() {
+    hls::stream<DATA_TYPE> din_strm[ChannelNumber];
+    hls::stream<KEY_TYPE> kin_strm[ChannelNumber];
+    hls::stream<bool> din_strm_end[ChannelNumber];
+    hls::stream<DATA_TYPE> dout_strm("dout_strm");
+    hls::stream<KEY_TYPE> kout_strm("kout_strm");
+    hls::stream<bool> dout_strm_end("dout_strm_end");
+
+    int nerror = 0;
+
+    // generate test data, the small key range gives plenty of ties
+    std::vector<row_t> rows;
+    srand(1);
+    for (int i = 0; i < TestNumber; i++) {
+        row_t r;
+        r.key = rand() % 2000 - 1000;
+        r.data = i;
+        r.ch = rand() % ChannelNumber;
+        rows.push_back(r);
+        kin_strm[r.ch].write(r.key);
+        din_strm[r.ch].write(r.data);
+        din_strm_end[r.ch].write(false);
+    }
+    for (int c = 0; c < ChannelNumber; c++) {
+        din_strm_end[c].write(true);
+    }
+    std::cout << " random test data generated! " << std::endl;
+
+    // call top_k function
+    hls_db_top_k(din_strm, kin_strm, din_strm_end, dout_strm, kout_strm, dout_strm_end, Limit, OP);
+
+    // run reference sort
+    std::stable_sort(rows.begin(), rows.end(), row_before);
+
+    //===== check if the output flag e_out_strm is correct or not =====
+    for (int i = 0; i < Limit; i++) {
+        bool e = dout_strm_end.read();
+        if (e) {
+            std::cout << "\nthe output flag is incorrect" << std::endl;
+            nerror++;
+            break;
+        }
+        KEY_TYPE key = kout_strm.read();
+        DATA_TYPE data = dout_strm.read();
+        if (key != rows[i].key || data != rows[i].data) {
+            nerror++;
+            std::cout << "Index=" << i << ' ' << "key=" << key << ' ' << "reference key=" << rows[i].key << ' '
+                      << "data=" << data << ' ' << "reference data=" << rows[i].data << std::endl;
+        }
+    }
+    // read out the last flag that e should =1
+    bool e = dout_strm_end.read();
+    if (!e) {
+        std::cout << "\nthe last output flag is incorrect" << std::endl;
+        nerror++;
+    }
+
+    // print result
+    if (nerror) {
+        std::cout << "\nFAIL: nerror= " << nerror << " errors found.\n";
+    } else {
+        std::cout << "\nPASS: no error found.\n";
+    }
+    return nerror;
+}
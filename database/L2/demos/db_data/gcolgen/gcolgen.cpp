@@ -0,0 +1,180 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tpch_read_2.hpp"
+#include "utils.hpp"
+#include "gqe_table_file.hpp"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <thread>
+
+// Converts the .dat columns written by columngen into mmapable .gcol files.
+
+struct col_t {
+    const char* name;
+    size_t width;
+};
+
+// every column written by columngen, width in bytes per row
+static const col_t cols[] = {
+    {"r_regionkey", TPCH_INT_SZ},
+    {"r_name", TPCH_READ_REGION_LEN + 1},
+    {"r_comment", TPCH_READ_N_CMNT_MAX + 1},
+
+    {"n_nationkey", TPCH_INT_SZ},
+    {"n_regionkey", TPCH_INT_SZ},
+    {"n_name", TPCH_READ_NATION_LEN + 1},
+    {"n_comment", TPCH_READ_N_CMNT_MAX + 1},
+
+    {"c_custkey", TPCH_INT_SZ},
+    {"c_name", TPCH_READ_C_NAME_LEN + 1},
+    {"c_address", TPCH_READ_S_ADDR_MAX + 1},
+    {"c_nationkey", TPCH_INT_SZ},
+    {"c_phone", TPCH_READ_PHONE_LEN + 1},
+    {"c_acctbal", TPCH_INT_SZ},
+    {"c_mktsegment", TPCH_READ_MAXAGG_LEN + 1},
+    {"c_commet", TPCH_READ_S_CMNT_MAX + 1},
+
+    {"o_orderkey", TPCH_INT_SZ},
+    {"o_custkey", TPCH_INT_SZ},
+    {"o_orderstatus", TPCH_INT_SZ},
+    {"o_totalprice", TPCH_INT_SZ},
+    {"o_orderdate", TPCH_INT_SZ},
+    {"o_orderpriority", TPCH_READ_MAXAGG_LEN + 1},
+    {"o_clerk", TPCH_READ_O_CLRK_LEN + 1},
+    {"o_shippriority", TPCH_INT_SZ},
+    {"o_comment", TPCH_READ_O_CMNT_MAX + 1},
+
+    {"l_orderkey", TPCH_INT_SZ},
+    {"l_partkey", TPCH_INT_SZ},
+    {"l_suppkey", TPCH_INT_SZ},
+    {"l_linenumber", TPCH_INT_SZ},
+    {"l_quantity", TPCH_INT_SZ},
+    {"l_extendedprice", TPCH_INT_SZ},
+    {"l_discount", TPCH_INT_SZ},
+    {"l_tax", TPCH_INT_SZ},
+    {"l_returnflag", TPCH_INT_SZ},
+    {"l_linestatus", TPCH_INT_SZ},
+    {"l_shipdate", TPCH_INT_SZ},
+    {"l_commitdate", TPCH_INT_SZ},
+    {"l_receiptdate", TPCH_INT_SZ},
+    {"l_shipinstruct", TPCH_READ_MAXAGG_LEN + 1},
+    {"l_shipmode", TPCH_READ_MAXAGG_LEN + 1},
+    {"l_comment", TPCH_READ_L_CMNT_MAX + 1},
+
+    {"s_suppkey", TPCH_INT_SZ},
+    {"s_name", TPCH_READ_S_NAME_LEN + 1},
+    {"s_address", TPCH_READ_S_ADDR_MAX + 1},
+    {"s_nationkey", TPCH_INT_SZ},
+    {"s_phone", TPCH_READ_PHONE_LEN + 1},
+    {"s_acctbal", TPCH_INT_SZ},
+    {"s_comment", TPCH_READ_S_CMNT_MAX + 1},
+
+    {"p_partkey", TPCH_INT_SZ},
+    {"p_name", TPCH_READ_P_NAME_LEN + 1},
+    {"p_mfgr", TPCH_READ_P_MFG_LEN + 1},
+    {"p_brand", TPCH_READ_P_BRND_LEN + 1},
+    {"p_type", TPCH_READ_P_TYPE_LEN + 1},
+    {"p_size", TPCH_INT_SZ},
+    {"p_container", TPCH_READ_P_CNTR_LEN + 1},
+    {"p_retailprice", TPCH_INT_SZ},
+    {"p_comment", TPCH_READ_P_CMNT_MAX + 1},
+
+    {"ps_partkey", TPCH_INT_SZ},
+    {"ps_suppkey", TPCH_INT_SZ},
+    {"ps_availqty", TPCH_INT_SZ},
+    {"ps_supplycost", TPCH_INT_SZ},
+    {"ps_comment", TPCH_READ_PS_CMNT_MAX + 1},
+};
+
+static const int ncols = sizeof(cols) / sizeof(cols[0]);
+
+int convert(const std::string& in_dir, const std::string& out_dir, const col_t& c) {
+    std::string fn = in_dir + "/" + c.name + ".dat";
+    int fd = open(fn.c_str(), O_RDONLY);
+    if (fd < 0) {
+        printf("WARNING: %s cannot be opened, skipped.\n", fn.c_str());
+        return 0;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = st.st_size;
+    if (size % c.width) {
+        printf("ERROR: %s size %zu is not a multiple of %zu.\n", fn.c_str(), size, c.width);
+        close(fd);
+        return 1;
+    }
+
+    // written straight from the page cache
+    void* data = NULL;
+    if (size) {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            printf("ERROR: %s cannot be mapped.\n", fn.c_str());
+            close(fd);
+            return 1;
+        }
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+    int err = write_gcol(out_dir, c.name, data, size / c.width, c.width);
+    if (size) munmap(data, size);
+    close(fd);
+    return err ? 1 : 0;
+}
+
+int main(int argc, const char* argv[]) {
+    // cmd arg parser.
+    ArgParser parser(argc, argv);
+
+    int err = 0;
+
+    std::string in_dir = ".";
+    parser.getCmdOption("-in", in_dir);
+    if (!is_dir(in_dir)) {
+        printf("ERROR: \"%s\" is not a directory!\n", in_dir.c_str());
+        ++err;
+    }
+
+    std::string out_dir = in_dir;
+    parser.getCmdOption("-out", out_dir);
+    if (!is_dir(out_dir)) {
+        printf("ERROR: \"%s\" is not a directory!\n", out_dir.c_str());
+        ++err;
+    }
+
+    if (err) return err;
+
+    struct timeval tv0, tv1;
+    gettimeofday(&tv0, 0);
+
+    // columns are independent, convert them on all cores
+    unsigned nthread = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    std::vector<int> errs(nthread, 0);
+    for (unsigned t = 0; t < nthread; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            for (int i = t; i < ncols; i += nthread) errs[t] += convert(in_dir, out_dir, cols[i]);
+        }));
+    }
+    for (auto& t : threads) t.join();
+    for (unsigned t = 0; t < nthread; ++t) err += errs[t];
+
+    gettimeofday(&tv1, 0);
+    printf("Time to convert columns: %d usec.\n", tvdiff(&tv0, &tv1));
+
+    return err;
+}
@@ -0,0 +1,477 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CPU_ENGINE_H
+#define CPU_ENGINE_H
+
+// Morsel-parallel columnar operators for the CPU references of the demos.
+//
+// Rows are processed in morsels of MORSEL_ROWS, handed out to a pool of
+// workers through one atomic counter, so skewed morsels do not stall the
+// others. Columns are read in place from the Table buffers:
+//
+//   filter     predicate over a morsel into a byte mask, then branch free
+//              compaction into a selection vector of row ids.
+//   group by   thread local open addressing tables, split on the top bits of
+//              the hash so that partitions are merged in parallel.
+//   join       build rows radix partitioned on the top bits of the hash, one
+//              cache sized open addressing table per partition, probed in
+//              parallel per morsel.
+//
+// Results keep the order of the input rows. The number of workers defaults
+// to the number of cores and can be set with GQE_CPU_THREADS.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace cpu {
+
+const size_t MORSEL_ROWS = 16384;
+
+inline int threadNum() {
+    static int n = [] {
+        const char* e = getenv("GQE_CPU_THREADS");
+        int t = e ? atoi(e) : (int)std::thread::hardware_concurrency();
+        return t > 0 ? t : 1;
+    }();
+    return n;
+}
+
+inline size_t morselNum(size_t n, size_t rows = MORSEL_ROWS) {
+    return (n + rows - 1) / rows;
+}
+
+//! Call f(tid, m, begin, end) for every morsel m of [0, n), tid < threadNum()
+template <class F>
+void parallelMorsels(size_t n, F f, size_t rows = MORSEL_ROWS) {
+    size_t nm = morselNum(n, rows);
+    int nt = (int)std::min<size_t>(threadNum(), nm);
+    std::atomic<size_t> next(0);
+    auto work = [&](int tid) {
+        for (size_t m = next++; m < nm; m = next++) f(tid, m, m * rows, std::min(n, (m + 1) * rows));
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < nt; t++) pool.emplace_back(work, t);
+    work(0);
+    for (auto& t : pool) t.join();
+}
+
+//! Call f(i) for every i in [0, n)
+template <class F>
+void parallelFor(size_t n, F f) {
+    parallelMorsels(n, [&](int, size_t, size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) f(i);
+    });
+}
+
+//! Typed view of column c, same layout as Table::getInt32 / getInt64
+template <class T, class TB>
+T* col(TB& t, int c) {
+    return (T*)(t.data + t.size512[c] + 1);
+}
+
+//! Fixed width string of row r in column c, as read by Table::getcharN<char, N>
+template <int N, class TB>
+const char* str(TB& t, int c, size_t r) {
+    return (const char*)(t.data + t.size512[c] + 1) + r * N;
+}
+
+//! Concatenate per morsel results in morsel order
+template <class T>
+std::vector<T> concat(std::vector<std::vector<T> >& parts) {
+    std::vector<size_t> off(parts.size() + 1, 0);
+    for (size_t m = 0; m < parts.size(); m++) off[m + 1] = off[m] + parts[m].size();
+    std::vector<T> out(off.back());
+    parallelMorsels(parts.size(),
+                    [&](int, size_t m, size_t, size_t) {
+                        std::copy(parts[m].begin(), parts[m].end(), out.begin() + off[m]);
+                        std::vector<T>().swap(parts[m]);
+                    },
+                    1);
+    return out;
+}
+
+// ------------------------------------------------------------
+// filter
+
+typedef std::vector<uint32_t> SelVec;
+
+//! Rows of [begin, end) for which pred(row) holds, written to sel. The mask
+//! loop has no branch and vectorizes for plain column compares.
+template <class R, class P>
+size_t selectMorsel(size_t begin, size_t end, R rowOf, P pred, uint32_t* sel) {
+    uint8_t mask[MORSEL_ROWS];
+    size_t n = end - begin;
+    for (size_t i = 0; i < n; i++) mask[i] = pred(rowOf(begin + i)) ? 1 : 0;
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        sel[k] = rowOf(begin + i);
+        k += mask[i];
+    }
+    return k;
+}
+
+template <class R, class P>
+SelVec selectRows(size_t n, R rowOf, P pred) {
+    std::vector<SelVec> parts(morselNum(n));
+    parallelMorsels(n, [&](int, size_t m, size_t b, size_t e) {
+        parts[m].resize(e - b);
+        parts[m].resize(selectMorsel(b, e, rowOf, pred, parts[m].data()));
+    });
+    return concat(parts);
+}
+
+//! Rows of [0, n) for which pred(row) holds, in row order
+template <class P>
+SelVec select(size_t n, P pred) {
+    return selectRows(n, [](size_t i) { return (uint32_t)i; }, pred);
+}
+
+//! Rows of sel for which pred(row) holds, in the order of sel
+template <class P>
+SelVec select(const SelVec& sel, P pred) {
+    return selectRows(sel.size(), [&](size_t i) { return sel[i]; }, pred);
+}
+
+//! dst[i] = src[sel[i]]
+template <class T>
+void gather(const T* src, const SelVec& sel, T* dst) {
+    parallelFor(sel.size(), [&](size_t i) { dst[i] = src[sel[i]]; });
+}
+
+// ------------------------------------------------------------
+// hashing
+
+inline uint64_t hash64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+//! FNV-1a over a NUL terminated string of at most n bytes
+inline uint64_t hashStr(const char* p, size_t n) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n && p[i]; i++) h = (h ^ (uint8_t)p[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+//! Fixed width string group key, zero padded after the first NUL
+template <int N>
+struct StrKey {
+    char s[N];
+
+    StrKey() { memset(s, 0, N); }
+    explicit StrKey(const char* p) { strncpy(s, p, N); }
+    bool operator==(const StrKey& o) const { return !memcmp(s, o.s, N); }
+};
+
+struct StrKeyHash {
+    template <int N>
+    size_t operator()(const StrKey<N>& k) const {
+        return hashStr(k.s, N);
+    }
+};
+
+//! Two 32-bit keys as one join key
+inline uint64_t key2(int32_t a, int32_t b) {
+    return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+}
+
+// ------------------------------------------------------------
+// group by
+
+//! Open addressing table with linear probing, grows at half load
+template <class K, class V>
+class AggTable {
+   public:
+    struct Slot {
+        K key;
+        V val;
+        uint64_t hash;
+        bool used;
+    };
+
+    AggTable() : cnt(0), mask(15), slots(16) {}
+
+    size_t size() const { return cnt; }
+
+    //! Value of k, set to init when k is new
+    V& find(const K& k, uint64_t h, const V& init) {
+        size_t s = h & mask;
+        while (slots[s].used) {
+            if (slots[s].hash == h && slots[s].key == k) return slots[s].val;
+            s = (s + 1) & mask;
+        }
+        if (2 * (cnt + 1) > slots.size()) {
+            grow();
+            return find(k, h, init);
+        }
+        slots[s].key = k;
+        slots[s].val = init;
+        slots[s].hash = h;
+        slots[s].used = true;
+        cnt++;
+        return slots[s].val;
+    }
+
+    template <class F>
+    void forEach(F f) {
+        for (auto& s : slots)
+            if (s.used) f(s.key, s.val);
+    }
+
+    //! Fold o into this table, m(into, from) combines the values of a key
+    template <class M>
+    void merge(AggTable& o, M m) {
+        for (auto& s : o.slots) {
+            if (!s.used) continue;
+            size_t c = cnt;
+            V& v = find(s.key, s.hash, s.val);
+            if (c == cnt) m(v, s.val);
+        }
+    }
+
+   private:
+    void grow() {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        mask = slots.size() - 1;
+        for (auto& o : old) {
+            if (!o.used) continue;
+            size_t s = o.hash & mask;
+            while (slots[s].used) s = (s + 1) & mask;
+            slots[s] = o;
+        }
+    }
+
+    size_t cnt;
+    size_t mask;
+    std::vector<Slot> slots;
+};
+
+//! Aggregation table split into 2^HASH_AGG_BITS partitions on the top bits
+//! of the hash, the slot within a partition is taken from the low bits.
+const int HASH_AGG_BITS = 6;
+
+template <class K, class V, class H = std::hash<K> >
+class HashAgg {
+   public:
+    HashAgg() : part(1 << HASH_AGG_BITS) {}
+
+    //! Value of k, value initialized when k is new
+    V& operator[](const K& k) { return emplace(k, V()); }
+
+    //! Value of k, set to init when k is new
+    V& emplace(const K& k, const V& init) {
+        uint64_t h = hash64(H()(k));
+        return part[h >> (64 - HASH_AGG_BITS)].find(k, h, init);
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for (auto& p : part) n += p.size();
+        return n;
+    }
+
+    template <class F>
+    void forEach(F f) {
+        for (auto& p : part) p.forEach(f);
+    }
+
+    std::vector<AggTable<K, V> > part;
+};
+
+//! Group rows of [0, n): upd(agg, i) folds row i into a thread local table,
+//! mrg(into, from) combines two partial values of a group.
+template <class K, class V, class H = std::hash<K>, class U, class M>
+HashAgg<K, V, H> groupBy(size_t n, U upd, M mrg) {
+    std::vector<HashAgg<K, V, H> > local(std::max<size_t>(1, std::min<size_t>(threadNum(), morselNum(n))));
+    parallelMorsels(n, [&](int tid, size_t, size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) upd(local[tid], i);
+    });
+    parallelMorsels(1 << HASH_AGG_BITS,
+                    [&](int, size_t p, size_t, size_t) {
+                        for (size_t t = 1; t < local.size(); t++) local[0].part[p].merge(local[t].part[p], mrg);
+                    },
+                    1);
+    return std::move(local[0]);
+}
+
+// ------------------------------------------------------------
+// join
+
+struct Match {
+    uint32_t probe;
+    uint32_t build;
+};
+
+//! Radix partitioned hash table on 64-bit keys, duplicate keys are kept.
+class HashJoin {
+   public:
+    //! rows per partition the build aims at, about 128KB of entries
+    static const size_t PART_ROWS = 8192;
+    static const int MAX_BITS = 12;
+    static const uint32_t EMPTY = 0xffffffff;
+
+    struct Entry {
+        uint64_t key;
+        uint32_t row;
+    };
+
+    HashJoin() : bits(0), nrow(0) {}
+
+    size_t size() const { return nrow; }
+
+    //! Build on rows [0, n), key(row) gives the join key
+    template <class KF>
+    void build(size_t n, KF key) {
+        buildRows(n, [](size_t i) { return (uint32_t)i; }, key);
+    }
+
+    //! Build on the rows of sel
+    template <class KF>
+    void build(const SelVec& sel, KF key) {
+        buildRows(sel.size(), [&](size_t i) { return sel[i]; }, key);
+    }
+
+    //! Call f(row) for every build row holding k
+    template <class F>
+    void probe(uint64_t k, F f) const {
+        uint64_t h = hash64(k);
+        size_t p = partOf(h);
+        const Entry* t = slots.data() + base[p];
+        size_t mask = base[p + 1] - base[p] - 1;
+        for (size_t s = h & mask; t[s].row != EMPTY; s = (s + 1) & mask)
+            if (t[s].key == k) f(t[s].row);
+    }
+
+    //! True when some build row holding k satisfies pred(row)
+    template <class P>
+    bool any(uint64_t k, P pred) const {
+        uint64_t h = hash64(k);
+        size_t p = partOf(h);
+        const Entry* t = slots.data() + base[p];
+        size_t mask = base[p + 1] - base[p] - 1;
+        for (size_t s = h & mask; t[s].row != EMPTY; s = (s + 1) & mask)
+            if (t[s].key == k && pred(t[s].row)) return true;
+        return false;
+    }
+
+    bool contains(uint64_t k) const {
+        return any(k, [](uint32_t) { return true; });
+    }
+
+    //! Matches of probe rows [0, n) in probe order
+    template <class KF>
+    std::vector<Match> join(size_t n, KF key) const {
+        return joinRows(n, [](size_t i) { return (uint32_t)i; }, key);
+    }
+
+    //! Matches of the probe rows of sel in the order of sel
+    template <class KF>
+    std::vector<Match> join(const SelVec& sel, KF key) const {
+        return joinRows(sel.size(), [&](size_t i) { return sel[i]; }, key);
+    }
+
+   private:
+    size_t partOf(uint64_t h) const { return bits ? (size_t)(h >> (64 - bits)) : 0; }
+
+    template <class R, class KF>
+    std::vector<Match> joinRows(size_t n, R rowOf, KF key) const {
+        std::vector<std::vector<Match> > parts(morselNum(n));
+        parallelMorsels(n, [&](int, size_t m, size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) {
+                uint32_t r = rowOf(i);
+                probe(key(r), [&](uint32_t br) { parts[m].push_back(Match{r, br}); });
+            }
+        });
+        return concat(parts);
+    }
+
+    template <class R, class KF>
+    void buildRows(size_t n, R rowOf, KF key) {
+        nrow = n;
+        bits = 0;
+        while (bits < MAX_BITS && (n >> bits) > PART_ROWS) bits++;
+        size_t np = (size_t)1 << bits;
+        size_t nm = morselNum(n);
+
+        // histogram of partitions per morsel
+        std::vector<size_t> hist(nm * np, 0);
+        parallelMorsels(n, [&](int, size_t m, size_t b, size_t e) {
+            size_t* h = &hist[m * np];
+            for (size_t i = b; i < e; i++) h[partOf(hash64(key(rowOf(i))))]++;
+        });
+        // scatter offsets, partition major so every partition is contiguous
+        std::vector<size_t> start(np + 1, 0);
+        size_t s = 0;
+        for (size_t p = 0; p < np; p++) {
+            start[p] = s;
+            for (size_t m = 0; m < nm; m++) {
+                size_t c = hist[m * np + p];
+                hist[m * np + p] = s;
+                s += c;
+            }
+        }
+        start[np] = s;
+        std::vector<Entry> tmp(n);
+        parallelMorsels(n, [&](int, size_t m, size_t b, size_t e) {
+            size_t* o = &hist[m * np];
+            for (size_t i = b; i < e; i++) {
+                uint32_t r = rowOf(i);
+                uint64_t k = key(r);
+                tmp[o[partOf(hash64(k))]++] = Entry{k, r};
+            }
+        });
+
+        // one table of at least twice the partition size per partition
+        base.assign(np + 1, 0);
+        for (size_t p = 0; p < np; p++) {
+            size_t cap = 2;
+            while (cap < 2 * (start[p + 1] - start[p])) cap <<= 1;
+            base[p + 1] = base[p] + cap;
+        }
+        slots.assign(base[np], Entry{0, EMPTY});
+        parallelMorsels(np,
+                        [&](int, size_t p, size_t, size_t) {
+                            Entry* t = slots.data() + base[p];
+                            size_t mask = base[p + 1] - base[p] - 1;
+                            for (size_t i = start[p]; i < start[p + 1]; i++) {
+                                size_t s = hash64(tmp[i].key) & mask;
+                                while (t[s].row != EMPTY) s = (s + 1) & mask;
+                                t[s] = tmp[i];
+                            }
+                        },
+                        1);
+    }
+
+    int bits;
+    size_t nrow;
+    std::vector<size_t> base;
+    std::vector<Entry> slots;
+};
+
+} // namespace cpu
+
+#endif // CPU_ENGINE_H
@@ -24,9 +24,14 @@
 #ifndef _GQE_API_
 #define _GQE_API_
 
+#include "xf_database/zone_map.hpp"
 #include <CL/cl_ext_xilinx.h>
 #include <xcl2.hpp>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "gqe_table_file.hpp"
+
 #define XCL_BANK(n) (((unsigned int)(n)) | XCL_MEM_TOPOLOGY)
 
 #define XCL_BANK0 XCL_BANK(0)
@@ -46,6 +51,11 @@
 #define XCL_BANK14 XCL_BANK(14)
 #define XCL_BANK15 XCL_BANK(15)
 
+// rows of one zone map block, a multiple of VEC_LEN * BURST_LEN
+#define ZONE_MAP_ROW (1 << 16)
+// blocks the table header can mark skipped
+#define ZONE_MAP_MAX_BLK 384
+
 long getkrltime(cl::Event e1, cl::Event e2) {
     cl_ulong start, end;
     e1.getProfilingInfo(CL_PROFILING_COMMAND_START, &start);
@@ -161,6 +171,15 @@ class Table {
     ap_uint<512>* datak;
     cl::Buffer buffer;
 
+    // bytes mapped by mapHost(), 0 when data is allocated
+    size_t mapsize = 0;
+
+    // min and max of each 4-byte column per block of zonerow rows
+    std::vector<xf::database::ZoneMap> zones;
+    size_t zonerow = 0;
+    // blocks marked skipped in the header by setZoneSkip(), empty for a full scan
+    std::vector<uint8_t> zoneskip;
+
     Table(){};
 
     Table(std::string name_, size_t nrow_, size_t ncol_, std::string dir_) {
@@ -192,6 +211,7 @@ class Table {
 
     //! Load table to CPU memory
     void loadHost() {
+        if (mapsize) return; // columns already in place
         // std::cout<<"load host"<<std::endl;
         for (size_t i = 0; i < ncol; i++) {
             // std::cout<<isrowid[i]<<std::endl;
@@ -208,11 +228,80 @@ class Table {
             }
             memcpy(data + size512[i], &nrow, 4);
         };
+        buildZoneMap();
+    };
+
+    //! Record min and max of each block of the 4-byte columns, for setZoneSkip()
+    void buildZoneMap() {
+        zonerow = ZONE_MAP_ROW;
+        while (nrow > zonerow * ZONE_MAP_MAX_BLK) zonerow *= 2;
+        zones.resize(ncol);
+        for (size_t i = 0; i < ncol; i++) {
+            if (colswidth[i] == 4) zones[i].build((const int32_t*)(data + size512[i] + 1), nrow, zonerow);
+        }
+    };
+
+    //! Mark in the table header the blocks in which no row can pass the filter,
+    //! scan kernels do not read them and transEngine does not transfer them.
+    //! fcol gives the column of this table seen by each of the 4 filter inputs,
+    //! -1 for an input not taken from this table. Returns number of blocks skipped.
+    size_t setZoneSkip(const uint32_t fcfg[45], const int fcol[4]) {
+        clearZoneSkip();
+        // kernel buffer is a compacted copy when some columns stay on host
+        for (size_t i = 0; i < ncol; i++) {
+            if (iskdata[i] == 0) return 0;
+        }
+        // mapped tables are paged in here, not when mapped
+        if (zones.size() != ncol) buildZoneMap();
+        const xf::database::ZoneMap* zm[4];
+        for (int c = 0; c < 4; c++) {
+            bool known = fcol[c] >= 0 && fcol[c] < (int)ncol && zones[fcol[c]].blocks();
+            zm[c] = known ? &zones[fcol[c]] : nullptr;
+        }
+        std::vector<uint8_t> skip;
+        size_t nskip = xf::database::zoneSkipList(fcfg, zm, skip);
+        if (nskip == 0 || skip.size() > ZONE_MAP_MAX_BLK) return 0;
+        data[0].range(127, 96) = zonerow / VEC_LEN;
+        for (size_t b = 0; b < skip.size(); b++) data[0].set_bit(128 + b, skip[b]);
+        zoneskip = skip;
+        return nskip;
+    };
+
+    //! Scan the whole table again
+    void clearZoneSkip() {
+        data[0].range(511, 96) = 0;
+        zoneskip.clear();
+    };
+
+    //! Write the header and the blocks not skipped to the device buffer
+    void writeKeptBlocks(cl::CommandQueue& clq, std::vector<cl::Event>* waitevt, std::vector<cl::Event>& evs) {
+        evs.push_back(cl::Event());
+        clq.enqueueWriteBuffer(buffer, CL_FALSE, 0, 64, data, waitevt, &evs.back());
+        size_t zone512 = zonerow / VEC_LEN;
+        size_t col512 = (nrow + VEC_LEN - 1) / VEC_LEN;
+        for (size_t i = 0; i < ncol; i++) {
+            size_t b = 0;
+            while (b < zoneskip.size()) {
+                if (zoneskip[b]) {
+                    b++;
+                    continue;
+                }
+                // one write for each run of kept blocks
+                size_t e = b;
+                while (e < zoneskip.size() && !zoneskip[e]) e++;
+                size_t w0 = size512[i] + 1 + b * zone512;
+                size_t w1 = size512[i] + 1 + (e * zone512 < col512 ? e * zone512 : col512);
+                evs.push_back(cl::Event());
+                clq.enqueueWriteBuffer(buffer, CL_FALSE, 64 * w0, 64 * (w1 - w0), data + w0, waitevt, &evs.back());
+                b = e;
+            }
+        }
     };
 
     //! CPU memory allocation
     void allocateHost() { // col added manually
         if (mode == 1) {
+            if (mapHost() == 0) return;
             data = aligned_alloc<ap_uint<512> >(size512.back());
             data[0] = get_table_header(size512[1], nrow); // TO CHECK
             for (size_t j = 1; j < ncol; j++) {
@@ -234,6 +323,89 @@ class Table {
         }
     };
 
+    //! Map the gcol files of all columns as one contiguous table, no copy
+    //! is made, pages are read from disk when first touched. Returns non-zero
+    //! when a column has no gcol file, the table is then left unallocated.
+    int mapHost() {
+        if (dir.empty()) return -1;
+        std::vector<int> fds(ncol, -1);
+        std::vector<size_t> col512(ncol);
+        int err = 0;
+        for (size_t i = 0; i < ncol && !err; i++) {
+            if (isrowid[i]) {
+                col512[i] = gcol_n512b(nrow, colswidth[i]);
+                continue;
+            }
+            std::string fn = gcol_path(dir, colsname[i]);
+            if (!is_file(fn)) {
+                err = 1;
+                break;
+            }
+            fds[i] = open(fn.c_str(), O_RDONLY);
+            gcol_header_t hdr;
+            if (fds[i] < 0 || read_gcol_header(fds[i], fn, hdr)) {
+                err = 1;
+            } else if (hdr.width != colswidth[i] || hdr.nrow != nrow) {
+                std::cerr << "ERROR: " << fn << " holds " << hdr.nrow << " rows of " << hdr.width << " bytes, "
+                          << nrow << " rows of " << colswidth[i] << " bytes required." << std::endl;
+                err = 1;
+            }
+            col512[i] = hdr.n512b;
+        }
+
+        // reserve the whole range first so the columns land back to back
+        size_t total = 0;
+        for (size_t i = 0; i < ncol && !err; i++) total += col512[i];
+        char* base = (char*)MAP_FAILED;
+        if (!err && total) {
+            base = (char*)mmap(NULL, total * 64, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        }
+        if (base == (char*)MAP_FAILED) err = 1;
+
+        // private mapping, writes to the table never reach the file
+        size_t off = 0;
+        for (size_t i = 0; i < ncol && !err; i++) {
+            size_t len = col512[i] * 64;
+            int prot = PROT_READ | PROT_WRITE;
+            void* p = isrowid[i] ? mmap(base + off, len, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0)
+                                 : mmap(base + off, len, prot, MAP_PRIVATE | MAP_FIXED, fds[i], GCOL_PAGE);
+            if (p == MAP_FAILED) {
+                std::cerr << "ERROR: cannot map column " << colsname[i] << "." << std::endl;
+                err = 1;
+            }
+            off += len;
+        }
+        for (size_t i = 0; i < ncol; i++) {
+            if (fds[i] >= 0) close(fds[i]);
+        }
+        if (err) {
+            if (base != (char*)MAP_FAILED) munmap(base, total * 64);
+            return -1;
+        }
+
+        data = (ap_uint<512>*)base;
+        mapsize = total * 64;
+        size512.resize(1);
+        for (size_t i = 0; i < ncol; i++) {
+            size512.push_back(size512.back() + col512[i]);
+            if (isrowid[i]) {
+                for (size_t j = 0; j < nrow; j++) setInt32(j, i, j);
+                data[size512[i]] = get_table_header(col512[i], nrow);
+            }
+        }
+        // table header shares the word of the first column header
+        data[0] = get_table_header(size512[1], nrow);
+        std::cout << name << " mapped from " << dir << ", " << mapsize / (1024 * 1024) << " MByte" << std::endl;
+        return 0;
+    };
+
+    //! Release memory of a mapped table
+    void unmapHost() {
+        if (mapsize) munmap(data, mapsize);
+        mapsize = 0;
+        data = nullptr;
+    };
+
     void allocateHost(float f, int p_num) { // col added manually
         if ((f == 0) || (p_num == 0))
             std::cout << "ERROR: p_num (" << p_num << ")should be bigger than 1,"
@@ -509,10 +681,15 @@ void gatherTable_row(Table& tin1, Table& tin2, Table& tout) {
     tout.setNumRow(nrow1 + nrow2);
 }
 
+// bloom filter of gqePart, two vectors of 2^21 bits
+#define BF_BUFF_SZ (1 << 19)
+
 class cfgCmd {
    public:
     ap_uint<512>* cmd;
     cl::Buffer buffer;
+    // written by gqePart on the build table, read by gqePart on the probe table
+    cl::Buffer bf_buffer;
 
     cfgCmd(){};
 
@@ -525,8 +702,14 @@ class cfgCmd {
         cl_mem_ext_ptr_t mext = {XCL_MEM_TOPOLOGY | (unsigned int)(32), cmd, 0};
         buffer = cl::Buffer(context, CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, (size_t)(64 * 9),
                             &mext);
+        cl_mem_ext_ptr_t mext_bf = {XCL_MEM_TOPOLOGY | (unsigned int)(32), nullptr, 0};
+        bf_buffer = cl::Buffer(context, CL_MEM_EXT_PTR_XILINX | CL_MEM_HOST_NO_ACCESS | CL_MEM_READ_WRITE,
+                               (size_t)BF_BUFF_SZ, &mext_bf);
     };
 
+    /// @brief gqePart on the build table makes a bloom filter of join keys, probe rows failing it are dropped
+    void setBloomFilter(bool on) { cmd[0].set_bit(7, on); };
+
     void setup(){}; // TODO
 };
 
@@ -742,6 +925,7 @@ class krnlEngine {
         krnl.setArg(j++, (in1->buffer));
         krnl.setArg(j++, (out->buffer));
         krnl.setArg(j++, (cfgcmd->buffer));
+        krnl.setArg(j++, (cfgcmd->bf_buffer));
     };
 
     void run(int rc, std::vector<cl::Event>* waitevt, cl::Event* outevt) { clq.enqueueTask(krnl, waitevt, outevt); };
@@ -795,6 +979,7 @@ class AggrKrnlEngine {
         krnl.setArg(j++, (in->buffer));
         krnl.setArg(j++, (out->buffer));
         krnl.setArg(j++, (hpcmd->buffer));
+        krnl.setArg(j++, (hpcmd->bf_buffer));
     };
 
     void run(int rc, std::vector<cl::Event>* waitevt, cl::Event* outevt) { clq.enqueueTask(krnl, waitevt, outevt); };
@@ -802,6 +987,8 @@ class AggrKrnlEngine {
 
 class transEngine {
     std::vector<cl::Memory> ib[2];
+    // tables scanned with zone skipping, only their kept blocks go to device
+    std::vector<Table*> zt[2];
     cl::CommandQueue clq;
 
    public:
@@ -810,12 +997,16 @@ class transEngine {
 
     void setq(cl::CommandQueue q) { clq = q; };
     void add(Table* tb) {
-        ib[0].push_back((tb->buffer));
+        if (tb->zoneskip.empty())
+            ib[0].push_back((tb->buffer));
+        else
+            zt[0].push_back(tb);
         // ib[1].push_back((tb->buffer)[1]);
     };
     void clear_add(Table* tb) {
         ib[0].clear();
-        ib[0].push_back((tb->buffer));
+        zt[0].clear();
+        add(tb);
         // ib[1].push_back((tb->buffer)[1]);
     };
     void add(cl::Buffer& buf) {
@@ -830,13 +1021,28 @@ class transEngine {
         ib[0].push_back((tb->buffer));
         // ib[1].push_back((tb->buffer)[1]);
     };
-    void clear() { ib[0].clear(); }
+    void clear() {
+        ib[0].clear();
+        zt[0].clear();
+    }
     void host2dev(int rc, std::vector<cl::Event>* waitevt, cl::Event* outevt) {
-        clq.enqueueMigrateMemObjects(ib[rc], 0, waitevt, outevt);
+        if (zt[rc].empty()) {
+            clq.enqueueMigrateMemObjects(ib[rc], 0, waitevt, outevt);
+            return;
+        }
+        std::vector<cl::Event> evs;
+        if (!ib[rc].empty()) {
+            evs.resize(1);
+            clq.enqueueMigrateMemObjects(ib[rc], 0, waitevt, &evs[0]);
+        }
+        for (size_t i = 0; i < zt[rc].size(); i++) zt[rc][i]->writeKeptBlocks(clq, waitevt, evs);
+        clq.enqueueMarkerWithWaitList(&evs, outevt);
     };
 
     void dev2host(int rc, std::vector<cl::Event>* waitevt, cl::Event* outevt) {
-        clq.enqueueMigrateMemObjects(ib[rc], CL_MIGRATE_MEM_OBJECT_HOST, waitevt, outevt);
+        std::vector<cl::Memory> ob = ib[rc];
+        for (size_t i = 0; i < zt[rc].size(); i++) ob.push_back(zt[rc][i]->buffer);
+        clq.enqueueMigrateMemObjects(ob, CL_MIGRATE_MEM_OBJECT_HOST, waitevt, outevt);
     };
 };
 
@@ -0,0 +1,391 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _GQE_PART_JOIN_
+#define _GQE_PART_JOIN_
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "gqe_api.hpp"
+#include "utils.hpp"
+
+// rows of the input tables sent to one gqePart call, and of the probe side of one gqeJoin call
+#define PJ_CHUNK_ROW (1 << 22)
+// rows of the build side of one gqeJoin call, a quarter of the hash table so that skewed partitions still fit
+#define PJ_JOIN_ROW (HT_BUFF_DEPTH / 4)
+// gqePart writes at most 2^HASHWL partitions
+#define PJ_MAX_PART 256
+// room given to each partition of a chunk over the even share, as in allocateHost(f, p_num)
+#define PJ_PART_RATIO 1.5
+
+/**
+ * @brief Runs a hash join whose tables do not fit on the device.
+ *
+ * The build and probe tables stay in host memory. They are cut into chunks of at most ``PJ_CHUNK_ROW`` rows and each
+ * chunk is hash partitioned by gqePart. The partitions are gathered on host. Then gqeJoin runs once per partition
+ * pair, a probe partition larger than a chunk is joined slice by slice against the same build partition. The number
+ * of partitions is picked from the build rows so that one build partition fits in ``PJ_JOIN_ROW`` rows.
+ *
+ * Keys may repeat on both sides. The build keys of each partition are counted on host, and the result buffers are
+ * sized to the most rows any gqeJoin call can output.
+ *
+ * Both passes keep two sets of device buffers. While one set runs its kernel, the result of the previous step is read
+ * back from the other set and the next step is written to it, so host to device copy, kernel and device to host copy
+ * of neighbouring steps overlap.
+ *
+ * The bloom filter option of the partition config is kept when the build table fits in one chunk, otherwise it is
+ * cleared, as every build chunk would restart the filter. The append option of the join config is always cleared.
+ */
+class partJoinEngine {
+    cl::Context ctx;
+    cl::Program prg;
+    cl::CommandQueue clq;
+    bufferTmp* buftmp;
+
+    size_t chunk_row;
+    size_t join_row;
+
+    // chunk in, partition out, of each side
+    struct partStep {
+        int side;
+        size_t start;
+        size_t nrow;
+    };
+
+    // build partition p against probe rows [start, start + nrow) of partition p
+    struct joinStep {
+        int part;
+        size_t start;
+        size_t nrow;
+    };
+
+    // column i of a part or join output goes to position i, so the highest used position gives the column count
+    static int part_ncol(cfgCmd& cmd, int index) {
+        int n = 0;
+        for (int i = 0; i < 8; i++) {
+            int8_t t = cmd.cmd[0].range(64 * index + 56 + 8 * i + 7, 64 * index + 56 + 8 * i);
+            if (t >= 0) n = i + 1;
+        }
+        return n;
+    }
+
+    static int join_ncol(cfgCmd& cmd) {
+        int n = 0;
+        for (int i = 0; i < 8; i++) {
+            if (cmd.cmd[0][184 + i]) n = i + 1;
+        }
+        return n;
+    }
+
+    // column of a side's input that lands on key k after shuffle1, the kernel joins on the first one or two of them
+    static int key_col(cfgCmd& cmd, int side, int k) {
+        int8_t s = cmd.cmd[0].range(192 + 64 * side + 8 * k + 7, 192 + 64 * side + 8 * k);
+        if (s < 0 || s >= 8) return -1;
+        int8_t c = cmd.cmd[0].range(56 + 64 * side + 8 * s + 7, 56 + 64 * side + 8 * s);
+        return c;
+    }
+
+    static uint64_t key_of(std::vector<std::vector<int32_t> >& cols, int* kc, int nk, size_t r) {
+        uint64_t k = (uint32_t)cols[kc[0]][r];
+        if (nk > 1) k = (k << 32) | (uint32_t)cols[kc[1]][r];
+        return k;
+    }
+
+    static char* col_ptr(Table& tb, int c) { return (char*)(tb.data + tb.size512[c] + 1); }
+
+    // copy rows [start, start + n) of all columns, data starts after the one word table header
+    static void pack(Table& src, size_t start, size_t n, int ncol, Table& dst) {
+        for (int c = 0; c < ncol; c++) {
+            memcpy(col_ptr(dst, c), col_ptr(src, c) + 4 * start, 4 * n);
+        }
+        dst.setNumRow(n);
+    }
+
+    static void pack(std::vector<std::vector<int32_t> >& cols, size_t start, size_t n, Table& dst) {
+        for (size_t c = 0; c < cols.size(); c++) {
+            if (n) memcpy(col_ptr(dst, c), cols[c].data() + start, 4 * n);
+        }
+        dst.setNumRow(n);
+    }
+
+    // append the rows of a block written by the kernel, block size of each column is in the header
+    static int unpack(ap_uint<512>* blk, std::vector<std::vector<int32_t> >& cols) {
+        size_t n = blk[0].range(31, 0).to_int();
+        size_t blk_size = blk[0].range(63, 32).to_int();
+        if (n > blk_size * VEC_LEN) return -1;
+        for (size_t c = 0; c < cols.size(); c++) {
+            int32_t* p = (int32_t*)(blk + blk_size * c + 1);
+            cols[c].insert(cols[c].end(), p, p + n);
+        }
+        return 0;
+    }
+
+   public:
+    partJoinEngine(cl::Context& context,
+                   cl::Program& program,
+                   cl::CommandQueue& q,
+                   bufferTmp& buf,
+                   size_t chunk_row_ = PJ_CHUNK_ROW,
+                   size_t join_row_ = PJ_JOIN_ROW) {
+        ctx = context;
+        prg = program;
+        clq = q;
+        buftmp = &buf;
+        chunk_row = chunk_row_;
+        join_row = join_row_;
+    };
+
+    //! Number of partitions for a build table of nrow rows, a power of 2, -1 when more than gqePart can make
+    int getPartNum(size_t nrow) {
+        int n = 1;
+        while ((size_t)n * join_row < nrow) n *= 2;
+        return n > PJ_MAX_PART ? -1 : n;
+    };
+
+    /**
+     * @brief joins build and probe into tbout.
+     *
+     * @param build build table in host memory, index 0 of the configs
+     * @param probe probe table in host memory, index 1 of the configs
+     * @param part_cmd gqePart config, with device buffer allocated
+     * @param join_cmd gqeJoin config on the partitioned columns, with device buffer allocated
+     * @param tbout result, allocated by this call with the columns of the join write mask
+     * @return 0 on success, -1 when the tables need more partitions than gqePart makes, a build partition does not fit
+     * in the hash table, or a partition overflows
+     */
+    int run(Table& build, Table& probe, cfgCmd& part_cmd, cfgCmd& join_cmd, Table& tbout) {
+        struct timeval tv0, tv1, tv2;
+        gettimeofday(&tv0, 0);
+
+        int npart = getPartNum(build.nrow);
+        if (npart < 0) {
+            std::cout << "ERROR: " << build.nrow << " build rows need more than " << PJ_MAX_PART << " partitions"
+                      << std::endl;
+            return -1;
+        }
+        int bit_num = log2(npart);
+        int ncol_in = std::max(part_ncol(part_cmd, 0), part_ncol(part_cmd, 1));
+        ncol_in = std::max(ncol_in, (int)std::max(build.ncol, probe.ncol));
+        int ncol_p[2] = {part_ncol(part_cmd, 0), part_ncol(part_cmd, 1)};
+        int ncol_out = join_ncol(join_cmd);
+        int join_type = join_cmd.cmd[0].range(5, 3);
+        int nkey = join_cmd.cmd[0][2] ? 2 : 1;
+        int kcol[2][2];
+        for (int s = 0; s < 2; s++) {
+            for (int k = 0; k < nkey; k++) {
+                kcol[s][k] = key_col(join_cmd, s, k);
+                if (kcol[s][k] < 0 || kcol[s][k] >= ncol_p[s]) {
+                    std::cout << "ERROR: join key " << k << " of side " << s << " is not a partitioned column"
+                              << std::endl;
+                    return -1;
+                }
+            }
+        }
+
+        std::vector<partStep> psteps;
+        size_t nrows[2] = {build.nrow, probe.nrow};
+        for (int s = 0; s < 2; s++) {
+            for (size_t r = 0; r == 0 || r < nrows[s]; r += chunk_row) {
+                partStep st = {s, r, std::min(chunk_row, nrows[s] - r)};
+                psteps.push_back(st);
+            }
+        }
+        if (build.nrow > chunk_row) part_cmd.setBloomFilter(false);
+        // every gqeJoin call writes its result from the start of the buffer
+        join_cmd.cmd[0].set_bit(6, false);
+        bool bf_on = part_cmd.cmd[0][7];
+        std::cout << "Partitioned join: " << npart << " partitions, " << psteps.size() << " gqePart calls"
+                  << std::endl;
+
+        transEngine transcfg(clq);
+        transcfg.add(&part_cmd);
+        transcfg.add(&join_cmd);
+        transcfg.host2dev(0, nullptr, nullptr);
+
+        /*
+         * 1. partition both sides chunk by chunk, the partitions are gathered on host
+         */
+        std::vector<std::vector<std::vector<int32_t> > > parts[2];
+        for (int s = 0; s < 2; s++) {
+            parts[s].resize(npart, std::vector<std::vector<int32_t> >(ncol_p[s]));
+        }
+
+        Table tin[2], tpp[2];
+        krnlEngine kpart[2];
+        transEngine pin[2], pout[2];
+        for (int i = 0; i < 2; i++) {
+            tin[i] = Table("pj_in" + std::to_string(i), chunk_row, ncol_in, "");
+            tin[i].allocateHost();
+            tin[i].allocateDevBuffer(ctx, 33);
+            tpp[i] = Table("pj_pp" + std::to_string(i), chunk_row, std::max(ncol_p[0], ncol_p[1]), "");
+            tpp[i].allocateHost(PJ_PART_RATIO, npart);
+            tpp[i].allocateDevBuffer(ctx, 32);
+            tpp[i].initBuffer(clq);
+            kpart[i] = krnlEngine(prg, clq, "gqePart");
+            pin[i].setq(clq);
+            pin[i].add(&tin[i]);
+            pout[i].setq(clq);
+            pout[i].add(&tpp[i]);
+        }
+        clq.finish();
+
+        int err = 0;
+        size_t np = psteps.size();
+        std::vector<std::vector<cl::Event> > ph2d(np, std::vector<cl::Event>(1));
+        std::vector<std::vector<cl::Event> > pkrn(np, std::vector<cl::Event>(1));
+        std::vector<std::vector<cl::Event> > pd2h(np, std::vector<cl::Event>(1));
+        cl::Event bf_evt;
+        for (size_t i = 0; i <= np + 1; i++) {
+            // the set of step i was last used by step i - 2, gather its partitions first
+            if (i >= 2) {
+                size_t j = i - 2;
+                int side = psteps[j].side;
+                pd2h[j][0].wait();
+                for (int p = 0; p < npart; p++) {
+                    ap_uint<512>* blk = tpp[j % 2].data + tpp[j % 2].size512[tpp[j % 2].ncol] * p;
+                    if (unpack(blk, parts[side][p])) err = -1;
+                }
+            }
+            if (i >= np) continue;
+            partStep& st = psteps[i];
+            Table& src = st.side ? probe : build;
+            pack(src, st.start, st.nrow, src.ncol, tin[i % 2]);
+            pin[i % 2].host2dev(0, nullptr, &ph2d[i][0]);
+            // the probe side reads the bloom filter of the build side
+            std::vector<cl::Event> wait = ph2d[i];
+            if (st.side == 1 && bf_on) wait.push_back(bf_evt);
+            kpart[i % 2].setup_hp(512, st.side, bit_num, tin[i % 2], tpp[i % 2], part_cmd);
+            kpart[i % 2].run(0, &wait, &pkrn[i][0]);
+            if (st.side == 0) bf_evt = pkrn[i][0];
+            pout[i % 2].dev2host(0, &pkrn[i], &pd2h[i][0]);
+        }
+        if (err) {
+            std::cout << "ERROR: a partition overflowed, try a smaller chunk" << std::endl;
+            return -1;
+        }
+        gettimeofday(&tv1, 0);
+
+        /*
+         * 2. join the partition pairs, probe partitions larger than a chunk are joined slice by slice
+         */
+        size_t build_max = 0;
+        for (int p = 0; p < npart; p++) {
+            build_max = std::max(build_max, parts[0][p][0].size());
+        }
+        if (build_max > HT_BUFF_DEPTH) {
+            std::cout << "ERROR: build partition of " << build_max << " rows does not fit in the hash table of "
+                      << HT_BUFF_DEPTH << " rows" << std::endl;
+            return -1;
+        }
+
+        // a step outputs at most the build rows matching its probe rows, or its probe rows for semi and anti join
+        size_t probe_max = 0;
+        size_t result_max = 0;
+        std::vector<joinStep> jsteps;
+        for (int p = 0; p < npart; p++) {
+            size_t nb = parts[0][p][0].size();
+            size_t nq = parts[1][p][0].size();
+            // no build row, only anti join has a result
+            if (nb == 0 && join_type != 2) continue;
+            std::unordered_map<uint64_t, size_t> count;
+            if (join_type != 2) {
+                for (size_t r = 0; r < nb; r++) count[key_of(parts[0][p], kcol[0], nkey, r)]++;
+            }
+            for (size_t r = 0; r < nq; r += chunk_row) {
+                joinStep st = {p, r, std::min(chunk_row, nq - r)};
+                size_t nr = st.nrow;
+                if (join_type != 2) {
+                    size_t m = 0;
+                    for (size_t k = st.start; k < st.start + st.nrow; k++) {
+                        auto it = count.find(key_of(parts[1][p], kcol[1], nkey, k));
+                        if (it != count.end()) m += it->second;
+                    }
+                    nr = join_type == 1 ? std::min(m, nr) : m;
+                }
+                probe_max = std::max(probe_max, st.nrow);
+                result_max = std::max(result_max, nr);
+                jsteps.push_back(st);
+            }
+        }
+
+        std::vector<std::vector<int32_t> > result(ncol_out);
+        Table tb[2], tp[2], tr[2];
+        krnlEngine kjoin[2];
+        transEngine jin[2], jout[2];
+        for (int i = 0; i < 2; i++) {
+            tb[i] = Table("pj_b" + std::to_string(i), std::max(build_max, (size_t)1), ncol_p[0], "");
+            tb[i].allocateHost();
+            tb[i].allocateDevBuffer(ctx, 32);
+            tp[i] = Table("pj_p" + std::to_string(i), std::max(probe_max, (size_t)1), ncol_p[1], "");
+            tp[i].allocateHost();
+            tp[i].allocateDevBuffer(ctx, 32);
+            tr[i] = Table("pj_r" + std::to_string(i), std::max(result_max, (size_t)1), ncol_out, "");
+            tr[i].allocateHost();
+            tr[i].allocateDevBuffer(ctx, 32);
+            tr[i].initBuffer(clq);
+            kjoin[i] = krnlEngine(prg, clq, "gqeJoin");
+            kjoin[i].setup(tb[i], tp[i], tr[i], join_cmd, *buftmp);
+            jin[i].setq(clq);
+            jin[i].add(&tb[i]);
+            jin[i].add(&tp[i]);
+            jout[i].setq(clq);
+            jout[i].add(&tr[i]);
+        }
+        clq.finish();
+
+        size_t nj = jsteps.size();
+        std::vector<std::vector<cl::Event> > jh2d(nj, std::vector<cl::Event>(1));
+        std::vector<std::vector<cl::Event> > jkrn(nj, std::vector<cl::Event>(1));
+        std::vector<std::vector<cl::Event> > jd2h(nj, std::vector<cl::Event>(1));
+        for (size_t i = 0; i <= nj + 1; i++) {
+            if (i >= 2) {
+                size_t j = i - 2;
+                jd2h[j][0].wait();
+                if (unpack(tr[j % 2].data, result)) err = -1;
+            }
+            if (i >= nj) continue;
+            joinStep& st = jsteps[i];
+            pack(parts[0][st.part], 0, parts[0][st.part][0].size(), tb[i % 2]);
+            pack(parts[1][st.part], st.start, st.nrow, tp[i % 2]);
+            jin[i % 2].host2dev(0, nullptr, &jh2d[i][0]);
+            // the hash table buffers are shared, so gqeJoin calls run one after another
+            std::vector<cl::Event> wait = jh2d[i];
+            if (i > 0) wait.push_back(jkrn[i - 1][0]);
+            kjoin[i % 2].run(0, &wait, &jkrn[i][0]);
+            jout[i % 2].dev2host(0, &jkrn[i], &jd2h[i][0]);
+        }
+        if (err) {
+            std::cout << "ERROR: join result overflowed" << std::endl;
+            return -1;
+        }
+
+        size_t nout = ncol_out ? result[0].size() : 0;
+        tbout = Table(tbout.name, nout, ncol_out, "");
+        tbout.allocateHost();
+        pack(result, 0, nout, tbout);
+        gettimeofday(&tv2, 0);
+
+        std::cout << "Partitioned join: " << nj << " gqeJoin calls, " << nout << " rows" << std::endl;
+        print_h_time(tv0, tv0, tv1, "Partition");
+        print_h_time(tv0, tv1, tv2, "Join");
+        return 0;
+    };
+};
+
+#endif
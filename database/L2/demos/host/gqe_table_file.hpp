@@ -0,0 +1,122 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GQE_TABLE_FILE_H
+#define GQE_TABLE_FILE_H
+
+// On-disk column layout which can be mmaped straight into a GQE table.
+//
+// <name>.gcol:
+//   [0, 4096)          gcol_header_t, zero padded
+//   [4096, 4096 + 64 * n512b)
+//                      column image as the kernels read it: one 512-bit
+//                      header word (nrow in bits [31:0], n512b in bits
+//                      [63:32]), then nrow values of width bytes, zero
+//                      padded to n512b words.
+//
+// n512b is a multiple of a page, so images of several columns mapped back to
+// back form one page aligned table buffer for CL_MEM_USE_HOST_PTR.
+
+#include "table_dt.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <stdint.h>
+#include <unistd.h>
+
+#define GCOL_MAGIC "XFGQECOL"
+#define GCOL_VERSION 1
+#define GCOL_PAGE 4096
+
+struct gcol_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t width; // bytes per row
+    uint64_t nrow;
+    uint64_t n512b; // size of column image in 512-bit words
+    char name[64];
+};
+
+// image size in 512-bit words, same slack as Table::addCol, rounded to a page
+inline size_t gcol_n512b(size_t nrow, size_t width) {
+    size_t depth = nrow + VEC_LEN * 2 - 1;
+    size_t n512b = (width * depth + 64 - 1) / 64;
+    return (n512b + GCOL_PAGE / 64 - 1) / (GCOL_PAGE / 64) * (GCOL_PAGE / 64);
+}
+
+inline std::string gcol_path(const std::string& dir, const std::string& name) {
+    return dir + "/" + name + ".gcol";
+}
+
+// write one column, data holds nrow values of width bytes
+inline int write_gcol(const std::string& dir, const std::string& name, const void* data, size_t nrow, size_t width) {
+    std::string fn = gcol_path(dir, name);
+    FILE* f = fopen(fn.c_str(), "wb");
+    if (!f) {
+        std::cerr << "ERROR: " << fn << " cannot be opened for binary write." << std::endl;
+        return -1;
+    }
+
+    char page[GCOL_PAGE];
+    memset(page, 0, sizeof(page));
+    gcol_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, GCOL_MAGIC, sizeof(hdr.magic));
+    hdr.version = GCOL_VERSION;
+    hdr.width = width;
+    hdr.nrow = nrow;
+    hdr.n512b = gcol_n512b(nrow, width);
+    strncpy(hdr.name, name.c_str(), sizeof(hdr.name) - 1);
+    memcpy(page, &hdr, sizeof(hdr));
+    size_t cnt = fwrite(page, GCOL_PAGE, 1, f);
+
+    // column header word, rest of the word stays zero
+    char word[64];
+    memset(word, 0, sizeof(word));
+    uint32_t h[2] = {(uint32_t)nrow, (uint32_t)hdr.n512b};
+    memcpy(word, h, sizeof(h));
+    cnt += fwrite(word, 64, 1, f);
+    cnt += fwrite(data, width * nrow, 1, f) || (nrow == 0);
+
+    // zero padding up to the end of the image
+    size_t pad = (hdr.n512b - 1) * 64 - width * nrow;
+    memset(page, 0, sizeof(page));
+    while (pad > 0) {
+        size_t n = pad < sizeof(page) ? pad : sizeof(page);
+        if (fwrite(page, n, 1, f) != 1) break;
+        pad -= n;
+    }
+    fclose(f);
+    if (cnt != 3 || pad != 0) {
+        std::cerr << "ERROR: failed writing " << fn << "." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// read and check the file header, returns 0 when fd holds a valid column
+inline int read_gcol_header(int fd, const std::string& fn, gcol_header_t& hdr) {
+    ssize_t cnt = pread(fd, &hdr, sizeof(hdr), 0);
+    if (cnt != (ssize_t)sizeof(hdr) || memcmp(hdr.magic, GCOL_MAGIC, sizeof(hdr.magic)) ||
+        hdr.version != GCOL_VERSION) {
+        std::cerr << "ERROR: " << fn << " is not a gcol file." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+#endif // GQE_TABLE_FILE_H
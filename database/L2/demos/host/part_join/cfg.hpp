@@ -0,0 +1,187 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GQE_CFG_H
+#define GQE_CFG_H
+
+#include "ap_int.h"
+
+#include "xf_database/dynamic_alu_host.hpp"
+#include "xf_database/enums.hpp"
+
+static void gen_pass_fcfg(uint32_t cfg[]) {
+    using namespace xf::database;
+    int n = 0;
+
+    // cond_1
+    cfg[n++] = (uint32_t)0UL;
+    cfg[n++] = (uint32_t)0UL;
+    cfg[n++] = 0UL | (FOP_DC << FilterOpWidth) | (FOP_DC);
+    // cond_2
+    cfg[n++] = (uint32_t)0UL;
+    cfg[n++] = (uint32_t)0UL;
+    cfg[n++] = 0UL | (FOP_DC << FilterOpWidth) | (FOP_DC);
+    // cond_3
+    cfg[n++] = (uint32_t)0UL;
+    cfg[n++] = (uint32_t)0UL;
+    cfg[n++] = 0UL | (FOP_DC << FilterOpWidth) | (FOP_DC);
+    // cond_4
+    cfg[n++] = (uint32_t)0UL;
+    cfg[n++] = (uint32_t)0UL;
+    cfg[n++] = 0UL | (FOP_DC << FilterOpWidth) | (FOP_DC);
+
+    uint32_t r = 0;
+    int sh = 0;
+    // cond_1 -- cond_2
+    r |= ((uint32_t)(FOP_DC << sh));
+    sh += FilterOpWidth;
+    // cond_1 -- cond_3
+    r |= ((uint32_t)(FOP_DC << sh));
+    sh += FilterOpWidth;
+    // cond_1 -- cond_4
+    r |= ((uint32_t)(FOP_DC << sh));
+    sh += FilterOpWidth;
+
+    // cond_2 -- cond_3
+    r |= ((uint32_t)(FOP_DC << sh));
+    sh += FilterOpWidth;
+    // cond_2 -- cond_4
+    r |= ((uint32_t)(FOP_DC << sh));
+    sh += FilterOpWidth;
+
+    // cond_3 -- cond_4
+    r |= ((uint32_t)(FOP_DC << sh));
+    sh += FilterOpWidth;
+
+    cfg[n++] = r;
+
+    // 4 true and 6 true
+    for (int i = 0; i < 31; i++) {
+        cfg[n++] = (uint32_t)0UL;
+    }
+    cfg[n++] = (uint32_t)(1UL << 31);
+}
+
+/*
+ * select b.key, a.pld, b.pld from a, b where a.key = b.key
+ *
+ * a (build) and b (probe) both have 2 columns, key and payload. Keys repeat on both sides.
+ * The same config partitions both tables on column 0 and joins the partitions.
+ *
+ * joined
+ * 0 b.pld
+ * 1 a.pld
+ * 2 key
+ */
+void get_cfg_dat_1(ap_uint<512>* hbuf) {
+    ap_uint<512>* b = hbuf;
+    memset(b, 0, sizeof(ap_uint<512>) * 9);
+
+    // 512b word
+    ap_uint<512> t = 1; // join on
+    t.set_bit(1, 0);    // aggr off
+    t.set_bit(2, 0);    // dual-key off
+    t.range(5, 3) = 0;  // hash join flag = 0 for normal, 1 for semi, 2 for anti
+
+    signed char id_a[] = {0, 1, -1, -1, -1, -1, -1, -1};
+    for (int c = 0; c < 8; ++c) {
+        t.range(56 + 8 * c + 7, 56 + 8 * c) = id_a[c];
+    }
+
+    signed char id_b[] = {0, 1, -1, -1, -1, -1, -1, -1};
+    for (int c = 0; c < 8; ++c) {
+        t.range(120 + 8 * c + 7, 120 + 8 * c) = id_b[c];
+    }
+
+    t.range(191, 184) = (128 * 0 + 64 * 0 + 32 * 0 + 16 * 0 + 8 * 0 + 4 * 1 + 2 * 1 + 1 * 1);
+
+    b[0] = t;
+
+    // 512b word
+    // alu:
+    ap_uint<289> op = 0;
+    b[1] = op;
+    b[2] = op;
+
+    // 512b word * 3
+    // filter a
+    uint32_t cfg[45];
+    gen_pass_fcfg(cfg);
+    memcpy(&b[3], cfg, sizeof(uint32_t) * 45);
+
+    // 512b word * 3
+    // filter b
+    gen_pass_fcfg(cfg);
+    memcpy(&b[6], cfg, sizeof(uint32_t) * 45);
+    // --
+    ap_int<64> shuffle1a_cfg;
+    shuffle1a_cfg(7, 0) = 0;
+    shuffle1a_cfg(15, 8) = 1;
+    shuffle1a_cfg(23, 16) = -1;
+    shuffle1a_cfg(31, 24) = -1;
+    shuffle1a_cfg(39, 32) = -1;
+    shuffle1a_cfg(47, 40) = -1;
+    shuffle1a_cfg(55, 48) = -1;
+    shuffle1a_cfg(63, 56) = -1;
+
+    ap_int<64> shuffle1b_cfg;
+    shuffle1b_cfg(7, 0) = 0;
+    shuffle1b_cfg(15, 8) = 1;
+    shuffle1b_cfg(23, 16) = -1;
+    shuffle1b_cfg(31, 24) = -1;
+    shuffle1b_cfg(39, 32) = -1;
+    shuffle1b_cfg(47, 40) = -1;
+    shuffle1b_cfg(55, 48) = -1;
+    shuffle1b_cfg(63, 56) = -1;
+
+    // probe payloads start at 0, build payloads at 6, the key at 12
+    ap_int<64> shuffle2_cfg;
+    shuffle2_cfg(7, 0) = 0;
+    shuffle2_cfg(15, 8) = 6;
+    shuffle2_cfg(23, 16) = 12;
+    shuffle2_cfg(31, 24) = -1;
+    shuffle2_cfg(39, 32) = -1;
+    shuffle2_cfg(47, 40) = -1;
+    shuffle2_cfg(55, 48) = -1;
+    shuffle2_cfg(63, 56) = -1;
+
+    ap_int<64> shuffle3_cfg;
+    shuffle3_cfg(7, 0) = 0;
+    shuffle3_cfg(15, 8) = 1;
+    shuffle3_cfg(23, 16) = 2;
+    shuffle3_cfg(31, 24) = -1;
+    shuffle3_cfg(39, 32) = -1;
+    shuffle3_cfg(47, 40) = -1;
+    shuffle3_cfg(55, 48) = -1;
+    shuffle3_cfg(63, 56) = -1;
+
+    ap_int<64> shuffle4_cfg;
+    shuffle4_cfg(7, 0) = 0;
+    shuffle4_cfg(15, 8) = 1;
+    shuffle4_cfg(23, 16) = 2;
+    shuffle4_cfg(31, 24) = -1;
+    shuffle4_cfg(39, 32) = -1;
+    shuffle4_cfg(47, 40) = -1;
+    shuffle4_cfg(55, 48) = -1;
+    shuffle4_cfg(63, 56) = -1;
+
+    b[0].range(255, 192) = shuffle1a_cfg;
+    b[0].range(319, 256) = shuffle1b_cfg;
+    b[0].range(383, 320) = shuffle2_cfg;
+    b[0].range(447, 384) = shuffle3_cfg;
+    b[0].range(511, 448) = shuffle4_cfg;
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "table_dt.hpp"
+#include "utils.hpp"
+#include "cfg.hpp"
+
+#include <sys/time.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include "gqe_part_join.hpp"
+
+// build keys repeat about KEY_DUP times, so the join is many to many
+#define KEY_DUP 3
+
+typedef std::array<int32_t, 3> joinRow;
+
+static void gen_table(Table& tb, int32_t key_range, int32_t pld_base) {
+    for (size_t r = 0; r < tb.nrow; r++) {
+        tb.setInt32(r, 0, (int32_t)((r * 2654435761ULL) % key_range));
+        tb.setInt32(r, 1, pld_base + (int32_t)r);
+    }
+    tb.setNumRow(tb.nrow);
+}
+
+// b.pld, a.pld, key of every matching pair, as in the join config
+static void cpu_join(Table& build, Table& probe, std::vector<joinRow>& out) {
+    std::unordered_multimap<int32_t, int32_t> ht;
+    for (size_t r = 0; r < build.nrow; r++) {
+        ht.insert(std::make_pair(build.getInt32(r, 0), build.getInt32(r, 1)));
+    }
+    for (size_t r = 0; r < probe.nrow; r++) {
+        int32_t key = probe.getInt32(r, 0);
+        auto its = ht.equal_range(key);
+        for (auto it = its.first; it != its.second; ++it) {
+            joinRow row = {probe.getInt32(r, 1), it->second, key};
+            out.push_back(row);
+        }
+    }
+}
+
+int main(int argc, const char* argv[]) {
+    std::cout << "\n------------ GQE partitioned join -------------\n";
+
+    // cmd arg parser.
+    ArgParser parser(argc, argv);
+
+    std::string xclbin_path;
+    if (!parser.getCmdOption("-xclbin", xclbin_path)) {
+        std::cout << "ERROR: xclbin path is not set!\n";
+        return 1;
+    }
+
+    int board = 0;
+    std::string board_s;
+    if (parser.getCmdOption("-b", board_s)) {
+        try {
+            board = std::stoi(board_s);
+        } catch (...) {
+            board = 0;
+        }
+    }
+
+    // small chunks and joins by default, so that a few MB of rows already go through many kernel calls
+    int chunk_bits = 16;
+    int join_bits = 14;
+    std::string bits_s;
+    if (parser.getCmdOption("-chunk", bits_s)) {
+        try {
+            chunk_bits = std::stoi(bits_s);
+        } catch (...) {
+            chunk_bits = 16;
+        }
+    }
+    if (parser.getCmdOption("-join", bits_s)) {
+        try {
+            join_bits = std::stoi(bits_s);
+        } catch (...) {
+            join_bits = 14;
+        }
+    }
+
+    int scale = 1;
+    std::string scale_str;
+    if (parser.getCmdOption("-c", scale_str)) {
+        try {
+            scale = std::stoi(scale_str);
+        } catch (...) {
+            scale = 1;
+        }
+    }
+    size_t build_n = (size_t)scale << 18;
+    size_t probe_n = (size_t)scale << 20;
+    std::cout << "NOTE: " << build_n << " build rows, " << probe_n << " probe rows, chunks of " << (1 << chunk_bits)
+              << " rows, joins of " << (1 << join_bits) << " build rows\n";
+
+    // ********************************************************** //
+
+    // Get CL devices.
+    std::vector<cl::Device> devices = xcl::get_xil_devices();
+    cl::Device device = devices[board];
+
+    // Create context and command queue for selected device
+    cl::Context context(device);
+    cl::CommandQueue q(context, device, CL_QUEUE_PROFILING_ENABLE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+    std::string devName = device.getInfo<CL_DEVICE_NAME>();
+    std::cout << "Selected Device " << devName << "\n";
+
+    cl::Program::Binaries xclBins = xcl::import_binary_file(xclbin_path);
+    std::vector<cl::Device> devices_;
+    devices_.push_back(device);
+    cl::Program program(context, devices_, xclBins);
+
+    std::cout << "Kernel has been created\n";
+    // ********************************************************* //
+
+    Table build("build", build_n, 2, "");
+    Table probe("probe", probe_n, 2, "");
+    build.allocateHost();
+    probe.allocateHost();
+    gen_table(build, build_n / KEY_DUP, 0);
+    // about one probe key in two finds no build row
+    gen_table(probe, 2 * build_n / KEY_DUP, 1 << 30);
+
+    cfgCmd part_cfg, join_cfg;
+    part_cfg.allocateHost();
+    get_cfg_dat_1(part_cfg.cmd);
+    part_cfg.allocateDevBuffer(context, 32);
+    join_cfg.allocateHost();
+    get_cfg_dat_1(join_cfg.cmd);
+    join_cfg.allocateDevBuffer(context, 32);
+
+    bufferTmp buftmp(context);
+    buftmp.initBuffer(q);
+
+    partJoinEngine pj(context, program, q, buftmp, (size_t)1 << chunk_bits, (size_t)1 << join_bits);
+    Table tout("tout", 0, 0, "");
+    struct timeval tv0, tv1;
+    gettimeofday(&tv0, 0);
+    int err = pj.run(build, probe, part_cfg, join_cfg, tout);
+    gettimeofday(&tv1, 0);
+    if (err) {
+        std::cout << "ERROR: partitioned join failed" << std::endl;
+        return 1;
+    }
+    std::cout << "FPGA execution time " << tvdiff(&tv0, &tv1) / 1000 << " ms" << std::endl;
+
+    std::vector<joinRow> golden, result;
+    cpu_join(build, probe, golden);
+    for (size_t r = 0; r < tout.nrow; r++) {
+        joinRow row = {tout.getInt32(r, 0), tout.getInt32(r, 1), tout.getInt32(r, 2)};
+        result.push_back(row);
+    }
+    std::sort(golden.begin(), golden.end());
+    std::sort(result.begin(), result.end());
+
+    int nerror = 0;
+    if (result != golden) {
+        std::cout << "ERROR: " << result.size() << " rows, expected " << golden.size() << std::endl;
+        nerror = 1;
+    } else {
+        std::cout << "Result matches the CPU join, " << golden.size() << " rows" << std::endl;
+    }
+    return nerror;
+}
@@ -13,30 +13,14 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // l_returnflag, l_linestatus, l_quantity  l_extendedprice l_discount l_tax l_shipdate
 void q1FilterL(Table& tin, Table& tout) {
-    int r = 0;
     int nrow = tin.getNumRow();
-    for (int i = 0; i < nrow; ++i) {
-        int32_t l_shipdate = tin.getInt32(i, 6);
-        // if(i<10) std::cout<<std::dec<<l_shipdate<<std::endl;
-        if (l_shipdate <= 19980902) {
-            int32_t l_returnflag = tin.getInt32(i, 0);
-            int32_t l_linestatus = tin.getInt32(i, 1);
-            int32_t l_quantity = tin.getInt32(i, 2);
-            int32_t l_extendedprice = tin.getInt32(i, 3);
-            int32_t l_discount = tin.getInt32(i, 4);
-            int32_t l_tax = tin.getInt32(i, 5);
-            tout.setInt32(r, 0, l_returnflag);
-            tout.setInt32(r, 1, l_linestatus);
-            tout.setInt32(r, 2, l_quantity);
-            tout.setInt32(r, 3, l_extendedprice);
-            tout.setInt32(r, 4, l_discount);
-            tout.setInt32(r, 5, l_tax);
-            tout.setInt32(r, 6, l_shipdate);
-            ++r;
-        }
-    }
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin, 6);
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) { return l_shipdate[i] <= 19980902; });
+    for (int c = 0; c < 7; c++) cpu::gather(cpu::col<int32_t>(tin, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " in q1FilterL" << std::endl;
 }
@@ -71,58 +55,59 @@ struct Q1GroupValue {
 };
 
 void q1GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<Q1GroupKey, Q1GroupValue> m;
+    typedef cpu::HashAgg<Q1GroupKey, Q1GroupValue> Agg;
+    const int32_t* l_returnflag = cpu::col<int32_t>(tin, 0);
+    const int32_t* l_linestatus = cpu::col<int32_t>(tin, 1);
+    const int32_t* l_quantity = cpu::col<int32_t>(tin, 2); // index much patMatch YAML
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin, 3);
+    const int32_t* l_discount = cpu::col<int32_t>(tin, 4);
+    const int32_t* l_tax = cpu::col<int32_t>(tin, 5);
 
     int nrow = tin.getNumRow();
-    for (int i = 0; i < nrow; ++i) {
-        int32_t l_returnflag = tin.getInt32(i, 0);
-        int32_t l_linestatus = tin.getInt32(i, 1);
-        int32_t l_quantity = tin.getInt32(i, 2); // index much patMatch YAML
-        int32_t l_extendedprice = tin.getInt32(i, 3);
-        int32_t l_discount = tin.getInt32(i, 4);
-        int32_t l_tax = tin.getInt32(i, 5);
-
-        int32_t eval0 = l_extendedprice * (100 - l_discount) / 100;
-        int64_t eval1 = (int64_t)l_extendedprice * (100 - l_discount) * (100 + l_tax) / 10000;
-        Q1GroupKey k{l_returnflag, l_linestatus};
-        auto it = m.find(k);
-        if (it != m.end()) {
-            int64_t sum_qty = it->second.sum_qty + l_quantity;
-            int64_t sum_price = it->second.sum_price + l_extendedprice;
-            int64_t sum_disc_price = it->second.sum_disc_price + eval0;
-            int64_t sum_charge = it->second.sum_charge + eval1;
-            int64_t sum_disc = it->second.sum_disc + l_discount;
-            int64_t sum_count = it->second.sum_count + 1;
-            Q1GroupValue s{sum_qty, sum_price, sum_disc_price, sum_charge, sum_disc, sum_count};
-            m[k] = s;
-        } else {
-            Q1GroupValue s{l_quantity, l_extendedprice, eval0, eval1, l_discount, 1};
-            m.insert(std::make_pair(k, s));
-        }
-    }
+    Agg m = cpu::groupBy<Q1GroupKey, Q1GroupValue>(
+        nrow,
+        [&](Agg& h, size_t i) {
+            int32_t eval0 = l_extendedprice[i] * (100 - l_discount[i]) / 100;
+            int64_t eval1 = (int64_t)l_extendedprice[i] * (100 - l_discount[i]) * (100 + l_tax[i]) / 10000;
+            Q1GroupValue& v = h[Q1GroupKey{l_returnflag[i], l_linestatus[i]}];
+            v.sum_qty += l_quantity[i];
+            v.sum_price += l_extendedprice[i];
+            v.sum_disc_price += eval0;
+            v.sum_charge += eval1;
+            v.sum_disc += l_discount[i];
+            v.sum_count++;
+        },
+        [](Q1GroupValue& a, const Q1GroupValue& b) {
+            a.sum_qty += b.sum_qty;
+            a.sum_price += b.sum_price;
+            a.sum_disc_price += b.sum_disc_price;
+            a.sum_charge += b.sum_charge;
+            a.sum_disc += b.sum_disc;
+            a.sum_count += b.sum_count;
+        });
 
     int r = 0;
-    for (auto& it : m) {
-        int64_t sum_qty = it.second.sum_qty;
-        int64_t sum_price = it.second.sum_price;
-        int64_t sum_disc = it.second.sum_disc;
-        int64_t sum_count = it.second.sum_count;
+    m.forEach([&](const Q1GroupKey& k, Q1GroupValue& v) {
+        int64_t sum_qty = v.sum_qty;
+        int64_t sum_price = v.sum_price;
+        int64_t sum_disc = v.sum_disc;
+        int64_t sum_count = v.sum_count;
         int64_t avg_qty = sum_qty / sum_count;
         int64_t avg_price = sum_price / sum_count;
         int64_t avg_disc = sum_disc / sum_count;
 
-        tout.setInt32(r, 0, it.first.k1);
-        tout.setInt32(r, 1, it.first.k2);
+        tout.setInt32(r, 0, k.k1);
+        tout.setInt32(r, 1, k.k2);
         tout.setInt64(r, 2, sum_qty);
         tout.setInt64(r, 3, sum_price);
-        tout.setInt64(r, 4, it.second.sum_disc_price);
-        tout.setInt64(r, 5, it.second.sum_charge);
+        tout.setInt64(r, 4, v.sum_disc_price);
+        tout.setInt64(r, 5, v.sum_charge);
         tout.setInt64(r, 6, avg_qty);
         tout.setInt64(r, 7, avg_price);
         tout.setInt64(r, 8, avg_disc);
         tout.setInt64(r, 9, sum_count);
         ++r;
-    }
+    });
     tout.setNumRow(r);
 }
 void q1Sort(Table& tin, Table& tout) {
@@ -14,34 +14,26 @@
  * limitations under the License.
  */
 #include <regex>
+#include "cpu_engine.hpp"
 // t1:5
 void q2Join_r_n(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        std::array<char, TPCH_READ_REGION_LEN + 1> r_name = tin1.getcharN<char, TPCH_READ_REGION_LEN + 1>(i, 1);
-        if (!strcmp("EUROPE", r_name.data())) {
-            int32_t r_regionkey = tin1.getInt32(i, 0);
-            ht1.insert(std::make_pair(r_regionkey, 0));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t n_regionkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(n_regionkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t n_nationkey = tin2.getInt32(i, 1);
-            int32_t n_rowid = i;
-            // std::array<char,TPCH_READ_NATION_LEN+1>n_name = tin2.getcharN<char,TPCH_READ_NATION_LEN+1>(i,2);
-            tout.setInt32(r, 0, n_nationkey);
-            tout.setInt32(r, 1, n_rowid);
-            //  tout.setcharN<char,TPCH_READ_NATION_LEN+1>(r,1,n_name.data());
-            it++;
-            r++;
-        }
-    }
+    const int32_t* r_regionkey = cpu::col<int32_t>(tin1, 0);
+    cpu::SelVec sel = cpu::select(
+        nrow1, [&](uint32_t i) { return !strcmp("EUROPE", cpu::str<TPCH_READ_REGION_LEN + 1>(tin1, 1, i)); });
+    cpu::HashJoin ht1;
+    ht1.build(sel, [&](uint32_t i) { return r_regionkey[i]; });
+    const int32_t* n_regionkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin2, 1);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return n_regionkey[i]; });
+    int32_t* o_nationkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_rowid = cpu::col<int32_t>(tout, 1);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        o_nationkey[r] = n_nationkey[m[r].probe];
+        o_rowid[r] = m[r].probe;
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q2Join_r_n" << std::endl;
 }
@@ -50,29 +42,24 @@ void q2Join_r_n(Table& tin1, Table& tin2, Table& tout) {
 // s_nationkey,s_suppkey,s_rowid(s_acctbal,s_name,s_address,s_phone,s_comment)
 void q2Join_t1_s(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t n_nationkey = tin1.getInt32(i, 0);
-        int32_t n_rowid = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(n_nationkey, n_rowid));
-    }
-    int r = 0;
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t s_nationkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(s_nationkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t s_suppkey = tin2.getInt32(i, 1);
-            int32_t s_rowid = tin2.getInt32(i, 7);
-            int32_t n_rowid = it->second;
-            tout.setInt32(r, 0, s_suppkey);
-            tout.setInt32(r, 1, s_rowid);
-            tout.setInt32(r, 2, n_rowid);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* s_rowid = cpu::col<int32_t>(tin2, 7);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return s_nationkey[i]; });
+    int32_t* o_suppkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_srowid = cpu::col<int32_t>(tout, 1);
+    int32_t* o_nrowid = cpu::col<int32_t>(tout, 2);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        o_suppkey[r] = s_suppkey[m[r].probe];
+        o_srowid[r] = s_rowid[m[r].probe];
+        o_nrowid[r] = n_rowid[m[r].build];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q2Join_t1_s" << std::endl;
 }
@@ -81,35 +68,26 @@ void q2Join_t1_s(Table& tin1, Table& tin2, Table& tout) {
 void q2Join_t2_p(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    struct KeyA {
-        int32_t s_rowid;
-        int32_t n_rowid;
-    };
-    std::unordered_multimap<int32_t, KeyA> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t s_suppkey = tin1.getInt32(i, 0);
-        int32_t s_rowid = tin1.getInt32(i, 1);
-        int32_t n_rowid = tin1.getInt32(i, 2);
-        ht1.insert(std::make_pair(s_suppkey, KeyA{s_rowid, n_rowid}));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t ps_suppkey = tin2.getInt32(i, 1);
-        auto its = ht1.equal_range(ps_suppkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t ps_partkey = tin2.getInt32(i, 0);
-            int32_t ps_supplycost = tin2.getInt32(i, 2);
-            int32_t s_rowid = it->second.s_rowid;
-            int32_t n_rowid = it->second.n_rowid;
-            tout.setInt32(r, 0, ps_partkey);
-            tout.setInt32(r, 1, ps_supplycost);
-            tout.setInt32(r, 2, s_rowid);
-            tout.setInt32(r, 3, n_rowid);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* s_rowid = cpu::col<int32_t>(tin1, 1);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_suppkey[i]; });
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* ps_suppkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* ps_supplycost = cpu::col<int32_t>(tin2, 2);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return ps_suppkey[i]; });
+    int32_t* o_partkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_supplycost = cpu::col<int32_t>(tout, 1);
+    int32_t* o_srowid = cpu::col<int32_t>(tout, 2);
+    int32_t* o_nrowid = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        o_partkey[r] = ps_partkey[m[r].probe];
+        o_supplycost[r] = ps_supplycost[m[r].probe];
+        o_srowid[r] = s_rowid[m[r].build];
+        o_nrowid[r] = n_rowid[m[r].build];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q2Join_t2_p" << std::endl;
 }
@@ -118,20 +96,20 @@ void q2Join_t2_p(Table& tin1, Table& tin2, Table& tout) {
 
 void q2Filter_p(Table& tin1, Table& tout) {
     int nrow = tin1.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_TYPE_LEN + 1> p_type = tin1.getcharN<char, TPCH_READ_P_TYPE_LEN + 1>(i, 2);
-        int32_t p_size = tin1.getInt32(i, 3);
-        // if( p_size==15&& std::regex_match(p_type.data(), std::regex("(.*)(BRASS)"))){
-        if (p_size == 15 && std::string(p_type.data()).find("BRASS") == std::string(p_type.data()).length() - 5) {
-            int32_t p_partkey = tin1.getInt32(i, 0);
-            int32_t p_rowid = i;
-            tout.setInt32(r, 0, p_partkey);
-            tout.setInt32(r, 1, p_rowid);
-            //  tout.setcharN<char,TPCH_READ_P_MFG_LEN+1>(r,1,p_mfgr);
-            r++;
-        }
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* p_size = cpu::col<int32_t>(tin1, 3);
+    // if( p_size==15&& std::regex_match(p_type.data(), std::regex("(.*)(BRASS)"))){
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        if (p_size[i] != 15) return false;
+        const char* p_type = cpu::str<TPCH_READ_P_TYPE_LEN + 1>(tin1, 2, i);
+        size_t len = strlen(p_type);
+        return len >= 5 && strstr(p_type, "BRASS") == p_type + len - 5;
+    });
+    int32_t* o_partkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_rowid = cpu::col<int32_t>(tout, 1);
+    cpu::gather(p_partkey, sel, o_partkey);
+    cpu::parallelFor(sel.size(), [&](size_t r) { o_rowid[r] = sel[r]; });
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q2Filter_p" << std::endl;
 }
@@ -140,148 +118,107 @@ void q2Filter_p(Table& tin1, Table& tout) {
 void q2Join_t4_t3(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t p_partkey = tin1.getInt32(i, 0);
-        int32_t p_rowid = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(p_partkey, p_rowid));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t ps_partkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(ps_partkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t ps_supplycost = tin2.getInt32(i, 1);
-            int32_t s_rowid = tin2.getInt32(i, 2);
-            int32_t n_rowid = tin2.getInt32(i, 3);
-            int32_t p_rowid = it->second;
-            tout.setInt32(r, 0, ps_partkey);
-            tout.setInt32(r, 1, ps_supplycost);
-            tout.setInt32(r, 2, p_rowid);
-            tout.setInt32(r, 3, s_rowid);
-            tout.setInt32(r, 4, n_rowid);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* p_rowid = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return p_partkey[i]; });
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* ps_supplycost = cpu::col<int32_t>(tin2, 1);
+    const int32_t* s_rowid = cpu::col<int32_t>(tin2, 2);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin2, 3);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return ps_partkey[i]; });
+    int32_t* o_partkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_supplycost = cpu::col<int32_t>(tout, 1);
+    int32_t* o_prowid = cpu::col<int32_t>(tout, 2);
+    int32_t* o_srowid = cpu::col<int32_t>(tout, 3);
+    int32_t* o_nrowid = cpu::col<int32_t>(tout, 4);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        o_partkey[r] = ps_partkey[m[r].probe];
+        o_supplycost[r] = ps_supplycost[m[r].probe];
+        o_prowid[r] = p_rowid[m[r].build];
+        o_srowid[r] = s_rowid[m[r].probe];
+        o_nrowid[r] = n_rowid[m[r].probe];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q2Join_t4_t3" << std::endl;
 }
 // t6:460
 void q2GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t ps_partkey = tin.getInt32(i, 0);
-        int32_t ps_supplycost = tin.getInt32(i, 1);
-        ;
-        auto it = ht1.find(ps_partkey);
-        if (it != ht1.end()) {
-            int64_t s = it->second < ps_supplycost ? it->second : ps_supplycost;
-            ht1[ps_partkey] = s;
-        } else {
-            ht1.insert(std::make_pair(ps_partkey, ps_supplycost));
-        }
-    }
+    typedef cpu::HashAgg<int32_t, int32_t> Agg;
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin, 0);
+    const int32_t* ps_supplycost = cpu::col<int32_t>(tin, 1);
+    Agg ht1 = cpu::groupBy<int32_t, int32_t>(
+        tin.getNumRow(),
+        [&](Agg& h, size_t i) {
+            int32_t& v = h.emplace(ps_partkey[i], ps_supplycost[i]);
+            v = std::min(v, ps_supplycost[i]);
+        },
+        [](int32_t& a, const int32_t& b) { a = std::min(a, b); });
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt32(r, 1, it.second);
-        // std::cout<<it.first<<" "<<it.second<<std::endl;
+    ht1.forEach([&](const int32_t& k, int32_t& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt32(r, 1, v);
+        // std::cout<<k<<" "<<v<<std::endl;
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q2GroupBy" << std::endl;
 }
 // t7
-struct KeyA {
-    int32_t p_partkey;
-    int32_t ps_supplycost;
-    bool operator==(const KeyA& other) const {
-        return (p_partkey == other.p_partkey) && (ps_supplycost == other.ps_supplycost);
-    }
-};
-namespace std {
-template <>
-struct hash<KeyA> {
-    std::size_t operator()(const KeyA& k) const {
-        using std::size_t;
-        using std::hash;
-        return (hash<int>()(k.p_partkey)) + (hash<int>()(k.ps_supplycost));
-    }
-};
-};
-struct KeyV1 {
-    int32_t p_rowid; // pmf
-    int32_t s_rowid;
-    int32_t n_rowid;
-};
 void q2Join_t5_t6(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<KeyA, KeyV1> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t p_partkey = tin1.getInt32(i, 0);
-        int32_t ps_supplycost = tin1.getInt32(i, 1);
-        int32_t p_rowid = tin1.getInt32(i, 2);
-        int32_t s_rowid = tin1.getInt32(i, 3);
-        int32_t n_rowid = tin1.getInt32(i, 4);
-        //        std::cout<<p_partkey<<" "<<ps_supplycost<<std::endl;
-        KeyA keya{p_partkey, ps_supplycost};
-        KeyV1 keyv1{p_rowid, s_rowid, n_rowid};
-        ht1.insert(std::make_pair(keya, keyv1));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t ps_partkey = tin2.getInt32(i, 0);
-        int32_t min_ps_supplycost = tin2.getInt32(i, 1);
-        // std::cout<<ps_partkey<<" "<<min_ps_supplycost<<std::endl;
-        auto its = ht1.equal_range(KeyA{ps_partkey, min_ps_supplycost});
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t p_rowid = it->second.p_rowid;
-            int32_t s_rowid = it->second.s_rowid;
-            int32_t n_rowid = it->second.n_rowid;
-            tout.setInt32(r, 0, ps_partkey);
-            tout.setInt32(r, 1, p_rowid);
-            tout.setInt32(r, 2, s_rowid);
-            tout.setInt32(r, 3, n_rowid);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* ps_supplycost = cpu::col<int32_t>(tin1, 1);
+    const int32_t* p_rowid = cpu::col<int32_t>(tin1, 2);
+    const int32_t* s_rowid = cpu::col<int32_t>(tin1, 3);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin1, 4);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return cpu::key2(p_partkey[i], ps_supplycost[i]); });
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* min_ps_supplycost = cpu::col<int32_t>(tin2, 1);
+    std::vector<cpu::Match> m =
+        ht1.join(nrow2, [&](uint32_t i) { return cpu::key2(ps_partkey[i], min_ps_supplycost[i]); });
+    int32_t* o_partkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_prowid = cpu::col<int32_t>(tout, 1);
+    int32_t* o_srowid = cpu::col<int32_t>(tout, 2);
+    int32_t* o_nrowid = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        o_partkey[r] = ps_partkey[m[r].probe];
+        o_prowid[r] = p_rowid[m[r].build];
+        o_srowid[r] = s_rowid[m[r].build];
+        o_nrowid[r] = n_rowid[m[r].build];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q2Join_t5_t6" << std::endl;
 }
 void q2Join_t6_t5(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<KeyA, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t ps_partkey = tin1.getInt32(i, 0);
-        int32_t min_ps_supplycost = tin1.getInt32(i, 1);
-
-        KeyA keya{ps_partkey, min_ps_supplycost};
-        ht1.insert(std::make_pair(keya, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t p_partkey = tin2.getInt32(i, 0);
-        int32_t ps_supplycost = tin2.getInt32(i, 1);
-        int32_t p_rowid = tin2.getInt32(i, 2);
-        int32_t s_rowid = tin2.getInt32(i, 3);
-        int32_t n_rowid = tin2.getInt32(i, 4);
-        auto its = ht1.equal_range(KeyA{p_partkey, ps_supplycost});
-        auto it = its.first;
-        while (it != its.second) {
-            tout.setInt32(r, 0, p_partkey);
-            tout.setInt32(r, 1, p_rowid);
-            tout.setInt32(r, 2, s_rowid);
-            tout.setInt32(r, 3, n_rowid);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* min_ps_supplycost = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return cpu::key2(ps_partkey[i], min_ps_supplycost[i]); });
+    const int32_t* p_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* ps_supplycost = cpu::col<int32_t>(tin2, 1);
+    const int32_t* p_rowid = cpu::col<int32_t>(tin2, 2);
+    const int32_t* s_rowid = cpu::col<int32_t>(tin2, 3);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin2, 4);
+    std::vector<cpu::Match> m =
+        ht1.join(nrow2, [&](uint32_t i) { return cpu::key2(p_partkey[i], ps_supplycost[i]); });
+    int32_t* o_partkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_prowid = cpu::col<int32_t>(tout, 1);
+    int32_t* o_srowid = cpu::col<int32_t>(tout, 2);
+    int32_t* o_nrowid = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        o_partkey[r] = p_partkey[m[r].probe];
+        o_prowid[r] = p_rowid[m[r].probe];
+        o_srowid[r] = s_rowid[m[r].probe];
+        o_nrowid[r] = n_rowid[m[r].probe];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q2Join_t5_t6" << std::endl;
 }
@@ -13,17 +13,13 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 void q3FilterC(Table& tin, Table& tout) {
-    int r = 0;
     int nrow = tin.getNumRow();
-    for (int i = 0; i < nrow; ++i) {
-        int32_t c_custkey = tin.getInt32(i, 0);
-        std::array<char, TPCH_READ_MAXAGG_LEN + 1> c_mktsegment = tin.getcharN<char, TPCH_READ_MAXAGG_LEN + 1>(i, 1);
-        if (!strcmp(c_mktsegment.data(), "BUILDING")) {
-            tout.setInt32(r, 0, c_custkey);
-            ++r;
-        }
-    }
+    cpu::SelVec sel = cpu::select(
+        nrow, [&](uint32_t i) { return !strcmp(cpu::str<TPCH_READ_MAXAGG_LEN + 1>(tin, 1, i), "BUILDING"); });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
 }
 
@@ -47,33 +43,24 @@ struct hash<Q3GroupKey> {
 };
 }
 void q3GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<Q3GroupKey, int64_t> m;
-
-    unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t l_orderkey = tin.getInt32(i, 0); // index much patMatch YAML
-        int32_t o_orderdate = tin.getInt32(i, 1);
-        int32_t o_shippriority = tin.getInt32(i, 2);
-        int32_t eval0 = tin.getInt32(i, 3);
-        int32_t r = eval0;
-        Q3GroupKey k{l_orderkey, o_orderdate, o_shippriority};
-        auto it = m.find(k);
-        if (it != m.end()) {
-            int64_t s = it->second + r;
-            m[k] = s; // update
-        } else {
-            m.insert(std::make_pair(k, r));
-        }
-    }
+    typedef cpu::HashAgg<Q3GroupKey, int64_t> Agg;
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin, 0); // index much patMatch YAML
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin, 1);
+    const int32_t* o_shippriority = cpu::col<int32_t>(tin, 2);
+    const int32_t* eval0 = cpu::col<int32_t>(tin, 3);
+    Agg m = cpu::groupBy<Q3GroupKey, int64_t>(
+        tin.getNumRow(),
+        [&](Agg& h, size_t i) { h[Q3GroupKey{l_orderkey[i], o_orderdate[i], o_shippriority[i]}] += eval0[i]; },
+        [](int64_t& a, const int64_t& b) { a += b; });
 
     int r = 0;
-    for (auto& it : m) {
-        tout.setInt32(r, 0, it.first.k1);
-        tout.setInt32(r, 1, it.first.k2);
-        tout.setInt32(r, 2, it.first.k3);
-        tout.setInt64(r, 3, it.second);
+    m.forEach([&](const Q3GroupKey& k, int64_t& v) {
+        tout.setInt32(r, 0, k.k1);
+        tout.setInt32(r, 1, k.k2);
+        tout.setInt32(r, 2, k.k3);
+        tout.setInt64(r, 3, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
 }
 void q3Sort(Table& tin, Table& tout) {
@@ -126,92 +113,53 @@ void q3Print(Table& tin) {
 }
 void q3Join_C_O1(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
+    const int32_t* c_custkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return c_custkey[i]; });
     std::cout << std::dec << ht1.size() << "  q3Join_C_O1" << std::endl;
-    struct KeyC {
-        int32_t o_orderkey;
-        int32_t o_custkey;
-        int32_t o_orderdate;
-        int32_t o_shippriority;
-    };
-    std::vector<KeyC> ht2;
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; ++i) {
-        int o_orderdate = tin2.getInt32(i, 2);
-        if (o_orderdate < 19950315) {
-            int o_orderkey = tin2.getInt32(i, 0);
-            int o_custkey = tin2.getInt32(i, 1);
-            int o_shippriority = tin2.getInt32(i, 3);
-            ht2.push_back(KeyC{o_orderkey, o_custkey, o_orderdate, o_shippriority});
-        }
-    }
-    // std::cout<<std::dec<<ht2.size()<<"  q3Join_C_O1"<<std::endl;
-    int r = 0;
-    for (size_t i = 0; i < ht2.size(); i++) {
-        int o_custkey = ht2[i].o_custkey;
-        auto it = ht1.find(o_custkey);
-        if (it != ht1.end()) {
-            int o_orderdate = ht2[i].o_orderdate;
-            int o_shippriority = ht2[i].o_shippriority;
-            int o_orderkey = ht2[i].o_orderkey;
-            tout.setInt32(r, 0, o_orderdate);
-            tout.setInt32(r, 1, o_shippriority);
-            tout.setInt32(r, 2, o_orderkey);
-            r++;
-        }
-    }
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* o_custkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin2, 2);
+    const int32_t* o_shippriority = cpu::col<int32_t>(tin2, 3);
+    // semi join, every order is taken at most once
+    cpu::SelVec sel = cpu::select(
+        nrow2, [&](uint32_t i) { return o_orderdate[i] < 19950315 && ht1.contains(o_custkey[i]); });
+    cpu::gather(o_orderdate, sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(o_shippriority, sel, cpu::col<int32_t>(tout, 1));
+    cpu::gather(o_orderkey, sel, cpu::col<int32_t>(tout, 2));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " out q3Join_C_O1" << std::endl;
 }
 
 void q3Join_C_O2(Table& tin1, Table& tin2, Table& tout) {
-    struct KeyA {
-        int32_t o_orderdate;
-        int32_t o_shippriority;
-    };
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, KeyA> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 2), KeyA{tin1.getInt32(i, 0), tin1.getInt32(i, 1)}));
-    }
-    struct KeyC {
-        int32_t l_orderkey;
-        int32_t l_extendedprice;
-        int32_t l_discount;
-        int32_t l_shipdate;
-    };
-    std::vector<KeyC> ht2;
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin1, 0);
+    const int32_t* o_shippriority = cpu::col<int32_t>(tin1, 1);
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return o_orderkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; ++i) {
-        int l_shipdate = tin2.getInt32(i, 3);
-        if (l_shipdate > 19950315) {
-            int l_orderkey = tin2.getInt32(i, 0);
-            int l_extendedprice = tin2.getInt32(i, 1);
-            int l_discount = tin2.getInt32(i, 2);
-            ht2.push_back(KeyC{l_orderkey, l_extendedprice, l_discount, l_shipdate});
-        }
-    }
-    std::cout << std::dec << ht2.size() << " q3Join_C_O2" << std::endl;
-    int r = 0;
-    for (size_t i = 0; i < ht2.size(); i++) {
-        int l_orderkey = ht2[i].l_orderkey;
-        auto it = ht1.find(l_orderkey);
-        if (it != ht1.end()) {
-            int o_orderdate = it->second.o_orderdate;
-            int o_shippriority = it->second.o_shippriority;
-            int32_t l_extendedprice = ht2[i].l_extendedprice;
-            int32_t l_discount = ht2[i].l_discount;
-            int eval0 = (-l_discount + 100) * l_extendedprice;
-            tout.setInt32(r, 0, l_orderkey);
-            tout.setInt32(r, 1, o_orderdate);
-            tout.setInt32(r, 2, o_shippriority);
-            tout.setInt32(r, 3, eval0);
-            r++;
-        }
-    }
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_discount = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin2, 3);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return l_shipdate[i] > 19950315; });
+    std::cout << std::dec << sel.size() << " q3Join_C_O2" << std::endl;
+    std::vector<cpu::Match> m = ht1.join(sel, [&](uint32_t i) { return l_orderkey[i]; });
+    int32_t* t_orderkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_orderdate = cpu::col<int32_t>(tout, 1);
+    int32_t* t_shippriority = cpu::col<int32_t>(tout, 2);
+    int32_t* t_eval0 = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        t_orderkey[r] = l_orderkey[i];
+        t_orderdate[r] = o_orderdate[m[r].build];
+        t_shippriority[r] = o_shippriority[m[r].build];
+        t_eval0[r] = (-l_discount[i] + 100) * l_extendedprice[i];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " out q3Join_C_O2" << std::endl;
 }
@@ -13,74 +13,50 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // t1 //t6
 void q4SemiJoin_o_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
     std::cout << std::dec << nrow1 << " " << std::endl;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t l_commitdate = tin1.getInt32(i, 1);
-        int32_t l_receiptdate = tin1.getInt32(i, 2);
-        int32_t l_orderkey = tin1.getInt32(i, 0);
-        if (l_commitdate < l_receiptdate) {
-            ht1.insert(std::make_pair(l_orderkey, 0));
-        }
-    }
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* l_commitdate = cpu::col<int32_t>(tin1, 1);
+    const int32_t* l_receiptdate = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(cpu::select(nrow1, [&](uint32_t i) { return l_commitdate[i] < l_receiptdate[i]; }),
+              [&](uint32_t i) { return l_orderkey[i]; });
     // std::cout<<std::dec<<ht1.size()<<" In q4"<<std::endl;
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t o_orderkey = tin2.getInt32(i, 1);
-        int32_t o_orderdate = tin2.getInt32(i, 2);
-        if ((o_orderdate >= 19930701 && o_orderdate < 19931001) && ht1.find(o_orderkey) != ht1.end()) {
-            int32_t o_rowid = tin2.getInt32(i, 3);
-            tout.setInt32(r, 0, o_rowid);
-            r++;
-        }
-    }
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin2, 2);
+    const int32_t* o_rowid = cpu::col<int32_t>(tin2, 3);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) {
+        return (o_orderdate[i] >= 19930701 && o_orderdate[i] < 19931001) && ht1.contains(o_orderkey[i]);
+    });
+    cpu::gather(o_rowid, sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q4SemiJoin_o_l" << std::endl;
 }
 
-struct q4GroupKey {
-    std::string o_orderpriority;
-    bool operator==(const q4GroupKey& other) const { return (o_orderpriority == other.o_orderpriority); }
-};
-namespace std {
-template <>
-struct hash<q4GroupKey> {
-    std::size_t operator()(const q4GroupKey& k) const {
-        using std::size_t;
-        using std::hash;
-        using std::string;
-        return (hash<string>()(k.o_orderpriority));
-    }
-};
-}
 void q4GroupBy(Table& tin, Table& origin, Table& tout) {
-    std::unordered_map<q4GroupKey, int64_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t o_rowid = tin.getInt32(i, 0);
-        std::array<char, TPCH_READ_MAXAGG_LEN + 1> orderpriority =
-            origin.getcharN<char, TPCH_READ_MAXAGG_LEN + 1>(o_rowid, 0);
-        // if(i<10) std::cout<<std::dec<<o_rowid<<" "<<orderpriority.data()<<std::endl;
-        q4GroupKey k{std::string(orderpriority.data())};
-        auto it = ht1.find(k);
-        if (it != ht1.end()) {
-            int64_t s = it->second + 1;
-            ht1[k] = s;
-        } else {
-            ht1.insert(std::make_pair(k, 1));
-        }
-    }
+    typedef cpu::StrKey<TPCH_READ_MAXAGG_LEN + 1> q4GroupKey;
+    typedef cpu::HashAgg<q4GroupKey, int64_t, cpu::StrKeyHash> Agg;
+    const int32_t* o_rowid = cpu::col<int32_t>(tin, 0);
+    Agg ht1 = cpu::groupBy<q4GroupKey, int64_t, cpu::StrKeyHash>(
+        tin.getNumRow(),
+        [&](Agg& h, size_t i) {
+            // if(i<10) std::cout<<std::dec<<o_rowid[i]<<" "<<orderpriority<<std::endl;
+            h[q4GroupKey(cpu::str<TPCH_READ_MAXAGG_LEN + 1>(origin, 0, o_rowid[i]))]++;
+        },
+        [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
+    ht1.forEach([&](const q4GroupKey& k, int64_t& v) {
         std::array<char, TPCH_READ_MAXAGG_LEN + 1> orderpriority{};
-        memcpy(orderpriority.data(), (it.first.o_orderpriority).data(), (it.first.o_orderpriority).length());
+        memcpy(orderpriority.data(), k.s, TPCH_READ_MAXAGG_LEN + 1);
         tout.setcharN<char, TPCH_READ_MAXAGG_LEN + 1>(r, 0, orderpriority);
-        tout.setInt64(r, 1, it.second);
+        tout.setInt64(r, 1, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q4GroupBy" << std::endl;
 }
@@ -168,6 +168,8 @@ int main(int argc, const char* argv[]) {
     cfgCmd cfgcmds[2];
     cfgcmds[0].allocateHost();
     get_cfg_dat_1(cfgcmds[0].cmd);
+    // partition of the probe table only keeps rows which may find a match in the build table
+    cfgcmds[0].setBloomFilter(true);
     cfgcmds[1].allocateHost();
     get_cfg_dat_1(cfgcmds[1].cmd);
 
@@ -285,7 +287,9 @@ int main(int argc, const char* argv[]) {
 
         kernelInd++;
 
-        krnlstep[kernelInd].run(0, &(eventsh2d_write[0 + NumSweep * k]), &(events[0 + 2 * k][1]));
+        // the probe partition reads the bloom filter made by the build partition
+        std::vector<cl::Event> bf_events(1, events[0 + 2 * k][0]);
+        krnlstep[kernelInd].run(0, &bf_events, &(events[0 + 2 * k][1]));
 
         kernelInd++;
         for (int i = 0; i < hjTimes; i++) {
@@ -14,31 +14,22 @@
  * limitations under the License.
  */
 #include <regex>
+#include "cpu_engine.hpp"
 // t1:5
 void q5Join_r_n(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        std::array<char, TPCH_READ_REGION_LEN + 1> r_name = tin1.getcharN<char, TPCH_READ_REGION_LEN + 1>(i, 1);
-        if (!strcmp("ASIA", r_name.data())) {
-            // if(!strcmp("ASIA",r_name.data())){
-            int32_t r_regionkey = tin1.getInt32(i, 0);
-            ht1.insert(std::make_pair(r_regionkey, 0));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t n_regionkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(n_regionkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t n_nationkey = tin2.getInt32(i, 1);
-            tout.setInt32(r, 0, n_nationkey);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* r_regionkey = cpu::col<int32_t>(tin1, 0);
+    cpu::SelVec sel = cpu::select(
+        nrow1, [&](uint32_t i) { return !strcmp("ASIA", cpu::str<TPCH_READ_REGION_LEN + 1>(tin1, 1, i)); });
+    cpu::HashJoin ht1;
+    ht1.build(sel, [&](uint32_t i) { return r_regionkey[i]; });
+    const int32_t* n_regionkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin2, 1);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return n_regionkey[i]; });
+    int32_t* o_nationkey = cpu::col<int32_t>(tout, 0);
+    cpu::parallelFor(m.size(), [&](size_t r) { o_nationkey[r] = n_nationkey[m[r].probe]; });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q5Join_r_n" << std::endl;
 }
@@ -47,25 +38,20 @@ void q5Join_r_n(Table& tin1, Table& tin2, Table& tout) {
 // s_nationkey,s_suppkey,s_rowid(s_acctbal,s_name,s_address,s_phone,s_comment)
 void q5Join_t1_c(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t n_nationkey = tin1.getInt32(i, 0);
-        ht1.insert(std::make_pair(n_nationkey, 0));
-    }
-    int r = 0;
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t c_nationkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(c_nationkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t c_custkey = tin2.getInt32(i, 1);
-            tout.setInt32(r, 0, c_custkey);
-            tout.setInt32(r, 1, c_nationkey);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* c_nationkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* c_custkey = cpu::col<int32_t>(tin2, 1);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return c_nationkey[i]; });
+    int32_t* o_custkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_nationkey = cpu::col<int32_t>(tout, 1);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        o_custkey[r] = c_custkey[m[r].probe];
+        o_nationkey[r] = c_nationkey[m[r].probe];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q5Join_t1_c" << std::endl;
 }
@@ -74,28 +60,23 @@ void q5Join_t1_c(Table& tin1, Table& tin2, Table& tout) {
 void q5Join_t2_o(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t c_custkey = tin1.getInt32(i, 0);
-        int32_t c_nationkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(c_custkey, c_nationkey));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t o_custkey = tin2.getInt32(i, 0);
-        int32_t o_orderkey = tin2.getInt32(i, 1);
-        int32_t o_orderdate = tin2.getInt32(i, 2);
-        if (o_orderdate >= 19940101 && o_orderdate < 19950101) {
-            auto its = ht1.equal_range(o_custkey);
-            auto it = its.first;
-            while (it != its.second) {
-                tout.setInt32(r, 0, o_orderkey);
-                tout.setInt32(r, 1, it->second);
-                it++;
-                r++;
-            }
-        }
-    }
+    const int32_t* c_custkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* c_nationkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return c_custkey[i]; });
+    const int32_t* o_custkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin2, 2);
+    cpu::SelVec sel =
+        cpu::select(nrow2, [&](uint32_t i) { return o_orderdate[i] >= 19940101 && o_orderdate[i] < 19950101; });
+    std::vector<cpu::Match> m = ht1.join(sel, [&](uint32_t i) { return o_custkey[i]; });
+    int32_t* t_orderkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 1);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_orderkey[r] = o_orderkey[m[r].probe];
+        t_nationkey[r] = c_nationkey[m[r].build];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q5Join_t2_o" << std::endl;
 }
@@ -103,142 +84,87 @@ void q5Join_t2_o(Table& tin1, Table& tin2, Table& tout) {
 void q5Join_t3_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_orderkey = tin1.getInt32(i, 0);
-        int32_t c_nationkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(o_orderkey, c_nationkey));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(l_orderkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t l_suppkey = tin2.getInt32(i, 1);
-            int32_t l_extendedprice = tin2.getInt32(i, 2);
-            int32_t l_discount = tin2.getInt32(i, 3);
-            int32_t c_nationkey = it->second;
-            int32_t e = l_extendedprice * (-l_discount + 100);
-            tout.setInt32(r, 0, l_suppkey);
-            tout.setInt32(r, 1, e);
-            tout.setInt32(r, 2, c_nationkey);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* c_nationkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return o_orderkey[i]; });
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_discount = cpu::col<int32_t>(tin2, 3);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return l_orderkey[i]; });
+    int32_t* t_suppkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_e = cpu::col<int32_t>(tout, 1);
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 2);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        t_suppkey[r] = l_suppkey[i];
+        t_e[r] = l_extendedprice[i] * (-l_discount[i] + 100);
+        t_nationkey[r] = c_nationkey[m[r].build];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q5Join_t3_l" << std::endl;
 }
-struct KeyA {
-    int32_t s_suppkey;
-    int32_t s_nationkey;
-    bool operator==(const KeyA& other) const {
-        return (s_suppkey == other.s_suppkey) && (s_nationkey == other.s_nationkey);
-    }
-};
-namespace std {
-template <>
-struct hash<KeyA> {
-    std::size_t operator()(const KeyA& k) const {
-        using std::size_t;
-        using std::hash;
-        using std::string;
-        return (hash<int>()(k.s_suppkey)) + (hash<int>()(k.s_nationkey));
-    }
-};
-}
 void q5Join_s_t4(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
     std::cout << "s_t4:" << nrow1 << " " << nrow2 << std::endl;
-    std::unordered_multimap<KeyA, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t s_suppkey = tin1.getInt32(i, 0);
-        int32_t s_nationkey = tin1.getInt32(i, 1);
-        KeyA keya{s_suppkey, s_nationkey};
-        ht1.insert(std::make_pair(keya, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_suppkey = tin2.getInt32(i, 0);
-        int32_t e = tin2.getInt32(i, 1);
-        int32_t c_nationkey = tin2.getInt32(i, 2);
-        auto its = ht1.equal_range(KeyA{l_suppkey, c_nationkey});
-        auto it = its.first;
-        while (it != its.second) {
-            tout.setInt32(r, 0, e);
-            tout.setInt32(r, 1, c_nationkey);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return cpu::key2(s_suppkey[i], s_nationkey[i]); });
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* e = cpu::col<int32_t>(tin2, 1);
+    const int32_t* c_nationkey = cpu::col<int32_t>(tin2, 2);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return cpu::key2(l_suppkey[i], c_nationkey[i]); });
+    int32_t* t_e = cpu::col<int32_t>(tout, 0);
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 1);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_e[r] = e[m[r].probe];
+        t_nationkey[r] = c_nationkey[m[r].probe];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q5Join_s_t4" << std::endl;
 }
 void q5Join_t5_n(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t e = tin1.getInt32(i, 0);
-        int32_t s_nationkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(s_nationkey, e));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t n_nationkey = tin2.getInt32(i, 1);
-        auto its = ht1.equal_range(n_nationkey);
-        auto it = its.first;
-        while (it != its.second) {
-            std::array<char, TPCH_READ_NATION_LEN + 1> n_name = tin2.getcharN<char, TPCH_READ_NATION_LEN + 1>(i, 2);
-            tout.setInt32(r, 0, it->second);
-            tout.setcharN<char, TPCH_READ_NATION_LEN + 1>(r, 1, n_name);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* e = cpu::col<int32_t>(tin1, 0);
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_nationkey[i]; });
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin2, 1);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return n_nationkey[i]; });
+    int32_t* t_e = cpu::col<int32_t>(tout, 0);
+    char* t_name = cpu::col<char>(tout, 1);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_e[r] = e[m[r].build];
+        memcpy(t_name + r * (TPCH_READ_NATION_LEN + 1), cpu::str<TPCH_READ_NATION_LEN + 1>(tin2, 2, m[r].probe),
+               TPCH_READ_NATION_LEN + 1);
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q5Join_t5_n" << std::endl;
 }
 
-struct q5GroupKey {
-    std::string n_name;
-    bool operator==(const q5GroupKey& other) const { return (n_name == other.n_name); }
-};
-namespace std {
-template <>
-struct hash<q5GroupKey> {
-    std::size_t operator()(const q5GroupKey& k) const {
-        using std::size_t;
-        using std::hash;
-        using std::string;
-        return (hash<string>()(k.n_name));
-    }
-};
-}
 void q5GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<q5GroupKey, int64_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t e = tin.getInt32(i, 0);
-        std::array<char, TPCH_READ_NATION_LEN + 1> n_name = tin.getcharN<char, TPCH_READ_NATION_LEN + 1>(i, 1);
-        q5GroupKey k{std::string(n_name.data())};
-        auto it = ht1.find(k);
-        if (it != ht1.end()) {
-            int64_t s = it->second + e;
-            ht1[k] = s;
-        } else {
-            ht1.insert(std::make_pair(k, e));
-        }
-    }
+    typedef cpu::StrKey<TPCH_READ_NATION_LEN + 1> q5GroupKey;
+    typedef cpu::HashAgg<q5GroupKey, int64_t, cpu::StrKeyHash> Agg;
+    const int32_t* e = cpu::col<int32_t>(tin, 0);
+    Agg ht1 = cpu::groupBy<q5GroupKey, int64_t, cpu::StrKeyHash>(
+        tin.getNumRow(),
+        [&](Agg& h, size_t i) { h[q5GroupKey(cpu::str<TPCH_READ_NATION_LEN + 1>(tin, 1, i))] += e[i]; },
+        [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
+    ht1.forEach([&](const q5GroupKey& k, int64_t& v) {
         std::array<char, TPCH_READ_NATION_LEN + 1> n_name{};
-        memcpy(n_name.data(), (it.first.n_name).data(), (it.first.n_name).length());
+        memcpy(n_name.data(), k.s, TPCH_READ_NATION_LEN + 1);
         tout.setcharN<char, TPCH_READ_NATION_LEN + 1>(r, 0, n_name);
-        tout.setInt64(r, 1, it.second);
+        tout.setInt64(r, 1, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q5GroupBy" << std::endl;
 }
@@ -14,19 +14,34 @@
  * limitations under the License.
  */
 
+#include "cpu_engine.hpp"
+
 void q6(Table& tin1, Table& tout) {
     int nrow = tin1.getNumRow();
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin1, 0);
+    const int32_t* l_discount = cpu::col<int32_t>(tin1, 1);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin1, 2);
+    const int32_t* l_quantity = cpu::col<int32_t>(tin1, 3);
+    std::vector<long long> sums(cpu::threadNum(), 0);
+    std::vector<int> cnts(cpu::threadNum(), 0);
+    auto rowOf = [](size_t i) { return (uint32_t)i; };
+    auto pred = [&](uint32_t i) {
+        return (l_shipdate[i] >= 19940101) & (l_shipdate[i] < 19950101) & (l_discount[i] >= 5) & (l_discount[i] <= 7) &
+               (l_quantity[i] < 24);
+    };
+    cpu::parallelMorsels(nrow, [&](int tid, size_t, size_t b, size_t e) {
+        uint32_t sel[cpu::MORSEL_ROWS];
+        size_t n = cpu::selectMorsel(b, e, rowOf, pred, sel);
+        long long sum = 0;
+        for (size_t k = 0; k < n; k++) sum += (l_extendedprice[sel[k]] * l_discount[sel[k]]);
+        sums[tid] += sum;
+        cnts[tid] += n;
+    });
     long long sum = 0;
     int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        int32_t l_extendedprice = tin1.getInt32(i, 0);
-        int32_t l_discount = tin1.getInt32(i, 1);
-        int32_t l_shipdate = tin1.getInt32(i, 2);
-        int32_t l_quantity = tin1.getInt32(i, 3);
-        if (l_shipdate >= 19940101 && l_shipdate < 19950101 && l_discount >= 5 && l_discount <= 7 && l_quantity < 24) {
-            sum += (l_extendedprice * l_discount);
-            r++;
-        }
+    for (int t = 0; t < cpu::threadNum(); t++) {
+        sum += sums[t];
+        r += cnts[t];
     }
     std::cout << std::dec << sum << " In q6" << std::endl;
     printf("%d\n", r);
@@ -141,6 +141,15 @@ int main(int argc, const char* argv[]) {
     cfgCmd cfgcmds;
     cfgcmds.allocateHost();
     get_q6_cfg(cfgcmds.cmd);
+
+    // filter sees lineitem col 0 to 3, blocks out of its l_shipdate range are not read,
+    // dbgen lineitem is in order key order, so only a time-ordered table gets blocks skipped
+    uint32_t fcfg[45];
+    gen_q6_fcfg(fcfg);
+    const int fcol[4] = {0, 1, 2, 3};
+    size_t nskip = tbs[0].setZoneSkip(fcfg, fcol);
+    std::cout << "Zone map skips " << nskip << " of " << tbs[0].zones[2].blocks() << " blocks of lineitem"
+              << std::endl;
     //  get_cfg_dat(cfgcmds[i].cmd,"./host/q10/join/hexBin.dat",i);
 
     /**
@@ -13,21 +13,19 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // t1 //t6
 void NationFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_NATION_LEN + 1> n_name = tin.getcharN<char, TPCH_READ_NATION_LEN + 1>(i, 1);
-        if (!strcmp("FRANCE", n_name.data()) || !strcmp("GERMANY", n_name.data())) {
-            int32_t n_nationkey = tin.getInt32(i, 0);
-            int32_t n_rowid = i;
-            tout.setInt32(r, 0, n_nationkey);
-            tout.setInt32(r, 1, n_rowid);
-            // tout.setcharN<char,TPCH_READ_NATION_LEN + 1>(r,1,n_name);
-            r++;
-        }
-    }
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        const char* n_name = cpu::str<TPCH_READ_NATION_LEN + 1>(tin, 1, i);
+        return !strcmp("FRANCE", n_name) || !strcmp("GERMANY", n_name);
+    });
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 1);
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, t_nationkey);
+    cpu::parallelFor(sel.size(), [&](size_t r) { t_rowid[r] = sel[r]; });
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In NationFilter" << std::endl;
 }
@@ -36,23 +34,22 @@ void NationFilter(Table& tin, Table& tout) {
 void q7Join_t1_s(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), tin1.getInt32(i, 1)));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t s_nationkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(s_nationkey);
-        if (it != ht1.end()) {
-            int32_t s_suppkey = tin2.getInt32(i, 1);
-            int32_t n_rowid = it->second;
-            tout.setInt32(r, 0, s_nationkey);
-            tout.setInt32(r, 1, n_rowid);
-            tout.setInt32(r, 2, s_suppkey);
-            r++;
-        }
-    }
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin2, 1);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return s_nationkey[i]; });
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 1);
+    int32_t* t_suppkey = cpu::col<int32_t>(tout, 2);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_nationkey[r] = s_nationkey[m[r].probe];
+        t_rowid[r] = n_rowid[m[r].build];
+        t_suppkey[r] = s_suppkey[m[r].probe];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q7Join_t1_s" << std::endl;
 }
@@ -61,107 +58,69 @@ void q7Join_t1_s(Table& tin1, Table& tin2, Table& tout) {
 void q7Join_t2_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    struct Key {
-        int32_t n_nationkey;
-        int32_t n_rowid;
-    };
-
-    std::unordered_map<int32_t, Key> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t n_nationkey = tin1.getInt32(i, 0);
-        int32_t n_rowid = tin1.getInt32(i, 1);
-        int32_t s_suppkey = tin1.getInt32(i, 2);
-        ht1.insert(std::make_pair(s_suppkey, Key{n_nationkey, n_rowid}));
-    }
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin1, 1);
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_suppkey[i]; });
 
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        int32_t l_suppkey = tin2.getInt32(i, 1);
-        int32_t l_shipdate = tin2.getInt32(i, 2);
-        int32_t l_extendedprice = tin2.getInt32(i, 3);
-        int32_t l_discount = tin2.getInt32(i, 4);
-        if (l_shipdate >= 19950101 && l_shipdate <= 19961231) {
-            auto it = ht1.find(l_suppkey);
-            if (it != ht1.end()) {
-                int32_t n_nationkey = it->second.n_nationkey;
-                int32_t n_rowid = it->second.n_rowid;
-                int32_t e = l_extendedprice * (100 - l_discount);
-                tout.setInt32(r, 0, n_nationkey);
-                tout.setInt32(r, 1, n_rowid);
-                tout.setInt32(r, 2, l_orderkey);
-                tout.setInt32(r, 3, l_shipdate);
-                tout.setInt32(r, 4, e);
-                r++;
-            }
-        }
-    }
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin2, 3);
+    const int32_t* l_discount = cpu::col<int32_t>(tin2, 4);
+    cpu::SelVec sel =
+        cpu::select(nrow2, [&](uint32_t i) { return (l_shipdate[i] >= 19950101) & (l_shipdate[i] <= 19961231); });
+    std::vector<cpu::Match> m = ht1.join(sel, [&](uint32_t i) { return l_suppkey[i]; });
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 1);
+    int32_t* t_orderkey = cpu::col<int32_t>(tout, 2);
+    int32_t* t_shipdate = cpu::col<int32_t>(tout, 3);
+    int32_t* t_e = cpu::col<int32_t>(tout, 4);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        t_nationkey[r] = n_nationkey[m[r].build];
+        t_rowid[r] = n_rowid[m[r].build];
+        t_orderkey[r] = l_orderkey[i];
+        t_shipdate[r] = l_shipdate[i];
+        t_e[r] = l_extendedprice[i] * (100 - l_discount[i]);
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q7Join_t2_l" << std::endl;
 }
 
-// t4
-void q7Join_o_t3(Table& tin1, Table& tin2, Table& tout) {
+// t4 and t5, joins on column 2 of tin2 and replaces it with the payload of tin1
+void q7Join_x_t(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_orderkey = tin1.getInt32(i, 0);
-        int32_t o_custkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(o_orderkey, o_custkey));
-    }
+    const int32_t* key1 = cpu::col<int32_t>(tin1, 0);
+    const int32_t* pld1 = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return key1[i]; });
 
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 2);
-        auto it = ht1.find(l_orderkey);
-        if (it != ht1.end()) {
-            int32_t n_nationkey = tin2.getInt32(i, 0);
-            int32_t n_rowid = tin2.getInt32(i, 1);
-            int32_t o_custkey = it->second;
-            int32_t l_shipdate = tin2.getInt32(i, 3);
-            int32_t e = tin2.getInt32(i, 4);
-            tout.setInt32(r, 0, n_nationkey);
-            tout.setInt32(r, 1, n_rowid);
-            tout.setInt32(r, 2, o_custkey);
-            tout.setInt32(r, 3, l_shipdate);
-            tout.setInt32(r, 4, e);
-            r++;
-        }
-    }
-    tout.setNumRow(r);
+    const int32_t* key2 = cpu::col<int32_t>(tin2, 2);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return key2[i]; });
+    for (int c = 0; c < 5; c++) {
+        const int32_t* in = c == 2 ? pld1 : cpu::col<int32_t>(tin2, c);
+        int32_t* out = cpu::col<int32_t>(tout, c);
+        cpu::parallelFor(m.size(), [&](size_t r) { out[r] = in[c == 2 ? m[r].build : m[r].probe]; });
+    }
+    tout.setNumRow(m.size());
+}
+
+// t4
+void q7Join_o_t3(Table& tin1, Table& tin2, Table& tout) {
+    // o_orderkey, o_custkey join n_nationkey, n_rowid, l_orderkey, l_shipdate, e
+    q7Join_x_t(tin1, tin2, tout);
+    int r = tout.getNumRow();
     std::cout << std::dec << r << " In q7Join_o_t3" << std::endl;
 }
 // t5
 void q7Join_c_t4(Table& tin1, Table& tin2, Table& tout) {
-    int nrow1 = tin1.getNumRow();
-    int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t c_custkey = tin1.getInt32(i, 0);
-        int32_t c_nationkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(c_custkey, c_nationkey));
-    }
-
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t o_custkey = tin2.getInt32(i, 2);
-        auto it = ht1.find(o_custkey);
-        if (it != ht1.end()) {
-            int32_t n_nationkey = tin2.getInt32(i, 0);
-            int32_t n_rowid = tin2.getInt32(i, 1);
-            int32_t c_nationkey = it->second;
-            int32_t l_shipdate = tin2.getInt32(i, 3);
-            int32_t e = tin2.getInt32(i, 4);
-            tout.setInt32(r, 0, n_nationkey);
-            tout.setInt32(r, 1, n_rowid);
-            tout.setInt32(r, 2, c_nationkey);
-            tout.setInt32(r, 3, l_shipdate);
-            tout.setInt32(r, 4, e);
-            r++;
-        }
-    }
-    tout.setNumRow(r);
+    // c_custkey, c_nationkey join n_nationkey, n_rowid, o_custkey, l_shipdate, e
+    q7Join_x_t(tin1, tin2, tout);
+    int r = tout.getNumRow();
     std::cout << std::dec << r << " In q7Join_o_t3" << std::endl;
 }
 
@@ -169,41 +128,38 @@ void q7Join_c_t4(Table& tin1, Table& tin2, Table& tout) {
 void q7Join_t6_t5(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t n_nationkey = tin1.getInt32(i, 0);
-        int32_t n_rowid = tin1.getInt32(i, 1);
-        ;
-        ht1.insert(std::make_pair(n_nationkey, n_rowid));
-    }
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
 
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t n_nationkey = tin2.getInt32(i, 0);
-        int32_t n_rowid_t5 = tin2.getInt32(i, 1);
-        int32_t c_nationkey = tin2.getInt32(i, 2);
-        int32_t l_shipdate = tin2.getInt32(i, 3);
-        int32_t e = tin2.getInt32(i, 4);
-        if (n_nationkey != c_nationkey) {
-            auto it = ht1.find(c_nationkey);
-            if (it != ht1.end()) {
-                int32_t n_rowid_t6 = it->second;
-                tout.setInt32(r, 0, n_rowid_t5);
-                tout.setInt32(r, 1, n_rowid_t6);
-                tout.setInt32(r, 2, l_shipdate);
-                tout.setInt32(r, 3, e);
-                r++;
-            }
-        }
-    }
+    const int32_t* t5_nationkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* n_rowid_t5 = cpu::col<int32_t>(tin2, 1);
+    const int32_t* c_nationkey = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin2, 3);
+    const int32_t* e = cpu::col<int32_t>(tin2, 4);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return t5_nationkey[i] != c_nationkey[i]; });
+    std::vector<cpu::Match> m = ht1.join(sel, [&](uint32_t i) { return c_nationkey[i]; });
+    int32_t* t_rowid_t5 = cpu::col<int32_t>(tout, 0);
+    int32_t* t_rowid_t6 = cpu::col<int32_t>(tout, 1);
+    int32_t* t_shipdate = cpu::col<int32_t>(tout, 2);
+    int32_t* t_e = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        t_rowid_t5[r] = n_rowid_t5[i];
+        t_rowid_t6[r] = n_rowid[m[r].build];
+        t_shipdate[r] = l_shipdate[i];
+        t_e[r] = e[i];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q7Join_t6_t5" << std::endl;
 }
 
 // t8
 struct q7GroupBy {
-    std::string supp_nation; // int32_t n_rowid_t5;
-    std::string cust_nation; // int32_t n_rowid_t6;
+    cpu::StrKey<TPCH_READ_NATION_LEN + 1> supp_nation; // int32_t n_rowid_t5;
+    cpu::StrKey<TPCH_READ_NATION_LEN + 1> cust_nation; // int32_t n_rowid_t6;
     int32_t l_shipdate;
     bool operator==(const q7GroupBy& other) const {
         return (supp_nation == other.supp_nation) && (cust_nation == other.cust_nation) &&
@@ -214,46 +170,38 @@ namespace std {
 template <>
 struct hash<q7GroupBy> {
     std::size_t operator()(const q7GroupBy& k) const {
-        using std::size_t;
-        using std::hash;
-        using std::string;
-        return (hash<string>()(k.supp_nation)) + (hash<string>()(k.cust_nation)) + (hash<int>()(k.l_shipdate));
+        return (cpu::StrKeyHash()(k.supp_nation) * 31 + cpu::StrKeyHash()(k.cust_nation)) * 31 + k.l_shipdate;
     }
 };
 }
 void q7Group(Table& tin, Table& origin, Table& tout) {
-    std::unordered_map<q7GroupBy, int64_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t n_rowid_t5 = tin.getInt32(i, 0);
-        int32_t n_rowid_t6 = tin.getInt32(i, 1);
-        int32_t l_shipdate = tin.getInt32(i, 2) / 10000;
-        int32_t e = tin.getInt32(i, 3);
-        std::array<char, TPCH_READ_NATION_LEN + 1> supp_nation =
-            origin.getcharN<char, TPCH_READ_NATION_LEN + 1>(n_rowid_t5, 1);
-        std::array<char, TPCH_READ_NATION_LEN + 1> cust_nation =
-            origin.getcharN<char, TPCH_READ_NATION_LEN + 1>(n_rowid_t6, 1);
-        q7GroupBy k{std::string(supp_nation.data()), std::string(cust_nation.data()), l_shipdate};
-        auto it = ht1.find(k);
-        if (it != ht1.end()) {
-            int64_t s = it->second + e;
-            ht1[k] = s;
-        } else {
-            ht1.insert(std::make_pair(k, e));
-        }
-    }
+    typedef cpu::HashAgg<q7GroupBy, int64_t> Agg;
+    const int32_t* n_rowid_t5 = cpu::col<int32_t>(tin, 0);
+    const int32_t* n_rowid_t6 = cpu::col<int32_t>(tin, 1);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin, 2);
+    const int32_t* e = cpu::col<int32_t>(tin, 3);
+    auto nation = [&](int32_t rowid) {
+        return cpu::StrKey<TPCH_READ_NATION_LEN + 1>(cpu::str<TPCH_READ_NATION_LEN + 1>(origin, 1, rowid));
+    };
+    Agg ht1 = cpu::groupBy<q7GroupBy, int64_t>(
+        tin.getNumRow(),
+        [&](Agg& h, size_t i) {
+            h[q7GroupBy{nation(n_rowid_t5[i]), nation(n_rowid_t6[i]), l_shipdate[i] / 10000}] += e[i];
+        },
+        [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
+    ht1.forEach([&](const q7GroupBy& k, int64_t& v) {
         std::array<char, TPCH_READ_NATION_LEN + 1> supp_nation{};
         std::array<char, TPCH_READ_NATION_LEN + 1> cust_nation{};
-        memcpy(supp_nation.data(), it.first.supp_nation.data(), it.first.supp_nation.length());
-        memcpy(cust_nation.data(), it.first.cust_nation.data(), it.first.cust_nation.length());
+        memcpy(supp_nation.data(), k.supp_nation.s, TPCH_READ_NATION_LEN + 1);
+        memcpy(cust_nation.data(), k.cust_nation.s, TPCH_READ_NATION_LEN + 1);
         tout.setcharN<char, TPCH_READ_NATION_LEN + 1>(r, 0, supp_nation);
         tout.setcharN<char, TPCH_READ_NATION_LEN + 1>(r, 1, cust_nation);
-        tout.setInt32(r, 2, it.first.l_shipdate);
-        tout.setInt64(r, 3, it.second);
-        //        if(r<10) std::cout<<it.second<<std::endl;
+        tout.setInt32(r, 2, k.l_shipdate);
+        tout.setInt64(r, 3, v);
+        //        if(r<10) std::cout<<v<<std::endl;
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q7GroupBy" << std::endl;
 }
@@ -13,30 +13,22 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // t1:5 rows
 // select count(*) from region,nation,customer where n_regionkey = r_regionkey and r_name = 'AMERICA' and c_nationkey =
 // n_nationkey
 void q8Join_r_n(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        std::array<char, TPCH_READ_REGION_LEN + 1> r_name = tin1.getcharN<char, TPCH_READ_REGION_LEN + 1>(i, 1);
-        if (!strcmp("AMERICA", r_name.data())) {
-            int32_t r_regionkey = tin1.getInt32(i, 0);
-            ht1.insert(std::make_pair(r_regionkey, 0));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t n_regionkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(n_regionkey);
-        if (it != ht1.end()) {
-            int32_t n_nationkey = tin2.getInt32(i, 1);
-            tout.setInt32(r, 0, n_nationkey);
-            r++;
-        }
-    }
+    const int32_t* r_regionkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    cpu::SelVec sel1 = cpu::select(
+        nrow1, [&](uint32_t i) { return !strcmp("AMERICA", cpu::str<TPCH_READ_REGION_LEN + 1>(tin1, 1, i)); });
+    ht1.build(sel1, [&](uint32_t i) { return r_regionkey[i]; });
+    const int32_t* n_regionkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(n_regionkey[i]); });
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Join_r_n" << std::endl;
 }
@@ -46,21 +38,14 @@ void q8Join_r_n(Table& tin1, Table& tin2, Table& tout) {
 // n_nationkey;
 void q8Join_t1_c(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
-    int r = 0;
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t c_nationkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(c_nationkey);
-        if (it != ht1.end()) {
-            int32_t c_custkey = tin2.getInt32(i, 1);
-            tout.setInt32(r, 0, c_custkey);
-            r++;
-        }
-    }
+    const int32_t* c_nationkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(c_nationkey[i]); });
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Join_t1_c" << std::endl;
 }
@@ -71,29 +56,20 @@ void q8Join_t1_c(Table& tin1, Table& tin2, Table& tout) {
 void q8Join_t2_o(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
     std::cout << std::dec << nrow1 << " " << nrow2 << std::endl;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t c_custkey = tin1.getInt32(i, 0);
-        ht1.insert(std::make_pair(c_custkey, 0));
-    }
+    const int32_t* c_custkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return c_custkey[i]; });
 
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        //        std::cout<<i<<std::endl;
-        int32_t o_orderdate = tin2.getInt32(i, 2);
-        if (o_orderdate >= 19950101 && o_orderdate <= 19961231) {
-            int32_t o_custkey = tin2.getInt32(i, 0);
-            int32_t o_orderkey = tin2.getInt32(i, 1);
-            auto it = ht1.find(o_custkey);
-            if (it != ht1.end()) {
-                tout.setInt32(r, 0, o_orderkey);
-                tout.setInt32(r, 1, o_orderdate);
-                // if(r<10) std::cout<<std::dec<<tout.getInt32(r,0)<<" "<<tout.getInt32(r,1)<<std::endl;
-                r++;
-            }
-        }
-    }
+    const int32_t* o_custkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin2, 2);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) {
+        return o_orderdate[i] >= 19950101 && o_orderdate[i] <= 19961231 && ht1.contains(o_custkey[i]);
+    });
+    cpu::gather(o_orderkey, sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(o_orderdate, sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
 
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Join_t2_o" << std::endl;
@@ -111,32 +87,29 @@ void q8Join_t2_o(Table& tin1, Table& tin2, Table& tout) {
 void q8Join_t3_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_orderkey = tin1.getInt32(i, 0);
-        int32_t o_orderdate = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(o_orderkey, o_orderdate));
-    }
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return o_orderkey[i]; });
 
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(l_orderkey);
-        if (it != ht1.end()) {
-            int32_t l_partkey = tin2.getInt32(i, 1);
-            int32_t l_suppkey = tin2.getInt32(i, 2);
-            int32_t l_extendedprice = tin2.getInt32(i, 3);
-            int32_t l_discount = tin2.getInt32(i, 4);
-            int32_t o_orderdate = it->second;
-            int32_t e = l_extendedprice * (100 - l_discount);
-            tout.setInt32(r, 0, l_partkey);
-            tout.setInt32(r, 1, l_suppkey);
-            tout.setInt32(r, 2, e);
-            tout.setInt32(r, 3, o_orderdate);
-            // if(r<10) std::cout<<std::dec<<tout.getInt32(r,0)<<std::endl;
-            r++;
-        }
-    }
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_partkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin2, 3);
+    const int32_t* l_discount = cpu::col<int32_t>(tin2, 4);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return l_orderkey[i]; });
+    int32_t* t_partkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_suppkey = cpu::col<int32_t>(tout, 1);
+    int32_t* t_e = cpu::col<int32_t>(tout, 2);
+    int32_t* t_orderdate = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        t_partkey[r] = l_partkey[i];
+        t_suppkey[r] = l_suppkey[i];
+        t_e[r] = l_extendedprice[i] * (100 - l_discount[i]);
+        t_orderdate[r] = o_orderdate[m[r].build];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Join_t3_l" << std::endl;
 }
@@ -144,15 +117,11 @@ void q8Join_t3_l(Table& tin1, Table& tin2, Table& tout) {
 // select count(*) from part where p_type = 'ECONOMY ANODIZED STEEL';
 void q8Filter_p(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_TYPE_LEN + 1> p_type = tin.getcharN<char, TPCH_READ_P_TYPE_LEN + 1>(i, 1);
-        if (!strcmp("ECONOMY ANODIZED STEEL", p_type.data())) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            tout.setInt32(r, 0, p_partkey);
-            r++;
-        }
-    }
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        return !strcmp("ECONOMY ANODIZED STEEL", cpu::str<TPCH_READ_P_TYPE_LEN + 1>(tin, 1, i));
+    });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Filter_p" << std::endl;
 }
@@ -164,26 +133,15 @@ void q8Filter_p(Table& tin, Table& tout) {
 void q8Join_t5_t4(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t p_partkey = tin1.getInt32(i, 0);
-        ht1.insert(std::make_pair(p_partkey, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_partkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(l_partkey);
-        if (it != ht1.end()) {
-            int32_t l_suppkey = tin2.getInt32(i, 1);
-            int32_t e = tin2.getInt32(i, 2);
-            int32_t o_orderdate = tin2.getInt32(i, 3);
-            tout.setInt32(r, 0, l_suppkey);
-            tout.setInt32(r, 1, e);
-            tout.setInt32(r, 2, o_orderdate);
-            if (r < 10) std::cout << std::dec << l_suppkey << " " << o_orderdate << std::endl;
-            r++;
-        }
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return p_partkey[i]; });
+    const int32_t* l_partkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(l_partkey[i]); });
+    for (int c = 0; c < 3; c++) cpu::gather(cpu::col<int32_t>(tin2, c + 1), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
+    for (int k = 0; k < r && k < 10; k++)
+        std::cout << std::dec << tout.getInt32(k, 0) << " " << tout.getInt32(k, 2) << std::endl;
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Join_t5_t4" << std::endl;
 }
@@ -192,27 +150,24 @@ void q8Join_t5_t4(Table& tin1, Table& tin2, Table& tout) {
 void q8Join_s_t6(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t s_suppkey = tin1.getInt32(i, 0);
-        int32_t s_nationkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(s_suppkey, s_nationkey));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_suppkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(l_suppkey);
-        if (it != ht1.end()) {
-            int32_t s_nationkey = it->second;
-            int32_t e = tin2.getInt32(i, 1);
-            int32_t o_orderdate = tin2.getInt32(i, 2);
-            tout.setInt32(r, 0, s_nationkey);
-            tout.setInt32(r, 1, e);
-            tout.setInt32(r, 2, o_orderdate);
-            if (r < 10) std::cout << std::dec << s_nationkey << " " << o_orderdate << std::endl;
-            r++;
-        }
-    }
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_suppkey[i]; });
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* e = cpu::col<int32_t>(tin2, 1);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin2, 2);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return l_suppkey[i]; });
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_e = cpu::col<int32_t>(tout, 1);
+    int32_t* t_orderdate = cpu::col<int32_t>(tout, 2);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_nationkey[r] = s_nationkey[m[r].build];
+        t_e[r] = e[m[r].probe];
+        t_orderdate[r] = o_orderdate[m[r].probe];
+    });
+    int r = m.size();
+    for (int k = 0; k < r && k < 10; k++) std::cout << std::dec << t_nationkey[k] << " " << t_orderdate[k] << std::endl;
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Join_s_t6" << std::endl;
 }
@@ -220,77 +175,61 @@ void q8Join_s_t6(Table& tin1, Table& tin2, Table& tout) {
 void q8Join_n_t7(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t n_nationkey = tin1.getInt32(i, 1);
-        // int32_t n_rowid = i;//tin1.getInt32(i,1);
-        int32_t n_rowid = tin1.getInt32(i, 3);
-        ht1.insert(std::make_pair(n_nationkey, n_rowid));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t s_nationkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(s_nationkey);
-        if (it != ht1.end()) {
-            int32_t e = tin2.getInt32(i, 1);
-            int32_t o_orderdate = tin2.getInt32(i, 2);
-            int32_t n_rowid = it->second;
-            tout.setInt32(r, 0, e);
-            tout.setInt32(r, 1, o_orderdate / 10000);
-            tout.setInt32(r, 2, n_rowid);
-            r++;
-        }
-    }
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 1);
+    // int32_t n_rowid = i;//tin1.getInt32(i,1);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin1, 3);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* e = cpu::col<int32_t>(tin2, 1);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin2, 2);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return s_nationkey[i]; });
+    int32_t* t_e = cpu::col<int32_t>(tout, 0);
+    int32_t* t_year = cpu::col<int32_t>(tout, 1);
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 2);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_e[r] = e[m[r].probe];
+        t_year[r] = o_orderdate[m[r].probe] / 10000;
+        t_rowid[r] = n_rowid[m[r].build];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Join_n_t7" << std::endl;
 }
 // for siyang tow group_bys
 void q8GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<int32_t, int64_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t e = tin.getInt32(i, 0);
-        int32_t o_year = tin.getInt32(i, 1);
-        auto it = ht1.find(o_year);
-        if (it != ht1.end()) {
-            int64_t s = it->second + e;
-            ht1[o_year] = s;
-        } else {
-            ht1.insert(std::make_pair(o_year, e));
-        }
-    }
+    typedef cpu::HashAgg<int32_t, int64_t> Agg;
+    const int32_t* e = cpu::col<int32_t>(tin, 0);
+    const int32_t* o_year = cpu::col<int32_t>(tin, 1);
+    Agg ht1 = cpu::groupBy<int32_t, int64_t>(tin.getNumRow(), [&](Agg& h, size_t i) { h[o_year[i]] += e[i]; },
+                                              [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt64(r, 1, it.second);
+    ht1.forEach([&](const int32_t& k, int64_t& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt64(r, 1, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
 }
 
 void q8GroupBy_filtern(Table& tin, Table& origin, Table& tout) {
-    std::unordered_map<int32_t, int64_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t e = tin.getInt32(i, 0);
-        int32_t o_year = tin.getInt32(i, 1);
-        int32_t n_rowid = tin.getInt32(i, 2);
-        std::array<char, TPCH_READ_NATION_LEN + 1> n_name = origin.getcharN<char, TPCH_READ_NATION_LEN + 1>(n_rowid, 2);
-        if (strcmp("BRAZIL", n_name.data())) {
-            e = 0;
-        }
-        auto it = ht1.find(o_year);
-        if (it != ht1.end()) {
-            int64_t s = it->second + e;
-            ht1[o_year] = s;
-        } else {
-            ht1.insert(std::make_pair(o_year, e));
-        }
-    }
+    typedef cpu::HashAgg<int32_t, int64_t> Agg;
+    const int32_t* e = cpu::col<int32_t>(tin, 0);
+    const int32_t* o_year = cpu::col<int32_t>(tin, 1);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin, 2);
+    Agg ht1 = cpu::groupBy<int32_t, int64_t>(
+        tin.getNumRow(),
+        [&](Agg& h, size_t i) {
+            bool brazil = !strcmp("BRAZIL", cpu::str<TPCH_READ_NATION_LEN + 1>(origin, 2, n_rowid[i]));
+            h[o_year[i]] += brazil ? e[i] : 0;
+        },
+        [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt64(r, 1, it.second);
+    ht1.forEach([&](const int32_t& k, int64_t& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt64(r, 1, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
 }
 
@@ -300,34 +239,31 @@ void q8GroupBy_all(Table& tin, Table& origin, Table& tout) {
         int64_t all;
         int64_t filter;
     };
+    typedef cpu::HashAgg<int32_t, Values> Agg;
 
-    std::unordered_map<int32_t, Values> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t e = tin.getInt32(i, 0);
-        int32_t e0 = e;
-        int32_t o_year = tin.getInt32(i, 1);
-        int32_t n_rowid = tin.getInt32(i, 2);
-        std::array<char, TPCH_READ_NATION_LEN + 1> n_name = origin.getcharN<char, TPCH_READ_NATION_LEN + 1>(n_rowid, 2);
-        if (strcmp("BRAZIL", n_name.data())) {
-            e0 = 0;
-        }
-        auto it = ht1.find(o_year);
-        if (it != ht1.end()) {
-            int64_t s = it->second.all + e;
-            int64_t s0 = it->second.filter + e0;
-            ht1[o_year] = Values{s, s0};
-        } else {
-            ht1.insert(std::make_pair(o_year, Values{e, e0}));
-        }
-    }
+    const int32_t* e = cpu::col<int32_t>(tin, 0);
+    const int32_t* o_year = cpu::col<int32_t>(tin, 1);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin, 2);
+    Agg ht1 = cpu::groupBy<int32_t, Values>(
+        tin.getNumRow(),
+        [&](Agg& h, size_t i) {
+            bool brazil = !strcmp("BRAZIL", cpu::str<TPCH_READ_NATION_LEN + 1>(origin, 2, n_rowid[i]));
+            Values& v = h[o_year[i]];
+            v.all += e[i];
+            v.filter += brazil ? e[i] : 0;
+        },
+        [](Values& a, const Values& b) {
+            a.all += b.all;
+            a.filter += b.filter;
+        });
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
-        double result = (double)it.second.filter / (double)it.second.all;
-        // tout.setInt64(r, 1, it.second.filter/it.second.all);
+    ht1.forEach([&](const int32_t& k, Values& v) {
+        tout.setInt32(r, 0, k);
+        double result = (double)v.filter / (double)v.all;
+        // tout.setInt64(r, 1, v.filter/v.all);
         if (r < 10) std::cout << tout.getInt32(r, 0) << " " << result << std::endl;
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " q8Group" << std::endl;
 }
@@ -14,163 +14,120 @@
  * limitations under the License.
  */
 #include <unordered_map>
+#include "cpu_engine.hpp"
 // order and lineitem
 void q10Join_O_L(Table& tin1, Table& tin2, Table& tout) {
-    std::unordered_map<int32_t, int32_t> ht1;
     int nrow1 = tin1.getNumRow();
-    for (int i = 0; i < nrow1; ++i) {
-        int o_orderdate = tin1.getInt32(i, 0);
-        if (19931001 <= o_orderdate && o_orderdate < 19940101) {
-            int o_orderkey = tin1.getInt32(i, 1);
-            int o_custkey = tin1.getInt32(i, 2);
-            ht1.insert(std::make_pair(o_orderkey, o_custkey));
-        }
-    }
-    struct lineitem {
-        int32_t l_orderkey;
-        int32_t l_extendedprice;
-        int32_t l_discount;
-    };
-    std::vector<lineitem> ht2;
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin1, 0);
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin1, 1);
+    const int32_t* o_custkey = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(cpu::select(nrow1, [&](uint32_t i) { return 19931001 <= o_orderdate[i] && o_orderdate[i] < 19940101; }),
+              [&](uint32_t i) { return o_orderkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; ++i) {
-        int l_returnflag = tin2.getInt32(i, 0);
-        if (l_returnflag == 'R') { // 82
-            // l_orderkey,l_extendedprice,l_discount
-            int l_orderkey = tin2.getInt32(i, 1);
-            int l_extendedprice = tin2.getInt32(i, 2);
-            int l_discount = tin2.getInt32(i, 3);
-            ht2.push_back(lineitem{l_orderkey, l_extendedprice, l_discount});
-        }
-    }
-    int r = 0;
-    for (size_t i = 0; i < ht2.size(); i++) {
-        int32_t l_orderkey = ht2[i].l_orderkey;
-        auto it1 = ht1.find(l_orderkey);
-        if (it1 != ht1.end()) {
-            int o_custkey = it1->second;
-            int l_extendedprice = ht2[i].l_extendedprice;
-            int l_discount = ht2[i].l_discount;
-            int32_t revenue = (-l_discount + 100) * l_extendedprice;
-            tout.setInt32(r, 0, o_custkey);
-            tout.setInt32(r, 1, revenue);
-            r++;
-        }
-    }
+    const int32_t* l_returnflag = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_discount = cpu::col<int32_t>(tin2, 3);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return l_returnflag[i] == 'R'; }); // 82
+    std::vector<cpu::Match> m = ht1.join(sel, [&](uint32_t i) { return l_orderkey[i]; });
+    int32_t* t_custkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_revenue = cpu::col<int32_t>(tout, 1);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        t_custkey[r] = o_custkey[m[r].build];
+        t_revenue[r] = (-l_discount[i] + 100) * l_extendedprice[i];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " out q10Join_O_L" << std::endl;
 }
 void q10Join_C_O1(Table& tin1, Table& tin2, Table& tout) {
-    struct KeyC {
-        int32_t c_nationkey;
-        int32_t c_rowid;
-    };
-
-    std::unordered_map<int32_t, KeyC> ht1;
     int nrow1 = tin1.getNumRow();
-    for (int i = 0; i < nrow1; ++i) {
-        int c_custkey = tin1.getInt32(i, 0);
-        int c_nationkey = tin1.getInt32(i, 1);
-        int c_rowid = tin1.getInt32(i, 2);
-        ht1.insert(std::make_pair(c_custkey, KeyC{c_nationkey, c_rowid}));
-    }
-    int r = 0;
+    const int32_t* c_custkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* c_nationkey = cpu::col<int32_t>(tin1, 1);
+    const int32_t* c_rowid = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return c_custkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int o_custkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(o_custkey);
-        if (it != ht1.end()) {
-            int c_nationkey = it->second.c_nationkey;
-            int c_rowid = it->second.c_rowid;
-            int revenue = tin2.getInt32(i, 1);
-            tout.setInt32(r, 0, c_nationkey);
-            tout.setInt32(r, 1, o_custkey);
-            tout.setInt32(r, 2, c_rowid);
-            tout.setInt32(r, 3, revenue);
-            r++;
-        }
-    }
+    const int32_t* o_custkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* revenue = cpu::col<int32_t>(tin2, 1);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return o_custkey[i]; });
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_custkey = cpu::col<int32_t>(tout, 1);
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 2);
+    int32_t* t_revenue = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        uint32_t j = m[r].build;
+        t_nationkey[r] = c_nationkey[j];
+        t_custkey[r] = o_custkey[i];
+        t_rowid[r] = c_rowid[j];
+        t_revenue[r] = revenue[i];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " out q10Join_C_O1" << std::endl;
 }
 void q10Join_N_O2(Table& tin1, Table& tin2, Table& tout) {
-    std::unordered_map<int32_t, int32_t> ht1;
     int nrow1 = tin1.getNumRow();
-    for (int i = 0; i < nrow1; ++i) {
-        int n_nationkey = tin1.getInt32(i, 0);
-        int n_rowid = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(n_nationkey, n_rowid));
-    }
-    int r = 0;
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* n_rowid = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int c_nationkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(c_nationkey);
-        if (it != ht1.end()) {
-            int o_custkey = tin2.getInt32(i, 1);
-            int c_rowid = tin2.getInt32(i, 2);
-            int n_rowid = it->second;
-            int revenue = tin2.getInt32(i, 3);
-            tout.setInt32(r, 0, o_custkey);
-            tout.setInt32(r, 1, c_nationkey);
-            tout.setInt32(r, 2, n_rowid);
-            tout.setInt32(r, 3, c_rowid);
-            tout.setInt32(r, 4, revenue);
-            r++;
-        }
-    }
+    const int32_t* c_nationkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* o_custkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* c_rowid = cpu::col<int32_t>(tin2, 2);
+    const int32_t* revenue = cpu::col<int32_t>(tin2, 3);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return c_nationkey[i]; });
+    int32_t* t_custkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 1);
+    int32_t* t_nrowid = cpu::col<int32_t>(tout, 2);
+    int32_t* t_crowid = cpu::col<int32_t>(tout, 3);
+    int32_t* t_revenue = cpu::col<int32_t>(tout, 4);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        t_custkey[r] = o_custkey[i];
+        t_nationkey[r] = c_nationkey[i];
+        t_nrowid[r] = n_rowid[m[r].build];
+        t_crowid[r] = c_rowid[i];
+        t_revenue[r] = revenue[i];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " out q10Join_N_O2" << std::endl;
 }
-struct Q10GroupKey {
-    int32_t c_custkey;
-    int32_t n_nationkey;
-    int32_t n_rowid;
-    int32_t c_rowid;
-    // std::array
-
-    bool operator==(const Q10GroupKey& other) const { return (c_custkey == other.c_custkey); }
-};
-namespace std {
-
-template <>
-struct hash<Q10GroupKey> {
-    std::size_t operator()(const Q10GroupKey& k) const {
-        using std::size_t;
-        using std::hash;
-        return (hash<int>()(k.c_custkey));
-    }
-};
-}
 
+// grouped on c_custkey only, the other fields follow the customer
 void q10GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<Q10GroupKey, int64_t> m;
-    unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t c_custkey = tin.getInt32(i, 0);   // index much patMatch YAML
-        int32_t n_nationkey = tin.getInt32(i, 1); // index much patMatch YAML
-        int32_t n_rowid = tin.getInt32(i, 2);
-        int32_t c_rowid = tin.getInt32(i, 3);
-        int32_t revenue = tin.getInt32(i, 4);
-
-        Q10GroupKey k{c_custkey, n_nationkey, n_rowid, c_rowid};
-        auto it = m.find(k);
-        if (it != m.end()) {
-            int64_t s = it->second + revenue;
-            m[k] = s; // update
-        } else {
-            m.insert(std::make_pair(k, revenue));
-        }
-    }
+    struct Q10GroupValue {
+        int32_t n_nationkey;
+        int32_t n_rowid;
+        int32_t c_rowid;
+        int64_t revenue;
+    };
+    typedef cpu::HashAgg<int32_t, Q10GroupValue> Agg;
+    const int32_t* c_custkey = cpu::col<int32_t>(tin, 0);   // index much patMatch YAML
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin, 1); // index much patMatch YAML
+    const int32_t* n_rowid = cpu::col<int32_t>(tin, 2);
+    const int32_t* c_rowid = cpu::col<int32_t>(tin, 3);
+    const int32_t* revenue = cpu::col<int32_t>(tin, 4);
+    Agg m = cpu::groupBy<int32_t, Q10GroupValue>(
+        tin.getNumRow(),
+        [&](Agg& h, size_t i) {
+            h.emplace(c_custkey[i], Q10GroupValue{n_nationkey[i], n_rowid[i], c_rowid[i], 0}).revenue += revenue[i];
+        },
+        [](Q10GroupValue& a, const Q10GroupValue& b) { a.revenue += b.revenue; });
     int r = 0;
-    for (auto& it : m) {
-        tout.setInt32(r, 0, it.first.c_custkey);
-        tout.setInt32(r, 1, it.first.n_nationkey);
-        tout.setInt32(r, 2, it.first.n_rowid);
-        tout.setInt32(r, 3, it.first.c_rowid);
-        tout.setInt64(r, 4, it.second);
+    m.forEach([&](const int32_t& k, Q10GroupValue& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt32(r, 1, v.n_nationkey);
+        tout.setInt32(r, 2, v.n_rowid);
+        tout.setInt32(r, 3, v.c_rowid);
+        tout.setInt64(r, 4, v.revenue);
         ++r;
-    }
+    });
     tout.setNumRow(r);
 }
 
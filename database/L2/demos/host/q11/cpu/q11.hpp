@@ -13,19 +13,14 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // n_nationkey:3
 void NationFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_NATION_LEN + 1> n_name = tin.getcharN<char, TPCH_READ_NATION_LEN + 1>(i, 1);
-        if (!strcmp("GERMANY", n_name.data())) {
-            int32_t n_nationkey = tin.getInt32(i, 0);
-            tout.setInt32(r, 0, n_nationkey);
-            // tout.setcharN<char,TPCH_READ_NATION_LEN + 1>(r,1,n_name);
-            r++;
-        }
-    }
+    cpu::SelVec sel = cpu::select(
+        nrow, [&](uint32_t i) { return !strcmp("GERMANY", cpu::str<TPCH_READ_NATION_LEN + 1>(tin, 1, i)); });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In NationFilter" << std::endl;
 }
@@ -33,21 +28,14 @@ void NationFilter(Table& tin, Table& tout) {
 // select count(*) from nation,supplier where n_name = 'GERMANY' and s_nationkey = n_nationkey;
 void q11Join_t1_s(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
-    int r = 0;
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t s_nationkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(s_nationkey);
-        if (it != ht1.end()) {
-            int32_t s_suppkey = tin2.getInt32(i, 1);
-            tout.setInt32(r, 0, s_suppkey);
-            r++;
-        }
-    }
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(s_nationkey[i]); });
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q11Join_t1_s" << std::endl;
 }
@@ -59,25 +47,23 @@ void q11Join_t1_s(Table& tin1, Table& tin2, Table& tout) {
 
 void q11Join_t2_p(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
-    int r = 0;
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_suppkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t ps_suppkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(ps_suppkey);
-        if (it != ht1.end()) {
-            int32_t ps_partkey = tin2.getInt32(i, 1);
-            int32_t ps_supplycost = tin2.getInt32(i, 2);
-            int32_t ps_availqty = tin2.getInt32(i, 3);
-            int32_t e = ps_supplycost * ps_availqty;
-            tout.setInt32(r, 0, ps_partkey);
-            tout.setInt32(r, 1, e);
-            r++;
-        }
-    }
+    const int32_t* ps_suppkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* ps_supplycost = cpu::col<int32_t>(tin2, 2);
+    const int32_t* ps_availqty = cpu::col<int32_t>(tin2, 3);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(ps_suppkey[i]); });
+    int32_t* t_partkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_e = cpu::col<int32_t>(tout, 1);
+    cpu::parallelFor(sel.size(), [&](size_t r) {
+        uint32_t i = sel[r];
+        t_partkey[r] = ps_partkey[i];
+        t_e[r] = ps_supplycost[i] * ps_availqty[i];
+    });
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In q11Join_t2_p" << std::endl;
 }
@@ -86,11 +72,15 @@ void q11Join_t2_p(Table& tin1, Table& tin2, Table& tout) {
 // 7874103.109405
 int64_t sq11Sum(Table& tin1) {
     int nrow1 = tin1.getNumRow();
+    const int32_t* e = cpu::col<int32_t>(tin1, 1);
+    std::vector<int64_t> sums(cpu::threadNum(), 0);
+    cpu::parallelMorsels(nrow1, [&](int tid, size_t, size_t b, size_t end) {
+        int64_t sum = 0;
+        for (size_t i = b; i < end; i++) sum += e[i];
+        sums[tid] += sum;
+    });
     int64_t sum = 0;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t e = tin1.getInt32(i, 1);
-        sum += e;
-    }
+    for (int t = 0; t < cpu::threadNum(); t++) sum += sums[t];
     return sum;
 }
 int64_t q14scalsum(Table& tin) {
@@ -101,25 +91,17 @@ int64_t q14scalsum(Table& tin) {
 // select count(*) from (select  sum(ps_supplycost*ps_availqty) from partsupp,supplier,nation where n_name = 'GERMANY'
 // and s_nationkey = n_nationkey and ps_suppkey = s_suppkey group by ps_partkey)ff;
 void q11Groupby(Table& tin1, Table& tout) {
-    int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t ps_partkey = tin1.getInt32(i, 0);
-        int32_t e = tin1.getInt32(i, 1);
-        auto it = ht1.find(ps_partkey);
-        if (it != ht1.end()) {
-            int64_t t = it->second + e;
-            ht1[ps_partkey] = t;
-        } else {
-            ht1.insert(std::make_pair(ps_partkey, e));
-        }
-    }
+    typedef cpu::HashAgg<int32_t, int64_t> Agg;
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* e = cpu::col<int32_t>(tin1, 1);
+    Agg ht1 = cpu::groupBy<int32_t, int64_t>(tin1.getNumRow(), [&](Agg& h, size_t i) { h[ps_partkey[i]] += e[i]; },
+                                              [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt64(r, 1, it.second);
+    ht1.forEach([&](const int32_t& k, int64_t& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt64(r, 1, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
 }
 
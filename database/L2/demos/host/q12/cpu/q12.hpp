@@ -13,28 +13,27 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // t1:1715437
 void LineFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
     std::cout << std::dec << nrow << " " << std::endl;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_MAXAGG_LEN + 1> l_shipmode = tin.getcharN<char, TPCH_READ_MAXAGG_LEN + 1>(i, 1);
-        if ((!strcmp(l_shipmode.data(), "MAIL")) || (!strcmp(l_shipmode.data(), "SHIP"))) {
-            int32_t l_orderkey = tin.getInt32(i, 0);
-            int32_t l_commitdate = tin.getInt32(i, 2);
-            int32_t l_receiptdate = tin.getInt32(i, 3);
-            int32_t l_shipdate = tin.getInt32(i, 4);
-            int32_t l_rowid = i;
-            if (r < 50 && l_orderkey > 174576000) std::cout << l_orderkey << "  " << l_shipmode.data() << std::endl;
-            tout.setInt32(r, 0, l_orderkey);
-            tout.setInt32(r, 1, l_rowid);
-            // tout.setcharN<char,TPCH_READ_MAXAGG_LEN + 1>(r,1,l_shipmode);
-            tout.setInt32(r, 2, l_commitdate);
-            tout.setInt32(r, 3, l_receiptdate);
-            tout.setInt32(r, 4, l_shipdate);
-            r++;
-        }
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin, 0);
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        const char* l_shipmode = cpu::str<TPCH_READ_MAXAGG_LEN + 1>(tin, 1, i);
+        return !strcmp(l_shipmode, "MAIL") || !strcmp(l_shipmode, "SHIP");
+    });
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 1);
+    cpu::gather(l_orderkey, sel, cpu::col<int32_t>(tout, 0));
+    cpu::parallelFor(sel.size(), [&](size_t r) { t_rowid[r] = sel[r]; });
+    // tout.setcharN<char,TPCH_READ_MAXAGG_LEN + 1>(r,1,l_shipmode);
+    cpu::gather(cpu::col<int32_t>(tin, 2), sel, cpu::col<int32_t>(tout, 2));
+    cpu::gather(cpu::col<int32_t>(tin, 3), sel, cpu::col<int32_t>(tout, 3));
+    cpu::gather(cpu::col<int32_t>(tin, 4), sel, cpu::col<int32_t>(tout, 4));
+    int r = sel.size();
+    for (int k = 0; k < r && k < 50; k++) {
+        if (l_orderkey[sel[k]] > 174576000)
+            std::cout << l_orderkey[sel[k]] << "  " << cpu::str<TPCH_READ_MAXAGG_LEN + 1>(tin, 1, sel[k]) << std::endl;
     }
     tout.setNumRow(r);
     std::cout << std::dec << r << " in LineFilter" << std::endl;
@@ -44,90 +43,66 @@ void LineFilter(Table& tin, Table& tout) {
 void q12Join_o_t1(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_orderkey = tin1.getInt32(i, 0);
-        int32_t o_rowid = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(o_orderkey, o_rowid));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        int32_t l_commitdate = tin2.getInt32(i, 2);
-        int32_t l_receiptdate = tin2.getInt32(i, 3);
-        int32_t l_shipdate = tin2.getInt32(i, 4);
-        auto it = ht1.find(l_orderkey);
-        if (l_commitdate < l_receiptdate && l_shipdate < l_commitdate && l_receiptdate >= 19940101 &&
-            l_receiptdate < 19950101 && it != ht1.end()) {
-            int32_t l_rowid = tin2.getInt32(i, 1);
-            int32_t o_rowid = it->second;
-            tout.setInt32(r, 0, o_rowid);
-            tout.setInt32(r, 1, l_rowid);
-            r++;
-        }
-    }
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* o_rowid = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return o_orderkey[i]; });
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_rowid = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_commitdate = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_receiptdate = cpu::col<int32_t>(tin2, 3);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin2, 4);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) {
+        return (l_commitdate[i] < l_receiptdate[i]) & (l_shipdate[i] < l_commitdate[i]) &
+               (l_receiptdate[i] >= 19940101) & (l_receiptdate[i] < 19950101);
+    });
+    std::vector<cpu::Match> m = ht1.join(sel, [&](uint32_t i) { return l_orderkey[i]; });
+    int32_t* t_orowid = cpu::col<int32_t>(tout, 0);
+    int32_t* t_lrowid = cpu::col<int32_t>(tout, 1);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_orowid[r] = o_rowid[m[r].build];
+        t_lrowid[r] = l_rowid[m[r].probe];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " in q12Join_o_t1" << std::endl;
 }
 // t2
-struct q12GroupKey {
-    std::string l_shipmode;
-    bool operator==(const q12GroupKey& other) const { return (l_shipmode == other.l_shipmode); }
-};
-namespace std {
-template <>
-struct hash<q12GroupKey> {
-    std::size_t operator()(const q12GroupKey& k) const {
-        using std::size_t;
-        using std::hash;
-        using std::string;
-        return (hash<string>()(k.l_shipmode));
-    }
-};
-}
+typedef cpu::StrKey<TPCH_READ_MAXAGG_LEN + 1> q12GroupKey;
 struct sumVs {
     int64_t sum1;
     int64_t sum2;
 };
 
 void q12Groupby(Table& tin1, Table& origint1, Table& origint2, Table& tout) {
+    typedef cpu::HashAgg<q12GroupKey, sumVs, cpu::StrKeyHash> Agg;
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<q12GroupKey, sumVs> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t l_rowid = tin1.getInt32(i, 1);
-        std::array<char, TPCH_READ_MAXAGG_LEN + 1> l_shipmode =
-            origint1.getcharN<char, TPCH_READ_MAXAGG_LEN + 1>(l_rowid, 1);
-        int32_t o_rowid = tin1.getInt32(i, 0);
-        std::array<char, TPCH_READ_MAXAGG_LEN + 1> o_orderpriority =
-            origint2.getcharN<char, TPCH_READ_MAXAGG_LEN + 1>(o_rowid, 2);
-        q12GroupKey k{std::string(l_shipmode.data())};
-        auto it = ht1.find(k);
-        if (it != ht1.end()) {
-            if (!strcmp(o_orderpriority.data(), "1-URGENT") || !strcmp(o_orderpriority.data(), "2-HIGH")) {
-                int64_t t = it->second.sum1 + 1;
-                ht1[k].sum1 = t;
+    const int32_t* o_rowid = cpu::col<int32_t>(tin1, 0);
+    const int32_t* l_rowid = cpu::col<int32_t>(tin1, 1);
+    Agg ht1 = cpu::groupBy<q12GroupKey, sumVs, cpu::StrKeyHash>(
+        nrow1,
+        [&](Agg& h, size_t i) {
+            q12GroupKey k(cpu::str<TPCH_READ_MAXAGG_LEN + 1>(origint1, 1, l_rowid[i]));
+            const char* o_orderpriority = cpu::str<TPCH_READ_MAXAGG_LEN + 1>(origint2, 2, o_rowid[i]);
+            if (!strcmp(o_orderpriority, "1-URGENT") || !strcmp(o_orderpriority, "2-HIGH")) {
+                h[k].sum1++;
             } else {
-                int64_t t = it->second.sum2 + 1;
-                ht1[k].sum2 = t;
+                h[k].sum2++;
             }
-
-        } else {
-            if (!strcmp(o_orderpriority.data(), "1-URGENT") || !strcmp(o_orderpriority.data(), "2-HIGH")) {
-                ht1.insert(std::make_pair(k, sumVs{1, 0}));
-            } else {
-                ht1.insert(std::make_pair(k, sumVs{0, 1}));
-            }
-        }
-    }
+        },
+        [](sumVs& a, const sumVs& b) {
+            a.sum1 += b.sum1;
+            a.sum2 += b.sum2;
+        });
     int r = 0;
-    for (auto& it : ht1) {
+    ht1.forEach([&](const q12GroupKey& k, sumVs& v) {
         std::array<char, TPCH_READ_MAXAGG_LEN + 1> l_shipmode;
-        memcpy(l_shipmode.data(), (it.first.l_shipmode).data(), (it.first.l_shipmode).length());
+        memcpy(l_shipmode.data(), k.s, TPCH_READ_MAXAGG_LEN + 1);
         tout.setcharN<char, TPCH_READ_MAXAGG_LEN + 1>(r, 0, l_shipmode);
-        tout.setInt64(r, 1, it.second.sum1);
-        tout.setInt64(r, 2, it.second.sum2);
+        tout.setInt64(r, 1, v.sum1);
+        tout.setInt64(r, 2, v.sum2);
         r++;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " in q12Groupby1" << std::endl;
 }
@@ -14,32 +14,30 @@
  * limitations under the License.
  */
 #include <regex>
+#include "cpu_engine.hpp"
 // 1479964 t1
-bool strm_pattern(std::string sub1, std::string sub2, std::string s, int len = 7) {
-    std::string::size_type spe_f = s.find(sub1);
-    std::string::size_type c_f = 0;
-    while (spe_f != std::string::npos) {
-        c_f += (spe_f + len);
-        std::string sub_s = s.substr(c_f);
-        if (sub_s.find(sub2) != std::string::npos) return true;
-        spe_f = sub_s.find(sub1);
+// true when sub2 follows an occurrence of sub1, len is the length of sub1
+bool strm_pattern(const char* sub1, const char* sub2, const char* s, int len = 7) {
+    const char* spe_f = strstr(s, sub1);
+    while (spe_f != NULL) {
+        const char* sub_s = spe_f + len;
+        if (strstr(sub_s, sub2) != NULL) return true;
+        spe_f = strstr(sub_s, sub1);
     }
     return false;
 }
+bool strm_pattern(std::string sub1, std::string sub2, std::string s, int len = 7) {
+    return strm_pattern(sub1.c_str(), sub2.c_str(), s.c_str(), len);
+}
 void OrderFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_O_CMNT_MAX + 1> o_comment = tin.getcharN<char, TPCH_READ_O_CMNT_MAX + 1>(i, 2);
-        // if(!std::regex_match(o_comment.data(), std::regex("(.*)(special)(.*)(requests)(.*)"))){
-        if (!strm_pattern("special", "requests", o_comment.data())) {
-            int32_t o_custkey = tin.getInt32(i, 0);
-            int32_t o_orderkey = tin.getInt32(i, 1);
-            tout.setInt32(r, 0, o_custkey);
-            tout.setInt32(r, 1, o_orderkey);
-            r++;
-        }
-    }
+    // if(!std::regex_match(o_comment.data(), std::regex("(.*)(special)(.*)(requests)(.*)"))){
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        return !strm_pattern("special", "requests", cpu::str<TPCH_READ_O_CMNT_MAX + 1>(tin, 2, i));
+    });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin, 1), sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after OrderFilter" << std::endl;
 }
@@ -47,23 +45,16 @@ void OrderFilter(Table& tin, Table& tout) {
 // 1479964 t2
 void q13Join_c_t1(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
-    int r = 0;
+    const int32_t* c_custkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return c_custkey[i]; });
     int nrow2 = tin2.getNumRow();
     //    std::cout<<std::dec<<nrow1<<" "<<nrow2<<std::endl;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t o_custkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(o_custkey);
-        if (it != ht1.end()) {
-            int32_t o_orderkey = tin2.getInt32(i, 1);
-            tout.setInt32(r, 0, o_custkey);
-            tout.setInt32(r, 1, o_orderkey);
-            r++;
-        }
-    }
+    const int32_t* o_custkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(o_custkey[i]); });
+    cpu::gather(o_custkey, sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q13Join_c_t1" << std::endl;
 }
@@ -72,61 +63,43 @@ void q13Join_c_t1(Table& tin1, Table& tin2, Table& tout) {
 void q13AntiJoin_t2_c(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_custkey = tin1.getInt32(i, 0);
-        int32_t o_orderkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(o_custkey, o_orderkey));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t c_custkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(c_custkey);
-        if (it == ht1.end()) {
-            tout.setInt32(r, 0, c_custkey);
-            tout.setInt32(r, 1, 0);
-            r++;
-        }
-    }
+    const int32_t* o_custkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return o_custkey[i]; });
+    const int32_t* c_custkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return !ht1.contains(c_custkey[i]); });
+    int32_t* t_count = cpu::col<int32_t>(tout, 1);
+    cpu::gather(c_custkey, sel, cpu::col<int32_t>(tout, 0));
+    cpu::parallelFor(sel.size(), [&](size_t r) { t_count[r] = 0; });
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q13AntiJoin_t2_c" << std::endl;
 }
 void q13GroupBy_t2(Table& tin, Table& tout) {
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t c_custkey = tin.getInt32(i, 0);
-        auto it = ht1.find(c_custkey);
-        if (it != ht1.end()) {
-            int64_t s = it->second + 1;
-            ht1[c_custkey] = s;
-        } else {
-            ht1.insert(std::make_pair(c_custkey, 1));
-        }
-    }
+    typedef cpu::HashAgg<int32_t, int32_t> Agg;
+    const int32_t* c_custkey = cpu::col<int32_t>(tin, 0);
+    Agg ht1 = cpu::groupBy<int32_t, int32_t>(tin.getNumRow(), [&](Agg& h, size_t i) { h[c_custkey[i]]++; },
+                                              [](int32_t& a, const int32_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt32(r, 1, it.second);
+    ht1.forEach([&](const int32_t& k, int32_t& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt32(r, 1, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q13GroupBy3" << std::endl;
 }
 void q13GroupBy_t3(Table& tin, Table& tout) {
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t o_custkey = tin.getInt32(i, 0);
-        auto it = ht1.find(o_custkey);
-        if (it == ht1.end()) {
-            ht1.insert(std::make_pair(o_custkey, 0));
-        }
-    }
+    typedef cpu::HashAgg<int32_t, int32_t> Agg;
+    const int32_t* o_custkey = cpu::col<int32_t>(tin, 0);
+    Agg ht1 = cpu::groupBy<int32_t, int32_t>(tin.getNumRow(), [&](Agg& h, size_t i) { h[o_custkey[i]]; },
+                                              [](int32_t&, const int32_t&) {});
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
+    ht1.forEach([&](const int32_t& k, int32_t&) {
+        tout.setInt32(r, 0, k);
         tout.setInt32(r, 1, 0);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q13GroupBy2" << std::endl;
 }
@@ -134,37 +107,26 @@ void q13GroupBy_t3(Table& tin, Table& tout) {
 void combile_t4_t5(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    int i = 0;
-    for (i = 0; i < nrow1; i++) {
-        tout.setInt32(i, 0, tin1.getInt32(i, 0));
-        tout.setInt32(i, 1, tin1.getInt32(i, 1));
-    }
-    for (i = nrow1; i < nrow1 + nrow2; i++) {
-        int j = i - nrow1;
-        tout.setInt32(i, 0, tin2.getInt32(j, 0));
-        tout.setInt32(i, 1, tin2.getInt32(j, 1));
+    for (int c = 0; c < 2; c++) {
+        int32_t* dst = cpu::col<int32_t>(tout, c);
+        memcpy(dst, cpu::col<int32_t>(tin1, c), sizeof(int32_t) * nrow1);
+        memcpy(dst + nrow1, cpu::col<int32_t>(tin2, c), sizeof(int32_t) * nrow2);
     }
+    int i = nrow1 + nrow2;
     tout.setNumRow(i);
     std::cout << std::dec << i << " after combile_t4_t5" << std::endl;
 }
 void q13GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < tin.getNumRow(); i++) {
-        int32_t c_count = tin.getInt32(i, 1);
-        auto it = ht1.find(c_count);
-        if (it != ht1.end()) {
-            int32_t s = it->second + 1;
-            ht1[c_count] = s;
-        } else {
-            ht1.insert(std::make_pair(c_count, 1));
-        }
-    }
+    typedef cpu::HashAgg<int32_t, int32_t> Agg;
+    const int32_t* c_count = cpu::col<int32_t>(tin, 1);
+    Agg ht1 = cpu::groupBy<int32_t, int32_t>(tin.getNumRow(), [&](Agg& h, size_t i) { h[c_count[i]]++; },
+                                              [](int32_t& a, const int32_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt32(r, 1, it.second);
+    ht1.forEach([&](const int32_t& k, int32_t& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt32(r, 1, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q13GroupBy3" << std::endl;
 }
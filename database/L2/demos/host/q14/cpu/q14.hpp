@@ -14,73 +14,61 @@
  * limitations under the License.
  */
 #include <regex>
+#include "cpu_engine.hpp"
 // t1 //t6
 void PartFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_TYPE_LEN + 1> p_type = tin.getcharN<char, TPCH_READ_P_TYPE_LEN + 1>(i, 1);
-        // if(std::regex_match(p_type.data(), std::regex("(PROMO)(.*)"))){
-        if (std::string(p_type.data()).find("PROMO") == 0) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            tout.setInt32(r, 0, p_partkey);
-
-            r++;
-        }
-    }
+    // if(std::regex_match(p_type.data(), std::regex("(PROMO)(.*)"))){
+    cpu::SelVec sel = cpu::select(
+        nrow, [&](uint32_t i) { return !strncmp(cpu::str<TPCH_READ_P_TYPE_LEN + 1>(tin, 1, i), "PROMO", 5); });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " In PartFilter" << std::endl;
 }
 
+// sum of l_extendedprice * (100 - l_discount) over Sep 1995 lineitems whose part is in ht1
+int64_t q14Revenue(const cpu::HashJoin& ht1, Table& tin2) {
+    int nrow2 = tin2.getNumRow();
+    const int32_t* l_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_discount = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin2, 3);
+    std::vector<int64_t> sums(cpu::threadNum(), 0);
+    auto rowOf = [](size_t i) { return (uint32_t)i; };
+    auto pred = [&](uint32_t i) { return (l_shipdate[i] >= 19950901) & (l_shipdate[i] < 19951001); };
+    cpu::parallelMorsels(nrow2, [&](int tid, size_t, size_t b, size_t e) {
+        uint32_t sel[cpu::MORSEL_ROWS];
+        size_t n = cpu::selectMorsel(b, e, rowOf, pred, sel);
+        int64_t sum = 0;
+        for (size_t k = 0; k < n; k++) {
+            uint32_t i = sel[k];
+            if (ht1.contains(l_partkey[i])) sum += (int32_t)(l_extendedprice[i] * (100 - l_discount[i]));
+        }
+        sums[tid] += sum;
+    });
+    int64_t sum = 0;
+    for (int t = 0; t < cpu::threadNum(); t++) sum += sums[t];
+    return sum;
+}
+
 // t2
 int64_t q14Join_t1_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return p_partkey[i]; });
     std::cout << std::dec << nrow1 << " " << ht1.size() << " 0In PartFilter" << std::endl;
-    int64_t sum = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_shipdate = tin2.getInt32(i, 3);
-        if (l_shipdate >= 19950901 && l_shipdate < 19951001) {
-            int32_t l_partkey = tin2.getInt32(i, 0);
-            auto it = ht1.find(l_partkey);
-            if (it != ht1.end()) {
-                int32_t l_extendedprice = tin2.getInt32(i, 1);
-                int32_t l_discount = tin2.getInt32(i, 2);
-                int32_t e = l_extendedprice * (100 - l_discount);
-                sum += e;
-            }
-        }
-    }
-    return sum;
+    return q14Revenue(ht1, tin2);
 }
 
 int64_t q14Join_p_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return p_partkey[i]; });
     std::cout << std::dec << ht1.size() << " In PartFilter" << std::endl;
-    int64_t sum = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_shipdate = tin2.getInt32(i, 3);
-        if (l_shipdate >= 19950901 && l_shipdate < 19951001) {
-            int32_t l_partkey = tin2.getInt32(i, 0);
-            auto it = ht1.find(l_partkey);
-            if (it != ht1.end()) {
-                int32_t l_extendedprice = tin2.getInt32(i, 1);
-                int32_t l_discount = tin2.getInt32(i, 2);
-                int32_t e = l_extendedprice * (100 - l_discount);
-                sum += e;
-            }
-        }
-    }
-    return sum;
+    return q14Revenue(ht1, tin2);
 }
 // t3
 // q14Join_p_l/q14Join_t1_l
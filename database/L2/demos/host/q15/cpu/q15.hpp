@@ -13,37 +13,32 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // order and lineitem
 
 void q15GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<int32_t, int64_t> m;
+    typedef cpu::HashAgg<int32_t, int64_t> Agg;
     unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t l_shipdate = tin.getInt32(i, 3);
-        //        if(i<10) std::cout<<std::dec<<l_shipdate<<std::endl;
-        if (l_shipdate >= 19960101 && l_shipdate < 19960401) {
-            int32_t l_suppkey = tin.getInt32(i, 0);       // index much patMatch YAML
-            int32_t l_extendedprice = tin.getInt32(i, 1); // index much patMatch YAML
-            int32_t l_discount = tin.getInt32(i, 2);
-            int32_t revenue = l_extendedprice * (100 - l_discount);
-            auto it = m.find(l_suppkey);
-            if (it != m.end()) {
-                int64_t s = it->second + revenue;
-                m[l_suppkey] = s; // update
-            } else {
-                m.insert(std::make_pair(l_suppkey, revenue));
-            }
-        }
-    }
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin, 0);       // index much patMatch YAML
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin, 1); // index much patMatch YAML
+    const int32_t* l_discount = cpu::col<int32_t>(tin, 2);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin, 3);
+    cpu::SelVec sel =
+        cpu::select(nrow, [&](uint32_t i) { return (l_shipdate[i] >= 19960101) & (l_shipdate[i] < 19960401); });
+    Agg m = cpu::groupBy<int32_t, int64_t>(
+        sel.size(),
+        [&](Agg& h, size_t k) {
+            uint32_t i = sel[k];
+            int32_t revenue = l_extendedprice[i] * (100 - l_discount[i]);
+            h[l_suppkey[i]] += revenue;
+        },
+        [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : m) {
-        int64_t sumv = it.second;
-        tout.setInt32(r, 0, it.first);
+    m.forEach([&](const int32_t& k, int64_t& sumv) {
+        tout.setInt32(r, 0, k);
         tout.setInt64(r, 1, sumv);
-        /*  if(sumv>maxv)
-             maxv = sumv;*/
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " out q15GroupBy" << std::endl;
 }
@@ -14,81 +14,63 @@
  * limitations under the License.
  */
 #include <regex>
+#include "cpu_engine.hpp"
 // t1 //t6
 void q16Filter_p(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand = tin.getcharN<char, TPCH_READ_P_BRND_LEN + 1>(i, 1);
-        std::array<char, TPCH_READ_P_TYPE_LEN + 1> p_type = tin.getcharN<char, TPCH_READ_P_TYPE_LEN + 1>(i, 2);
-        // if(!std::regex_match(p_type.data(), std::regex("(MEDIUM POLISHED)(.*)"))&&strcmp(p_brand.data(),"Brand#45")){
-        if (strcmp(p_brand.data(), "Brand#45") && std::string(p_type.data()).find("MEDIUM POLISHED") != 0) {
-            // if(std::string(p_type.data()).find("MEDIUM POLISHED")!=0&&strcmp(p_brand.data(),"Brand#45")){
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            int32_t p_rowid = i; // tin.getInt32(i,4);
-            tout.setInt32(r, 0, p_partkey);
-            tout.setInt32(r, 1, p_size);
-            tout.setInt32(r, 2, p_rowid);
-            //            tout.setcharN<char,TPCH_READ_P_BRND_LEN+1>(r,3,p_brand);
-            //            tout.setcharN<char,TPCH_READ_P_TYPE_LEN+1>(r,4,p_type);
-            r++;
-        }
-    }
+    // if(!std::regex_match(p_type.data(), std::regex("(MEDIUM POLISHED)(.*)"))&&strcmp(p_brand.data(),"Brand#45")){
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        const char* p_brand = cpu::str<TPCH_READ_P_BRND_LEN + 1>(tin, 1, i);
+        const char* p_type = cpu::str<TPCH_READ_P_TYPE_LEN + 1>(tin, 2, i);
+        return strcmp(p_brand, "Brand#45") && strncmp(p_type, "MEDIUM POLISHED", 15);
+    });
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 2);
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin, 3), sel, cpu::col<int32_t>(tout, 1));
+    cpu::parallelFor(sel.size(), [&](size_t r) { t_rowid[r] = sel[r]; }); // tin.getInt32(i,4);
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q16Filter_p" << std::endl;
 }
 
 void q16Join_c_t1(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
-    int r = 0;
+    const int32_t* c_size = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return c_size[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t p_size = tin2.getInt32(i, 1);
-        auto it = ht1.find(p_size);
-        if (it != ht1.end()) {
-            int32_t p_partkey = tin2.getInt32(i, 0);
-            int32_t p_rowid = tin2.getInt32(i, 2);
-            tout.setInt32(r, 0, p_partkey);
-            tout.setInt32(r, 1, p_rowid);
-            tout.setInt32(r, 2, p_size);
-            r++;
-        }
-    }
+    const int32_t* p_size = cpu::col<int32_t>(tin2, 1);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(p_size[i]); });
+    cpu::gather(cpu::col<int32_t>(tin2, 0), sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin2, 2), sel, cpu::col<int32_t>(tout, 1));
+    cpu::gather(p_size, sel, cpu::col<int32_t>(tout, 2));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q16Join_c_t1" << std::endl;
 }
 
-bool strm_pattern(std::string sub1, std::string sub2, std::string s, int len = 7) {
-    std::string::size_type spe_f = s.find(sub1);
-    std::string::size_type c_f = 0;
-    while (spe_f != std::string::npos) {
-        c_f += (spe_f + len);
-        std::string sub_s = s.substr(c_f);
-        if (sub_s.find(sub2) != std::string::npos) return true;
-        spe_f = sub_s.find(sub1);
+// true when sub2 follows an occurrence of sub1, len is the length of sub1
+bool strm_pattern(const char* sub1, const char* sub2, const char* s, int len = 7) {
+    const char* spe_f = strstr(s, sub1);
+    while (spe_f != NULL) {
+        const char* sub_s = spe_f + len;
+        if (strstr(sub_s, sub2) != NULL) return true;
+        spe_f = strstr(sub_s, sub1);
     }
     return false;
 }
+bool strm_pattern(std::string sub1, std::string sub2, std::string s, int len = 7) {
+    return strm_pattern(sub1.c_str(), sub2.c_str(), s.c_str(), len);
+}
 // t3
 void q16Filter_s(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_S_CMNT_MAX + 1> s_comment = tin.getcharN<char, TPCH_READ_S_CMNT_MAX + 1>(i, 1);
-        // if(!std::regex_match (s_comment.data(), std::regex("(.*)(Customer)(.*)(Complaint)(.*)"))){
-        if (!strm_pattern("Customer", "Complaint", s_comment.data(), 8)) {
-            int32_t s_suppkey = tin.getInt32(i, 0);
-            // std::cout<<s_suppkey<<"   "<<s_comment.data()<<std::endl;
-            tout.setInt32(r, 0, s_suppkey);
-            r++;
-        }
-    }
+    // if(!std::regex_match (s_comment.data(), std::regex("(.*)(Customer)(.*)(Complaint)(.*)"))){
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        return !strm_pattern("Customer", "Complaint", cpu::str<TPCH_READ_S_CMNT_MAX + 1>(tin, 1, i), 8);
+    });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q16Filter_s" << std::endl;
 }
@@ -96,22 +78,14 @@ void q16Filter_s(Table& tin, Table& tout) {
 void q16Join_t3_p(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t s_suppkey = tin1.getInt32(i, 0);
-        ht1.insert(std::make_pair(s_suppkey, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t ps_suppkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(ps_suppkey);
-        if (it != ht1.end()) {
-            int32_t ps_partkey = tin2.getInt32(i, 1);
-            tout.setInt32(r, 0, ps_partkey);
-            tout.setInt32(r, 1, ps_suppkey);
-            r++;
-        }
-    }
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_suppkey[i]; });
+    const int32_t* ps_suppkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(ps_suppkey[i]); });
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(ps_suppkey, sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q16Join_t3_p" << std::endl;
 }
@@ -123,35 +97,30 @@ void q16Join_t4_t2(Table& tin1, Table& tin2, Table& tout) {
     std::cout << tin2.getInt32(1, 2) << std::endl;
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t ps_partkey = tin1.getInt32(i, 0);
-        int32_t ps_suppkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(ps_partkey, ps_suppkey));
-    }
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* ps_suppkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return ps_partkey[i]; });
 
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t p_partkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(p_partkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t p_rowid = tin2.getInt32(i, 1);
-            int32_t p_size = tin2.getInt32(i, 2);
-            int32_t ps_suppkey = it->second;
-            tout.setInt32(r, 0, p_rowid);
-            tout.setInt32(r, 1, p_size);
-            tout.setInt32(r, 2, ps_suppkey);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* p_rowid = cpu::col<int32_t>(tin2, 1);
+    const int32_t* p_size = cpu::col<int32_t>(tin2, 2);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return p_partkey[i]; });
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 0);
+    int32_t* t_size = cpu::col<int32_t>(tout, 1);
+    int32_t* t_suppkey = cpu::col<int32_t>(tout, 2);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_rowid[r] = p_rowid[m[r].probe];
+        t_size[r] = p_size[m[r].probe];
+        t_suppkey[r] = ps_suppkey[m[r].build];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q16Join_t4_t2" << std::endl;
 }
 struct Q16GroupKey {
-    std::string p_brand;
-    std::string p_type;
+    cpu::StrKey<TPCH_READ_P_BRND_LEN + 1> p_brand;
+    cpu::StrKey<TPCH_READ_P_TYPE_LEN + 1> p_type;
     int32_t p_size;
     // std::array
 
@@ -159,53 +128,63 @@ struct Q16GroupKey {
         return (p_brand == other.p_brand) && (p_type == other.p_type) && (p_size == other.p_size);
     }
 };
+// one (group, ps_suppkey) pair, for count(distinct ps_suppkey)
+struct Q16DistinctKey {
+    Q16GroupKey k;
+    int32_t ps_suppkey;
+    bool operator==(const Q16DistinctKey& other) const { return (k == other.k) && (ps_suppkey == other.ps_suppkey); }
+};
 namespace std {
 
 template <>
 struct hash<Q16GroupKey> {
     std::size_t operator()(const Q16GroupKey& k) const {
-        using std::size_t;
-        using std::hash;
-        using std::string;
-        return (hash<string>()(k.p_brand)) + (hash<string>()(k.p_type)) + (hash<int>()(k.p_size));
+        return (cpu::StrKeyHash()(k.p_brand) * 31 + cpu::StrKeyHash()(k.p_type)) * 31 + k.p_size;
+    }
+};
+template <>
+struct hash<Q16DistinctKey> {
+    std::size_t operator()(const Q16DistinctKey& k) const {
+        return hash<Q16GroupKey>()(k.k) * 31 + k.ps_suppkey;
     }
 };
 }
 
 void q16GroupBy(Table& tin, Table& origin, Table& tout) {
-    std::unordered_map<Q16GroupKey, std::set<int> > m;
+    typedef cpu::HashAgg<Q16DistinctKey, char> DistAgg;
+    typedef cpu::HashAgg<Q16GroupKey, int64_t> Agg;
     unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t p_rowid = tin.getInt32(i, 0); // index much patMatch YAML
-        int32_t p_size = tin.getInt32(i, 1);  // index much patMatch YAML
-        int32_t ps_suppkey = tin.getInt32(i, 2);
-        std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand =
-            origin.getcharN<char, TPCH_READ_P_BRND_LEN + 1>(p_rowid, 1);
-        std::array<char, TPCH_READ_P_TYPE_LEN + 1> p_type = origin.getcharN<char, TPCH_READ_P_TYPE_LEN + 1>(p_rowid, 2);
-        Q16GroupKey k{std::string(p_brand.data()), std::string(p_type.data()), p_size};
-        auto it = m.find(k);
-        if (it != m.end()) {
-            m[k].insert(ps_suppkey); // update
-        } else {
-            std::set<int> myset;
-            myset.insert(ps_suppkey);
-            m.insert(std::make_pair(k, myset));
-        }
-    }
+    const int32_t* p_rowid = cpu::col<int32_t>(tin, 0); // index much patMatch YAML
+    const int32_t* p_size = cpu::col<int32_t>(tin, 1);  // index much patMatch YAML
+    const int32_t* ps_suppkey = cpu::col<int32_t>(tin, 2);
+    // distinct (group, supplier) pairs first, then count them per group
+    DistAgg d = cpu::groupBy<Q16DistinctKey, char>(
+        nrow,
+        [&](DistAgg& h, size_t i) {
+            cpu::StrKey<TPCH_READ_P_BRND_LEN + 1> p_brand(cpu::str<TPCH_READ_P_BRND_LEN + 1>(origin, 1, p_rowid[i]));
+            cpu::StrKey<TPCH_READ_P_TYPE_LEN + 1> p_type(cpu::str<TPCH_READ_P_TYPE_LEN + 1>(origin, 2, p_rowid[i]));
+            h[Q16DistinctKey{Q16GroupKey{p_brand, p_type, p_size[i]}, ps_suppkey[i]}];
+        },
+        [](char&, const char&) {});
+    std::vector<Q16GroupKey> pairs;
+    pairs.reserve(d.size());
+    d.forEach([&](const Q16DistinctKey& k, char&) { pairs.push_back(k.k); });
+    Agg m = cpu::groupBy<Q16GroupKey, int64_t>(pairs.size(), [&](Agg& h, size_t i) { h[pairs[i]]++; },
+                                                [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : m) {
+    m.forEach([&](const Q16GroupKey& k, int64_t& v) {
         std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand_s{};
-        memcpy(p_brand_s.data(), (it.first.p_brand).data(), (it.first.p_brand).length());
+        memcpy(p_brand_s.data(), k.p_brand.s, TPCH_READ_P_BRND_LEN + 1);
         std::array<char, TPCH_READ_P_TYPE_LEN + 1> p_type_s{};
-        memcpy(p_type_s.data(), (it.first.p_type).data(), (it.first.p_type).length());
+        memcpy(p_type_s.data(), k.p_type.s, TPCH_READ_P_TYPE_LEN + 1);
         tout.setcharN<char, TPCH_READ_P_BRND_LEN + 1>(r, 0, p_brand_s);
         tout.setcharN<char, TPCH_READ_P_TYPE_LEN + 1>(r, 1, p_type_s);
-        tout.setInt32(r, 2, it.first.p_size);
-        tout.setInt64(r, 3, it.second.size());
+        tout.setInt32(r, 2, k.p_size);
+        tout.setInt64(r, 3, v);
         // if(r<10)std::cout<<tout.getcharN<char,TPCH_READ_P_BRND_LEN+1>(r, 0).data()<<"
         // "<<tout.getcharN<char,TPCH_READ_P_TYPE_LEN+1>(r, 1).data()<<" "<<std::dec<<tout.getInt32(r,2)<<std::endl;
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " groupby_q16" << std::endl;
 }
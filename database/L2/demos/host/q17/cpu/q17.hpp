@@ -13,65 +13,45 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // no use
 void q17Join_t3_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), tin1.getInt32(i, 1)));
-    }
-    int r = 0;
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return p_partkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_partkey = tin2.getInt32(i, 0);
-        int32_t l_quantity = tin2.getInt32(i, 1);
-        auto it = ht1.find(l_partkey);
-        if (it != ht1.end()) {
-            tout.setInt32(r, 0, l_partkey);
-            tout.setInt32(r, 1, l_quantity);
-            r++;
-        }
-    }
+    const int32_t* l_partkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(l_partkey[i]); });
+    cpu::gather(l_partkey, sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q17Join_t3_l" << std::endl;
 }
 // t2
 void PartFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand = tin.getcharN<char, TPCH_READ_P_BRND_LEN + 1>(i, 1);
-        std::array<char, TPCH_READ_P_CNTR_LEN + 1> p_container = tin.getcharN<char, TPCH_READ_P_CNTR_LEN + 1>(i, 2);
-        if (!strcmp(p_container.data(), "MED BOX") && !strcmp(p_brand.data(), "Brand#23")) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            tout.setInt32(r, 0, p_partkey);
-            r++;
-        }
-    }
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        return !strcmp(cpu::str<TPCH_READ_P_CNTR_LEN + 1>(tin, 2, i), "MED BOX") &&
+               !strcmp(cpu::str<TPCH_READ_P_BRND_LEN + 1>(tin, 1, i), "Brand#23");
+    });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q17PartFiler" << std::endl;
 }
 // t3
 void q17Join_t2_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), 0));
-    }
-    int r = 0;
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return p_partkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_partkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(l_partkey);
-        if (it != ht1.end()) {
-            int32_t l_quantity = tin2.getInt32(i, 1);
-            int32_t l_extendedprice = tin2.getInt32(i, 2);
-            tout.setInt32(r, 0, l_partkey);
-            tout.setInt32(r, 1, l_quantity);
-            tout.setInt32(r, 2, l_extendedprice);
-            r++;
-        }
-    }
+    const int32_t* l_partkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(l_partkey[i]); });
+    for (int c = 0; c < 3; c++) cpu::gather(cpu::col<int32_t>(tin2, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q17Join_t2_l" << std::endl;
 }
@@ -81,60 +61,57 @@ void q17GroupBy(Table& tin, Table& tout) {
         int64_t sum;
         int64_t count;
     };
+    typedef cpu::HashAgg<int32_t, Values> Agg;
 
     int nrow = tin.getNumRow();
-    std::unordered_map<int32_t, Values> ht1;
-    for (int i = 0; i < nrow; i++) {
-        int32_t l_partkey = tin.getInt32(i, 0);
-        int32_t l_quantity = tin.getInt32(i, 1);
-        auto it = ht1.find(l_partkey);
-        if (it != ht1.end()) {
-            int64_t sum_ = it->second.sum + l_quantity;
-            int64_t count_ = it->second.count + 1;
-            Values v{sum_, count_};
-            ht1[l_partkey] = v;
-        } else {
-            Values v{l_quantity, 1};
-            ht1.insert(std::make_pair(l_partkey, v));
-        }
-    }
+    const int32_t* l_partkey = cpu::col<int32_t>(tin, 0);
+    const int32_t* l_quantity = cpu::col<int32_t>(tin, 1);
+    Agg ht1 = cpu::groupBy<int32_t, Values>(
+        nrow,
+        [&](Agg& h, size_t i) {
+            Values& v = h[l_partkey[i]];
+            v.sum += l_quantity[i];
+            v.count++;
+        },
+        [](Values& a, const Values& b) {
+            a.sum += b.sum;
+            a.count += b.count;
+        });
     int r = 0;
-    for (auto it : ht1) {
-        int64_t sum = it.second.sum;
-        int64_t count = it.second.count;
-        int32_t l_partkey = it.first;
-        int32_t avg = 200 * sum / count;
+    ht1.forEach([&](const int32_t& k, Values& v) {
+        int32_t avg = 200 * v.sum / v.count;
         //        float avg_f =(float)sum/(float)count*0.2;
         //        if(r<10)std::cout<<avg<<std::endl;
-        tout.setInt32(r, 0, l_partkey);
+        tout.setInt32(r, 0, k);
         tout.setInt32(r, 1, avg);
         r++;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " q17GroupBy_firt" << std::endl;
 }
 void q17Join_t1_t3(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        ht1.insert(std::make_pair(tin1.getInt32(i, 0), tin1.getInt32(i, 1)));
-    }
-    int r = 0;
+    const int32_t* t_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* avg_l_quantity = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return t_partkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_partkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(l_partkey);
-        if (it != ht1.end()) {
-            int32_t l_quantity = tin2.getInt32(i, 1);
-            int32_t l_extendedprice = tin2.getInt32(i, 2);
-            tout.setInt32(r, 0, l_partkey);
-            tout.setInt32(r, 1, it->second);
-            tout.setInt32(r, 2, l_quantity);
-            tout.setInt32(r, 3, l_extendedprice);
-            //       if(l_partkey==135991)std::cout<<l_partkey<<" "<<it->second<<" "<<l_extendedprice<<std::endl;
-            r++;
-        }
-    }
+    const int32_t* l_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_quantity = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin2, 2);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return l_partkey[i]; });
+    int32_t* o_partkey = cpu::col<int32_t>(tout, 0);
+    int32_t* o_avg = cpu::col<int32_t>(tout, 1);
+    int32_t* o_quantity = cpu::col<int32_t>(tout, 2);
+    int32_t* o_extendedprice = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        o_partkey[r] = l_partkey[i];
+        o_avg[r] = avg_l_quantity[m[r].build];
+        o_quantity[r] = l_quantity[i];
+        o_extendedprice[r] = l_extendedprice[i];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q17Join_t1_t3" << std::endl;
 }
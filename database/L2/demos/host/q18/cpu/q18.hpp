@@ -13,142 +13,109 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // t1:1500000
 void q18GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<int32_t, int64_t> m;
+    typedef cpu::HashAgg<int32_t, int64_t> Agg;
     unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t l_orderkey = tin.getInt32(i, 0); // index much patMatch YAML
-        int32_t l_quantity = tin.getInt32(i, 1); // index much patMatch YAML
-        auto it = m.find(l_orderkey);
-        if (it != m.end()) {
-            int64_t s = it->second + l_quantity;
-            m[l_orderkey] = s; // update
-            if (l_orderkey == 1) std::cout << std::dec << s << std::endl;
-        } else {
-            m.insert(std::make_pair(l_orderkey, l_quantity));
-        }
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin, 0); // index much patMatch YAML
+    const int32_t* l_quantity = cpu::col<int32_t>(tin, 1); // index much patMatch YAML
+    Agg m = cpu::groupBy<int32_t, int64_t>(nrow, [&](Agg& h, size_t i) { h[l_orderkey[i]] += l_quantity[i]; },
+                                            [](int64_t& a, const int64_t& b) { a += b; });
+    // running sum of order 1
+    cpu::SelVec one = cpu::select(nrow, [&](uint32_t i) { return l_orderkey[i] == 1; });
+    int64_t s = 0;
+    for (size_t k = 0; k < one.size(); k++) {
+        s += l_quantity[one[k]];
+        if (k > 0) std::cout << std::dec << s << std::endl;
     }
     int r = 0;
-    for (auto& it : m) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt64_l(r, 1, it.second);
-        tout.setInt64_h(r, 2, it.second);
+    m.forEach([&](const int32_t& k, int64_t& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt64_l(r, 1, v);
+        tout.setInt64_h(r, 2, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " After q18GroupBy" << std::endl;
 }
 // t1 order
 void q18Join_t1_o(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
-    std::unordered_map<int32_t, int64_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t l_orderkey = tin1.getInt32(i, 0);
-        int32_t sum_l = tin1.getInt32(i, 1);
-        int32_t sum_h = tin1.getInt32(i, 2);
-        int64_t sum = tin1.mergeInt64(sum_l, sum_h);
-        if (sum > 300) {
-            ht1.insert(std::make_pair(l_orderkey, sum));
-        }
-    }
-    int r = 0;
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* sum_l = cpu::col<int32_t>(tin1, 1);
+    const int32_t* sum_h = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(cpu::select(nrow1, [&](uint32_t i) { return tin1.mergeInt64(sum_l[i], sum_h[i]) > 300; }),
+              [&](uint32_t i) { return l_orderkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t o_orderkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(o_orderkey);
-        if (it != ht1.end()) {
-            int32_t o_custkey = tin2.getInt32(i, 1);
-            int32_t o_orderdate = tin2.getInt32(i, 2);
-            int32_t o_totalprice = tin2.getInt32(i, 3);
-            tout.setInt32(r, 0, o_orderkey);
-            tout.setInt32(r, 1, o_custkey);
-            tout.setInt32(r, 2, o_orderdate);
-            tout.setInt32(r, 3, o_totalprice);
-            r++;
-        }
-    }
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(o_orderkey[i]); });
+    for (int c = 0; c < 4; c++) cpu::gather(cpu::col<int32_t>(tin2, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " After q18Join_t1_o" << std::endl;
 }
 // c_name c_rowid
 void q18Join_t2_c(Table& tin1, Table& tin2, Table& tout) {
-    struct KeyA {
-        int32_t o_orderkey;
-        int32_t o_orderdate;
-        int32_t o_totalprice;
-    };
     int nrow1 = tin1.getNumRow();
-    std::unordered_multimap<int32_t, KeyA> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_orderkey = tin1.getInt32(i, 0);
-        int32_t o_custkey = tin1.getInt32(i, 1);
-        int32_t o_orderdate = tin1.getInt32(i, 2);
-        int32_t o_totalprice = tin1.getInt32(i, 3);
-        ht1.insert(std::make_pair(o_custkey, KeyA{o_orderkey, o_orderdate, o_totalprice}));
-    }
-    int r = 0;
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* o_custkey = cpu::col<int32_t>(tin1, 1);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin1, 2);
+    const int32_t* o_totalprice = cpu::col<int32_t>(tin1, 3);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return o_custkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t c_custkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(c_custkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t c_rowid = i; // tin2.getInt32(i,2);
-            int32_t o_orderkey = it->second.o_orderkey;
-            int32_t o_orderdate = it->second.o_orderdate;
-            int32_t o_totalprice = it->second.o_totalprice;
-            tout.setInt32(r, 0, o_orderkey);
-            tout.setInt32(r, 1, o_orderdate);
-            tout.setInt32(r, 2, o_totalprice);
-            tout.setInt32(r, 3, c_rowid);
-            tout.setInt32(r, 4, c_custkey);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* c_custkey = cpu::col<int32_t>(tin2, 0);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return c_custkey[i]; });
+    int32_t* t_orderkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_orderdate = cpu::col<int32_t>(tout, 1);
+    int32_t* t_totalprice = cpu::col<int32_t>(tout, 2);
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 3);
+    int32_t* t_custkey = cpu::col<int32_t>(tout, 4);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t j = m[r].build;
+        t_orderkey[r] = o_orderkey[j];
+        t_orderdate[r] = o_orderdate[j];
+        t_totalprice[r] = o_totalprice[j];
+        t_rowid[r] = m[r].probe; // tin2.getInt32(i,2);
+        t_custkey[r] = c_custkey[m[r].probe];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " After q18Join_t2_c" << std::endl;
 }
+// o_orderkey is unique in tin1, so each lineitem matches at most once
 void q18Join_t3_l(Table& tin1, Table& tin2, Table& tout) {
-    struct KeyA {
-        int32_t o_orderdate;
-        int32_t o_totalprice;
-        int32_t c_rowid;
-        int32_t c_custkey;
-    };
     int nrow1 = tin1.getNumRow();
-    std::unordered_multimap<int32_t, KeyA> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_orderkey = tin1.getInt32(i, 0);
-        int32_t o_orderdate = tin1.getInt32(i, 1);
-        int32_t o_totalprice = tin1.getInt32(i, 2);
-        int32_t c_rowid = tin1.getInt32(i, 3);
-        int32_t c_custkey = tin1.getInt32(i, 4);
-        ht1.insert(std::make_pair(o_orderkey, KeyA{o_orderdate, o_totalprice, c_rowid, c_custkey}));
-    }
-    int r = 0;
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin1, 1);
+    const int32_t* o_totalprice = cpu::col<int32_t>(tin1, 2);
+    const int32_t* c_rowid = cpu::col<int32_t>(tin1, 3);
+    const int32_t* c_custkey = cpu::col<int32_t>(tin1, 4);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return o_orderkey[i]; });
     int nrow2 = tin2.getNumRow();
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(l_orderkey);
-        auto it = its.first;
-        if (it != its.second) {
-            int32_t l_quantity = tin2.getInt32(i, 1);
-            int32_t o_orderdate = it->second.o_orderdate;
-            int32_t o_totalprice = it->second.o_totalprice;
-            int32_t c_rowid = it->second.c_rowid;
-            int32_t c_custkey = it->second.c_custkey;
-            tout.setInt32(r, 0, l_orderkey);
-            tout.setInt32(r, 1, o_orderdate);
-            tout.setInt32(r, 2, o_totalprice);
-            tout.setInt32(r, 3, c_rowid);
-            tout.setInt32(r, 4, c_custkey);
-            tout.setInt32(r, 5, l_quantity);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_quantity = cpu::col<int32_t>(tin2, 1);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return l_orderkey[i]; });
+    int32_t* t_orderkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_orderdate = cpu::col<int32_t>(tout, 1);
+    int32_t* t_totalprice = cpu::col<int32_t>(tout, 2);
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 3);
+    int32_t* t_custkey = cpu::col<int32_t>(tout, 4);
+    int32_t* t_quantity = cpu::col<int32_t>(tout, 5);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        uint32_t j = m[r].build;
+        t_orderkey[r] = l_orderkey[i];
+        t_orderdate[r] = o_orderdate[j];
+        t_totalprice[r] = o_totalprice[j];
+        t_rowid[r] = c_rowid[j];
+        t_custkey[r] = c_custkey[j];
+        t_quantity[r] = l_quantity[i];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " After q18Join_t3_l" << std::endl;
 }
@@ -157,7 +124,7 @@ struct Q18GroupKey {
     int32_t o_orderkey;
     int32_t o_orderdate;
     int32_t o_totalprice;
-    std::string c_name;
+    cpu::StrKey<TPCH_READ_C_NAME_LEN + 1> c_name;
     int32_t c_custkey;
     bool operator==(const Q18GroupKey& other) const {
         return (c_name == other.c_name) && (c_custkey == other.c_custkey) && (o_orderkey == other.o_orderkey) &&
@@ -169,50 +136,41 @@ namespace std {
 template <>
 struct hash<Q18GroupKey> {
     std::size_t operator()(const Q18GroupKey& k) const {
-        using std::size_t;
-        using std::hash;
-        using std::string;
-        return (hash<string>()(k.c_name)) + (hash<int>()(k.c_custkey)) + (hash<int>()(k.o_orderkey)) +
-               (hash<int>()(k.o_orderdate)) + (hash<int>()(k.o_totalprice));
+        return cpu::hash64(cpu::key2(k.o_orderkey, k.c_custkey)) + (k.o_orderdate * 31 + k.o_totalprice) * 31 +
+               cpu::StrKeyHash()(k.c_name);
     }
 };
 }
 
 void q18GroupBy(Table& tin, Table& origintb, Table& tout) {
     std::cout << "DEBUG" << std::endl;
-    std::unordered_map<Q18GroupKey, int64_t> m;
+    typedef cpu::HashAgg<Q18GroupKey, int64_t> Agg;
     unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t o_orderkey = tin.getInt32(i, 0);
-        int32_t o_orderdate = tin.getInt32(i, 1);
-        int32_t o_totalprice = tin.getInt32(i, 2);
-        int32_t c_rowid = tin.getInt32(i, 3);
-        std::array<char, TPCH_READ_C_NAME_LEN + 1> c_name_array =
-            origintb.getcharN<char, TPCH_READ_C_NAME_LEN + 1>(c_rowid, 1);
-        std::string c_name = std::string(c_name_array.data());
-        int32_t c_custkey = tin.getInt32(i, 4);
-        int32_t l_quantity = tin.getInt32(i, 5);
-        Q18GroupKey k{o_orderkey, o_orderdate, o_totalprice, c_name, c_custkey};
-        auto it = m.find(k);
-        if (it != m.end()) {
-            int64_t s = it->second + l_quantity;
-            m[k] = s; // update
-        } else {
-            m.insert(std::make_pair(k, l_quantity));
-        }
-    }
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin, 0);
+    const int32_t* o_orderdate = cpu::col<int32_t>(tin, 1);
+    const int32_t* o_totalprice = cpu::col<int32_t>(tin, 2);
+    const int32_t* c_rowid = cpu::col<int32_t>(tin, 3);
+    const int32_t* c_custkey = cpu::col<int32_t>(tin, 4);
+    const int32_t* l_quantity = cpu::col<int32_t>(tin, 5);
+    Agg m = cpu::groupBy<Q18GroupKey, int64_t>(
+        nrow,
+        [&](Agg& h, size_t i) {
+            cpu::StrKey<TPCH_READ_C_NAME_LEN + 1> c_name(cpu::str<TPCH_READ_C_NAME_LEN + 1>(origintb, 1, c_rowid[i]));
+            h[Q18GroupKey{o_orderkey[i], o_orderdate[i], o_totalprice[i], c_name, c_custkey[i]}] += l_quantity[i];
+        },
+        [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : m) {
-        tout.setInt32(r, 0, it.first.o_orderkey);
-        tout.setInt32(r, 1, it.first.o_orderdate);
-        tout.setInt32(r, 2, it.first.o_totalprice);
+    m.forEach([&](const Q18GroupKey& k, int64_t& v) {
+        tout.setInt32(r, 0, k.o_orderkey);
+        tout.setInt32(r, 1, k.o_orderdate);
+        tout.setInt32(r, 2, k.o_totalprice);
         std::array<char, TPCH_READ_C_NAME_LEN + 1> c_name_array{};
-        memcpy(c_name_array.data(), (it.first.c_name).data(), (it.first.c_name).length());
+        memcpy(c_name_array.data(), k.c_name.s, TPCH_READ_C_NAME_LEN + 1);
         tout.setcharN<char, TPCH_READ_C_NAME_LEN + 1>(r, 3, c_name_array);
-        tout.setInt32(r, 4, it.first.c_custkey);
-        tout.setInt64(r, 5, it.second);
+        tout.setInt32(r, 4, k.c_custkey);
+        tout.setInt64(r, 5, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " After q18GroupBy" << std::endl;
 }
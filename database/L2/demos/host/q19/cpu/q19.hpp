@@ -13,282 +13,125 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-// t1
-void PartFilter1(Table& tin, Table& tout) {
+#include "cpu_engine.hpp"
+// one of the four containers of a q19 branch
+inline bool q19In(const char* s, const char* c0, const char* c1, const char* c2, const char* c3) {
+    return !strcmp(s, c0) || !strcmp(s, c1) || !strcmp(s, c2) || !strcmp(s, c3);
+}
+// p_partkey, p_size of parts with brand and one of the four containers
+int q19PartSel(Table& tin,
+               Table& tout,
+               const char* brand,
+               const char* c0,
+               const char* c1,
+               const char* c2,
+               const char* c3) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand = tin.getcharN<char, TPCH_READ_P_BRND_LEN + 1>(i, 1);
-        std::array<char, TPCH_READ_P_CNTR_LEN + 1> p_container = tin.getcharN<char, TPCH_READ_P_CNTR_LEN + 1>(i, 2);
-        if ((std::string(p_container.data()) == "SM CASE" || std::string(p_container.data()) == "SM BOX" ||
-             std::string(p_container.data()) == "SM PACK" || std::string(p_container.data()) == "SM PKG") &&
-            std::string(p_brand.data()) == "Brand#12") {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout.setInt32(r, 0, p_partkey);
-            tout.setInt32(r, 1, p_size);
-            r++;
-        }
-    }
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        return !strcmp(cpu::str<TPCH_READ_P_BRND_LEN + 1>(tin, 1, i), brand) &&
+               q19In(cpu::str<TPCH_READ_P_CNTR_LEN + 1>(tin, 2, i), c0, c1, c2, c3);
+    });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin, 3), sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
+    return r;
+}
+// t1
+void PartFilter1(Table& tin, Table& tout) {
+    int r = q19PartSel(tin, tout, "Brand#12", "SM CASE", "SM BOX", "SM PACK", "SM PKG");
     std::cout << std::dec << r << " after PartFilter1" << std::endl;
 }
+// the three brands are disjoint, so each branch is an independent filter
 void PartFilter_(Table& tin, Table& tout0, Table& tout1, Table& tout2) {
-    int nrow = tin.getNumRow();
-    int r0 = 0;
-    int r1 = 0;
-    int r2 = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand = tin.getcharN<char, TPCH_READ_P_BRND_LEN + 1>(i, 1);
-        std::array<char, TPCH_READ_P_CNTR_LEN + 1> p_container = tin.getcharN<char, TPCH_READ_P_CNTR_LEN + 1>(i, 2);
-        if (std::string(p_brand.data()) == "Brand#12" &&
-            (std::string(p_container.data()) == "SM CASE" || std::string(p_container.data()) == "SM BOX" ||
-             std::string(p_container.data()) == "SM PACK" || std::string(p_container.data()) == "SM PKG")) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout0.setInt32(r0, 0, p_partkey);
-            tout0.setInt32(r0, 1, p_size);
-            r0++;
-        } else if (std::string(p_brand.data()) == "Brand#23" &&
-                   (std::string(p_container.data()) == "MED BAG" || std::string(p_container.data()) == "MED BOX" ||
-                    std::string(p_container.data()) == "MED PKG" || std::string(p_container.data()) == "MED PACK")) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout1.setInt32(r1, 0, p_partkey);
-            tout1.setInt32(r1, 1, p_size);
-            r1++;
-        } else if (std::string(p_brand.data()) == "Brand#34" &&
-                   (std::string(p_container.data()) == "LG CASE" || std::string(p_container.data()) == "LG BOX" ||
-                    std::string(p_container.data()) == "LG PACK" || std::string(p_container.data()) == "LG PKG")) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout2.setInt32(r2, 0, p_partkey);
-            tout2.setInt32(r2, 1, p_size);
-            r2++;
-        }
-    }
-    tout0.setNumRow(r0);
-    tout1.setNumRow(r1);
-    tout2.setNumRow(r2);
+    int r0 = q19PartSel(tin, tout0, "Brand#12", "SM CASE", "SM BOX", "SM PACK", "SM PKG");
+    int r1 = q19PartSel(tin, tout1, "Brand#23", "MED BAG", "MED BOX", "MED PKG", "MED PACK");
+    int r2 = q19PartSel(tin, tout2, "Brand#34", "LG CASE", "LG BOX", "LG PACK", "LG PKG");
     std::cout << std::dec << r0 << " after_ PartFilter1" << std::endl;
     std::cout << std::dec << r1 << " after_ PartFilter2" << std::endl;
     std::cout << std::dec << r2 << " after_ PartFilter3" << std::endl;
 }
 void PartFilter(Table& tin, Table& tout0, Table& tout1, Table& tout2) {
-    std::unordered_map<std::string, int32_t> ht1;
-    std::unordered_map<std::string, int32_t> ht2;
-    std::unordered_map<std::string, int32_t> ht3;
-    ht1.insert(std::make_pair("SM PACK", 0));
-    ht1.insert(std::make_pair("SM CASE", 0));
-    ht1.insert(std::make_pair("SM BOX", 0));
-    ht1.insert(std::make_pair("SM PKG", 0));
-    ht2.insert(std::make_pair("MED BAG", 0));
-    ht2.insert(std::make_pair("MED BOX", 0));
-    ht2.insert(std::make_pair("MED PKG", 0));
-    ht2.insert(std::make_pair("MED PACK", 0));
-    ht3.insert(std::make_pair("LG CASE", 0));
-    ht3.insert(std::make_pair("LG BOX", 0));
-    ht3.insert(std::make_pair("LG PACK", 0));
-    ht3.insert(std::make_pair("LG PKG", 0));
-    int nrow = tin.getNumRow();
-    int r0 = 0;
-    int r1 = 0;
-    int r2 = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand = tin.getcharN<char, TPCH_READ_P_BRND_LEN + 1>(i, 1);
-        std::array<char, TPCH_READ_P_CNTR_LEN + 1> p_container = tin.getcharN<char, TPCH_READ_P_CNTR_LEN + 1>(i, 2);
-        if (std::string(p_brand.data()) == "Brand#12" && ht1.find(std::string(p_container.data())) != ht1.end()) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout0.setInt32(r0, 0, p_partkey);
-            tout0.setInt32(r0, 1, p_size);
-            r0++;
-        } else if (std::string(p_brand.data()) == "Brand#23" &&
-                   ht2.find(std::string(p_container.data())) != ht2.end()) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout1.setInt32(r1, 0, p_partkey);
-            tout1.setInt32(r1, 1, p_size);
-            r1++;
-        } else if (std::string(p_brand.data()) == "Brand#34" &&
-                   ht3.find(std::string(p_container.data())) != ht3.end()) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout2.setInt32(r2, 0, p_partkey);
-            tout2.setInt32(r2, 1, p_size);
-            r2++;
-        }
-    }
-    tout0.setNumRow(r0);
-    tout1.setNumRow(r1);
-    tout2.setNumRow(r2);
-    std::cout << std::dec << r0 << " after_ PartFilter1" << std::endl;
-    std::cout << std::dec << r1 << " after_ PartFilter2" << std::endl;
-    std::cout << std::dec << r2 << " after_ PartFilter3" << std::endl;
+    PartFilter_(tin, tout0, tout1, tout2);
 }
 // t2
 void LineFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_MAXAGG_LEN + 1> l_shipmode = tin.getcharN<char, TPCH_READ_MAXAGG_LEN + 1>(i, 4);
-        std::array<char, TPCH_READ_MAXAGG_LEN + 1> l_shipinstruct = tin.getcharN<char, TPCH_READ_MAXAGG_LEN + 1>(i, 5);
-        if ((std::string(l_shipmode.data()) == "AIR" || std::string(l_shipmode.data()) == "AIR REG") &&
-            std::string(l_shipinstruct.data()) == "DELIVER IN PERSON") {
-            int32_t l_partkey = tin.getInt32(i, 0);
-            int32_t l_quantity = tin.getInt32(i, 1);
-            int32_t l_extendedprice = tin.getInt32(i, 2);
-            int32_t l_discount = tin.getInt32(i, 3);
-            tout.setInt32(r, 0, l_partkey);
-            tout.setInt32(r, 1, l_quantity);
-            tout.setInt32(r, 2, l_extendedprice);
-            tout.setInt32(r, 3, l_discount);
-            r++;
-        }
-    }
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) {
+        const char* l_shipmode = cpu::str<TPCH_READ_MAXAGG_LEN + 1>(tin, 4, i);
+        const char* l_shipinstruct = cpu::str<TPCH_READ_MAXAGG_LEN + 1>(tin, 5, i);
+        return (!strcmp(l_shipmode, "AIR") || !strcmp(l_shipmode, "AIR REG")) &&
+               !strcmp(l_shipinstruct, "DELIVER IN PERSON");
+    });
+    for (int c = 0; c < 4; c++) cpu::gather(cpu::col<int32_t>(tin, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after LineFilter1" << std::endl;
 }
-// t3
-void q19Join_t1_t2(Table& tin1, Table& tin2, Table& tout) {
+// e = l_extendedprice * (100 - l_discount) of lineitems joined with parts of size [1, size_hi] and quantity in
+// [qty_lo, qty_hi]
+int q19JoinPart(Table& tin1, Table& tin2, Table& tout, int32_t size_hi, int32_t qty_lo, int32_t qty_hi) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int64_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t p_partkey = tin1.getInt32(i, 0);
-        int32_t p_size = tin1.getInt32(i, 1);
-        if (p_size >= 1 && p_size <= 5) {
-            ht1.insert(std::make_pair(p_partkey, p_size));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_quantity = tin2.getInt32(i, 1);
-        int32_t l_partkey = tin2.getInt32(i, 0);
-        if (l_quantity >= 1 && l_quantity <= 11) {
-            auto it = ht1.find(l_partkey);
-            if (it != ht1.end()) {
-                int32_t l_extendedprice = tin2.getInt32(i, 2);
-                int32_t l_discount = tin2.getInt32(i, 3);
-                int32_t e = l_extendedprice * (100 - l_discount);
-                tout.setInt32(r, 0, e);
-                r++;
-            }
-        }
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* p_size = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(cpu::select(nrow1, [&](uint32_t i) { return (p_size[i] >= 1) & (p_size[i] <= size_hi); }),
+              [&](uint32_t i) { return p_partkey[i]; });
+    const int32_t* l_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_quantity = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_extendedprice = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_discount = cpu::col<int32_t>(tin2, 3);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) {
+        return l_quantity[i] >= qty_lo && l_quantity[i] <= qty_hi && ht1.contains(l_partkey[i]);
+    });
+    int32_t* t_e = cpu::col<int32_t>(tout, 0);
+    cpu::parallelFor(sel.size(), [&](size_t r) {
+        uint32_t i = sel[r];
+        t_e[r] = l_extendedprice[i] * (100 - l_discount[i]);
+    });
+    int r = sel.size();
     tout.setNumRow(r);
+    return r;
+}
+// t3
+void q19Join_t1_t2(Table& tin1, Table& tin2, Table& tout) {
+    int r = q19JoinPart(tin1, tin2, tout, 5, 1, 11);
     std::cout << std::dec << r << " after q19Join_t1_t2" << std::endl;
 }
 // t4
 void PartFilter2(Table& tin, Table& tout) {
-    int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand = tin.getcharN<char, TPCH_READ_P_BRND_LEN + 1>(i, 1);
-        std::array<char, TPCH_READ_P_CNTR_LEN + 1> p_container = tin.getcharN<char, TPCH_READ_P_CNTR_LEN + 1>(i, 2);
-        if ((std::string(p_container.data()) == "MED BAG" || std::string(p_container.data()) == "MED BOX" ||
-             std::string(p_container.data()) == "MED PKG" || std::string(p_container.data()) == "MED PACK") &&
-            std::string(p_brand.data()) == "Brand#23") {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout.setInt32(r, 0, p_partkey);
-            tout.setInt32(r, 1, p_size);
-            r++;
-        }
-    }
-    tout.setNumRow(r);
+    int r = q19PartSel(tin, tout, "Brand#23", "MED BAG", "MED BOX", "MED PKG", "MED PACK");
     std::cout << std::dec << r << " after PartFilter2" << std::endl;
 }
 // t6
 void PartFilter3(Table& tin, Table& tout) {
-    int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_BRND_LEN + 1> p_brand = tin.getcharN<char, TPCH_READ_P_BRND_LEN + 1>(i, 1);
-        std::array<char, TPCH_READ_P_CNTR_LEN + 1> p_container = tin.getcharN<char, TPCH_READ_P_CNTR_LEN + 1>(i, 2);
-        if ((std::string(p_container.data()) == "LG CASE" || std::string(p_container.data()) == "LG BOX" ||
-             std::string(p_container.data()) == "LG PACK" || std::string(p_container.data()) == "LG PKG") &&
-            std::string(p_brand.data()) == "Brand#34") {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            int32_t p_size = tin.getInt32(i, 3);
-            tout.setInt32(r, 0, p_partkey);
-            tout.setInt32(r, 1, p_size);
-            r++;
-        }
-    }
-    tout.setNumRow(r);
+    int r = q19PartSel(tin, tout, "Brand#34", "LG CASE", "LG BOX", "LG PACK", "LG PKG");
     std::cout << std::dec << r << " after PartFilter3" << std::endl;
 }
 // t5
 void q19Join_t4_t2(Table& tin1, Table& tin2, Table& tout) {
-    int nrow1 = tin1.getNumRow();
-    int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int64_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t p_partkey = tin1.getInt32(i, 0);
-        int32_t p_size = tin1.getInt32(i, 1);
-        if (p_size >= 1 && p_size <= 10) {
-            ht1.insert(std::make_pair(p_partkey, p_size));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_quantity = tin2.getInt32(i, 1);
-        int32_t l_partkey = tin2.getInt32(i, 0);
-        if (l_quantity >= 10 && l_quantity <= 20) {
-            auto it = ht1.find(l_partkey);
-            if (it != ht1.end()) {
-                int32_t l_extendedprice = tin2.getInt32(i, 2);
-                int32_t l_discount = tin2.getInt32(i, 3);
-                int32_t e = l_extendedprice * (100 - l_discount);
-                tout.setInt32(r, 0, e);
-                r++;
-            }
-        }
-    }
-    tout.setNumRow(r);
+    int r = q19JoinPart(tin1, tin2, tout, 10, 10, 20);
     std::cout << std::dec << r << " after q19Join_t4_t2" << std::endl;
 }
 
 // t7
 void q19Join_t6_t2(Table& tin1, Table& tin2, Table& tout) {
-    int nrow1 = tin1.getNumRow();
-    int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int64_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t p_partkey = tin1.getInt32(i, 0);
-        int32_t p_size = tin1.getInt32(i, 1);
-        if (p_size >= 1 && p_size <= 15) {
-            ht1.insert(std::make_pair(p_partkey, p_size));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_quantity = tin2.getInt32(i, 1);
-        int32_t l_partkey = tin2.getInt32(i, 0);
-        if (l_quantity >= 20 && l_quantity <= 30) {
-            auto it = ht1.find(l_partkey);
-            if (it != ht1.end()) {
-                int32_t l_extendedprice = tin2.getInt32(i, 2);
-                int32_t l_discount = tin2.getInt32(i, 3);
-                int32_t e = l_extendedprice * (100 - l_discount);
-                tout.setInt32(r, 0, e);
-                r++;
-            }
-        }
-    }
-    tout.setNumRow(r);
+    int r = q19JoinPart(tin1, tin2, tout, 15, 20, 30);
     std::cout << std::dec << r << " after q19Join_t6_t2" << std::endl;
 }
 
 // t3 t5 t7
 int64_t q19GroupBy(Table& tin, Table& tout) {
-    int64_t sum = 0;
     unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t e = tin.getInt32(i, 0);
-        sum += e;
-    }
+    const int32_t* e = cpu::col<int32_t>(tin, 0);
+    std::vector<int64_t> sums(cpu::threadNum(), 0);
+    cpu::parallelMorsels(nrow, [&](int tid, size_t, size_t b, size_t end) {
+        int64_t sum = 0;
+        for (size_t i = b; i < end; i++) sum += e[i];
+        sums[tid] += sum;
+    });
+    int64_t sum = 0;
+    for (int t = 0; t < cpu::threadNum(); t++) sum += sums[t];
     return sum;
-    std::cout << std::dec << sum << " after q19Join_t6_t2" << std::endl;
 }
@@ -14,19 +14,15 @@
  * limitations under the License.
  */
 #include <regex>
+#include "cpu_engine.hpp"
 // 2388
 void PartFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        std::array<char, TPCH_READ_P_NAME_LEN + 1> p_name = tin.getcharN<char, TPCH_READ_P_NAME_LEN + 1>(i, 1);
-        // if(std::regex_match(p_name.data(), std::regex("(forest)(.*)"))){
-        if (std::string(p_name.data()).find("forest") == 0) {
-            int32_t p_partkey = tin.getInt32(i, 0);
-            tout.setInt32(r, 0, p_partkey);
-            r++;
-        }
-    }
+    // if(std::regex_match(p_name.data(), std::regex("(forest)(.*)"))){
+    cpu::SelVec sel = cpu::select(
+        nrow, [&](uint32_t i) { return !strncmp(cpu::str<TPCH_READ_P_NAME_LEN + 1>(tin, 1, i), "forest", 6); });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after PartFilter" << std::endl;
 }
@@ -34,24 +30,13 @@ void PartFilter(Table& tin, Table& tout) {
 void q20Join_t1_p(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t p_partkey = tin1.getInt32(i, 0);
-        ht1.insert(std::make_pair(p_partkey, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t ps_partkey = tin2.getInt32(i, 0);
-        auto it = ht1.find(ps_partkey);
-        if (it != ht1.end()) {
-            int32_t ps_suppkey = tin2.getInt32(i, 1);
-            int32_t ps_availqty = tin2.getInt32(i, 2);
-            tout.setInt32(r, 0, ps_partkey);
-            tout.setInt32(r, 1, ps_suppkey);
-            tout.setInt32(r, 2, ps_availqty);
-            r++;
-        }
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return p_partkey[i]; });
+    const int32_t* ps_partkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(ps_partkey[i]); });
+    for (int c = 0; c < 3; c++) cpu::gather(cpu::col<int32_t>(tin2, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q20Join_t1_p" << std::endl;
 }
@@ -65,43 +50,36 @@ struct Q20GroupKey {
 namespace std {
 template <>
 struct hash<Q20GroupKey> {
-    std::size_t operator()(const Q20GroupKey& k) const {
-        using std::size_t;
-        using std::hash;
-        return (hash<int>()(k.l_partkey)) + (hash<int>()(k.l_suppkey));
-    }
+    std::size_t operator()(const Q20GroupKey& k) const { return cpu::hash64(cpu::key2(k.l_partkey, k.l_suppkey)); }
 };
 }
 void q20GroupBy(Table& tin, Table& tout) {
-    std::unordered_map<Q20GroupKey, int64_t> m;
+    typedef cpu::HashAgg<Q20GroupKey, int64_t> Agg;
     unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t l_partkey = tin.getInt32(i, 0);
-        int32_t l_suppkey = tin.getInt32(i, 1);
-        int32_t l_shipdate = tin.getInt32(i, 2);
-        int32_t l_quantity = tin.getInt32(i, 3);
-        if (l_shipdate >= 19940101 && l_shipdate < 19950101) {
-            Q20GroupKey k{l_partkey, l_suppkey};
-            auto it = m.find(k);
-            if (it != m.end()) {
-                int64_t t = it->second + l_quantity;
-                m[k] = t;
-            } else {
-                m.insert(std::make_pair(k, l_quantity));
-            }
-        }
-    }
+    const int32_t* l_partkey = cpu::col<int32_t>(tin, 0);
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin, 1);
+    const int32_t* l_shipdate = cpu::col<int32_t>(tin, 2);
+    const int32_t* l_quantity = cpu::col<int32_t>(tin, 3);
+    cpu::SelVec sel =
+        cpu::select(nrow, [&](uint32_t i) { return (l_shipdate[i] >= 19940101) & (l_shipdate[i] < 19950101); });
+    Agg m = cpu::groupBy<Q20GroupKey, int64_t>(
+        sel.size(),
+        [&](Agg& h, size_t k) {
+            uint32_t i = sel[k];
+            h[Q20GroupKey{l_partkey[i], l_suppkey[i]}] += l_quantity[i];
+        },
+        [](int64_t& a, const int64_t& b) { a += b; });
     int r = 0;
-    for (auto& it : m) {
-        tout.setInt32(r, 0, it.first.l_partkey);
-        tout.setInt32(r, 1, it.first.l_suppkey);
-        int64_t sumall = 5 * it.second;
+    m.forEach([&](const Q20GroupKey& k, int64_t& v) {
+        tout.setInt32(r, 0, k.l_partkey);
+        tout.setInt32(r, 1, k.l_suppkey);
+        int64_t sumall = 5 * v;
         tout.setInt32(r, 2, sumall & 0x00000000ffffffff);
         tout.setInt32(r, 3, sumall >> 32);
         // if(r<10)std::cout<<tout.getInt32(r, 0)<<"  "<<tout.getInt32(r,1)<<"
         // "<<std::dec<<tout.getInt32(r,2)<<std::endl;
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " q20GroupBy" << std::endl;
 }
@@ -109,115 +87,91 @@ void q20GroupBy(Table& tin, Table& tout) {
 void q20Join_t2_t3(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<Q20GroupKey, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t p_partkey = tin1.getInt32(i, 0);
-        int32_t ps_suppkey = tin1.getInt32(i, 1);
-        int32_t ps_availqty = tin1.getInt32(i, 2);
-        Q20GroupKey k{p_partkey, ps_suppkey};
-        ht1.insert(std::make_pair(k, ps_availqty));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_partkey = tin2.getInt32(i, 0);
-        int32_t l_suppkey = tin2.getInt32(i, 1);
-        Q20GroupKey k = {l_partkey, l_suppkey};
-        auto it = ht1.find(k);
-        if (it != ht1.end()) {
-            int32_t ps_suppkey = it->first.l_suppkey;
-            int32_t ps_availqty = it->second;
-            // int64_t sum_t1 = tin2.getInt64(i,2);
-            int32_t sum_l = tin2.getInt32(i, 2);
-            int32_t sum_h = tin2.getInt32(i, 3);
-            tout.setInt32(r, 0, ps_suppkey);
-            tout.setInt32(r, 1, 10 * ps_availqty);
-            tout.setInt32(r, 2, sum_l);
-            tout.setInt32(r, 3, sum_h);
-            r++;
-        }
-    }
+    const int32_t* p_partkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* ps_suppkey = cpu::col<int32_t>(tin1, 1);
+    const int32_t* ps_availqty = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return cpu::key2(p_partkey[i], ps_suppkey[i]); });
+    const int32_t* l_partkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin2, 1);
+    // int64_t sum_t1 = tin2.getInt64(i,2);
+    const int32_t* sum_l = cpu::col<int32_t>(tin2, 2);
+    const int32_t* sum_h = cpu::col<int32_t>(tin2, 3);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return cpu::key2(l_partkey[i], l_suppkey[i]); });
+    int32_t* t_suppkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_availqty = cpu::col<int32_t>(tout, 1);
+    int32_t* t_sum_l = cpu::col<int32_t>(tout, 2);
+    int32_t* t_sum_h = cpu::col<int32_t>(tout, 3);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        uint32_t i = m[r].probe;
+        uint32_t j = m[r].build;
+        t_suppkey[r] = ps_suppkey[j];
+        t_availqty[r] = 10 * ps_availqty[j];
+        t_sum_l[r] = sum_l[i];
+        t_sum_h[r] = sum_h[i];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q20Join_t2_t3" << std::endl;
 }
 
 // filter table
 void q20Join_s_t4(Table& tin1, Table& tin2, Table& tout) {
-    struct q20KeyA {
-        int32_t s_nationkey;
-        int32_t s_rowid;
-    };
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, q20KeyA> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t s_suppkey = tin1.getInt32(i, 0);
-        int32_t s_nationkey = tin1.getInt32(i, 1);
-        int32_t s_rowid = i; // tin1.getInt32(i,1);
-        ht1.insert(std::make_pair(s_suppkey, q20KeyA{s_nationkey, s_rowid}));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t ps_suppkey = tin2.getInt32(i, 0);
-        int32_t ps_availqty = tin2.getInt32(i, 1);
-        int32_t sum_l = tin2.getInt32(i, 2);
-        int64_t sum_h = tin2.getInt32(i, 3);
-        int64_t sum = (sum_h << 32) + sum_l;
-        if (ps_availqty > sum) {
-            auto it = ht1.find(ps_suppkey);
-            if (it != ht1.end()) {
-                int32_t s_nationkey = it->second.s_nationkey;
-                int32_t s_rowid = it->second.s_rowid;
-                tout.setInt32(r, 0, s_nationkey);
-                tout.setInt32(r, 1, s_rowid);
-                r++;
-            }
-        }
-    }
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_suppkey[i]; });
+    const int32_t* ps_suppkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* ps_availqty = cpu::col<int32_t>(tin2, 1);
+    const int32_t* sum_l = cpu::col<int32_t>(tin2, 2);
+    const int32_t* sum_h = cpu::col<int32_t>(tin2, 3);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) {
+        int64_t sum = ((int64_t)sum_h[i] << 32) + sum_l[i];
+        return ps_availqty[i] > sum;
+    });
+    std::vector<cpu::Match> m = ht1.join(sel, [&](uint32_t i) { return ps_suppkey[i]; });
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 1);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_nationkey[r] = s_nationkey[m[r].build];
+        t_rowid[r] = m[r].build; // tin1.getInt32(i,1);
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q20Join_s_t4" << std::endl;
 }
 void q20Join_t4_s(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t ps_suppkey = tin1.getInt32(i, 0);
-        int32_t ps_availqty = tin1.getInt32(i, 1);
-        int32_t sum_l = tin1.getInt32(i, 2);
-        int64_t sum_h = tin1.getInt32(i, 3);
-        int64_t sum = (sum_h << 32) + sum_l;
-        if (ps_availqty > sum) {
-            ht1.insert(std::make_pair(ps_suppkey, 0));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t s_suppkey = tin2.getInt32(i, 0);
-        int32_t s_nationkey = tin2.getInt32(i, 1);
-        int32_t s_rowid = i; // tin1.getInt32(i,1);
-        auto it = ht1.find(s_suppkey);
-        if (it != ht1.end()) {
-            tout.setInt32(r, 0, s_nationkey);
-            tout.setInt32(r, 1, s_rowid);
-            r++;
-        }
-    }
+    const int32_t* ps_suppkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* ps_availqty = cpu::col<int32_t>(tin1, 1);
+    const int32_t* sum_l = cpu::col<int32_t>(tin1, 2);
+    const int32_t* sum_h = cpu::col<int32_t>(tin1, 3);
+    cpu::HashJoin ht1;
+    cpu::SelVec sel1 = cpu::select(nrow1, [&](uint32_t i) {
+        int64_t sum = ((int64_t)sum_h[i] << 32) + sum_l[i];
+        return ps_availqty[i] > sum;
+    });
+    ht1.build(sel1, [&](uint32_t i) { return ps_suppkey[i]; });
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(s_suppkey[i]); });
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 1);
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 0));
+    cpu::parallelFor(sel.size(), [&](size_t r) { t_rowid[r] = sel[r]; }); // tin1.getInt32(i,1);
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q20Join_t4_s" << std::endl;
 }
 // n_filter
 // t6
 void Filter_n(Table& tin, Table& tout) {
-    int r = 0;
     int nrow = tin.getNumRow();
-    for (int i = 0; i < nrow; i++) {
-        int32_t n_nationkey = tin.getInt32(i, 0);
-        std::array<char, TPCH_READ_NATION_LEN + 1> n_name = tin.getcharN<char, TPCH_READ_NATION_LEN + 1>(i, 1);
-        if (std::string(n_name.data()) == "CANADA") {
-            tout.setInt32(r, 0, n_nationkey);
-            r++;
-        }
-    }
+    cpu::SelVec sel = cpu::select(
+        nrow, [&](uint32_t i) { return !strcmp(cpu::str<TPCH_READ_NATION_LEN + 1>(tin, 1, i), "CANADA"); });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " Filter_n" << std::endl;
 }
@@ -225,24 +179,15 @@ void Filter_n(Table& tin, Table& tout) {
 void q20Join_t5_t6(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t s_nationkey = tin1.getInt32(i, 0);
-        int32_t s_rowid = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(s_nationkey, s_rowid));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t n_nationkey = tin2.getInt32(i, 0);
-        auto its = ht1.equal_range(n_nationkey);
-        auto it = its.first;
-        while (it != its.second) {
-            int32_t s_rowid = it->second;
-            tout.setInt32(r, 0, s_rowid);
-            it++;
-            r++;
-        }
-    }
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* s_rowid = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_nationkey[i]; });
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin2, 0);
+    std::vector<cpu::Match> m = ht1.join(nrow2, [&](uint32_t i) { return n_nationkey[i]; });
+    int32_t* t_rowid = cpu::col<int32_t>(tout, 0);
+    cpu::parallelFor(m.size(), [&](size_t r) { t_rowid[r] = s_rowid[m[r].build]; });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " q20Join_t5_t6" << std::endl;
 }
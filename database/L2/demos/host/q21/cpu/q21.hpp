@@ -14,40 +14,28 @@
  * limitations under the License.
  */
 #include <set>
+#include "cpu_engine.hpp"
 // t0
 void NationFilter(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        int32_t n_nationkey = tin.getInt32(i, 0);
-        std::array<char, TPCH_READ_NATION_LEN + 1> n_name = tin.getcharN<char, TPCH_READ_NATION_LEN + 1>(i, 1);
-        if (std::string(n_name.data()) == "SAUDI ARABIA") {
-            tout.setInt32(r, 0, n_nationkey);
-            r++;
-        }
-    }
+    cpu::SelVec sel = cpu::select(
+        nrow, [&](uint32_t i) { return !strcmp(cpu::str<TPCH_READ_NATION_LEN + 1>(tin, 1, i), "SAUDI ARABIA"); });
+    cpu::gather(cpu::col<int32_t>(tin, 0), sel, cpu::col<int32_t>(tout, 0));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after NationFilter" << std::endl;
 }
 void q21Join_n_s(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t n_nationkey = tin1.getInt32(i, 0);
-        ht1.insert(std::make_pair(n_nationkey, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t s_suppkey = tin2.getInt32(i, 0);
-        int32_t s_nationkey = tin2.getInt32(i, 1);
-        auto it = ht1.find(s_nationkey);
-        if (it != ht1.end()) {
-            tout.setInt32(r, 0, s_suppkey);
-            tout.setInt32(r, 1, s_nationkey);
-            r++;
-        }
-    }
+    const int32_t* n_nationkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return n_nationkey[i]; });
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin2, 1);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(s_nationkey[i]); });
+    cpu::gather(cpu::col<int32_t>(tin2, 0), sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(s_nationkey, sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q21Join_n_s" << std::endl;
 }
@@ -55,28 +43,25 @@ void q21Join_n_s(Table& tin1, Table& tin2, Table& tout) {
 void q21Join_t0_l(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t s_suppkey = tin1.getInt32(i, 0);
-        int32_t s_nationkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(s_suppkey, s_nationkey));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        int32_t l_suppkey = tin2.getInt32(i, 1);
-        int32_t l_receiptdate = tin2.getInt32(i, 2);
-        int32_t l_commitdate = tin2.getInt32(i, 3);
-        if (l_receiptdate > l_commitdate) {
-            auto it = ht1.find(l_suppkey);
-            if (it != ht1.end()) {
-                tout.setInt32(r, 0, l_orderkey);
-                tout.setInt32(r, 1, it->second);
-                tout.setInt32(r, 2, l_suppkey);
-                r++;
-            }
-        }
-    }
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* s_nationkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return s_suppkey[i]; });
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* l_suppkey = cpu::col<int32_t>(tin2, 1);
+    const int32_t* l_receiptdate = cpu::col<int32_t>(tin2, 2);
+    const int32_t* l_commitdate = cpu::col<int32_t>(tin2, 3);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return l_receiptdate[i] > l_commitdate[i]; });
+    std::vector<cpu::Match> m = ht1.join(sel, [&](uint32_t i) { return l_suppkey[i]; });
+    int32_t* t_orderkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_nationkey = cpu::col<int32_t>(tout, 1);
+    int32_t* t_suppkey = cpu::col<int32_t>(tout, 2);
+    cpu::parallelFor(m.size(), [&](size_t r) {
+        t_orderkey[r] = l_orderkey[m[r].probe];
+        t_nationkey[r] = s_nationkey[m[r].build];
+        t_suppkey[r] = l_suppkey[m[r].probe];
+    });
+    int r = m.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q21Join_t0_l" << std::endl;
 }
@@ -84,202 +69,109 @@ void q21Join_t0_l(Table& tin1, Table& tin2, Table& tout) {
 void q21Join_o_t1(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_orderkey = tin1.getInt32(i, 0);
-        int32_t o_orderstatus = tin1.getInt32(i, 1);
-        if (o_orderstatus == 'F') {
-            ht1.insert(std::make_pair(o_orderkey, 0));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        int32_t s_nationkey = tin2.getInt32(i, 1);
-        int32_t l_suppkey = tin2.getInt32(i, 2);
-        auto it = ht1.find(l_orderkey);
-        if (it != ht1.end()) {
-            tout.setInt32(r, 0, l_orderkey);
-            tout.setInt32(r, 1, s_nationkey);
-            tout.setInt32(r, 2, l_suppkey);
-            r++;
-        }
-    }
+    const int32_t* o_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* o_orderstatus = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(cpu::select(nrow1, [&](uint32_t i) { return o_orderstatus[i] == 'F'; }),
+              [&](uint32_t i) { return o_orderkey[i]; });
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) { return ht1.contains(l_orderkey[i]); });
+    for (int c = 0; c < 3; c++) cpu::gather(cpu::col<int32_t>(tin2, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q21Join_o_t1" << std::endl;
 }
-struct Q21AntiKey {
-    int32_t l_orderkey;
-    int32_t l_suppkey;
-    // std::array
-
-    bool operator==(const Q21AntiKey& other) const {
-        return (l_orderkey == other.l_orderkey) && (l_suppkey != other.l_suppkey);
-    }
-};
-namespace std {
-
-template <>
-struct hash<Q21AntiKey> {
-    std::size_t operator()(const Q21AntiKey& k) const {
-        using std::size_t;
-        using std::hash;
-        return (hash<int>()(k.l_orderkey));
-    }
-};
-}
+// Semi/anti join on "same l_orderkey, other l_suppkey": the build side is keyed on l_orderkey only and the
+// supplier is compared per matching row.
 // t3
 void q21SemiJoin_l_t2(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<Q21AntiKey, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t l_orderkey = tin1.getInt32(i, 0);
-        int32_t l_suppkey = tin1.getInt32(i, 1);
-        ht1.insert(std::make_pair(Q21AntiKey{l_orderkey, l_suppkey}, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        int32_t s_nationkey = tin2.getInt32(i, 1);
-        int32_t s_suppkey = tin2.getInt32(i, 2);
-        Q21AntiKey k = {l_orderkey, s_suppkey};
-        auto it = ht1.find(k);
-        if (it != ht1.end()) {
-            //            if(r<10) std::cout<<l_orderkey<<" "<<it->first.l_orderkey<<std::endl;
-            //            if(r<10) std::cout<<s_suppkey<<" "<<it->first.l_suppkey<<std::endl;
-            tout.setInt32(r, 0, l_orderkey);
-            tout.setInt32(r, 1, s_nationkey);
-            tout.setInt32(r, 2, s_suppkey);
-            r++;
-        }
-    }
+    const int32_t* b_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* b_suppkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return b_orderkey[i]; });
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin2, 2);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) {
+        return ht1.any(l_orderkey[i], [&](uint32_t j) { return b_suppkey[j] != s_suppkey[i]; });
+    });
+    for (int c = 0; c < 3; c++) cpu::gather(cpu::col<int32_t>(tin2, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q21SemiJoin_l_t2" << std::endl;
 }
+// late lineitems of tin1, keyed on l_orderkey
+void q21BuildLate(Table& tin1, cpu::HashJoin& ht1) {
+    int nrow1 = tin1.getNumRow();
+    const int32_t* b_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* l_receiptdate = cpu::col<int32_t>(tin1, 2);
+    const int32_t* l_commitdate = cpu::col<int32_t>(tin1, 3);
+    ht1.build(cpu::select(nrow1, [&](uint32_t i) { return l_receiptdate[i] > l_commitdate[i]; }),
+              [&](uint32_t i) { return b_orderkey[i]; });
+}
 // t4
 void q21SemiJoin_l_t3(Table& tin1, Table& tin2, Table& tout) {
-    int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<Q21AntiKey, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t l_orderkey = tin1.getInt32(i, 0);
-        int32_t l_suppkey = tin1.getInt32(i, 1);
-        int32_t l_receiptdate = tin1.getInt32(i, 2);
-        int32_t l_commitdate = tin1.getInt32(i, 3);
-        if (l_receiptdate > l_commitdate) {
-            ht1.insert(std::make_pair(Q21AntiKey{l_orderkey, l_suppkey}, 0));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        int32_t s_nationkey = tin2.getInt32(i, 1);
-        int32_t s_suppkey = tin2.getInt32(i, 2);
-        Q21AntiKey k = {l_orderkey, s_suppkey};
-        auto it = ht1.find(k);
-        if (it != ht1.end()) {
-            tout.setInt32(r, 0, l_orderkey);
-            tout.setInt32(r, 1, s_nationkey);
-            tout.setInt32(r, 2, s_suppkey);
-            r++;
-        }
-    }
+    const int32_t* b_suppkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    q21BuildLate(tin1, ht1);
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin2, 2);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) {
+        return ht1.any(l_orderkey[i], [&](uint32_t j) { return b_suppkey[j] != s_suppkey[i]; });
+    });
+    for (int c = 0; c < 3; c++) cpu::gather(cpu::col<int32_t>(tin2, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q21SemiJoin_l_t3" << std::endl;
 }
-struct KeyA {
-    int32_t l_orderkey;
-    int32_t l_suppkey;
-    bool operator==(const KeyA& other) const {
-        return (l_orderkey == other.l_orderkey) && (l_suppkey == other.l_suppkey);
-    }
-};
-namespace std {
-
-template <>
-struct hash<KeyA> {
-    std::size_t operator()(const KeyA& k) const {
-        using std::size_t;
-        using std::hash;
-        return (hash<int>()(k.l_orderkey)) + (hash<int>()(k.l_suppkey));
-    }
-};
-}
 void q21AntiJoin_t4_t3(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<KeyA, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t l_orderkey = tin1.getInt32(i, 0);
-        int32_t l_suppkey = tin1.getInt32(i, 2);
-        ht1.insert(std::make_pair(KeyA{l_orderkey, l_suppkey}, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        int32_t s_nationkey = tin2.getInt32(i, 1);
-        int32_t s_suppkey = tin2.getInt32(i, 2);
-        KeyA k = {l_orderkey, s_suppkey};
-        auto it = ht1.find(k);
-        if (it == ht1.end()) {
-            tout.setInt32(r, 0, s_suppkey);
-            tout.setInt32(r, 1, s_nationkey);
-            r++;
-        }
-    }
+    const int32_t* b_orderkey = cpu::col<int32_t>(tin1, 0);
+    const int32_t* b_suppkey = cpu::col<int32_t>(tin1, 2);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return cpu::key2(b_orderkey[i], b_suppkey[i]); });
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin2, 2);
+    cpu::SelVec sel =
+        cpu::select(nrow2, [&](uint32_t i) { return !ht1.contains(cpu::key2(l_orderkey[i], s_suppkey[i])); });
+    cpu::gather(s_suppkey, sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q21AntiJoin_t4_t3" << std::endl;
 }
 // cancle in this file
 void q21AntiJoin_l_t3(Table& tin1, Table& tin2, Table& tout) {
-    int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_multimap<Q21AntiKey, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t l_orderkey = tin1.getInt32(i, 0);
-        int32_t l_suppkey = tin1.getInt32(i, 1);
-        int32_t l_receiptdate = tin1.getInt32(i, 2);
-        int32_t l_commitdate = tin1.getInt32(i, 3);
-        if (l_receiptdate > l_commitdate) {
-            ht1.insert(std::make_pair(Q21AntiKey{l_orderkey, l_suppkey}, 0));
-        }
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t l_orderkey = tin2.getInt32(i, 0);
-        int32_t s_nationkey = tin2.getInt32(i, 1);
-        int32_t s_suppkey = tin2.getInt32(i, 2);
-        Q21AntiKey k = {l_orderkey, s_suppkey};
-        auto it = ht1.find(k);
-        if (it == ht1.end()) {
-            tout.setInt32(r, 0, s_suppkey);
-            tout.setInt32(r, 1, s_nationkey);
-            r++;
-        }
-    }
+    const int32_t* b_suppkey = cpu::col<int32_t>(tin1, 1);
+    cpu::HashJoin ht1;
+    q21BuildLate(tin1, ht1);
+    const int32_t* l_orderkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin2, 2);
+    cpu::SelVec sel = cpu::select(nrow2, [&](uint32_t i) {
+        return !ht1.any(l_orderkey[i], [&](uint32_t j) { return b_suppkey[j] != s_suppkey[i]; });
+    });
+    cpu::gather(s_suppkey, sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin2, 1), sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q21AntiJoin_l_t3" << std::endl;
 }
 void q21Group_t4(Table& tin, Table& tout) {
+    typedef cpu::HashAgg<int32_t, int32_t> Agg;
     int nrow = tin.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow; i++) {
-        int32_t s_suppkey = tin.getInt32(i, 0);
-        auto it = ht1.find(s_suppkey);
-        if (it != ht1.end()) {
-            int32_t t = it->second + 1;
-            ht1[s_suppkey] = t;
-        } else {
-            ht1.insert(std::make_pair(s_suppkey, 1));
-        }
-    }
+    const int32_t* s_suppkey = cpu::col<int32_t>(tin, 0);
+    Agg ht1 = cpu::groupBy<int32_t, int32_t>(nrow, [&](Agg& h, size_t i) { h[s_suppkey[i]]++; },
+                                              [](int32_t& a, const int32_t& b) { a += b; });
     int r = 0;
-    for (auto& it : ht1) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt32(r, 1, it.second);
+    ht1.forEach([&](const int32_t& k, int32_t& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt32(r, 1, v);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q21Group_t4" << std::endl;
 }
@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cpu_engine.hpp"
 // only for host
 bool c_phone_int_in(int32_t c_phone_int) {
     if (c_phone_int == (('1' << 8) + ('3')) || c_phone_int == (('3' << 8) + ('1')) ||
@@ -26,19 +27,17 @@ bool c_phone_int_in(int32_t c_phone_int) {
 // customer->t1
 void Substring(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
-    for (int i = 0; i < nrow; i++) {
-        int32_t c_custkey = tin.getInt32(i, 0);
-        std::array<char, TPCH_READ_PHONE_LEN + 1> c_phone = tin.getcharN<char, TPCH_READ_PHONE_LEN + 1>(i, 1);
-        int32_t c_acctbal = tin.getInt32(i, 2);
-        int c_phone_int = 0;
-        for (int j = 1; j >= 0; j--) {
-            int subint = c_phone.at(1 - j) << (8 * j);
-            c_phone_int += subint;
-        }
-        tout.setInt32(i, 0, c_custkey);
-        tout.setInt32(i, 1, c_phone_int);
-        tout.setInt32(i, 2, c_acctbal);
-    }
+    const int32_t* c_custkey = cpu::col<int32_t>(tin, 0);
+    const int32_t* c_acctbal = cpu::col<int32_t>(tin, 2);
+    int32_t* t_custkey = cpu::col<int32_t>(tout, 0);
+    int32_t* t_phone_int = cpu::col<int32_t>(tout, 1);
+    int32_t* t_acctbal = cpu::col<int32_t>(tout, 2);
+    cpu::parallelFor(nrow, [&](size_t i) {
+        const char* c_phone = cpu::str<TPCH_READ_PHONE_LEN + 1>(tin, 1, i);
+        t_custkey[i] = c_custkey[i];
+        t_phone_int[i] = (c_phone[0] << 8) + c_phone[1];
+        t_acctbal[i] = c_acctbal[i];
+    });
     tout.setNumRow(nrow);
     std::cout << std::dec << nrow << " after Substring of Customer" << std::endl;
 }
@@ -51,18 +50,28 @@ bool iswrong(int32_t c) {
 }
 int32_t Group_AVG(Table& tin, Table& tout) {
     int nrow = tin.getNumRow();
+    const int32_t* c_phone_int = cpu::col<int32_t>(tin, 1);
+    const int32_t* c_acctbal = cpu::col<int32_t>(tin, 2);
+    std::vector<int64_t> sums(cpu::threadNum(), 0);
+    std::vector<int> cnts(cpu::threadNum(), 0);
+    // if(c==1741||c==34434||c==36078||c==146548){
+    //    std::cout<<c_acctbal<<std::endl;
+    // }
+    auto rowOf = [](size_t i) { return (uint32_t)i; };
+    auto pred = [&](uint32_t i) { return c_acctbal[i] > 0 && c_phone_int_in(c_phone_int[i]); }; //&&iswrong(c)){
+    cpu::parallelMorsels(nrow, [&](int tid, size_t, size_t b, size_t e) {
+        uint32_t sel[cpu::MORSEL_ROWS];
+        size_t n = cpu::selectMorsel(b, e, rowOf, pred, sel);
+        int64_t sum = 0;
+        for (size_t k = 0; k < n; k++) sum += c_acctbal[sel[k]];
+        sums[tid] += sum;
+        cnts[tid] += n;
+    });
     int64_t sum = 0;
     int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        int32_t c_phone_int = tin.getInt32(i, 1);
-        int32_t c_acctbal = tin.getInt32(i, 2);
-        // if(c==1741||c==34434||c==36078||c==146548){
-        //    std::cout<<c_acctbal<<std::endl;
-        // }
-        if (c_acctbal > 0 && c_phone_int_in(c_phone_int)) { //&&iswrong(c)){
-            sum += c_acctbal;
-            r++;
-        }
+    for (int t = 0; t < cpu::threadNum(); t++) {
+        sum += sums[t];
+        r += cnts[t];
     }
     std::cout << std::dec << "count:" << r << " avg is: " << 100 * sum / r << std::endl;
     return sum / r;
@@ -71,18 +80,10 @@ int32_t Group_AVG(Table& tin, Table& tout) {
 // t1->t2
 void customerFilter_c_acctbal(Table& tin, Table& tout, int32_t avg_acct) {
     int nrow = tin.getNumRow();
-    int r = 0;
-    for (int i = 0; i < nrow; i++) {
-        int32_t c_custkey = tin.getInt32(i, 0);
-        int32_t c_phone_int = tin.getInt32(i, 1);
-        int32_t c_acctbal = tin.getInt32(i, 2);
-        if (c_acctbal > avg_acct) {
-            tout.setInt32(r, 0, c_custkey);
-            tout.setInt32(r, 1, c_phone_int);
-            tout.setInt32(r, 2, c_acctbal);
-            r++;
-        }
-    }
+    const int32_t* c_acctbal = cpu::col<int32_t>(tin, 2);
+    cpu::SelVec sel = cpu::select(nrow, [&](uint32_t i) { return c_acctbal[i] > avg_acct; });
+    for (int c = 0; c < 3; c++) cpu::gather(cpu::col<int32_t>(tin, c), sel, cpu::col<int32_t>(tout, c));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after customerFilter_c_acctbal" << std::endl;
 }
@@ -90,23 +91,16 @@ void customerFilter_c_acctbal(Table& tin, Table& tout, int32_t avg_acct) {
 void q22AntiJoin_o_t2(Table& tin1, Table& tin2, Table& tout) {
     int nrow1 = tin1.getNumRow();
     int nrow2 = tin2.getNumRow();
-    std::unordered_map<int32_t, int32_t> ht1;
-    for (int i = 0; i < nrow1; i++) {
-        int32_t o_custkey = tin1.getInt32(i, 0);
-        ht1.insert(std::make_pair(o_custkey, 0));
-    }
-    int r = 0;
-    for (int i = 0; i < nrow2; i++) {
-        int32_t c_phone_int = tin2.getInt32(i, 1);
-        int32_t c_custkey = tin2.getInt32(i, 0);
-        int32_t c_acctbal = tin2.getInt32(i, 2);
-        auto it = ht1.find(c_custkey);
-        if (c_phone_int_in(c_phone_int) && it == ht1.end()) {
-            tout.setInt32(r, 0, c_phone_int);
-            tout.setInt32(r, 1, c_acctbal);
-            r++;
-        }
-    }
+    const int32_t* o_custkey = cpu::col<int32_t>(tin1, 0);
+    cpu::HashJoin ht1;
+    ht1.build(nrow1, [&](uint32_t i) { return o_custkey[i]; });
+    const int32_t* c_custkey = cpu::col<int32_t>(tin2, 0);
+    const int32_t* c_phone_int = cpu::col<int32_t>(tin2, 1);
+    cpu::SelVec sel = cpu::select(
+        nrow2, [&](uint32_t i) { return c_phone_int_in(c_phone_int[i]) && !ht1.contains(c_custkey[i]); });
+    cpu::gather(c_phone_int, sel, cpu::col<int32_t>(tout, 0));
+    cpu::gather(cpu::col<int32_t>(tin2, 2), sel, cpu::col<int32_t>(tout, 1));
+    int r = sel.size();
     tout.setNumRow(r);
     std::cout << std::dec << r << " after q22AntiJoin_t1_t2" << std::endl;
 }
@@ -115,28 +109,28 @@ void q22GroupBy(Table& tin, Table& tout) {
         int32_t numcust;
         int64_t sumacct;
     };
-    std::unordered_map<int32_t, q22Groupload> m;
+    typedef cpu::HashAgg<int32_t, q22Groupload> Agg;
     unsigned nrow = tin.getNumRow();
-    for (size_t i = 0; i < nrow; ++i) {
-        int32_t c_phone_int = tin.getInt32(i, 0);
-        int32_t c_acctbal = tin.getInt32(i, 1);
-        auto it = m.find(c_phone_int);
-        if (it != m.end()) {
-            int32_t s0 = it->second.numcust + 1;
-            int64_t s1 = it->second.sumacct + c_acctbal;
-            m[c_phone_int].numcust = s0; // update
-            m[c_phone_int].sumacct = s1; // update
-        } else {
-            m.insert(std::make_pair(c_phone_int, q22Groupload{1, c_acctbal}));
-        }
-    }
+    const int32_t* c_phone_int = cpu::col<int32_t>(tin, 0);
+    const int32_t* c_acctbal = cpu::col<int32_t>(tin, 1);
+    Agg m = cpu::groupBy<int32_t, q22Groupload>(
+        nrow,
+        [&](Agg& h, size_t i) {
+            q22Groupload& v = h[c_phone_int[i]];
+            v.numcust++;
+            v.sumacct += c_acctbal[i];
+        },
+        [](q22Groupload& a, const q22Groupload& b) {
+            a.numcust += b.numcust;
+            a.sumacct += b.sumacct;
+        });
     int r = 0;
-    for (auto& it : m) {
-        tout.setInt32(r, 0, it.first);
-        tout.setInt32(r, 1, it.second.numcust);
-        tout.setInt64(r, 2, it.second.sumacct);
+    m.forEach([&](const int32_t& k, q22Groupload& v) {
+        tout.setInt32(r, 0, k);
+        tout.setInt32(r, 1, v.numcust);
+        tout.setInt64(r, 2, v.sumacct);
         ++r;
-    }
+    });
     tout.setNumRow(r);
     std::cout << std::dec << r << " After q22GroupBy" << std::endl;
 }
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GQE_BLOOM_FILTER_PART_HPP
+#define GQE_BLOOM_FILTER_PART_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+#include "xf_database/bloom_filter.hpp"
+#include "xf_database/hash_lookup3.hpp"
+
+#include "gqe_blocks/gqe_types.hpp"
+
+#ifndef __SYNTHESIS__
+#include <iostream>
+#endif
+
+namespace xf {
+namespace database {
+namespace gqe {
+
+// the same key as hash partition, second column only with dual key
+template <int COL_NM>
+ap_uint<64> bf_key(bool mk_on, ap_uint<8 * TPCH_INT_SZ> d[COL_NM]) {
+#pragma HLS inline
+    ap_uint<64> key;
+    key.range(31, 0) = d[0];
+    key.range(63, 32) = mk_on ? d[1] : ap_uint<8 * TPCH_INT_SZ>(0);
+    return key;
+}
+
+// pass the rows through, hash the keys for the bit vectors
+template <int COL_NM, int BFW>
+void bf_hash_key(bool mk_on,
+                 hls::stream<ap_uint<8 * TPCH_INT_SZ> > in_strm[COL_NM],
+                 hls::stream<bool>& e_in_strm,
+                 hls::stream<ap_uint<8 * TPCH_INT_SZ> > out_strm[COL_NM],
+                 hls::stream<bool>& e_out_strm,
+                 hls::stream<ap_uint<BFW> >& hash0_strm,
+                 hls::stream<ap_uint<BFW> >& hash1_strm,
+                 hls::stream<bool>& e_hash_strm) {
+    ap_uint<8 * TPCH_INT_SZ> d[COL_NM];
+#pragma HLS array_partition variable = d complete
+
+    bool e = e_in_strm.read();
+    while (!e) {
+#pragma HLS pipeline II = 1
+        for (int c = 0; c < COL_NM; ++c) {
+#pragma HLS unroll
+            d[c] = in_strm[c].read();
+            out_strm[c].write(d[c]);
+        }
+        ap_uint<64> hash;
+        xf::database::details::hashlookup3_core<64>(bf_key<COL_NM>(mk_on, d), hash);
+        hash0_strm.write(hash(BFW - 1, 0));
+        hash1_strm.write(hash(2 * BFW - 1, BFW));
+        e_hash_strm.write(false);
+        e_out_strm.write(false);
+        e = e_in_strm.read();
+    }
+    e_hash_strm.write(true);
+    e_out_strm.write(true);
+}
+
+template <int COL_NM, int BFW>
+void bf_build(bool mk_on,
+              hls::stream<ap_uint<8 * TPCH_INT_SZ> > in_strm[COL_NM],
+              hls::stream<bool>& e_in_strm,
+              hls::stream<ap_uint<8 * TPCH_INT_SZ> > out_strm[COL_NM],
+              hls::stream<bool>& e_out_strm,
+              ap_uint<72>* bv0,
+              ap_uint<72>* bv1) {
+#pragma HLS dataflow
+
+    hls::stream<ap_uint<BFW> > hash0_strm;
+#pragma HLS stream variable = hash0_strm depth = 8
+    hls::stream<ap_uint<BFW> > hash1_strm;
+#pragma HLS stream variable = hash1_strm depth = 8
+    hls::stream<bool> e_hash_strm;
+#pragma HLS stream variable = e_hash_strm depth = 8
+
+    bf_hash_key<COL_NM, BFW>(mk_on, in_strm, e_in_strm, out_strm, e_out_strm, hash0_strm, hash1_strm, e_hash_strm);
+    xf::database::details::bv_update_uram<BFW>(hash0_strm, hash1_strm, e_hash_strm, bv0, bv1);
+}
+
+// keep only the rows whose key hits both bit vectors
+template <int COL_NM, int BFW>
+void bf_probe(bool mk_on,
+              hls::stream<ap_uint<8 * TPCH_INT_SZ> > in_strm[COL_NM],
+              hls::stream<bool>& e_in_strm,
+              hls::stream<ap_uint<8 * TPCH_INT_SZ> > out_strm[COL_NM],
+              hls::stream<bool>& e_out_strm,
+              ap_uint<72>* bv0,
+              ap_uint<72>* bv1) {
+    ap_uint<8 * TPCH_INT_SZ> d[COL_NM];
+#pragma HLS array_partition variable = d complete
+
+#ifndef __SYNTHESIS__
+    int cnt = 0, hit = 0;
+#endif
+
+    bool e = e_in_strm.read();
+    while (!e) {
+#pragma HLS pipeline II = 1
+        for (int c = 0; c < COL_NM; ++c) {
+#pragma HLS unroll
+            d[c] = in_strm[c].read();
+        }
+        ap_uint<64> hash;
+        xf::database::details::hashlookup3_core<64>(bf_key<COL_NM>(mk_on, d), hash);
+        ap_uint<BFW> h0 = hash(BFW - 1, 0);
+        ap_uint<BFW> h1 = hash(2 * BFW - 1, BFW);
+        ap_uint<72> w0 = bv0[h0(BFW - 1, 6)];
+        ap_uint<72> w1 = bv1[h1(BFW - 1, 6)];
+        if (w0[h0(5, 0)] && w1[h1(5, 0)]) {
+            for (int c = 0; c < COL_NM; ++c) {
+#pragma HLS unroll
+                out_strm[c].write(d[c]);
+            }
+            e_out_strm.write(false);
+#ifndef __SYNTHESIS__
+            hit++;
+#endif
+        }
+#ifndef __SYNTHESIS__
+        cnt++;
+#endif
+        e = e_in_strm.read();
+    }
+    e_out_strm.write(true);
+
+#ifndef __SYNTHESIS__
+    std::cout << "Bloom filter kept " << hit << " of " << cnt << " rows" << std::endl;
+#endif
+}
+
+// the two vectors go to memory back to back, 8 words of 64 bits per line
+template <int BFW>
+void bf_write(ap_uint<72>* bv0, ap_uint<72>* bv1, ap_uint<8 * TPCH_INT_SZ * VEC_LEN>* buf_bf) {
+    const int N = 1 << (BFW - 6);
+    ap_uint<8 * TPCH_INT_SZ * VEC_LEN> line = 0;
+    for (int i = 0; i < 2 * N; i++) {
+#pragma HLS pipeline II = 1
+        ap_uint<72> w = i < N ? bv0[i] : bv1[i - N];
+        line.range(64 * (i % 8) + 63, 64 * (i % 8)) = w(63, 0);
+        if (i % 8 == 7) buf_bf[i / 8] = line;
+    }
+}
+
+template <int BFW>
+void bf_read(ap_uint<8 * TPCH_INT_SZ * VEC_LEN>* buf_bf, ap_uint<72>* bv0, ap_uint<72>* bv1) {
+    const int N = 1 << (BFW - 6);
+    ap_uint<8 * TPCH_INT_SZ * VEC_LEN> line;
+    for (int i = 0; i < 2 * N; i++) {
+#pragma HLS pipeline II = 1
+        if (i % 8 == 0) line = buf_bf[i / 8];
+        ap_uint<72> w = line.range(64 * (i % 8) + 63, 64 * (i % 8));
+        if (i < N) {
+            bv0[i] = w;
+        } else {
+            bv1[i - N] = w;
+        }
+    }
+}
+
+/**
+ * @brief bloom filter pushdown from the build table to the probe table of a join.
+ *
+ * With bf_mode 1, rows pass through unchanged and their keys are added to the filter,
+ * which is written to buf_bf at the end. With bf_mode 2, the filter is read from buf_bf
+ * first, and rows whose key cannot be in the build table are dropped. bf_mode 0 is bypass.
+ * The filter takes ``2 ^ (BFW - 2)`` bytes in buf_bf.
+ */
+template <int COL_NM, int BFW>
+void bloom_filter_part(ap_uint<2> bf_mode,
+                       bool mk_on,
+                       ap_uint<8 * TPCH_INT_SZ * VEC_LEN>* buf_bf,
+                       hls::stream<ap_uint<8 * TPCH_INT_SZ> > in_strm[COL_NM],
+                       hls::stream<bool>& e_in_strm,
+                       hls::stream<ap_uint<8 * TPCH_INT_SZ> > out_strm[COL_NM],
+                       hls::stream<bool>& e_out_strm) {
+    ap_uint<72> bv0[1 << (BFW - 6)];
+#pragma HLS resource variable = bv0 core = RAM_2P_URAM
+    ap_uint<72> bv1[1 << (BFW - 6)];
+#pragma HLS resource variable = bv1 core = RAM_2P_URAM
+
+    if (bf_mode == 1) {
+        for (int i = 0; i < (1 << (BFW - 6)); i++) {
+#pragma HLS pipeline II = 1
+            bv0[i] = 0;
+            bv1[i] = 0;
+        }
+        bf_build<COL_NM, BFW>(mk_on, in_strm, e_in_strm, out_strm, e_out_strm, bv0, bv1);
+        bf_write<BFW>(bv0, bv1, buf_bf);
+    } else if (bf_mode == 2) {
+        bf_read<BFW>(buf_bf, bv0, bv1);
+        bf_probe<COL_NM, BFW>(mk_on, in_strm, e_in_strm, out_strm, e_out_strm, bv0, bv1);
+    } else {
+        // bypass
+        bool e = e_in_strm.read();
+        while (!e) {
+#pragma HLS pipeline II = 1
+            for (int c = 0; c < COL_NM; ++c) {
+#pragma HLS unroll
+                out_strm[c].write(in_strm[c].read());
+            }
+            e_out_strm.write(false);
+            e = e_in_strm.read();
+        }
+        e_out_strm.write(true);
+    }
+}
+
+} // namespace gqe
+} // namespace database
+} // namespace xf
+
+#endif
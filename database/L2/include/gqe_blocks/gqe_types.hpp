@@ -39,6 +39,8 @@ typedef int32_t KEY_T;
 #define FILTER_MAX_ROW (1 << 20)
 #define HASHJOIN_MAX_ROW (1 << 20)
 #define AGGREGATE_MAX_ROW (1 << 20)
+// rows kept by ORDER BY ... LIMIT after aggregation
+#define TOPK_MAX_ROW 128
 
 #define BURST_LEN 32
 
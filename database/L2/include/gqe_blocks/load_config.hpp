@@ -217,6 +217,7 @@ void load_config(ap_uint<8 * TPCH_INT_SZ>* ptr,
                  hls::stream<ap_uint<32> >& merge_column_cfg_strm,
                  hls::stream<ap_uint<32> >& group_aggr_cfg_strm,
                  hls::stream<bool>& direct_aggr_cfg_strm,
+                 hls::stream<ap_uint<32> >& top_k_cfg_strm,
                  hls::stream<ap_uint<32> >& write_out_cfg_strm) {
     ap_uint<8 * TPCH_INT_SZ> config[128];
 #pragma HLS resource variable = config core = RAM_1P_BRAM
@@ -233,6 +234,7 @@ void load_config(ap_uint<8 * TPCH_INT_SZ>* ptr,
     ap_uint<32> merge_column_cfg[2];
     ap_uint<32> group_aggr_cfg[4];
     bool direct_aggr_cfg;
+    ap_uint<32> top_k_cfg[2];
     ap_uint<32> write_out_cfg;
 
     // store
@@ -306,6 +308,10 @@ void load_config(ap_uint<8 * TPCH_INT_SZ>* ptr,
     // write out
     write_out_cfg = config[82];
 
+    // top k
+    top_k_cfg[0] = config[83];
+    top_k_cfg[1] = config[84];
+
 #if !defined __SYNTHESIS__ && XDEBUG == 1
     std::cout << std::hex << "write out config" << write_out_cfg << std::endl;
 #endif // !defined __SYNTHESIS__ && XDEBUG == 1
@@ -336,6 +342,8 @@ void load_config(ap_uint<8 * TPCH_INT_SZ>* ptr,
     merge_column_cfg_strm.write(merge_column_cfg[0]);
     merge_column_cfg_strm.write(merge_column_cfg[1]);
     direct_aggr_cfg_strm.write(direct_aggr_cfg);
+    top_k_cfg_strm.write(top_k_cfg[0]);
+    top_k_cfg_strm.write(top_k_cfg[1]);
     write_out_cfg_strm.write(write_out_cfg);
 }
 
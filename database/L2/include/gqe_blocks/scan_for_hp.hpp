@@ -43,12 +43,34 @@ void _read_to_colvec(const int bit_num,
 
     // number of row in each col.
     int nrow = bw.range(31, 0);
-    nrow_strm.write(nrow); // tells splitter
 
     // size of buffer space for 1 col.
     // int col_naxi = (bw.range(63,32) + 63) / 64;
     int col_naxi = bw.range(63, 32).to_int();
 
+    // zone map block skipping, words of one block in each col, 0 for none,
+    // and one bit per block set by host when no row of it can pass the filter.
+    int zone_naxi = bw.range(127, 96).to_int();
+    ap_uint<384> zone_skip = bw.range(511, 128);
+
+    // AXI read for each col
+    int nread = (nrow + vec_len - 1) / vec_len;
+
+    // rows left after skipping, only the last block can be partial.
+    int nkeep = nrow;
+    if (zone_naxi) {
+        int zone_row = zone_naxi * vec_len;
+    ZONE_COUNT_LOOP:
+        for (int b = 0; b < 384; ++b) {
+#pragma HLS pipeline II = 1
+            int start = b * zone_row;
+            if (zone_skip[b] && start < nrow) {
+                nkeep -= (start + zone_row > nrow) ? (nrow - start) : zone_row;
+            }
+        }
+    }
+    nrow_strm.write(nkeep); // tells splitter
+
     bit_num_strm.write(bit_num);
     bit_num_strm_copy.write(bit_num);
 
@@ -67,9 +89,6 @@ void _read_to_colvec(const int bit_num,
         }
     }
 
-    // AXI read for each col
-    int nread = (nrow + vec_len - 1) / vec_len;
-
     ap_uint<512> cnt;
     //#pragma HLS array_partition variable=cnt complete
 
@@ -78,8 +97,24 @@ void _read_to_colvec(const int bit_num,
         cnt.range((i + 1) * 32 - 1, i * 32) = i;
     }
 
-    for (int i = 0; i < nread; i += burst_len) {
-        const int len = ((i + burst_len) > nread) ? (nread - i) : burst_len;
+    int zone_blk = 0;
+    int zone_end = zone_naxi ? zone_naxi : nread;
+    for (int i = 0; i < nread;) {
+        if (i == zone_end) {
+            zone_blk++;
+            zone_end += zone_naxi;
+        }
+        const int blk_end = zone_end > nread ? nread : zone_end;
+        if (zone_naxi && zone_blk < 384 && zone_skip[zone_blk]) {
+            // skipped block is never read, row id goes on after it
+            for (int k = 0; k < vec_len; k++) {
+#pragma HLS UNROLL
+                cnt.range((k + 1) * 32 - 1, k * 32) = cnt.range((k + 1) * 32 - 1, k * 32) + (blk_end - i) * vec_len;
+            }
+            i = blk_end;
+            continue;
+        }
+        const int len = ((i + burst_len) > blk_end) ? (blk_end - i) : burst_len;
         // do a burst read for one col
         for (int c = 0; c < col_num; ++c) {
             int offset = col_offset[c];
@@ -112,6 +147,7 @@ void _read_to_colvec(const int bit_num,
 #pragma HLS UNROLL
             cnt.range((i + 1) * 32 - 1, i * 32) = cnt.range((i + 1) * 32 - 1, i * 32) + len * vec_len;
         }
+        i += len;
     }
 }
 
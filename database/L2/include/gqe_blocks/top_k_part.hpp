@@ -0,0 +1,156 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GQE_TOP_K_PART_HPP
+#define GQE_TOP_K_PART_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+#include "xf_database/top_k.hpp"
+
+#include "gqe_blocks/gqe_types.hpp"
+
+#ifndef __SYNTHESIS__
+#include <iostream>
+#endif
+
+namespace xf {
+namespace database {
+namespace gqe {
+
+// top-k config word 0:
+// bit 0: enable, bit 1: 1 for ascending, bit 2: 64-bit key,
+// bits 15-8: low key column, bits 23-16: high key column.
+// top-k config word 1: limit.
+
+template <int N>
+void top_k_pack(ap_uint<32> cfg,
+                hls::stream<ap_uint<8 * TPCH_INT_SZ> > in_strm[N],
+                hls::stream<bool>& e_in_strm,
+                hls::stream<ap_uint<8 * TPCH_INT_SZ * N> >& row_strm,
+                hls::stream<ap_int<64> >& key_strm,
+                hls::stream<bool>& e_row_strm) {
+    ap_uint<8> lo_col = cfg.range(15, 8);
+    ap_uint<8> hi_col = cfg.range(23, 16);
+    bool wide = cfg[2];
+
+    bool e = e_in_strm.read();
+    while (!e) {
+#pragma HLS pipeline II = 1
+        ap_uint<8 * TPCH_INT_SZ * N> row;
+        for (int i = 0; i < N; i++) {
+#pragma HLS unroll
+            row.range(8 * TPCH_INT_SZ * (i + 1) - 1, 8 * TPCH_INT_SZ * i) = in_strm[i].read();
+        }
+        ap_uint<32> lo = row.range(32 * lo_col + 31, 32 * lo_col);
+        ap_uint<32> hi = row.range(32 * hi_col + 31, 32 * hi_col);
+        // columns hold signed values, a 64-bit key takes its sign from the high column
+        ap_int<64> key = wide ? ap_int<64>((ap_int<64>((int32_t)hi) << 32) | lo) : ap_int<64>((int32_t)lo);
+        row_strm.write(row);
+        key_strm.write(key);
+        e_row_strm.write(false);
+        e = e_in_strm.read();
+    }
+    e_row_strm.write(true);
+}
+
+template <int N>
+void top_k_unpack(hls::stream<ap_uint<8 * TPCH_INT_SZ * N> >& row_strm,
+                  hls::stream<ap_int<64> >& key_strm,
+                  hls::stream<bool>& e_row_strm,
+                  hls::stream<ap_uint<8 * TPCH_INT_SZ> > out_strm[N],
+                  hls::stream<bool>& e_out_strm) {
+    bool e = e_row_strm.read();
+    while (!e) {
+#pragma HLS pipeline II = 1
+        ap_uint<8 * TPCH_INT_SZ * N> row = row_strm.read();
+        key_strm.read();
+        for (int i = 0; i < N; i++) {
+#pragma HLS unroll
+            out_strm[i].write(row.range(8 * TPCH_INT_SZ * (i + 1) - 1, 8 * TPCH_INT_SZ * i));
+        }
+        e_out_strm.write(false);
+        e = e_row_strm.read();
+    }
+    e_out_strm.write(true);
+}
+
+template <int N, int K>
+void top_k_core(ap_uint<32> cfg,
+                ap_uint<32> limit,
+                hls::stream<ap_uint<8 * TPCH_INT_SZ> > in_strm[N],
+                hls::stream<bool>& e_in_strm,
+                hls::stream<ap_uint<8 * TPCH_INT_SZ> > out_strm[N],
+                hls::stream<bool>& e_out_strm) {
+#pragma HLS dataflow
+
+    hls::stream<ap_uint<8 * TPCH_INT_SZ * N> > row_strm;
+#pragma HLS stream variable = row_strm depth = 8
+    hls::stream<ap_int<64> > key_strm;
+#pragma HLS stream variable = key_strm depth = 8
+    hls::stream<bool> e_row_strm;
+#pragma HLS stream variable = e_row_strm depth = 8
+
+    hls::stream<ap_uint<8 * TPCH_INT_SZ * N> > top_strm;
+#pragma HLS stream variable = top_strm depth = 8
+    hls::stream<ap_int<64> > top_key_strm;
+#pragma HLS stream variable = top_key_strm depth = 8
+    hls::stream<bool> e_top_strm;
+#pragma HLS stream variable = e_top_strm depth = 8
+
+    top_k_pack<N>(cfg, in_strm, e_in_strm, row_strm, key_strm, e_row_strm);
+    xf::database::topK<ap_int<64>, ap_uint<8 * TPCH_INT_SZ * N>, K>(row_strm, key_strm, e_row_strm, top_strm,
+                                                                     top_key_strm, e_top_strm, limit, cfg[1]);
+    top_k_unpack<N>(top_strm, top_key_strm, e_top_strm, out_strm, e_out_strm);
+}
+
+/// @brief ORDER BY ... LIMIT on the aggregated rows, so that only limit rows are written back.
+template <int N, int K>
+void top_k_wrapper(hls::stream<ap_uint<32> >& top_k_cfg_strm,
+                   hls::stream<ap_uint<8 * TPCH_INT_SZ> > in_strm[N],
+                   hls::stream<bool>& e_in_strm,
+                   hls::stream<ap_uint<8 * TPCH_INT_SZ> > out_strm[N],
+                   hls::stream<bool>& e_out_strm) {
+    ap_uint<32> cfg = top_k_cfg_strm.read();
+    ap_uint<32> limit = top_k_cfg_strm.read();
+    if (limit > K) limit = K;
+
+    if (cfg[0]) {
+#if !defined __SYNTHESIS__ && XDEBUG == 1
+        std::cout << "Top-K on column " << cfg.range(15, 8) << ", limit " << limit << std::endl;
+#endif
+        top_k_core<N, K>(cfg, limit, in_strm, e_in_strm, out_strm, e_out_strm);
+    } else {
+        // bypass
+        bool e = e_in_strm.read();
+        while (!e) {
+#pragma HLS pipeline II = 1
+            for (int i = 0; i < N; i++) {
+#pragma HLS unroll
+                out_strm[i].write(in_strm[i].read());
+            }
+            e = e_in_strm.read();
+            e_out_strm.write(false);
+        }
+        e_out_strm.write(true);
+    }
+}
+
+} // namespace gqe
+} // namespace database
+} // namespace xf
+
+#endif
@@ -194,6 +194,8 @@ void burstWrite(hls::stream<ap_uint<elem_size * vec_len> > i_strm[col_num],
         nm = nm_strm.read();
     }
 
+    // partitions have no zone map, scan them all
+    first_r(elem_size * 4 - 1, elem_size * 3) = 0;
 FINAL_WRITE_HEAD_LOOP:
     for (int i = 0; i < BK; i++) {
         const int base_addr = PARTITION_SIZE * i;
@@ -168,6 +168,8 @@ void burstWrite(hls::stream<ap_uint<elem_size * vec_len> > i_strm[col_num],
     std::cout << std::dec << "write out row=" << rnm.to_int() << " col_nm=" << wcol << std::endl;
 #endif
     first_r(elem_size - 1, 0) = rnm;
+    // result table has no zone map, scan it all
+    first_r(elem_size * 4 - 1, elem_size * 3) = 0;
     ptr[0] = first_r;
 }
 
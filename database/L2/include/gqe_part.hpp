@@ -34,6 +34,8 @@
 const int HASHWH = 0;
 const int HASHWL = 8;
 const int PU = (1 << HASHWH);
+// width of bloom filter hash, each of the two bit vectors has 2^BF_HASHW bits
+const int BF_HASHW = 21;
 // const int BK = (1 << HASHWL);
 
 #ifndef __SYNTHESIS__
@@ -52,6 +54,8 @@ const int PU = (1 << HASHWH);
  * @param buf_A input table buffer
  * @param buf_B output table buffer
  * @param buf_D configuration buffer
+ * @param buf_bf bloom filter buffer, written when partitioning the build table and read when partitioning the
+ * probe table, at least 2^(BF_HASHW - 2) bytes
  *
  */
 extern "C" void gqePart(const int k_depth,
@@ -59,6 +63,7 @@ extern "C" void gqePart(const int k_depth,
                         const int bit_num,
                         ap_uint<8 * TPCH_INT_SZ * VEC_LEN> buf_A[],
                         ap_uint<8 * TPCH_INT_SZ * VEC_LEN> buf_B[],
-                        ap_uint<8 * TPCH_INT_SZ * VEC_LEN> buf_D[]);
+                        ap_uint<8 * TPCH_INT_SZ * VEC_LEN> buf_D[],
+                        ap_uint<8 * TPCH_INT_SZ * VEC_LEN> buf_bf[]);
 
 #endif // _XF_DB_GQE_PART_H_
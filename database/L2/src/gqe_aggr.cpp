@@ -26,6 +26,7 @@
 #include "gqe_blocks/filter_part.hpp"
 #include "gqe_blocks/group_aggregate_part.hpp"
 #include "gqe_blocks/aggr_part.hpp"
+#include "gqe_blocks/top_k_part.hpp"
 #include "gqe_blocks/write_info.hpp"
 #include "gqe_blocks/write_out.hpp"
 
@@ -161,6 +162,10 @@ extern "C" void gqeAggr(                                        //
 #pragma HLS stream variable = direct_aggr_cfg_strm depth = 4
 #pragma HLS resource variable = direct_aggr_cfg_strm core = FIFO_SRL
 
+    hls::stream<ap_uint<32> > top_k_cfg_strm;
+#pragma HLS stream variable = top_k_cfg_strm depth = 4
+#pragma HLS resource variable = top_k_cfg_strm core = FIFO_SRL
+
     hls::stream<ap_uint<32> > write_cfg_strm;
 #pragma HLS stream variable = write_cfg_strm depth = 4
 #pragma HLS resource variable = write_cfg_strm core = FIFO_SRL
@@ -183,7 +188,8 @@ extern "C" void gqeAggr(                                        //
 
     load_config<n_channel, n_column>(buf_cfg, cid_strm, alu0_cfg_strm, alu1_cfg_strm, filter_cfg_strm,
                                      shuffle1_cfg_strm, shuffle2_cfg_strm, shuffle3_cfg_strm, shuffle4_cfg_strm,
-                                     merge_column_cfg_strm, group_aggr_cfg_strm, direct_aggr_cfg_strm, write_cfg_strm);
+                                     merge_column_cfg_strm, group_aggr_cfg_strm, direct_aggr_cfg_strm, top_k_cfg_strm,
+                                     write_cfg_strm);
 
 #ifndef __SYNTHESIS__
     printf("******************************\n");
@@ -394,6 +400,23 @@ extern "C" void gqeAggr(                                        //
     }
 #endif
 
+    //------------------------top k--------------------------
+
+    hls::stream<ap_uint<32> > top_k_strm[2 * n_column];
+#pragma HLS stream variable = top_k_strm depth = 8
+#pragma HLS resource variable = top_k_strm core = FIFO_SRL
+    hls::stream<bool> e_top_k_strm;
+#pragma HLS stream variable = e_top_k_strm depth = 8
+
+#ifndef __SYNTHESIS__
+    printf("******************************\n");
+    printf("            Top K\n");
+    printf("******************************\n");
+#endif
+
+    top_k_wrapper<2 * n_column, TOPK_MAX_ROW>(top_k_cfg_strm, direct_aggr_strm, e_direct_aggr_strm, top_k_strm,
+                                              e_top_k_strm);
+
 //------------------------write out--------------------------
 
 #ifndef __SYNTHESIS__
@@ -402,8 +425,7 @@ extern "C" void gqeAggr(                                        //
     printf("******************************\n");
 #endif
 
-    writeTable<BURST_LEN, 8 * TPCH_INT_SZ, VEC_LEN, 2 * n_column>(direct_aggr_strm, e_direct_aggr_strm, buf_out,
-                                                                  write_cfg_strm);
+    writeTable<BURST_LEN, 8 * TPCH_INT_SZ, VEC_LEN, 2 * n_column>(top_k_strm, e_top_k_strm, buf_out, write_cfg_strm);
 
 #ifndef __SYNTHESIS__
 
@@ -21,6 +21,7 @@
 #include "gqe_part.hpp"
 #include "gqe_blocks/scan_for_hp.hpp"
 #include "gqe_blocks/filter_part.hpp"
+#include "gqe_blocks/bloom_filter_part.hpp"
 #include "gqe_blocks/write_for_hp.hpp"
 #include "xf_database/hash_partition.hpp"
 
@@ -31,6 +32,7 @@ namespace gqe {
 void load_config(ap_uint<8 * TPCH_INT_SZ * VEC_LEN> ptr[9],
                  const int col_index,
                  bool& mk_on,
+                 ap_uint<2>& bf_mode,
                  hls::stream<int8_t>& col_id_strm,
                  hls::stream<ap_uint<32> >& wr_cfg_strm,
                  hls::stream<ap_uint<32> >& filter_cfg_strm) {
@@ -57,6 +59,11 @@ void load_config(ap_uint<8 * TPCH_INT_SZ * VEC_LEN> ptr[9],
         std::cout << "\nDual key is off\n";
 #endif
 
+    // bloom filter pushdown, the build table (index 0) fills the filter and the probe table (index 1) is
+    // checked against it. Anti join needs the probe rows without match, so the filter is not used.
+    bool bf_on = config[0][7] && config[0].range(5, 3) < 2;
+    bf_mode = bf_on ? (col_index == 0 ? 1 : 2) : 0;
+
     for (int i = 0; i < COL_NUM; i++) {
 #pragma HLS PIPELINE II = 1
         int8_t t = config[0].range(64 * col_index + 56 + 8 * i + 7, 64 * col_index + 56 + 8 * i);
@@ -169,6 +176,7 @@ void hash_partition_wrapper(bool mk_on,
  * @param buf_A input table buffer
  * @param buf_B output table buffer
  * @param buf_D configuration buffer
+ * @param buf_bf bloom filter buffer
  *
  */
 extern "C" void gqePart(const int k_depth,
@@ -176,7 +184,8 @@ extern "C" void gqePart(const int k_depth,
                         const int bit_num,
                         ap_uint<512> buf_A[TEST_BUF_DEPTH],
                         ap_uint<512> buf_B[TEST_BUF_DEPTH],
-                        ap_uint<512> buf_D[TEST_BUF_DEPTH]) {
+                        ap_uint<512> buf_D[TEST_BUF_DEPTH],
+                        ap_uint<512> buf_bf[TEST_BUF_DEPTH]) {
 // clang-format off
 #pragma HLS INTERFACE m_axi offset = slave latency = 64 \
 	num_write_outstanding = 16 num_read_outstanding = 16 \
@@ -193,12 +202,18 @@ extern "C" void gqePart(const int k_depth,
 	max_write_burst_length = 64 max_read_burst_length = 64 \
 	bundle = gmem0_2 port = buf_D
 
+#pragma HLS INTERFACE m_axi offset = slave latency = 64 \
+	num_write_outstanding = 16 num_read_outstanding = 16 \
+	max_write_burst_length = 64 max_read_burst_length = 64 \
+	bundle = gmem0_3 port = buf_bf
+
 #pragma HLS INTERFACE s_axilite port = k_depth bundle = control
 #pragma HLS INTERFACE s_axilite port = col_index bundle = control
 #pragma HLS INTERFACE s_axilite port = bit_num bundle = control
 #pragma HLS INTERFACE s_axilite port = buf_A bundle = control
 #pragma HLS INTERFACE s_axilite port = buf_B bundle = control
 #pragma HLS INTERFACE s_axilite port = buf_D bundle = control
+#pragma HLS INTERFACE s_axilite port = buf_bf bundle = control
 #pragma HLS INTERFACE s_axilite port = return bundle = control
 
     // clang-format on
@@ -207,6 +222,7 @@ extern "C" void gqePart(const int k_depth,
 #pragma HLS DATAFLOW
 
     bool mk_on;
+    ap_uint<2> bf_mode;
     hls::stream<int8_t> cid_strm;
 #pragma HLS stream variable = cid_strm depth = 16
     hls::stream<ap_uint<32> > wr_cfg_strm;
@@ -234,6 +250,14 @@ extern "C" void gqePart(const int k_depth,
     hls::stream<bool> e_flt_strms[CH_NUM];
 #pragma HLS stream variable = e_flt_strms depth = 32
 
+    // bloom filter part
+    hls::stream<ap_uint<8 * TPCH_INT_SZ> > bf_strms[CH_NUM][COL_NUM];
+#pragma HLS stream variable = bf_strms depth = 32
+#pragma HLS array_partition variable = bf_strms dim = 1
+#pragma HLS resource variable = bf_strms core = FIFO_LUTRAM
+    hls::stream<bool> e_bf_strms[CH_NUM];
+#pragma HLS stream variable = e_bf_strms depth = 32
+
     // partition part
     hls::stream<ap_uint<16> > hp_bkpu_strm;
 #pragma HLS stream variable = hp_bkpu_strm depth = 32
@@ -242,7 +266,7 @@ extern "C" void gqePart(const int k_depth,
     hls::stream<ap_uint<8 * TPCH_INT_SZ> > hp_out_strms[COL_NUM];
 #pragma HLS stream variable = hp_out_strms depth = 32
 
-    load_config(buf_D, col_index, mk_on, cid_strm, wr_cfg_strm, fcfg);
+    load_config(buf_D, col_index, mk_on, bf_mode, cid_strm, wr_cfg_strm, fcfg);
 
     scan_to_channel<COL_NUM, CH_NUM>(bit_num, buf_A, cid_strm, ch_strms, e_ch_strms, bit_num_strm, bit_num_strm_copy);
 #ifndef __SYNTHESIS__
@@ -267,7 +291,11 @@ extern "C" void gqePart(const int k_depth,
     }
 #endif
 
-    hash_partition_wrapper<COL_NUM, CH_NUM, COL_NUM>(mk_on, k_depth, bit_num_strm, flt_strms, e_flt_strms, hp_bkpu_strm,
+    // scan uses a single channel, so one filter sees all keys
+    bloom_filter_part<COL_NUM, BF_HASHW>(bf_mode, mk_on, buf_bf, flt_strms[0], e_flt_strms[0], bf_strms[0],
+                                         e_bf_strms[0]);
+
+    hash_partition_wrapper<COL_NUM, CH_NUM, COL_NUM>(mk_on, k_depth, bit_num_strm, bf_strms, e_bf_strms, hp_bkpu_strm,
                                                      hp_nm_strm, hp_out_strms);
 
     writeTable<32, VEC_LEN, COL_NUM>(hp_out_strms, wr_cfg_strm, bit_num_strm_copy, hp_nm_strm, hp_bkpu_strm, buf_B);
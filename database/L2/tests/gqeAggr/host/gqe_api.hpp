@@ -528,10 +528,15 @@ void gatherTable_row(Table& tin1, Table& tin2, Table& tout) {
     tout.setNumRow(nrow1 + nrow2);
 }
 
+// bloom filter of gqePart, two vectors of 2^21 bits
+#define BF_BUFF_SZ (1 << 19)
+
 class cfgCmd {
    public:
     ap_uint<512>* cmd;
     cl::Buffer buffer;
+    // written by gqePart on the build table, read by gqePart on the probe table
+    cl::Buffer bf_buffer;
 
     cfgCmd(){};
 
@@ -544,8 +549,14 @@ class cfgCmd {
         cl_mem_ext_ptr_t mext = {XCL_MEM_TOPOLOGY | (unsigned int)(32), cmd, 0};
         buffer = cl::Buffer(context, CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, (size_t)(64 * 9),
                             &mext);
+        cl_mem_ext_ptr_t mext_bf = {XCL_MEM_TOPOLOGY | (unsigned int)(32), nullptr, 0};
+        bf_buffer = cl::Buffer(context, CL_MEM_EXT_PTR_XILINX | CL_MEM_HOST_NO_ACCESS | CL_MEM_READ_WRITE,
+                               (size_t)BF_BUFF_SZ, &mext_bf);
     };
 
+    /// @brief gqePart on the build table makes a bloom filter of join keys, probe rows failing it are dropped
+    void setBloomFilter(bool on) { cmd[0].set_bit(7, on); };
+
     void setup(){}; // TODO
 };
 
@@ -761,6 +772,7 @@ class krnlEngine {
         krnl.setArg(j++, (in1->buffer));
         krnl.setArg(j++, (out->buffer));
         krnl.setArg(j++, (cfgcmd->buffer));
+        krnl.setArg(j++, (cfgcmd->bf_buffer));
     };
 
     void run(int rc, std::vector<cl::Event>* waitevt, cl::Event* outevt) { clq.enqueueTask(krnl, waitevt, outevt); };
@@ -814,6 +826,7 @@ class AggrKrnlEngine {
         krnl.setArg(j++, (in->buffer));
         krnl.setArg(j++, (out->buffer));
         krnl.setArg(j++, (hpcmd->buffer));
+        krnl.setArg(j++, (hpcmd->bf_buffer));
     };
 
     void run(int rc, std::vector<cl::Event>* waitevt, cl::Event* outevt) { clq.enqueueTask(krnl, waitevt, outevt); };
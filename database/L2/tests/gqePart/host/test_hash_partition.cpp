@@ -41,7 +41,8 @@ extern "C" void gqePart(const int k_depth,
                         const int bit_num,
                         ap_uint<512> buf_A[],
                         ap_uint<512> buf_B[],
-                        ap_uint<512> buf_D[]);
+                        ap_uint<512> buf_D[],
+                        ap_uint<512> buf_bf[]);
 #else
 #include <CL/cl_ext_xilinx.h>
 #include <xcl2.hpp>
@@ -195,6 +196,9 @@ int main(int argc, const char* argv[]) {
 
     ap_uint<512>* table_cfg = aligned_alloc<ap_uint<512> >(9);
     get_q5simple_cfg(table_cfg);
+    // bloom filter of join keys, not used as pushdown is off in this config
+    const int table_bf_depth = 1 << 13;
+    ap_uint<512>* table_bf = aligned_alloc<ap_uint<512> >(table_bf_depth);
 
     const int bit_num = 3;
     const int BK = 1 << bit_num;
@@ -218,7 +222,7 @@ int main(int argc, const char* argv[]) {
 #ifdef HLS_TEST
     hls::stream<ap_uint<64> > key_in;
     hls::stream<ap_uint<64> > key_out;
-    gqePart(k_depth, 0, bit_num, (ap_uint<512>*)table_l, (ap_uint<512>*)table_out, (ap_uint<512>*)table_cfg);
+    gqePart(k_depth, 0, bit_num, (ap_uint<512>*)table_l, (ap_uint<512>*)table_out, (ap_uint<512>*)table_cfg, table_bf);
     {
         std::cout << "------------------------HLS Csim Result "
                      "Checking-------------------------\n";
@@ -285,10 +289,11 @@ int main(int argc, const char* argv[]) {
 
     std::cout << "Kernel has been created\n";
 
-    cl_mem_ext_ptr_t mext_table_l, mext_table_out, mext_cfg;
+    cl_mem_ext_ptr_t mext_table_l, mext_table_out, mext_cfg, mext_bf;
     mext_table_l = {XCL_BANK(33), table_l, 0};
     mext_table_out = {XCL_BANK(32), table_out, 0};
     mext_cfg = {XCL_BANK(32), table_cfg, 0};
+    mext_bf = {XCL_BANK(32), table_bf, 0};
 
     // Map buffers
     cl::Buffer buf_table_l(context, CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY,
@@ -297,6 +302,8 @@ int main(int argc, const char* argv[]) {
                              (size_t)(sizeof(ap_uint<512>) * table_result_size), &mext_table_out);
     cl::Buffer buf_cfg(context, CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE,
                        (size_t)(sizeof(ap_uint<512>) * 9), &mext_cfg);
+    cl::Buffer buf_bf(context, CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE,
+                      (size_t)(sizeof(ap_uint<512>) * table_bf_depth), &mext_bf);
 
     std::cout << "DDR buffers have been mapped/copy-and-mapped\n";
 
@@ -325,6 +332,7 @@ int main(int argc, const char* argv[]) {
     kernel0table.setArg(j++, buf_table_l);
     kernel0table.setArg(j++, buf_table_out);
     kernel0table.setArg(j++, buf_cfg);
+    kernel0table.setArg(j++, buf_bf);
 
     struct timeval tv0;
     int exec_us;
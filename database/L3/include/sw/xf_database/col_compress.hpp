@@ -0,0 +1,176 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef XF_DATABASE_COL_COMPRESS_H
+#define XF_DATABASE_COL_COMPRESS_H
+
+#include <ap_int.h>
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+#include "xf_database/enums.hpp"
+
+namespace xf {
+namespace database {
+namespace details {
+namespace col_compress {
+
+// bits of an unsigned offset up to r, at least 1
+inline int offset_bits(uint64_t r) {
+    int b = 1;
+    while (b < 32 && (r >> b) != 0) ++b;
+    return b;
+}
+
+inline size_t packed_words(size_t n, int b) {
+    size_t per_word = 512 / b;
+    return (n + per_word - 1) / per_word;
+}
+
+inline void pack(const std::vector<uint32_t>& off, int step, std::vector<ap_uint<512> >& page) {
+    int per_word = 512 / step;
+    for (size_t i = 0; i < off.size(); i += per_word) {
+        ap_uint<512> w = 0;
+        for (int j = 0; j < per_word && i + j < off.size(); ++j) {
+            w.range(step * j + step - 1, step * j) = off[i + j];
+        }
+        page.push_back(w);
+    }
+}
+
+} // namespace col_compress
+} // namespace details
+
+/**
+ * @brief Picks the encoding of a column with the fewest payload words.
+ *
+ * Bit-packing stores each value as an offset from the column minimum, delta encoding stores the difference to the
+ * previous value as an offset from the smallest difference, so sorted keys and dates pack into few bits. Run-length
+ * encoding wins for columns with long runs of one value. On a tie the simpler encoding is kept.
+ *
+ * @param v the column.
+ * @param n number of rows.
+ * @param bw bit width of the packed offsets of the picked encoding.
+ * @return the encoding.
+ */
+inline ColEncoding pickColEncoding(const int32_t* v, size_t n, int& bw) {
+    using namespace details::col_compress;
+    if (n == 0) {
+        bw = 32;
+        return CENC_RAW;
+    }
+    int64_t mn = v[0], mx = v[0], dmn = 0, dmx = 0;
+    size_t runs = 1;
+    for (size_t i = 1; i < n; ++i) {
+        int64_t d = (int64_t)v[i] - v[i - 1];
+        mn = v[i] < mn ? v[i] : mn;
+        mx = v[i] > mx ? v[i] : mx;
+        dmn = (i == 1 || d < dmn) ? d : dmn;
+        dmx = (i == 1 || d > dmx) ? d : dmx;
+        runs += v[i] != v[i - 1];
+    }
+
+    ColEncoding enc = CENC_RAW;
+    bw = 32;
+    size_t best = packed_words(n, 32);
+    int b = offset_bits(mx - mn);
+    if (packed_words(n, b) < best) {
+        enc = CENC_BITPACK;
+        bw = b;
+        best = packed_words(n, b);
+    }
+    if ((runs + 7) / 8 < best) {
+        enc = CENC_RLE;
+        bw = 32;
+        best = (runs + 7) / 8;
+    }
+    // a difference range wider than 32 bits cannot be packed
+    b = offset_bits(dmx - dmn);
+    if (dmx - dmn < (int64_t(1) << 32) && packed_words(n, b) < best) {
+        enc = CENC_DELTA;
+        bw = b;
+    }
+    return enc;
+}
+
+/**
+ * @brief Encodes a column into a page for scanCompressedCol.
+ *
+ * @param v the column.
+ * @param n number of rows.
+ * @param page output, header word followed by the payload words.
+ * @param enc encoding, -1 to pick the one with the fewest words.
+ * @return the encoding used.
+ */
+inline ColEncoding compressColumn(const int32_t* v, size_t n, std::vector<ap_uint<512> >& page, int enc = -1) {
+    using namespace details::col_compress;
+    int bw = 32;
+    ColEncoding e = pickColEncoding(v, n, bw);
+    if (enc >= 0 && enc != e) {
+        e = (ColEncoding)enc;
+        bw = 32;
+    }
+
+    uint32_t base = 0;
+    uint32_t start = 0;
+    std::vector<uint32_t> off;
+    if (e == CENC_BITPACK || e == CENC_DELTA) {
+        int64_t mn = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int64_t d = e == CENC_DELTA ? (i ? (int64_t)v[i] - v[i - 1] : 0) : v[i];
+            if (i == (e == CENC_DELTA) || d < mn) mn = d;
+        }
+        uint64_t mx = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int64_t d = e == CENC_DELTA ? (i ? (int64_t)v[i] - v[i - 1] : mn) : v[i];
+            off.push_back((uint32_t)(d - mn));
+            mx = (uint64_t)(d - mn) > mx ? (uint64_t)(d - mn) : mx;
+        }
+        base = (uint32_t)mn;
+        // the first row is start + base + 0
+        if (e == CENC_DELTA && n) start = (uint32_t)v[0] - base;
+        if (bw == 32) bw = offset_bits(mx);
+    } else if (e == CENC_RLE) {
+        for (size_t i = 0; i < n;) {
+            size_t j = i;
+            while (j < n && v[j] == v[i] && j - i < 0xffffffffu) ++j;
+            off.push_back((uint32_t)v[i]);
+            off.push_back((uint32_t)(j - i));
+            i = j;
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) off.push_back((uint32_t)v[i]);
+    }
+
+    page.clear();
+    page.push_back(0);
+    pack(off, e == CENC_RLE ? 32 : bw, page);
+    ap_uint<512> hdr = 0;
+    hdr.range(7, 0) = e;
+    hdr.range(15, 8) = bw;
+    hdr.range(63, 32) = n;
+    hdr.range(95, 64) = base;
+    hdr.range(127, 96) = start;
+    hdr.range(159, 128) = page.size() - 1;
+    page[0] = hdr;
+    return e;
+}
+
+} // namespace database
+} // namespace xf
+
+#endif // XF_DATABASE_COL_COMPRESS_H
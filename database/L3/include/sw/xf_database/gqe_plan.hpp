@@ -0,0 +1,1033 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef XF_DATABASE_GQE_PLAN_H
+#define XF_DATABASE_GQE_PLAN_H
+
+#include "xf_database/dynamic_alu_host.hpp"
+#include "xf_database/enums.hpp"
+#include "xf_database/string_dict.hpp"
+
+#include <ap_int.h>
+#include <stdint.h>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace xf {
+namespace database {
+namespace details {
+namespace gqe_plan {
+
+//------------- filter expression -----------------------------------//
+
+// one comparison, columns always on the left hand side
+struct FilterAtom {
+    int col0;
+    int col1; // -1 for compare with constant
+    int op;
+    uint32_t val;
+    int bit; // bit of the truth table address
+};
+
+enum { NODE_ATOM = 0, NODE_AND, NODE_OR, NODE_NOT };
+
+// rows kept by the top-k stage of gqeAggr, TOPK_MAX_ROW of the kernel
+enum { AGGR_TOPK_MAX = 128 };
+
+struct FilterNode {
+    int type;
+    int a; // atom index for NODE_ATOM
+    int b;
+};
+
+// swap the sides of a comparison
+inline int flip_op(int op) {
+    using namespace xf::database::enums;
+    switch (op) {
+        case FOP_GT:
+            return FOP_LT;
+        case FOP_LT:
+            return FOP_GT;
+        case FOP_GE:
+            return FOP_LE;
+        case FOP_LE:
+            return FOP_GE;
+        case FOP_GTU:
+            return FOP_LTU;
+        case FOP_LTU:
+            return FOP_GTU;
+        case FOP_GEU:
+            return FOP_LEU;
+        case FOP_LEU:
+            return FOP_GEU;
+        default:
+            return op;
+    }
+}
+
+inline int unsigned_op(int op) {
+    using namespace xf::database::enums;
+    switch (op) {
+        case FOP_GT:
+            return FOP_GTU;
+        case FOP_LT:
+            return FOP_LTU;
+        case FOP_GE:
+            return FOP_GEU;
+        case FOP_LE:
+            return FOP_LEU;
+        default:
+            return op;
+    }
+}
+
+// recursive descent parser for "a >= 19940101u && (b < 3 || a != c)"
+class FilterParser {
+   public:
+    FilterParser(const std::vector<std::string>& cols, const std::string& expr) : cols_(cols), s_(expr), p_(0) {}
+
+    bool parse(std::vector<FilterNode>& nodes, std::vector<FilterAtom>& atoms, int& root) {
+        nodes_ = &nodes;
+        atoms_ = &atoms;
+        root = parse_or();
+        skip();
+        if (root >= 0 && p_ != s_.size()) {
+            error("unexpected character");
+            root = -1;
+        }
+        return root >= 0;
+    }
+
+   private:
+    const std::vector<std::string>& cols_;
+    std::string s_;
+    size_t p_;
+    std::vector<FilterNode>* nodes_;
+    std::vector<FilterAtom>* atoms_;
+
+    void error(const char* msg) {
+        std::cout << "ERROR: filter \"" << s_ << "\" at " << p_ << ": " << msg << std::endl;
+    }
+
+    void skip() {
+        while (p_ < s_.size() && isspace(s_[p_])) ++p_;
+    }
+
+    bool match(const char* t) {
+        skip();
+        size_t n = std::string(t).size();
+        if (s_.compare(p_, n, t) != 0) return false;
+        // do not take "!" out of "!="
+        if (n == 1 && t[0] == '!' && p_ + 1 < s_.size() && s_[p_ + 1] == '=') return false;
+        p_ += n;
+        return true;
+    }
+
+    int push(int type, int a, int b) {
+        FilterNode n = {type, a, b};
+        nodes_->push_back(n);
+        return nodes_->size() - 1;
+    }
+
+    int parse_or() {
+        int n = parse_and();
+        while (n >= 0 && match("||")) {
+            int m = parse_and();
+            if (m < 0) return -1;
+            n = push(NODE_OR, n, m);
+        }
+        return n;
+    }
+
+    int parse_and() {
+        int n = parse_unary();
+        while (n >= 0 && match("&&")) {
+            int m = parse_unary();
+            if (m < 0) return -1;
+            n = push(NODE_AND, n, m);
+        }
+        return n;
+    }
+
+    int parse_unary() {
+        if (match("!")) {
+            int n = parse_unary();
+            return n < 0 ? -1 : push(NODE_NOT, n, -1);
+        }
+        if (match("(")) {
+            int n = parse_or();
+            if (n >= 0 && !match(")")) {
+                error("expecting ')'");
+                return -1;
+            }
+            return n;
+        }
+        return parse_atom();
+    }
+
+    // column index into cols_, or -1 with v and u set for a constant
+    bool parse_operand(int& col, int64_t& v, bool& u) {
+        skip();
+        col = -1;
+        u = false;
+        size_t b = p_;
+        if (p_ < s_.size() && (isalpha(s_[p_]) || s_[p_] == '_')) {
+            while (p_ < s_.size() && (isalnum(s_[p_]) || s_[p_] == '_')) ++p_;
+            std::string name = s_.substr(b, p_ - b);
+            for (size_t i = 0; i < cols_.size(); ++i) {
+                if (cols_[i] == name) col = i;
+            }
+            if (col < 0) {
+                p_ = b;
+                error(("column " + name + " is not one of the first 4 scanned columns").c_str());
+                return false;
+            }
+            return true;
+        }
+        if (p_ < s_.size() && s_[p_] == '-') ++p_;
+        while (p_ < s_.size() && isdigit(s_[p_])) ++p_;
+        if (p_ == b || (p_ == b + 1 && s_[b] == '-')) {
+            p_ = b;
+            error("expecting column or integer");
+            return false;
+        }
+        v = strtoll(s_.substr(b, p_ - b).c_str(), NULL, 10);
+        if (p_ < s_.size() && s_[p_] == 'u') {
+            u = true;
+            ++p_;
+        }
+        return true;
+    }
+
+    int parse_atom() {
+        using namespace xf::database::enums;
+        int c0, c1;
+        int64_t v0 = 0, v1 = 0;
+        bool u0, u1;
+        if (!parse_operand(c0, v0, u0)) return -1;
+        int op;
+        if (match("==")) {
+            op = FOP_EQ;
+        } else if (match("!=")) {
+            op = FOP_NE;
+        } else if (match(">=")) {
+            op = FOP_GE;
+        } else if (match("<=")) {
+            op = FOP_LE;
+        } else if (match(">")) {
+            op = FOP_GT;
+        } else if (match("<")) {
+            op = FOP_LT;
+        } else {
+            error("expecting comparison operator");
+            return -1;
+        }
+        if (!parse_operand(c1, v1, u1)) return -1;
+
+        FilterAtom a = {c0, c1, op, (uint32_t)v1, -1};
+        if (c0 < 0 && c1 < 0) {
+            error("comparison between two constants");
+            return -1;
+        } else if (c0 < 0) {
+            a.col0 = c1;
+            a.col1 = -1;
+            a.op = flip_op(op);
+            a.val = (uint32_t)v0;
+            u1 = u0;
+        } else if (c1 >= 0) {
+            if (c0 == c1) {
+                error("comparison of a column with itself");
+                return -1;
+            }
+            if (c0 > c1) {
+                a.col0 = c1;
+                a.col1 = c0;
+                a.op = flip_op(op);
+            }
+        }
+        if (u1) a.op = unsigned_op(a.op);
+        atoms_->push_back(a);
+        return push(NODE_ATOM, atoms_->size() - 1, -1);
+    }
+};
+
+// atoms reachable from root through AND only can share a var-const slot
+inline void mark_top(const std::vector<FilterNode>& nodes, int n, std::vector<bool>& top) {
+    if (nodes[n].type == NODE_AND) {
+        mark_top(nodes, nodes[n].a, top);
+        mark_top(nodes, nodes[n].b, top);
+    } else if (nodes[n].type == NODE_ATOM) {
+        top[nodes[n].a] = true;
+    }
+}
+
+inline bool eval_node(const std::vector<FilterNode>& nodes,
+                      const std::vector<FilterAtom>& atoms,
+                      int n,
+                      unsigned addr) {
+    const FilterNode& d = nodes[n];
+    switch (d.type) {
+        case NODE_ATOM:
+            return (addr >> atoms[d.a].bit) & 1;
+        case NODE_AND:
+            return eval_node(nodes, atoms, d.a, addr) && eval_node(nodes, atoms, d.b, addr);
+        case NODE_OR:
+            return eval_node(nodes, atoms, d.a, addr) || eval_node(nodes, atoms, d.b, addr);
+        default:
+            return !eval_node(nodes, atoms, d.a, addr);
+    }
+}
+
+//------------- column shuffles -------------------------------------//
+
+inline int find_col(const std::vector<std::string>& v, const std::string& n) {
+    for (size_t i = 0; i < v.size(); ++i) {
+        if (!n.empty() && v[i] == n) return i;
+    }
+    return -1;
+}
+
+inline void add_col(std::vector<std::string>& v, const std::string& n) {
+    if (!n.empty() && find_col(v, n) < 0) v.push_back(n);
+}
+
+// 8 int8 entries picking want out of cur, -1 for unused outputs
+inline bool shuffle_cfg(const std::vector<std::string>& cur,
+                        const std::vector<std::string>& want,
+                        ap_uint<64>& cfg,
+                        const char* stage) {
+    if (want.size() > 8) {
+        std::cout << "ERROR: " << stage << " needs " << want.size() << " columns, at most 8 supported." << std::endl;
+        return false;
+    }
+    for (int i = 0; i < 8; ++i) {
+        int idx = -1;
+        if (i < (int)want.size() && !want[i].empty()) {
+            idx = find_col(cur, want[i]);
+            if (idx < 0) {
+                std::cout << "ERROR: " << stage << " cannot find column " << want[i] << "." << std::endl;
+                return false;
+            }
+        }
+        cfg.range(8 * i + 7, 8 * i) = (uint8_t)(int8_t)idx;
+    }
+    return true;
+}
+
+// column names referenced by an evaluation expression, c1 to c4 are constants
+inline void eval_inputs(const std::string& expr, std::vector<std::string>& cols) {
+    size_t p = 0;
+    while (p < expr.size()) {
+        if (isalpha(expr[p]) || expr[p] == '_') {
+            size_t b = p;
+            while (p < expr.size() && (isalnum(expr[p]) || expr[p] == '_')) ++p;
+            std::string id = expr.substr(b, p - b);
+            if (id != "c1" && id != "c2" && id != "c3" && id != "c4") add_col(cols, id);
+        } else {
+            ++p;
+        }
+    }
+}
+
+// columns going into an evaluation stage: its inputs first, then the live ones
+inline std::vector<std::string> eval_want(const std::string& expr,
+                                          const std::string& name,
+                                          const std::vector<std::string>& live) {
+    std::vector<std::string> want;
+    eval_inputs(expr, want);
+    for (size_t i = 0; i < live.size(); ++i) {
+        if (live[i] != name) add_col(want, live[i]);
+    }
+    return want;
+}
+
+// rename input columns to strm1 to strm4 after the preceding shuffle
+inline std::string eval_rename(const std::string& expr, const std::vector<std::string>& want) {
+    std::string r;
+    size_t p = 0;
+    while (p < expr.size()) {
+        if (isalpha(expr[p]) || expr[p] == '_') {
+            size_t b = p;
+            while (p < expr.size() && (isalnum(expr[p]) || expr[p] == '_')) ++p;
+            std::string id = expr.substr(b, p - b);
+            int i = find_col(want, id);
+            r += (i >= 0 && i < 4) ? "strm" + std::to_string(i + 1) : id;
+        } else {
+            r += expr[p++];
+        }
+    }
+    return r;
+}
+
+inline std::string rename_col(const std::string& expr, const std::string& from, const std::string& to) {
+    std::string r;
+    size_t p = 0;
+    while (p < expr.size()) {
+        if (isalpha(expr[p]) || expr[p] == '_') {
+            size_t b = p;
+            while (p < expr.size() && (isalnum(expr[p]) || expr[p] == '_')) ++p;
+            std::string id = expr.substr(b, p - b);
+            r += (id == from) ? to : id;
+        } else {
+            r += expr[p++];
+        }
+    }
+    return r;
+}
+
+} // namespace gqe_plan
+} // namespace details
+
+/**
+ * @brief Generate config bits for the 4-column dynamic filter from an expression.
+ *
+ * Expression compares columns with signed 32-bit constants or other columns,
+ * using ``== != < <= > >=``, combined with ``&& || !`` and parentheses.
+ * A ``u`` suffix on a constant, like ``19940101u``, makes the comparison
+ * unsigned. All comparisons of one column with constants share one comparator
+ * with a lower and an upper bound, so when they are not all top-level ``&&``
+ * terms only one such comparison per column is allowed. An empty expression
+ * lets everything pass.
+ *
+ * @param cols names of the four columns seen by the filter, in order.
+ * @param expr filter expression.
+ * @param cfg generated config, 45 words.
+ * @return true on success.
+ */
+inline bool dynamicFilterCompiler(const std::vector<std::string>& cols, const std::string& expr, uint32_t cfg[45]) {
+    using namespace xf::database::enums;
+    using namespace xf::database::details::gqe_plan;
+
+    for (int i = 0; i < 45; ++i) cfg[i] = 0;
+
+    std::vector<FilterNode> nodes;
+    std::vector<FilterAtom> atoms;
+    int root = -1;
+    bool empty = expr.find_first_not_of(" \t\n") == std::string::npos;
+    if (!empty) {
+        std::vector<std::string> c(cols.begin(), cols.size() > 4 ? cols.begin() + 4 : cols.end());
+        FilterParser parser(c, expr);
+        if (!parser.parse(nodes, atoms, root)) return false;
+    }
+    std::vector<bool> top(atoms.size(), false);
+    if (root >= 0) mark_top(nodes, root, top);
+
+    // var-const slots: l, r, lop, rop, and whether shared by top-level terms
+    uint32_t l[4] = {0, 0, 0, 0}, r[4] = {0, 0, 0, 0};
+    int lop[4] = {FOP_DC, FOP_DC, FOP_DC, FOP_DC}, rop[4] = {FOP_DC, FOP_DC, FOP_DC, FOP_DC};
+    int nvc[4] = {0, 0, 0, 0};
+    bool vc_top[4] = {true, true, true, true};
+    // var-var slots in order 0-1, 0-2, 0-3, 1-2, 1-3, 2-3
+    int vv[6] = {FOP_DC, FOP_DC, FOP_DC, FOP_DC, FOP_DC, FOP_DC};
+    bool vv_top[6] = {true, true, true, true, true, true};
+    unsigned used = 0;
+
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        FilterAtom& a = atoms[i];
+        if (a.col1 < 0) {
+            int c = a.col0;
+            bool lower = (a.op == FOP_GT || a.op == FOP_GE || a.op == FOP_GTU || a.op == FOP_GEU);
+            bool upper = (a.op == FOP_LT || a.op == FOP_LE || a.op == FOP_LTU || a.op == FOP_LEU);
+            if (nvc[c] > 0 && !(top[i] && vc_top[c])) {
+                std::cout << "ERROR: filter \"" << expr << "\": column " << cols[c]
+                          << " compared with constants under || or !, at most one comparison allowed." << std::endl;
+                return false;
+            }
+            if (!upper && lop[c] == FOP_DC) {
+                lop[c] = a.op;
+                l[c] = a.val;
+            } else if (!lower && rop[c] == FOP_DC) {
+                rop[c] = a.op;
+                r[c] = a.val;
+            } else {
+                std::cout << "ERROR: filter \"" << expr << "\": too many bounds on column " << cols[c] << "."
+                          << std::endl;
+                return false;
+            }
+            nvc[c]++;
+            vc_top[c] = vc_top[c] && top[i];
+            a.bit = c;
+        } else {
+            int k = a.col0 == 0 ? a.col1 - 1 : a.col0 + a.col1;
+            if (vv[k] != FOP_DC && !(vv[k] == a.op && top[i] && vv_top[k])) {
+                std::cout << "ERROR: filter \"" << expr << "\": columns " << cols[a.col0] << " and " << cols[a.col1]
+                          << " can be compared only once." << std::endl;
+                return false;
+            }
+            vv[k] = a.op;
+            vv_top[k] = vv_top[k] && top[i];
+            a.bit = 4 + k;
+        }
+        used |= 1u << a.bit;
+    }
+
+    int n = 0;
+    for (int c = 0; c < 4; ++c) {
+        cfg[n++] = l[c];
+        cfg[n++] = r[c];
+        cfg[n++] = 0UL | (lop[c] << FilterOpWidth) | (rop[c]);
+    }
+    uint32_t w = 0;
+    for (int k = 0; k < 6; ++k) {
+        w |= ((uint32_t)vv[k]) << (FilterOpWidth * k);
+    }
+    cfg[n++] = w;
+
+    // unused comparators always give true, so only addresses with those bits set are filled
+    for (unsigned addr = 0; addr < 1024; ++addr) {
+        if ((addr | used) != 1023) continue;
+        if (root < 0 || eval_node(nodes, atoms, root, addr)) {
+            cfg[n + addr / 32] |= 1u << (addr % 32);
+        }
+    }
+    return true;
+}
+
+namespace gqe {
+
+enum JoinType { INNER_JOIN = 0, SEMI_JOIN = 1, ANTI_JOIN = 2 };
+
+/**
+ * @brief Expression evaluated by the dynamic ALU, producing one new column.
+ *
+ * The expression follows dynamicALUOPCompiler, with column names in place of
+ * strm1 to strm4, and c1 to c4 taking the given constants.
+ */
+struct Eval {
+    std::string name;
+    std::string expr;
+    int32_t c[4];
+    int scale; // gqeAggr only, divide result by 10, 100, 1000 or 10000; 0 for none
+
+    Eval(const std::string& _name,
+         const std::string& _expr,
+         int32_t c1 = 0,
+         int32_t c2 = 0,
+         int32_t c3 = 0,
+         int32_t c4 = 0,
+         int _scale = 0)
+        : name(_name), expr(_expr), scale(_scale) {
+        c[0] = c1;
+        c[1] = c2;
+        c[2] = c3;
+        c[3] = c4;
+    }
+};
+
+/// @brief One aggregate of a group-by, col can be left empty for AOP_COUNT.
+struct Agg {
+    enums::AggregateOp op;
+    std::string col;
+    std::string name;
+};
+
+/**
+ * @brief Join of a small build table and a large probe table on gqeJoin.
+ *
+ * Without probe table, the kernel runs with join off, filtering and
+ * evaluating over the build table only.
+ */
+struct JoinSpec {
+    std::string build;
+    std::string build_filter;
+    std::vector<std::string> build_keys; // one or two
+    std::string probe;
+    std::string probe_filter;
+    std::vector<std::string> probe_keys;
+    JoinType type = INNER_JOIN;
+    std::vector<Eval> evals;         // at most two, run after the join
+    std::vector<std::string> output; // at most 8 columns
+    bool sum = false;                // sum up each output column into one row
+    bool bloom = false;              // gqePart drops probe rows failing a bloom filter of build keys
+};
+
+/// @brief Group-by aggregation on gqeAggr, evals run first, then the filter.
+struct AggrSpec {
+    std::string input;
+    std::vector<Eval> evals;
+    std::string filter;
+    std::vector<std::string> group_by; // at most 8 keys
+    std::vector<Agg> aggs;             // at most 8, at most 4 of AOP_MEAN
+    std::string order_by;              // output column, AOP_SUM compares all 64 bits
+    bool desc = false;
+    int limit = 0; // only the first limit rows in order_by order are written, 0 for all rows
+};
+
+/// @brief One kernel invocation of the plan.
+struct Step {
+    std::string kernel; // gqeJoin or gqeAggr
+    std::string in1;    // build table, or input of gqeAggr
+    std::string in2;    // probe table, empty when not used
+    std::string out;
+    int cfg; // index into the join or aggr configs
+};
+
+/**
+ * @brief Compiles a small relational plan into GQE kernel configurations.
+ *
+ * Tables are referred to by name, and columns by name within tables. Base
+ * tables are declared with addTable in the order their columns are added to
+ * the host Table, the result of each step becomes a new table whose column i
+ * is the i-th column written by the kernel. Empty names mark unused columns.
+ *
+ * For gqeAggr, aggregate j is written to column j, with the high 32 bits of
+ * AOP_SUM named ``<name>_h`` in column 8 + j. Group keys go to the first
+ * free columns of the low half, or next to the aggregates of the high half
+ * when the low half is full.
+ *
+ * String columns are loaded as codes of a StringDict and declared with
+ * addDict, then filters may compare them with string literals, see
+ * dictFilterRewrite. Group keys and outputs stay codes until decoded on host.
+ */
+class Plan {
+   public:
+    void addTable(const std::string& name, const std::vector<std::string>& cols) { tables_[name] = cols; }
+
+    /// @brief column col holds codes of d, its string predicates in filters are rewritten to codes
+    void addDict(const std::string& col, const StringDict& d) { dicts_[col] = &d; }
+
+    const std::vector<std::string>& schema(const std::string& name) const {
+        static const std::vector<std::string> none;
+        std::map<std::string, std::vector<std::string> >::const_iterator it = tables_.find(name);
+        return it == tables_.end() ? none : it->second;
+    }
+
+    const std::vector<Step>& steps() const { return steps_; }
+
+    /// @brief copy config of join step into the 9 words of a cfgCmd
+    void getJoinCfg(int i, ap_uint<512>* cmd) const {
+        for (int w = 0; w < 9; ++w) cmd[w] = join_cfgs_[i][w];
+    }
+
+    /// @brief copy config of aggr step into the 128 words of an AggrCfgCmd
+    void getAggrCfg(int i, ap_uint<32>* cmd) const {
+        for (int w = 0; w < 128; ++w) cmd[w] = aggr_cfgs_[i][w];
+    }
+
+    /// @brief print the kernel call sequence
+    void print() const {
+        for (size_t i = 0; i < steps_.size(); ++i) {
+            const Step& s = steps_[i];
+            std::cout << "step " << i << ": " << s.kernel << "(" << s.in1;
+            if (!s.in2.empty()) std::cout << ", " << s.in2;
+            std::cout << " -> " << s.out << ", cfg " << s.cfg << ")" << std::endl;
+        }
+    }
+
+    /**
+     * @brief add a gqeJoin step writing table out.
+     * @return true on success, nothing is added on failure.
+     */
+    bool addJoin(const std::string& out, const JoinSpec& spec) {
+        using namespace xf::database::details::gqe_plan;
+        JoinSpec s = spec;
+        if (!dictFilterRewrite(dicts_, spec.build_filter, s.build_filter) ||
+            !dictFilterRewrite(dicts_, spec.probe_filter, s.probe_filter)) {
+            return false;
+        }
+        const std::vector<std::string>& ta = schema(s.build);
+        const std::vector<std::string>& tb = schema(s.probe);
+        bool join_on = !s.probe.empty();
+        size_t nkey = s.build_keys.size();
+        bool dual = nkey == 2;
+        if (ta.empty() || (join_on && tb.empty())) {
+            std::cout << "ERROR: " << out << ": unknown input table." << std::endl;
+            return false;
+        }
+        if (join_on && (nkey == 0 || nkey > 2 || nkey != s.probe_keys.size())) {
+            std::cout << "ERROR: " << out << ": join needs one or two key pairs." << std::endl;
+            return false;
+        }
+        if (s.evals.size() > 2 || s.output.empty()) {
+            std::cout << "ERROR: " << out << ": needs 1 to 8 output columns and at most 2 evals." << std::endl;
+            return false;
+        }
+
+        // after the join build keys are the same columns as probe keys
+        std::vector<std::string> w4 = s.output;
+        std::vector<Eval> evals = s.evals;
+        evals.resize(2, Eval("", ""));
+        for (size_t k = 0; join_on && k < nkey; ++k) {
+            for (size_t i = 0; i < w4.size(); ++i) {
+                if (w4[i] == s.build_keys[k]) w4[i] = s.probe_keys[k];
+            }
+            for (int i = 0; i < 2; ++i) {
+                evals[i].expr = rename_col(evals[i].expr, s.build_keys[k], s.probe_keys[k]);
+            }
+        }
+
+        // work backwards from output to the columns needed after the join
+        const Eval& e1 = evals[0];
+        const Eval& e2 = evals[1];
+        std::vector<std::string> w3 = eval_want(e2.expr, e2.name, w4);
+        std::vector<std::string> w2 = eval_want(e1.expr, e1.name, w3);
+
+        // scan filter columns first, then keys, then payload
+        std::vector<std::string> fa, fb, sa, sb, pa, pb;
+        if (!filter_cols(ta, s.build_filter, fa) || (join_on && !filter_cols(tb, s.probe_filter, fb))) return false;
+        sa = fa;
+        sb = fb;
+        for (size_t i = 0; join_on && i < nkey; ++i) {
+            add_col(sa, s.build_keys[i]);
+            add_col(sb, s.probe_keys[i]);
+        }
+        for (size_t i = 0; i < w2.size(); ++i) {
+            if (join_on && (find_col(s.build_keys, w2[i]) >= 0 || find_col(s.probe_keys, w2[i]) >= 0)) continue;
+            if (join_on && find_col(tb, w2[i]) >= 0) {
+                add_col(pb, w2[i]);
+            } else if (find_col(ta, w2[i]) >= 0) {
+                add_col(pa, w2[i]);
+            } else {
+                std::cout << "ERROR: " << out << ": column " << w2[i] << " not found in inputs." << std::endl;
+                return false;
+            }
+        }
+        if (join_on && s.type != INNER_JOIN && !pa.empty()) {
+            std::cout << "ERROR: " << out << ": semi and anti join cannot output build columns." << std::endl;
+            return false;
+        }
+        size_t npld = dual ? 5 : 6;
+        if (join_on && (pa.size() > npld || pb.size() > npld)) {
+            std::cout << "ERROR: " << out << ": at most " << npld << " payload columns per table." << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < pa.size(); ++i) add_col(sa, pa[i]);
+        for (size_t i = 0; i < pb.size(); ++i) add_col(sb, pb[i]);
+        if (sa.size() > 8 || sb.size() > 8) {
+            std::cout << "ERROR: " << out << ": at most 8 columns scanned per table." << std::endl;
+            return false;
+        }
+
+        std::vector<ap_uint<512> > b(9, ap_uint<512>(0));
+        ap_uint<512> t = 0;
+        t[0] = join_on;
+        t[1] = s.sum;
+        t[2] = join_on && dual;
+        t.range(5, 3) = join_on ? (int)s.type : 0;
+        t[7] = join_on && s.bloom && s.type != ANTI_JOIN;
+        for (int c = 0; c < 8; ++c) {
+            t.range(56 + 8 * c + 7, 56 + 8 * c) = (uint8_t)(int8_t)(c < (int)sa.size() ? find_col(ta, sa[c]) : -1);
+            t.range(120 + 8 * c + 7, 120 + 8 * c) = (uint8_t)(int8_t)(c < (int)sb.size() ? find_col(tb, sb[c]) : -1);
+        }
+
+        // key first, then payload; with join off shuffle1a feeds eval1 directly
+        std::vector<std::string> ka, kb, cur;
+        ap_uint<64> sh1a = 0, sh1b = 0, sh2 = 0, sh3 = 0, sh4 = 0;
+        if (join_on) {
+            ka = s.build_keys;
+            kb = s.probe_keys;
+            ka.insert(ka.end(), pa.begin(), pa.end());
+            kb.insert(kb.end(), pb.begin(), pb.end());
+            if (!shuffle_cfg(sa, ka, sh1a, "shuffle1a") || !shuffle_cfg(sb, kb, sh1b, "shuffle1b")) return false;
+
+            // 0-5 probe payload, 6-11 build payload, 12-13 keys
+            cur.assign(14, "");
+            for (size_t i = 0; i < pb.size(); ++i) cur[i] = pb[i];
+            for (size_t i = 0; i < pa.size(); ++i) cur[6 + i] = pa[i];
+            cur[12] = s.probe_keys[0];
+            if (dual) cur[13] = s.probe_keys[1];
+            if (!shuffle_cfg(cur, w2, sh2, "shuffle2")) return false;
+        } else {
+            if (!shuffle_cfg(sa, w2, sh1a, "shuffle1a")) return false;
+        }
+
+        // eval1, shuffle3, eval2, shuffle4 with eval results as column 8
+        ap_uint<289> op1 = 0, op2 = 0;
+        cur = w2;
+        if (!compile_eval(e1, cur, op1)) return false;
+        if (!shuffle_cfg(cur, w3, sh3, "shuffle3")) return false;
+        cur = w3;
+        if (!compile_eval(e2, cur, op2)) return false;
+        if (!shuffle_cfg(cur, w4, sh4, "shuffle4")) return false;
+        t.range(191, 184) = (1 << w4.size()) - 1;
+
+        t.range(255, 192) = sh1a;
+        t.range(319, 256) = sh1b;
+        t.range(383, 320) = sh2;
+        t.range(447, 384) = sh3;
+        t.range(511, 448) = sh4;
+        b[0] = t;
+        b[1] = op1;
+        b[2] = op2;
+
+        uint32_t fcfg[45];
+        if (!dynamicFilterCompiler(sa, s.build_filter, fcfg)) return false;
+        copy_filter(fcfg, &b[3]);
+        if (!dynamicFilterCompiler(sb, s.probe_filter, fcfg)) return false;
+        copy_filter(fcfg, &b[6]);
+
+        Step st = {"gqeJoin", s.build, join_on ? s.probe : "", out, (int)join_cfgs_.size()};
+        join_cfgs_.push_back(b);
+        steps_.push_back(st);
+        tables_[out] = s.output;
+        return true;
+    }
+
+    /**
+     * @brief add a gqeAggr step writing table out.
+     * @return true on success, nothing is added on failure.
+     */
+    bool addAggr(const std::string& out, const AggrSpec& spec) {
+        using namespace xf::database::details::gqe_plan;
+        using namespace xf::database::enums;
+        AggrSpec s = spec;
+        if (!dictFilterRewrite(dicts_, spec.filter, s.filter)) return false;
+        const std::vector<std::string>& ti = schema(s.input);
+        if (ti.empty()) {
+            std::cout << "ERROR: " << out << ": unknown input table." << std::endl;
+            return false;
+        }
+        if (s.evals.size() > 2 || s.aggs.empty() || s.aggs.size() > 8 || s.group_by.size() > 8) {
+            std::cout << "ERROR: " << out << ": needs 1 to 8 aggregates, at most 8 keys and 2 evals." << std::endl;
+            return false;
+        }
+
+        // pld order: mean first as only 4 columns get divided, then sum, then single word results
+        std::vector<int> order;
+        for (int pass = 0; pass < 3; ++pass) {
+            for (size_t j = 0; j < s.aggs.size(); ++j) {
+                AggregateOp op = s.aggs[j].op;
+                int cls = op == AOP_MEAN ? 0 : (op == AOP_SUM ? 1 : 2);
+                if (cls == pass) order.push_back(j);
+            }
+        }
+        int nkey = s.group_by.size();
+        int nagg = order.size();
+        if (nagg > 4 && s.aggs[order[4]].op == AOP_MEAN) {
+            std::cout << "ERROR: " << out << ": at most 4 AOP_MEAN supported." << std::endl;
+            return false;
+        }
+
+        // columns needed by filter, keys and aggregates, filter columns first
+        std::vector<std::string> fc, w2;
+        if (!filter_cols(ti, s.filter, fc, false)) return false;
+        w2 = fc;
+        for (int k = 0; k < nkey; ++k) add_col(w2, s.group_by[k]);
+        std::vector<std::string> pld(nagg);
+        for (int j = 0; j < nagg; ++j) {
+            pld[j] = s.aggs[order[j]].col;
+            if (pld[j].empty()) pld[j] = !w2.empty() ? w2[0] : ti[0];
+            add_col(w2, pld[j]);
+        }
+
+        Eval none("", "");
+        const Eval& e0 = s.evals.size() > 0 ? s.evals[0] : none;
+        const Eval& e1 = s.evals.size() > 1 ? s.evals[1] : none;
+        std::vector<std::string> w1 = eval_want(e1.expr, e1.name, w2);
+        std::vector<std::string> w0 = eval_want(e0.expr, e0.name, w1);
+        for (size_t i = 0; i < w0.size(); ++i) {
+            if (find_col(ti, w0[i]) < 0) {
+                std::cout << "ERROR: " << out << ": column " << w0[i] << " not found in " << s.input << "."
+                          << std::endl;
+                return false;
+            }
+        }
+        if (w0.size() > 8) {
+            std::cout << "ERROR: " << out << ": at most 8 columns scanned." << std::endl;
+            return false;
+        }
+
+        std::vector<ap_uint<32> > config(128, ap_uint<32>(0));
+        for (int c = 0; c < 8; ++c) {
+            config[c / 4].range(8 * (c % 4) + 7, 8 * (c % 4)) =
+                (uint8_t)(int8_t)(c < (int)w0.size() ? find_col(ti, w0[c]) : -1);
+        }
+
+        ap_uint<289> op;
+        ap_uint<64> sh1 = 0, sh2 = 0, sh3 = 0, sh4 = 0;
+        std::vector<std::string> cur = w0;
+        if (!compile_eval(e0, cur, op)) return false;
+        copy_alu(op, e0.scale, &config[2]);
+        if (!shuffle_cfg(cur, w1, sh1, "shuffle1")) return false;
+        cur = w1;
+        if (!compile_eval(e1, cur, op)) return false;
+        copy_alu(op, e1.scale, &config[12]);
+        if (!shuffle_cfg(cur, w2, sh2, "shuffle2")) return false;
+
+        uint32_t fcfg[45];
+        if (!dynamicFilterCompiler(w2, s.filter, fcfg)) return false;
+        for (int i = 0; i < 45; ++i) config[22 + i] = fcfg[i];
+
+        if (!shuffle_cfg(w2, s.group_by, sh3, "shuffle3") || !shuffle_cfg(w2, pld, sh4, "shuffle4")) return false;
+        config[67] = sh1(31, 0);
+        config[68] = sh1(63, 32);
+        config[69] = sh2(31, 0);
+        config[70] = sh2(63, 32);
+        config[71] = sh3(31, 0);
+        config[72] = sh3(63, 32);
+        config[73] = sh4(31, 0);
+        config[74] = sh4(63, 32);
+
+        ap_uint<32> aop = 0;
+        for (int j = 0; j < nagg; ++j) aop.range(4 * j + 3, 4 * j) = s.aggs[order[j]].op;
+        config[75] = aop;
+        config[76] = nkey;
+        config[77] = nagg;
+        config[78] = 0;
+
+        // out[i] is merge0 (pld0: min, max, count) or merge1 (pld1: low word),
+        // out[8 + i] is merge0 or merge2 (pld2: high word), each merge can
+        // take key[i], or key[7 - i] in reverse mode.
+        std::vector<std::string> res(16, "");
+        ap_uint<8> m1c0 = 0, m1c1 = 0, m1c2 = 0, m2c0 = 0, m2c1 = 0;
+        bool reverse = nagg + nkey <= 8;
+        for (int j = 0; j < nagg; ++j) {
+            const Agg& a = s.aggs[order[j]];
+            res[j] = a.name;
+            if (a.op != AOP_SUM && a.op != AOP_MEAN) m2c0[j] = 1;
+            if (a.op == AOP_SUM) res[8 + j] = a.name + "_h";
+        }
+        for (int k = 0; k < nkey; ++k) {
+            if (reverse) {
+                // key k lands in out[7 - k] through merge1
+                m1c1[7 - k] = 1;
+                res[7 - k] = s.group_by[k];
+            } else {
+                if (k < nagg && s.aggs[order[k]].op == AOP_SUM) {
+                    std::cout << "ERROR: " << out << ": too many keys and aggregates, no room for high word of "
+                              << s.aggs[order[k]].name << "." << std::endl;
+                    return false;
+                }
+                m1c2[k] = 1;
+                res[8 + k] = s.group_by[k];
+            }
+        }
+        config[79].range(7, 0) = m1c0;
+        config[79].range(15, 8) = m1c1;
+        config[79].range(23, 16) = m1c2;
+        config[79][24] = reverse;
+        config[80].range(7, 0) = m2c0;
+        config[80].range(15, 8) = m2c1;
+
+        // direct aggr
+        config[81] = 0;
+
+        ap_uint<32> mask = 0;
+        for (int i = 0; i < 16; ++i) mask[i] = !res[i].empty();
+        config[82] = mask;
+
+        // order by ... limit
+        if (s.limit > 0) {
+            int lo = find_col(res, s.order_by);
+            int hi = find_col(res, s.order_by + "_h");
+            if (lo < 0 || s.limit > AGGR_TOPK_MAX) {
+                std::cout << "ERROR: " << out << ": limit needs an output column to order by and at most "
+                          << AGGR_TOPK_MAX << " rows." << std::endl;
+                return false;
+            }
+            config[83][0] = 1;
+            config[83][1] = !s.desc;
+            config[83][2] = hi >= 0;
+            config[83].range(15, 8) = lo;
+            config[83].range(23, 16) = hi >= 0 ? hi : 0;
+            config[84] = s.limit;
+        }
+
+        Step st = {"gqeAggr", s.input, "", out, (int)aggr_cfgs_.size()};
+        aggr_cfgs_.push_back(config);
+        steps_.push_back(st);
+        tables_[out] = res;
+        return true;
+    }
+
+   private:
+    std::map<std::string, std::vector<std::string> > tables_;
+    std::map<std::string, const StringDict*> dicts_;
+    std::vector<Step> steps_;
+    std::vector<std::vector<ap_uint<512> > > join_cfgs_;
+    std::vector<std::vector<ap_uint<32> > > aggr_cfgs_;
+
+    // columns of t referenced by filter, in order of appearance
+    static bool filter_cols(const std::vector<std::string>& t,
+                            const std::string& expr,
+                            std::vector<std::string>& cols,
+                            bool check = true) {
+        size_t p = 0;
+        while (p < expr.size()) {
+            if (isalpha(expr[p]) || expr[p] == '_') {
+                size_t b = p;
+                while (p < expr.size() && (isalnum(expr[p]) || expr[p] == '_')) ++p;
+                std::string id = expr.substr(b, p - b);
+                if (check && details::gqe_plan::find_col(t, id) < 0) {
+                    std::cout << "ERROR: filter column " << id << " not found." << std::endl;
+                    return false;
+                }
+                details::gqe_plan::add_col(cols, id);
+            } else {
+                // skip the u suffix of constants
+                while (p < expr.size() && isdigit(expr[p])) ++p;
+                if (p < expr.size() && expr[p] == 'u' && p > 0 && isdigit(expr[p - 1])) ++p;
+                if (p < expr.size() && !isdigit(expr[p]) && !isalpha(expr[p]) && expr[p] != '_') ++p;
+            }
+        }
+        if (cols.size() > 4) {
+            std::cout << "ERROR: filter \"" << expr << "\" uses more than 4 columns." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // compile eval over cur, then append its result as column 8
+    static bool compile_eval(const Eval& e, std::vector<std::string>& cur, ap_uint<289>& op) {
+        op = 0;
+        cur.resize(8);
+        if (e.expr.empty()) {
+            cur.push_back("");
+            return true;
+        }
+        std::vector<std::string> in;
+        details::gqe_plan::eval_inputs(e.expr, in);
+        if (in.size() > 4) {
+            std::cout << "ERROR: eval " << e.name << " uses more than 4 columns." << std::endl;
+            return false;
+        }
+        std::string expr = details::gqe_plan::eval_rename(e.expr, cur);
+        if (!dynamicALUOPCompiler<int32_t, int32_t, int32_t, int32_t>(expr.c_str(), e.c[0], e.c[1], e.c[2], e.c[3],
+                                                                       op)) {
+            std::cout << "ERROR: eval " << e.name << " \"" << e.expr << "\" failed to compile." << std::endl;
+            return false;
+        }
+        cur.push_back(e.name);
+        return true;
+    }
+
+    // alu op of gqeAggr: 289 bits over 10 words, scaling in bits [3:1] of the last
+    static void copy_alu(const ap_uint<289>& op, int scale, ap_uint<32>* w) {
+        for (int i = 0; i < 9; i++) {
+            w[i] = op(32 * (i + 1) - 1, 32 * i);
+        }
+        w[9] = 0;
+        w[9][0] = op[288];
+        int s = scale == 10 ? 4 : scale == 100 ? 5 : scale == 1000 ? 6 : scale == 10000 ? 7 : 0;
+        w[9](3, 1) = s;
+    }
+
+    static void copy_filter(const uint32_t fcfg[45], ap_uint<512>* w) {
+        for (int i = 0; i < 45; ++i) {
+            w[i / 16].range(32 * (i % 16) + 31, 32 * (i % 16)) = fcfg[i];
+        }
+    }
+};
+
+} // namespace gqe
+} // namespace database
+} // namespace xf
+
+#endif // XF_DATABASE_GQE_PLAN_H
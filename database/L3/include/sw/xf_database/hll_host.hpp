@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef XF_DATABASE_HLL_HOST_H
+#define XF_DATABASE_HLL_HOST_H
+
+#include <ap_int.h>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <utility>
+
+#include "xf_database/hll_sketch.hpp"
+
+namespace xf {
+namespace database {
+
+/**
+ * @brief Rebuilds the sketch of one hash aggregate result row.
+ *
+ * hashGroupAggregate keeps the AOP_HLL sketch of a payload column in its three output words, low bits first.
+ *
+ * @param pld0 the [0][*] output of the column.
+ * @param pld1 the [1][*] output of the column.
+ * @param pld2 the [2][*] output of the column.
+ */
+template <int _WPay>
+ap_uint<3 * _WPay> hllFromHashAggr(const ap_uint<_WPay>& pld0,
+                                   const ap_uint<_WPay>& pld1,
+                                   const ap_uint<_WPay>& pld2) {
+    ap_uint<3 * _WPay> sketch = 0;
+    sketch(_WPay - 1, 0) = pld0;
+    sketch(2 * _WPay - 1, _WPay) = pld1;
+    sketch(3 * _WPay - 1, 2 * _WPay) = pld2;
+    return sketch;
+}
+
+/**
+ * @brief Merges sketch src into dst, afterwards dst counts the values of both.
+ */
+template <int W>
+void hllMerge(ap_uint<W>& dst, const ap_uint<W>& src) {
+    dst = details::hll_merge<W>(dst, src);
+}
+
+/**
+ * @brief Merges the per-group sketches of one partition into the result of the partitions seen so far.
+ *
+ * Call once per partition (PU, kernel run or card), groups present in several partitions end up with the merged
+ * sketch, which is the same sketch a single pass over all partitions would have built.
+ *
+ * @param keys group keys of the partition.
+ * @param sketches AOP_HLL result of each group.
+ * @param n number of groups in the partition.
+ * @param groups merged sketch of each group.
+ */
+template <typename K, int W>
+void hllMergePartition(const K* keys, const ap_uint<W>* sketches, size_t n, std::map<K, ap_uint<W> >& groups) {
+    for (size_t i = 0; i < n; i++) {
+        typename std::map<K, ap_uint<W> >::iterator it = groups.find(keys[i]);
+        if (it == groups.end()) {
+            groups.insert(std::make_pair(keys[i], sketches[i]));
+        } else {
+            hllMerge(it->second, sketches[i]);
+        }
+    }
+}
+
+/**
+ * @brief Estimates the number of distinct values counted by a sketch.
+ *
+ * Uses the HyperLogLog harmonic mean with linear counting for small cardinalities. The standard error is about
+ * ``1.04 / sqrt(m)`` for m registers, so at least 16 registers, ``W >= 80``, are recommended.
+ */
+template <int W>
+double hllEstimate(const ap_uint<W>& sketch) {
+    const int m = 1 << details::hll_index_bits<W>::value;
+    double alpha = m >= 128 ? 0.7213 / (1.0 + 1.079 / m) : m == 64 ? 0.709 : m == 32 ? 0.697 : 0.673;
+
+    double sum = 0;
+    int zeros = 0;
+    for (int i = 0; i < m; i++) {
+        int r = sketch(HLLRegWidth * i + HLLRegWidth - 1, HLLRegWidth * i);
+        sum += std::ldexp(1.0, -r);
+        zeros += r == 0;
+    }
+    double e = alpha * m * m / sum;
+    if (e <= 2.5 * m && zeros != 0) {
+        e = m * std::log((double)m / zeros);
+    }
+    return e;
+}
+
+} // namespace database
+} // namespace xf
+
+#endif // XF_DATABASE_HLL_HOST_H
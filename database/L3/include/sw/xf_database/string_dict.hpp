@@ -0,0 +1,315 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef XF_DATABASE_STRING_DICT_H
+#define XF_DATABASE_STRING_DICT_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace xf {
+namespace database {
+namespace details {
+
+inline std::string dict_str(const std::string& s) {
+    return s;
+}
+
+inline std::string dict_str(const char* s) {
+    return std::string(s);
+}
+
+// fixed size strings like d_string of the TPC-H reader keep their chars in a null terminated data member
+template <typename T>
+inline std::string dict_str(const T& s) {
+    return std::string(s.data);
+}
+
+} // namespace details
+
+/**
+ * @brief Sorted dictionary of one string column, or of several columns joined on each other.
+ *
+ * Values are added first, then ``seal()`` sorts them and gives each distinct value its rank as a 32-bit code. As codes
+ * keep the order of the strings, equality, ranges and prefixes of strings become ranges of codes, and grouping or
+ * sorting on the codes gives the same groups and order as on the strings.
+ */
+class StringDict {
+   public:
+    StringDict() : sealed_(false) {}
+
+    //! Adds a value before seal()
+    void add(const std::string& v) { vals_.push_back(v); }
+
+    //! Adds all values of a column before seal()
+    template <typename T>
+    void addColumn(const std::vector<T>& col) {
+        for (size_t i = 0; i < col.size(); ++i) vals_.push_back(details::dict_str(col[i]));
+    }
+
+    //! Sorts the values and drops duplicates, codes are fixed from here on
+    void seal() {
+        std::sort(vals_.begin(), vals_.end());
+        vals_.erase(std::unique(vals_.begin(), vals_.end()), vals_.end());
+        sealed_ = true;
+    }
+
+    bool sealed() const { return sealed_; }
+
+    //! Number of distinct values, codes are 0 to size() - 1
+    uint32_t size() const { return vals_.size(); }
+
+    //! Code of v, -1 when v is not in the dictionary
+    int32_t encode(const std::string& v) const {
+        std::vector<std::string>::const_iterator it = std::lower_bound(vals_.begin(), vals_.end(), v);
+        if (it == vals_.end() || *it != v) return -1;
+        return it - vals_.begin();
+    }
+
+    /**
+     * @brief Encodes a column into 32-bit codes.
+     *
+     * @param col the string column, std::string, const char* or d_string.
+     * @param codes output, one code per row.
+     * @return number of rows whose value is not in the dictionary, their code is -1.
+     */
+    template <typename T>
+    size_t encodeColumn(const std::vector<T>& col, int32_t* codes) const {
+        size_t miss = 0;
+        for (size_t i = 0; i < col.size(); ++i) {
+            codes[i] = encode(details::dict_str(col[i]));
+            miss += codes[i] < 0;
+        }
+        return miss;
+    }
+
+    //! String of a code, for result materialization
+    const std::string& decode(uint32_t code) const { return vals_[code]; }
+
+    //! First code whose string is not less than v
+    uint32_t lowerBound(const std::string& v) const {
+        return std::lower_bound(vals_.begin(), vals_.end(), v) - vals_.begin();
+    }
+
+    //! First code whose string is greater than v
+    uint32_t upperBound(const std::string& v) const {
+        return std::upper_bound(vals_.begin(), vals_.end(), v) - vals_.begin();
+    }
+
+    //! Codes [lo, hi) of the strings starting with prefix
+    void prefixRange(const std::string& prefix, uint32_t& lo, uint32_t& hi) const {
+        lo = lowerBound(prefix);
+        hi = lo;
+        while (hi < vals_.size() && vals_[hi].compare(0, prefix.size(), prefix) == 0) ++hi;
+    }
+
+   private:
+    std::vector<std::string> vals_;
+    bool sealed_;
+};
+
+namespace details {
+namespace string_dict {
+
+// a condition on codes [lo, hi) of column c, as a term the filter compiler takes. It never keeps code -1, and an
+// empty range is one comparison no signed 32-bit value passes, so it can still appear under || and !.
+inline std::string range_term(const std::string& c, uint32_t lo, uint32_t hi) {
+    if (lo >= hi) return "(" + c + " < -2147483648)";
+    if (hi - lo == 1) return "(" + c + " == " + std::to_string(lo) + ")";
+    return "(" + c + " >= " + std::to_string(lo) + " && " + c + " < " + std::to_string(hi) + ")";
+}
+
+class Rewriter {
+   public:
+    Rewriter(const std::map<std::string, const StringDict*>& dicts, const std::string& expr)
+        : dicts_(dicts), s_(expr), p_(0) {}
+
+    bool run(std::string& out) {
+        out.clear();
+        while (p_ < s_.size()) {
+            if (isalpha(s_[p_]) || s_[p_] == '_') {
+                size_t b = p_;
+                while (p_ < s_.size() && (isalnum(s_[p_]) || s_[p_] == '_')) ++p_;
+                std::string id = s_.substr(b, p_ - b);
+                std::map<std::string, const StringDict*>::const_iterator it = dicts_.find(id);
+                if (it == dicts_.end()) {
+                    out += id;
+                } else {
+                    std::string t;
+                    if (!term(id, *it->second, t)) return false;
+                    out += t;
+                }
+            } else if (s_[p_] == '\'') {
+                return error("string literal not compared with a dictionary column");
+            } else {
+                out += s_[p_++];
+            }
+        }
+        return true;
+    }
+
+   private:
+    const std::map<std::string, const StringDict*>& dicts_;
+    std::string s_;
+    size_t p_;
+
+    bool error(const char* msg) {
+        std::cout << "ERROR: filter \"" << s_ << "\": " << msg << " at " << p_ << "." << std::endl;
+        return false;
+    }
+
+    void skip() {
+        while (p_ < s_.size() && isspace(s_[p_])) ++p_;
+    }
+
+    bool match(const char* t) {
+        skip();
+        size_t n = std::string(t).size();
+        if (s_.compare(p_, n, t) != 0) return false;
+        // keywords must not run into an identifier
+        if (isalpha(t[0]) && p_ + n < s_.size() && (isalnum(s_[p_ + n]) || s_[p_ + n] == '_')) return false;
+        p_ += n;
+        return true;
+    }
+
+    bool literal(std::string& v) {
+        skip();
+        if (p_ >= s_.size() || s_[p_] != '\'') return error("expecting string literal");
+        v.clear();
+        for (++p_; p_ < s_.size(); ++p_) {
+            if (s_[p_] == '\'') {
+                // '' is a quote inside the literal
+                if (p_ + 1 < s_.size() && s_[p_ + 1] == '\'') {
+                    v += '\'';
+                    ++p_;
+                } else {
+                    ++p_;
+                    return true;
+                }
+            } else {
+                v += s_[p_];
+            }
+        }
+        return error("unterminated string literal");
+    }
+
+    bool term(const std::string& c, const StringDict& d, std::string& t) {
+        if (!d.sealed()) return error("dictionary is not sealed");
+        std::string v;
+        if (match("IN") || match("in")) {
+            std::vector<uint32_t> codes;
+            if (!match("(")) return error("expecting (");
+            do {
+                if (!literal(v)) return false;
+                int32_t k = d.encode(v);
+                if (k >= 0) codes.push_back(k);
+            } while (match(","));
+            if (!match(")")) return error("expecting )");
+            std::sort(codes.begin(), codes.end());
+            codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+            // the filter keeps one code range per column
+            if (!codes.empty() && codes.back() - codes.front() + 1 != codes.size()) {
+                return error("IN list codes are not adjacent in the dictionary");
+            }
+            t = codes.empty() ? range_term(c, 0, 0) : range_term(c, codes.front(), codes.back() + 1);
+            return true;
+        }
+        if (match("LIKE") || match("like")) {
+            if (!literal(v)) return false;
+            size_t pc = v.find_first_of("%_");
+            if (pc == std::string::npos) {
+                uint32_t lo = d.lowerBound(v);
+                t = range_term(c, lo, d.upperBound(v));
+            } else if (pc == v.size() - 1 && v[pc] == '%') {
+                uint32_t lo, hi;
+                d.prefixRange(v.substr(0, pc), lo, hi);
+                t = range_term(c, lo, hi);
+            } else {
+                return error("only prefix LIKE patterns are supported");
+            }
+            return true;
+        }
+        const char* ops[] = {"==", "!=", ">=", "<=", ">", "<"};
+        int op = -1;
+        for (int i = 0; i < 6 && op < 0; ++i) {
+            if (match(ops[i])) op = i;
+        }
+        skip();
+        if (op < 0 || p_ >= s_.size() || s_[p_] != '\'') {
+            // an integer comparison on the codes
+            t = c;
+            if (op >= 0) t += std::string(" ") + ops[op];
+            return true;
+        }
+        if (!literal(v)) return false;
+        uint32_t lo = d.lowerBound(v);
+        uint32_t hi = d.upperBound(v);
+        switch (op) {
+            case 0:
+                t = range_term(c, lo, hi);
+                break;
+            case 1:
+                t = lo < hi ? "(" + c + " >= 0 && " + c + " != " + std::to_string(lo) + ")" : "(" + c + " >= 0)";
+                break;
+            case 2:
+                t = "(" + c + " >= " + std::to_string(lo) + ")";
+                break;
+            case 3:
+                t = range_term(c, 0, hi);
+                break;
+            case 4:
+                t = "(" + c + " >= " + std::to_string(hi) + ")";
+                break;
+            default:
+                t = range_term(c, 0, lo);
+        }
+        return true;
+    }
+};
+
+} // namespace string_dict
+} // namespace details
+
+/**
+ * @brief Rewrites string predicates on dictionary encoded columns into code comparisons.
+ *
+ * The output is an expression for ``dynamicFilterCompiler``. Supported terms on a column with a dictionary are
+ * ``col == 'v'``, ``col != 'v'``, ``< <= > >=`` against a string, ``col IN ('a', 'b')`` and ``col LIKE 'pre%'``.
+ * ``''`` is a quote inside a literal. Every term becomes one code range, so an IN list must map to adjacent codes,
+ * and a term that needs both bounds can only appear under top-level ``&&`` of the filter. Rows whose value is not in
+ * the dictionary have code -1 and match no term, so ``!=``, ``<`` and ``<=`` need both bounds too.
+ *
+ * @param dicts dictionary of each encoded column, by column name.
+ * @param expr filter expression with string literals.
+ * @param out rewritten expression.
+ * @return true on success.
+ */
+inline bool dictFilterRewrite(const std::map<std::string, const StringDict*>& dicts,
+                              const std::string& expr,
+                              std::string& out) {
+    details::string_dict::Rewriter r(dicts, expr);
+    return r.run(out);
+}
+
+} // namespace database
+} // namespace xf
+
+#endif // XF_DATABASE_STRING_DICT_H
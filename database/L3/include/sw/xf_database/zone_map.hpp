@@ -0,0 +1,272 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef XF_DATABASE_ZONE_MAP_H
+#define XF_DATABASE_ZONE_MAP_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+#include "xf_database/enums.hpp"
+
+namespace xf {
+namespace database {
+
+/**
+ * @brief Minimum and maximum of a 32-bit column in each block of a fixed number of rows.
+ *
+ * Built once when a table is loaded, so that a filter can be checked against the blocks before the table is scanned.
+ */
+class ZoneMap {
+   public:
+    ZoneMap() : blk_row_(0), nrow_(0) {}
+
+    /**
+     * @brief Records min and max of each block of a column.
+     *
+     * @param v the column.
+     * @param n number of rows.
+     * @param blk_row rows of one block, the last block may be shorter.
+     */
+    void build(const int32_t* v, size_t n, size_t blk_row) {
+        blk_row_ = blk_row;
+        nrow_ = n;
+        mn_.clear();
+        mx_.clear();
+        for (size_t b = 0; b < n; b += blk_row) {
+            size_t e = b + blk_row < n ? b + blk_row : n;
+            int32_t lo = v[b], hi = v[b];
+            for (size_t i = b + 1; i < e; ++i) {
+                lo = v[i] < lo ? v[i] : lo;
+                hi = v[i] > hi ? v[i] : hi;
+            }
+            mn_.push_back(lo);
+            mx_.push_back(hi);
+        }
+    }
+
+    size_t blockRow() const { return blk_row_; }
+    size_t numRow() const { return nrow_; }
+    size_t blocks() const { return mn_.size(); }
+    int32_t min(size_t b) const { return mn_[b]; }
+    int32_t max(size_t b) const { return mx_[b]; }
+
+   private:
+    size_t blk_row_;
+    size_t nrow_;
+    std::vector<int32_t> mn_;
+    std::vector<int32_t> mx_;
+};
+
+namespace details {
+namespace zone_map {
+
+// truth values a comparator may give for the rows of a block
+enum { MAY_FALSE = 1, MAY_TRUE = 2, MAY_BOTH = 3 };
+
+inline bool unsigned_op(int op) {
+    using namespace xf::database::enums;
+    return op == FOP_GTU || op == FOP_LTU || op == FOP_GEU || op == FOP_LEU;
+}
+
+// range of the column as seen by op, false when unsigned order does not keep it one range
+inline bool op_range(bool u, int32_t mn, int32_t mx, int64_t& lo, int64_t& hi) {
+    if (!u) {
+        lo = mn;
+        hi = mx;
+    } else if (mn >= 0 || mx < 0) {
+        lo = (uint32_t)mn;
+        hi = (uint32_t)mx;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// lower and upper bound comparator of one column, as var_const_cmp of the dynamic filter
+inline int var_const(int lop, uint32_t l, int rop, uint32_t r, int32_t mn, int32_t mx) {
+    using namespace xf::database::enums;
+    if (lop == FOP_DC && rop == FOP_DC) return MAY_TRUE;
+    bool u = unsigned_op(lop) || unsigned_op(rop);
+    // bounds of mixed signedness are not used by the filter compiler
+    if (lop != FOP_DC && rop != FOP_DC && unsigned_op(lop) != unsigned_op(rop)) return MAY_BOTH;
+    int64_t lo, hi;
+    if (!op_range(u, mn, mx, lo, hi)) return MAY_BOTH;
+
+    // rows passing are [a, b] except the ne points
+    int64_t a = lo, b = hi;
+    int64_t ne[2];
+    int nne = 0;
+    const int op[2] = {lop, rop};
+    const uint32_t cv[2] = {l, r};
+    for (int k = 0; k < 2; ++k) {
+        int64_t c = u ? (int64_t)cv[k] : (int64_t)(int32_t)cv[k];
+        switch (op[k]) {
+            case FOP_EQ:
+                a = c > a ? c : a;
+                b = c < b ? c : b;
+                break;
+            case FOP_NE:
+                ne[nne++] = c;
+                break;
+            case FOP_GT:
+            case FOP_GTU:
+                a = c + 1 > a ? c + 1 : a;
+                break;
+            case FOP_GE:
+            case FOP_GEU:
+                a = c > a ? c : a;
+                break;
+            case FOP_LT:
+            case FOP_LTU:
+                b = c - 1 < b ? c - 1 : b;
+                break;
+            case FOP_LE:
+            case FOP_LEU:
+                b = c < b ? c : b;
+                break;
+            default:
+                break;
+        }
+    }
+    bool may_true = a <= b;
+    bool may_false = a > lo || b < hi;
+    for (int k = 0; k < nne; ++k) {
+        if (a == b && a == ne[k]) may_true = false;
+        if (lo <= ne[k] && ne[k] <= hi) may_false = true;
+    }
+    return (may_true ? MAY_TRUE : 0) | (may_false ? MAY_FALSE : 0);
+}
+
+// comparator between two columns, as var_var_cmp of the dynamic filter
+inline int var_var(int op, int32_t xmn, int32_t xmx, int32_t ymn, int32_t ymx) {
+    using namespace xf::database::enums;
+    if (op == FOP_DC) return MAY_TRUE;
+    bool u = unsigned_op(op);
+    int64_t xl, xh, yl, yh;
+    if (!op_range(u, xmn, xmx, xl, xh) || !op_range(u, ymn, ymx, yl, yh)) return MAY_BOTH;
+    bool t, f;
+    switch (op) {
+        case FOP_EQ:
+            t = xl <= yh && yl <= xh;
+            f = !(xl == xh && yl == yh && xl == yl);
+            break;
+        case FOP_NE:
+            t = !(xl == xh && yl == yh && xl == yl);
+            f = xl <= yh && yl <= xh;
+            break;
+        case FOP_GT:
+        case FOP_GTU:
+            t = xh > yl;
+            f = xl <= yh;
+            break;
+        case FOP_GE:
+        case FOP_GEU:
+            t = xh >= yl;
+            f = xl < yh;
+            break;
+        case FOP_LT:
+        case FOP_LTU:
+            t = xl < yh;
+            f = xh >= yl;
+            break;
+        case FOP_LE:
+        case FOP_LEU:
+            t = xl <= yh;
+            f = xh > yl;
+            break;
+        default:
+            return MAY_BOTH;
+    }
+    return (t ? MAY_TRUE : 0) | (f ? MAY_FALSE : 0);
+}
+
+} // namespace zone_map
+} // namespace details
+
+/**
+ * @brief Checks whether any row with each column inside a range can pass the 4-column dynamic filter.
+ *
+ * Each comparator of the filter is narrowed to the truth values it can give over the ranges, and the truth table is
+ * looked up for every combination of them. Columns are bounded independently, so a true return may still have no
+ * passing row, while a false return always means none passes.
+ *
+ * @param cfg config of the dynamic filter, 45 words, as generated by dynamicFilterCompiler.
+ * @param mn minimum of each filter column, INT32_MIN for a column of unknown range.
+ * @param mx maximum of each filter column, INT32_MAX for a column of unknown range.
+ * @return false when no row can pass.
+ */
+inline bool filterMayPass(const uint32_t cfg[45], const int32_t mn[4], const int32_t mx[4]) {
+    using namespace details::zone_map;
+    int may[10];
+    for (int c = 0; c < 4; ++c) {
+        uint32_t ops = cfg[3 * c + 2];
+        int lop = (ops >> FilterOpWidth) & ((1 << FilterOpWidth) - 1);
+        int rop = ops & ((1 << FilterOpWidth) - 1);
+        may[c] = var_const(lop, cfg[3 * c], rop, cfg[3 * c + 1], mn[c], mx[c]);
+    }
+    // var-var comparators in order 0-1, 0-2, 0-3, 1-2, 1-3, 2-3
+    int k = 0;
+    for (int x = 0; x < 4; ++x) {
+        for (int y = x + 1; y < 4; ++y, ++k) {
+            int op = (cfg[12] >> (FilterOpWidth * k)) & ((1 << FilterOpWidth) - 1);
+            may[4 + k] = var_var(op, mn[x], mx[x], mn[y], mx[y]);
+        }
+    }
+    for (unsigned addr = 0; addr < 1024; ++addr) {
+        bool ok = true;
+        for (int i = 0; i < 10 && ok; ++i) {
+            ok = (may[i] >> ((addr >> i) & 1)) & 1;
+        }
+        if (ok && ((cfg[13 + addr / 32] >> (addr % 32)) & 1)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Lists the blocks of a table in which no row can pass the 4-column dynamic filter.
+ *
+ * @param cfg config of the dynamic filter, 45 words.
+ * @param zm zone maps of the 4 columns seen by the filter, nullptr for a column without one, like an evaluated column.
+ *        All zone maps given must share the same blocks.
+ * @param skip output, 1 for each block to skip, empty when no zone map is given.
+ * @return number of blocks to skip.
+ */
+inline size_t zoneSkipList(const uint32_t cfg[45], const ZoneMap* const zm[4], std::vector<uint8_t>& skip) {
+    skip.clear();
+    size_t nblk = 0;
+    for (int c = 0; c < 4; ++c) {
+        if (zm[c] && zm[c]->blocks()) nblk = zm[c]->blocks();
+    }
+    size_t nskip = 0;
+    for (size_t b = 0; b < nblk; ++b) {
+        int32_t mn[4], mx[4];
+        for (int c = 0; c < 4; ++c) {
+            bool known = zm[c] && b < zm[c]->blocks();
+            mn[c] = known ? zm[c]->min(b) : INT32_MIN;
+            mx[c] = known ? zm[c]->max(b) : INT32_MAX;
+        }
+        skip.push_back(!filterMayPass(cfg, mn, mx));
+        nskip += skip.back();
+    }
+    return nskip;
+}
+
+} // namespace database
+} // namespace xf
+
+#endif // XF_DATABASE_ZONE_MAP_H
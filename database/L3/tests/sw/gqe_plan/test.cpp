@@ -0,0 +1,288 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "xf_database/gqe_plan.hpp"
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+using namespace xf::database;
+using namespace xf::database::enums;
+
+// software model of the dynamic filter reading the 45 config words
+static bool ref_vc(int lop, int rop, uint32_t l, uint32_t r, int32_t x) {
+    uint32_t xu = x;
+    bool bl = lop == FOP_DC || (lop == FOP_EQ && x == (int32_t)l) || (lop == FOP_NE && x != (int32_t)l) ||
+              (lop == FOP_GT && x > (int32_t)l) || (lop == FOP_GE && x >= (int32_t)l) || (lop == FOP_GTU && xu > l) ||
+              (lop == FOP_GEU && xu >= l);
+    bool br = rop == FOP_DC || (rop == FOP_EQ && x == (int32_t)r) || (rop == FOP_NE && x != (int32_t)r) ||
+              (rop == FOP_LT && x < (int32_t)r) || (rop == FOP_LE && x <= (int32_t)r) || (rop == FOP_LTU && xu < r) ||
+              (rop == FOP_LEU && xu <= r);
+    return bl && br;
+}
+
+static bool ref_vv(int op, int32_t x, int32_t y) {
+    return op == FOP_DC || (op == FOP_EQ && x == y) || (op == FOP_NE && x != y) || (op == FOP_GT && x > y) ||
+           (op == FOP_LT && x < y) || (op == FOP_GE && x >= y) || (op == FOP_LE && x <= y);
+}
+
+static bool ref_filter(const uint32_t cfg[45], const int32_t v[4]) {
+    unsigned addr = 0;
+    for (int c = 0; c < 4; ++c) {
+        int lop = (cfg[3 * c + 2] >> FilterOpWidth) & 0xf;
+        int rop = cfg[3 * c + 2] & 0xf;
+        addr |= ref_vc(lop, rop, cfg[3 * c], cfg[3 * c + 1], v[c]) << c;
+    }
+    int k = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = i + 1; j < 4; ++j, ++k) {
+            addr |= ref_vv((cfg[12] >> (FilterOpWidth * k)) & 0xf, v[i], v[j]) << (4 + k);
+        }
+    }
+    return (cfg[13 + addr / 32] >> (addr % 32)) & 1;
+}
+
+struct FilterCase {
+    const char* expr;
+    std::function<bool(const int32_t*)> golden;
+};
+
+static int test_filter() {
+    std::vector<std::string> cols = {"a", "b", "c", "d"};
+    FilterCase cases[] = {
+        {"", [](const int32_t* v) { return true; }},
+        {"a > 1 && a <= 3 && b != 0", [](const int32_t* v) { return v[0] > 1 && v[0] <= 3 && v[1] != 0; }},
+        {"2 < a && a != 3", [](const int32_t* v) { return v[0] > 2 && v[0] != 3; }},
+        {"a < -1 || b == 2", [](const int32_t* v) { return v[0] < -1 || v[1] == 2; }},
+        {"!(a == c) && (b > d || d == 0)",
+         [](const int32_t* v) { return v[0] != v[2] && (v[1] > v[3] || v[3] == 0); }},
+        {"a < b || c >= d", [](const int32_t* v) { return v[0] < v[1] || v[2] >= v[3]; }},
+        {"d <= a && b > -2u", [](const int32_t* v) { return v[3] <= v[0] && (uint32_t)v[1] > (uint32_t)-2; }},
+    };
+    int nerror = 0;
+    for (size_t t = 0; t < sizeof(cases) / sizeof(cases[0]); ++t) {
+        uint32_t cfg[45];
+        if (!dynamicFilterCompiler(cols, cases[t].expr, cfg)) {
+            std::cout << "Filter \"" << cases[t].expr << "\": compile failed" << std::endl;
+            nerror++;
+            continue;
+        }
+        int nmiss = 0;
+        for (int r = 0; r < 4096; ++r) {
+            int32_t v[4];
+            for (int c = 0; c < 4; ++c) v[c] = rand() % 9 - 4;
+            if (ref_filter(cfg, v) != cases[t].golden(v)) nmiss++;
+        }
+        std::cout << "Filter \"" << cases[t].expr << "\": " << nmiss << " mismatch" << std::endl;
+        nerror += nmiss != 0;
+    }
+
+    // same words as hand-written TPC-H Q5 config
+    uint32_t cfg[45];
+    dynamicFilterCompiler(cols, "c >= 19940101u && c < 19950101u", cfg);
+    for (int i = 0; i < 45; ++i) {
+        uint32_t g = i == 6 ? 19940101 : i == 7 ? 19950101 : i == 8 ? (FOP_GEU << FilterOpWidth) | FOP_LTU : 0;
+        if (i == 44) g = 1u << 31;
+        if (cfg[i] != g) nerror++;
+    }
+
+    // not expressible with one comparator per column
+    const char* bad[] = {"a > 1 || a < -1", "e > 1", "a > 1 && a > 2", "a < b || b > a", "a >"};
+    for (int i = 0; i < 5; ++i) {
+        if (dynamicFilterCompiler(cols, bad[i], cfg)) {
+            std::cout << "Filter \"" << bad[i] << "\": should fail" << std::endl;
+            nerror++;
+        }
+    }
+    return nerror;
+}
+
+static int8_t field(ap_uint<512>& w, int lo) {
+    return (int8_t)(uint64_t)w.range(lo + 7, lo);
+}
+
+static int check(const char* what, int got, int golden) {
+    if (got == golden) return 0;
+    std::cout << what << ": got " << got << ", expecting " << golden << std::endl;
+    return 1;
+}
+
+static int test_join() {
+    int nerror = 0;
+    gqe::Plan plan;
+    plan.addTable("orders", {"o_custkey", "o_orderkey", "o_orderdate"});
+    plan.addTable("customer", {"c_custkey", "c_nationkey"});
+
+    gqe::JoinSpec j;
+    j.build = "customer";
+    j.build_keys = {"c_custkey"};
+    j.probe = "orders";
+    j.probe_filter = "o_orderdate >= 19940101u && o_orderdate < 19950101u";
+    j.probe_keys = {"o_custkey"};
+    j.output = {"o_orderkey", "c_nationkey"};
+    if (!plan.addJoin("t_co", j)) return 1;
+
+    ap_uint<512> b[9];
+    plan.getJoinCfg(0, b);
+    nerror += check("join flags", (uint64_t)b[0].range(5, 0), 1);
+    // filter column scanned first
+    int id_a[] = {0, 1, -1, -1, -1, -1, -1, -1};
+    int id_b[] = {2, 0, 1, -1, -1, -1, -1, -1};
+    int sh1a[] = {0, 1, -1, -1, -1, -1, -1, -1};
+    int sh1b[] = {1, 2, -1, -1, -1, -1, -1, -1};
+    int sh2[] = {0, 6, -1, -1, -1, -1, -1, -1};
+    int sh34[] = {0, 1, -1, -1, -1, -1, -1, -1};
+    for (int c = 0; c < 8; ++c) {
+        nerror += check("col id A", field(b[0], 56 + 8 * c), id_a[c]);
+        nerror += check("col id B", field(b[0], 120 + 8 * c), id_b[c]);
+        nerror += check("shuffle1a", field(b[0], 192 + 8 * c), sh1a[c]);
+        nerror += check("shuffle1b", field(b[0], 256 + 8 * c), sh1b[c]);
+        nerror += check("shuffle2", field(b[0], 320 + 8 * c), sh2[c]);
+        nerror += check("shuffle3", field(b[0], 384 + 8 * c), sh34[c]);
+        nerror += check("shuffle4", field(b[0], 448 + 8 * c), sh34[c]);
+    }
+    nerror += check("write mask", (uint64_t)b[0].range(191, 184), 3);
+    nerror += check("filter B l", (uint64_t)b[6].range(31, 0), 19940101);
+    nerror += check("filter B r", (uint64_t)b[6].range(63, 32), 19950101);
+    nerror += check("filter B truth table", (uint64_t)b[8].range(415, 384), 1u << 31);
+
+    // bloom filter pushdown is dropped for anti join
+    gqe::JoinSpec jb = j;
+    jb.bloom = true;
+    if (!plan.addJoin("t_co_bf", jb)) return 1;
+    jb.type = gqe::ANTI_JOIN;
+    jb.output = {"o_orderkey"};
+    if (!plan.addJoin("t_co_anti", jb)) return 1;
+    plan.getJoinCfg(1, b);
+    nerror += check("bloom filter", (uint64_t)b[0][7], 1);
+    plan.getJoinCfg(2, b);
+    nerror += check("bloom filter anti join", (uint64_t)b[0][7], 0);
+
+    // join off: filter and evaluate over one table
+    plan.addTable("lineitem", {"l_orderkey", "l_extendedprice", "l_discount", "l_shipdate"});
+    gqe::JoinSpec s;
+    s.build = "lineitem";
+    s.build_filter = "l_shipdate >= 19940101u";
+    s.evals.push_back(gqe::Eval("revenue", "l_extendedprice*(-l_discount+c2)", 0, 100));
+    s.output = {"l_orderkey", "revenue"};
+    if (!plan.addJoin("t_rev", s)) return 1;
+    plan.getJoinCfg(3, b);
+    ap_uint<289> op;
+    dynamicALUOPCompiler<int32_t, int32_t, int32_t, int32_t>("strm1*(-strm2+c2)", 0, 100, 0, 0, op);
+    ap_uint<512> golden = op;
+    for (int i = 0; i < 9; ++i) {
+        uint64_t g = golden.range(32 * i + 31, 32 * i);
+        nerror += check("eval1", (uint64_t)b[1].range(32 * i + 31, 32 * i), g);
+    }
+    int sh1[] = {1, 2, 3, -1, -1, -1, -1, -1};
+    int sh3[] = {2, 8, -1, -1, -1, -1, -1, -1};
+    for (int c = 0; c < 8; ++c) {
+        nerror += check("shuffle1a", field(b[0], 192 + 8 * c), sh1[c]);
+        nerror += check("shuffle3", field(b[0], 384 + 8 * c), sh3[c]);
+    }
+    nerror += check("join off", (uint64_t)b[0].range(0, 0), 0);
+
+    // build payload is not available for semi join
+    j.type = gqe::SEMI_JOIN;
+    nerror += check("semi join with build payload", plan.addJoin("t_bad", j), 0);
+    return nerror;
+}
+
+static int test_aggr() {
+    int nerror = 0;
+    gqe::Plan plan;
+    plan.addTable("lineitem", {"l_orderkey", "l_extendedprice", "l_discount", "l_tax", "l_shipdate", "l_returnflag",
+                               "l_linestatus", "l_quantity"});
+
+    // TPC-H Q1
+    gqe::AggrSpec a;
+    a.input = "lineitem";
+    a.evals.push_back(gqe::Eval("disc_price", "l_extendedprice*(-l_discount+c2)", 0, 100, 0, 0, 100));
+    a.evals.push_back(gqe::Eval("charge", "l_extendedprice*(-l_discount+c2)*(l_tax+c3)", 0, 100, 100, 0, 10000));
+    a.filter = "l_shipdate <= 19980902";
+    a.group_by = {"l_returnflag", "l_linestatus"};
+    a.aggs = {{AOP_SUM, "l_quantity", "sum_qty"},       {AOP_SUM, "l_extendedprice", "sum_base_price"},
+              {AOP_SUM, "disc_price", "sum_disc_price"}, {AOP_SUM, "charge", "sum_charge"},
+              {AOP_MEAN, "l_quantity", "avg_qty"},       {AOP_MEAN, "l_extendedprice", "avg_price"},
+              {AOP_MEAN, "l_discount", "avg_disc"},      {AOP_COUNT, "", "count_order"}};
+    if (!plan.addAggr("q1", a)) return 1;
+
+    ap_uint<32> w[128];
+    plan.getAggrCfg(0, w);
+    nerror += check("scaling alu0", (uint64_t)w[11].range(3, 1), 5);
+    nerror += check("scaling alu1", (uint64_t)w[21].range(3, 1), 7);
+    nerror += check("aggr op", (uint64_t)w[75], 0x32222555);
+    nerror += check("key column", (uint64_t)w[76], 2);
+    nerror += check("pld column", (uint64_t)w[77], 8);
+    nerror += check("merge level1", (uint64_t)w[79], 0x30000);
+    nerror += check("merge level2", (uint64_t)w[80], 0x80);
+    nerror += check("write mask", (uint64_t)w[82], 0x7bff);
+
+    const std::vector<std::string>& out = plan.schema("q1");
+    const char* golden[] = {"avg_qty",        "avg_price",        "avg_disc",     "sum_qty",
+                            "sum_base_price", "sum_disc_price",   "sum_charge",   "count_order",
+                            "l_returnflag",   "l_linestatus",     "",             "sum_qty_h",
+                            "sum_base_price_h", "sum_disc_price_h", "sum_charge_h", ""};
+    for (int i = 0; i < 16; ++i) {
+        if (out[i] != golden[i]) {
+            std::cout << "aggr output " << i << ": got " << out[i] << ", expecting " << golden[i] << std::endl;
+            nerror++;
+        }
+    }
+
+    // few aggregates leave room for keys in the low half
+    gqe::AggrSpec m;
+    m.input = "lineitem";
+    m.group_by = {"l_orderkey"};
+    m.aggs = {{AOP_SUM, "l_quantity", "sum_qty"}, {AOP_MAX, "l_discount", "max_disc"}};
+    if (!plan.addAggr("q_small", m)) return 1;
+    plan.getAggrCfg(1, w);
+    nerror += check("merge level1", (uint64_t)w[79], 0x1008000);
+    nerror += check("merge level2", (uint64_t)w[80], 0x2);
+    nerror += check("write mask", (uint64_t)w[82], 0x183);
+    nerror += check("output key", plan.schema("q_small")[7] == "l_orderkey", 1);
+    nerror += check("top k off", (uint64_t)w[83], 0);
+
+    // order by the 64-bit sum, largest first
+    m.order_by = "sum_qty";
+    m.desc = true;
+    m.limit = 10;
+    if (!plan.addAggr("q_top", m)) return 1;
+    plan.getAggrCfg(2, w);
+    nerror += check("top k", (uint64_t)w[83], 0x80005);
+    nerror += check("top k limit", (uint64_t)w[84], 10);
+    m.limit = 1000;
+    nerror += check("top k over limit", plan.addAggr("q_bad", m), 0);
+
+    plan.print();
+    return nerror;
+}
+
+int main(int argc, const char* argv[]) {
+    int nerror = 0;
+    nerror += test_filter();
+    nerror += test_join();
+    nerror += test_aggr();
+
+    if (nerror == 0)
+        std::cout << "\n"
+                  << "TEST PASS!" << std::endl;
+    else
+        std::cout << "\n"
+                  << "TEST FAILED! " << nerror << " errors" << std::endl;
+
+    return nerror;
+}
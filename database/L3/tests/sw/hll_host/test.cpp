@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "xf_database/hll_host.hpp"
+#include <cmath>
+#include <iostream>
+#include <set>
+#include <vector>
+
+using namespace xf::database;
+
+#define PART_NUM 4
+#define GROUP_NUM 8
+#define ROW_NUM 200000
+
+// 1024 registers, about 3% standard error
+#define SKETCH_W (HLLRegWidth * 1024)
+
+typedef ap_uint<SKETCH_W> Sketch;
+
+static uint32_t lcg(uint32_t& s) {
+    s = s * 1664525u + 1013904223u;
+    return s >> 8;
+}
+
+int main(int argc, const char* argv[]) {
+    int nerror = 0;
+
+    // every partition sees part of each group, values of a group repeat across partitions
+    std::vector<uint32_t> keys[PART_NUM];
+    std::vector<Sketch> sketches[PART_NUM];
+    Sketch single[GROUP_NUM];
+    std::set<uint32_t> distinct[GROUP_NUM];
+    for (int g = 0; g < GROUP_NUM; g++) single[g] = 0;
+
+    uint32_t seed = 1;
+    for (int p = 0; p < PART_NUM; p++) {
+        Sketch part[GROUP_NUM];
+        for (int g = 0; g < GROUP_NUM; g++) part[g] = 0;
+        for (int i = 0; i < ROW_NUM; i++) {
+            int g = lcg(seed) % GROUP_NUM;
+            ap_uint<32> v = lcg(seed) % (1000u << g);
+            part[g] = details::hll_update<SKETCH_W, 32>(part[g], v);
+            single[g] = details::hll_update<SKETCH_W, 32>(single[g], v);
+            distinct[g].insert(v);
+        }
+        for (int g = 0; g < GROUP_NUM; g++) {
+            keys[p].push_back(g);
+            sketches[p].push_back(part[g]);
+        }
+    }
+
+    std::map<uint32_t, Sketch> merged;
+    for (int p = 0; p < PART_NUM; p++) {
+        hllMergePartition(keys[p].data(), sketches[p].data(), keys[p].size(), merged);
+    }
+
+    for (int g = 0; g < GROUP_NUM; g++) {
+        if (merged[g] != single[g]) {
+            std::cout << "group " << g << ": merged sketch differs from single pass sketch" << std::endl;
+            nerror++;
+        }
+        double est = hllEstimate(merged[g]);
+        double exact = distinct[g].size();
+        double err = std::fabs(est - exact) / exact;
+        std::cout << "group " << g << ": estimate " << (uint64_t)est << ", exact " << (uint64_t)exact << std::endl;
+        if (err > 0.1) {
+            std::cout << "group " << g << ": error " << err << " out of range" << std::endl;
+            nerror++;
+        }
+    }
+
+    // hash aggregate keeps the sketch in three payload words
+    ap_uint<96> s96 = 0;
+    for (uint32_t v = 0; v < 50; v++) {
+        s96 = details::hll_update<96, 32>(s96, ap_uint<32>(v));
+    }
+    ap_uint<32> p0 = s96(31, 0);
+    ap_uint<32> p1 = s96(63, 32);
+    ap_uint<32> p2 = s96(95, 64);
+    if (hllFromHashAggr<32>(p0, p1, p2) != s96) {
+        std::cout << "hash aggregate sketch rebuilt wrong" << std::endl;
+        nerror++;
+    }
+    if (hllEstimate(ap_uint<96>(0)) != 0) {
+        std::cout << "empty sketch should estimate 0" << std::endl;
+        nerror++;
+    }
+
+    if (nerror == 0)
+        std::cout << "\n"
+                  << "TEST PASS!" << std::endl;
+    else
+        std::cout << "\n"
+                  << "TEST FAILED! " << nerror << " errors" << std::endl;
+
+    return nerror;
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "xf_database/gqe_plan.hpp"
+#include "xf_database/string_dict.hpp"
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+using namespace xf::database;
+using namespace xf::database::enums;
+
+#define ROW_NUM 10000
+
+// software model of the dynamic filter, constant comparisons only
+static bool ref_vc(int op, uint32_t l, int32_t x) {
+    return op == FOP_DC || (op == FOP_EQ && x == (int32_t)l) || (op == FOP_NE && x != (int32_t)l) ||
+           (op == FOP_GT && x > (int32_t)l) || (op == FOP_GE && x >= (int32_t)l) || (op == FOP_LT && x < (int32_t)l) ||
+           (op == FOP_LE && x <= (int32_t)l);
+}
+
+static bool ref_filter(const uint32_t cfg[45], const int32_t v[4]) {
+    unsigned addr = 1023 & ~15u;
+    for (int c = 0; c < 4; ++c) {
+        int lop = (cfg[3 * c + 2] >> FilterOpWidth) & 0xf;
+        int rop = cfg[3 * c + 2] & 0xf;
+        addr |= (ref_vc(lop, cfg[3 * c], v[c]) && ref_vc(rop, cfg[3 * c + 1], v[c])) << c;
+    }
+    return (cfg[13 + addr / 32] >> (addr % 32)) & 1;
+}
+
+struct Row {
+    std::string mode;
+    std::string type;
+    int qty;
+};
+
+struct DictCase {
+    const char* expr;
+    std::function<bool(const Row&)> golden;
+};
+
+static bool starts(const std::string& s, const char* p) {
+    return s.compare(0, std::string(p).size(), p) == 0;
+}
+
+// compiles each case and compares the filter on the codes with the golden on the strings, returns the failed cases
+static int check_cases(const std::map<std::string, const StringDict*>& dicts,
+                       const std::vector<std::string>& cols,
+                       const DictCase* cases,
+                       size_t ncase,
+                       const std::vector<Row>& rows,
+                       const std::vector<int32_t>& code0,
+                       const std::vector<int32_t>& code1) {
+    int nerror = 0;
+    for (size_t t = 0; t < ncase; ++t) {
+        std::string expr;
+        uint32_t cfg[45];
+        if (!dictFilterRewrite(dicts, cases[t].expr, expr) || !dynamicFilterCompiler(cols, expr, cfg)) {
+            std::cout << "Filter \"" << cases[t].expr << "\": compile failed" << std::endl;
+            nerror++;
+            continue;
+        }
+        int nmiss = 0;
+        for (size_t i = 0; i < rows.size(); i++) {
+            int32_t v[4] = {code0[i], code1[i], rows[i].qty, 0};
+            if (ref_filter(cfg, v) != cases[t].golden(rows[i])) nmiss++;
+        }
+        std::cout << "Filter \"" << cases[t].expr << "\" -> \"" << expr << "\": " << nmiss << " mismatch" << std::endl;
+        nerror += nmiss != 0;
+    }
+    return nerror;
+}
+
+int main(int argc, const char* argv[]) {
+    int nerror = 0;
+
+    const char* modes[] = {"REG AIR", "AIR", "RAIL", "SHIP", "TRUCK", "MAIL", "FOB"};
+    const char* t1[] = {"STANDARD", "SMALL", "MEDIUM", "LARGE", "ECONOMY", "PROMO"};
+    const char* t2[] = {"ANODIZED", "BURNISHED", "PLATED", "POLISHED", "BRUSHED"};
+    std::vector<Row> rows;
+    std::vector<std::string> mode_col, type_col;
+    srand(1);
+    for (int i = 0; i < ROW_NUM; i++) {
+        Row r;
+        r.mode = modes[rand() % 7];
+        r.type = std::string(t1[rand() % 6]) + " " + t2[rand() % 5];
+        r.qty = rand() % 50 + 1;
+        rows.push_back(r);
+        mode_col.push_back(r.mode);
+        type_col.push_back(r.type);
+    }
+
+    StringDict mode_dict, type_dict;
+    mode_dict.addColumn(mode_col);
+    mode_dict.seal();
+    type_dict.addColumn(type_col);
+    type_dict.seal();
+    std::vector<int32_t> mode_code(ROW_NUM), type_code(ROW_NUM);
+    nerror += mode_dict.encodeColumn(mode_col, mode_code.data()) != 0;
+    nerror += type_dict.encodeColumn(type_col, type_code.data()) != 0;
+    if (mode_dict.size() != 7 || type_dict.size() != 30) {
+        std::cout << "dictionary sizes " << mode_dict.size() << " " << type_dict.size() << std::endl;
+        nerror++;
+    }
+    for (int i = 0; i < ROW_NUM; i++) {
+        if (mode_dict.decode(mode_code[i]) != rows[i].mode || type_dict.decode(type_code[i]) != rows[i].type) {
+            nerror++;
+        }
+        // codes keep the string order
+        if (i && (mode_code[i] < mode_code[i - 1]) != (rows[i].mode < rows[i - 1].mode)) nerror++;
+    }
+    if (nerror) std::cout << "encode and decode do not match" << std::endl;
+
+    std::map<std::string, const StringDict*> dicts;
+    dicts["l_shipmode"] = &mode_dict;
+    dicts["p_type"] = &type_dict;
+    std::vector<std::string> cols = {"l_shipmode", "p_type", "l_quantity"};
+    DictCase cases[] = {
+        {"l_shipmode == 'MAIL'", [](const Row& r) { return r.mode == "MAIL"; }},
+        {"l_shipmode != 'AIR' && l_quantity < 24", [](const Row& r) { return r.mode != "AIR" && r.qty < 24; }},
+        {"l_shipmode IN ('REG AIR', 'RAIL')", [](const Row& r) { return r.mode == "REG AIR" || r.mode == "RAIL"; }},
+        {"l_shipmode in ('AIR', 'NONE')", [](const Row& r) { return r.mode == "AIR"; }},
+        {"p_type LIKE 'PROMO%'", [](const Row& r) { return starts(r.type, "PROMO"); }},
+        {"p_type LIKE 'MEDIUM POLISHED%' || l_quantity > 40",
+         [](const Row& r) { return starts(r.type, "MEDIUM POLISHED") || r.qty > 40; }},
+        {"p_type LIKE 'SMALL%' && !(l_shipmode >= 'RAIL')",
+         [](const Row& r) { return starts(r.type, "SMALL") && !(r.mode >= "RAIL"); }},
+        {"l_shipmode < 'MAIL' && p_type <= 'LARGE ZINC'",
+         [](const Row& r) { return r.mode < "MAIL" && r.type <= "LARGE ZINC"; }},
+        {"l_shipmode == 'BOAT'", [](const Row& r) { return false; }},
+    };
+    nerror += check_cases(dicts, cols, cases, sizeof(cases) / sizeof(cases[0]), rows, mode_code, type_code);
+
+    // MAIL and FOB rows are not in this dictionary, their code is -1 and they match no term
+    StringDict known_dict;
+    for (int i = 0; i < 5; ++i) known_dict.add(modes[i]);
+    known_dict.seal();
+    std::vector<int32_t> known_code(ROW_NUM);
+    size_t nunknown = 0;
+    for (int i = 0; i < ROW_NUM; i++) nunknown += rows[i].mode == "MAIL" || rows[i].mode == "FOB";
+    if (known_dict.encodeColumn(mode_col, known_code.data()) != nunknown || nunknown == 0) {
+        std::cout << "rows missing from the dictionary are not counted" << std::endl;
+        nerror++;
+    }
+    std::map<std::string, const StringDict*> known_dicts;
+    known_dicts["l_shipmode"] = &known_dict;
+    known_dicts["p_type"] = &type_dict;
+    auto known = [](const Row& r) { return r.mode != "MAIL" && r.mode != "FOB"; };
+    DictCase miss_cases[] = {
+        {"l_shipmode == 'MAIL'", [](const Row& r) { return false; }},
+        {"l_shipmode == 'MAIL' || l_quantity > 40", [](const Row& r) { return r.qty > 40; }},
+        {"!(l_shipmode == 'MAIL')", [](const Row& r) { return true; }},
+        {"l_shipmode != 'MAIL'", [=](const Row& r) { return known(r); }},
+        {"l_shipmode != 'AIR'", [=](const Row& r) { return known(r) && r.mode != "AIR"; }},
+        {"l_shipmode < 'RAIL'", [=](const Row& r) { return known(r) && r.mode < "RAIL"; }},
+        {"l_shipmode <= 'MAIL'", [=](const Row& r) { return known(r) && r.mode <= "MAIL"; }},
+        {"l_shipmode < 'AIR'", [](const Row& r) { return false; }},
+        {"l_shipmode > 'MAIL'", [=](const Row& r) { return known(r) && r.mode > "MAIL"; }},
+        {"l_shipmode >= 'FOB'", [=](const Row& r) { return known(r) && r.mode >= "FOB"; }},
+        {"l_shipmode LIKE 'MA%'", [](const Row& r) { return false; }},
+        {"l_shipmode IN ('FOB', 'MAIL')", [](const Row& r) { return false; }},
+        {"l_shipmode IN ('FOB', 'AIR')", [](const Row& r) { return r.mode == "AIR"; }},
+    };
+    nerror += check_cases(known_dicts, cols, miss_cases, sizeof(miss_cases) / sizeof(miss_cases[0]), rows, known_code,
+                          type_code);
+
+    // MAIL and SHIP are not adjacent, and a range under ! needs both bounds of the comparator
+    const char* bad[] = {"l_shipmode IN ('MAIL', 'SHIP')", "p_type LIKE '%BRASS'", "l_quantity == 'MAIL'",
+                         "l_shipmode == 'MAIL", "!(p_type LIKE 'SMALL%')"};
+    for (int i = 0; i < 5; ++i) {
+        std::string expr;
+        uint32_t cfg[45];
+        if (dictFilterRewrite(dicts, bad[i], expr) && dynamicFilterCompiler(cols, expr, cfg)) {
+            std::cout << "Filter \"" << bad[i] << "\": should fail" << std::endl;
+            nerror++;
+        }
+    }
+
+    // plan filters take string literals once the column has a dictionary
+    gqe::Plan plan;
+    plan.addTable("lineitem", {"l_orderkey", "l_shipmode", "l_quantity"});
+    plan.addDict("l_shipmode", mode_dict);
+    gqe::AggrSpec a;
+    a.input = "lineitem";
+    a.filter = "l_shipmode == 'TRUCK'";
+    a.group_by = {"l_shipmode"};
+    a.aggs = {{AOP_SUM, "l_quantity", "sum_qty"}};
+    if (!plan.addAggr("t", a)) {
+        std::cout << "plan with dictionary filter failed" << std::endl;
+        nerror++;
+    }
+
+    if (nerror == 0)
+        std::cout << "\n"
+                  << "TEST PASS!" << std::endl;
+    else
+        std::cout << "\n"
+                  << "TEST FAILED! " << nerror << " errors" << std::endl;
+
+    return nerror;
+}
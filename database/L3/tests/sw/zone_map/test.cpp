@@ -0,0 +1,175 @@
+/*
+ * Copyright 2019 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "xf_database/gqe_plan.hpp"
+#include "xf_database/zone_map.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace xf::database;
+
+#define ROW_NUM (1 << 20)
+#define BLK_ROW (1 << 14)
+
+static uint32_t lcg(uint32_t& s) {
+    s = s * 1664525u + 1013904223u;
+    return s >> 8;
+}
+
+// one comparison of the dynamic filter, as var_const_cmp and var_var_cmp
+static bool cmp(int op, uint32_t xu, uint32_t yu) {
+    int32_t x = xu, y = yu;
+    switch (op) {
+        case FOP_EQ:
+            return x == y;
+        case FOP_NE:
+            return x != y;
+        case FOP_GT:
+            return x > y;
+        case FOP_LT:
+            return x < y;
+        case FOP_GE:
+            return x >= y;
+        case FOP_LE:
+            return x <= y;
+        case FOP_GTU:
+            return xu > yu;
+        case FOP_LTU:
+            return xu < yu;
+        case FOP_GEU:
+            return xu >= yu;
+        case FOP_LEU:
+            return xu <= yu;
+        default:
+            return true;
+    }
+}
+
+// reference model of the filter on one row
+static bool row_pass(const uint32_t cfg[45], const int32_t v[4]) {
+    const uint32_t m = (1 << FilterOpWidth) - 1;
+    unsigned addr = 0;
+    for (int c = 0; c < 4; ++c) {
+        bool b = cmp((cfg[3 * c + 2] >> FilterOpWidth) & m, v[c], cfg[3 * c]) &&
+                 cmp(cfg[3 * c + 2] & m, v[c], cfg[3 * c + 1]);
+        addr |= (unsigned)b << c;
+    }
+    int k = 0;
+    for (int x = 0; x < 4; ++x) {
+        for (int y = x + 1; y < 4; ++y, ++k) {
+            addr |= (unsigned)cmp((cfg[12] >> (FilterOpWidth * k)) & m, v[x], v[y]) << (4 + k);
+        }
+    }
+    return (cfg[13 + addr / 32] >> (addr % 32)) & 1;
+}
+
+int main(int argc, const char* argv[]) {
+    int nerror = 0;
+
+    // a time-ordered fact table: date ascending, the rest random
+    std::vector<int32_t> col[4];
+    uint32_t seed = 7;
+    for (int i = 0; i < ROW_NUM; ++i) {
+        // 1000 rows a day from 1992-01-01, 28-day months are enough to keep dates ordered
+        int d = i / 1000;
+        col[0].push_back((1992 + d / 336) * 10000 + (1 + d % 336 / 28) * 100 + 1 + d % 28);
+        col[1].push_back(lcg(seed) % 11);
+        col[2].push_back(1 + lcg(seed) % 50);
+        col[3].push_back((int32_t)(lcg(seed) % 200001) - 100000);
+    }
+    std::vector<std::string> names = {"l_shipdate", "l_discount", "l_quantity", "l_delta"};
+
+    ZoneMap zm[4];
+    for (int c = 0; c < 4; ++c) zm[c].build(col[c].data(), ROW_NUM, BLK_ROW);
+    const ZoneMap* zp[4] = {&zm[0], &zm[1], &zm[2], &zm[3]};
+    if (zm[0].blocks() != (ROW_NUM + BLK_ROW - 1) / BLK_ROW) {
+        std::cout << "ERROR: " << zm[0].blocks() << " blocks built." << std::endl;
+        nerror++;
+    }
+
+    struct Case {
+        std::string expr;
+        bool exact; // conditions on the ordered column only, every block without a passing row must be skipped
+        bool eval;  // l_delta is produced by evaluation, so has no zone map
+    };
+    std::vector<Case> cases = {
+        {"l_shipdate >= 19930101 && l_shipdate < 19940101", true, false},
+        {"l_shipdate >= 19940101u && l_shipdate < 19950101u && l_discount >= 5 && l_discount <= 7 && l_quantity < 24",
+         true, false},
+        {"l_shipdate < 19930101 || l_discount > 10", true, false},
+        {"l_shipdate == 19930505", true, false},
+        {"!(l_shipdate <= 19940601) && l_delta > 0", true, true},
+        {"l_shipdate != 19930101", true, false},
+        {"l_quantity > 50", true, false},
+        {"l_discount < l_quantity && l_shipdate > 19941231", false, false},
+        {"l_delta >= 0u", false, false},
+        {"", true, false},
+    };
+
+    for (size_t t = 0; t < cases.size(); ++t) {
+        uint32_t cfg[45];
+        if (!dynamicFilterCompiler(names, cases[t].expr, cfg)) {
+            std::cout << "ERROR: \"" << cases[t].expr << "\" not compiled." << std::endl;
+            nerror++;
+            continue;
+        }
+        std::vector<uint8_t> skip;
+        zp[3] = cases[t].eval ? nullptr : &zm[3];
+        size_t nskip = zoneSkipList(cfg, zp, skip);
+
+        size_t nempty = 0;
+        for (size_t b = 0; b < skip.size(); ++b) {
+            bool pass = false;
+            for (size_t i = b * BLK_ROW; i < (b + 1) * BLK_ROW && i < ROW_NUM && !pass; ++i) {
+                int32_t v[4] = {col[0][i], col[1][i], col[2][i], col[3][i]};
+                pass = row_pass(cfg, v);
+            }
+            nempty += !pass;
+            if (skip[b] && pass) {
+                std::cout << "ERROR: \"" << cases[t].expr << "\": block " << b << " skipped with passing rows."
+                          << std::endl;
+                nerror++;
+            }
+        }
+        if (cases[t].exact && nskip != nempty) {
+            std::cout << "ERROR: \"" << cases[t].expr << "\": " << nskip << " blocks skipped, " << nempty
+                      << " have no passing row." << std::endl;
+            nerror++;
+        }
+        std::cout << "\"" << cases[t].expr << "\": " << nskip << " of " << skip.size() << " blocks skipped."
+                  << std::endl;
+    }
+
+    // unknown ranges never skip
+    {
+        uint32_t cfg[45];
+        dynamicFilterCompiler(names, "l_shipdate > 0 && l_quantity < 0", cfg);
+        int32_t mn[4] = {INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN};
+        int32_t mx[4] = {INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX};
+        if (!filterMayPass(cfg, mn, mx)) {
+            std::cout << "ERROR: unknown ranges rejected." << std::endl;
+            nerror++;
+        }
+    }
+
+    if (nerror) {
+        std::cout << "FAIL: " << nerror << " errors found." << std::endl;
+    } else {
+        std::cout << "TEST PASS!" << std::endl;
+    }
+    return nerror;
+}